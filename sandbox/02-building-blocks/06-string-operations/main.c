@@ -1,6 +1,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#include "../strview.h"
+
+static double seconds_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
 
 int main(int argc, char *argv[])
 {
@@ -143,5 +153,80 @@ int main(int argc, char *argv[])
         free(dyn_str);  // Free the memory when done
     }
 
+    // 7. LENGTH-TRACKED STRINGS
+    /**
+     * strcat() has to find the end of the destination on every call, so
+     * building a string from n pieces costs O(n^2). A buffer that knows
+     * its length appends in O(piece), and a view (pointer + length) can
+     * name any slice of it without copying or a '\0'.
+     */
+    enum { LOG_LINES = 20000 };
+    const char *levels[] = {"INFO", "DEBUG", "WARN", "error", "INFO"};
+    char line[64];
+
+    size_t log_cap = LOG_LINES * sizeof(line);
+    char *log_cat = (char *) malloc(log_cap);
+    StrBuf log = STRBUF_INIT;
+    if (log_cat == NULL) return 1;
+
+    double t0 = seconds_now();
+    log_cat[0] = '\0';
+    for (i = 0; i < LOG_LINES; i++)
+    {
+        snprintf(line, sizeof(line), "%s request %d took %d ms\n",
+                 levels[i % 5], i, i % 97);
+        strcat(log_cat, line);
+    }
+    double t1 = seconds_now();
+    for (i = 0; i < LOG_LINES; i++)
+    {
+        int n = snprintf(line, sizeof(line), "%s request %d took %d ms\n",
+                         levels[i % 5], i, i % 97);
+        sb_append(&log, (StrView){line, (size_t) n});
+    }
+    double t2 = seconds_now();
+    printf("\nBuilding a %zu-byte log from %d lines:\n", log.len, LOG_LINES);
+    printf("strcat():        %8.2f ms\n", (t1 - t0) * 1e3);
+    printf("StrBuf append:   %8.2f ms (same text: %s)\n",
+           (t2 - t1) * 1e3,
+           strcmp(log_cat, log.data) == 0 ? "yes" : "no");
+
+    // Count the lines mentioning "took 9"
+    StrView pattern = SV("took 9");
+    int hits_strstr = 0;
+    t0 = seconds_now();
+    for (char *p = log_cat; (p = strstr(p, pattern.data)) != NULL; p++)
+    {
+        hits_strstr++;
+    }
+    t1 = seconds_now();
+
+    int hits_view = 0;
+    StrView rest = sb_view(&log);
+    for (size_t at; (at = sv_find(rest, pattern)) != SV_NPOS; hits_view++)
+    {
+        rest = sv_slice(rest, at + 1, rest.len);
+    }
+    t2 = seconds_now();
+
+    // Lines as views, no copies: the ERROR lines in any case
+    int errors = 0;
+    rest = sb_view(&log);
+    while (rest.len > 0)
+    {
+        StrView entry = sv_split_next(&rest, '\n');
+        if (sv_casecmp(sv_slice(entry, 0, 5), SV("ERROR")) == 0) errors++;
+    }
+
+    printf("strstr() scan:   %8.2f ms, %d matches\n", (t1 - t0) * 1e3,
+           hits_strstr);
+    printf("sv_find() scan:  %8.2f ms, %d matches\n", (t2 - t1) * 1e3,
+           hits_view);
+    printf("ERROR lines:     %d (any case)\n", errors);
+    printf("ASCII only:      %s\n", sv_is_ascii(sb_view(&log)) ? "yes" : "no");
+
+    free(log_cat);
+    sb_free(&log);
+
     return 0;
 }
@@ -0,0 +1,406 @@
+// Length-tracked strings and SIMD search kernels, shared by the string
+// demos.
+//
+// NUL-terminated strings make every operation start by finding the end:
+// strlen is a scan, strcat scans the destination before appending (so
+// building a string by repeated strcat is quadratic), and none of the
+// standard functions can work on a slice of a larger buffer. Here a
+// string is a pointer plus a length:
+//
+//   StrView   read-only slice (data, len); never owns memory, need not be
+//             NUL-terminated, so substrings of a log line cost nothing
+//   StrBuf    growable owned buffer; capacity doubles, so n appends cost
+//             O(total length), and it stays NUL-terminated for printf
+//
+// Search kernels, 16 or 32 bytes per step:
+//
+//   sv_find_byte   first occurrence of a byte
+//   sv_find        first occurrence of a substring: compares the needle's
+//                  first and last byte at 16/32 positions at once and only
+//                  runs memcmp where both match (the "generic SIMD" filter)
+//   sv_casecmp     ASCII case-insensitive ordering
+//   sv_is_ascii    true if no byte has the high bit set
+//
+// On x86-64 they use SSE2, or AVX2 when the CPU reports it (chosen once
+// before main, as in vector_batch.c); elsewhere they fall back to the C
+// library and plain loops.
+#ifndef STRVIEW_H
+#define STRVIEW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define STRVIEW_X86 1
+#include <immintrin.h>
+#endif
+
+#define SV_NPOS ((size_t) -1)  // "Not found"
+
+typedef struct
+{
+    const char *data;
+    size_t len;
+} StrView;
+
+// View of a string literal, length known at compile time
+#define SV(literal) ((StrView){(literal), sizeof(literal) - 1})
+
+static inline StrView sv_from_cstr(const char *s)
+{
+    return (StrView){s, strlen(s)};
+}
+
+// Bytes [start, start + len), clamped to the view
+static inline StrView sv_slice(StrView s, size_t start, size_t len)
+{
+    if (start > s.len) start = s.len;
+    if (len > s.len - start) len = s.len - start;
+    return (StrView){s.data + start, len};
+}
+
+static inline bool sv_eq(StrView a, StrView b)
+{
+    return a.len == b.len && memcmp(a.data, b.data, a.len) == 0;
+}
+
+/* ---- Builder ---- */
+
+typedef struct
+{
+    char *data;  // NUL-terminated; NULL until the first append
+    size_t len;
+    size_t cap;  // Bytes allocated, including the NUL
+} StrBuf;
+
+#define STRBUF_INIT {NULL, 0, 0}
+
+// Make room for extra more bytes; false if out of memory (the buffer is
+// unchanged then)
+static inline bool sb_reserve(StrBuf *b, size_t extra)
+{
+    size_t need = b->len + extra + 1;
+    if (need <= b->cap) return true;
+
+    size_t cap = b->cap ? b->cap : 64;
+    while (cap < need) cap *= 2;
+    char *data = (char *) realloc(b->data, cap);
+    if (data == NULL) return false;
+    b->data = data;
+    b->cap = cap;
+    return true;
+}
+
+static inline bool sb_append(StrBuf *b, StrView s)
+{
+    if (!sb_reserve(b, s.len)) return false;
+    memcpy(b->data + b->len, s.data, s.len);
+    b->len += s.len;
+    b->data[b->len] = '\0';
+    return true;
+}
+
+static inline bool sb_append_cstr(StrBuf *b, const char *s)
+{
+    return sb_append(b, sv_from_cstr(s));
+}
+
+static inline bool sb_append_char(StrBuf *b, char c)
+{
+    return sb_append(b, (StrView){&c, 1});
+}
+
+static inline StrView sb_view(const StrBuf *b)
+{
+    return (StrView){b->data ? b->data : "", b->len};
+}
+
+// Empty the buffer but keep its memory for reuse
+static inline void sb_clear(StrBuf *b)
+{
+    b->len = 0;
+    if (b->data) b->data[0] = '\0';
+}
+
+static inline void sb_free(StrBuf *b)
+{
+    free(b->data);
+    b->data = NULL;
+    b->len = b->cap = 0;
+}
+
+/* ---- Scalar kernels ---- */
+
+static inline unsigned char sv_fold(unsigned char c)
+{
+    return c >= 'A' && c <= 'Z' ? (unsigned char) (c + 32) : c;
+}
+
+// Compare folded bytes from position i on, then lengths
+static inline int sv_casecmp_from(StrView a, StrView b, size_t i)
+{
+    size_t n = a.len < b.len ? a.len : b.len;
+    for (; i < n; i++)
+    {
+        int d = sv_fold((unsigned char) a.data[i])
+                - sv_fold((unsigned char) b.data[i]);
+        if (d != 0) return d;
+    }
+    return (a.len > b.len) - (a.len < b.len);
+}
+
+// Substring search over positions [from, hay.len - needle.len]
+static inline size_t sv_find_from(StrView hay, StrView needle, size_t from)
+{
+    if (needle.len > hay.len) return SV_NPOS;
+    size_t last = hay.len - needle.len;
+    for (size_t i = from; i <= last; i++)
+    {
+        const char *p =
+            (const char *) memchr(hay.data + i, needle.data[0], last - i + 1);
+        if (p == NULL) return SV_NPOS;
+        i = (size_t) (p - hay.data);
+        if (memcmp(p + 1, needle.data + 1, needle.len - 1) == 0) return i;
+    }
+    return SV_NPOS;
+}
+
+static inline bool sv_is_ascii_from(StrView s, size_t i)
+{
+    uint64_t any = 0;
+    for (; i + 8 <= s.len; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, s.data + i, 8);
+        any |= word;
+    }
+    for (; i < s.len; i++) any |= (unsigned char) s.data[i];
+    return (any & 0x8080808080808080ull) == 0;
+}
+
+/* ---- SIMD kernels ---- */
+
+#ifdef STRVIEW_X86
+
+__attribute__((target("sse2"))) static inline size_t sv_find_byte_sse2(
+    StrView s, char c)
+{
+    __m128i target = _mm_set1_epi8(c);
+    size_t i = 0;
+    for (; i + 16 <= s.len; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i *) (s.data + i));
+        unsigned mask = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(block, target));
+        if (mask) return i + (size_t) __builtin_ctz(mask);
+    }
+    for (; i < s.len; i++)
+        if (s.data[i] == c) return i;
+    return SV_NPOS;
+}
+
+__attribute__((target("avx2"))) static inline size_t sv_find_byte_avx2(
+    StrView s, char c)
+{
+    __m256i target = _mm256_set1_epi8(c);
+    size_t i = 0;
+    for (; i + 32 <= s.len; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i *) (s.data + i));
+        unsigned mask =
+            (unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, target));
+        if (mask) return i + (size_t) __builtin_ctz(mask);
+    }
+    for (; i < s.len; i++)
+        if (s.data[i] == c) return i;
+    return SV_NPOS;
+}
+
+// Candidates are positions where both the first and the last needle byte
+// match; with typical text that filters out nearly everything, so memcmp
+// runs rarely. Needles of at least 2 bytes.
+__attribute__((target("sse2"))) static inline size_t sv_find_sse2(
+    StrView hay, StrView needle)
+{
+    size_t k = needle.len;
+    __m128i first = _mm_set1_epi8(needle.data[0]);
+    __m128i last = _mm_set1_epi8(needle.data[k - 1]);
+    size_t i = 0;
+    for (; i + k - 1 + 16 <= hay.len; i += 16)
+    {
+        __m128i block_first = _mm_loadu_si128((const __m128i *) (hay.data + i));
+        __m128i block_last =
+            _mm_loadu_si128((const __m128i *) (hay.data + i + k - 1));
+        unsigned mask = (unsigned) _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(block_first, first),
+                          _mm_cmpeq_epi8(block_last, last)));
+        while (mask)
+        {
+            size_t at = i + (size_t) __builtin_ctz(mask);
+            if (memcmp(hay.data + at + 1, needle.data + 1, k - 2) == 0) return at;
+            mask &= mask - 1;
+        }
+    }
+    return sv_find_from(hay, needle, i);
+}
+
+__attribute__((target("avx2"))) static inline size_t sv_find_avx2(
+    StrView hay, StrView needle)
+{
+    size_t k = needle.len;
+    __m256i first = _mm256_set1_epi8(needle.data[0]);
+    __m256i last = _mm256_set1_epi8(needle.data[k - 1]);
+    size_t i = 0;
+    for (; i + k - 1 + 32 <= hay.len; i += 32)
+    {
+        __m256i block_first =
+            _mm256_loadu_si256((const __m256i *) (hay.data + i));
+        __m256i block_last =
+            _mm256_loadu_si256((const __m256i *) (hay.data + i + k - 1));
+        unsigned mask = (unsigned) _mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first),
+                             _mm256_cmpeq_epi8(block_last, last)));
+        while (mask)
+        {
+            size_t at = i + (size_t) __builtin_ctz(mask);
+            if (memcmp(hay.data + at + 1, needle.data + 1, k - 2) == 0) return at;
+            mask &= mask - 1;
+        }
+    }
+    return sv_find_from(hay, needle, i);
+}
+
+// Fold A-Z to a-z: signed compares, so bytes >= 0x80 are never in range
+__attribute__((target("sse2"))) static inline __m128i sv_fold_sse2(__m128i x)
+{
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('A' - 1)),
+                                  _mm_cmplt_epi8(x, _mm_set1_epi8('Z' + 1)));
+    return _mm_add_epi8(x, _mm_and_si128(upper, _mm_set1_epi8(32)));
+}
+
+// Skip the common folded prefix 16 bytes at a time, then let the scalar
+// code order the first difference
+__attribute__((target("sse2"))) static inline int sv_casecmp_sse2(StrView a,
+                                                                  StrView b)
+{
+    size_t n = a.len < b.len ? a.len : b.len;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i x = sv_fold_sse2(_mm_loadu_si128((const __m128i *) (a.data + i)));
+        __m128i y = sv_fold_sse2(_mm_loadu_si128((const __m128i *) (b.data + i)));
+        unsigned same = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+        if (same != 0xFFFF)
+        {
+            return sv_casecmp_from(a, b, i + (size_t) __builtin_ctz(~same));
+        }
+    }
+    return sv_casecmp_from(a, b, i);
+}
+
+__attribute__((target("sse2"))) static inline bool sv_is_ascii_sse2(StrView s)
+{
+    size_t i = 0;
+    for (; i + 64 <= s.len; i += 64)
+    {
+        const __m128i *p = (const __m128i *) (s.data + i);
+        __m128i any = _mm_or_si128(
+            _mm_or_si128(_mm_loadu_si128(p), _mm_loadu_si128(p + 1)),
+            _mm_or_si128(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3)));
+        if (_mm_movemask_epi8(any)) return false;
+    }
+    return sv_is_ascii_from(s, i);
+}
+
+__attribute__((target("avx2"))) static inline bool sv_is_ascii_avx2(StrView s)
+{
+    size_t i = 0;
+    for (; i + 128 <= s.len; i += 128)
+    {
+        const __m256i *p = (const __m256i *) (s.data + i);
+        __m256i any = _mm256_or_si256(
+            _mm256_or_si256(_mm256_loadu_si256(p), _mm256_loadu_si256(p + 1)),
+            _mm256_or_si256(_mm256_loadu_si256(p + 2),
+                            _mm256_loadu_si256(p + 3)));
+        if (_mm256_movemask_epi8(any)) return false;
+    }
+    return sv_is_ascii_from(s, i);
+}
+
+static bool sv_use_avx2;
+
+__attribute__((constructor)) static void sv_select_kernels(void)
+{
+    __builtin_cpu_init();  // Required before cpu_supports in a constructor
+    sv_use_avx2 = __builtin_cpu_supports("avx2");
+}
+
+#endif  // STRVIEW_X86
+
+/* ---- Public search API ---- */
+
+// Index of the first c in s, or SV_NPOS
+static inline size_t sv_find_byte(StrView s, char c)
+{
+#ifdef STRVIEW_X86
+    return sv_use_avx2 ? sv_find_byte_avx2(s, c) : sv_find_byte_sse2(s, c);
+#else
+    const char *p = (const char *) memchr(s.data, c, s.len);
+    return p ? (size_t) (p - s.data) : SV_NPOS;
+#endif
+}
+
+// Index of the first occurrence of needle in hay, or SV_NPOS; an empty
+// needle matches at 0
+static inline size_t sv_find(StrView hay, StrView needle)
+{
+    if (needle.len == 0) return 0;
+    if (needle.len == 1) return sv_find_byte(hay, needle.data[0]);
+    if (needle.len > hay.len) return SV_NPOS;
+#ifdef STRVIEW_X86
+    return sv_use_avx2 ? sv_find_avx2(hay, needle) : sv_find_sse2(hay, needle);
+#else
+    return sv_find_from(hay, needle, 0);
+#endif
+}
+
+static inline bool sv_contains(StrView hay, StrView needle)
+{
+    return sv_find(hay, needle) != SV_NPOS;
+}
+
+// <0, 0 or >0 like strcmp, ignoring ASCII case
+static inline int sv_casecmp(StrView a, StrView b)
+{
+#ifdef STRVIEW_X86
+    return sv_casecmp_sse2(a, b);
+#else
+    return sv_casecmp_from(a, b, 0);
+#endif
+}
+
+static inline bool sv_is_ascii(StrView s)
+{
+#ifdef STRVIEW_X86
+    return sv_use_avx2 ? sv_is_ascii_avx2(s) : sv_is_ascii_sse2(s);
+#else
+    return sv_is_ascii_from(s, 0);
+#endif
+}
+
+// Split off the text up to the next delim: returns it and advances *rest
+// past the delimiter (or to the end)
+static inline StrView sv_split_next(StrView *rest, char delim)
+{
+    size_t at = sv_find_byte(*rest, delim);
+    size_t len = at == SV_NPOS ? rest->len : at;
+    StrView head = {rest->data, len};
+    size_t skip = at == SV_NPOS ? len : len + 1;
+    rest->data += skip;
+    rest->len -= skip;
+    return head;
+}
+
+#endif  // STRVIEW_H
@@ -22,15 +22,23 @@ void updateScore(Student *s, float newScore)
     s->score = newScore;
 }
 
-// Function to create a new student dynamically
+// Function to create a student as a value: returned in the caller's
+// variable, so there is no allocation and nothing to free
+Student makeStudent(const char *name, int id, float score)
+{
+    Student s = {.id = id, .score = score};
+    snprintf(s.name, sizeof(s.name), "%s", name);
+    return s;
+}
+
+// Function to create a new student dynamically, only for a student that
+// must outlive the caller: an explicit heap copy of makeStudent's value
 Student *createStudent(char *name, int id, float score)
 {
     Student *newStudent = (Student *) malloc(sizeof(Student));
     if (newStudent != NULL)
     {
-        strcpy(newStudent->name, name);
-        newStudent->id = id;
-        newStudent->score = score;
+        *newStudent = makeStudent(name, id, score);
     }
     return newStudent;
 }
@@ -48,6 +56,11 @@ int main()
     printf("\nAfter update:\n");
     displayStudent(student1);
 
+    // Create a structure by value: no malloc, no free
+    Student student3 = makeStudent("Grace Lee", 11223, 88.0);
+    printf("\nStudent returned by value:\n");
+    displayStudent(student3);
+
     // Create dynamic structure
     Student *student2 = createStudent("Mark Wilson", 54321, 78.1);
     if (student2 != NULL)
@@ -1,4 +1,43 @@
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Locale-independent, from_chars-style number conversion. Parsers consume
+// the longest number at the start of [p, end) and return the first
+// unconsumed position, or NULL if there is no number or it overflows.
+// Formatters write at p without a terminator and return the new end.
+const char *parse_int64(const char *p, const char *end, int64_t *out);
+const char *parse_float(const char *p, const char *end, float *out);
+const char *parse_double(const char *p, const char *end, double *out);
+char *format_int64(char *p, int64_t value);
+char *format_fixed(char *p, double value, int decimals);
+
+typedef struct
+{
+    const char *data;  // Not NUL-terminated
+    size_t length;
+} FieldView;
+
+size_t split_fields(const char *p,
+                    const char *end,
+                    char delimiter,
+                    FieldView *fields,
+                    size_t max_fields);
+
+typedef struct
+{
+    char name[50];
+    int age;
+    float height;
+} PersonRecord;
+
+const char *parse_person(const char *p, const char *end, PersonRecord *out);
+char *format_person(char *p, const PersonRecord *person);
+void formatted_io_benchmark(void);
 
 int main(int argc, char *argv[])
 {
@@ -39,5 +78,634 @@ int main(int argc, char *argv[])
     }
 
     fclose(fp);
+
+    formatted_io_benchmark();
+    return 0;
+}
+
+// A decimal number split into significand and power of ten. Up to 19
+// significant digits are kept; 'truncated' records that more were seen.
+typedef struct
+{
+    int negative;
+    uint64_t mantissa;
+    int exponent;
+    int truncated;
+} DecimalNumber;
+
+static const char *scan_decimal(const char *p,
+                                const char *end,
+                                DecimalNumber *d)
+{
+    int digits = 0;
+    int significant = 0;
+
+    memset(d, 0, sizeof(*d));
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        d->negative = *p == '-';
+        p++;
+    }
+
+    for (int fraction = 0;; fraction = 1)
+    {
+        while (p < end && *p >= '0' && *p <= '9')
+        {
+            int digit = *p++ - '0';
+            digits++;
+            if (significant < 19)
+            {
+                d->mantissa = d->mantissa * 10 + digit;
+                significant += d->mantissa != 0;
+                d->exponent -= fraction;
+            }
+            else
+            {
+                d->exponent += !fraction;
+                d->truncated |= digit != 0;
+            }
+        }
+        if (fraction || p == end || *p != '.')
+        {
+            break;
+        }
+        p++;
+    }
+
+    if (digits == 0)
+    {
+        return NULL;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char *q = p + 1;
+        int sign = 1;
+        int value = 0;
+        if (q < end && (*q == '-' || *q == '+'))
+        {
+            sign = *q == '-' ? -1 : 1;
+            q++;
+        }
+        if (q < end && *q >= '0' && *q <= '9')
+        {
+            while (q < end && *q >= '0' && *q <= '9')
+            {
+                if (value < 100000)
+                {
+                    value = value * 10 + (*q - '0');
+                }
+                q++;
+            }
+            d->exponent += sign * value;
+            p = q;
+        }
+    }
+    return p;
+}
+
+// Rare inputs (long significands, huge exponents) go to strtod/strtof on a
+// terminated copy of exactly the scanned characters
+static int parse_fallback(const char *start,
+                          const char *stop,
+                          double *as_double,
+                          float *as_float)
+{
+    char local[128];
+    size_t length = (size_t) (stop - start);
+    char *copy = length < sizeof(local) ? local : malloc(length + 1);
+    if (copy == NULL)
+    {
+        return -1;
+    }
+    memcpy(copy, start, length);
+    copy[length] = '\0';
+
+    if (as_double)
+    {
+        *as_double = strtod(copy, NULL);
+    }
+    else
+    {
+        *as_float = strtof(copy, NULL);
+    }
+
+    if (copy != local)
+    {
+        free(copy);
+    }
     return 0;
 }
+
+static const double exact_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Clinger's fast path: when the significand and the power of ten are both
+// exactly representable, one IEEE multiply or divide is correctly rounded
+const char *parse_double(const char *p, const char *end, double *out)
+{
+    DecimalNumber d;
+    const char *stop = scan_decimal(p, end, &d);
+    if (stop == NULL)
+    {
+        return NULL;
+    }
+
+    if (!d.truncated && d.mantissa <= (UINT64_C(1) << 53)
+        && d.exponent >= -22 && d.exponent <= 22)
+    {
+        double value = (double) d.mantissa;
+        value = d.exponent < 0 ? value / exact_powers_of_ten[-d.exponent]
+                               : value * exact_powers_of_ten[d.exponent];
+        *out = d.negative ? -value : value;
+        return stop;
+    }
+
+    return parse_fallback(p, stop, out, NULL) == 0 ? stop : NULL;
+}
+
+const char *parse_float(const char *p, const char *end, float *out)
+{
+    static const float exact_float_powers[] = {
+        1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+
+    DecimalNumber d;
+    const char *stop = scan_decimal(p, end, &d);
+    if (stop == NULL)
+    {
+        return NULL;
+    }
+
+    // Same fast path in single precision: parsing via double and then
+    // narrowing would round twice
+    if (!d.truncated && d.mantissa <= (1u << 24) && d.exponent >= -10
+        && d.exponent <= 10)
+    {
+        float value = (float) d.mantissa;
+        value = d.exponent < 0 ? value / exact_float_powers[-d.exponent]
+                               : value * exact_float_powers[d.exponent];
+        *out = d.negative ? -value : value;
+        return stop;
+    }
+
+    return parse_fallback(p, stop, NULL, out) == 0 ? stop : NULL;
+}
+
+const char *parse_int64(const char *p, const char *end, int64_t *out)
+{
+    int negative = 0;
+    uint64_t value = 0;
+    const char *digits;
+
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t limit = negative ? (uint64_t) INT64_MAX + 1 : INT64_MAX;
+    for (digits = p; p < end && *p >= '0' && *p <= '9'; p++)
+    {
+        unsigned digit = (unsigned) (*p - '0');
+        if (value > (limit - digit) / 10)
+        {
+            return NULL;  // Overflow
+        }
+        value = value * 10 + digit;
+    }
+
+    if (p == digits)
+    {
+        return NULL;
+    }
+    *out = negative ? (int64_t) (0 - value) : (int64_t) value;
+    return p;
+}
+
+static const char digit_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Unsigned conversion two digits at a time, written back to front
+static char *format_uint64(char *p, uint64_t value)
+{
+    char digits[20];
+    char *q = digits + sizeof(digits);
+
+    while (value >= 100)
+    {
+        unsigned pair = (unsigned) (value % 100);
+        value /= 100;
+        q -= 2;
+        memcpy(q, digit_pairs + pair * 2, 2);
+    }
+    if (value >= 10)
+    {
+        q -= 2;
+        memcpy(q, digit_pairs + value * 2, 2);
+    }
+    else
+    {
+        *--q = (char) ('0' + value);
+    }
+
+    size_t length = (size_t) (digits + sizeof(digits) - q);
+    memcpy(p, q, length);
+    return p + length;
+}
+
+char *format_int64(char *p, int64_t value)
+{
+    if (value < 0)
+    {
+        *p++ = '-';
+        return format_uint64(p, 0 - (uint64_t) value);
+    }
+    return format_uint64(p, (uint64_t) value);
+}
+
+// Rounding error of a * b, exactly (Dekker's product, no FMA needed)
+static double product_error(double a, double b, double product)
+{
+    const double split = 134217729.0;  // 2^27 + 1
+    double ta = split * a;
+    double a_hi = ta - (ta - a);
+    double a_lo = a - a_hi;
+    double tb = split * b;
+    double b_hi = tb - (tb - b);
+    double b_lo = b - b_hi;
+    return ((a_hi * b_hi - product) + a_hi * b_lo + a_lo * b_hi)
+           + a_lo * b_lo;
+}
+
+// Same text as printf("%.*f") for 0..9 decimals while value * 10^decimals
+// fits in 53 bits; anything else goes to snprintf
+char *format_fixed(char *p, double value, int decimals)
+{
+    if (decimals < 0 || decimals > 9 || !isfinite(value)
+        || fabs(value) * exact_powers_of_ten[decimals] >= 4503599627370496.0)
+    {
+        return p + snprintf(p, 352, "%.*f", decimals, value);
+    }
+
+    // The scaled product is rounded, but it can only land exactly on a
+    // .5 tie by rounding; the exact error then says which way printf,
+    // which rounds the exact binary value half to even, would go
+    double scale = exact_powers_of_ten[decimals];
+    double scaled = fabs(value) * scale;
+    uint64_t units = (uint64_t) scaled;
+    double fraction = scaled - (double) units;
+    if (fraction > 0.5)
+    {
+        units++;
+    }
+    else if (fraction == 0.5)
+    {
+        double error = product_error(fabs(value), scale, scaled);
+        units += error > 0 || (error == 0 && (units & 1));
+    }
+
+    if (signbit(value))
+    {
+        *p++ = '-';  // printf keeps the sign of values that round to zero
+    }
+    uint64_t divisor = (uint64_t) scale;
+    p = format_uint64(p, units / divisor);
+    if (decimals > 0)
+    {
+        char digits[20];
+        char *f = format_uint64(digits, units % divisor);
+        size_t length = (size_t) (f - digits);
+
+        *p++ = '.';
+        memset(p, '0', decimals - length);
+        memcpy(p + decimals - length, digits, length);
+        p += decimals;
+    }
+    return p;
+}
+
+// One memchr per delimiter. Returns the number of fields found; fields
+// past max_fields are left in the last one.
+size_t split_fields(const char *p,
+                    const char *end,
+                    char delimiter,
+                    FieldView *fields,
+                    size_t max_fields)
+{
+    size_t count = 0;
+
+    while (count + 1 < max_fields)
+    {
+        const char *next = memchr(p, delimiter, (size_t) (end - p));
+        if (next == NULL)
+        {
+            break;
+        }
+        fields[count].data = p;
+        fields[count].length = (size_t) (next - p);
+        count++;
+        p = next + 1;
+    }
+
+    if (max_fields > 0)
+    {
+        fields[count].data = p;
+        fields[count].length = (size_t) (end - p);
+        count++;
+    }
+    return count;
+}
+
+// Skip leading blanks and an expected label such as "Age: "
+static const char *field_value(const FieldView *field, const char *label)
+{
+    const char *p = field->data;
+    const char *end = field->data + field->length;
+    size_t label_length = strlen(label);
+
+    while (p < end && *p == ' ')
+    {
+        p++;
+    }
+    if ((size_t) (end - p) < label_length || memcmp(p, label, label_length))
+    {
+        return NULL;
+    }
+    return p + label_length;
+}
+
+// Parse one "Name: <name>, Age: <int>, Height: <float>" line. Returns the
+// start of the next line, or NULL if the line does not match.
+const char *parse_person(const char *p, const char *end, PersonRecord *out)
+{
+    const char *line_end = memchr(p, '\n', (size_t) (end - p));
+    const char *next = line_end ? line_end + 1 : end;
+    if (line_end == NULL)
+    {
+        line_end = end;
+    }
+
+    FieldView fields[4];
+    if (split_fields(p, line_end, ',', fields, 4) != 3)
+    {
+        return NULL;
+    }
+
+    const char *value = field_value(&fields[0], "Name: ");
+    const char *field_end = fields[0].data + fields[0].length;
+    if (value == NULL || (size_t) (field_end - value) >= sizeof(out->name))
+    {
+        return NULL;
+    }
+    memcpy(out->name, value, (size_t) (field_end - value));
+    out->name[field_end - value] = '\0';
+
+    int64_t age;
+    value = field_value(&fields[1], "Age: ");
+    field_end = fields[1].data + fields[1].length;
+    if (value == NULL || parse_int64(value, field_end, &age) != field_end
+        || age < INT32_MIN || age > INT32_MAX)
+    {
+        return NULL;
+    }
+    out->age = (int) age;
+
+    value = field_value(&fields[2], "Height: ");
+    field_end = fields[2].data + fields[2].length;
+    if (value == NULL
+        || parse_float(value, field_end, &out->height) != field_end)
+    {
+        return NULL;
+    }
+    return next;
+}
+
+char *format_person(char *p, const PersonRecord *person)
+{
+    size_t name_length = strlen(person->name);
+
+    memcpy(p, "Name: ", 6);
+    memcpy(p + 6, person->name, name_length);
+    p += 6 + name_length;
+    memcpy(p, ", Age: ", 7);
+    p = format_int64(p + 7, person->age);
+    memcpy(p, ", Height: ", 10);
+    p = format_fixed(p + 10, person->height, 2);
+    *p++ = '\n';
+    return p;
+}
+
+static double seconds_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long file_size(const char *filename)
+{
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL)
+    {
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fclose(fp);
+    return size;
+}
+
+static int files_equal(const char *a, const char *b)
+{
+    FILE *fa = fopen(a, "rb");
+    FILE *fb = fopen(b, "rb");
+    int equal = fa != NULL && fb != NULL;
+
+    while (equal)
+    {
+        int ca = getc(fa);
+        int cb = getc(fb);
+        equal = ca == cb;
+        if (ca == EOF)
+        {
+            break;
+        }
+    }
+
+    if (fa != NULL)
+    {
+        fclose(fa);
+    }
+    if (fb != NULL)
+    {
+        fclose(fb);
+    }
+    return equal;
+}
+
+// fprintf/fscanf against the fast formatter and parser on the same data
+void formatted_io_benchmark(void)
+{
+    const size_t count = 1000000;
+    const char *names[] = {"John", "Alice", "Bob Smith", "Maria Garcia"};
+    PersonRecord *people = malloc(count * sizeof(PersonRecord));
+    PersonRecord *scanned = malloc(count * sizeof(PersonRecord));
+    PersonRecord *parsed = malloc(count * sizeof(PersonRecord));
+    char *buffer = malloc(1 << 20);
+    char *text = NULL;
+
+    if (!people || !scanned || !parsed || !buffer)
+    {
+        fprintf(stderr, "Out of memory\n");
+        goto done;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        snprintf(people[i].name,
+                 sizeof(people[i].name),
+                 "%s %zu",
+                 names[i % 4],
+                 i);
+        people[i].age = 18 + (int) (i * 7919 % 70);
+        people[i].height = (140 + (int) (i * 104729 % 70)) / 100.0f;
+    }
+
+    printf("\n%zu records:\n", count);
+
+    // Formatting
+    double start = seconds_now();
+    FILE *fp = fopen("formatted_slow.txt", "w");
+    if (fp == NULL)
+    {
+        perror("Error opening file for writing ");
+        goto done;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        fprintf(fp,
+                "Name: %s, Age: %d, Height: %.2f\n",
+                people[i].name,
+                people[i].age,
+                people[i].height);
+    }
+    fclose(fp);
+    double fprintf_time = seconds_now() - start;
+
+    start = seconds_now();
+    fp = fopen("formatted_fast.txt", "w");
+    if (fp == NULL)
+    {
+        perror("Error opening file for writing ");
+        goto done;
+    }
+    char *out = buffer;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (out - buffer > (1 << 20) - 256)
+        {
+            fwrite(buffer, 1, (size_t) (out - buffer), fp);
+            out = buffer;
+        }
+        out = format_person(out, &people[i]);
+    }
+    fwrite(buffer, 1, (size_t) (out - buffer), fp);
+    fclose(fp);
+    double format_time = seconds_now() - start;
+
+    long size = file_size("formatted_fast.txt");
+    printf("  fprintf:       %.3f s\n", fprintf_time);
+    printf("  format_person: %.3f s (%.1fx), output %s\n",
+           format_time,
+           fprintf_time / format_time,
+           files_equal("formatted_slow.txt", "formatted_fast.txt")
+               ? "identical"
+               : "DIFFERS");
+
+    // Parsing
+    start = seconds_now();
+    fp = fopen("formatted_slow.txt", "r");
+    if (fp == NULL)
+    {
+        perror("Error opening file for reading ");
+        goto done;
+    }
+    size_t scanned_count = 0;
+    while (scanned_count < count
+           && fscanf(fp,
+                     "Name: %49[^,], Age: %d, Height: %f\n",
+                     scanned[scanned_count].name,
+                     &scanned[scanned_count].age,
+                     &scanned[scanned_count].height)
+                  == 3)
+    {
+        scanned_count++;
+    }
+    fclose(fp);
+    double fscanf_time = seconds_now() - start;
+
+    // Whole file in one read, then parse in place
+    start = seconds_now();
+    fp = fopen("formatted_fast.txt", "rb");
+    text = malloc((size_t) size + 1);
+    if (fp == NULL || text == NULL
+        || fread(text, 1, (size_t) size, fp) != (size_t) size)
+    {
+        perror("Error reading formatted file");
+        if (fp != NULL)
+        {
+            fclose(fp);
+        }
+        goto done;
+    }
+    fclose(fp);
+
+    const char *p = text;
+    const char *end = text + size;
+    size_t parsed_count = 0;
+    while (p < end && parsed_count < count)
+    {
+        p = parse_person(p, end, &parsed[parsed_count]);
+        if (p == NULL)
+        {
+            fprintf(stderr, "Parse error at record %zu\n", parsed_count);
+            break;
+        }
+        parsed_count++;
+    }
+    double parse_time = seconds_now() - start;
+
+    size_t mismatches = scanned_count == parsed_count ? 0 : count;
+    for (size_t i = 0; i < parsed_count && i < scanned_count; i++)
+    {
+        if (strcmp(scanned[i].name, parsed[i].name) != 0
+            || scanned[i].age != parsed[i].age
+            || memcmp(&scanned[i].height, &parsed[i].height, sizeof(float)))
+        {
+            mismatches++;
+        }
+    }
+
+    printf("  fscanf:        %.3f s, %zu records\n",
+           fscanf_time,
+           scanned_count);
+    printf("  parse_person:  %.3f s (%.1fx), %zu records, %zu mismatches\n",
+           parse_time,
+           fscanf_time / parse_time,
+           parsed_count,
+           mismatches);
+
+done:
+    remove("formatted_slow.txt");
+    remove("formatted_fast.txt");
+    free(text);
+    free(buffer);
+    free(parsed);
+    free(scanned);
+    free(people);
+}
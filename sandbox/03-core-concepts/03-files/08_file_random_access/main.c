@@ -1,5 +1,13 @@
+#define _FILE_OFFSET_BITS 64
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include "../../../06-professional-devlopment/01-advanced-C-features/const_tables.h"
 
 typedef struct
 {
@@ -10,6 +18,51 @@ typedef struct
 
 void printEmployee(Employee *emp);
 
+// Employee record with variable-length text fields, stored in an indexed
+// file: sorted records packed into compressed, checksummed blocks, then a
+// sparse index (one entry per block) and a fixed-size footer. A lookup by
+// id binary-searches the in-memory index and reads exactly one block.
+//
+// [block 0][block 1]...[block N-1][index: N entries][footer]
+typedef struct
+{
+    int id;
+    float salary;
+    const char *name;
+    const char *department;
+} EmployeeRecord;
+
+typedef struct
+{
+    int32_t first_id;
+    int32_t last_id;
+    uint64_t offset;
+    uint32_t stored_size;  // Equal to raw_size when stored uncompressed
+    uint32_t raw_size;
+    uint32_t crc;  // CRC-32 of the stored bytes
+} EmpxIndexEntry;
+
+typedef struct
+{
+    FILE *fp;
+    uint32_t block_count;
+    uint32_t record_count;
+    EmpxIndexEntry *index;
+    unsigned char *stored;  // Block as read from disk
+    unsigned char *block;   // Decompressed block, backs returned strings
+    size_t capacity;
+    long cached_block;  // Block currently in 'block', or -1
+    unsigned long reads;
+} EmpxFile;
+
+int empx_write(const char *filename,
+               const EmployeeRecord *records,
+               size_t count);
+int empx_open(EmpxFile *f, const char *filename);
+int empx_lookup(EmpxFile *f, int id, EmployeeRecord *out);
+void empx_close(EmpxFile *f);
+void indexed_file_demo(void);
+
 int main(int argc, char *argv[])
 {
     FILE *fp;
@@ -58,6 +111,8 @@ int main(int argc, char *argv[])
     }
 
     fclose(fp);
+
+    indexed_file_demo();
     return 0;
 }
 
@@ -65,3 +120,753 @@ void printEmployee(Employee *emp)
 {
     printf("ID: %d, Name: %s, Salary: %.2f\n", emp->id, emp->name, emp->salary);
 }
+
+#define EMPX_MAGIC 0x58504D45u  // "EMPX" little-endian
+#define EMPX_VERSION 1
+#define EMPX_BLOCK_TARGET (16 * 1024)  // Raw bytes per block
+#define EMPX_INDEX_ENTRY_SIZE 28
+#define EMPX_FOOTER_SIZE 32
+#define EMPX_MAX_TEXT 65535
+
+// All integers are stored little-endian regardless of host byte order
+static void put_u16(unsigned char *p, uint16_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        p[i] = (v >> (8 * i)) & 0xff;
+    }
+}
+
+static void put_u64(unsigned char *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        p[i] = (v >> (8 * i)) & 0xff;
+    }
+}
+
+static uint16_t get_u16(const unsigned char *p)
+{
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--)
+    {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static uint64_t get_u64(const unsigned char *p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--)
+    {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+// Table computed at compile time, so there is no first-call fill
+static uint32_t crc32_update(const unsigned char *data, size_t length)
+{
+    return table_crc32_update(0, data, length);
+}
+
+// Small byte-oriented LZ77 used for block compression. A control byte
+// below 0x80 introduces (c + 1) literal bytes; otherwise it is a match of
+// (c & 0x7f) + 3 bytes at a 16-bit little-endian back distance.
+#define LZ_HASH_BITS 12
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_MATCH (0x7f + LZ_MIN_MATCH)
+
+static int lz_emit_literals(const unsigned char *src,
+                            size_t length,
+                            unsigned char *dst,
+                            size_t capacity,
+                            size_t *op)
+{
+    while (length > 0)
+    {
+        size_t run = length > 128 ? 128 : length;
+        if (*op + 1 + run > capacity)
+        {
+            return 0;
+        }
+        dst[(*op)++] = (unsigned char) (run - 1);
+        memcpy(dst + *op, src, run);
+        *op += run;
+        src += run;
+        length -= run;
+    }
+    return 1;
+}
+
+// Returns the compressed size, or 0 if the output would not fit in
+// capacity (the caller then stores the block raw)
+static size_t lz_compress(const unsigned char *src,
+                          size_t length,
+                          unsigned char *dst,
+                          size_t capacity)
+{
+    uint32_t table[1 << LZ_HASH_BITS] = {0};  // Position + 1, 0 = empty
+    size_t ip = 0;
+    size_t op = 0;
+    size_t literal_start = 0;
+
+    while (ip + LZ_MIN_MATCH <= length)
+    {
+        uint32_t key = src[ip] | (src[ip + 1] << 8) | (src[ip + 2] << 16);
+        uint32_t hash = (key * 2654435761u) >> (32 - LZ_HASH_BITS);
+        size_t candidate = table[hash];
+        table[hash] = (uint32_t) ip + 1;
+
+        if (candidate && ip - (candidate - 1) <= 0xffff
+            && memcmp(src + candidate - 1, src + ip, LZ_MIN_MATCH) == 0)
+        {
+            size_t ref = candidate - 1;
+            size_t match = LZ_MIN_MATCH;
+            while (ip + match < length && match < LZ_MAX_MATCH
+                   && src[ref + match] == src[ip + match])
+            {
+                match++;
+            }
+
+            if (!lz_emit_literals(src + literal_start,
+                                  ip - literal_start,
+                                  dst,
+                                  capacity,
+                                  &op)
+                || op + 3 > capacity)
+            {
+                return 0;
+            }
+            dst[op++] = (unsigned char) (0x80 | (match - LZ_MIN_MATCH));
+            put_u16(dst + op, (uint16_t) (ip - ref));
+            op += 2;
+
+            ip += match;
+            literal_start = ip;
+        }
+        else
+        {
+            ip++;
+        }
+    }
+
+    if (!lz_emit_literals(
+            src + literal_start, length - literal_start, dst, capacity, &op))
+    {
+        return 0;
+    }
+    return op;
+}
+
+static int lz_decompress(const unsigned char *src,
+                         size_t length,
+                         unsigned char *dst,
+                         size_t raw_size)
+{
+    size_t ip = 0;
+    size_t op = 0;
+
+    while (ip < length)
+    {
+        unsigned c = src[ip++];
+        if (c < 0x80)
+        {
+            size_t run = c + 1;
+            if (ip + run > length || op + run > raw_size)
+            {
+                return -1;
+            }
+            memcpy(dst + op, src + ip, run);
+            ip += run;
+            op += run;
+        }
+        else
+        {
+            size_t match = (c & 0x7f) + LZ_MIN_MATCH;
+            if (ip + 2 > length)
+            {
+                return -1;
+            }
+            size_t distance = get_u16(src + ip);
+            ip += 2;
+            if (distance == 0 || distance > op || op + match > raw_size)
+            {
+                return -1;
+            }
+            // Byte by byte: a match may overlap its own output
+            for (size_t i = 0; i < match; i++, op++)
+            {
+                dst[op] = dst[op - distance];
+            }
+        }
+    }
+    return op == raw_size ? 0 : -1;
+}
+
+static int compare_record_ids(const void *a, const void *b)
+{
+    const EmployeeRecord *x = *(const EmployeeRecord *const *) a;
+    const EmployeeRecord *y = *(const EmployeeRecord *const *) b;
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+// Compress (if it pays) and append one block plus its index entry
+static int empx_flush_block(FILE *fp,
+                            unsigned char *raw,
+                            size_t raw_size,
+                            unsigned char *scratch,
+                            EmpxIndexEntry *entry,
+                            uint64_t *offset)
+{
+    size_t stored_size = lz_compress(raw, raw_size, scratch, raw_size - 1);
+    const unsigned char *stored = scratch;
+    if (stored_size == 0)
+    {
+        stored = raw;
+        stored_size = raw_size;
+    }
+
+    if (fwrite(stored, 1, stored_size, fp) != stored_size)
+    {
+        perror("Error writing block");
+        return -1;
+    }
+
+    entry->offset = *offset;
+    entry->stored_size = (uint32_t) stored_size;
+    entry->raw_size = (uint32_t) raw_size;
+    entry->crc = crc32_update(stored, stored_size);
+    *offset += stored_size;
+    return 0;
+}
+
+// Write records as an indexed file. Records may be given in any order;
+// they are stored sorted by id, and duplicate ids are rejected.
+int empx_write(const char *filename,
+               const EmployeeRecord *records,
+               size_t count)
+{
+    const EmployeeRecord **sorted = malloc(count * sizeof(*sorted) + 1);
+    size_t max_blocks = count + 1;
+    EmpxIndexEntry *index = malloc(max_blocks * sizeof(EmpxIndexEntry));
+    size_t raw_capacity = EMPX_BLOCK_TARGET + 2 * EMPX_MAX_TEXT + 16;
+    unsigned char *raw = malloc(raw_capacity);
+    unsigned char *scratch = malloc(raw_capacity);
+    FILE *fp = NULL;
+    int result = -1;
+
+    if (!sorted || !index || !raw || !scratch)
+    {
+        fprintf(stderr, "Out of memory writing %s\n", filename);
+        goto done;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        sorted[i] = &records[i];
+    }
+    qsort(sorted, count, sizeof(*sorted), compare_record_ids);
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL)
+    {
+        perror("Error opening indexed file for writing");
+        goto done;
+    }
+
+    uint64_t offset = 0;
+    size_t blocks = 0;
+    size_t raw_size = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const EmployeeRecord *r = sorted[i];
+        size_t name_len = strlen(r->name);
+        size_t dept_len = strlen(r->department);
+
+        if (i > 0 && sorted[i - 1]->id == r->id)
+        {
+            fprintf(stderr, "Duplicate employee id %d\n", r->id);
+            goto done;
+        }
+        if (name_len > EMPX_MAX_TEXT || dept_len > EMPX_MAX_TEXT)
+        {
+            fprintf(stderr, "Text field too long for id %d\n", r->id);
+            goto done;
+        }
+
+        if (raw_size == 0)
+        {
+            index[blocks].first_id = r->id;
+        }
+
+        // id, salary, then each string as length + bytes + NUL so lookups
+        // can hand out pointers into the decoded block
+        unsigned char *p = raw + raw_size;
+        uint32_t salary_bits;
+        memcpy(&salary_bits, &r->salary, sizeof(salary_bits));
+        put_u32(p, (uint32_t) r->id);
+        put_u32(p + 4, salary_bits);
+        p += 8;
+        put_u16(p, (uint16_t) name_len);
+        memcpy(p + 2, r->name, name_len + 1);
+        p += 2 + name_len + 1;
+        put_u16(p, (uint16_t) dept_len);
+        memcpy(p + 2, r->department, dept_len + 1);
+        p += 2 + dept_len + 1;
+        raw_size = p - raw;
+
+        index[blocks].last_id = r->id;
+        if (raw_size >= EMPX_BLOCK_TARGET)
+        {
+            if (empx_flush_block(
+                    fp, raw, raw_size, scratch, &index[blocks], &offset)
+                != 0)
+            {
+                goto done;
+            }
+            blocks++;
+            raw_size = 0;
+        }
+    }
+
+    if (raw_size > 0)
+    {
+        if (empx_flush_block(
+                fp, raw, raw_size, scratch, &index[blocks], &offset)
+            != 0)
+        {
+            goto done;
+        }
+        blocks++;
+    }
+
+    // Index block, then the footer that locates and validates it
+    unsigned char *encoded = malloc(blocks * EMPX_INDEX_ENTRY_SIZE + 1);
+    if (!encoded)
+    {
+        fprintf(stderr, "Out of memory writing %s\n", filename);
+        goto done;
+    }
+    for (size_t b = 0; b < blocks; b++)
+    {
+        unsigned char *e = encoded + b * EMPX_INDEX_ENTRY_SIZE;
+        put_u32(e, (uint32_t) index[b].first_id);
+        put_u32(e + 4, (uint32_t) index[b].last_id);
+        put_u64(e + 8, index[b].offset);
+        put_u32(e + 16, index[b].stored_size);
+        put_u32(e + 20, index[b].raw_size);
+        put_u32(e + 24, index[b].crc);
+    }
+    size_t index_size = blocks * EMPX_INDEX_ENTRY_SIZE;
+
+    unsigned char footer[EMPX_FOOTER_SIZE];
+    put_u32(footer, EMPX_MAGIC);
+    put_u32(footer + 4, EMPX_VERSION);
+    put_u64(footer + 8, offset);
+    put_u32(footer + 16, (uint32_t) blocks);
+    put_u32(footer + 20, (uint32_t) count);
+    put_u32(footer + 24, crc32_update(encoded, index_size));
+    put_u32(footer + 28, crc32_update(footer, 28));
+
+    if (fwrite(encoded, 1, index_size, fp) != index_size
+        || fwrite(footer, 1, sizeof(footer), fp) != sizeof(footer))
+    {
+        perror("Error writing index");
+        free(encoded);
+        goto done;
+    }
+    free(encoded);
+    result = 0;
+
+done:
+    if (fp != NULL && fclose(fp) != 0 && result == 0)
+    {
+        perror("Error closing indexed file");
+        result = -1;
+    }
+    free(scratch);
+    free(raw);
+    free(index);
+    free(sorted);
+    return result;
+}
+
+// Read and validate the footer and index. Costs two reads.
+int empx_open(EmpxFile *f, const char *filename)
+{
+    unsigned char footer[EMPX_FOOTER_SIZE];
+    unsigned char *encoded = NULL;
+
+    memset(f, 0, sizeof(*f));
+    f->cached_block = -1;
+
+    f->fp = fopen(filename, "rb");
+    if (f->fp == NULL)
+    {
+        perror("Error opening indexed file");
+        return -1;
+    }
+
+    if (fseeko(f->fp, -EMPX_FOOTER_SIZE, SEEK_END) != 0
+        || fread(footer, 1, sizeof(footer), f->fp) != sizeof(footer))
+    {
+        fprintf(stderr, "%s: too short for an indexed file\n", filename);
+        goto fail;
+    }
+    f->reads++;
+
+    if (get_u32(footer) != EMPX_MAGIC || get_u32(footer + 4) != EMPX_VERSION
+        || get_u32(footer + 28) != crc32_update(footer, 28))
+    {
+        fprintf(stderr, "%s: bad footer\n", filename);
+        goto fail;
+    }
+
+    uint64_t index_offset = get_u64(footer + 8);
+    f->block_count = get_u32(footer + 16);
+    f->record_count = get_u32(footer + 20);
+    size_t index_size = (size_t) f->block_count * EMPX_INDEX_ENTRY_SIZE;
+
+    encoded = malloc(index_size + 1);
+    f->index = malloc((f->block_count + 1) * sizeof(EmpxIndexEntry));
+    if (!encoded || !f->index)
+    {
+        fprintf(stderr, "Out of memory opening %s\n", filename);
+        goto fail;
+    }
+
+    if (fseeko(f->fp, (off_t) index_offset, SEEK_SET) != 0
+        || fread(encoded, 1, index_size, f->fp) != index_size)
+    {
+        fprintf(stderr, "%s: truncated index\n", filename);
+        goto fail;
+    }
+    f->reads++;
+
+    if (crc32_update(encoded, index_size) != get_u32(footer + 24))
+    {
+        fprintf(stderr, "%s: index checksum mismatch\n", filename);
+        goto fail;
+    }
+
+    size_t max_raw = 0;
+    for (uint32_t b = 0; b < f->block_count; b++)
+    {
+        const unsigned char *e = encoded + (size_t) b * EMPX_INDEX_ENTRY_SIZE;
+        EmpxIndexEntry *entry = &f->index[b];
+        entry->first_id = (int32_t) get_u32(e);
+        entry->last_id = (int32_t) get_u32(e + 4);
+        entry->offset = get_u64(e + 8);
+        entry->stored_size = get_u32(e + 16);
+        entry->raw_size = get_u32(e + 20);
+        entry->crc = get_u32(e + 24);
+
+        if (entry->stored_size > entry->raw_size
+            || entry->offset + entry->stored_size > index_offset)
+        {
+            fprintf(stderr, "%s: bad index entry %u\n", filename, b);
+            goto fail;
+        }
+        if (entry->raw_size > max_raw)
+        {
+            max_raw = entry->raw_size;
+        }
+    }
+
+    f->capacity = max_raw;
+    f->stored = malloc(max_raw + 1);
+    f->block = malloc(max_raw + 1);
+    if (!f->stored || !f->block)
+    {
+        fprintf(stderr, "Out of memory opening %s\n", filename);
+        goto fail;
+    }
+
+    free(encoded);
+    return 0;
+
+fail:
+    free(encoded);
+    empx_close(f);
+    return -1;
+}
+
+// Load block b into f->block, verifying its checksum. One read unless the
+// block is already cached.
+static int empx_load_block(EmpxFile *f, uint32_t b)
+{
+    if (f->cached_block == (long) b)
+    {
+        return 0;
+    }
+
+    const EmpxIndexEntry *entry = &f->index[b];
+    f->cached_block = -1;
+
+    if (fseeko(f->fp, (off_t) entry->offset, SEEK_SET) != 0
+        || fread(f->stored, 1, entry->stored_size, f->fp)
+               != entry->stored_size)
+    {
+        fprintf(stderr, "Error reading block %u\n", b);
+        return -1;
+    }
+    f->reads++;
+
+    if (crc32_update(f->stored, entry->stored_size) != entry->crc)
+    {
+        fprintf(stderr, "Checksum mismatch in block %u\n", b);
+        return -1;
+    }
+
+    if (entry->stored_size == entry->raw_size)
+    {
+        memcpy(f->block, f->stored, entry->raw_size);
+    }
+    else if (lz_decompress(
+                 f->stored, entry->stored_size, f->block, entry->raw_size)
+             != 0)
+    {
+        fprintf(stderr, "Corrupt compressed data in block %u\n", b);
+        return -1;
+    }
+
+    f->cached_block = b;
+    return 0;
+}
+
+// Find a record by id. Returns 1 and fills out if found, 0 if absent and
+// -1 on error. The strings in out stay valid until the next lookup.
+int empx_lookup(EmpxFile *f, int id, EmployeeRecord *out)
+{
+    // Last block whose first id is <= id
+    uint32_t lo = 0;
+    uint32_t hi = f->block_count;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (f->index[mid].first_id <= id)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    if (lo == 0 || f->index[lo - 1].last_id < id)
+    {
+        return 0;  // Answered from the index alone
+    }
+
+    uint32_t b = lo - 1;
+    if (empx_load_block(f, b) != 0)
+    {
+        return -1;
+    }
+
+    const unsigned char *p = f->block;
+    const unsigned char *end = f->block + f->index[b].raw_size;
+    while (p < end)
+    {
+        if (end - p < 10)
+        {
+            break;
+        }
+        int record_id = (int32_t) get_u32(p);
+        uint32_t salary_bits = get_u32(p + 4);
+        size_t name_len = get_u16(p + 8);
+        const unsigned char *name = p + 10;
+        if ((size_t) (end - name) < name_len + 3)
+        {
+            break;
+        }
+        size_t dept_len = get_u16(name + name_len + 1);
+        const unsigned char *dept = name + name_len + 3;
+        if ((size_t) (end - dept) < dept_len + 1)
+        {
+            break;
+        }
+
+        if (record_id == id)
+        {
+            out->id = record_id;
+            memcpy(&out->salary, &salary_bits, sizeof(out->salary));
+            out->name = (const char *) name;
+            out->department = (const char *) dept;
+            return 1;
+        }
+        if (record_id > id)
+        {
+            return 0;  // Records are sorted within the block
+        }
+        p = dept + dept_len + 1;
+    }
+
+    if (p != end)
+    {
+        fprintf(stderr, "Malformed record in block %u\n", b);
+        return -1;
+    }
+    return 0;
+}
+
+void empx_close(EmpxFile *f)
+{
+    if (f->fp != NULL)
+    {
+        fclose(f->fp);
+    }
+    free(f->index);
+    free(f->stored);
+    free(f->block);
+    memset(f, 0, sizeof(*f));
+    f->cached_block = -1;
+}
+
+static double seconds_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void indexed_file_demo(void)
+{
+    const char *filename = "employees_indexed.dat";
+    const size_t count = 200000;
+    const char *departments[] = {"Engineering",
+                                 "Finance",
+                                 "Human Resources",
+                                 "Marketing",
+                                 "Operations",
+                                 "Research and Development",
+                                 "Sales",
+                                 "Customer Support"};
+
+    printf("\nIndexed file with %zu variable-length records:\n", count);
+
+    EmployeeRecord *records = malloc(count * sizeof(EmployeeRecord));
+    char (*names)[40] = malloc(count * sizeof(*names));
+    if (!records || !names)
+    {
+        fprintf(stderr, "Out of memory\n");
+        free(records);
+        free(names);
+        return;
+    }
+
+    // Sparse ids (every third) so some lookups miss; shuffled so the
+    // writer has to sort
+    srand(42);
+    for (size_t i = 0; i < count; i++)
+    {
+        snprintf(names[i], sizeof(names[i]), "Employee %06zu", i);
+        records[i].id = 1000 + (int) i * 3;
+        records[i].salary = 30000.0f + (float) (rand() % 70000);
+        records[i].name = names[i];
+        records[i].department = departments[rand() % 8];
+    }
+    for (size_t i = count - 1; i > 0; i--)
+    {
+        size_t j = (size_t) rand() % (i + 1);
+        EmployeeRecord t = records[i];
+        records[i] = records[j];
+        records[j] = t;
+    }
+
+    if (empx_write(filename, records, count) != 0)
+    {
+        free(records);
+        free(names);
+        return;
+    }
+
+    EmpxFile f;
+    if (empx_open(&f, filename) != 0)
+    {
+        free(records);
+        free(names);
+        return;
+    }
+
+    off_t file_size = 0;
+    fseeko(f.fp, 0, SEEK_END);
+    file_size = ftello(f.fp);
+    printf("  %u blocks, %ld bytes on disk (fixed-size layout: %zu bytes)\n",
+           f.block_count,
+           (long) file_size,
+           count * sizeof(Employee));
+
+    EmployeeRecord found;
+    if (empx_lookup(&f, records[0].id, &found) == 1)
+    {
+        printf("  Lookup %d -> ", records[0].id);
+        printf("Name: %s, Department: %s, Salary: %.2f\n",
+               found.name,
+               found.department,
+               found.salary);
+    }
+
+    // Random point lookups, about a third of which miss
+    const int lookups = 100000;
+    unsigned long reads_before = f.reads;
+    int hits = 0;
+    double start = seconds_now();
+    for (int i = 0; i < lookups; i++)
+    {
+        int id = 1000 + rand() % (int) (count * 3);
+        int rc = empx_lookup(&f, id, &found);
+        if (rc < 0)
+        {
+            break;
+        }
+        hits += rc;
+    }
+    double elapsed = seconds_now() - start;
+    printf("  %d lookups: %d hits, %.2f block reads per lookup, %.2f us each\n",
+           lookups,
+           hits,
+           (double) (f.reads - reads_before) / lookups,
+           elapsed * 1e6 / lookups);
+
+    // Flip one byte inside the first data block; the checksum catches it
+    uint64_t victim = f.index[0].offset + f.index[0].stored_size / 2;
+    int first_id = f.index[0].first_id;
+    empx_close(&f);
+
+    FILE *fp = fopen(filename, "rb+");
+    if (fp != NULL)
+    {
+        fseeko(fp, (off_t) victim, SEEK_SET);
+        int c = fgetc(fp);
+        fseeko(fp, (off_t) victim, SEEK_SET);
+        fputc(c ^ 0x5a, fp);
+        fclose(fp);
+
+        if (empx_open(&f, filename) == 0)
+        {
+            printf("  After corrupting block 0, lookup %d returns %d\n",
+                   first_id,
+                   empx_lookup(&f, first_id, &found));
+            empx_close(&f);
+        }
+    }
+
+    remove(filename);
+    free(records);
+    free(names);
+}
@@ -1,6 +1,8 @@
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 // 0. sum_n (n + n-1 + n-2 + ... + 2 + 1)
 unsigned int sum_n(int n)
@@ -85,6 +87,286 @@ unsigned long climb_stairs(int n)
     return climb_stairs(n - 1) + climb_stairs(n - 2);
 }
 
+// 6. Memoization: a bounded cache keyed by argument
+/**
+ * Direct-mapped: argument n lives in slot n % capacity, so memory stays
+ * fixed however many distinct arguments are seen, and a collision simply
+ * evicts the older entry (it will be recomputed if needed again).
+ */
+typedef struct
+{
+    int *keys;
+    unsigned long long *values;
+    bool *valid;
+    size_t capacity;
+} Memo;
+
+bool memo_init(Memo *memo, size_t capacity)
+{
+    memo->keys = (int *) malloc(capacity * sizeof(int));
+    memo->values =
+        (unsigned long long *) malloc(capacity * sizeof(unsigned long long));
+    memo->valid = (bool *) calloc(capacity, sizeof(bool));
+    memo->capacity = capacity;
+
+    if (!memo->keys || !memo->values || !memo->valid)
+    {
+        free(memo->keys);
+        free(memo->values);
+        free(memo->valid);
+        return false;
+    }
+    return true;
+}
+
+void memo_free(Memo *memo)
+{
+    free(memo->keys);
+    free(memo->values);
+    free(memo->valid);
+}
+
+bool memo_lookup(const Memo *memo, int key, unsigned long long *value)
+{
+    size_t slot = (unsigned int) key % memo->capacity;
+    if (memo->valid[slot] && memo->keys[slot] == key)
+    {
+        *value = memo->values[slot];
+        return true;
+    }
+    return false;
+}
+
+void memo_store(Memo *memo, int key, unsigned long long value)
+{
+    size_t slot = (unsigned int) key % memo->capacity;
+    memo->keys[slot] = key;
+    memo->values[slot] = value;
+    memo->valid[slot] = true;
+}
+
+// 7. climb_stairs, three ways faster than the plain recursion above
+/**
+ * climb_stairs(n) is fibonacci(n + 1), so 91 is the largest n whose answer
+ * fits in 64 bits; the versions below return 0 past that rather than a
+ * wrapped-around count.
+ */
+#define CLIMB_STAIRS_MAX 91
+
+// Same recursion, but each n is computed once: O(n) instead of O(phi^n)
+unsigned long climb_stairs_memo(int n, Memo *memo)
+{
+    if (n <= 0 || n > CLIMB_STAIRS_MAX) return 0;
+    if (n == 1) return 1;
+    if (n == 2) return 2;
+
+    unsigned long long cached;
+    if (memo_lookup(memo, n, &cached)) return cached;
+
+    unsigned long ways =
+        climb_stairs_memo(n - 1, memo) + climb_stairs_memo(n - 2, memo);
+    memo_store(memo, n, ways);
+    return ways;
+}
+
+// Bottom-up DP: only the last two answers are needed, so O(1) memory
+unsigned long climb_stairs_iterative(int n)
+{
+    if (n <= 0 || n > CLIMB_STAIRS_MAX) return 0;
+
+    unsigned long prev = 1;  // ways to climb 0 steps
+    unsigned long curr = 1;  // ways to climb 1 step
+    for (int i = 2; i <= n; i++)
+    {
+        unsigned long next = prev + curr;
+        prev = curr;
+        curr = next;
+    }
+    return curr;
+}
+
+/**
+ * [[1, 1], [1, 0]]^k = [[F(k+1), F(k)], [F(k), F(k-1)]], and the power is
+ * computed by repeated squaring: O(log n) 2x2 multiplications.
+ */
+unsigned long climb_stairs_matrix(int n)
+{
+    if (n <= 0 || n > CLIMB_STAIRS_MAX) return 0;
+
+    // result = identity, base = Q; we want F(n + 1) = Q^n [0][0]
+    unsigned long r00 = 1, r01 = 0, r10 = 0, r11 = 1;
+    unsigned long b00 = 1, b01 = 1, b10 = 1, b11 = 0;
+
+    for (unsigned int k = (unsigned int) n; k > 0; k >>= 1)
+    {
+        if (k & 1)
+        {
+            unsigned long t00 = r00 * b00 + r01 * b10;
+            unsigned long t01 = r00 * b01 + r01 * b11;
+            unsigned long t10 = r10 * b00 + r11 * b10;
+            unsigned long t11 = r10 * b01 + r11 * b11;
+            r00 = t00, r01 = t01, r10 = t10, r11 = t11;
+        }
+        if (k > 1)
+        {
+            // Squaring past the last bit needed would overflow (harmlessly,
+            // but pointlessly), so it is skipped
+            unsigned long t00 = b00 * b00 + b01 * b10;
+            unsigned long t01 = b00 * b01 + b01 * b11;
+            unsigned long t10 = b10 * b00 + b11 * b10;
+            unsigned long t11 = b10 * b01 + b11 * b11;
+            b00 = t00, b01 = t01, b10 = t10, b11 = t11;
+        }
+    }
+    return r00;
+}
+
+// 8. sum_n and reverse without one stack frame per element
+unsigned long long sum_n_closed_form(unsigned int n)
+{
+    return (unsigned long long) n * (n + 1) / 2;
+}
+
+void reverse_iterative(char *str, size_t length)
+{
+    if (length < 2) return;
+
+    for (size_t left = 0, right = length - 1; left < right; left++, right--)
+    {
+        char temp = str[left];
+        str[left] = str[right];
+        str[right] = temp;
+    }
+}
+
+// 9. factorial in 128 bits, with overflow detection
+#if defined(__SIZEOF_INT128__)
+typedef unsigned __int128 uint128;
+
+/**
+ * 34! is the largest factorial that fits in 128 bits (20! for 64 bits).
+ * Returns false instead of a silently wrapped value when n! does not fit.
+ */
+bool factorial_checked(unsigned int n, uint128 *result)
+{
+    uint128 product = 1;
+    for (unsigned int i = 2; i <= n; i++)
+    {
+        if (__builtin_mul_overflow(product, (uint128) i, &product))
+        {
+            return false;
+        }
+    }
+    *result = product;
+    return true;
+}
+
+// printf has no 128-bit conversion; buffer must hold 40 characters
+char *uint128_to_string(uint128 value, char *buffer)
+{
+    char digits[40];
+    int count = 0;
+
+    do
+    {
+        digits[count++] = (char) ('0' + (int) (value % 10));
+        value /= 10;
+    } while (value != 0);
+
+    for (int i = 0; i < count; i++)
+    {
+        buffer[i] = digits[count - 1 - i];
+    }
+    buffer[count] = '\0';
+    return buffer;
+}
+#endif
+
+// 10. Benchmark: how far apart the recursive and iterative versions are
+double seconds_since(clock_t start)
+{
+    return ((double) (clock() - start)) / CLOCKS_PER_SEC;
+}
+
+void benchmark_recursion()
+{
+    printf("\n=== Benchmark: Recursive vs Memoized vs Iterative ===\n");
+
+    // Naive recursion makes about 2 * climb_stairs(n) calls: 40 is ~330M
+    const int naive_n = 40;
+    const int repeats = 100000;
+    volatile unsigned long sink;
+    Memo memo;
+
+    if (!memo_init(&memo, 128)) return;
+
+    clock_t start = clock();
+    sink = climb_stairs(naive_n);
+    printf("climb_stairs(%d) naive:     %12.6f s (once)\n",
+           naive_n,
+           seconds_since(start));
+
+    start = clock();
+    for (int r = 0; r < repeats; r++)
+    {
+        // Start cold each time so the recursion actually runs
+        memset(memo.valid, 0, memo.capacity * sizeof(bool));
+        sink = climb_stairs_memo(naive_n, &memo);
+    }
+    printf("climb_stairs(%d) memoized:  %12.9f s per call\n",
+           naive_n,
+           seconds_since(start) / repeats);
+
+    start = clock();
+    for (int r = 0; r < repeats; r++)
+    {
+        sink = climb_stairs_iterative(naive_n + (r & 1));
+    }
+    printf("climb_stairs(%d) iterative: %12.9f s per call\n",
+           naive_n,
+           seconds_since(start) / repeats);
+
+    start = clock();
+    for (int r = 0; r < repeats; r++)
+    {
+        sink = climb_stairs_matrix(naive_n + (r & 1));
+    }
+    printf("climb_stairs(%d) matrix:    %12.9f s per call\n",
+           naive_n,
+           seconds_since(start) / repeats);
+    (void) sink;
+
+    printf("All agree: %s; climb_stairs(%d) = %lu\n",
+           climb_stairs_memo(naive_n, &memo) == climb_stairs(naive_n)
+                   && climb_stairs_iterative(naive_n) == climb_stairs(naive_n)
+                   && climb_stairs_matrix(naive_n) == climb_stairs(naive_n)
+               ? "yes"
+               : "NO",
+           CLIMB_STAIRS_MAX,
+           climb_stairs_matrix(CLIMB_STAIRS_MAX));
+    memo_free(&memo);
+
+    // One stack frame per character would need tens of MB here; the loop
+    // needs none
+    size_t length = 50 * 1000 * 1000;
+    char *big = (char *) malloc(length);
+    if (big)
+    {
+        memset(big, 'a', length);
+        big[0] = 'z';
+        start = clock();
+        reverse_iterative(big, length);
+        printf("reverse %zu chars iteratively: %.3f s (last char '%c')\n",
+               length,
+               seconds_since(start),
+               big[length - 1]);
+        free(big);
+    }
+
+    printf("sum_n(1000000000) closed form: %llu\n",
+           sum_n_closed_form(1000000000u));
+}
+
 int main(int argc, char *argv[])
 {
     printf("Sum: 1 + ... + 5: %d\n", sum_n(5));
@@ -105,5 +387,25 @@ int main(int argc, char *argv[])
     free(reversed_str);
 
     printf("\nClimb 10 Stairs: %lu\n", climb_stairs(10));
+
+#if defined(__SIZEOF_INT128__)
+    char digits[40];
+    uint128 big_factorial;
+    for (unsigned int n = 33; n <= 35; n++)
+    {
+        if (factorial_checked(n, &big_factorial))
+        {
+            printf("Factorial of %u (128-bit): %s\n",
+                   n,
+                   uint128_to_string(big_factorial, digits));
+        }
+        else
+        {
+            printf("Factorial of %u: overflows 128 bits\n", n);
+        }
+    }
+#endif
+
+    benchmark_recursion();
     return 0;
 }
@@ -1,5 +1,13 @@
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../array_ops.h"
+#include "../../sort_kernels.h"
+
+SORT_DEFINE_PARALLEL(sort_int, int, SORT_LESS)
 
 int add(int a, int b)
 {
@@ -11,16 +19,180 @@ int sub(int a, int b)
     return a - b;
 }
 
+int mul(int a, int b)
+{
+    return a * b;
+}
+
+// Division that cannot trap: x / 0 and INT_MIN / -1 give 0
+int divide(int a, int b)
+{
+    return b == 0 || (a == INT_MIN && b == -1) ? 0 : a / b;
+}
+
 // Higher-order function that takes a function pointer as an argument
 int operate(int (*operation)(int, int), int a, int b)
 {
     return operation(a, b);
 }
 
-// Callback function for array sorting
+// Callback function for array sorting. (x > y) - (x < y) rather than
+// x - y, which overflows for operands of opposite sign far apart.
 int compare_ints(const void *a, const void *b)
 {
-    return *(int *) a - *(int *) b;
+    int x = *(const int *) a;
+    int y = *(const int *) b;
+    return (x > y) - (x < y);
+}
+
+static double seconds_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// qsort calls compare_ints through a pointer for every comparison; the
+// sort_kernels.h sorts inline the comparison instead. Each sort gets the
+// same random input and its output is checked against qsort's.
+static void sort_benchmark(size_t count)
+{
+    int *input = malloc(count * sizeof(int));
+    int *expected = malloc(count * sizeof(int));
+    int *work = malloc(count * sizeof(int));
+    int *scratch = malloc(count * sizeof(int));
+    if (!input || !expected || !work || !scratch)
+    {
+        printf("Memory allocation failed\n");
+        free(input);
+        free(expected);
+        free(work);
+        free(scratch);
+        return;
+    }
+
+    srand(42);
+    for (size_t i = 0; i < count; i++)
+    {
+        input[i] = rand() - RAND_MAX / 2;
+    }
+
+    printf("\nSorting %zu random ints:\n", count);
+
+    memcpy(expected, input, count * sizeof(int));
+    double start = seconds_now();
+    qsort(expected, count, sizeof(int), compare_ints);
+    double qsort_time = seconds_now() - start;
+    printf("  %-30s %8.2f ms\n", "qsort(compare_ints)", qsort_time * 1e3);
+
+    for (int method = 0; method < 3; method++)
+    {
+        static const char *names[] = {
+            "sort_int (introsort)",
+            "radix_sort_i32",
+            "sort_int_parallel (4 threads)",
+        };
+
+        memcpy(work, input, count * sizeof(int));
+        start = seconds_now();
+        switch (method)
+        {
+        case 0:
+            sort_int(work, count);
+            break;
+        case 1:
+            radix_sort_i32(work, scratch, count);
+            break;
+        case 2:
+            sort_int_parallel(work, count, 2);
+            break;
+        }
+        double elapsed = seconds_now() - start;
+
+        int same = memcmp(work, expected, count * sizeof(int)) == 0;
+        printf("  %-30s %8.2f ms  %.1fx%s\n", names[method], elapsed * 1e3,
+               qsort_time / elapsed, same ? "" : "  MISMATCH");
+    }
+
+    free(input);
+    free(expected);
+    free(work);
+    free(scratch);
+}
+
+// operate() applied element by element makes an indirect call per pair;
+// array_apply() looks the operation up once and runs a SIMD kernel over
+// the whole array. Both get the same inputs and must agree.
+static void operate_benchmark(size_t count)
+{
+    int *a = malloc(count * sizeof(int));
+    int *b = malloc(count * sizeof(int));
+    int *expected = malloc(count * sizeof(int));
+    int *out = malloc(count * sizeof(int));
+    if (!a || !b || !expected || !out)
+    {
+        printf("Memory allocation failed\n");
+        free(a);
+        free(b);
+        free(expected);
+        free(out);
+        return;
+    }
+
+    // Small enough that add, sub and mul through the callbacks never
+    // overflow; every 64th divisor is zero
+    srand(42);
+    for (size_t i = 0; i < count; i++)
+    {
+        a[i] = rand() % 20001 - 10000;
+        b[i] = i % 64 == 0 ? 0 : rand() % 201 - 100;
+    }
+    memset(out, 0, count * sizeof(int));  // Fault the pages in before timing
+
+    static const struct
+    {
+        ArrayOp op;
+        int (*callback)(int, int);
+    } cases[] = {
+        {ARRAY_OP_ADD, add},
+        {ARRAY_OP_SUB, sub},
+        {ARRAY_OP_MUL, mul},
+        {ARRAY_OP_DIV_CHECKED, divide},
+    };
+
+    printf("\nApplying operations to %zu pairs:\n", count);
+    printf("  %-16s %12s %12s %8s\n", "operation", "operate()", "array_apply",
+           "speedup");
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    {
+        // Read through volatile so the compiler cannot inline the
+        // callback, as with one registered at run time
+        int (*volatile callback)(int, int) = cases[c].callback;
+        int (*operation)(int, int) = callback;
+
+        double start = seconds_now();
+        for (size_t i = 0; i < count; i++)
+        {
+            expected[i] = operate(operation, a[i], b[i]);
+        }
+        double each_time = seconds_now() - start;
+
+        start = seconds_now();
+        size_t failed = array_apply(cases[c].op, out, a, b, count);
+        double apply_time = seconds_now() - start;
+
+        int same = memcmp(out, expected, count * sizeof(int)) == 0;
+        printf("  %-16s %9.2f ms %9.2f ms %7.1fx%s", array_op_name(cases[c].op),
+               each_time * 1e3, apply_time * 1e3, each_time / apply_time,
+               same ? "" : "  MISMATCH");
+        if (failed) printf("  (%zu divisions by zero)", failed);
+        printf("\n");
+    }
+
+    free(a);
+    free(b);
+    free(expected);
+    free(out);
 }
 
 // Function to print an array of integers
@@ -60,18 +232,22 @@ int main(int argc, char *argv[])
     const int higher_order = operate(op, 99, 1);
     printf("High order function demo result: %d\n", higher_order);
 
-    // Using qsort with a comparison function pointer
+    // Sorting: qsort takes the comparison as a function pointer
     int numbers[] = {43, 22, 15, 87, 42, 31, 8, 56, 19, 62};
     size_t size = sizeof(numbers) / sizeof(numbers[0]);
 
     printf("\nArray before sorting: ");
     print_array(numbers, size);
 
-    // Standard library qsort using our comparison function
-    qsort(numbers, size, sizeof(int), compare_ints);
+    // sort_array picks sort_int for an int array; the comparison is
+    // compiled into it instead of being called through a pointer
+    sort_array(numbers, size);
 
     printf("Array after sorting: ");
     print_array(numbers, size);
 
+    sort_benchmark(1000000);
+    operate_benchmark(10000000);
+
     return 0;
 }
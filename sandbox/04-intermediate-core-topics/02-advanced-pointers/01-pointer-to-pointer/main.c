@@ -1,6 +1,10 @@
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#define CACHE_LINE 64
 
 void basic_double_pointer_example()
 {
@@ -71,6 +75,122 @@ void free_2d_array(int **matrix, int rows)
     free(matrix);
 }
 
+// Round n up to a multiple of CACHE_LINE
+static size_t round_to_cache_line(size_t n)
+{
+    return (n + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+}
+
+// Allocate a 2D array as ONE cache-line aligned block: the row-pointer
+// index comes first, followed by all rows back to back. The result is
+// still an int ** (so print_2d_array and matrix[i][j] work unchanged), but
+// rows are contiguous instead of scattered across the heap, and the whole
+// thing is released with a single free_2d_array_contiguous().
+//
+// With pad_rows, each row's length is rounded up to a whole number of
+// cache lines so that every row starts on a line boundary.
+int **allocate_2d_array_contiguous(int rows, int cols, bool pad_rows)
+{
+    size_t stride = pad_rows
+                        ? round_to_cache_line(cols * sizeof(int)) / sizeof(int)
+                        : (size_t) cols;
+    size_t index_bytes = round_to_cache_line(rows * sizeof(int *));
+    size_t data_bytes = (size_t) rows * stride * sizeof(int);
+
+    // aligned_alloc wants the size to be a multiple of the alignment
+    char *block = (char *) aligned_alloc(
+        CACHE_LINE, round_to_cache_line(index_bytes + data_bytes));
+    if (block == NULL)
+    {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+
+    int **matrix = (int **) block;
+    int *data = (int *) (block + index_bytes);
+    for (int i = 0; i < rows; i++)
+    {
+        matrix[i] = data + i * stride;
+        // Initialize with the same values as allocate_2d_array
+        for (int j = 0; j < cols; j++)
+        {
+            matrix[i][j] = i * cols + j + 1;
+        }
+    }
+    return matrix;
+}
+
+// The index and the rows share one allocation, so one free releases both
+void free_2d_array_contiguous(int **matrix)
+{
+    free(matrix);
+}
+
+// Sum every element row by row, the traversal both layouts are timed on
+static long long sum_2d_array(int **matrix, int rows, int cols)
+{
+    long long sum = 0;
+    for (int i = 0; i < rows; i++)
+    {
+        for (int j = 0; j < cols; j++)
+        {
+            sum += matrix[i][j];
+        }
+    }
+    return sum;
+}
+
+// Compare allocating, traversing and freeing a large grid with per-row
+// mallocs against the single contiguous block
+void benchmark_2d_allocators()
+{
+    printf("\n--- 2D Allocator Benchmark ---\n");
+
+    const int ROWS = 4000;
+    const int COLS = 1000;
+    const int PASSES = 10;
+    const char *names[] = {"row-pointer (rows + 1 mallocs)",
+                           "contiguous",
+                           "contiguous, padded rows"};
+
+    for (int kind = 0; kind < 3; kind++)
+    {
+        long long sum = 0;
+
+        clock_t start = clock();
+        int **matrix = kind == 0 ? allocate_2d_array(ROWS, COLS)
+                                 : allocate_2d_array_contiguous(
+                                       ROWS, COLS, kind == 2);
+        clock_t allocated = clock();
+        if (matrix == NULL) return;
+
+        for (int pass = 0; pass < PASSES; pass++)
+        {
+            sum += sum_2d_array(matrix, ROWS, COLS);
+        }
+        clock_t traversed = clock();
+
+        if (kind == 0)
+        {
+            free_2d_array(matrix, ROWS);
+        }
+        else
+        {
+            free_2d_array_contiguous(matrix);
+        }
+        clock_t freed = clock();
+
+        printf("%-31s alloc+init %6.2f ms, %d traversals %6.2f ms, "
+               "free %5.2f ms (sum %lld)\n",
+               names[kind],
+               (allocated - start) * 1000.0 / CLOCKS_PER_SEC,
+               PASSES,
+               (traversed - allocated) * 1000.0 / CLOCKS_PER_SEC,
+               (freed - traversed) * 1000.0 / CLOCKS_PER_SEC,
+               sum);
+    }
+}
+
 // Function to print a 2D array
 void print_2d_array(int **matrix, int rows, int cols)
 {
@@ -148,6 +268,20 @@ int main(int argc, char *argv[])
         free_2d_array(matrix, rows);
     }
 
+    // Same array as one contiguous block; print_2d_array is unchanged
+    matrix = allocate_2d_array_contiguous(rows, cols, true);
+    if (matrix != NULL)
+    {
+        printf("Contiguous 2D Array (%dx%d, rows padded to %d bytes):\n",
+               rows,
+               cols,
+               CACHE_LINE);
+        print_2d_array(matrix, rows, cols);
+        free_2d_array_contiguous(matrix);
+    }
+
+    benchmark_2d_allocators();
+
     // Array of strings example
     array_of_strings_example();
 
@@ -1,27 +1,55 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Generic swap function that can swap any type of data
+#include "../../sort_kernels.h"
+
+// Swap one fixed-size chunk through a register-sized temporary. memcpy
+// with a constant size compiles to a plain load and store, and unlike a
+// pointer cast it is valid whatever the alignment and type of the data.
+#define SWAP_CHUNK(a, b, type)          \
+    do                                  \
+    {                                   \
+        type ta, tb;                    \
+        memcpy(&ta, (a), sizeof(type)); \
+        memcpy(&tb, (b), sizeof(type)); \
+        memcpy((a), &tb, sizeof(type)); \
+        memcpy((b), &ta, sizeof(type)); \
+    } while (0)
+
+// Generic swap function that can swap any type of data. The common sizes
+// are one load and one store per side; anything else is swapped 8 bytes
+// at a time, so no temporary buffer is needed at all.
 void swap_generic(void *a, void *b, size_t size)
 {
-    // Allocate temporary buffer to hold the data
-    void *temp = malloc(size);
-    if (temp == NULL)
+    unsigned char *pa = (unsigned char *) a;
+    unsigned char *pb = (unsigned char *) b;
+
+    switch (size)
     {
-        printf("Memory allocation failed\n");
+    case 1:
+        SWAP_CHUNK(pa, pb, uint8_t);
+        return;
+    case 2:
+        SWAP_CHUNK(pa, pb, uint16_t);
+        return;
+    case 4:
+        SWAP_CHUNK(pa, pb, uint32_t);
+        return;
+    case 8:
+        SWAP_CHUNK(pa, pb, uint64_t);
         return;
     }
 
-    // Copy a to temp
-    memcpy(temp, a, size);
-    // Copy b to a
-    memcpy(a, b, size);
-    // Copy temp to b
-    memcpy(b, temp, size);
-
-    // Free temp buffer
-    free(temp);
+    for (; size >= 8; size -= 8, pa += 8, pb += 8)
+    {
+        SWAP_CHUNK(pa, pb, uint64_t);
+    }
+    for (; size > 0; size--, pa++, pb++)
+    {
+        SWAP_CHUNK(pa, pb, uint8_t);
+    }
 }
 
 // Function to print different data types
@@ -46,12 +74,6 @@ void print_value(void *ptr, char type)
     }
 }
 
-// Generic comparison function for qsort
-int compare_ints(const void *a, const void *b)
-{
-    return (*(int *) a - *(int *) b);
-}
-
 // Generic array printing function
 void print_array(const void *array,
                  size_t element_size,
@@ -114,8 +136,25 @@ int main()
     swap_generic(&x, &y, sizeof(float));
     printf("After swap: x = %f, y = %f\n", x, y);
 
-    // 3. Using qsort with void pointers for comparison
-    printf("\n--- qsort with Void Pointers ---\n");
+    double p = 1.5, q = -0.25;
+    printf("Before swap: p = %lf, q = %lf\n", p, q);
+    swap_generic(&p, &q, sizeof(double));
+    printf("After swap: p = %lf, q = %lf\n", p, q);
+
+    struct
+    {
+        char label[12];
+        int id;
+    } first = {"first", 1}, second = {"second", 2};
+    swap_generic(&first, &second, sizeof(first));  // 16 bytes: two 8-byte chunks
+    printf("After struct swap: first = {%s, %d}, second = {%s, %d}\n",
+           first.label, first.id, second.label, second.id);
+
+    // 3. Sorting
+    // qsort sorts anything through void pointers, but that means calling a
+    // comparison function for every pair it looks at. sort_array and the
+    // radix sorts from sort_kernels.h are compiled for the element type.
+    printf("\n--- Sorting ---\n");
 
     int numbers[] = {42, 13, 7, 87, 42, 16};
     int nums_size = sizeof(numbers) / sizeof(numbers[0]);
@@ -123,12 +162,23 @@ int main()
     printf("Before sorting: ");
     print_array(numbers, sizeof(int), nums_size, 'i');
 
-    // qsort uses void pointers for generic sorting
-    qsort(numbers, nums_size, sizeof(int), compare_ints);
+    sort_array(numbers, nums_size);
 
     printf("After sorting: ");
     print_array(numbers, sizeof(int), nums_size, 'i');
 
+    float readings[] = {3.5f, -1.25f, 0.0f, 12.0f, -7.5f, 2.0f};
+    float scratch[sizeof(readings) / sizeof(readings[0])];
+    size_t readings_size = sizeof(readings) / sizeof(readings[0]);
+
+    printf("Before radix sort: ");
+    print_array(readings, sizeof(float), readings_size, 'f');
+
+    radix_sort_float(readings, scratch, readings_size);
+
+    printf("After radix sort: ");
+    print_array(readings, sizeof(float), readings_size, 'f');
+
     // 4. Generic function for printing arrays
     printf("\n--- Generic Array Printing ---\n");
 
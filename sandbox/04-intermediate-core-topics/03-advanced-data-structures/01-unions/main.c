@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "../../bit_cast.h"
+
 // Basic union example
 union Data
 {
@@ -137,7 +139,38 @@ int main()
     {
         printf("%02X ", conv.bytes[i]);
     }
-    printf("\n\n");
+    printf("\n");
+
+    // The same bits without a union: float_bits() is a memcpy that compiles
+    // to one register move, and unlike *(int *) &f it is defined behaviour
+    float pi = 3.14159f;
+    printf("float_bits(%f): 0x%08X (union: 0x%08X)\n", pi, float_bits(pi),
+           (unsigned) conv.i);
+
+    // Classification and sign changes straight on the bits
+    float samples[] = {-0.0f, 1e-40f, pi, -float_from_bits(FLOAT_EXPONENT_MASK),
+                       float_from_bits(0x7FC00000u)};
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+    {
+        float x = samples[i];
+        printf("%-12g sign %d  %s  |x| = %g, sortable key 0x%08X\n", x,
+               float_sign_bit(x),
+               float_is_nan(x)         ? "nan      "
+               : float_is_inf(x)       ? "infinite "
+               : float_is_zero(x)      ? "zero     "
+               : float_is_subnormal(x) ? "subnormal"
+                                       : "normal   ",
+               float_abs(x), float_sortable_key(x));
+    }
+
+    // 0.1f added ten times is not exactly 1.0f, but it is one float away
+    float total = 0.0f;
+    for (int i = 0; i < 10; i++)
+    {
+        total += 0.1f;
+    }
+    printf("0.1f * 10 = %.9f: %u ulp(s) from 1.0f\n\n", total,
+           float_ulp_distance(total, 1.0f));
 
     // 4. Memory Conservation Example
     printf("--- Memory Conservation Example ---\n");
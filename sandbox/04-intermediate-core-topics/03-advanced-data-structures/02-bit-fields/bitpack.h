@@ -0,0 +1,152 @@
+// Schema-driven bit packing: portable replacements for bit-fields.
+//
+// C leaves the order, alignment and container size of bit-fields to the
+// compiler, so a struct of bit-fields cannot be written to disk and read
+// back by another compiler or CPU, and every access is a read-modify-write
+// of a word the compiler picks. Here a record is a plain uint32_t and the
+// layout is a schema listing each field as (name, shift, width):
+//
+//     #define DATE_FIELDS(X, p) X(p, day, 0, 5) X(p, month, 5, 4) ...
+//     BITPACK_DEFINE(date, DATE_FIELDS)
+//
+// where each entry is X(p, name, shift, width); the full date schema is in
+// main.c.
+//
+// BITPACK_DEFINE checks the schema at compile time and generates:
+//
+//   date_day(word)                  read a field (shift and mask)
+//   date_with_day(word, value)      word with one field replaced
+//   date_columns                    one uint32_t array per field
+//   date_pack_array / _unpack_array columns <-> words
+//   date_write_wire / _read_wire    words <-> little-endian bytes
+//   date_WIRE_BYTES                 bytes per record on the wire
+//
+// The array loops handle one record per iteration with no branches, so
+// the compiler vectorizes them (SSE2/AVX2/NEON) without intrinsics at -O3
+// or -O2 -fvect-cost-model=cheap; GCC's default -O2 model skips loops
+// whose trip count it cannot see. The
+// wire format stores only the bytes the schema needs, lowest byte first,
+// so it is identical on every compiler and byte order.
+#ifndef BITPACK_H
+#define BITPACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BITPACK_MASK(width) \
+    ((uint32_t) ((width) >= 32 ? 0xFFFFFFFFu : (1u << (width)) - 1u))
+
+// Each field must fit in the word
+#define BITPACK_CHECK(p, name, shift, width)                       \
+    _Static_assert((width) > 0 && (shift) + (width) <= 32,         \
+                   #p "." #name " does not fit in 32 bits");
+
+// Bits claimed by the field; the sum and the OR must agree, otherwise two
+// fields overlap
+#define BITPACK_WIDTH(p, name, shift, width) +(width)
+#define BITPACK_BITS(p, name, shift, width) | (BITPACK_MASK(width) << (shift))
+
+#define BITPACK_ACCESSORS(p, name, shift, width)                            \
+    static inline uint32_t p##_##name(uint32_t word)                        \
+    {                                                                       \
+        return (word >> (shift)) & BITPACK_MASK(width);                     \
+    }                                                                       \
+    static inline uint32_t p##_with_##name(uint32_t word, uint32_t value)  \
+    {                                                                       \
+        return (word & ~(BITPACK_MASK(width) << (shift)))                   \
+               | ((value & BITPACK_MASK(width)) << (shift));                \
+    }
+
+#define BITPACK_COLUMN(p, name, shift, width) uint32_t *name;
+
+// Column pointers are copied to locals so the compiler knows stores to
+// the columns cannot change them, which lets it vectorize the loops
+#define BITPACK_LOCAL(p, name, shift, width) \
+    uint32_t *restrict const name = columns->name;
+
+#define BITPACK_PACK_FIELD(p, name, shift, width) \
+    word |= (name[i] & BITPACK_MASK(width)) << (shift);
+
+#define BITPACK_UNPACK_FIELD(p, name, shift, width) \
+    name[i] = (words[i] >> (shift)) & BITPACK_MASK(width);
+
+// The columns and the word array never overlap; saying so spares the
+// vectorizer a runtime overlap check, which -O2 is not willing to emit
+#if defined(__GNUC__) && !defined(__clang__)
+#define BITPACK_IVDEP _Pragma("GCC ivdep")
+#else
+#define BITPACK_IVDEP
+#endif
+
+#define BITPACK_DEFINE(p, FIELDS)                                            \
+    FIELDS(BITPACK_CHECK, p)                                                 \
+    _Static_assert((0 FIELDS(BITPACK_WIDTH, p))                              \
+                       == __builtin_popcount(0u FIELDS(BITPACK_BITS, p)),    \
+                   #p " has overlapping fields");                            \
+    FIELDS(BITPACK_ACCESSORS, p)                                             \
+                                                                             \
+    enum                                                                     \
+    {                                                                        \
+        p##_BITS = 32 - __builtin_clz(0u FIELDS(BITPACK_BITS, p)),           \
+        p##_WIRE_BYTES = (p##_BITS + 7) / 8                                  \
+    };                                                                       \
+                                                                             \
+    typedef struct                                                           \
+    {                                                                        \
+        FIELDS(BITPACK_COLUMN, p)                                            \
+    } p##_columns;                                                           \
+                                                                             \
+    static inline void p##_pack_array(uint32_t *restrict words,              \
+                                      const p##_columns *columns,            \
+                                      size_t count)                          \
+    {                                                                        \
+        FIELDS(BITPACK_LOCAL, p)                                             \
+        BITPACK_IVDEP                                                        \
+        for (size_t i = 0; i < count; i++)                                   \
+        {                                                                    \
+            uint32_t word = 0;                                               \
+            FIELDS(BITPACK_PACK_FIELD, p)                                    \
+            words[i] = word;                                                 \
+        }                                                                    \
+    }                                                                        \
+                                                                             \
+    static inline void p##_unpack_array(const uint32_t *restrict words,      \
+                                        const p##_columns *columns,          \
+                                        size_t count)                        \
+    {                                                                        \
+        FIELDS(BITPACK_LOCAL, p)                                             \
+        BITPACK_IVDEP                                                        \
+        for (size_t i = 0; i < count; i++)                                   \
+        {                                                                    \
+            FIELDS(BITPACK_UNPACK_FIELD, p)                                  \
+        }                                                                    \
+    }                                                                        \
+                                                                             \
+    static inline size_t p##_write_wire(                                     \
+        uint8_t *restrict out, const uint32_t *restrict words, size_t count) \
+    {                                                                        \
+        for (size_t i = 0; i < count; i++)                                   \
+        {                                                                    \
+            for (int b = 0; b < p##_WIRE_BYTES; b++)                         \
+            {                                                                \
+                out[i * p##_WIRE_BYTES + b] = (uint8_t) (words[i] >> (8 * b)); \
+            }                                                                \
+        }                                                                    \
+        return count * p##_WIRE_BYTES;                                       \
+    }                                                                        \
+                                                                             \
+    static inline void p##_read_wire(                                        \
+        uint32_t *restrict words, const uint8_t *restrict in, size_t count)  \
+    {                                                                        \
+        for (size_t i = 0; i < count; i++)                                   \
+        {                                                                    \
+            uint32_t word = 0;                                               \
+            for (int b = 0; b < p##_WIRE_BYTES; b++)                         \
+            {                                                                \
+                word |= (uint32_t) in[i * p##_WIRE_BYTES + b] << (8 * b);    \
+            }                                                                \
+            words[i] = word;                                                 \
+        }                                                                    \
+    }
+
+#endif  // BITPACK_H
@@ -1,4 +1,9 @@
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bitpack.h"
 
 // Basic bit field example
 struct PackedDate
@@ -53,6 +58,124 @@ struct AlignmentTest
     unsigned int flag2 : 1;
 };
 
+// The same records as portable packed words. Unlike the bit-fields above
+// the layout is fixed by the schema, not by the compiler.
+#define DATE_FIELDS(X, p) X(p, day, 0, 5) X(p, month, 5, 4) X(p, year, 9, 12)
+BITPACK_DEFINE(date, DATE_FIELDS)
+
+#define PERM_FIELDS(X, p)                                             \
+    X(p, read, 0, 1)                                                  \
+    X(p, write, 1, 1) X(p, execute, 2, 1) X(p, system, 3, 1) X(p, hidden, 4, 1)
+BITPACK_DEFINE(perm, PERM_FIELDS)
+
+#define CTRL_FIELDS(X, p)                          \
+    X(p, enable, 0, 1)                             \
+    X(p, direction, 1, 1) X(p, mode, 2, 2) X(p, interrupt, 4, 1)
+BITPACK_DEFINE(ctrl, CTRL_FIELDS)
+
+#define DATE_COUNT (1 << 20)
+
+static double seconds_since(clock_t start)
+{
+    return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+// Pack a million dates both ways and check the codec round-trips
+void bitpack_demo(void)
+{
+    printf("\n--- Schema-Driven Bit Packing ---\n");
+
+    uint32_t today = 0;
+    today = date_with_day(today, 15);
+    today = date_with_month(today, 6);
+    today = date_with_year(today, 2023);
+    printf("Packed date 0x%06X -> %u/%u/%u, %d bytes on the wire\n",
+           today,
+           date_month(today),
+           date_day(today),
+           date_year(today),
+           date_WIRE_BYTES);
+
+    uint32_t perms = perm_with_write(perm_with_read(0, 1), 1);
+    uint32_t reg = ctrl_with_enable(0, 1);
+    reg = ctrl_with_direction(reg, 1);
+    reg = ctrl_with_mode(reg, 2);
+    printf("Permissions 0x%02X (execute %u), control register 0x%02X "
+           "(mode %u), %d byte each\n",
+           perms,
+           perm_execute(perms),
+           reg,
+           ctrl_mode(reg),
+           perm_WIRE_BYTES);
+
+    // Bulk conversion: columns -> words -> wire bytes and back
+    uint32_t *day = malloc(DATE_COUNT * sizeof(uint32_t));
+    uint32_t *month = malloc(DATE_COUNT * sizeof(uint32_t));
+    uint32_t *year = malloc(DATE_COUNT * sizeof(uint32_t));
+    uint32_t *words = malloc(DATE_COUNT * sizeof(uint32_t));
+    uint8_t *wire = malloc(DATE_COUNT * date_WIRE_BYTES);
+    if (!day || !month || !year || !words || !wire)
+    {
+        printf("Allocation failed\n");
+        free(day), free(month), free(year), free(words), free(wire);
+        return;
+    }
+
+    srand(42);
+    for (size_t i = 0; i < DATE_COUNT; i++)
+    {
+        day[i] = 1 + rand() % 31;
+        month[i] = 1 + rand() % 12;
+        year[i] = 1900 + rand() % 200;
+    }
+
+    date_columns columns = {day, month, year};
+    clock_t start = clock();
+    for (int round = 0; round < 20; round++)
+    {
+        date_pack_array(words, &columns, DATE_COUNT);
+    }
+    double packed = seconds_since(start);
+
+    size_t bytes = date_write_wire(wire, words, DATE_COUNT);
+    for (size_t i = 0; i < DATE_COUNT; i++) words[i] = 0;
+    date_read_wire(words, wire, DATE_COUNT);
+
+    uint32_t *check_day = malloc(DATE_COUNT * sizeof(uint32_t));
+    uint32_t *check_month = malloc(DATE_COUNT * sizeof(uint32_t));
+    uint32_t *check_year = malloc(DATE_COUNT * sizeof(uint32_t));
+    size_t mismatches = 0;
+    double unpacked = 0;
+    if (check_day && check_month && check_year)
+    {
+        date_columns check = {check_day, check_month, check_year};
+        start = clock();
+        for (int round = 0; round < 20; round++)
+        {
+            date_unpack_array(words, &check, DATE_COUNT);
+        }
+        unpacked = seconds_since(start);
+        for (size_t i = 0; i < DATE_COUNT; i++)
+        {
+            mismatches += check_day[i] != day[i] || check_month[i] != month[i]
+                          || check_year[i] != year[i];
+        }
+    }
+
+    printf("%d dates: pack %.2f ns, unpack %.2f ns per date\n",
+           DATE_COUNT,
+           packed * 1e9 / (20.0 * DATE_COUNT),
+           unpacked * 1e9 / (20.0 * DATE_COUNT));
+    printf("Wire size: %zu bytes (%d per date, struct PackedDate is %zu)\n",
+           bytes,
+           date_WIRE_BYTES,
+           sizeof(struct PackedDate));
+    printf("Round trip mismatches: %zu\n", mismatches);
+
+    free(check_day), free(check_month), free(check_year);
+    free(day), free(month), free(year), free(words), free(wire);
+}
+
 int main()
 {
     // 1. Basic bit field example
@@ -136,5 +259,8 @@ int main()
     struct AlignmentTest at;
     printf("Size of AlignmentTest: %zu bytes\n", sizeof(struct AlignmentTest));
 
+    // 7. Portable alternative
+    bitpack_demo();
+
     return 0;
 }
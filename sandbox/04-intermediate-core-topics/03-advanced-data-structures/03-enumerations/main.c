@@ -1,4 +1,8 @@
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 // Basic enumeration
 enum Days
@@ -50,7 +54,8 @@ enum State
     STATE_RUNNING,
     STATE_PAUSED,
     STATE_STOPPED,
-    STATE_ERROR
+    STATE_ERROR,
+    STATE_COUNT  // Not a state: the number of states, for sizing tables
 };
 
 // Forward state transitions
@@ -61,27 +66,23 @@ enum StateTransition
     TRANSITION_PAUSE,
     TRANSITION_RESUME,
     TRANSITION_RESET,
-    TRANSITION_ERROR
+    TRANSITION_ERROR,
+    TRANSITION_COUNT
 };
 
-// Function to convert state enums to strings
+static const char *const state_names[STATE_COUNT] = {
+    [STATE_IDLE] = "Idle",
+    [STATE_RUNNING] = "Running",
+    [STATE_PAUSED] = "Paused",
+    [STATE_STOPPED] = "Stopped",
+    [STATE_ERROR] = "Error",
+};
+
+// Function to convert state enums to strings: a lookup in the constant
+// table above (in .rodata, no code per case) instead of a switch
 const char* state_to_string(enum State state)
 {
-    switch (state)
-    {
-    case STATE_IDLE:
-        return "Idle";
-    case STATE_RUNNING:
-        return "Running";
-    case STATE_PAUSED:
-        return "Paused";
-    case STATE_STOPPED:
-        return "Stopped";
-    case STATE_ERROR:
-        return "Error";
-    default:
-        return "Unknown";
-    }
+    return (unsigned) state < STATE_COUNT ? state_names[state] : "Unknown";
 }
 
 // Function to handle state transitions
@@ -110,6 +111,7 @@ enum State transition_state(enum State current_state,
         break;
     case STATE_ERROR:
         if (transition == TRANSITION_RESET) return STATE_IDLE;
+        break;    default:
         break;
     }
 
@@ -117,6 +119,287 @@ enum State transition_state(enum State current_state,
     return current_state;
 }
 
+// The same machine as data: next_state[current][transition]. Every cell is
+// filled in, so "no valid transition" is an explicit self-loop rather than a
+// branch, and the whole table is 30 bytes that stay in L1.
+static const unsigned char state_table[STATE_COUNT][TRANSITION_COUNT] = {
+    //                START          STOP           PAUSE          RESUME         RESET       ERROR
+    [STATE_IDLE]    = {STATE_RUNNING, STATE_IDLE,    STATE_IDLE,    STATE_IDLE,    STATE_IDLE, STATE_ERROR},
+    [STATE_RUNNING] = {STATE_RUNNING, STATE_STOPPED, STATE_PAUSED,  STATE_RUNNING, STATE_RUNNING, STATE_ERROR},
+    [STATE_PAUSED]  = {STATE_PAUSED,  STATE_STOPPED, STATE_PAUSED,  STATE_RUNNING, STATE_PAUSED, STATE_ERROR},
+    [STATE_STOPPED] = {STATE_STOPPED, STATE_STOPPED, STATE_STOPPED, STATE_STOPPED, STATE_IDLE, STATE_ERROR},
+    [STATE_ERROR]   = {STATE_ERROR,   STATE_ERROR,   STATE_ERROR,   STATE_ERROR,   STATE_IDLE, STATE_ERROR},
+};
+
+static const char *const transition_names[TRANSITION_COUNT] = {
+    [TRANSITION_START] = "START",
+    [TRANSITION_STOP] = "STOP",
+    [TRANSITION_PAUSE] = "PAUSE",
+    [TRANSITION_RESUME] = "RESUME",
+    [TRANSITION_RESET] = "RESET",
+    [TRANSITION_ERROR] = "ERROR",
+};
+
+/**
+ * A generic table-driven state machine: any enum-based machine with up to
+ * 256 states can be described by its flattened table and names.
+ */
+typedef struct
+{
+    const unsigned char *table;  // [state * event_count + event] -> next state
+    const char *const *state_names;
+    const char *const *event_names;
+    int state_count;
+    int event_count;
+} FsmDefinition;
+
+static const FsmDefinition state_machine = {
+    .table = &state_table[0][0],
+    .state_names = state_names,
+    .event_names = transition_names,
+    .state_count = STATE_COUNT,
+    .event_count = TRANSITION_COUNT,
+};
+
+// One step with the same contract as transition_state: out-of-range input
+// leaves the state unchanged
+int fsm_step(const FsmDefinition *fsm, int state, int event)
+{
+    if (state < 0 || state >= fsm->state_count) return state;
+    if (event < 0 || event >= fsm->event_count) return state;
+    return fsm->table[state * fsm->event_count + event];
+}
+
+const char *fsm_state_name(const FsmDefinition *fsm, int state)
+{
+    if (state < 0 || state >= fsm->state_count) return "Unknown";
+    return fsm->state_names[state];
+}
+
+/**
+ * Many instances of one machine, stored as a struct of arrays: the current
+ * state of every machine is one byte in `states`. When profiling is on,
+ * transition_counts[state * event_count + event] counts every step taken
+ * from `state` on `event` (self-loops included).
+ */
+typedef struct
+{
+    const FsmDefinition *fsm;
+    unsigned char *states;
+    size_t count;
+    unsigned long long *transition_counts;  // NULL when not profiling
+} FsmBank;
+
+bool fsm_bank_init(FsmBank *bank,
+                   const FsmDefinition *fsm,
+                   size_t count,
+                   int initial_state,
+                   bool profile)
+{
+    size_t cells = (size_t) fsm->state_count * fsm->event_count;
+
+    bank->fsm = fsm;
+    bank->count = count;
+    bank->states = (unsigned char *) malloc(count ? count : 1);
+    bank->transition_counts =
+        profile ? (unsigned long long *) calloc(cells, sizeof(unsigned long long))
+                : NULL;
+    if (!bank->states || (profile && !bank->transition_counts))
+    {
+        free(bank->states);
+        free(bank->transition_counts);
+        return false;
+    }
+    memset(bank->states, initial_state, count);
+    return true;
+}
+
+void fsm_bank_free(FsmBank *bank)
+{
+    free(bank->states);
+    free(bank->transition_counts);
+    bank->states = NULL;
+    bank->transition_counts = NULL;
+}
+
+/**
+ * Feeds `steps` rounds of events to every machine. events[step * count + m]
+ * is the event for machine m in round `step`, and every event must be below
+ * event_count (map raw input to event classes first).
+ *
+ * Rounds are processed machine by machine rather than running each machine
+ * through its whole stream: consecutive table lookups then belong to
+ * independent machines and overlap in the pipeline, instead of each one
+ * waiting on the load before it. There is no data-dependent branch at all,
+ * so nothing is left to mispredict.
+ */
+void fsm_bank_run(FsmBank *bank, const unsigned char *events, size_t steps)
+{
+    const unsigned char *table = bank->fsm->table;
+    const size_t stride = (size_t) bank->fsm->event_count;
+    unsigned char *states = bank->states;
+    unsigned long long *counts = bank->transition_counts;
+    const size_t count = bank->count;
+
+    for (size_t step = 0; step < steps; step++)
+    {
+        const unsigned char *round = events + step * count;
+
+        // The profiling test is hoisted out of the per-machine loop
+        if (counts)
+        {
+            for (size_t m = 0; m < count; m++)
+            {
+                size_t cell = states[m] * stride + round[m];
+                counts[cell]++;
+                states[m] = table[cell];
+            }
+        }
+        else
+        {
+            for (size_t m = 0; m < count; m++)
+            {
+                states[m] = table[states[m] * stride + round[m]];
+            }
+        }
+    }
+}
+
+void fsm_bank_print_profile(const FsmBank *bank, int limit)
+{
+    const FsmDefinition *fsm = bank->fsm;
+    int cells = fsm->state_count * fsm->event_count;
+    unsigned long long total = 0;
+    bool *shown = (bool *) calloc(cells, sizeof(bool));
+
+    if (!bank->transition_counts || !shown)
+    {
+        free(shown);
+        return;
+    }
+    for (int c = 0; c < cells; c++) total += bank->transition_counts[c];
+
+    // Only a handful of rows are printed, so repeated max-finding will do
+    for (int printed = 0; printed < limit && printed < cells; printed++)
+    {
+        int best = -1;
+        for (int c = 0; c < cells; c++)
+        {
+            if (!shown[c]
+                && (best < 0
+                    || bank->transition_counts[c]
+                           > bank->transition_counts[best]))
+            {
+                best = c;
+            }
+        }
+        shown[best] = true;
+
+        int from = best / fsm->event_count;
+        int event = best % fsm->event_count;
+        printf("  %-8s --%-6s--> %-8s %12llu (%.1f%%)\n",
+               fsm->state_names[from],
+               fsm->event_names[event],
+               fsm->state_names[fsm->table[best]],
+               bank->transition_counts[best],
+               total ? 100.0 * bank->transition_counts[best] / total : 0.0);
+    }
+    free(shown);
+}
+
+double seconds_since(clock_t start)
+{
+    return ((double) (clock() - start)) / CLOCKS_PER_SEC;
+}
+
+void benchmark_state_machines(size_t machines, size_t steps)
+{
+    printf("\n--- Benchmark: switch vs table, %zu machines x %zu steps ---\n",
+           machines,
+           steps);
+
+    unsigned char *events = (unsigned char *) malloc(machines * steps);
+    unsigned char *switch_states = (unsigned char *) malloc(machines);
+    FsmBank bank, profiled;
+
+    if (!events || !switch_states)
+    {
+        free(events);
+        free(switch_states);
+        return;
+    }
+    if (!fsm_bank_init(&bank, &state_machine, machines, STATE_IDLE, false))
+    {
+        free(events);
+        free(switch_states);
+        return;
+    }
+    if (!fsm_bank_init(&profiled, &state_machine, machines, STATE_IDLE, true))
+    {
+        fsm_bank_free(&bank);
+        free(events);
+        free(switch_states);
+        return;
+    }
+
+    // Random events: the worst case for a predictor, and what a busy mix of
+    // connections looks like from the parser's point of view
+    unsigned int seed = 12345u;
+    for (size_t i = 0; i < machines * steps; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        events[i] = (unsigned char) ((seed >> 16) % TRANSITION_COUNT);
+    }
+    memset(switch_states, STATE_IDLE, machines);
+
+    clock_t start = clock();
+    for (size_t step = 0; step < steps; step++)
+    {
+        const unsigned char *round = events + step * machines;
+        for (size_t m = 0; m < machines; m++)
+        {
+            switch_states[m] = (unsigned char) transition_state(
+                (enum State) switch_states[m],
+                (enum StateTransition) round[m]);
+        }
+    }
+    double switch_time = seconds_since(start);
+
+    start = clock();
+    fsm_bank_run(&bank, events, steps);
+    double table_time = seconds_since(start);
+
+    start = clock();
+    fsm_bank_run(&profiled, events, steps);
+    double profiled_time = seconds_since(start);
+
+    double total = (double) machines * steps;
+    printf("switch:             %.3f s (%6.1f M steps/s)\n",
+           switch_time,
+           total / switch_time / 1e6);
+    printf("table:              %.3f s (%6.1f M steps/s, %.1fx)\n",
+           table_time,
+           total / table_time / 1e6,
+           switch_time / table_time);
+    printf("table + profiling:  %.3f s (%6.1f M steps/s, %.1fx)\n",
+           profiled_time,
+           total / profiled_time / 1e6,
+           switch_time / profiled_time);
+    printf("Final states agree: %s\n",
+           memcmp(switch_states, bank.states, machines) == 0
+                   && memcmp(switch_states, profiled.states, machines) == 0
+               ? "yes"
+               : "NO");
+
+    printf("Hottest transitions:\n");
+    fsm_bank_print_profile(&profiled, 5);
+
+    fsm_bank_free(&bank);
+    fsm_bank_free(&profiled);
+    free(events);
+    free(switch_states);
+}
+
 int main()
 {
     // 1. Basic Enumeration Example
@@ -212,6 +495,39 @@ int main()
     current = transition_state(current, TRANSITION_RESET);
     printf("After RESET: %s\n", state_to_string(current));
 
+    // 6. The same transitions through the table-driven engine
+    printf("\n--- Table-Driven State Machine ---\n");
+
+    bool table_matches = true;
+    for (int state = 0; state < STATE_COUNT; state++)
+    {
+        for (int event = 0; event < TRANSITION_COUNT; event++)
+        {
+            if (fsm_step(&state_machine, state, event)
+                != (int) transition_state((enum State) state,
+                                          (enum StateTransition) event))
+            {
+                table_matches = false;
+            }
+        }
+    }
+    printf("Table matches transition_state for all %d pairs: %s\n",
+           STATE_COUNT * TRANSITION_COUNT,
+           table_matches ? "yes" : "NO");
+
+    int fsm_current = STATE_IDLE;
+    const int script[] = {
+        TRANSITION_START, TRANSITION_PAUSE, TRANSITION_STOP, TRANSITION_RESET};
+    for (size_t i = 0; i < sizeof(script) / sizeof(script[0]); i++)
+    {
+        fsm_current = fsm_step(&state_machine, fsm_current, script[i]);
+        printf("After %s: %s\n",
+               transition_names[script[i]],
+               fsm_state_name(&state_machine, fsm_current));
+    }
+
+    benchmark_state_machines(4096, 4096);
+
     // Enum size
     printf("\nSize of enum Days: %zu bytes\n", sizeof(enum Days));
     printf("Size of enum Colors: %zu bytes\n", sizeof(enum Colors));
@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../../array_ops.h"
+
 // 1. Basic typedef for primitive types
 typedef int Integer;
 typedef unsigned int UInteger;
@@ -240,6 +242,37 @@ int main()
                y,
                operations[i](x, y));
     }
+    printf("\n");
+
+    // 9. Whole arrays: a table of kernels indexed by an enum typedef
+    printf("--- Array Operations ---\n");
+
+    int left[8] = {10, 20, 30, 40, 50, 60, 70, INT_MIN};
+    int right[8] = {2, 4, 0, 8, 10, 0, 14, -1};
+    int results[8];
+
+    // One lookup in array_kernels for all eight pairs
+    for (ArrayOp op = ARRAY_OP_ADD; op < ARRAY_OP_COUNT; op++)
+    {
+        size_t failed = array_apply(op, results, left, right, 8);
+        printf("%-17s", array_op_name(op));
+        for (int i = 0; i < 8; i++)
+        {
+            printf(" %d", results[i]);
+        }
+        if (failed) printf("  (%zu failed)", failed);
+        printf("\n");
+    }
+
+    // Any MathOperation still works, at one indirect call per element
+    MathOperation fallback = operations[3];
+    array_apply_each(fallback, results, left, right, 4);
+    printf("%-17s", "divide (each)");
+    for (int i = 0; i < 4; i++)
+    {
+        printf(" %d", results[i]);
+    }
+    printf("\n");
 
     return 0;
 }
@@ -1,7 +1,10 @@
 #include <stdalign.h>  // C11 standard
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
+#include "struct_layout.h"
+
 // Basic structure with potential padding
 struct BasicStruct
 {
@@ -58,6 +61,49 @@ struct __attribute__((aligned(16))) AlignedStruct
     double c;
 };
 
+// Connection record: the lookup loop only reads id, state and
+// last_seen, the rest is for reporting
+struct Connection
+{
+    uint32_t id;
+    char peer[40];
+    uint8_t state;
+    double created;
+    char user_agent[64];
+    uint64_t last_seen;
+    uint64_t bytes_sent;
+};
+
+// Same fields with the hot ones together at the front
+struct ConnectionHotFirst
+{
+    uint64_t last_seen;
+    uint32_t id;
+    uint8_t state;
+    uint64_t bytes_sent;
+    double created;
+    char peer[40];
+    char user_agent[64];
+};
+
+// Per-thread counters packed together: every increment invalidates the
+// other threads' copy of the line
+struct WorkerCounters
+{
+    uint64_t processed[4];  // processed[i] is written by thread i
+    uint64_t limit;         // Set before the threads start
+};
+
+// One line per writer
+struct PaddedWorkerCounters
+{
+    struct
+    {
+        alignas(64) uint64_t value;
+    } processed[4];
+    alignas(64) uint64_t limit;
+};
+
 // Function to print address and offset information
 void print_member_info(const char *struct_name,
                        const char *member_name,
@@ -183,6 +229,84 @@ void demonstrate_array_alignment(void)
     }
 }
 
+// Run the layout analyzer over the structs above
+void analyze_layouts(void)
+{
+    printf("\n=== Layout Analysis ===\n");
+    size_t line = layout_cache_line();
+
+    StructLayout basic = STRUCT_LAYOUT(
+        struct BasicStruct,
+        LAYOUT_FIELD(struct BasicStruct, a, LAYOUT_HOT, LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(struct BasicStruct, b, LAYOUT_HOT, LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(struct BasicStruct, c, LAYOUT_HOT, LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(struct BasicStruct, d, LAYOUT_HOT, LAYOUT_NO_WRITER));
+    layout_report(&basic, line);
+
+    StructLayout connection = STRUCT_LAYOUT(
+        struct Connection,
+        LAYOUT_FIELD(struct Connection, id, LAYOUT_HOT, LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(struct Connection, peer, LAYOUT_COLD, LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(struct Connection, state, LAYOUT_HOT, LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(
+            struct Connection, created, LAYOUT_COLD, LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(
+            struct Connection, user_agent, LAYOUT_COLD, LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(
+            struct Connection, last_seen, LAYOUT_HOT, LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(
+            struct Connection, bytes_sent, LAYOUT_COLD, LAYOUT_NO_WRITER));
+    layout_report(&connection, line);
+
+    StructLayout hot_first = STRUCT_LAYOUT(
+        struct ConnectionHotFirst,
+        LAYOUT_FIELD(
+            struct ConnectionHotFirst, last_seen, LAYOUT_HOT, LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(
+            struct ConnectionHotFirst, id, LAYOUT_HOT, LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(
+            struct ConnectionHotFirst, state, LAYOUT_HOT, LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(struct ConnectionHotFirst,
+                     bytes_sent,
+                     LAYOUT_COLD,
+                     LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(
+            struct ConnectionHotFirst, created, LAYOUT_COLD, LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(
+            struct ConnectionHotFirst, peer, LAYOUT_COLD, LAYOUT_NO_WRITER),
+        LAYOUT_FIELD(struct ConnectionHotFirst,
+                     user_agent,
+                     LAYOUT_COLD,
+                     LAYOUT_NO_WRITER));
+    layout_report(&hot_first, line);
+
+    StructLayout counters = STRUCT_LAYOUT(
+        struct WorkerCounters,
+        LAYOUT_FIELD(struct WorkerCounters, processed[0], LAYOUT_HOT, 0),
+        LAYOUT_FIELD(struct WorkerCounters, processed[1], LAYOUT_HOT, 1),
+        LAYOUT_FIELD(struct WorkerCounters, processed[2], LAYOUT_HOT, 2),
+        LAYOUT_FIELD(struct WorkerCounters, processed[3], LAYOUT_HOT, 3),
+        LAYOUT_FIELD(
+            struct WorkerCounters, limit, LAYOUT_HOT, LAYOUT_NO_WRITER));
+    layout_report(&counters, line);
+
+    StructLayout padded = STRUCT_LAYOUT(
+        struct PaddedWorkerCounters,
+        LAYOUT_FIELD(
+            struct PaddedWorkerCounters, processed[0].value, LAYOUT_HOT, 0),
+        LAYOUT_FIELD(
+            struct PaddedWorkerCounters, processed[1].value, LAYOUT_HOT, 1),
+        LAYOUT_FIELD(
+            struct PaddedWorkerCounters, processed[2].value, LAYOUT_HOT, 2),
+        LAYOUT_FIELD(
+            struct PaddedWorkerCounters, processed[3].value, LAYOUT_HOT, 3),
+        LAYOUT_FIELD(struct PaddedWorkerCounters,
+                     limit,
+                     LAYOUT_HOT,
+                     LAYOUT_NO_WRITER));
+    layout_report(&padded, line);
+}
+
 int main(void)
 {
     // Inspect the memory layouts of different structures
@@ -196,5 +320,8 @@ int main(void)
     // Demonstrate array alignment
     demonstrate_array_alignment();
 
+    // Padding, cache lines, hot/cold split and false sharing
+    analyze_layouts();
+
     return 0;
 }
@@ -0,0 +1,288 @@
+// Struct layout analyzer: padding, cache-line crossings, hot/cold split
+// and false sharing for any struct whose fields are registered.
+//
+// Register a struct once with an offsetof table built by the macros below,
+// tagging each field as hot (touched on the fast path) or cold, and, for
+// structs shared between threads, with the thread that writes it:
+//
+//     StructLayout layout = STRUCT_LAYOUT(
+//         struct Node,
+//         LAYOUT_FIELD(struct Node, key, LAYOUT_HOT, LAYOUT_NO_WRITER),
+//         LAYOUT_FIELD(struct Node, hits, LAYOUT_HOT, 0),
+//         LAYOUT_FIELD(struct Node, name, LAYOUT_COLD, LAYOUT_NO_WRITER));
+//     layout_report(&layout, layout_cache_line());
+//
+// Offsets are relative to a cache-line-aligned start, which is what
+// malloc gives for large objects and alignas(64) guarantees; for arrays
+// the report also counts how many elements straddle a line boundary.
+// Fields must be listed in declaration order.
+#ifndef STRUCT_LAYOUT_H
+#define STRUCT_LAYOUT_H
+
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define LAYOUT_NO_WRITER (-1)  // Read-only, or written before sharing
+#define LAYOUT_MAX_FIELDS 64
+
+typedef enum
+{
+    LAYOUT_HOT,
+    LAYOUT_COLD
+} LayoutAccess;
+
+typedef struct
+{
+    const char *name;
+    size_t offset;
+    size_t size;
+    size_t align;
+    LayoutAccess access;
+    int writer;  // Thread index that writes the field, or LAYOUT_NO_WRITER
+} LayoutField;
+
+typedef struct
+{
+    const char *name;
+    size_t size;
+    size_t align;
+    const LayoutField *fields;
+    size_t count;
+} StructLayout;
+
+#define LAYOUT_FIELD(type, member, access, writer)   \
+    {#member,                                        \
+     offsetof(type, member),                         \
+     sizeof(((type *) 0)->member),                   \
+     alignof(__typeof__(((type *) 0)->member)),      \
+     access,                                         \
+     writer}
+
+#define STRUCT_LAYOUT(type, ...)                            \
+    ((StructLayout) {#type,                                 \
+                     sizeof(type),                          \
+                     alignof(type),                         \
+                     (const LayoutField[]) {__VA_ARGS__},   \
+                     sizeof((const LayoutField[]) {__VA_ARGS__}) \
+                         / sizeof(LayoutField)})
+
+// Numbers behind the report, for callers that want to assert on them
+typedef struct
+{
+    size_t padding;          // Bytes of the struct no field covers
+    size_t packed_size;      // Size with fields sorted by alignment
+    size_t crossing_fields;  // Fields that straddle a cache line
+    size_t hot_lines;        // Lines holding at least one hot field
+    size_t hot_lines_min;    // Lines the hot fields would need if grouped
+    size_t shared_lines;     // Lines written by more than one thread
+} LayoutSummary;
+
+// L1 data cache line size, 64 if the system will not say
+static inline size_t layout_cache_line(void)
+{
+#ifdef _SC_LEVEL1_DCACHE_LINESIZE
+    long line = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+    if (line > 0) return (size_t) line;
+#endif
+    return 64;
+}
+
+static inline size_t layout_round_up(size_t value, size_t align)
+{
+    return (value + align - 1) / align * align;
+}
+
+static int layout_compare_align(const void *a, const void *b)
+{
+    const LayoutField *x = *(const LayoutField *const *) a;
+    const LayoutField *y = *(const LayoutField *const *) b;
+    if (x->align != y->align) return x->align < y->align ? 1 : -1;
+    return x->offset < y->offset ? -1 : x->offset > y->offset;
+}
+
+static inline bool layout_crosses(size_t offset, size_t size, size_t line)
+{
+    return size > 0 && offset / line != (offset + size - 1) / line;
+}
+
+// Print the field table and the findings; returns the same numbers
+static LayoutSummary layout_report(const StructLayout *layout, size_t line)
+{
+    LayoutSummary summary = {0, 0, 0, 0, 0, 0};
+    size_t count = layout->count < LAYOUT_MAX_FIELDS ? layout->count
+                                                     : LAYOUT_MAX_FIELDS;
+    size_t lines = (layout->size + line - 1) / line;
+
+    printf("\n%s: %zu bytes, align %zu, %zu cache line%s of %zu bytes\n",
+           layout->name,
+           layout->size,
+           layout->align,
+           lines,
+           lines == 1 ? "" : "s",
+           line);
+    printf("  %-20s %6s %5s %5s %4s %5s  %s\n",
+           "field", "offset", "size", "align", "pad", "line", "notes");
+
+    size_t end = 0;
+    size_t hot_bytes = 0;
+    int writers[LAYOUT_MAX_FIELDS];
+    size_t writer_count = 0;
+    bool hot_read_only = false;
+    bool hot_line[LAYOUT_MAX_FIELDS] = {false};
+    for (size_t i = 0; i < count; i++)
+    {
+        const LayoutField *f = &layout->fields[i];
+        size_t pad = f->offset > end ? f->offset - end : 0;
+        bool crosses = layout_crosses(f->offset, f->size, line);
+        summary.padding += pad;
+        summary.crossing_fields += crosses;
+
+        printf("  %-20s %6zu %5zu %5zu %4zu %5zu  %s%s",
+               f->name,
+               f->offset,
+               f->size,
+               f->align,
+               pad,
+               f->offset / line,
+               f->access == LAYOUT_HOT ? "hot" : "cold",
+               crosses ? ", CROSSES LINE" : "");
+        if (f->writer != LAYOUT_NO_WRITER) printf(", written by %d", f->writer);
+        printf("\n");
+
+        if (f->access == LAYOUT_HOT)
+        {
+            hot_bytes += f->size;
+            hot_read_only |= f->writer == LAYOUT_NO_WRITER;
+            for (size_t l = f->offset / line;
+                 l <= (f->offset + f->size - 1) / line && l < LAYOUT_MAX_FIELDS;
+                 l++)
+            {
+                hot_line[l] = true;
+            }
+        }
+        if (f->writer != LAYOUT_NO_WRITER)
+        {
+            size_t w = 0;
+            while (w < writer_count && writers[w] != f->writer) w++;
+            if (w == writer_count) writers[writer_count++] = f->writer;
+        }
+        if (f->offset + f->size > end) end = f->offset + f->size;
+    }
+    summary.padding += layout->size - end;
+
+    // Padding, and what sorting by decreasing alignment would give
+    const LayoutField *sorted[LAYOUT_MAX_FIELDS];
+    for (size_t i = 0; i < count; i++) sorted[i] = &layout->fields[i];
+    qsort(sorted, count, sizeof(sorted[0]), layout_compare_align);
+    size_t packed = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        packed = layout_round_up(packed, sorted[i]->align) + sorted[i]->size;
+    }
+    summary.packed_size = layout_round_up(packed, layout->align);
+
+    printf("  padding: %zu bytes (%.0f%%), %zu of them at the tail\n",
+           summary.padding,
+           100.0 * summary.padding / layout->size,
+           layout->size - end);
+    // With several writers the padding is what keeps them apart
+    if (writer_count > 1)
+    {
+        if (summary.padding)
+                printf("  padding keeps %zu writers apart; not counted as waste\n",
+                   writer_count);
+    }
+    else if (summary.packed_size < layout->size)
+    {
+        printf("  reorder by alignment -> %zu bytes:", summary.packed_size);
+        for (size_t i = 0; i < count; i++) printf(" %s", sorted[i]->name);
+        printf("\n");
+    }
+
+    // Hot fields spread over more lines than they need
+    for (size_t l = 0; l < lines && l < LAYOUT_MAX_FIELDS; l++)
+    {
+        summary.hot_lines += hot_line[l];
+    }
+    summary.hot_lines_min = (hot_bytes + line - 1) / line;
+    if (writer_count > 1 && summary.hot_lines_min < writer_count + hot_read_only)
+    {
+        // One line per writer, plus one for the fields nobody writes
+        summary.hot_lines_min = writer_count + hot_read_only;
+    }
+    if (summary.hot_lines > summary.hot_lines_min)
+    {
+        printf("  hot fields (%zu bytes) touch %zu lines, %zu would do:"
+               " group them first or move cold fields to a side struct\n",
+               hot_bytes,
+               summary.hot_lines,
+               summary.hot_lines_min);
+    }
+
+    // False sharing: one line written by several threads
+    for (size_t l = 0; l < lines; l++)
+    {
+        int first_writer = LAYOUT_NO_WRITER;
+        bool shared = false;
+        bool read_only = false;
+        for (size_t i = 0; i < count; i++)
+        {
+            const LayoutField *f = &layout->fields[i];
+            if (f->offset / line > l || (f->offset + f->size - 1) / line < l)
+            {
+                continue;
+            }
+            if (f->writer == LAYOUT_NO_WRITER)
+                read_only = true;
+            else if (first_writer == LAYOUT_NO_WRITER)
+                first_writer = f->writer;
+            else if (f->writer != first_writer)
+                shared = true;
+        }
+        if (shared)
+        {
+            summary.shared_lines++;
+            printf("  FALSE SHARING: line %zu is written by several threads;"
+                   " give each writer its own line (alignas(%zu))\n",
+                   l,
+                   line);
+        }
+        else if (first_writer != LAYOUT_NO_WRITER && read_only)
+        {
+            printf("  line %zu mixes read-only fields with fields thread %d"
+                   " writes; readers miss on every write\n",
+                   l,
+                   first_writer);
+        }
+    }
+
+    if (summary.crossing_fields)
+    {
+        printf("  %zu field%s a cache line: two misses per access\n",
+               summary.crossing_fields,
+               summary.crossing_fields == 1 ? " straddles" : "s straddle");
+    }
+
+    // In an array, element i starts at i * size
+    if (layout->size < line && line % layout->size != 0)
+    {
+        size_t period = line;
+        while (period % layout->size) period += line;
+        size_t elements = period / layout->size;
+        size_t split = 0;
+        for (size_t i = 0; i < elements; i++)
+        {
+            split += layout_crosses(i * layout->size, layout->size, line);
+        }
+        printf("  in an array, %zu of every %zu elements straddle a line\n",
+               split,
+               elements);
+    }
+    return summary;
+}
+
+#endif  // STRUCT_LAYOUT_H
@@ -0,0 +1,190 @@
+// Whole-array integer operations selected from a dispatch table.
+//
+// Applying an int (*)(int, int) to each pair of elements costs an
+// indirect call per element, and because the compiler cannot see through
+// the pointer the loop can never be vectorized. Here the operation is
+// chosen once per array instead:
+//
+//   array_apply(ARRAY_OP_MUL, out, a, b, n);      // out[i] = a[i] * b[i]
+//   size_t bad = array_apply(ARRAY_OP_DIV_CHECKED, out, a, b, n);
+//
+// and each kernel is a plain loop the compiler turns into SIMD code (at
+// -O2, built for AVX-512/AVX2/baseline and picked at load time on x86-64
+// Linux). array_apply_each() keeps the per-element function-pointer API
+// for operations without a kernel.
+//
+// Arithmetic wraps on overflow (two's complement) instead of being
+// undefined. There is no SIMD integer divide, so the division kernels
+// divide in double, which is exact for 32-bit operands: the quotient is
+// never close enough to the next integer for rounding to reach it.
+//
+//   ARRAY_OP_DIV_CHECKED     x / 0 and INT_MIN / -1 give 0 and are
+//                            counted; the count is returned
+//   ARRAY_OP_DIV_SATURATING  x / 0 gives INT_MAX, INT_MIN or 0 by the sign
+//                            of x; INT_MIN / -1 gives INT_MAX
+//
+// out may not overlap a or b.
+#ifndef ARRAY_OPS_H
+#define ARRAY_OPS_H
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum
+{
+    ARRAY_OP_ADD,
+    ARRAY_OP_SUB,
+    ARRAY_OP_MUL,
+    ARRAY_OP_DIV_CHECKED,
+    ARRAY_OP_DIV_SATURATING,
+    ARRAY_OP_COUNT
+} ArrayOp;
+
+// Returns the number of elements that failed (checked divide), else 0
+typedef size_t (*ArrayKernel)(int *restrict out,
+                              const int *restrict a,
+                              const int *restrict b,
+                              size_t n);
+
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) \
+    && defined(__linux__)
+#define ARRAY_OPS_CLONES \
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define ARRAY_OPS_CLONES
+#endif
+
+// Kernels run in fixed blocks of ARRAY_OPS_LANES and finish the tail one
+// element at a time: GCC vectorizes a fixed-count inner loop at -O2
+#define ARRAY_OPS_LANES 16
+
+/* ---- Element operations ---- */
+
+static inline int array_wrap_add(int x, int y)
+{
+    return (int) ((unsigned) x + (unsigned) y);
+}
+
+static inline int array_wrap_sub(int x, int y)
+{
+    return (int) ((unsigned) x - (unsigned) y);
+}
+
+static inline int array_wrap_mul(int x, int y)
+{
+    return (int) ((unsigned) x * (unsigned) y);
+}
+
+// keep ? a : b with masks. With ?: GCC moves the divide into the branch
+// that uses it, and a divide that may trap cannot be made unconditional
+// again, so the loop would not vectorize.
+static inline int array_select(int keep, int a, int b)
+{
+    int mask = -keep;
+    return (a & mask) | (b & ~mask);
+}
+
+static inline int array_div_checked(int x, int y, uint64_t *errors)
+{
+    int bad = (y == 0) | ((x == INT_MIN) & (y == -1));
+    int q = (int) ((double) x / (double) array_select(bad, 1, y));
+    *errors += (uint64_t) bad;
+    return array_select(bad, 0, q);
+}
+
+static inline int array_div_saturating(int x, int y)
+{
+    int zero = y == 0;
+    int overflow = (x == INT_MIN) & (y == -1);
+    int q = (int) ((double) x / (double) array_select(zero | overflow, 1, y));
+    int by_zero =
+        array_select(x > 0, INT_MAX, array_select(x < 0, INT_MIN, 0));
+    return array_select(zero, by_zero, array_select(overflow, INT_MAX, q));
+}
+
+/* ---- Kernels ---- */
+
+#define ARRAY_OPS_KERNEL(name, element)                                    \
+    ARRAY_OPS_CLONES static size_t name(int *restrict out,                 \
+                                        const int *restrict a,             \
+                                        const int *restrict b,             \
+                                        size_t n)                          \
+    {                                                                      \
+        size_t i = 0;                                                      \
+        for (; i + ARRAY_OPS_LANES <= n; i += ARRAY_OPS_LANES)             \
+        {                                                                  \
+            for (int j = 0; j < ARRAY_OPS_LANES; j++)                      \
+            {                                                              \
+                out[i + j] = element(a[i + j], b[i + j]);                  \
+            }                                                              \
+        }                                                                  \
+        for (; i < n; i++) out[i] = element(a[i], b[i]);                   \
+        return 0;                                                          \
+    }
+
+ARRAY_OPS_KERNEL(array_add, array_wrap_add)
+ARRAY_OPS_KERNEL(array_sub, array_wrap_sub)
+ARRAY_OPS_KERNEL(array_mul, array_wrap_mul)
+ARRAY_OPS_KERNEL(array_div_sat, array_div_saturating)
+
+// One error counter per lane, summed at the end
+ARRAY_OPS_CLONES static size_t array_div(int *restrict out,
+                                         const int *restrict a,
+                                         const int *restrict b,
+                                         size_t n)
+{
+    uint64_t errors[ARRAY_OPS_LANES] = {0};
+    size_t i = 0;
+    for (; i + ARRAY_OPS_LANES <= n; i += ARRAY_OPS_LANES)
+    {
+        for (int j = 0; j < ARRAY_OPS_LANES; j++)
+        {
+            out[i + j] = array_div_checked(a[i + j], b[i + j], &errors[j]);
+        }
+    }
+    for (; i < n; i++) out[i] = array_div_checked(a[i], b[i], &errors[0]);
+
+    size_t total = 0;
+    for (int j = 0; j < ARRAY_OPS_LANES; j++) total += errors[j];
+    return total;
+}
+
+/* ---- Dispatch ---- */
+
+static const ArrayKernel array_kernels[ARRAY_OP_COUNT] = {
+    [ARRAY_OP_ADD] = array_add,
+    [ARRAY_OP_SUB] = array_sub,
+    [ARRAY_OP_MUL] = array_mul,
+    [ARRAY_OP_DIV_CHECKED] = array_div,
+    [ARRAY_OP_DIV_SATURATING] = array_div_sat,
+};
+
+static inline const char *array_op_name(ArrayOp op)
+{
+    static const char *const names[ARRAY_OP_COUNT] = {
+        "add", "sub", "mul", "div (checked)", "div (saturating)"};
+    return op < ARRAY_OP_COUNT ? names[op] : "?";
+}
+
+// out[i] = a[i] op b[i] for i < n: one table lookup for the whole array
+static inline size_t array_apply(ArrayOp op,
+                                 int *restrict out,
+                                 const int *restrict a,
+                                 const int *restrict b,
+                                 size_t n)
+{
+    return op < ARRAY_OP_COUNT ? array_kernels[op](out, a, b, n) : 0;
+}
+
+// Fallback for any int (*)(int, int): one indirect call per element
+static inline void array_apply_each(int (*operation)(int, int),
+                                    int *out,
+                                    const int *a,
+                                    const int *b,
+                                    size_t n)
+{
+    for (size_t i = 0; i < n; i++) out[i] = operation(a[i], b[i]);
+}
+
+#endif  // ARRAY_OPS_H
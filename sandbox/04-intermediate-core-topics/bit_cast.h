@@ -0,0 +1,166 @@
+// Reading the bits of a float, and back, without undefined behaviour.
+//
+// *(uint32_t *) &f breaks the strict aliasing rule: at -O2 the compiler
+// may assume a store through a uint32_t * never changes a float and keep
+// a stale value in a register. Reading a union member other than the one
+// last written is allowed in C99 (not in C++), but only through the union
+// object itself. memcpy of the whole value is always defined, and GCC and
+// Clang compile it to one register move (movd on x86-64, fmov on AArch64)
+// or to nothing when the value is already in the right register:
+//
+//   uint32_t bits = float_bits(x);        // same as the union, no UB
+//   if (float_is_nan(x)) ...              // integer compare, no FP flags
+//   float_ulp_distance(a, b) <= 4         // "equal to about 6 digits"
+//
+// The classification and sign helpers work on the bit pattern, so they
+// are exact for NaN, infinities, -0.0 and subnormals, never raise FP
+// exceptions, and do not depend on -ffast-math (under which isnan() may
+// be folded to false).
+#ifndef BIT_CAST_H
+#define BIT_CAST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define FLOAT_SIGN_MASK     0x80000000u
+#define FLOAT_EXPONENT_MASK 0x7F800000u
+#define FLOAT_MANTISSA_MASK 0x007FFFFFu
+
+/* ---- Bit casts ---- */
+
+static inline uint32_t float_bits(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+static inline float float_from_bits(uint32_t bits)
+{
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+static inline uint64_t double_bits(double x)
+{
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+static inline double double_from_bits(uint64_t bits)
+{
+    double x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+/* ---- Classification ---- */
+
+// Exponent all ones: infinity with a zero mantissa, NaN otherwise
+static inline bool float_is_nan(float x)
+{
+    return (float_bits(x) & ~FLOAT_SIGN_MASK) > FLOAT_EXPONENT_MASK;
+}
+
+static inline bool float_is_inf(float x)
+{
+    return (float_bits(x) & ~FLOAT_SIGN_MASK) == FLOAT_EXPONENT_MASK;
+}
+
+static inline bool float_is_finite(float x)
+{
+    return (float_bits(x) & FLOAT_EXPONENT_MASK) != FLOAT_EXPONENT_MASK;
+}
+
+// +0.0 and -0.0
+static inline bool float_is_zero(float x)
+{
+    return (float_bits(x) << 1) == 0;
+}
+
+// Exponent zero, mantissa not: these are the values that make some CPUs
+// fall into a slow microcode path
+static inline bool float_is_subnormal(float x)
+{
+    uint32_t bits = float_bits(x);
+    return (bits & FLOAT_EXPONENT_MASK) == 0
+           && (bits & FLOAT_MANTISSA_MASK) != 0;
+}
+
+/* ---- Sign ---- */
+
+// True for -0.0 and negative NaNs too, unlike x < 0
+static inline bool float_sign_bit(float x)
+{
+    return float_bits(x) >> 31;
+}
+
+static inline float float_abs(float x)
+{
+    return float_from_bits(float_bits(x) & ~FLOAT_SIGN_MASK);
+}
+
+static inline float float_negate(float x)
+{
+    return float_from_bits(float_bits(x) ^ FLOAT_SIGN_MASK);
+}
+
+// |magnitude| with the sign of sign
+static inline float float_copysign(float magnitude, float sign)
+{
+    return float_from_bits((float_bits(magnitude) & ~FLOAT_SIGN_MASK)
+                           | (float_bits(sign) & FLOAT_SIGN_MASK));
+}
+
+// x * (sign < 0 ? -1 : 1) without the multiply or the branch
+static inline float float_mul_sign(float x, float sign)
+{
+    return float_from_bits(float_bits(x)
+                           ^ (float_bits(sign) & FLOAT_SIGN_MASK));
+}
+
+/* ---- Ordering ---- */
+
+// IEEE 754 floats order like sign-magnitude integers: set the sign bit of
+// positives, invert all bits of negatives, and the result orders like the
+// floats as unsigned integers (the radix sort key). -0.0 sorts just
+// before +0.0, and NaNs go to the ends by their sign bit.
+static inline uint32_t float_sortable_key(float x)
+{
+    uint32_t bits = float_bits(x);
+    uint32_t mask = (uint32_t) -(int32_t) (bits >> 31) | FLOAT_SIGN_MASK;
+    return bits ^ mask;
+}
+
+static inline float float_from_sortable_key(uint32_t key)
+{
+    uint32_t mask = ((key >> 31) - 1) | FLOAT_SIGN_MASK;
+    return float_from_bits(key ^ mask);
+}
+
+// Number of representable floats between a and b: 0 for equal values, 1
+// for neighbours (including -0.0 and +0.0), UINT32_MAX if either is NaN.
+// A relative tolerance that scales with the values by itself, unlike a
+// fixed epsilon; but near zero even tiny absolute differences are millions
+// of ulps apart, so pair it with an absolute bound there.
+static inline uint32_t float_ulp_distance(float a, float b)
+{
+    if (float_is_nan(a) || float_is_nan(b)) return UINT32_MAX;
+    uint32_t ka = float_sortable_key(a), kb = float_sortable_key(b);
+    return ka > kb ? ka - kb : kb - ka;
+}
+
+// Within max_ulps of each other, or closer than abs_epsilon in value
+static inline bool float_nearly_equal(float a,
+                                      float b,
+                                      uint32_t max_ulps,
+                                      float abs_epsilon)
+{
+    return float_abs(a - b) <= abs_epsilon
+           || float_ulp_distance(a, b) <= max_ulps;
+}
+
+#endif  // BIT_CAST_H
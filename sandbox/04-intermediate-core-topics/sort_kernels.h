@@ -0,0 +1,305 @@
+// Type-specialized sorting: introsort, LSD radix sort and a parallel merge
+// sort.
+//
+// qsort sees elements only through void pointers, so every comparison is
+// an indirect call that cannot be inlined and every move is a memcpy of a
+// runtime size. The sorts here are stamped out per element type by a
+// macro, with the comparison written as an expression the compiler inlines:
+//
+//   #define BY_AGE(x, y) ((x).age < (y).age)
+//   SORT_DEFINE(sort_people, Person, BY_AGE)  // sort_people(Person *, size_t)
+//
+//   SORT_DEFINE        introsort: median-of-3 quicksort, heapsort once the
+//                      recursion gets too deep (worst case O(n log n)),
+//                      insertion sort for short ranges
+//   RADIX_DEFINE       LSD radix sort on a 32-bit key, 4 passes of 8 bits,
+//                      no comparisons at all; needs an n-element scratch
+//   SORT_DEFINE_PARALLEL
+//                      merge sort that sorts halves on separate threads
+//                      (link with -pthread)
+//
+// sort_int/sort_unsigned/sort_float/sort_double, radix_sort_u32/_i32/
+// _float and sort_array() (picks the introsort by the array's type) are
+// defined below for the common cases.
+#ifndef SORT_KERNELS_H
+#define SORT_KERNELS_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bit_cast.h"
+
+#define SORT_LESS(x, y) ((x) < (y))
+
+#define SORT_INSERTION_MAX 16  // Ranges this short go to insertion sort
+
+#define SORT_SWAP(type, x, y) \
+    do                        \
+    {                         \
+        type sort_tmp_ = (x); \
+        (x) = (y);            \
+        (y) = sort_tmp_;      \
+    } while (0)
+
+static inline int sort_depth_limit(size_t n)
+{
+    int depth = 0;
+    while (n > 1)
+    {
+        n >>= 1;
+        depth += 2;
+    }
+    return depth;
+}
+
+/* ---- Introsort ---- */
+
+#define SORT_DEFINE(name, type, less)                                        \
+    static inline void name##_insertion(type *a, size_t n)                   \
+    {                                                                        \
+        for (size_t i = 1; i < n; i++)                                       \
+        {                                                                    \
+            type v = a[i];                                                   \
+            size_t j = i;                                                    \
+            for (; j > 0 && less(v, a[j - 1]); j--) a[j] = a[j - 1];         \
+            a[j] = v;                                                        \
+        }                                                                    \
+    }                                                                        \
+                                                                             \
+    static inline void name##_sift_down(type *a, size_t root, size_t n)      \
+    {                                                                        \
+        type v = a[root];                                                    \
+        for (;;)                                                             \
+        {                                                                    \
+            size_t child = 2 * root + 1;                                     \
+            if (child >= n) break;                                           \
+            if (child + 1 < n && less(a[child], a[child + 1])) child++;      \
+            if (!less(v, a[child])) break;                                   \
+            a[root] = a[child];                                              \
+            root = child;                                                    \
+        }                                                                    \
+        a[root] = v;                                                         \
+    }                                                                        \
+                                                                             \
+    static inline void name##_heapsort(type *a, size_t n)                    \
+    {                                                                        \
+        for (size_t i = n / 2; i-- > 0;) name##_sift_down(a, i, n);          \
+        for (size_t end = n; end-- > 1;)                                     \
+        {                                                                    \
+            SORT_SWAP(type, a[0], a[end]);                                   \
+            name##_sift_down(a, 0, end);                                     \
+        }                                                                    \
+    }                                                                        \
+                                                                             \
+    static inline void name##_introsort(type *a, size_t n, int depth)        \
+    {                                                                        \
+        while (n > SORT_INSERTION_MAX)                                       \
+        {                                                                    \
+            if (depth-- == 0)                                                \
+            {                                                                \
+                name##_heapsort(a, n);                                       \
+                return;                                                      \
+            }                                                                \
+                                                                             \
+            /* Median of three; a[0] and a[n - 1] then bound both scans */   \
+            size_t mid = n / 2;                                              \
+            if (less(a[mid], a[0])) SORT_SWAP(type, a[mid], a[0]);           \
+            if (less(a[n - 1], a[mid]))                                      \
+            {                                                                \
+                SORT_SWAP(type, a[n - 1], a[mid]);                           \
+                if (less(a[mid], a[0])) SORT_SWAP(type, a[mid], a[0]);       \
+            }                                                                \
+            type pivot = a[mid];                                             \
+                                                                             \
+            /* Hoare partition: stops on equal keys, so runs of duplicates   \
+               split evenly instead of going quadratic */                    \
+            size_t i = 0, j = n - 1;                                         \
+            for (;;)                                                         \
+            {                                                                \
+                while (less(a[++i], pivot)) {}                               \
+                while (less(pivot, a[--j])) {}                               \
+                if (i >= j) break;                                           \
+                SORT_SWAP(type, a[i], a[j]);                                 \
+            }                                                                \
+                                                                             \
+            /* Recurse into the smaller side, loop on the larger */          \
+            if (i < n - i)                                                   \
+            {                                                                \
+                name##_introsort(a, i, depth);                               \
+                a += i;                                                      \
+                n -= i;                                                      \
+            }                                                                \
+            else                                                             \
+            {                                                                \
+                name##_introsort(a + i, n - i, depth);                       \
+                n = i;                                                       \
+            }                                                                \
+        }                                                                    \
+        name##_insertion(a, n);                                              \
+    }                                                                        \
+                                                                             \
+    static inline void name(type *a, size_t n)                               \
+    {                                                                        \
+        name##_introsort(a, n, sort_depth_limit(n));                         \
+    }
+
+/* ---- LSD radix sort ---- */
+
+// key(x) maps an element to a uint32_t whose unsigned order is the
+// element order. All four digit histograms come from one read of the
+// input; a pass whose digit is the same for every element is skipped, so
+// small keys cost fewer passes. Stable.
+#define RADIX_DEFINE(name, type, key)                                        \
+    static inline void name(type *a, type *scratch, size_t n)                \
+    {                                                                        \
+        if (n < 2) return;                                                   \
+        size_t counts[4][256] = {{0}};                                       \
+        for (size_t i = 0; i < n; i++)                                       \
+        {                                                                    \
+            uint32_t k = key(a[i]);                                          \
+            counts[0][k & 0xFF]++;                                           \
+            counts[1][(k >> 8) & 0xFF]++;                                    \
+            counts[2][(k >> 16) & 0xFF]++;                                   \
+            counts[3][k >> 24]++;                                            \
+        }                                                                    \
+                                                                             \
+        type *src = a, *dst = scratch;                                       \
+        for (int pass = 0; pass < 4; pass++)                                 \
+        {                                                                    \
+            int shift = 8 * pass;                                            \
+            size_t *count = counts[pass];                                    \
+            if (count[(key(src[0]) >> shift) & 0xFF] == n) continue;         \
+                                                                             \
+            size_t offset[256];                                              \
+            size_t total = 0;                                                \
+            for (int d = 0; d < 256; d++)                                    \
+            {                                                                \
+                offset[d] = total;                                           \
+                total += count[d];                                           \
+            }                                                                \
+            for (size_t i = 0; i < n; i++)                                   \
+            {                                                                \
+                dst[offset[(key(src[i]) >> shift) & 0xFF]++] = src[i];       \
+            }                                                                \
+            type *t = src;                                                   \
+            src = dst;                                                       \
+            dst = t;                                                         \
+        }                                                                    \
+        if (src != a) memcpy(a, src, n * sizeof(type));                      \
+    }
+
+static inline uint32_t sort_key_u32(uint32_t x)
+{
+    return x;
+}
+
+// Flipping the sign bit puts negative numbers below positive ones
+static inline uint32_t sort_key_i32(int32_t x)
+{
+    return (uint32_t) x ^ 0x80000000u;
+}
+
+// See float_sortable_key in bit_cast.h
+static inline uint32_t sort_key_float(float x)
+{
+    return float_sortable_key(x);
+}
+
+/* ---- Parallel merge sort ---- */
+
+// Splits the array in half, sorts one half on a new thread and the other
+// on the calling thread, down to 2^levels pieces sorted by the introsort
+// `name`, then merges back up through an n-element scratch buffer. Needs
+// SORT_DEFINE(name, ...) first. If a thread cannot be created that half is
+// sorted inline, so the result never depends on how many threads ran.
+#define SORT_PARALLEL_MIN 16384  // Below this a thread costs more than it saves
+
+#define SORT_DEFINE_PARALLEL(name, type, less)                               \
+    typedef struct                                                           \
+    {                                                                        \
+        type *a;                                                             \
+        type *scratch;                                                       \
+        size_t n;                                                            \
+        int levels;                                                          \
+    } name##_job;                                                            \
+                                                                             \
+    static inline void *name##_parallel_run(void *arg);                      \
+                                                                             \
+    static inline void name##_merge(type *out,                               \
+                                    const type *left, size_t left_n,         \
+                                    const type *right, size_t right_n)       \
+    {                                                                        \
+        size_t i = 0, j = 0, k = 0;                                          \
+        while (i < left_n && j < right_n)                                    \
+        {                                                                    \
+            /* Take from the left on ties: stable */                         \
+            out[k++] = less(right[j], left[i]) ? right[j++] : left[i++];     \
+        }                                                                    \
+        while (i < left_n) out[k++] = left[i++];                             \
+        while (j < right_n) out[k++] = right[j++];                           \
+    }                                                                        \
+                                                                             \
+    static inline void name##_parallel_job(name##_job *job)                  \
+    {                                                                        \
+        if (job->levels == 0 || job->n < SORT_PARALLEL_MIN)                  \
+        {                                                                    \
+            name(job->a, job->n);                                            \
+            return;                                                          \
+        }                                                                    \
+        size_t half = job->n / 2;                                            \
+        name##_job left = {job->a, job->scratch, half, job->levels - 1};     \
+        name##_job right = {job->a + half, job->scratch + half,              \
+                            job->n - half, job->levels - 1};                 \
+                                                                             \
+        pthread_t thread;                                                    \
+        int spawned =                                                        \
+            pthread_create(&thread, NULL, name##_parallel_run, &left) == 0;  \
+        if (!spawned) name##_parallel_job(&left);                            \
+        name##_parallel_job(&right);                                         \
+        if (spawned) pthread_join(thread, NULL);                             \
+                                                                             \
+        name##_merge(job->scratch, left.a, left.n, right.a, right.n);        \
+        memcpy(job->a, job->scratch, job->n * sizeof(type));                 \
+    }                                                                        \
+                                                                             \
+    static inline void *name##_parallel_run(void *arg)                       \
+    {                                                                        \
+        name##_parallel_job((name##_job *) arg);                             \
+        return NULL;                                                         \
+    }                                                                        \
+                                                                             \
+    /* Up to 2^levels threads; returns -1 if scratch cannot be allocated */  \
+    static inline int name##_parallel(type *a, size_t n, int levels)         \
+    {                                                                        \
+        if (n < 2) return 0;                                                 \
+        type *scratch = (type *) malloc(n * sizeof(type));                   \
+        if (scratch == NULL) return -1;                                      \
+        name##_job job = {a, scratch, n, levels};                            \
+        name##_parallel_job(&job);                                           \
+        free(scratch);                                                       \
+        return 0;                                                            \
+    }
+
+/* ---- Common instances ---- */
+
+SORT_DEFINE(sort_int, int, SORT_LESS)
+SORT_DEFINE(sort_unsigned, unsigned, SORT_LESS)
+SORT_DEFINE(sort_float, float, SORT_LESS)
+SORT_DEFINE(sort_double, double, SORT_LESS)
+
+RADIX_DEFINE(radix_sort_u32, uint32_t, sort_key_u32)
+RADIX_DEFINE(radix_sort_i32, int32_t, sort_key_i32)
+RADIX_DEFINE(radix_sort_float, float, sort_key_float)
+
+// sort_array(a, n): introsort chosen by the element type of a
+#define sort_array(a, n)              \
+    _Generic((a),                     \
+        int *: sort_int,              \
+        unsigned *: sort_unsigned,    \
+        float *: sort_float,          \
+        double *: sort_double)((a), (n))
+
+#endif  // SORT_KERNELS_H
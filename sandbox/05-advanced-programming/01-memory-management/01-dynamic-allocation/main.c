@@ -1,7 +1,16 @@
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <time.h>
+#include <unistd.h>
 
 void malloc_example()
 {
@@ -296,8 +305,418 @@ void benchmark_malloc_vs_calloc()
     }
 }
 
-int main()
+// ===== First-Touch / NUMA Placement Study =====
+//
+// Linux places an anonymous page on the NUMA node of the thread that first
+// touches it. Which thread that is depends on the allocation path:
+// malloc/calloc of a large block return untouched mmap memory, so the
+// workers that initialize their slices own them; memset from one thread
+// or MAP_POPULATE fault everything in on the allocating thread's node.
+
+#define MAX_NODES       64
+#define MAX_STUDY_CPUS  1024
+#define STUDY_PAGE_SIZE 4096
+#define HUGE_PAGE_SIZE  (2UL * 1024 * 1024)
+
+typedef struct
+{
+    int node_count;
+    int node_id[MAX_NODES];  // Kernel node number; ids can have gaps
+    int cpu_count[MAX_NODES];
+    int cpus[MAX_NODES][MAX_STUDY_CPUS];
+} NodeTopology;
+
+typedef enum
+{
+    PLACE_MALLOC,         // malloc, workers touch first
+    PLACE_MALLOC_MEMSET,  // malloc + memset on the main thread
+    PLACE_CALLOC,         // calloc, workers touch first
+    PLACE_MMAP_POPULATE,  // mmap(MAP_POPULATE), faulted by the kernel up front
+    PLACE_HUGE_PAGES,     // MAP_HUGETLB, or THP via madvise as a fallback
+    PLACE_COUNT
+} PlacementPath;
+
+static const char *placement_names[PLACE_COUNT] = {
+    "malloc", "malloc+memset", "calloc", "mmap(POPULATE)", "huge pages"};
+
+typedef enum
+{
+    TOUCH_WRITE,        // Write the thread's own slice (first touch)
+    TOUCH_READ_LOCAL,   // Read the slice this thread wrote
+    TOUCH_READ_REMOTE,  // Read the slice of a thread on the next node
+} TouchMode;
+
+typedef struct
+{
+    char *buffer;
+    size_t slice;
+    int index;
+    int thread_count;
+    int cpu;
+    TouchMode mode;
+    long faults;
+    uint64_t sum;
+} TouchWorker;
+
+// Parse a sysfs cpulist such as "0-3,8-11"
+static int parse_cpu_list(const char *path, int *cpus, int max)
+{
+    FILE *file = fopen(path, "r");
+    if (!file) return 0;
+
+    int count = 0, first, last;
+    while (count < max && fscanf(file, "%d", &first) == 1)
+    {
+        last = first;
+        int c = fgetc(file);
+        if (c == '-')
+        {
+            if (fscanf(file, "%d", &last) != 1) break;
+            c = fgetc(file);
+        }
+        for (int cpu = first; cpu <= last && count < max; cpu++)
+        {
+            cpus[count++] = cpu;
+        }
+        if (c != ',') break;
+    }
+
+    fclose(file);
+    return count;
+}
+
+static int compare_ints(const void *a, const void *b)
+{
+    int x = *(const int *) a, y = *(const int *) b;
+    return (x > y) - (x < y);
+}
+
+// Discover nodes with CPUs from sysfs, in node id order; without NUMA
+// everything is node 0
+static void discover_topology(NodeTopology *topo)
+{
+    int ids[MAX_NODES];
+    int id_count = 0;
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (dir)
+    {
+        struct dirent *entry;
+        while (id_count < MAX_NODES && (entry = readdir(dir)) != NULL)
+        {
+            int id;
+            char tail;
+            if (sscanf(entry->d_name, "node%d%c", &id, &tail) == 1) ids[id_count++] = id;
+        }
+        closedir(dir);
+    }
+    qsort(ids, id_count, sizeof(int), compare_ints);
+
+    topo->node_count = 0;
+    for (int i = 0; i < id_count; i++)
+    {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", ids[i]);
+        int count = parse_cpu_list(path, topo->cpus[topo->node_count], MAX_STUDY_CPUS);
+        if (count > 0)
+        {
+            topo->node_id[topo->node_count] = ids[i];
+            topo->cpu_count[topo->node_count++] = count;
+        }
+    }
+
+    if (topo->node_count == 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        topo->node_count = 1;
+        topo->node_id[0] = 0;
+        topo->cpu_count[0] = online > 0 ? (int) (online < MAX_STUDY_CPUS ? online : MAX_STUDY_CPUS) : 1;
+        for (int i = 0; i < topo->cpu_count[0]; i++)
+        {
+            topo->cpus[0][i] = i;
+        }
+    }
+}
+
+// Spread threads round-robin over nodes, then over each node's CPUs
+static int cpu_for_thread(const NodeTopology *topo, int thread)
+{
+    int node = thread % topo->node_count;
+    int slot = (thread / topo->node_count) % topo->cpu_count[node];
+    return topo->cpus[node][slot];
+}
+
+// Kernel id of the node a thread runs on, as move_pages reports it
+static int node_for_thread(const NodeTopology *topo, int thread)
+{
+    return topo->node_id[thread % topo->node_count];
+}
+
+static double study_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long thread_minor_faults(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_minflt;
+}
+
+static void *touch_worker(void *arg)
+{
+    TouchWorker *w = (TouchWorker *) arg;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(w->cpu, &set);
+    sched_setaffinity(0, sizeof(set), &set);  // Best effort
+
+    int slice_index = w->index;
+    if (w->mode == TOUCH_READ_REMOTE)
+    {
+        slice_index = (w->index + 1) % w->thread_count;
+    }
+    char *start = w->buffer + (size_t) slice_index * w->slice;
+
+    long faults = thread_minor_faults();
+    if (w->mode == TOUCH_WRITE)
+    {
+        memset(start, w->index + 1, w->slice);
+    }
+    else
+    {
+        const uint64_t *words = (const uint64_t *) start;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < w->slice / sizeof(uint64_t); i++)
+        {
+            sum += words[i];
+        }
+        w->sum = sum;
+    }
+    w->faults = thread_minor_faults() - faults;
+
+    return NULL;
+}
+
+// Run one phase on all threads; returns elapsed seconds
+static double run_touch_phase(const NodeTopology *topo,
+                              char *buffer,
+                              size_t slice,
+                              int thread_count,
+                              TouchMode mode,
+                              long *faults)
+{
+    pthread_t threads[thread_count];
+    TouchWorker workers[thread_count];
+
+    double start = study_seconds();
+    for (int i = 0; i < thread_count; i++)
+    {
+        workers[i] = (TouchWorker) {.buffer = buffer,
+                                    .slice = slice,
+                                    .index = i,
+                                    .thread_count = thread_count,
+                                    .cpu = cpu_for_thread(topo, i),
+                                    .mode = mode};
+        pthread_create(&threads[i], NULL, touch_worker, &workers[i]);
+    }
+
+    *faults = 0;
+    for (int i = 0; i < thread_count; i++)
+    {
+        pthread_join(threads[i], NULL);
+        *faults += workers[i].faults;
+    }
+    return study_seconds() - start;
+}
+
+// Fraction of sampled pages that live on the node of the thread owning
+// their slice, via move_pages(2) in query mode. -1 if unavailable.
+static double local_page_fraction(const NodeTopology *topo, char *buffer, size_t slice, int thread_count)
+{
+#ifdef SYS_move_pages
+    enum { SAMPLES_PER_SLICE = 64 };
+    int total = thread_count * SAMPLES_PER_SLICE;
+    void *pages[total];
+    int status[total];
+
+    for (int t = 0; t < thread_count; t++)
+    {
+        for (int s = 0; s < SAMPLES_PER_SLICE; s++)
+        {
+            size_t offset = (slice / SAMPLES_PER_SLICE) * s & ~(size_t) (STUDY_PAGE_SIZE - 1);
+            pages[t * SAMPLES_PER_SLICE + s] = buffer + (size_t) t * slice + offset;
+        }
+    }
+
+    if (syscall(SYS_move_pages, 0, (unsigned long) total, pages, NULL, status, 0) != 0)
+    {
+        return -1.0;
+    }
+
+    int local = 0, valid = 0;
+    for (int i = 0; i < total; i++)
+    {
+        if (status[i] < 0) continue;
+        valid++;
+        if (status[i] == node_for_thread(topo, i / SAMPLES_PER_SLICE)) local++;
+    }
+    return valid ? (double) local / valid : -1.0;
+#else
+    (void) topo, (void) buffer, (void) slice, (void) thread_count;
+    return -1.0;
+#endif
+}
+
+// Allocate through one path. *mapped_size is non-zero for mmap'd buffers.
+static char *placement_alloc(PlacementPath path, size_t size, size_t *mapped_size)
+{
+    char *buffer = NULL;
+    *mapped_size = 0;
+
+    switch (path)
+    {
+        case PLACE_MALLOC:
+            buffer = (char *) malloc(size);
+            break;
+        case PLACE_MALLOC_MEMSET:
+            buffer = (char *) malloc(size);
+            // Non-zero so the compiler cannot turn this into calloc
+            if (buffer) memset(buffer, 0xA5, size);
+            break;
+        case PLACE_CALLOC:
+            buffer = (char *) calloc(size, 1);
+            break;
+        case PLACE_MMAP_POPULATE:
+            buffer = (char *) mmap(NULL, size, PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+            if (buffer == MAP_FAILED) return NULL;
+            *mapped_size = size;
+            break;
+        case PLACE_HUGE_PAGES:
+        {
+            size_t rounded = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+            buffer = (char *) mmap(NULL, rounded, PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (buffer == MAP_FAILED)
+            {
+                // No reserved hugetlb pages: ask for transparent huge pages
+                buffer = (char *) mmap(NULL, rounded, PROT_READ | PROT_WRITE,
+                                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (buffer == MAP_FAILED) return NULL;
+                madvise(buffer, rounded, MADV_HUGEPAGE);
+            }
+            *mapped_size = rounded;
+            break;
+        }
+        default:
+            break;
+    }
+
+    return buffer;
+}
+
+void first_touch_study(size_t size, int thread_count)
 {
+    printf("\n--- First-Touch / NUMA Placement Study ---\n");
+
+    NodeTopology *topo = (NodeTopology *) malloc(sizeof(NodeTopology));
+    if (!topo)
+    {
+        printf("Memory allocation failed\n");
+        return;
+    }
+    discover_topology(topo);
+
+    // Whole huge pages per slice so no page straddles two threads
+    size_t slice = (size / thread_count + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    size = slice * thread_count;
+
+    printf("%d node(s), %d thread(s), %zu MB buffer (%zu MB per thread)\n",
+           topo->node_count,
+           thread_count,
+           size >> 20,
+           slice >> 20);
+    if (topo->node_count == 1)
+    {
+        printf("Single node: every page is local, remote reads measure cache effects only\n");
+    }
+
+    printf("%-15s %9s %9s %10s %10s %11s %11s %7s\n",
+           "path", "alloc ms", "faults", "init flt", "init GB/s", "local GB/s", "remote GB/s",
+           "local%");
+
+    for (int p = 0; p < PLACE_COUNT; p++)
+    {
+        long alloc_faults = thread_minor_faults();
+        double start = study_seconds();
+        size_t mapped_size;
+        char *buffer = placement_alloc((PlacementPath) p, size, &mapped_size);
+        double alloc_ms = (study_seconds() - start) * 1e3;
+        alloc_faults = thread_minor_faults() - alloc_faults;
+
+        if (!buffer)
+        {
+            printf("%-15s allocation failed\n", placement_names[p]);
+            continue;
+        }
+
+        long init_faults, read_faults;
+        double init_time = run_touch_phase(topo, buffer, slice, thread_count, TOUCH_WRITE, &init_faults);
+        double local_fraction = local_page_fraction(topo, buffer, slice, thread_count);
+        double local_time =
+            run_touch_phase(topo, buffer, slice, thread_count, TOUCH_READ_LOCAL, &read_faults);
+        double remote_time =
+            run_touch_phase(topo, buffer, slice, thread_count, TOUCH_READ_REMOTE, &read_faults);
+
+        double gb = (double) size / 1e9;
+        printf("%-15s %9.2f %9ld %10ld %10.2f %11.2f %11.2f ",
+               placement_names[p],
+               alloc_ms,
+               alloc_faults,
+               init_faults,
+               gb / init_time,
+               gb / local_time,
+               gb / remote_time);
+        if (local_fraction < 0)
+        {
+            printf("%7s\n", "n/a");
+        }
+        else
+        {
+            printf("%6.1f%%\n", local_fraction * 100.0);
+        }
+
+        if (mapped_size)
+        {
+            munmap(buffer, mapped_size);
+        }
+        else
+        {
+            free(buffer);
+        }
+    }
+
+    printf("faults = minor faults on the allocating thread, init flt = faults in the workers\n");
+    free(topo);
+}
+
+// Usage: main [--first-touch [size_mb] [threads]]
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "--first-touch") == 0)
+    {
+        size_t size_mb = argc > 2 ? strtoul(argv[2], NULL, 10) : 1024;
+        int threads = argc > 3 ? atoi(argv[3]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+        if (size_mb == 0) size_mb = 1024;
+        if (threads < 1) threads = 1;
+        first_touch_study(size_mb << 20, threads);
+        return 0;
+    }
+
     printf("==== DYNAMIC MEMORY ALLOCATION EXAMPLES ====\n\n");
 
     malloc_example();
@@ -305,6 +724,7 @@ int main()
     realloc_examples();
     calloc_struct_example();
     benchmark_malloc_vs_calloc();
+    first_touch_study(64UL << 20, 4);
 
     return 0;
 }
@@ -1,20 +1,146 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Structure to track allocations
+// Call site that allocated memory, with its live totals
 typedef struct
 {
-    void *ptr;
-    size_t size;
     const char *file;
     int line;
     const char *function;
+    size_t live_bytes;
+    size_t live_count;
+} AllocationSite;
+
+// Structure to track allocations
+typedef struct
+{
+    void *ptr;  // NULL marks an empty slot
+    size_t size;
+    size_t site;  // Index into AllocationTable.sites
 } AllocationRecord;
 
-#define MAX_ALLOCATIONS 1000
-AllocationRecord allocations[MAX_ALLOCATIONS];
-int allocation_count = 0;
+// Open-addressing hash tables (linear probing, power-of-two capacity).
+// records is keyed by pointer; site_index maps file:line to a sites entry.
+typedef struct
+{
+    AllocationRecord *records;
+    size_t capacity;
+    size_t count;
+
+    AllocationSite *sites;  // Dense array, sites are never removed
+    size_t site_count;
+    size_t *site_index;  // Slots hold site + 1, 0 is empty
+    size_t site_capacity;
+} AllocationTable;
+
+#define INITIAL_TABLE_CAPACITY 64
+#define MAX_LEAK_DETAILS       20
+
+AllocationTable allocations = {0};
+
+// Mix pointer bits; the low bits are mostly zero because of alignment
+size_t hash_pointer(const void *ptr)
+{
+    uint64_t x = (uint64_t) (uintptr_t) ptr;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return (size_t) x;
+}
+
+size_t hash_site(const char *file, int line)
+{
+    return hash_pointer(file) ^ ((size_t) line * 0x9E3779B97F4A7C15ULL);
+}
+
+// Grow a table when it is more than 70% full
+int table_needs_growth(size_t count, size_t capacity)
+{
+    return capacity == 0 || (count + 1) * 10 > capacity * 7;
+}
+
+int grow_records(void)
+{
+    size_t capacity = allocations.capacity ? allocations.capacity * 2 : INITIAL_TABLE_CAPACITY;
+    AllocationRecord *records = calloc(capacity, sizeof(AllocationRecord));
+    if (records == NULL) return 0;
+
+    // Reinsert every live record into the new table
+    for (size_t i = 0; i < allocations.capacity; i++)
+    {
+        AllocationRecord *old = &allocations.records[i];
+        if (old->ptr == NULL) continue;
+
+        size_t slot = hash_pointer(old->ptr) & (capacity - 1);
+        while (records[slot].ptr != NULL)
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        records[slot] = *old;
+    }
+
+    free(allocations.records);
+    allocations.records = records;
+    allocations.capacity = capacity;
+    return 1;
+}
+
+int grow_sites(void)
+{
+    size_t capacity = allocations.site_capacity ? allocations.site_capacity * 2 : INITIAL_TABLE_CAPACITY;
+    size_t *index = calloc(capacity, sizeof(size_t));
+    AllocationSite *sites = realloc(allocations.sites, capacity * sizeof(AllocationSite));
+    if (index == NULL || sites == NULL)
+    {
+        free(index);
+        if (sites != NULL) allocations.sites = sites;
+        return 0;
+    }
+    allocations.sites = sites;
+
+    for (size_t i = 0; i < allocations.site_count; i++)
+    {
+        size_t slot = hash_site(sites[i].file, sites[i].line) & (capacity - 1);
+        while (index[slot] != 0)
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        index[slot] = i + 1;
+    }
+
+    free(allocations.site_index);
+    allocations.site_index = index;
+    allocations.site_capacity = capacity;
+    return 1;
+}
+
+// Find or create the site entry for file:line; returns SIZE_MAX on failure
+size_t lookup_site(const char *file, int line, const char *function)
+{
+    if (table_needs_growth(allocations.site_count, allocations.site_capacity) && !grow_sites())
+    {
+        return SIZE_MAX;
+    }
+
+    size_t mask = allocations.site_capacity - 1;
+    size_t slot = hash_site(file, line) & mask;
+    while (allocations.site_index[slot] != 0)
+    {
+        AllocationSite *site = &allocations.sites[allocations.site_index[slot] - 1];
+        if (site->file == file && site->line == line)
+        {
+            return allocations.site_index[slot] - 1;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    size_t id = allocations.site_count++;
+    allocations.sites[id] = (AllocationSite) {file, line, function, 0, 0};
+    allocations.site_index[slot] = id + 1;
+    return id;
+}
 
 // Custom allocation functions for tracking
 void *track_malloc(size_t size,
@@ -23,35 +149,72 @@ void *track_malloc(size_t size,
                    const char *function)
 {
     void *ptr = malloc(size);
+    if (ptr == NULL) return NULL;
 
-    if (ptr != NULL && allocation_count < MAX_ALLOCATIONS)
+    size_t site = lookup_site(file, line, function);
+    if (site == SIZE_MAX
+        || (table_needs_growth(allocations.count, allocations.capacity) && !grow_records()))
     {
-        allocations[allocation_count].ptr = ptr;
-        allocations[allocation_count].size = size;
-        allocations[allocation_count].file = file;
-        allocations[allocation_count].line = line;
-        allocations[allocation_count].function = function;
-        allocation_count++;
+        return ptr;  // Tracker is out of memory, hand out the block untracked
     }
 
+    size_t mask = allocations.capacity - 1;
+    size_t slot = hash_pointer(ptr) & mask;
+    while (allocations.records[slot].ptr != NULL)
+    {
+        slot = (slot + 1) & mask;
+    }
+    allocations.records[slot] = (AllocationRecord) {ptr, size, site};
+    allocations.count++;
+
+    allocations.sites[site].live_bytes += size;
+    allocations.sites[site].live_count++;
+
     return ptr;
 }
 
+// Remove the record in slot, shifting later entries of its probe run back
+void remove_record(size_t slot)
+{
+    size_t mask = allocations.capacity - 1;
+    size_t hole = slot;
+
+    for (size_t next = (hole + 1) & mask; allocations.records[next].ptr != NULL; next = (next + 1) & mask)
+    {
+        size_t home = hash_pointer(allocations.records[next].ptr) & mask;
+
+        // Move the entry only if the hole lies between its home and its slot
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            allocations.records[hole] = allocations.records[next];
+            hole = next;
+        }
+    }
+
+    allocations.records[hole].ptr = NULL;
+    allocations.count--;
+}
+
 void track_free(void *ptr, const char *file, int line, const char *function)
 {
     if (ptr == NULL) return;
 
     // Find the allocation record
     int found = 0;
-    for (int i = 0; i < allocation_count; i++)
+    if (allocations.capacity > 0)
     {
-        if (allocations[i].ptr == ptr)
+        size_t mask = allocations.capacity - 1;
+        for (size_t slot = hash_pointer(ptr) & mask; allocations.records[slot].ptr != NULL; slot = (slot + 1) & mask)
         {
-            // Remove by swapping with the last element
-            allocations[i] = allocations[allocation_count - 1];
-            allocation_count--;
-            found = 1;
-            break;
+            AllocationRecord *record = &allocations.records[slot];
+            if (record->ptr == ptr)
+            {
+                allocations.sites[record->site].live_bytes -= record->size;
+                allocations.sites[record->site].live_count--;
+                remove_record(slot);
+                found = 1;
+                break;
+            }
         }
     }
 
@@ -76,29 +239,61 @@ void print_leak_report(void)
 {
     printf("\n=== Memory Leak Report ===\n");
 
-    if (allocation_count == 0)
+    if (allocations.count == 0)
     {
         printf("No memory leaks detected!\n");
+        return;
     }
-    else
-    {
-        printf("Detected %d memory leaks:\n", allocation_count);
 
-        size_t total_bytes = 0;
-        for (int i = 0; i < allocation_count; i++)
-        {
-            printf("%d) %p: %zu bytes allocated at %s:%d (%s)\n",
-                   i + 1,
-                   allocations[i].ptr,
-                   allocations[i].size,
-                   allocations[i].file,
-                   allocations[i].line,
-                   allocations[i].function);
-            total_bytes += allocations[i].size;
-        }
+    printf("Detected %zu memory leaks:\n", allocations.count);
+
+    // Per-site totals are maintained incrementally, so this is O(sites)
+    size_t total_bytes = 0;
+    for (size_t i = 0; i < allocations.site_count; i++)
+    {
+        AllocationSite *site = &allocations.sites[i];
+        if (site->live_count == 0) continue;
+
+        printf("%s:%d (%s): %zu bytes in %zu allocation(s)\n",
+               site->file,
+               site->line,
+               site->function,
+               site->live_bytes,
+               site->live_count);
+        total_bytes += site->live_bytes;
+    }
 
-        printf("\nTotal leaked memory: %zu bytes\n", total_bytes);
+    // Individual leaks, capped so huge processes stay readable
+    size_t shown = 0;
+    for (size_t i = 0; i < allocations.capacity && shown < MAX_LEAK_DETAILS; i++)
+    {
+        AllocationRecord *record = &allocations.records[i];
+        if (record->ptr == NULL) continue;
+
+        AllocationSite *site = &allocations.sites[record->site];
+        printf("%zu) %p: %zu bytes allocated at %s:%d (%s)\n",
+               ++shown,
+               record->ptr,
+               record->size,
+               site->file,
+               site->line,
+               site->function);
     }
+    if (shown < allocations.count)
+    {
+        printf("... and %zu more\n", allocations.count - shown);
+    }
+
+    printf("\nTotal leaked memory: %zu bytes\n", total_bytes);
+}
+
+// Release the tracker's own tables
+void free_allocation_table(void)
+{
+    free(allocations.records);
+    free(allocations.sites);
+    free(allocations.site_index);
+    allocations = (AllocationTable) {0};
 }
 
 // Common types of memory issues
@@ -223,6 +418,32 @@ void demonstrate_null_pointer_dereference(void)
     }
 }
 
+void demonstrate_many_allocations(void)
+{
+    printf("\n--- Tracking Many Allocations ---\n");
+
+    enum { COUNT = 100000 };
+    void **blocks = malloc(COUNT * sizeof(void *));
+    if (blocks == NULL) return;
+
+    for (int i = 0; i < COUNT; i++)
+    {
+        blocks[i] = DEBUG_MALLOC(16 + i % 64);
+    }
+    printf("Tracking %zu live allocations in a table of %zu slots\n",
+           allocations.count,
+           allocations.capacity);
+
+    // Free in a scattered order to exercise hash table deletion
+    for (int i = 0; i < COUNT; i++)
+    {
+        DEBUG_FREE(blocks[(i * 7919) % COUNT]);
+    }
+    printf("After freeing them all: %zu live allocations\n", allocations.count);
+
+    free(blocks);
+}
+
 int main(void)
 {
     printf("==== MEMORY LEAKS AND DEBUGGING ====\n\n");
@@ -233,9 +454,11 @@ int main(void)
     demonstrate_use_after_free();
     demonstrate_memory_corruption();
     demonstrate_null_pointer_dereference();
+    demonstrate_many_allocations();
 
     // Print memory leak report
     print_leak_report();
+    free_allocation_table();
 
     return 0;
 }
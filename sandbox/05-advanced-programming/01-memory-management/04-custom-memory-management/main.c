@@ -1,8 +1,30 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+// The practices/007 memory manager, benchmarked alongside this chapter's
+// allocators
+#include "../../../practices/007-memory-manager/memory_manager.h"
+
+// Build with -DSCOPE_TRACE to record chunk growth and benchmark phases as
+// a timeline in allocator_trace.json
+#include "../../scope_trace.h"
+
+#include "../../../bench/bench_report.h"
 
 // Simple memory pool implementation
 #define POOL_SIZE 1024
@@ -98,6 +120,208 @@ void stack_allocator_destroy(StackAllocator *stack)
     stack->used = 0;
 }
 
+// Growable arena: a chain of chunks, each twice the size of the last
+#define ARENA_MAX_CHUNK       (64 * 1024 * 1024)
+#define ARENA_HUGE_PAGE_SIZE  (2 * 1024 * 1024)
+#define ARENA_DEFAULT_ALIGN   _Alignof(max_align_t)
+#define ARENA_FLAG_HUGE_PAGES 0x1  // Map chunks >= 2 MiB with huge pages
+
+typedef struct ArenaChunk
+{
+    struct ArenaChunk *prev;  // Older chunk in the chain, or next free one
+    size_t capacity;          // Usable bytes in data
+    size_t used;
+    size_t mapped_size;  // Non-zero if the chunk came from mmap
+    _Alignas(max_align_t) unsigned char data[];
+} ArenaChunk;
+
+typedef struct
+{
+    ArenaChunk *current;  // Chunk being allocated from
+    ArenaChunk *free_chunks;  // Released chunks, reused before malloc
+    ArenaChunk *first;    // Survives arena_reset
+    int flags;
+} Arena;
+
+// Position in an arena that can be rolled back to, even across chunks
+typedef struct
+{
+    ArenaChunk *chunk;
+    size_t used;
+} ArenaMarker;
+
+// Get a chunk with at least capacity usable bytes
+static ArenaChunk *arena_chunk_create(size_t capacity, int flags)
+{
+    TRACE_FUNCTION();
+    size_t total = sizeof(ArenaChunk) + capacity;
+    ArenaChunk *chunk = NULL;
+    size_t mapped_size = 0;
+
+    if ((flags & ARENA_FLAG_HUGE_PAGES) && total >= ARENA_HUGE_PAGE_SIZE)
+    {
+        mapped_size = (total + ARENA_HUGE_PAGE_SIZE - 1) & ~(size_t) (ARENA_HUGE_PAGE_SIZE - 1);
+        void *mem = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        // Explicit huge pages only work if the system has some reserved
+        mem = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+        if (mem == MAP_FAILED)
+        {
+            mem = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+            // Fall back to asking for transparent huge pages
+            if (mem != MAP_FAILED) madvise(mem, mapped_size, MADV_HUGEPAGE);
+#endif
+        }
+        if (mem == MAP_FAILED) return NULL;
+        chunk = (ArenaChunk *) mem;
+        capacity = mapped_size - sizeof(ArenaChunk);
+    }
+    else
+    {
+        chunk = (ArenaChunk *) malloc(total);
+        if (!chunk) return NULL;
+    }
+
+    chunk->prev = NULL;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    chunk->mapped_size = mapped_size;
+    return chunk;
+}
+
+static void arena_chunk_destroy(ArenaChunk *chunk)
+{
+    if (chunk->mapped_size)
+    {
+        munmap(chunk, chunk->mapped_size);
+    }
+    else
+    {
+        free(chunk);
+    }
+}
+
+// Initialize arena with a first chunk of initial_size bytes
+int arena_init(Arena *arena, size_t initial_size, int flags)
+{
+    arena->flags = flags;
+    arena->free_chunks = NULL;
+    arena->first = arena_chunk_create(initial_size, flags);
+    arena->current = arena->first;
+    return arena->first != NULL;
+}
+
+// Released chunks stay on the free list until arena_destroy, so memory is
+// bounded by the arena's peak footprint and a workload that keeps growing
+// to the same size does no malloc calls after its first pass
+static void arena_release_chunk(Arena *arena, ArenaChunk *chunk)
+{
+    chunk->prev = arena->free_chunks;
+    arena->free_chunks = chunk;
+}
+
+// Take the smallest free chunk with at least capacity bytes, or NULL
+static ArenaChunk *arena_take_free_chunk(Arena *arena, size_t capacity)
+{
+    ArenaChunk **best = NULL;
+    for (ArenaChunk **link = &arena->free_chunks; *link; link = &(*link)->prev)
+    {
+        if ((*link)->capacity >= capacity && (!best || (*link)->capacity < (*best)->capacity))
+        {
+            best = link;
+        }
+    }
+    if (!best) return NULL;
+
+    ArenaChunk *chunk = *best;
+    *best = chunk->prev;
+    return chunk;
+}
+
+// Allocate size bytes aligned to align (a power of two)
+void *arena_alloc_aligned(Arena *arena, size_t size, size_t align)
+{
+    ArenaChunk *chunk = arena->current;
+    uintptr_t base = (uintptr_t) chunk->data;
+    size_t offset = ((base + chunk->used + align - 1) & ~(uintptr_t) (align - 1)) - base;
+
+    if (offset + size > chunk->capacity)
+    {
+        // Grow geometrically, but always enough for this request
+        size_t capacity = chunk->capacity * 2;
+        if (capacity > ARENA_MAX_CHUNK) capacity = ARENA_MAX_CHUNK;
+        if (capacity < size + align) capacity = size + align;
+
+        ArenaChunk *next = arena_take_free_chunk(arena, size + align);
+        if (!next)
+        {
+            next = arena_chunk_create(capacity, arena->flags);
+            if (!next) return NULL;
+        }
+
+        next->prev = chunk;
+        next->used = 0;
+        arena->current = chunk = next;
+        base = (uintptr_t) chunk->data;
+        offset = ((base + align - 1) & ~(uintptr_t) (align - 1)) - base;
+    }
+
+    chunk->used = offset + size;
+    return chunk->data + offset;
+}
+
+// Allocate with the default (max_align_t) alignment
+void *arena_alloc(Arena *arena, size_t size)
+{
+    return arena_alloc_aligned(arena, size, ARENA_DEFAULT_ALIGN);
+}
+
+// Create a marker for the current position
+ArenaMarker arena_get_marker(Arena *arena)
+{
+    ArenaMarker marker = {arena->current, arena->current->used};
+    return marker;
+}
+
+// Roll back to a previous marker, releasing chunks chained after it
+void arena_free_to_marker(Arena *arena, ArenaMarker marker)
+{
+    while (arena->current != marker.chunk && arena->current != arena->first)
+    {
+        ArenaChunk *chunk = arena->current;
+        arena->current = chunk->prev;
+        arena_release_chunk(arena, chunk);
+    }
+
+    if (marker.used <= arena->current->used)
+    {
+        arena->current->used = marker.used;
+    }
+}
+
+// Free everything but keep the first chunk for reuse
+void arena_reset(Arena *arena)
+{
+    ArenaMarker start = {arena->first, 0};
+    arena_free_to_marker(arena, start);
+}
+
+// Free every chunk
+void arena_destroy(Arena *arena)
+{
+    arena_reset(arena);
+    while (arena->free_chunks)
+    {
+        ArenaChunk *chunk = arena->free_chunks;
+        arena->free_chunks = chunk->prev;
+        arena_chunk_destroy(chunk);
+    }
+    arena_chunk_destroy(arena->first);
+    arena->first = arena->current = NULL;
+}
+
 // Block allocator for fixed-size objects
 typedef struct BlockNode
 {
@@ -140,6 +364,7 @@ int block_allocator_init(BlockAllocator *alloc,
 // Allocate a new chunk of memory
 int block_allocator_add_chunk(BlockAllocator *alloc)
 {
+    TRACE_FUNCTION();
     if (alloc->chunk_count >= alloc->max_chunks)
     {
         return 0;  // Too many chunks
@@ -210,6 +435,173 @@ void block_allocator_destroy(BlockAllocator *alloc)
     alloc->chunk_count = 0;
 }
 
+// Concurrent block allocator: the free list is a Treiber stack whose head
+// packs a 16-bit ABA tag above a 48-bit pointer (user-space addresses on
+// x86-64 and AArch64 fit in 48 bits), so a single 64-bit CAS suffices.
+#define TAGGED_PTR_BITS 48
+#define TAGGED_PTR_MASK ((UINT64_C(1) << TAGGED_PTR_BITS) - 1)
+
+typedef struct ConcurrentBlockNode
+{
+    _Atomic(struct ConcurrentBlockNode *) next;
+} ConcurrentBlockNode;
+
+typedef struct
+{
+    size_t block_size;
+    size_t blocks_per_chunk;
+    _Atomic uint64_t free_head;  // (tag << 48) | node pointer
+    void **chunks;
+    _Atomic size_t chunk_count;
+    size_t max_chunks;
+    pthread_mutex_t grow_lock;  // Serializes growth only, never allocation
+} ConcurrentBlockAllocator;
+
+static inline ConcurrentBlockNode *tagged_node(uint64_t head)
+{
+    return (ConcurrentBlockNode *) (uintptr_t) (head & TAGGED_PTR_MASK);
+}
+
+static inline uint64_t tagged_make(uint64_t old_head, ConcurrentBlockNode *node)
+{
+    uint64_t tag = (old_head >> TAGGED_PTR_BITS) + 1;
+    return (tag << TAGGED_PTR_BITS) | ((uint64_t) (uintptr_t) node & TAGGED_PTR_MASK);
+}
+
+// Push the list first..last onto the free stack with one CAS
+static void concurrent_push_list(ConcurrentBlockAllocator *alloc,
+                                 ConcurrentBlockNode *first,
+                                 ConcurrentBlockNode *last)
+{
+    uint64_t old = atomic_load_explicit(&alloc->free_head, memory_order_relaxed);
+    do
+    {
+        atomic_store_explicit(&last->next, tagged_node(old), memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(&alloc->free_head,
+                                                    &old,
+                                                    tagged_make(old, first),
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
+// Initialize concurrent block allocator
+int concurrent_block_allocator_init(ConcurrentBlockAllocator *alloc,
+                                    size_t block_size,
+                                    size_t blocks_per_chunk,
+                                    size_t max_chunks)
+{
+    if (block_size < sizeof(ConcurrentBlockNode))
+    {
+        block_size = sizeof(ConcurrentBlockNode);  // Minimum size
+    }
+    // Keep every block aligned for the atomic link
+    block_size = (block_size + _Alignof(ConcurrentBlockNode) - 1) & ~(_Alignof(ConcurrentBlockNode) - 1);
+
+    alloc->block_size = block_size;
+    alloc->blocks_per_chunk = blocks_per_chunk;
+    atomic_init(&alloc->free_head, 0);
+    atomic_init(&alloc->chunk_count, 0);
+    alloc->max_chunks = max_chunks;
+
+    alloc->chunks = (void **) malloc(max_chunks * sizeof(void *));
+    if (!alloc->chunks) return 0;
+
+    return pthread_mutex_init(&alloc->grow_lock, NULL) == 0;
+}
+
+// Allocate a new chunk; safe while other threads allocate and free
+int concurrent_block_allocator_add_chunk(ConcurrentBlockAllocator *alloc)
+{
+    TRACE_FUNCTION();
+    pthread_mutex_lock(&alloc->grow_lock);
+
+    size_t count = atomic_load_explicit(&alloc->chunk_count, memory_order_relaxed);
+    void *chunk = NULL;
+    if (count < alloc->max_chunks)
+    {
+        chunk = malloc(alloc->block_size * alloc->blocks_per_chunk);
+    }
+    if (!chunk)
+    {
+        pthread_mutex_unlock(&alloc->grow_lock);
+        return 0;  // Too many chunks or out of memory
+    }
+
+    alloc->chunks[count] = chunk;
+    atomic_store_explicit(&alloc->chunk_count, count + 1, memory_order_release);
+    pthread_mutex_unlock(&alloc->grow_lock);
+
+    // Link the chunk privately, then publish it in a single push
+    char *block = (char *) chunk;
+    for (size_t i = 0; i + 1 < alloc->blocks_per_chunk; i++)
+    {
+        ConcurrentBlockNode *node = (ConcurrentBlockNode *) block;
+        atomic_init(&node->next, (ConcurrentBlockNode *) (block + alloc->block_size));
+        block += alloc->block_size;
+    }
+    concurrent_push_list(alloc, (ConcurrentBlockNode *) chunk, (ConcurrentBlockNode *) block);
+
+    return 1;
+}
+
+// Allocate a block
+void *concurrent_block_alloc(ConcurrentBlockAllocator *alloc)
+{
+    uint64_t old = atomic_load_explicit(&alloc->free_head, memory_order_acquire);
+
+    for (;;)
+    {
+        ConcurrentBlockNode *node = tagged_node(old);
+        if (!node)
+        {
+            // If no free blocks, allocate a new chunk
+            if (!concurrent_block_allocator_add_chunk(alloc))
+            {
+                return NULL;
+            }
+            old = atomic_load_explicit(&alloc->free_head, memory_order_acquire);
+            continue;
+        }
+
+        // node may already be taken by another thread; chunks are never
+        // freed while in use, so the read is safe and the tag fails the CAS
+        ConcurrentBlockNode *next = atomic_load_explicit(&node->next, memory_order_relaxed);
+        if (atomic_compare_exchange_weak_explicit(&alloc->free_head,
+                                                  &old,
+                                                  tagged_make(old, next),
+                                                  memory_order_acquire,
+                                                  memory_order_acquire))
+        {
+            return node;
+        }
+    }
+}
+
+// Free a block
+void concurrent_block_free(ConcurrentBlockAllocator *alloc, void *ptr)
+{
+    if (!ptr) return;
+
+    ConcurrentBlockNode *node = (ConcurrentBlockNode *) ptr;
+    concurrent_push_list(alloc, node, node);
+}
+
+// Destroy concurrent block allocator; no other thread may be using it
+void concurrent_block_allocator_destroy(ConcurrentBlockAllocator *alloc)
+{
+    size_t count = atomic_load(&alloc->chunk_count);
+    for (size_t i = 0; i < count; i++)
+    {
+        free(alloc->chunks[i]);
+    }
+
+    free(alloc->chunks);
+    pthread_mutex_destroy(&alloc->grow_lock);
+    alloc->chunks = NULL;
+    atomic_store(&alloc->free_head, 0);
+    atomic_store(&alloc->chunk_count, 0);
+}
+
 // Function to demonstrate memory pool usage
 void memory_pool_example()
 {
@@ -327,6 +719,58 @@ void stack_allocator_example(void)
     stack_allocator_destroy(&stack);
 }
 
+// Function to demonstrate arena usage
+void arena_example(void)
+{
+    printf("\n=== Arena Example ===\n");
+
+    Arena arena;
+    if (!arena_init(&arena, 256, 0))
+    {
+        printf("Failed to initialize arena\n");
+        return;
+    }
+
+    // Cache-line aligned allocation
+    double *aligned = (double *) arena_alloc_aligned(&arena, 4 * sizeof(double), 64);
+    printf("64-byte aligned block at %p (offset %% 64 = %zu)\n",
+           (void *) aligned,
+           (size_t) ((uintptr_t) aligned % 64));
+
+    // Simulate per-request scratch memory that outgrows the first chunk
+    for (int request = 0; request < 3; request++)
+    {
+        ArenaMarker marker = arena_get_marker(&arena);
+
+        int chunks = 1;
+        for (int i = 0; i < 40; i++)
+        {
+            ArenaChunk *before = arena.current;
+            char *scratch = (char *) arena_alloc(&arena, 100);
+            if (!scratch) break;
+            snprintf(scratch, 100, "request %d item %d", request, i);
+            if (arena.current != before) chunks++;
+        }
+        printf("Request %d used %d chunk(s), current chunk holds %zu bytes\n",
+               request,
+               chunks,
+               arena.current->capacity);
+
+        arena_free_to_marker(&arena, marker);
+    }
+
+    size_t free_bytes = 0;
+    for (ArenaChunk *chunk = arena.free_chunks; chunk; chunk = chunk->prev) free_bytes += chunk->capacity;
+    printf("After rollbacks: first chunk used %zu bytes, %zu bytes in free chunks\n",
+           arena.current->used,
+           free_bytes);
+
+    arena_reset(&arena);
+    printf("After reset: first chunk used %zu bytes\n", arena.current->used);
+
+    arena_destroy(&arena);
+}
+
 // Function to demonstrate block allocator usage
 void block_allocator_example(void)
 {
@@ -403,110 +847,772 @@ void block_allocator_example(void)
     block_allocator_destroy(&entity_allocator);
 }
 
-// Function to benchmark different allocation methods
-void benchmark_allocators(void)
+// Multi-threaded benchmark: every thread runs alloc/free bursts
+#define MT_BENCH_OPS   200000
+#define MT_BENCH_BURST 64
+#define MT_BENCH_SIZE  32
+
+typedef struct
+{
+    ConcurrentBlockAllocator *alloc;  // NULL benchmarks malloc/free
+    _Atomic long failed;              // Allocations that returned NULL
+} MtBenchArg;
+
+void *mt_bench_worker(void *arg)
+{
+    TRACE_FUNCTION();
+    MtBenchArg *bench = arg;
+    ConcurrentBlockAllocator *alloc = bench->alloc;
+    void *burst[MT_BENCH_BURST];
+    long failed = 0;
+
+    for (int op = 0; op < MT_BENCH_OPS; op += MT_BENCH_BURST)
+    {
+        for (int i = 0; i < MT_BENCH_BURST; i++)
+        {
+            burst[i] = alloc ? concurrent_block_alloc(alloc) : malloc(MT_BENCH_SIZE);
+            if (burst[i] == NULL)
+            {
+                failed++;
+                continue;
+            }
+            *(volatile char *) burst[i] = (char) i;
+        }
+        for (int i = 0; i < MT_BENCH_BURST; i++)
+        {
+            if (burst[i] == NULL) continue;
+            if (alloc)
+            {
+                concurrent_block_free(alloc, burst[i]);
+            }
+            else
+            {
+                free(burst[i]);
+            }
+        }
+    }
+    atomic_fetch_add_explicit(&bench->failed, failed, memory_order_relaxed);
+    return NULL;
+}
+
+// Run the workload on thread_count threads; returns million ops per second
+double run_mt_bench(ConcurrentBlockAllocator *alloc, int thread_count)
+{
+    pthread_t threads[16];
+    MtBenchArg arg = {.alloc = alloc};
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < thread_count; i++)
+    {
+        pthread_create(&threads[i], NULL, mt_bench_worker, &arg);
+    }
+    for (int i = 0; i < thread_count; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    long failed = atomic_load(&arg.failed);
+    if (failed > 0)
+    {
+        printf("Warning: %ld of %ld %s allocations failed\n",
+               failed,
+               (long) MT_BENCH_OPS * thread_count,
+               alloc ? "block" : "malloc");
+    }
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return (double) MT_BENCH_OPS * thread_count / seconds / 1e6;
+}
+
+void benchmark_allocators_multithreaded(void)
+{
+    printf("\n=== Multi-threaded Allocator Benchmark ===\n");
+    printf("%d alloc/free pairs of %d bytes per thread, bursts of %d\n",
+           MT_BENCH_OPS,
+           MT_BENCH_SIZE,
+           MT_BENCH_BURST);
+    printf("%-8s %14s %14s %10s\n", "threads", "malloc Mops/s", "block Mops/s", "vs malloc");
+
+    // BENCH_THREADS caps the sweep
+    const int thread_counts[] = {1, 2, 4, 8, 16};
+    const long max_threads = bench_param("THREADS", 16);
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]) && thread_counts[t] <= max_threads; t++)
+    {
+        ConcurrentBlockAllocator alloc;
+        if (!concurrent_block_allocator_init(&alloc, MT_BENCH_SIZE, 1024, 64))
+        {
+            printf("Failed to initialize concurrent block allocator\n");
+            return;
+        }
+
+        double malloc_rate = run_mt_bench(NULL, thread_counts[t]);
+        double block_rate = run_mt_bench(&alloc, thread_counts[t]);
+        printf("%-8d %14.2f %14.2f %9.2fx\n",
+               thread_counts[t],
+               malloc_rate,
+               block_rate,
+               block_rate / malloc_rate);
+
+        char name[32];
+        snprintf(name, sizeof(name), "mt_malloc_%dt", thread_counts[t]);
+        bench_report(name, malloc_rate, "Mops/s", BENCH_HIGHER_IS_BETTER);
+        snprintf(name, sizeof(name), "mt_block_%dt", thread_counts[t]);
+        bench_report(name, block_rate, "Mops/s", BENCH_HIGHER_IS_BETTER);
+
+        concurrent_block_allocator_destroy(&alloc);
+    }
+}
+
+// =================================================================
+// Allocator benchmark harness
+// =================================================================
+//
+// Runs every allocator in this chapter plus the practices/007 memory
+// manager and the system allocator through the same workloads and
+// reports ns/op percentiles, resident set size and cache misses.
+// Set ALLOC_BENCH_CSV=<path> to also write the results as CSV, and
+// ALLOC_BENCH_TRACE=<path> (one allocation size per line) to replace
+// the built-in size distribution with one taken from a real trace.
+
+#define BENCH_BATCH        16     // Operations timed together
+#define BENCH_OPS          200000
+#define BENCH_LIVE         4096   // Working set of the churn workload
+#define BENCH_FRAG_ROUNDS  8
+#define BENCH_FRAG_OBJECTS 20000
+#define BENCH_QUEUE_SIZE   1024   // Producer/consumer hand-off ring
+#define BENCH_MAX_SIZES    65536
+#define BENCH_BLOCK_SIZE   1024   // Fixed-size allocators serve up to this
+
+// Uniform interface over every allocator
+typedef struct
+{
+    const char *name;
+    void *(*create)(void);
+    void *(*alloc)(void *state, size_t size);
+    void (*free)(void *state, void *ptr);  // NULL: only bulk reset
+    void (*reset)(void *state);            // Drop everything at once
+    void (*thread_exit)(void *state);      // Per-thread teardown hook
+    void (*destroy)(void *state);
+    int thread_safe;
+    size_t max_size;  // Largest request it can serve; 0 for any size
+} BenchAllocator;
+
+typedef struct
+{
+    const char *allocator;
+    const char *workload;
+    int threads;
+    size_t ops;
+    double p50, p90, p99, max;  // ns per operation
+    long rss_delta_kb;          // RSS at end of run minus RSS at start
+    long peak_rss_delta_kb;     // Highest RSS seen minus RSS at start
+    long long cache_misses;     // -1 when counters are unavailable
+    size_t resets;              // Bulk resets of allocators without free
+    size_t failed;              // Allocations that returned NULL
+} BenchResult;
+
+// ---- Allocator adapters ----
+
+static void *bench_malloc_create(void) { return NULL; }
+static void *bench_malloc_alloc(void *state, size_t size)
+{
+    (void) state;
+    return malloc(size);
+}
+static void *bench_calloc_alloc(void *state, size_t size)
+{
+    (void) state;
+    return calloc(1, size);
+}
+static void bench_malloc_free(void *state, void *ptr)
+{
+    (void) state;
+    free(ptr);
+}
+static void bench_noop(void *state) { (void) state; }
+
+static void *bench_pool_create(void)
+{
+    MemoryPool *pool = malloc(sizeof(MemoryPool));
+    if (pool) pool_init(pool);
+    return pool;
+}
+static void *bench_pool_alloc(void *state, size_t size) { return pool_alloc(state, size); }
+static void bench_pool_reset(void *state) { pool_reset(state); }
+
+static void *bench_stack_create(void)
+{
+    StackAllocator *stack = malloc(sizeof(StackAllocator));
+    if (stack && !stack_allocator_init(stack, 1024 * 1024))
+    {
+        free(stack);
+        return NULL;
+    }
+    return stack;
+}
+static void *bench_stack_alloc(void *state, size_t size) { return stack_alloc(state, size); }
+static void bench_stack_reset(void *state) { stack_free_to_marker(state, 0); }
+static void bench_stack_destroy(void *state)
+{
+    stack_allocator_destroy(state);
+    free(state);
+}
+
+static void *bench_arena_create(void)
+{
+    Arena *arena = malloc(sizeof(Arena));
+    if (arena && !arena_init(arena, 64 * 1024, 0))
+    {
+        free(arena);
+        return NULL;
+    }
+    return arena;
+}
+static void *bench_arena_alloc(void *state, size_t size) { return arena_alloc(state, size); }
+static void bench_arena_reset(void *state) { arena_reset(state); }
+static void bench_arena_destroy(void *state)
+{
+    arena_destroy(state);
+    free(state);
+}
+
+static void *bench_block_create(void)
+{
+    BlockAllocator *block = malloc(sizeof(BlockAllocator));
+    if (block && !block_allocator_init(block, BENCH_BLOCK_SIZE, 1024, 4096))
+    {
+        free(block);
+        return NULL;
+    }
+    return block;
+}
+static void *bench_block_alloc(void *state, size_t size)
+{
+    return size <= BENCH_BLOCK_SIZE ? block_alloc(state) : NULL;
+}
+static void bench_block_free(void *state, void *ptr) { block_free(state, ptr); }
+static void bench_block_destroy(void *state)
+{
+    block_allocator_destroy(state);
+    free(state);
+}
+
+static void *bench_concurrent_create(void)
+{
+    ConcurrentBlockAllocator *block = malloc(sizeof(ConcurrentBlockAllocator));
+    if (block && !concurrent_block_allocator_init(block, BENCH_BLOCK_SIZE, 1024, 4096))
+    {
+        free(block);
+        return NULL;
+    }
+    return block;
+}
+static void *bench_concurrent_alloc(void *state, size_t size)
+{
+    return size <= BENCH_BLOCK_SIZE ? concurrent_block_alloc(state) : NULL;
+}
+static void bench_concurrent_free(void *state, void *ptr) { concurrent_block_free(state, ptr); }
+static void bench_concurrent_destroy(void *state)
+{
+    concurrent_block_allocator_destroy(state);
+    free(state);
+}
+
+static void *bench_manager_create(void)
+{
+    memory_manager_init();
+    memory_manager_enable_thread_cache();
+    return NULL;
+}
+static void *bench_manager_alloc(void *state, size_t size)
+{
+    (void) state;
+    return MM_ALLOC(size);
+}
+static void bench_manager_free(void *state, void *ptr)
+{
+    (void) state;
+    MM_FREE(ptr);
+}
+static void bench_manager_thread_exit(void *state)
+{
+    (void) state;
+    memory_thread_flush();
+}
+static void bench_manager_destroy(void *state)
+{
+    (void) state;
+    memory_manager_cleanup();
+}
+
+static const BenchAllocator bench_allocators[] = {
+    {"malloc", bench_malloc_create, bench_malloc_alloc, bench_malloc_free, NULL, bench_noop, bench_noop, 1, 0},
+    {"calloc", bench_malloc_create, bench_calloc_alloc, bench_malloc_free, NULL, bench_noop, bench_noop, 1, 0},
+    {"pool", bench_pool_create, bench_pool_alloc, NULL, bench_pool_reset, bench_noop, free, 0, POOL_SIZE},
+    {"stack", bench_stack_create, bench_stack_alloc, NULL, bench_stack_reset, bench_noop, bench_stack_destroy, 0, 0},
+    {"arena", bench_arena_create, bench_arena_alloc, NULL, bench_arena_reset, bench_noop, bench_arena_destroy, 0, 0},
+    {"block", bench_block_create, bench_block_alloc, bench_block_free, NULL, bench_noop, bench_block_destroy, 0, BENCH_BLOCK_SIZE},
+    {"block-mt", bench_concurrent_create, bench_concurrent_alloc, bench_concurrent_free, NULL, bench_noop, bench_concurrent_destroy, 1, BENCH_BLOCK_SIZE},
+    {"memory-manager", bench_manager_create, bench_manager_alloc, bench_manager_free, NULL, bench_manager_thread_exit, bench_manager_destroy, 1, 0},
+};
+
+// ---- Measurement helpers ----
+
+static double bench_now_ns(void)
 {
-    printf("\n=== Memory Allocator Benchmark ===\n");
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
 
-    const int num_allocations = 100000;
-    const size_t alloc_size = 32;  // Small allocations
-    const int iterations = 5;
+// Resident set size in KiB, or 0 where /proc is not available
+static long bench_rss_kb(void)
+{
+    long pages = 0, resident = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (!statm) return 0;
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(statm);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
 
-    clock_t start, end;
-    double malloc_time = 0, pool_time = 0, stack_time = 0, block_time = 0;
+// Open a cache-miss counter covering this thread and threads it creates
+static int bench_cache_counter_open(void)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    int fd = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
 
-    printf("Benchmarking %d allocations of %zu bytes...\n",
-           num_allocations,
-           alloc_size);
+static long long bench_cache_counter_close(int fd)
+{
+    long long count = -1;
+#ifdef __linux__
+    if (fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) != (ssize_t) sizeof(count)) count = -1;
+        close(fd);
+    }
+#else
+    (void) fd;
+#endif
+    return count;
+}
 
-    // Average over iterations
-    for (int iter = 0; iter < iterations; iter++)
+// Per-batch latency samples of one run
+typedef struct
+{
+    double *ns_per_op;
+    size_t count;
+    size_t capacity;
+    long rss_start;
+    long rss_peak;
+    size_t resets;
+    size_t failed;
+} BenchSamples;
+
+static void bench_record(BenchSamples *samples, double start_ns, int ops)
+{
+    if (samples->count < samples->capacity)
     {
-        // 1. Standard malloc/free
-        void *ptrs[num_allocations];
+        samples->ns_per_op[samples->count++] = (bench_now_ns() - start_ns) / ops;
+    }
+}
+
+static void bench_track_rss(BenchSamples *samples)
+{
+    long rss = bench_rss_kb();
+    if (rss > samples->rss_peak) samples->rss_peak = rss;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static double bench_percentile(const double *sorted, size_t count, double pct)
+{
+    if (count == 0) return 0;
+    size_t index = (size_t) (pct / 100.0 * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+// ---- Size distribution ----
+
+// Small-object heavy mix in the shape allocator traces usually show
+static const struct
+{
+    size_t size;
+    int weight;
+} bench_default_sizes[] = {
+    {8, 8}, {16, 22}, {24, 12}, {32, 16}, {48, 10}, {64, 9},
+    {96, 6}, {128, 6}, {256, 5}, {512, 3}, {1024, 2}, {4096, 1},
+};
 
-        start = clock();
-        for (int i = 0; i < num_allocations; i++)
+static size_t bench_sizes[BENCH_MAX_SIZES];
+static size_t bench_size_count;
+
+static void bench_load_sizes(void)
+{
+    const char *trace = getenv("ALLOC_BENCH_TRACE");
+    FILE *file = trace ? fopen(trace, "r") : NULL;
+
+    bench_size_count = 0;
+    if (file)
+    {
+        unsigned long size;
+        while (bench_size_count < BENCH_MAX_SIZES && fscanf(file, "%lu", &size) == 1)
         {
-            ptrs[i] = malloc(alloc_size);
+            if (size > 0) bench_sizes[bench_size_count++] = size;
         }
-        for (int i = 0; i < num_allocations; i++)
+        fclose(file);
+        printf("Loaded %zu sizes from %s\n", bench_size_count, trace);
+    }
+
+    // Expand the weighted table into 100 entries to sample uniformly
+    if (bench_size_count == 0)
+    {
+        for (size_t i = 0; i < sizeof(bench_default_sizes) / sizeof(bench_default_sizes[0]); i++)
         {
-            free(ptrs[i]);
+            for (int w = 0; w < bench_default_sizes[i].weight; w++)
+            {
+                bench_sizes[bench_size_count++] = bench_default_sizes[i].size;
+            }
         }
-        end = clock();
-        malloc_time += ((double) (end - start)) / CLOCKS_PER_SEC;
+    }
+}
+
+static size_t bench_next_size(unsigned int *seed)
+{
+    return bench_sizes[rand_r(seed) % bench_size_count];
+}
+
+// Requests larger than an allocator can serve are clamped to its maximum,
+// so fixed-size allocators do real work on every operation instead of
+// timing an immediate NULL
+static size_t bench_request_size(const BenchAllocator *a, size_t size)
+{
+    return a->max_size && size > a->max_size ? a->max_size : size;
+}
+
+// Allocate, resetting bulk-only allocators when they are full; failures
+// are counted so they never pass for fast allocations
+static void *bench_alloc(const BenchAllocator *a, void *state, size_t size, BenchSamples *samples, void **live, size_t live_count)
+{
+    size = bench_request_size(a, size);
+    void *ptr = a->alloc(state, size);
+    if (!ptr && a->reset)
+    {
+        a->reset(state);
+        memset(live, 0, live_count * sizeof(void *));
+        samples->resets++;
+        ptr = a->alloc(state, size);
+    }
+    if (ptr)
+    {
+        *(volatile char *) ptr = 1;
+    }
+    else
+    {
+        samples->failed++;
+    }
+    return ptr;
+}
+
+// ---- Workloads ----
 
-        // 2. Memory Pool
-        MemoryPool pool;
-        pool_init(&pool);
+// Replace random members of a live working set
+static void workload_churn(const BenchAllocator *a, void *state, BenchSamples *samples)
+{
+    TRACE_FUNCTION();
+    void **live = calloc(BENCH_LIVE, sizeof(void *));
+    unsigned int seed = 42;
+    if (!live) return;
 
-        start = clock();
-        for (int i = 0; i < num_allocations && i * alloc_size < POOL_SIZE; i++)
+    for (size_t op = 0; op < BENCH_OPS; op += BENCH_BATCH)
+    {
+        double start = bench_now_ns();
+        for (int k = 0; k < BENCH_BATCH; k++)
         {
-            pool_alloc(&pool, alloc_size);
+            size_t slot = rand_r(&seed) % BENCH_LIVE;
+            if (live[slot] && a->free) a->free(state, live[slot]);
+            live[slot] = bench_alloc(a, state, bench_next_size(&seed), samples, live, BENCH_LIVE);
         }
-        pool_reset(&pool);  // Reset instead of individual frees
-        end = clock();
-        pool_time += ((double) (end - start)) / CLOCKS_PER_SEC;
+        bench_record(samples, start, BENCH_BATCH);
+        if (op % (BENCH_OPS / 16) == 0) bench_track_rss(samples);
+    }
 
-        // 3. Stack Allocator
-        StackAllocator stack;
-        if (stack_allocator_init(&stack, num_allocations * alloc_size))
+    for (size_t i = 0; i < BENCH_LIVE && a->free; i++)
+    {
+        if (live[i]) a->free(state, live[i]);
+    }
+    free(live);
+}
+
+// Repeatedly free a random half and refill with larger objects
+static void workload_fragmentation(const BenchAllocator *a, void *state, BenchSamples *samples)
+{
+    TRACE_FUNCTION();
+    void **live = calloc(BENCH_FRAG_OBJECTS, sizeof(void *));
+    unsigned int seed = 7;
+    if (!live) return;
+
+    for (int round = 0; round < BENCH_FRAG_ROUNDS; round++)
+    {
+        size_t scale = 1 + round % 4;  // Sizes drift upward, then wrap
+
+        for (size_t i = 0; i < BENCH_FRAG_OBJECTS; i += BENCH_BATCH)
         {
-            start = clock();
-            for (int i = 0; i < num_allocations; i++)
+            double start = bench_now_ns();
+            for (size_t k = i; k < i + BENCH_BATCH && k < BENCH_FRAG_OBJECTS; k++)
             {
-                stack_alloc(&stack, alloc_size);
+                if (live[k] && (rand_r(&seed) & 1) == 0)
+                {
+                    if (a->free) a->free(state, live[k]);
+                    live[k] = NULL;
+                }
+                if (!live[k])
+                {
+                    live[k] = bench_alloc(a, state, bench_next_size(&seed) * scale, samples, live, BENCH_FRAG_OBJECTS);
+                }
             }
-            stack_allocator_destroy(&stack);
-            end = clock();
-            stack_time += ((double) (end - start)) / CLOCKS_PER_SEC;
+            bench_record(samples, start, BENCH_BATCH);
+        }
+        bench_track_rss(samples);
+    }
+
+    for (size_t i = 0; i < BENCH_FRAG_OBJECTS && a->free; i++)
+    {
+        if (live[i]) a->free(state, live[i]);
+    }
+    free(live);
+}
+
+// Single-producer single-consumer ring; the consumer frees what it gets
+typedef struct
+{
+    const BenchAllocator *allocator;
+    void *state;
+    void *slots[BENCH_QUEUE_SIZE];
+    _Atomic size_t head;
+    _Atomic size_t tail;
+} BenchQueue;
+
+static void *bench_consumer(void *arg)
+{
+    TRACE_FUNCTION();
+    BenchQueue *queue = arg;
+    size_t received = 0;
+
+    while (received < BENCH_OPS)
+    {
+        size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        if (tail == atomic_load_explicit(&queue->head, memory_order_acquire))
+        {
+            sched_yield();
+            continue;
         }
+        void *ptr = queue->slots[tail % BENCH_QUEUE_SIZE];
+        atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+        if (ptr) queue->allocator->free(queue->state, ptr);
+        received++;
+    }
 
-        // 4. Block Allocator
-        BlockAllocator block;
-        if (block_allocator_init(&block, alloc_size, num_allocations / 10, 10))
+    queue->allocator->thread_exit(queue->state);
+    return NULL;
+}
+
+// Objects allocated on one thread and freed on another
+static void workload_producer_consumer(const BenchAllocator *a, void *state, BenchSamples *samples)
+{
+    TRACE_FUNCTION();
+    BenchQueue *queue = calloc(1, sizeof(BenchQueue));
+    pthread_t consumer;
+    unsigned int seed = 99;
+    if (!queue) return;
+
+    queue->allocator = a;
+    queue->state = state;
+    pthread_create(&consumer, NULL, bench_consumer, queue);
+
+    for (size_t op = 0; op < BENCH_OPS; op += BENCH_BATCH)
+    {
+        double start = bench_now_ns();
+        for (int k = 0; k < BENCH_BATCH; k++)
         {
-            start = clock();
-            for (int i = 0; i < num_allocations; i++)
+            void *ptr = a->alloc(state, bench_request_size(a, bench_next_size(&seed)));
+            if (ptr)
+            {
+                *(volatile char *) ptr = 1;
+            }
+            else
+            {
+                samples->failed++;
+            }
+            size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+            while (head - atomic_load_explicit(&queue->tail, memory_order_acquire) == BENCH_QUEUE_SIZE)
             {
-                void *ptr = block_alloc(&block);
-                if (!ptr) break;
+                sched_yield();
             }
-            block_allocator_destroy(&block);
-            end = clock();
-            block_time += ((double) (end - start)) / CLOCKS_PER_SEC;
+            queue->slots[head % BENCH_QUEUE_SIZE] = ptr;
+            atomic_store_explicit(&queue->head, head + 1, memory_order_release);
         }
+        bench_record(samples, start, BENCH_BATCH);
+        if (op % (BENCH_OPS / 16) == 0) bench_track_rss(samples);
+    }
+
+    pthread_join(consumer, NULL);
+    free(queue);
+}
+
+typedef struct
+{
+    const char *name;
+    void (*run)(const BenchAllocator *, void *, BenchSamples *);
+    int threads;
+    int needs_free;  // Needs individual frees from a thread-safe allocator
+} BenchWorkload;
+
+static const BenchWorkload bench_workloads[] = {
+    {"churn", workload_churn, 1, 0},
+    {"fragmentation", workload_fragmentation, 1, 0},
+    {"producer-consumer", workload_producer_consumer, 2, 1},
+};
+
+// Run one allocator through one workload
+static int bench_run(const BenchAllocator *a, const BenchWorkload *w, BenchResult *result)
+{
+    if (w->needs_free && (!a->thread_safe || !a->free)) return 0;
+
+    // One span per allocator, the workload's span nested inside it
+    TRACE_SCOPE(a->name);
+    void *state = a->create();
+    BenchSamples samples = {0};
+    samples.capacity = BENCH_FRAG_ROUNDS * BENCH_FRAG_OBJECTS / BENCH_BATCH + BENCH_OPS / BENCH_BATCH + 16;
+    samples.ns_per_op = malloc(samples.capacity * sizeof(double));
+    samples.rss_start = samples.rss_peak = bench_rss_kb();
+
+    int counter = bench_cache_counter_open();
+    w->run(a, state, &samples);
+    result->cache_misses = bench_cache_counter_close(counter);
+
+    bench_track_rss(&samples);
+    a->thread_exit(state);
+    result->rss_delta_kb = bench_rss_kb() - samples.rss_start;
+    a->destroy(state);
+
+    qsort(samples.ns_per_op, samples.count, sizeof(double), compare_doubles);
+    result->allocator = a->name;
+    result->workload = w->name;
+    result->threads = w->threads;
+    result->ops = samples.count * BENCH_BATCH;
+    result->p50 = bench_percentile(samples.ns_per_op, samples.count, 50);
+    result->p90 = bench_percentile(samples.ns_per_op, samples.count, 90);
+    result->p99 = bench_percentile(samples.ns_per_op, samples.count, 99);
+    result->max = samples.count ? samples.ns_per_op[samples.count - 1] : 0;
+    result->peak_rss_delta_kb = samples.rss_peak - samples.rss_start;
+    result->resets = samples.resets;
+    result->failed = samples.failed;
+
+    free(samples.ns_per_op);
+    return 1;
+}
+
+// Run every allocator through every workload
+void run_allocator_benchmarks(void)
+{
+    printf("\n=== Allocator Benchmark Harness ===\n");
+    bench_load_sizes();
+
+    const char *csv_path = getenv("ALLOC_BENCH_CSV");
+    FILE *csv = csv_path ? fopen(csv_path, "w") : NULL;
+    if (csv)
+    {
+        fprintf(csv, "allocator,workload,threads,ops,p50_ns,p90_ns,p99_ns,max_ns,rss_delta_kb,peak_rss_delta_kb,cache_misses,resets,failed\n");
     }
 
-    // Average the results
-    malloc_time /= iterations;
-    pool_time /= iterations;
-    stack_time /= iterations;
-    block_time /= iterations;
+    printf("%-15s %-18s %7s %7s %7s %9s %9s %9s %12s %7s %7s\n",
+           "allocator", "workload", "p50", "p90", "p99", "max", "rss KiB", "peak KiB", "cache-miss", "resets", "failed");
+
+    for (size_t w = 0; w < sizeof(bench_workloads) / sizeof(bench_workloads[0]); w++)
+    {
+        for (size_t a = 0; a < sizeof(bench_allocators) / sizeof(bench_allocators[0]); a++)
+        {
+            BenchResult r;
+            if (!bench_run(&bench_allocators[a], &bench_workloads[w], &r)) continue;
+
+            char misses[24] = "n/a";
+            if (r.cache_misses >= 0) snprintf(misses, sizeof(misses), "%lld", r.cache_misses);
 
-    printf("\nAverage times over %d iterations:\n", iterations);
-    printf("malloc/free:      %.6f seconds\n", malloc_time);
-    printf("Memory Pool:      %.6f seconds (%.2fx vs malloc)\n",
-           pool_time,
-           malloc_time / pool_time);
-    printf("Stack Allocator:  %.6f seconds (%.2fx vs malloc)\n",
-           stack_time,
-           malloc_time / stack_time);
-    printf("Block Allocator:  %.6f seconds (%.2fx vs malloc)\n",
-           block_time,
-           malloc_time / block_time);
+            printf("%-15s %-18s %7.1f %7.1f %7.1f %9.1f %9ld %9ld %12s %7zu %7zu\n",
+                   r.allocator, r.workload, r.p50, r.p90, r.p99, r.max,
+                   r.rss_delta_kb, r.peak_rss_delta_kb, misses, r.resets, r.failed);
+            if (csv)
+            {
+                fprintf(csv, "%s,%s,%d,%zu,%.2f,%.2f,%.2f,%.2f,%ld,%ld,%lld,%zu,%zu\n",
+                        r.allocator, r.workload, r.threads, r.ops, r.p50, r.p90, r.p99, r.max,
+                        r.rss_delta_kb, r.peak_rss_delta_kb, r.cache_misses, r.resets, r.failed);
+            }
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s_%s_p50", r.allocator, r.workload);
+            bench_report(name, r.p50, "ns/op", BENCH_LOWER_IS_BETTER);
+        }
+    }
+
+    printf("(ns/op percentiles over batches of %d operations)\n", BENCH_BATCH);
+    for (size_t a = 0; a < sizeof(bench_allocators) / sizeof(bench_allocators[0]); a++)
+    {
+        if (bench_allocators[a].max_size)
+        {
+            printf("(%s serves at most %zu bytes; larger requests are clamped to that)\n",
+                   bench_allocators[a].name,
+                   bench_allocators[a].max_size);
+        }
+    }
+    if (csv)
+    {
+        fclose(csv);
+        printf("Results written to %s\n", csv_path);
+    }
 }
 
 int main(void)
 {
     printf("==== CUSTOM MEMORY MANAGEMENT ====\n\n");
+    scope_trace_thread_name("main");
+    bench_ready();
 
     memory_pool_example();
     stack_allocator_example();
+    arena_example();
     block_allocator_example();
-    benchmark_allocators();
+    run_allocator_benchmarks();
+    benchmark_allocators_multithreaded();
+
+    long spans = scope_trace_write_json("allocator_trace.json");
+    if (spans > 0) printf("\nWrote %ld spans to allocator_trace.json\n", spans);
 
     return 0;
 }
@@ -1,7 +1,15 @@
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#include "../../intern_pool.h"
 
 // ===== Reference Counting Example =====
 
@@ -59,134 +67,765 @@ void rc_release(RefCountedObject *obj)
     }
 }
 
+// ===== Thread-Safe Biased Reference Counting =====
+//
+// Most objects are only ever retained and released by the thread that
+// created them, so the count is split in two (biased reference counting):
+// the owner thread updates a plain biased count with no atomics, other
+// threads update an atomic shared count that may go negative. When the
+// owner drops its last biased reference, or when another thread drives
+// the shared count below zero, the two halves are merged and from then on
+// only the shared count is used. Objects whose count reaches zero are
+// destroyed in batches, and their shells are recycled by rc_mt_create.
+
+// Low bits of the shared word; the count lives in the bits above them
+#define RC_MERGED      0x1  // Biased count folded in, shared count is exact
+#define RC_QUEUED      0x2  // Waiting in the owner's merge queue
+#define RC_FLAG_BITS   2
+#define RC_ONE         ((intptr_t) 1 << RC_FLAG_BITS)
+#define RC_BATCH_SIZE  64  // Objects destroyed together
+#define RC_SPARE_COUNT 64  // Recycled object shells kept per thread
+
+typedef struct RcThread RcThread;
+
+typedef struct SharedRcObject
+{
+    char *data;
+    _Atomic(RcThread *) owner;     // NULL once merged
+    int biased_count;              // Only touched by the owner
+    _Atomic intptr_t shared;       // (count << 2) | flags
+    struct SharedRcObject *queue_next;   // Link in the owner's merge queue
+    struct SharedRcObject *owned_prev;   // Links in the owner's object list
+    struct SharedRcObject *owned_next;
+} SharedRcObject;
+
+struct RcThread
+{
+    _Atomic(SharedRcObject *) merge_queue;  // Pushed by other threads
+    SharedRcObject *owned;                  // Objects biased to this thread
+    SharedRcObject *batch[RC_BATCH_SIZE];   // Dead objects awaiting destruction
+    int batch_count;
+    SharedRcObject *spare[RC_SPARE_COUNT];  // Shells ready for reuse
+    int spare_count;
+};
+
+static _Thread_local RcThread rc_thread;
+
+static intptr_t rc_count(intptr_t word)
+{
+    return (word - (word & (RC_ONE - 1))) / RC_ONE;
+}
+
+// Destroy every object in this thread's batch
+void rc_mt_flush_batch(void)
+{
+    for (int i = 0; i < rc_thread.batch_count; i++)
+    {
+        SharedRcObject *obj = rc_thread.batch[i];
+        free(obj->data);
+        if (rc_thread.spare_count < RC_SPARE_COUNT)
+        {
+            rc_thread.spare[rc_thread.spare_count++] = obj;
+        }
+        else
+        {
+            free(obj);
+        }
+    }
+    rc_thread.batch_count = 0;
+}
+
+// Queue a dead object for batched destruction
+static void rc_mt_destroy(SharedRcObject *obj)
+{
+    rc_thread.batch[rc_thread.batch_count++] = obj;
+    if (rc_thread.batch_count == RC_BATCH_SIZE)
+    {
+        rc_mt_flush_batch();
+    }
+}
+
+// Create an object biased to the calling thread
+SharedRcObject *rc_mt_create(const char *data)
+{
+    SharedRcObject *obj = rc_thread.spare_count > 0
+                              ? rc_thread.spare[--rc_thread.spare_count]
+                              : (SharedRcObject *) malloc(sizeof(SharedRcObject));
+    if (!obj) return NULL;
+
+    obj->data = strdup(data);
+    if (!obj->data)
+    {
+        free(obj);
+        return NULL;
+    }
+
+    atomic_init(&obj->owner, &rc_thread);
+    obj->biased_count = 1;
+    atomic_init(&obj->shared, 0);
+    obj->queue_next = NULL;
+
+    // Track it so the owner can merge it when the thread exits
+    obj->owned_prev = NULL;
+    obj->owned_next = rc_thread.owned;
+    if (rc_thread.owned) rc_thread.owned->owned_prev = obj;
+    rc_thread.owned = obj;
+
+    return obj;
+}
+
+// Owner only: fold the biased count into the shared count. Returns the
+// shared word after merging.
+static intptr_t rc_mt_merge(SharedRcObject *obj, bool clear_queued)
+{
+    intptr_t old = atomic_load_explicit(&obj->shared, memory_order_relaxed);
+    intptr_t desired;
+    do
+    {
+        desired = (old + obj->biased_count * RC_ONE) | RC_MERGED;
+        if (clear_queued) desired &= ~(intptr_t) RC_QUEUED;
+    } while (!atomic_compare_exchange_weak_explicit(
+        &obj->shared, &old, desired, memory_order_acq_rel, memory_order_relaxed));
+
+    obj->biased_count = 0;
+    // Release pairs with the snapshot in rc_mt_release: a thread that sees
+    // NULL also sees RC_MERGED
+    atomic_store_explicit(&obj->owner, NULL, memory_order_release);
+
+    if (obj->owned_prev)
+    {
+        obj->owned_prev->owned_next = obj->owned_next;
+    }
+    else
+    {
+        rc_thread.owned = obj->owned_next;
+    }
+    if (obj->owned_next) obj->owned_next->owned_prev = obj->owned_prev;
+
+    return desired;
+}
+
+// Add a reference
+void rc_mt_add_ref(SharedRcObject *obj)
+{
+    if (atomic_load_explicit(&obj->owner, memory_order_relaxed) == &rc_thread)
+    {
+        obj->biased_count++;  // Fast path: no atomic instruction
+        return;
+    }
+    atomic_fetch_add_explicit(&obj->shared, RC_ONE, memory_order_relaxed);
+}
+
+// Release a reference
+void rc_mt_release(SharedRcObject *obj)
+{
+    // Snapshot before touching the count: once our CAS queues the object
+    // the owner may merge it and clear owner at any moment. The snapshot is
+    // the real owner whenever the CAS below finds the word unmerged.
+    RcThread *owner = atomic_load_explicit(&obj->owner, memory_order_acquire);
+    if (owner == &rc_thread)
+    {
+        if (--obj->biased_count > 0) return;
+
+        // Last biased reference: hand the object over to the shared count.
+        // A queued object is finished by rc_mt_poll instead.
+        intptr_t word = rc_mt_merge(obj, false);
+        if (rc_count(word) == 0 && !(word & RC_QUEUED)) rc_mt_destroy(obj);
+        return;
+    }
+
+    intptr_t old = atomic_load_explicit(&obj->shared, memory_order_relaxed);
+    intptr_t desired;
+    do
+    {
+        desired = old - RC_ONE;
+
+        // Going negative means the owner holds references we released:
+        // ask it to merge (once) so the object cannot leak
+        if (!(old & RC_MERGED) && rc_count(desired) < 0) desired |= RC_QUEUED;
+    } while (!atomic_compare_exchange_weak_explicit(
+        &obj->shared, &old, desired, memory_order_acq_rel, memory_order_relaxed));
+
+    if (old & RC_MERGED)
+    {
+        if (rc_count(desired) == 0 && !(desired & RC_QUEUED)) rc_mt_destroy(obj);
+    }
+    else if ((desired & RC_QUEUED) && !(old & RC_QUEUED))
+    {
+        SharedRcObject *head = atomic_load_explicit(&owner->merge_queue, memory_order_relaxed);
+        do
+        {
+            obj->queue_next = head;
+        } while (!atomic_compare_exchange_weak_explicit(
+            &owner->merge_queue, &head, obj, memory_order_release, memory_order_relaxed));
+    }
+}
+
+// Owner side: merge objects other threads queued; returns how many
+int rc_mt_poll(void)
+{
+    SharedRcObject *obj = atomic_exchange_explicit(&rc_thread.merge_queue, NULL, memory_order_acquire);
+    int processed = 0;
+
+    while (obj)
+    {
+        SharedRcObject *next = obj->queue_next;
+        intptr_t word;
+
+        if (atomic_load_explicit(&obj->owner, memory_order_relaxed) == &rc_thread)
+        {
+            word = rc_mt_merge(obj, true);
+        }
+        else
+        {
+            // Already merged by the owner's last release; just dequeue
+            word = atomic_fetch_and_explicit(&obj->shared, ~(intptr_t) RC_QUEUED, memory_order_acq_rel)
+                   & ~(intptr_t) RC_QUEUED;
+        }
+
+        if (rc_count(word) == 0) rc_mt_destroy(obj);
+        obj = next;
+        processed++;
+    }
+
+    return processed;
+}
+
+// Call before a thread exits: merge everything it still owns so other
+// threads can finish the objects without it
+void rc_mt_thread_exit(void)
+{
+    int pending = 0;
+
+    rc_mt_poll();
+    while (rc_thread.owned)
+    {
+        SharedRcObject *obj = rc_thread.owned;
+        intptr_t word = rc_mt_merge(obj, false);
+        if (word & RC_QUEUED)
+        {
+            pending++;  // A push to our queue is in flight
+        }
+        else if (rc_count(word) == 0)
+        {
+            rc_mt_destroy(obj);
+        }
+    }
+
+    // Queued objects stay alive until dequeued, so wait for the pushes
+    while (pending > 0)
+    {
+        pending -= rc_mt_poll();
+        if (pending > 0) sched_yield();
+    }
+
+    rc_mt_flush_batch();
+    for (int i = 0; i < rc_thread.spare_count; i++)
+    {
+        free(rc_thread.spare[i]);
+    }
+    rc_thread.spare_count = 0;
+}
+
+#define RC_DEMO_THREADS 4
+#define RC_DEMO_OPS     1000000
+
+static SharedRcObject *rc_demo_object;
+
+// Worker: retain/release the shared object, then drop the reference it was given
+void *rc_demo_worker(void *arg)
+{
+    (void) arg;
+    for (int i = 0; i < RC_DEMO_OPS; i++)
+    {
+        rc_mt_add_ref(rc_demo_object);
+        rc_mt_release(rc_demo_object);
+    }
+    rc_mt_release(rc_demo_object);
+    rc_mt_thread_exit();
+    return NULL;
+}
+
+void biased_refcount_demo(void)
+{
+    printf("\n=== Thread-Safe Biased Reference Counting Example ===\n");
+
+    rc_demo_object = rc_mt_create("shared between threads");
+
+    // One reference per worker, taken by the owner on the fast path
+    for (int i = 0; i < RC_DEMO_THREADS; i++)
+    {
+        rc_mt_add_ref(rc_demo_object);
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < RC_DEMO_OPS; i++)
+    {
+        rc_mt_add_ref(rc_demo_object);
+        rc_mt_release(rc_demo_object);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("Owner thread: %d retain/release pairs in %.2f ms (biased, non-atomic)\n",
+           RC_DEMO_OPS,
+           (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+
+    pthread_t threads[RC_DEMO_THREADS];
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < RC_DEMO_THREADS; i++)
+    {
+        pthread_create(&threads[i], NULL, rc_demo_worker, NULL);
+    }
+    for (int i = 0; i < RC_DEMO_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%d workers: %d pairs each in %.2f ms (shared, atomic)\n",
+           RC_DEMO_THREADS,
+           RC_DEMO_OPS,
+           (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+
+    // Workers released references the owner had taken: shared count is
+    // negative and the object is waiting in our merge queue
+    printf("Shared count before merge: %ld\n", (long) rc_count(atomic_load(&rc_demo_object->shared)));
+    printf("Queued merges processed: %d\n", rc_mt_poll());
+    printf("After merge: shared count %ld, biased count %d\n",
+           (long) rc_count(atomic_load(&rc_demo_object->shared)),
+           rc_demo_object->biased_count);
+
+    rc_mt_release(rc_demo_object);  // Last reference
+    rc_mt_thread_exit();
+    printf("Object destroyed in the owner's release batch\n");
+
+    // Burst release: many objects die together and are destroyed in batches
+    SharedRcObject *burst[1000];
+    for (int i = 0; i < 1000; i++)
+    {
+        burst[i] = rc_mt_create("burst");
+    }
+    for (int i = 0; i < 1000; i++)
+    {
+        rc_mt_release(burst[i]);
+    }
+    printf("Released 1000 objects: %d still awaiting batch destruction\n", rc_thread.batch_count);
+    rc_mt_thread_exit();
+}
+
 // ===== Mark and Sweep Example =====
+//
+// A generational, incremental collector. New objects start in a young
+// generation that is collected on its own (minor GC): only objects
+// reachable from the roots, from the remembered set, or from the major
+// collector's mark stack survive, and survivors are promoted to the old
+// generation. The old generation is collected by an incremental
+// tri-color mark-and-sweep (major GC) that does a bounded amount of work
+// per step, so pauses do not grow with the heap.
+
+// Tri-color marking states
+typedef enum
+{
+    GC_WHITE,  // Not reached yet (garbage if still white after marking)
+    GC_GRAY,   // Reached, children not scanned yet (on the mark stack)
+    GC_BLACK   // Reached and scanned
+} GcColor;
+
+// Object names are interned: thousands of objects share a handful of
+// names ("temp"), so each object holds a 4-byte id instead of a strdup
+// copy, and the strings are freed together when the demo ends
+static InternPool object_names = INTERN_POOL_INIT;
+
+#define object_name(obj) intern_str(&object_names, (obj)->name)
 
 // Simple object for mark-sweep demonstration
 typedef struct Object
 {
     int id;
-    char *name;
+    InternId name;
     struct Object **references;  // Objects this object refers to
     int ref_count;               // Number of references
-    bool marked;                 // Used during mark phase
+    int ref_capacity;            // Allocated slots in references
+    bool marked;                 // Used during minor (young) collections
+    GcColor color;               // Used during major (old) collections
+    bool old;                    // Promoted to the old generation
+    bool remembered;             // Old object in the remembered set
+    struct Object *next;         // Next object in the old generation list
 } Object;
 
-// Array to hold all objects for demonstration
-#define MAX_OBJECTS 100
-Object *all_objects[MAX_OBJECTS];
-int object_count = 0;
+// Growable array of object pointers, also used as a stack
+typedef struct
+{
+    Object **items;
+    int count;
+    int capacity;
+} ObjectStack;
+
+typedef enum
+{
+    GC_IDLE,
+    GC_MARKING,
+    GC_SWEEPING
+} GcPhase;
+
+// Young generation collection trigger, and work units per major GC step
+#define YOUNG_GEN_LIMIT 256
+#define GC_STEP_BUDGET  128
+
+// Heap state
+ObjectStack young_objects;   // Young generation
+Object *old_head = NULL;     // Old generation, singly linked
+Object *old_tail = NULL;
+int old_count = 0;
+int object_count = 0;        // Objects in both generations
+ObjectStack remembered_set;  // Old objects that point at young ones
+ObjectStack mark_stack;      // Gray objects of the major collector
+
+// Major collector state
+GcPhase gc_phase = GC_IDLE;
+Object **sweep_link = NULL;  // Link to the next object to sweep
+Object *sweep_prev = NULL;   // Object owning sweep_link, NULL at the head
+int major_threshold = YOUNG_GEN_LIMIT * 4;
+
+// Statistics
+int minor_collections = 0;
+int major_cycles = 0;
+bool gc_verbose = true;
 
 // Root objects are those directly accessible from the program
 #define MAX_ROOTS 10
 Object *root_objects[MAX_ROOTS];
 int root_count = 0;
 
-// Create an object for mark-sweep
-Object *create_object(int id, const char *name)
+// Push an object onto an ObjectStack
+bool stack_push(ObjectStack *stack, Object *obj)
 {
-    if (object_count >= MAX_OBJECTS) return NULL;
-
-    Object *obj = (Object *) malloc(sizeof(Object));
-    if (!obj) return NULL;
-
-    obj->id = id;
-    obj->name = strdup(name);
-    obj->references = (Object **) malloc(MAX_OBJECTS * sizeof(Object *));
-    obj->ref_count = 0;
-    obj->marked = false;
-
-    all_objects[object_count++] = obj;
-    printf("Created object %d: %s\n", id, name);
-    return obj;
+    if (stack->count == stack->capacity)
+    {
+        int capacity = stack->capacity ? stack->capacity * 2 : 64;
+        Object **items = (Object **) realloc(stack->items, capacity * sizeof(Object *));
+        if (!items) return false;
+        stack->items = items;
+        stack->capacity = capacity;
+    }
+    stack->items[stack->count++] = obj;
+    return true;
 }
 
-// Add a reference from one object to another
-void add_reference(Object *from, Object *to)
+// Gray an object for the major collector
+void shade(Object *obj)
 {
-    if (!from || !to || from->ref_count >= MAX_OBJECTS) return;
+    if (obj && obj->color == GC_WHITE)
+    {
+        obj->color = GC_GRAY;
+        stack_push(&mark_stack, obj);
+    }
+}
 
-    from->references[from->ref_count++] = to;
-    printf("Added reference from '%s' to '%s'\n", from->name, to->name);
+void free_object(Object *obj)
+{
+    if (gc_verbose)
+    {
+        printf("Sweeping (freeing) unmarked object %d: %s\n", obj->id, object_name(obj));
+    }
+    free(obj->references);
+    free(obj);
+    object_count--;
 }
 
-// Add an object to the root set
-void add_root(Object *obj)
+// Append an object to the old generation list
+void old_append(Object *obj)
 {
-    if (!obj || root_count >= MAX_ROOTS) return;
+    obj->old = true;
+    obj->next = NULL;
+    if (old_tail)
+    {
+        old_tail->next = obj;
+    }
+    else
+    {
+        old_head = obj;
+    }
+    old_tail = obj;
+    old_count++;
+}
 
-    root_objects[root_count++] = obj;
-    printf("Added '%s' to root set\n", obj->name);
+// Minor mark: mark a young object and queue it for scanning
+void mark_young(ObjectStack *work, Object *obj)
+{
+    if (obj && !obj->old && !obj->marked)
+    {
+        obj->marked = true;
+        stack_push(work, obj);
+    }
 }
 
-// Mark phase of mark-sweep algorithm
-void mark_object(Object *obj)
+// Collect the young generation; cost depends on young and remembered objects
+void minor_collect(void)
 {
-    if (!obj || obj->marked) return;
+    ObjectStack work = {0};
+
+    // Roots, old objects pointing into the young generation, and pending
+    // gray objects of an in-progress major marking all keep young objects alive
+    for (int i = 0; i < root_count; i++)
+    {
+        mark_young(&work, root_objects[i]);
+    }
+    for (int i = 0; i < remembered_set.count; i++)
+    {
+        Object *obj = remembered_set.items[i];
+        for (int j = 0; j < obj->ref_count; j++)
+        {
+            mark_young(&work, obj->references[j]);
+        }
+        obj->remembered = false;
+    }
+    for (int i = 0; i < mark_stack.count; i++)
+    {
+        mark_young(&work, mark_stack.items[i]);
+    }
+    remembered_set.count = 0;
 
-    obj->marked = true;
-    printf("Marked object %d: %s\n", obj->id, obj->name);
+    // Trace within the young generation using an explicit stack
+    while (work.count > 0)
+    {
+        Object *obj = work.items[--work.count];
+        for (int i = 0; i < obj->ref_count; i++)
+        {
+            mark_young(&work, obj->references[i]);
+        }
+    }
+    free(work.items);
 
-    // Mark all referenced objects recursively
-    for (int i = 0; i < obj->ref_count; i++)
+    // Free dead young objects and promote every survivor
+    for (int i = 0; i < young_objects.count; i++)
     {
-        mark_object(obj->references[i]);
+        Object *obj = young_objects.items[i];
+        if (!obj->marked)
+        {
+            free_object(obj);
+            continue;
+        }
+
+        obj->marked = false;
+        old_append(obj);
+
+        // Promoted objects must not be lost by an in-progress major cycle
+        if (gc_phase == GC_MARKING)
+        {
+            shade(obj);
+        }
+        else if (gc_phase == GC_SWEEPING)
+        {
+            obj->color = GC_BLACK;  // The sweep will reset it to white
+        }
+        else
+        {
+            obj->color = GC_WHITE;  // Drop any color left from the last cycle
+        }
     }
+    young_objects.count = 0;
+    minor_collections++;
 }
 
-// Mark phase starting from roots
-void mark_phase(void)
+// Begin an incremental major cycle
+void major_start(void)
 {
-    printf("\n--- Mark Phase ---\n");
+    gc_phase = GC_MARKING;
 
-    // Clear all marks
-    for (int i = 0; i < object_count; i++)
+    // Young objects may carry colors from the previous cycle
+    for (int i = 0; i < young_objects.count; i++)
     {
-        all_objects[i]->marked = false;
+        young_objects.items[i]->color = GC_WHITE;
     }
-
-    // Mark from roots
     for (int i = 0; i < root_count; i++)
     {
-        mark_object(root_objects[i]);
+        shade(root_objects[i]);
     }
 }
 
-// Sweep phase - free unmarked objects
-void sweep_phase(void)
+// Drop an object from the remembered set before it is freed
+void forget_remembered(Object *obj)
 {
-    printf("\n--- Sweep Phase ---\n");
+    for (int i = 0; i < remembered_set.count; i++)
+    {
+        if (remembered_set.items[i] == obj)
+        {
+            remembered_set.items[i] = remembered_set.items[--remembered_set.count];
+            return;
+        }
+    }
+}
 
-    int i = 0;
-    while (i < object_count)
+// Do up to budget units of major GC work; returns true when the cycle ends
+bool major_step(int budget)
+{
+    while (gc_phase == GC_MARKING && budget-- > 0)
     {
-        if (!all_objects[i]->marked)
+        if (mark_stack.count == 0)
+        {
+            // Everything reachable is black: start sweeping the old list
+            gc_phase = GC_SWEEPING;
+            sweep_link = &old_head;
+            sweep_prev = NULL;
+            break;
+        }
+
+        Object *obj = mark_stack.items[--mark_stack.count];
+        for (int i = 0; i < obj->ref_count; i++)
+        {
+            shade(obj->references[i]);
+        }
+        obj->color = GC_BLACK;
+        if (gc_verbose)
+        {
+            printf("Marked object %d: %s\n", obj->id, object_name(obj));
+        }
+    }
+
+    while (gc_phase == GC_SWEEPING && budget-- > 0)
+    {
+        Object *obj = *sweep_link;
+        if (!obj)
+        {
+            gc_phase = GC_IDLE;
+            major_cycles++;
+            major_threshold = old_count * 2 > YOUNG_GEN_LIMIT * 4 ? old_count * 2 : YOUNG_GEN_LIMIT * 4;
+            return true;
+        }
+
+        if (obj->color == GC_WHITE)
         {
-            printf("Sweeping (freeing) unmarked object %d: %s\n",
-                   all_objects[i]->id,
-                   all_objects[i]->name);
-
-            // Free the object
-            free(all_objects[i]->name);
-            free(all_objects[i]->references);
-            free(all_objects[i]);
-
-            // Remove from array by replacing with last object
-            all_objects[i] = all_objects[--object_count];
-            all_objects[object_count] = NULL;
+            *sweep_link = obj->next;
+            if (old_tail == obj) old_tail = sweep_prev;
+            if (obj->remembered) forget_remembered(obj);
+            old_count--;
+            free_object(obj);
         }
         else
         {
-            i++;
+            obj->color = GC_WHITE;  // Ready for the next cycle
+            sweep_prev = obj;
+            sweep_link = &obj->next;
         }
     }
+
+    return false;
+}
+
+// Allocation-driven pacing: bounded GC work on every allocation
+void gc_on_allocation(void)
+{
+    if (young_objects.count >= YOUNG_GEN_LIMIT)
+    {
+        minor_collect();
+    }
+
+    if (gc_phase != GC_IDLE)
+    {
+        major_step(GC_STEP_BUDGET);
+    }
+    else if (old_count >= major_threshold)
+    {
+        major_start();
+    }
+}
+
+// Create an object for mark-sweep
+Object *create_object(int id, const char *name)
+{
+    gc_on_allocation();
+
+    Object *obj = (Object *) calloc(1, sizeof(Object));
+    if (!obj) return NULL;
+
+    obj->id = id;
+    obj->name = intern_cstr(&object_names, name);
+    obj->color = GC_WHITE;
+
+    if (obj->name == INTERN_NONE || !stack_push(&young_objects, obj))
+    {
+        free(obj);
+        return NULL;
+    }
+
+    object_count++;
+    if (gc_verbose)
+    {
+        printf("Created object %d: %s\n", id, name);
+    }
+    return obj;
+}
+
+// Add a reference from one object to another
+void add_reference(Object *from, Object *to)
+{
+    if (!from || !to) return;
+
+    if (from->ref_count == from->ref_capacity)
+    {
+        int capacity = from->ref_capacity ? from->ref_capacity * 2 : 4;
+        Object **refs = (Object **) realloc(from->references, capacity * sizeof(Object *));
+        if (!refs) return;
+        from->references = refs;
+        from->ref_capacity = capacity;
+    }
+    from->references[from->ref_count++] = to;
+
+    // Write barrier (Dijkstra): a black object must never point to a white
+    // one, or the incremental marker would miss it
+    if (gc_phase == GC_MARKING && from->color == GC_BLACK)
+    {
+        shade(to);
+    }
+
+    // Generational barrier: remember old objects that point at young ones
+    if (from->old && !to->old && !from->remembered)
+    {
+        from->remembered = true;
+        stack_push(&remembered_set, from);
+    }
+
+    if (gc_verbose)
+    {
+        printf("Added reference from '%s' to '%s'\n", object_name(from), object_name(to));
+    }
+}
+
+// Add an object to the root set
+void add_root(Object *obj)
+{
+    if (!obj || root_count >= MAX_ROOTS) return;
+
+    root_objects[root_count++] = obj;
+
+    // New roots are shaded so an in-progress marking sees them
+    if (gc_phase == GC_MARKING)
+    {
+        shade(obj);
+    }
+
+    if (gc_verbose)
+    {
+        printf("Added '%s' to root set\n", object_name(obj));
+    }
 }
 
-// Run mark and sweep garbage collection
+// Run a full collection: finish any cycle in progress, then a fresh one
 void run_gc(void)
 {
     printf("\n=== Running Garbage Collection ===\n");
-    mark_phase();
-    sweep_phase();
+
+    minor_collect();
+    while (gc_phase != GC_IDLE)
+    {
+        major_step(INT_MAX);
+    }
+    major_start();
+    while (gc_phase != GC_IDLE)
+    {
+        major_step(INT_MAX);
+    }
+
     printf("Garbage collection complete. Remaining objects: %d\n",
            object_count);
 }
@@ -194,14 +833,91 @@ void run_gc(void)
 // Clean up all objects
 void cleanup_objects(void)
 {
-    for (int i = 0; i < object_count; i++)
+    for (int i = 0; i < young_objects.count; i++)
     {
-        free(all_objects[i]->name);
-        free(all_objects[i]->references);
-        free(all_objects[i]);
+        Object *obj = young_objects.items[i];
+        free(obj->references);
+        free(obj);
+    }
+    while (old_head)
+    {
+        Object *next = old_head->next;
+        free(old_head->references);
+        free(old_head);
+        old_head = next;
     }
+
+    free(young_objects.items);
+    free(remembered_set.items);
+    free(mark_stack.items);
+    young_objects = remembered_set = mark_stack = (ObjectStack) {0};
+    old_tail = NULL;
+    old_count = 0;
     object_count = 0;
     root_count = 0;
+    gc_phase = GC_IDLE;
+}
+
+double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// Build a deep live chain while churning short-lived garbage
+void incremental_gc_demo(void)
+{
+    printf("\n=== Incremental Generational GC Example ===\n");
+
+    const int chain_length = 200000;  // Would overflow a recursive marker
+    const int garbage_per_link = 4;
+    char name[32];
+    double max_pause = 0;
+
+    gc_verbose = false;
+    Object *head = create_object(0, "chain head");
+    add_root(head);
+
+    Object *tail = head;
+    for (int i = 1; i < chain_length; i++)
+    {
+        double start = now_ms();
+        snprintf(name, sizeof(name), "link %d", i);
+        Object *link = create_object(i, name);
+        double pause = now_ms() - start;
+        if (pause > max_pause) max_pause = pause;
+
+        add_reference(tail, link);
+        tail = link;
+
+        // Temporary objects that die young
+        for (int g = 0; g < garbage_per_link; g++)
+        {
+            create_object(-1, "temp");
+        }
+    }
+
+    printf("Live chain of %d objects, %d temporaries created\n",
+           chain_length,
+           (chain_length - 1) * garbage_per_link);
+    printf("Minor collections: %d, major cycles: %d, objects now: %d\n",
+           minor_collections,
+           major_cycles,
+           object_count);
+    printf("Longest allocation pause: %.3f ms\n", max_pause);
+    printf("Object names: %zu requested, %u distinct, %zu bytes of text\n",
+           object_names.requests,
+           object_names.count,
+           object_names.bytes);
+
+    // Drop the root: the whole chain becomes garbage
+    root_count = 0;
+    double start = now_ms();
+    run_gc();
+    printf("Full collection of the chain took %.3f ms\n", now_ms() - start);
+
+    gc_verbose = true;
 }
 
 int main(void)
@@ -222,6 +938,8 @@ int main(void)
     rc_release(str3);  // This will be freed (ref count = 0)
     rc_release(str2);  // Now this will be freed (ref count = 0)
 
+    biased_refcount_demo();
+
     printf("\n=== Mark-Sweep Example ===\n");
 
     // Create objects
@@ -255,5 +973,9 @@ int main(void)
     // Clean up
     cleanup_objects();
 
+    incremental_gc_demo();
+    cleanup_objects();
+    intern_free(&object_names);
+
     return 0;
 }
@@ -11,6 +11,18 @@
 
 #define DEBUG_LEVEL 2  // 0=none, 1=basic, 2=verbose
 
+// DEBUG_LEVEL picks the lowest log level that is compiled in: level 1
+// enables LOG_DEBUG, level 2 LOG_TRACE as well. Calls below it expand to
+// nothing, so they need no #if around them.
+#if DEBUG_LEVEL >= 2
+#define LOG_COMPILE_LEVEL LOG_LEVEL_TRACE
+#elif DEBUG_LEVEL >= 1
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#else
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#endif
+#include "../binlog.h"
+
 // Example of system-specific code using #if, #elif, #else
 void demo_platform_specific()
 {
@@ -92,23 +104,31 @@ void demo_debug_levels()
     printf("\n=== Debugging levels using #if ===\n");
 
     int value = 42;
+    (void) value;  // Only read by log calls, which may be compiled out
 
     printf("Current DEBUG_LEVEL: %d\n", DEBUG_LEVEL);
 
-// Basic tracing always included if any debug is enabled
-#if DEBUG_LEVEL >= 1
-    printf("DEBUG[1]: Function demo_debug_levels() called\n");
-    printf("DEBUG[1]: value = %d\n", value);
-#endif
+    // The log calls only record their arguments; the text is produced by
+    // binlog_decode below
+    static unsigned char storage[4096];
+    BinLog log;
+    binlog_init(&log, storage, sizeof(storage));
+    binlog_use(&log);
 
-// More verbose debugging
-#if DEBUG_LEVEL >= 2
-    printf("DEBUG[2]: Additional internal details...\n");
-    printf("DEBUG[2]: &value = %p\n", (void*) &value);
-#endif
+    // Basic tracing, compiled in if any debug is enabled
+    LOG_DEBUG("Function demo_debug_levels() called");
+    LOG_DEBUG("value = %d", value);
+
+    // More verbose debugging
+    LOG_TRACE("Additional internal details...");
+    LOG_TRACE("&value = %p", (void*) &value);
 
     // This code will always be compiled (not conditional)
     printf("Function execution completed\n");
+
+    binlog_use(NULL);
+    printf("%llu debug records:\n", (unsigned long long) log.records);
+    binlog_decode(log.data, log.used, stdout);
 }
 
 // Conditional compilation to handle compiler differences
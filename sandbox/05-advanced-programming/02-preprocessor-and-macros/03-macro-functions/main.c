@@ -2,6 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+// Scoped timers: compiled in here so the demo has something to show;
+// without SCOPE_TRACE the TRACE_* macros expand to nothing
+#define SCOPE_TRACE
+#include "../../scope_trace.h"
+
 // Simple macro function
 #define SQUARE(x) ((x) * (x))
 
@@ -118,15 +123,22 @@ void demo_do_while_macros()
 {
     printf("\n=== Using do-while(0) in Macros ===\n");
 
-    // Example without do-while
+    // Example without do-while: BAD_MACRO expands to two statements, so
+    // the if below ends after the first and the else has no if to attach
+    // to; x++ on a literal fails as well. The block is left out of the
+    // build so the rest of the file compiles; change it to #if 1 to see
+    // the errors.
 #define BAD_MACRO(x)          \
     printf("Value: %d\n", x); \
     x++
 
+#if 0
     if (1)
         BAD_MACRO(10);  // Works fine here
     else
         printf("This would cause syntax error if reached\n");
+#endif
+    printf("Without do-while(0): BAD_MACRO breaks if/else (see source)\n");
 
     // Example with do-while
 #define GOOD_MACRO(x)             \
@@ -177,6 +189,39 @@ void function_with_tracing()
     TRACE_EXIT();
 }
 
+// TRACE_EXIT has to be written before every return; a scoped timer
+// declared with __attribute__((cleanup)) ends itself however the block is
+// left, and records a timestamped span instead of printing
+static long traced_sum(const int *values, int count)
+{
+    TRACE_FUNCTION();
+    long sum = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (values[i] < 0) return -1;  // Span still ends here
+        sum += values[i];
+    }
+    return sum;
+}
+
+void function_with_scoped_timers()
+{
+    TRACE_FUNCTION();
+
+    int values[1000];
+    {
+        TRACE_SCOPE("fill");
+        for (int i = 0; i < 1000; i++) values[i] = i;
+    }
+    for (int round = 0; round < 3; round++)
+    {
+        TRACE_SCOPE("round");
+        printf("Round %d sum: %ld\n", round, traced_sum(values, 1000));
+    }
+    values[500] = -1;
+    printf("Sum with a negative value: %ld\n", traced_sum(values, 1000));
+}
+
 int main()
 {
     printf("==== MACRO FUNCTIONS ====\n\n");
@@ -189,5 +234,16 @@ int main()
     printf("\n=== Function Tracing with Macros ===\n");
     function_with_tracing();
 
+    printf("\n=== Scoped Timers with __attribute__((cleanup)) ===\n");
+    scope_trace_thread_name("main");
+    function_with_scoped_timers();
+
+    // Open in chrome://tracing or ui.perfetto.dev
+    long spans = scope_trace_write_json("macro_trace.json");
+    if (spans >= 0)
+    {
+        printf("Wrote %ld spans to macro_trace.json\n", spans);
+    }
+
     return 0;
 }
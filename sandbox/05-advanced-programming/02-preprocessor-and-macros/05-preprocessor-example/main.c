@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../../intern_pool.h"
+
 // ====================================================
 // Configuration section
 // ====================================================
@@ -112,25 +114,49 @@
 // Application code
 // ====================================================
 
+// Item names are interned: an item stores a 4-byte id instead of a
+// 50-byte array, and two items have the same name exactly when their ids
+// are equal
+static InternPool item_names = INTERN_POOL_INIT;
+
+#define ITEM_NAME(item) intern_str(&item_names, (item)->name)
+
 // Simple data structure
 typedef struct
 {
-    char name[50];
+    InternId name;
     int value;
 } Item;
 
 // Function prototypes
+Item item_make(const char* name, int value);
 Item* create_item(const char* name, int value);
 void print_version(void);
 
-// Function to create an item
-Item* create_item(const char* name, int value)
+// Function to create an item as a value: an Item is 8 bytes, so it is
+// returned in a register and never needs the allocator. The name is
+// INTERN_NONE if interning ran out of memory.
+Item item_make(const char* name, int value)
 {
     LOG_DEBUG("Creating item: %s with value: %d", name, value);
 
     // Validate inputs
     ASSERT(name != NULL, "Item name cannot be NULL");
-    ASSERT(strlen(name) < 50, "Item name too long");
+
+    Item item = (Item){.name = intern_cstr(&item_names, name), .value = value};
+    if (item.name == INTERN_NONE)
+    {
+        LOG_ERROR("Memory allocation failed");
+    }
+    return item;
+}
+
+// Function to create an item on the heap, for an item that must outlive
+// its creator: an explicit copy of item_make's value
+Item* create_item(const char* name, int value)
+{
+    Item made = item_make(name, value);
+    if (made.name == INTERN_NONE) return NULL;
 
     Item* item = ALLOC(Item, 1);
     if (!item)
@@ -138,10 +164,7 @@ Item* create_item(const char* name, int value)
         LOG_ERROR("Memory allocation failed");
         return NULL;
     }
-
-    strcpy(item->name, name);
-    item->value = value;
-
+    *item = made;
     return item;
 }
 
@@ -174,25 +197,25 @@ int main()
 
     LOG_DEBUG("Debug information visible in debug builds");
 
-    // Create some items
-    Item* items[3];
+    // Create some items: values in a local array, no allocation each
+    Item items[3];
     const char* names[] = {"Apple", "Banana", "Cherry"};
 
     for (int i = 0; i < 3; i++)
     {
-        items[i] = create_item(names[i], (i + 1) * 10);
-        if (items[i])
+        items[i] = item_make(names[i], (i + 1) * 10);
+        if (items[i].name != INTERN_NONE)
         {
             LOG_INFO("Created item %d: %s (value: %d)",
                      i,
-                     items[i]->name,
-                     items[i]->value);
+                     ITEM_NAME(&items[i]),
+                     items[i].value);
         }
     }
 
     // Show use of MAX/MIN macros
     printf("\nMaximum value: %d\n",
-           MAX(items[0]->value, MAX(items[1]->value, items[2]->value)));
+           MAX(items[0].value, MAX(items[1].value, items[2].value)));
 
     // Use repeat macro
     printf("\nRepeating message:\n");
@@ -206,12 +229,17 @@ int main()
     advanced_feature();
 #endif
 
-    // Clean up
-    for (int i = 0; i < 3; i++)
+    // An item kept past this scope goes to the heap explicitly
+    Item* kept = create_item("Date", 40);
+    if (kept)
     {
-        FREE(items[i]);
+        LOG_INFO("Heap item: %s (value: %d)", ITEM_NAME(kept), kept->value);
     }
 
+    // Clean up: only the escaped item was allocated
+    FREE(kept);
+    intern_free(&item_names);
+
     LOG_INFO("Application shutting down");
     return 0;
 }
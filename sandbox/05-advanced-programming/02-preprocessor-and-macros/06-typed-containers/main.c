@@ -0,0 +1,782 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ====================================================
+// Typed containers generated by macros
+// ====================================================
+//
+// A void * container (like practices/006-linked-list) stores a pointer to
+// a separate copy of each element and calls compare/print through function
+// pointers: an extra allocation and a pointer chase per element, and an
+// indirect call the compiler cannot inline per comparison.
+//
+// The DEFINE_* macros below instead stamp out a struct and a set of
+// static inline functions for one element type, the way a C++ template
+// would. Elements are stored by value, and the comparator/hash arguments
+// are macros or inline functions, so they are inlined at every use.
+//
+// Each DEFINE_* takes a Name used as the type name and as the prefix of
+// every function: DEFINE_VEC(IntVec, int) gives IntVec, IntVec_push, ...
+
+// ====================================================
+// Intrusive doubly linked list
+// ====================================================
+//
+// The link lives inside the element (struct Task { ...; ListLink link; }),
+// so the list never allocates and an element can be unlinked in O(1) from
+// a pointer to it. The list head is a sentinel: an empty list points at
+// itself, so no operation needs a NULL check.
+
+typedef struct ListLink
+{
+    struct ListLink *next;
+    struct ListLink *prev;
+} ListLink;
+
+// Pointer to the struct that contains *ptr as its member `member`
+#define CONTAINER_OF(ptr, type, member) \
+    ((type *) ((char *) (ptr) - offsetof(type, member)))
+
+// EQ(const T *a, const T *b) is true when a and b match for Name_find
+#define DEFINE_INTRUSIVE_LIST(Name, T, member, EQ)                       \
+    typedef struct                                                       \
+    {                                                                    \
+        ListLink head;                                                   \
+        size_t size;                                                     \
+    } Name;                                                              \
+                                                                         \
+    static inline void Name##_init(Name *list)                           \
+    {                                                                    \
+        list->head.next = list->head.prev = &list->head;                 \
+        list->size = 0;                                                  \
+    }                                                                    \
+                                                                         \
+    static inline void Name##_link_after(                                \
+        Name *list, ListLink *pos, T *item)                              \
+    {                                                                    \
+        ListLink *link = &item->member;                                  \
+        link->prev = pos;                                                \
+        link->next = pos->next;                                          \
+        pos->next->prev = link;                                          \
+        pos->next = link;                                                \
+        list->size++;                                                    \
+    }                                                                    \
+                                                                         \
+    static inline void Name##_push_front(Name *list, T *item)            \
+    {                                                                    \
+        Name##_link_after(list, &list->head, item);                      \
+    }                                                                    \
+                                                                         \
+    static inline void Name##_push_back(Name *list, T *item)             \
+    {                                                                    \
+        Name##_link_after(list, list->head.prev, item);                  \
+    }                                                                    \
+                                                                         \
+    /* O(1): item must currently be in list */                           \
+    static inline void Name##_remove(Name *list, T *item)                \
+    {                                                                    \
+        ListLink *link = &item->member;                                  \
+        link->prev->next = link->next;                                   \
+        link->next->prev = link->prev;                                   \
+        link->next = link->prev = link;                                  \
+        list->size--;                                                    \
+    }                                                                    \
+                                                                         \
+    /* First element, or NULL if the list is empty */                    \
+    static inline T *Name##_first(Name *list)                            \
+    {                                                                    \
+        return list->head.next == &list->head                            \
+                   ? NULL                                                \
+                   : CONTAINER_OF(list->head.next, T, member);           \
+    }                                                                    \
+                                                                         \
+    /* Element after item, or NULL at the end */                         \
+    static inline T *Name##_next(Name *list, T *item)                    \
+    {                                                                    \
+        return item->member.next == &list->head                          \
+                   ? NULL                                                \
+                   : CONTAINER_OF(item->member.next, T, member);         \
+    }                                                                    \
+                                                                         \
+    /* First element matching key by EQ, or NULL */                      \
+    static inline T *Name##_find(Name *list, const T *key)               \
+    {                                                                    \
+        for (ListLink *link = list->head.next; link != &list->head;      \
+             link = link->next)                                          \
+        {                                                                \
+            T *item = CONTAINER_OF(link, T, member);                     \
+            if (EQ(item, key)) return item;                              \
+        }                                                                \
+        return NULL;                                                     \
+    }
+
+// ====================================================
+// Dynamic array
+// ====================================================
+
+#define DEFINE_VEC(Name, T)                                                 \
+    typedef struct                                                          \
+    {                                                                       \
+        T *data;                                                            \
+        size_t size;                                                        \
+        size_t capacity;                                                    \
+    } Name;                                                                 \
+                                                                            \
+    static inline void Name##_init(Name *vec)                               \
+    {                                                                       \
+        vec->data = NULL;                                                   \
+        vec->size = vec->capacity = 0;                                      \
+    }                                                                       \
+                                                                            \
+    static inline void Name##_free(Name *vec)                               \
+    {                                                                       \
+        free(vec->data);                                                    \
+        Name##_init(vec);                                                   \
+    }                                                                       \
+                                                                            \
+    /* false (vec unchanged) if the allocation fails */                     \
+    static inline bool Name##_reserve(Name *vec, size_t capacity)           \
+    {                                                                       \
+        if (capacity <= vec->capacity) return true;                         \
+        T *data = (T *) realloc(vec->data, capacity * sizeof(T));           \
+        if (data == NULL) return false;                                     \
+        vec->data = data;                                                   \
+        vec->capacity = capacity;                                           \
+        return true;                                                        \
+    }                                                                       \
+                                                                            \
+    /* Amortized O(1): the capacity doubles when full */                    \
+    static inline bool Name##_push(Name *vec, T value)                      \
+    {                                                                       \
+        if (vec->size == vec->capacity                                      \
+            && !Name##_reserve(vec, vec->capacity ? vec->capacity * 2 : 8)) \
+        {                                                                   \
+            return false;                                                   \
+        }                                                                   \
+        vec->data[vec->size++] = value;                                     \
+        return true;                                                        \
+    }                                                                       \
+                                                                            \
+    /* Remove the last element into *out; false if empty */                 \
+    static inline bool Name##_pop(Name *vec, T *out)                        \
+    {                                                                       \
+        if (vec->size == 0) return false;                                   \
+        *out = vec->data[--vec->size];                                      \
+        return true;                                                        \
+    }                                                                       \
+                                                                            \
+    /* Unchecked, like an array subscript */                                \
+    static inline T *Name##_at(Name *vec, size_t i)                         \
+    {                                                                       \
+        return &vec->data[i];                                               \
+    }
+
+// ====================================================
+// Binary heap
+// ====================================================
+
+// LESS(a, b) orders the elements: the heap pops the element no other
+// element is LESS than first, so a < b gives a min-heap
+#define DEFINE_HEAP(Name, T, LESS)                                        \
+    DEFINE_VEC(Name##_storage, T)                                         \
+                                                                          \
+    typedef struct                                                        \
+    {                                                                     \
+        Name##_storage items;                                             \
+    } Name;                                                               \
+                                                                          \
+    static inline void Name##_init(Name *heap)                            \
+    {                                                                     \
+        Name##_storage_init(&heap->items);                                \
+    }                                                                     \
+                                                                          \
+    static inline void Name##_free(Name *heap)                            \
+    {                                                                     \
+        Name##_storage_free(&heap->items);                                \
+    }                                                                     \
+                                                                          \
+    static inline size_t Name##_size(const Name *heap)                    \
+    {                                                                     \
+        return heap->items.size;                                          \
+    }                                                                     \
+                                                                          \
+    static inline bool Name##_push(Name *heap, T value)                   \
+    {                                                                     \
+        if (!Name##_storage_push(&heap->items, value)) return false;      \
+                                                                          \
+        /* Sift up: move the hole, write value once at the end */         \
+        T *data = heap->items.data;                                       \
+        size_t i = heap->items.size - 1;                                  \
+        while (i > 0)                                                     \
+        {                                                                 \
+            size_t parent = (i - 1) / 2;                                  \
+            if (!LESS(value, data[parent])) break;                        \
+            data[i] = data[parent];                                       \
+            i = parent;                                                   \
+        }                                                                 \
+        data[i] = value;                                                  \
+        return true;                                                      \
+    }                                                                     \
+                                                                          \
+    /* Remove the top element into *out; false if empty */                \
+    static inline bool Name##_pop(Name *heap, T *out)                     \
+    {                                                                     \
+        if (heap->items.size == 0) return false;                          \
+                                                                          \
+        T *data = heap->items.data;                                       \
+        *out = data[0];                                                   \
+        T last = data[--heap->items.size];                                \
+        size_t n = heap->items.size;                                      \
+        size_t i = 0;                                                     \
+                                                                          \
+        /* Sift down from the root with the former last element */        \
+        for (;;)                                                          \
+        {                                                                 \
+            size_t child = 2 * i + 1;                                     \
+            if (child >= n) break;                                        \
+            if (child + 1 < n && LESS(data[child + 1], data[child]))      \
+            {                                                             \
+                child++;                                                  \
+            }                                                             \
+            if (!LESS(data[child], last)) break;                          \
+            data[i] = data[child];                                        \
+            i = child;                                                    \
+        }                                                                 \
+        if (n > 0) data[i] = last;                                        \
+        return true;                                                      \
+    }                                                                     \
+                                                                          \
+    /* Top element without removing it, or NULL if empty */               \
+    static inline const T *Name##_peek(const Name *heap)                  \
+    {                                                                     \
+        return heap->items.size ? &heap->items.data[0] : NULL;            \
+    }
+
+// ====================================================
+// Open-addressing hash map
+// ====================================================
+//
+// Linear probing over power-of-two arrays of keys and values, with a
+// separate occupancy byte per slot. Removal shifts later entries of the
+// probe run back (backward-shift deletion), so there are no tombstones and
+// lookups never slow down after many removals.
+
+#define HASHMAP_MIN_CAPACITY 16
+
+// HASH(K) returns a size_t (its low bits pick the slot, so it must mix
+// well), and EQ(K, K) compares keys
+#define DEFINE_HASHMAP(Name, K, V, HASH, EQ)                                  \
+    typedef struct                                                            \
+    {                                                                         \
+        K *keys;                                                              \
+        V *values;                                                            \
+        uint8_t *used;                                                        \
+        size_t size;                                                          \
+        size_t capacity; /* 0 or a power of two */                            \
+    } Name;                                                                   \
+                                                                              \
+    static inline void Name##_init(Name *map)                                 \
+    {                                                                         \
+        memset(map, 0, sizeof(*map));                                         \
+    }                                                                         \
+                                                                              \
+    static inline void Name##_free(Name *map)                                 \
+    {                                                                         \
+        free(map->keys);                                                      \
+        free(map->values);                                                    \
+        free(map->used);                                                      \
+        Name##_init(map);                                                     \
+    }                                                                         \
+                                                                              \
+    /* Slot holding key, or the empty slot that ends its probe run */         \
+    static inline size_t Name##_slot(const Name *map, K key)                  \
+    {                                                                         \
+        size_t mask = map->capacity - 1;                                      \
+        size_t i = HASH(key) & mask;                                          \
+        while (map->used[i] && !EQ(map->keys[i], key))                        \
+        {                                                                     \
+            i = (i + 1) & mask;                                               \
+        }                                                                     \
+        return i;                                                             \
+    }                                                                         \
+                                                                              \
+    static inline bool Name##_grow(Name *map)                                 \
+    {                                                                         \
+        size_t capacity =                                                     \
+            map->capacity ? map->capacity * 2 : HASHMAP_MIN_CAPACITY;         \
+        Name bigger = {(K *) malloc(capacity * sizeof(K)),                    \
+                       (V *) malloc(capacity * sizeof(V)),                    \
+                       (uint8_t *) calloc(capacity, 1),                       \
+                       map->size,                                             \
+                       capacity};                                             \
+        if (!bigger.keys || !bigger.values || !bigger.used)                   \
+        {                                                                     \
+            Name##_free(&bigger);                                             \
+            return false;                                                     \
+        }                                                                     \
+        for (size_t i = 0; i < map->capacity; i++)                            \
+        {                                                                     \
+            if (!map->used[i]) continue;                                      \
+            size_t slot = Name##_slot(&bigger, map->keys[i]);                 \
+            bigger.keys[slot] = map->keys[i];                                 \
+            bigger.values[slot] = map->values[i];                             \
+            bigger.used[slot] = 1;                                            \
+        }                                                                     \
+        Name##_free(map);                                                     \
+        *map = bigger;                                                        \
+        return true;                                                          \
+    }                                                                         \
+                                                                              \
+    /* Insert or overwrite; false only if growing the table fails */          \
+    static inline bool Name##_put(Name *map, K key, V value)                  \
+    {                                                                         \
+        /* Keep the load factor at or below 3/4 */                            \
+        if (4 * (map->size + 1) > 3 * map->capacity && !Name##_grow(map))     \
+        {                                                                     \
+            return false;                                                     \
+        }                                                                     \
+        size_t slot = Name##_slot(map, key);                                  \
+        if (!map->used[slot])                                                 \
+        {                                                                     \
+            map->keys[slot] = key;                                            \
+            map->used[slot] = 1;                                              \
+            map->size++;                                                      \
+        }                                                                     \
+        map->values[slot] = value;                                            \
+        return true;                                                          \
+    }                                                                         \
+                                                                              \
+    /* Pointer to key's value (valid until the next put), or NULL */          \
+    static inline V *Name##_get(const Name *map, K key)                       \
+    {                                                                         \
+        if (map->size == 0) return NULL;                                      \
+        size_t slot = Name##_slot(map, key);                                  \
+        return map->used[slot] ? &map->values[slot] : NULL;                   \
+    }                                                                         \
+                                                                              \
+    static inline bool Name##_remove(Name *map, K key)                        \
+    {                                                                         \
+        if (map->size == 0) return false;                                     \
+        size_t mask = map->capacity - 1;                                      \
+        size_t hole = Name##_slot(map, key);                                  \
+        if (!map->used[hole]) return false;                                   \
+                                                                              \
+        /* Pull back every later entry whose home slot is at or before */     \
+        /* the hole, so each stays reachable from its home */                 \
+        for (size_t i = (hole + 1) & mask; map->used[i]; i = (i + 1) & mask)  \
+        {                                                                     \
+            size_t home = HASH(map->keys[i]) & mask;                          \
+            if (((i - home) & mask) >= ((i - hole) & mask))                   \
+            {                                                                 \
+                map->keys[hole] = map->keys[i];                               \
+                map->values[hole] = map->values[i];                           \
+                hole = i;                                                     \
+            }                                                                 \
+        }                                                                     \
+        map->used[hole] = 0;                                                  \
+        map->size--;                                                          \
+        return true;                                                          \
+    }
+
+// ====================================================
+// Instantiations
+// ====================================================
+
+typedef struct
+{
+    int id;
+    int priority;
+    ListLink link;
+} Task;
+
+#define TASK_ID_EQ(a, b) ((a)->id == (b)->id)
+DEFINE_INTRUSIVE_LIST(TaskList, Task, link, TASK_ID_EQ)
+
+DEFINE_VEC(IntVec, int)
+
+#define INT_LESS(a, b) ((a) < (b))
+DEFINE_HEAP(IntHeap, int, INT_LESS)
+
+// Tasks by priority, highest first
+#define TASK_PRIORITY_LESS(a, b) ((a).priority > (b).priority)
+DEFINE_HEAP(TaskHeap, Task, TASK_PRIORITY_LESS)
+
+// Fibonacci hashing: the multiply moves entropy into the high bits, and
+// the shift brings them down to where the map's mask looks
+static inline size_t hash_u32(uint32_t key)
+{
+    return (size_t) (((uint64_t) key * 0x9E3779B97F4A7C15ull) >> 32);
+}
+#define U32_EQ(a, b) ((a) == (b))
+DEFINE_HASHMAP(U32Map, uint32_t, int, hash_u32, U32_EQ)
+
+// ====================================================
+// void * baselines, for the benchmark
+// ====================================================
+
+// Node and callback layout of practices/006-linked-list
+typedef struct GenericNode
+{
+    void *data;
+    struct GenericNode *next;
+} GenericNode;
+
+GenericNode *generic_find(GenericNode *head,
+                          void *data,
+                          int (*compare)(void *, void *))
+{
+    for (GenericNode *node = head; node != NULL; node = node->next)
+    {
+        if (compare(node->data, data) == 0) return node;
+    }
+    return NULL;
+}
+
+int compare_int(void *a, void *b)
+{
+    return *(int *) a - *(int *) b;
+}
+
+// Heap of elem_size-byte elements ordered by a comparator callback
+typedef struct
+{
+    char *data;
+    size_t size;
+    size_t capacity;
+    size_t elem_size;
+    int (*compare)(const void *, const void *);
+} GenericHeap;
+
+void generic_swap(char *a, char *b, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        char t = a[i];
+        a[i] = b[i];
+        b[i] = t;
+    }
+}
+
+bool generic_heap_push(GenericHeap *heap, const void *value)
+{
+    if (heap->size == heap->capacity)
+    {
+        size_t capacity = heap->capacity ? heap->capacity * 2 : 8;
+        char *data = (char *) realloc(heap->data, capacity * heap->elem_size);
+        if (data == NULL) return false;
+        heap->data = data;
+        heap->capacity = capacity;
+    }
+
+    size_t n = heap->elem_size;
+    size_t i = heap->size++;
+    memcpy(heap->data + i * n, value, n);
+    while (i > 0)
+    {
+        size_t parent = (i - 1) / 2;
+        if (heap->compare(heap->data + i * n, heap->data + parent * n) >= 0)
+        {
+            break;
+        }
+        generic_swap(heap->data + i * n, heap->data + parent * n, n);
+        i = parent;
+    }
+    return true;
+}
+
+bool generic_heap_pop(GenericHeap *heap, void *out)
+{
+    if (heap->size == 0) return false;
+
+    size_t n = heap->elem_size;
+    memcpy(out, heap->data, n);
+    heap->size--;
+    memcpy(heap->data, heap->data + heap->size * n, n);
+
+    size_t i = 0;
+    for (;;)
+    {
+        size_t child = 2 * i + 1;
+        if (child >= heap->size) break;
+        if (child + 1 < heap->size
+            && heap->compare(heap->data + (child + 1) * n,
+                             heap->data + child * n)
+                   < 0)
+        {
+            child++;
+        }
+        if (heap->compare(heap->data + child * n, heap->data + i * n) >= 0)
+        {
+            break;
+        }
+        generic_swap(heap->data + i * n, heap->data + child * n, n);
+        i = child;
+    }
+    return true;
+}
+
+int compare_int_const(const void *a, const void *b)
+{
+    int x = *(const int *) a;
+    int y = *(const int *) b;
+    return (x > y) - (x < y);
+}
+
+// ====================================================
+// Demos
+// ====================================================
+
+void demo_intrusive_list()
+{
+    printf("=== Intrusive List ===\n");
+
+    Task tasks[5];
+    TaskList list;
+    TaskList_init(&list);
+
+    for (int i = 0; i < 5; i++)
+    {
+        tasks[i].id = i + 1;
+        tasks[i].priority = (i * 3) % 5;
+        TaskList_push_back(&list, &tasks[i]);
+    }
+
+    Task key = {.id = 3};
+    Task *found = TaskList_find(&list, &key);
+    printf("Found task %d (priority %d)\n", found->id, found->priority);
+    TaskList_remove(&list, found);
+
+    printf("After removing it (%zu left):", list.size);
+    for (Task *t = TaskList_first(&list); t; t = TaskList_next(&list, t))
+    {
+        printf(" %d", t->id);
+    }
+    printf("\n");
+}
+
+void demo_vec_and_heap()
+{
+    printf("\n=== Vector and Heap ===\n");
+
+    IntVec vec;
+    IntVec_init(&vec);
+    for (int i = 0; i < 10; i++)
+    {
+        IntVec_push(&vec, (i * 7) % 10);
+    }
+
+    IntHeap heap;
+    IntHeap_init(&heap);
+    printf("Vector:");
+    for (size_t i = 0; i < vec.size; i++)
+    {
+        printf(" %d", *IntVec_at(&vec, i));
+        IntHeap_push(&heap, *IntVec_at(&vec, i));
+    }
+
+    printf("\nPopped from the min-heap:");
+    int value;
+    while (IntHeap_pop(&heap, &value))
+    {
+        printf(" %d", value);
+    }
+    printf("\n");
+
+    TaskHeap tasks;
+    TaskHeap_init(&tasks);
+    for (int i = 0; i < 5; i++)
+    {
+        Task t = {.id = i + 1, .priority = (i * 3) % 5};
+        TaskHeap_push(&tasks, t);
+    }
+    printf("Highest priority task: %d (priority %d)\n",
+           TaskHeap_peek(&tasks)->id,
+           TaskHeap_peek(&tasks)->priority);
+
+    TaskHeap_free(&tasks);
+    IntHeap_free(&heap);
+    IntVec_free(&vec);
+}
+
+void demo_hashmap()
+{
+    printf("\n=== Hash Map ===\n");
+
+    U32Map map;
+    U32Map_init(&map);
+    for (uint32_t key = 0; key < 100; key++)
+    {
+        U32Map_put(&map, key, (int) (key * key));
+    }
+    for (uint32_t key = 0; key < 100; key += 2)
+    {
+        U32Map_remove(&map, key);
+    }
+
+    int *nine = U32Map_get(&map, 9);
+    int *ten = U32Map_get(&map, 10);
+    printf("size %zu, capacity %zu, 9 -> %d, 10 -> %s\n",
+           map.size,
+           map.capacity,
+           nine ? *nine : -1,
+           ten ? "present" : "removed");
+    U32Map_free(&map);
+}
+
+// ====================================================
+// Benchmark
+// ====================================================
+
+double seconds_since(clock_t start)
+{
+    return ((double) (clock() - start)) / CLOCKS_PER_SEC;
+}
+
+void benchmark_containers()
+{
+    printf("\n=== Benchmark: Typed vs void * Containers ===\n");
+
+    const int n = 1000000;
+    int *values = (int *) malloc(n * sizeof(int));
+    if (values == NULL) return;
+    srand(7);
+    for (int i = 0; i < n; i++)
+    {
+        values[i] = rand();
+    }
+
+    // Heap sort through each heap
+    clock_t start = clock();
+    IntHeap heap;
+    IntHeap_init(&heap);
+    for (int i = 0; i < n; i++)
+    {
+        IntHeap_push(&heap, values[i]);
+    }
+    unsigned long long typed_check = 0;
+    int out;
+    while (IntHeap_pop(&heap, &out))
+    {
+        typed_check = typed_check * 31 + out;
+    }
+    IntHeap_free(&heap);
+    double typed_heap = seconds_since(start);
+
+    start = clock();
+    GenericHeap generic = {NULL, 0, 0, sizeof(int), compare_int_const};
+    for (int i = 0; i < n; i++)
+    {
+        generic_heap_push(&generic, &values[i]);
+    }
+    unsigned long long generic_check = 0;
+    while (generic_heap_pop(&generic, &out))
+    {
+        generic_check = generic_check * 31 + out;
+    }
+    free(generic.data);
+    double generic_heap = seconds_since(start);
+
+    printf("heap sort of %d ints:  typed %.3f s, void * %.3f s (%.1fx)%s\n",
+           n,
+           typed_heap,
+           generic_heap,
+           generic_heap / typed_heap,
+           typed_check == generic_check ? "" : " MISMATCH");
+
+    // Scan a list for a missing value
+    Task *tasks = (Task *) malloc(n * sizeof(Task));
+    GenericNode *head = NULL;
+    TaskList list;
+    TaskList_init(&list);
+    if (tasks == NULL) return;
+    for (int i = 0; i < n; i++)
+    {
+        tasks[i].id = values[i] & 0x3FFFFFFF;
+        tasks[i].priority = 0;
+        TaskList_push_front(&list, &tasks[i]);
+
+        // Two allocations per element, as create_node makes
+        GenericNode *node = (GenericNode *) malloc(sizeof(GenericNode));
+        node->data = malloc(sizeof(int));
+        *(int *) node->data = tasks[i].id;
+        node->next = head;
+        head = node;
+    }
+
+    const int scans = 20;
+    Task key = {.id = -1};
+    start = clock();
+    for (int r = 0; r < scans; r++)
+    {
+        if (TaskList_find(&list, &key) != NULL) printf("unexpected\n");
+    }
+    double typed_scan = seconds_since(start) / scans;
+
+    start = clock();
+    for (int r = 0; r < scans; r++)
+    {
+        if (generic_find(head, &key.id, compare_int) != NULL)
+        {
+            printf("unexpected\n");
+        }
+    }
+    double generic_scan = seconds_since(start) / scans;
+
+    printf("list scan of %d:       typed %.4f s, void * %.4f s (%.1fx)\n",
+           n,
+           typed_scan,
+           generic_scan,
+           generic_scan / typed_scan);
+
+    while (head != NULL)
+    {
+        GenericNode *next = head->next;
+        free(head->data);
+        free(head);
+        head = next;
+    }
+    free(tasks);
+
+    // Hash map: no void * baseline in this chapter; absolute numbers only
+    U32Map map;
+    U32Map_init(&map);
+    start = clock();
+    for (int i = 0; i < n; i++)
+    {
+        U32Map_put(&map, (uint32_t) values[i], i);
+    }
+    int hits = 0;
+    for (int i = 0; i < n; i++)
+    {
+        hits += U32Map_get(&map, (uint32_t) values[i]) != NULL;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        U32Map_remove(&map, (uint32_t) values[i]);
+    }
+    printf("hash map put/get/remove of %d: %.3f s (%d hits, %zu left)\n",
+           n,
+           seconds_since(start),
+           hits,
+           map.size);
+    U32Map_free(&map);
+
+    free(values);
+}
+
+int main()
+{
+    printf("==== TYPED CONTAINERS ====\n\n");
+
+    demo_intrusive_list();
+    demo_vec_and_heap();
+    demo_hashmap();
+    benchmark_containers();
+
+    return 0;
+}
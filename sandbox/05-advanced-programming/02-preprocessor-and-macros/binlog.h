@@ -0,0 +1,470 @@
+// Binary logging with compile-time levels.
+//
+// A printf-style log macro formats on every call: it parses the format
+// string, converts each argument to text and copies __FILE__ and __func__
+// into the output, even though the only parts that change between calls
+// are the argument values. These macros split the work in two:
+//
+//   LOG_INFO("read %d bytes from %s", n, path);
+//
+// - Levels below LOG_COMPILE_LEVEL expand to ((void) 0): no code, no
+//   string literals in the binary, arguments not evaluated.
+// - Everything known at compile time (format, file, line, function,
+//   level, argument types) goes into a static BinLogSite descriptor,
+//   emitted once per call site into the "binlog_sites" section.
+// - At run time a call appends one record to a BinLog buffer: the site's
+//   index in that section, a timestamp and the raw argument values
+//   (8 bytes each; strings are copied, up to 255 bytes).
+// - binlog_decode() turns records back into text later, off the hot path.
+//
+// The format is still checked by the compiler against the arguments as
+// for printf. Integer arguments are widened to 64 bits and float to
+// double; pass other pointers as (void *) for %p. Site indices only mean
+// something to the executable that wrote them, so a saved buffer must be
+// decoded by the same build. Records are self-contained, so a full buffer
+// can be handed to a writer thread (like the async logger's) as is.
+//
+// The section start/stop symbols are generated by GNU-compatible linkers
+// for ELF targets.
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_WARN  3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_NONE  5
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define BINLOG_MAX_ARGS   8
+#define BINLOG_MAX_STRING 255
+
+typedef struct
+{
+    const char *format;
+    const char *file;
+    const char *func;
+    uint32_t line;
+    uint8_t level;
+    uint8_t nargs;
+    // Per argument: 'i' int, 'u' unsigned, 'd' double, 's' string,
+    // 'p' pointer
+    char types[BINLOG_MAX_ARGS + 1];
+} BinLogSite;
+
+typedef union
+{
+    int64_t i;
+    uint64_t u;
+    double d;
+    const char *s;
+} BinLogValue;
+
+typedef struct
+{
+    uint8_t *data;
+    size_t capacity;
+    size_t used;
+    uint64_t records;
+    uint64_t dropped;  // Records that did not fit
+} BinLog;
+
+// Sites are placed back to back in one section; aligning each to a
+// pointer stops the compiler padding them apart, so index arithmetic on
+// the section works
+#define BINLOG_SITE_ATTRS \
+    __attribute__((section("binlog_sites"), used, aligned(sizeof(void *))))
+
+extern const BinLogSite __start_binlog_sites[] __attribute__((weak));
+extern const BinLogSite __stop_binlog_sites[] __attribute__((weak));
+
+// The buffer the LOG_* macros write to in this translation unit; records
+// are dropped while it is NULL
+static BinLog *binlog_current;
+
+static inline void binlog_init(BinLog *log, void *buffer, size_t capacity)
+{
+    log->data = (uint8_t *) buffer;
+    log->capacity = capacity;
+    log->used = 0;
+    log->records = 0;
+    log->dropped = 0;
+}
+
+static inline void binlog_use(BinLog *log)
+{
+    binlog_current = log;
+}
+
+/* ---- Argument capture ---- */
+
+static inline BinLogValue binlog_from_i64(int64_t v)
+{
+    BinLogValue value;
+    value.i = v;
+    return value;
+}
+
+static inline BinLogValue binlog_from_u64(uint64_t v)
+{
+    BinLogValue value;
+    value.u = v;
+    return value;
+}
+
+static inline BinLogValue binlog_from_double(double v)
+{
+    BinLogValue value;
+    value.d = v;
+    return value;
+}
+
+static inline BinLogValue binlog_from_str(const char *v)
+{
+    BinLogValue value;
+    value.s = v;
+    return value;
+}
+
+static inline BinLogValue binlog_from_ptr(const void *v)
+{
+    BinLogValue value;
+    value.u = (uintptr_t) v;
+    return value;
+}
+
+// Type tag of an argument; an integer constant expression, so it can
+// initialise the static site
+#define BINLOG_TYPE(x)               \
+    _Generic((x),                    \
+        char *: 's',                 \
+        const char *: 's',           \
+        float: 'd',                  \
+        double: 'd',                 \
+        unsigned char: 'u',          \
+        unsigned short: 'u',         \
+        unsigned int: 'u',           \
+        unsigned long: 'u',          \
+        unsigned long long: 'u',     \
+        void *: 'p',                 \
+        const void *: 'p',           \
+        default: 'i'),
+
+#define BINLOG_VALUE(x)                          \
+    _Generic((x),                                \
+        char *: binlog_from_str,                 \
+        const char *: binlog_from_str,           \
+        float: binlog_from_double,               \
+        double: binlog_from_double,              \
+        unsigned char: binlog_from_u64,          \
+        unsigned short: binlog_from_u64,         \
+        unsigned int: binlog_from_u64,           \
+        unsigned long: binlog_from_u64,          \
+        unsigned long long: binlog_from_u64,     \
+        void *: binlog_from_ptr,                 \
+        const void *: binlog_from_ptr,           \
+        default: binlog_from_i64)(x),
+
+// BINLOG_MAP(m, a, b, c) -> m(a) m(b) m(c), for up to BINLOG_MAX_ARGS
+#define BINLOG_COUNT(...) \
+    BINLOG_COUNT_(_, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define BINLOG_COUNT_(_, a, b, c, d, e, f, g, h, n, ...) n
+
+#define BINLOG_MAP(m, ...) \
+    BINLOG_MAP_N(BINLOG_COUNT(__VA_ARGS__), m, ##__VA_ARGS__)
+#define BINLOG_MAP_N(n, m, ...)  BINLOG_MAP_N_(n, m, ##__VA_ARGS__)
+#define BINLOG_MAP_N_(n, m, ...) BINLOG_MAP_##n(m, ##__VA_ARGS__)
+#define BINLOG_MAP_0(m)
+#define BINLOG_MAP_1(m, a)      m(a)
+#define BINLOG_MAP_2(m, a, ...) m(a) BINLOG_MAP_1(m, __VA_ARGS__)
+#define BINLOG_MAP_3(m, a, ...) m(a) BINLOG_MAP_2(m, __VA_ARGS__)
+#define BINLOG_MAP_4(m, a, ...) m(a) BINLOG_MAP_3(m, __VA_ARGS__)
+#define BINLOG_MAP_5(m, a, ...) m(a) BINLOG_MAP_4(m, __VA_ARGS__)
+#define BINLOG_MAP_6(m, a, ...) m(a) BINLOG_MAP_5(m, __VA_ARGS__)
+#define BINLOG_MAP_7(m, a, ...) m(a) BINLOG_MAP_6(m, __VA_ARGS__)
+#define BINLOG_MAP_8(m, a, ...) m(a) BINLOG_MAP_7(m, __VA_ARGS__)
+
+// Never called; lets the compiler check the format against the arguments
+static inline __attribute__((format(printf, 1, 2))) void
+binlog_check_format(const char *format, ...)
+{
+    (void) format;
+}
+
+/* ---- Hot path ---- */
+
+static inline void binlog_put(BinLog *log, const void *src, size_t size)
+{
+    memcpy(log->data + log->used, src, size);
+    log->used += size;
+}
+
+// Record: u32 site index, u64 timestamp (CLOCK_MONOTONIC ns), then per
+// argument 8 bytes, or for strings a u8 length and that many bytes
+static inline void binlog_write(BinLog *log,
+                                const BinLogSite *site,
+                                const BinLogValue *values)
+{
+    if (log == NULL) return;
+
+    uint8_t lengths[BINLOG_MAX_ARGS];
+    size_t size = sizeof(uint32_t) + sizeof(uint64_t);
+    for (int i = 0; i < site->nargs; i++)
+    {
+        if (site->types[i] == 's')
+        {
+            size_t length = values[i].s ? strlen(values[i].s) : 0;
+            lengths[i] = length > BINLOG_MAX_STRING ? BINLOG_MAX_STRING
+                                                    : (uint8_t) length;
+            size += 1 + lengths[i];
+        }
+        else
+        {
+            size += sizeof(BinLogValue);
+        }
+    }
+    if (log->capacity - log->used < size)
+    {
+        log->dropped++;
+        return;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t timestamp =
+        (uint64_t) now.tv_sec * UINT64_C(1000000000) + now.tv_nsec;
+    uint32_t index = (uint32_t) (site - __start_binlog_sites);
+
+    binlog_put(log, &index, sizeof(index));
+    binlog_put(log, &timestamp, sizeof(timestamp));
+    for (int i = 0; i < site->nargs; i++)
+    {
+        if (site->types[i] == 's')
+        {
+            binlog_put(log, &lengths[i], 1);
+            binlog_put(log, values[i].s, lengths[i]);
+        }
+        else
+        {
+            binlog_put(log, &values[i], sizeof(BinLogValue));
+        }
+    }
+    log->records++;
+}
+
+#define BINLOG_EMIT(lvl, fmt, ...)                                          \
+    do                                                                      \
+    {                                                                       \
+        _Static_assert(BINLOG_COUNT(__VA_ARGS__) <= BINLOG_MAX_ARGS,        \
+                       "too many log arguments");                           \
+        static const BinLogSite binlog_site_ BINLOG_SITE_ATTRS = {          \
+            fmt, __FILE__, __func__, __LINE__, lvl,                         \
+            BINLOG_COUNT(__VA_ARGS__),                                      \
+            {BINLOG_MAP(BINLOG_TYPE, ##__VA_ARGS__) 0}};                    \
+        if (0) binlog_check_format(fmt, ##__VA_ARGS__);                     \
+        binlog_write(binlog_current,                                        \
+                     &binlog_site_,                                         \
+                     (const BinLogValue[]) {                                \
+                         BINLOG_MAP(BINLOG_VALUE, ##__VA_ARGS__){0}});      \
+    } while (0)
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(...) BINLOG_EMIT(LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) ((void) 0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) BINLOG_EMIT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void) 0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) BINLOG_EMIT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void) 0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) BINLOG_EMIT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void) 0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) BINLOG_EMIT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void) 0)
+#endif
+
+/* ---- Offline decoding ---- */
+
+static const char *const binlog_level_names[] = {
+    "TRACE", "DEBUG", "INFO", "WARN", "ERROR"};
+
+// Print one argument for the conversion spec (without length modifier)
+// in spec, coercing the stored value to what the conversion expects
+static inline void binlog_print_arg(FILE *out,
+                                    char *spec,
+                                    size_t spec_length,
+                                    char conversion,
+                                    char type,
+                                    BinLogValue value,
+                                    const char *string)
+{
+    char *end = spec + spec_length;
+    double as_double = type == 'd'   ? value.d
+                       : type == 'u' ? (double) value.u
+                                     : (double) value.i;
+    long long as_int = type == 'd' ? (long long) value.d : (long long) value.i;
+
+    switch (conversion)
+    {
+    case 'd':
+    case 'i':
+        strcpy(end, "lld");
+        fprintf(out, spec, as_int);
+        break;
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+        end[0] = 'l';
+        end[1] = 'l';
+        end[2] = conversion;
+        end[3] = '\0';
+        fprintf(out, spec, (unsigned long long) as_int);
+        break;
+    case 'c':
+        strcpy(end, "c");
+        fprintf(out, spec, (int) as_int);
+        break;
+    case 's':
+        strcpy(end, "s");
+        fprintf(out, spec, type == 's' ? string : "?");
+        break;
+    case 'p':
+        strcpy(end, "p");
+        fprintf(out, spec, (void *) (uintptr_t) value.u);
+        break;
+    default:  // f, e, g, a and upper case
+        end[0] = conversion;
+        end[1] = '\0';
+        fprintf(out, spec, as_double);
+        break;
+    }
+}
+
+static inline void binlog_format(FILE *out,
+                                 const BinLogSite *site,
+                                 const BinLogValue *values,
+                                 char strings[][BINLOG_MAX_STRING + 1])
+{
+    int arg = 0;
+    for (const char *p = site->format; *p;)
+    {
+        if (*p != '%')
+        {
+            fputc(*p++, out);
+            continue;
+        }
+        if (p[1] == '%')
+        {
+            fputc('%', out);
+            p += 2;
+            continue;
+        }
+
+        // Copy flags, width and precision; drop the length modifier,
+        // since the stored value has its own width
+        char spec[40];
+        size_t n = 0;
+        spec[n++] = *p++;
+        while (*p && strchr("-+ #0123456789.", *p) && n < sizeof(spec) - 5)
+        {
+            spec[n++] = *p++;
+        }
+        while (*p && strchr("hlLqjzt", *p)) p++;
+        char conversion = *p;
+        if (conversion == '\0') break;
+        p++;
+
+        if (arg >= site->nargs)
+        {
+            fputs("<missing>", out);
+            continue;
+        }
+        binlog_print_arg(out, spec, n, conversion, site->types[arg],
+                         values[arg], strings[arg]);
+        arg++;
+    }
+}
+
+// Format every record in data as
+//   seconds.nanoseconds [LEVEL] file:line:func(): message
+// Returns the number of records decoded, or -1 if the data is corrupt.
+static inline long binlog_decode(const void *data, size_t length, FILE *out)
+{
+    const uint8_t *p = (const uint8_t *) data;
+    const uint8_t *end = p + length;
+    size_t site_count = (size_t) (__stop_binlog_sites - __start_binlog_sites);
+    long records = 0;
+
+    while (p < end)
+    {
+        uint32_t index;
+        uint64_t timestamp;
+        if ((size_t) (end - p) < sizeof(index) + sizeof(timestamp)) return -1;
+        memcpy(&index, p, sizeof(index));
+        memcpy(&timestamp, p + sizeof(index), sizeof(timestamp));
+        p += sizeof(index) + sizeof(timestamp);
+        if (index >= site_count) return -1;
+
+        const BinLogSite *site = &__start_binlog_sites[index];
+        BinLogValue values[BINLOG_MAX_ARGS];
+        char strings[BINLOG_MAX_ARGS][BINLOG_MAX_STRING + 1];
+        for (int i = 0; i < site->nargs; i++)
+        {
+            if (site->types[i] == 's')
+            {
+                if (p >= end || (size_t) (end - p) < 1u + p[0]) return -1;
+                memcpy(strings[i], p + 1, p[0]);
+                strings[i][p[0]] = '\0';
+                p += 1 + p[0];
+            }
+            else
+            {
+                if ((size_t) (end - p) < sizeof(BinLogValue)) return -1;
+                memcpy(&values[i], p, sizeof(BinLogValue));
+                p += sizeof(BinLogValue);
+            }
+        }
+
+        fprintf(out,
+                "%llu.%09llu [%s] %s:%u:%s(): ",
+                (unsigned long long) (timestamp / 1000000000u),
+                (unsigned long long) (timestamp % 1000000000u),
+                site->level < LOG_LEVEL_NONE
+                    ? binlog_level_names[site->level]
+                    : "?",
+                site->file,
+                (unsigned) site->line,
+                site->func);
+        binlog_format(out, site, values, strings);
+        fputc('\n', out);
+        records++;
+    }
+    return records;
+}
+
+#endif  // BINLOG_H
@@ -1,19 +1,30 @@
 #ifndef MATH_UTILS_H
 #define MATH_UTILS_H
 
+/*
+ * Define MATHLIB_HEADER_ONLY (e.g. -DMATHLIB_HEADER_ONLY) to get every
+ * function below as static inline, so callers can inline and vectorize
+ * them instead of making an opaque call into math_utils.o.
+ */
+#ifdef MATHLIB_HEADER_ONLY
+#define MATH_UTILS_API static inline
+#else
+#define MATH_UTILS_API
+#endif
+
 /**
  * Calculates the square of a number
  * @param x The number to square
  * @return The square of x
  */
-double square(double x);
+MATH_UTILS_API double square(double x);
 
 /**
  * Calculates the cube of a number
  * @param x The number to cube
  * @return The cube of x
  */
-double cube(double x);
+MATH_UTILS_API double cube(double x);
 
 /**
  * Calculates x raised to the power of y
@@ -21,6 +32,39 @@ double cube(double x);
  * @param y Exponent value
  * @return x to the power of y
  */
-double power(double x, int y);
+MATH_UTILS_API double(power)(double x, int y);
+
+/**
+ * Straight-line power for the small exponents power() specializes; gives
+ * the same result as power(x, y) for -2 <= y <= 4
+ */
+static inline double power_small(double x, int y)
+{
+    switch (y)
+    {
+    case -2: return 1.0 / (x * x);
+    case -1: return 1.0 / x;
+    case 0: return 1.0;
+    case 1: return x;
+    case 2: return x * x;
+    case 3: return x * (x * x);
+    default: return (x * x) * (x * x);
+    }
+}
+
+/*
+ * power(x, 2) with a literal exponent compiles to a multiply instead of a
+ * call: GCC and Clang fold __builtin_constant_p so only one branch is left.
+ * Write (power)(x, y) to always get the function.
+ */
+#if defined(__GNUC__)
+#define power(x, y)                                                    \
+    (__builtin_constant_p(y) && (y) >= -2 && (y) <= 4 ? power_small(x, y) \
+                                                      : (power)(x, y))
+#endif
+
+#ifdef MATHLIB_HEADER_ONLY
+#include "math_utils_impl.h"
+#endif
 
 #endif /* MATH_UTILS_H */
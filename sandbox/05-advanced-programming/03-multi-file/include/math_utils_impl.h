@@ -0,0 +1,39 @@
+#ifndef MATH_UTILS_IMPL_H
+#define MATH_UTILS_IMPL_H
+
+/*
+ * Definitions of the functions declared in math_utils.h. Compiled once by
+ * src/math_utils.c normally, or pulled into every caller as static inline
+ * when MATHLIB_HEADER_ONLY is defined.
+ */
+#include "math_utils.h"
+
+MATH_UTILS_API double square(double x)
+{
+    return x * x;
+}
+
+MATH_UTILS_API double cube(double x)
+{
+    return x * x * x;
+}
+
+/* Parenthesized name: power() may be a macro, see math_utils.h */
+MATH_UTILS_API double(power)(double x, int y)
+{
+    /* Exponentiation by squaring: O(log |y|) multiplies. The magnitude is
+     * taken as unsigned so y == INT_MIN does not overflow. */
+    unsigned int n = y < 0 ? 0u - (unsigned int)y : (unsigned int)y;
+    double result = 1.0;
+
+    while (n > 0)
+    {
+        if (n & 1u) result *= x;
+        n >>= 1;
+        if (n > 0) x *= x;
+    }
+
+    return y < 0 ? 1.0 / result : result;
+}
+
+#endif /* MATH_UTILS_IMPL_H */
@@ -0,0 +1,36 @@
+#ifndef POLYNOMIAL_H
+#define POLYNOMIAL_H
+
+#include <stddef.h> /* For size_t */
+
+/**
+ * Highest degree poly_eval_estrin evaluates itself; above it falls back to
+ * poly_eval_horner
+ */
+#define POLY_MAX_DEGREE 31
+
+/**
+ * Evaluate c[0] + c[1]*x + ... + c[degree]*x^degree at n points using
+ * Horner's rule, one fused multiply-add per coefficient
+ * @param out Results, out[i] = p(x[i]); may be the same array as x
+ * @param coeffs degree + 1 coefficients, constant term first
+ */
+void poly_eval_horner(double *out,
+                      const double *x,
+                      size_t n,
+                      const double *coeffs,
+                      int degree);
+
+/**
+ * Same as poly_eval_horner using Estrin's scheme: terms are paired with x,
+ * then with x^2, x^4, ..., so the multiply-adds for one point form a tree
+ * of depth log2(degree) instead of a chain of length degree. Rounding can
+ * differ from Horner in the last bits.
+ */
+void poly_eval_estrin(double *out,
+                      const double *x,
+                      size_t n,
+                      const double *coeffs,
+                      int degree);
+
+#endif /* POLYNOMIAL_H */
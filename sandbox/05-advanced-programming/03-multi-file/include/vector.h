@@ -4,6 +4,13 @@
 /* Only include what's necessary for the declarations */
 #include <stdbool.h> /* For bool type */
 
+/* MATHLIB_HEADER_ONLY makes these static inline, as in math_utils.h */
+#ifdef MATHLIB_HEADER_ONLY
+#define VECTOR_API static inline
+#else
+#define VECTOR_API
+#endif
+
 /**
  * 3D vector structure
  */
@@ -17,54 +24,67 @@ typedef struct
 /**
  * Create a new 3D vector with given components
  */
-Vector3 vector_create(float x, float y, float z);
+VECTOR_API Vector3 vector_create(float x, float y, float z);
 
 /**
  * Add two vectors
  * @return Result of v1 + v2
  */
-Vector3 vector_add(Vector3 v1, Vector3 v2);
+VECTOR_API Vector3 vector_add(Vector3 v1, Vector3 v2);
 
 /**
  * Subtract v2 from v1
  * @return Result of v1 - v2
  */
-Vector3 vector_subtract(Vector3 v1, Vector3 v2);
+VECTOR_API Vector3 vector_subtract(Vector3 v1, Vector3 v2);
 
 /**
  * Multiply a vector by a scalar
  * @return Vector with each component multiplied by scalar
  */
-Vector3 vector_scale(Vector3 v, float scalar);
+VECTOR_API Vector3 vector_scale(Vector3 v, float scalar);
 
 /**
  * Calculate dot product of two vectors
  * @return The dot product v1·v2
  */
-float vector_dot(Vector3 v1, Vector3 v2);
+VECTOR_API float vector_dot(Vector3 v1, Vector3 v2);
 
 /**
  * Calculate cross product of two vectors
  * @return The cross product v1×v2
  */
-Vector3 vector_cross(Vector3 v1, Vector3 v2);
+VECTOR_API Vector3 vector_cross(Vector3 v1, Vector3 v2);
 
 /**
  * Calculate the magnitude (length) of a vector
  * @return The magnitude of the vector
  */
-float vector_magnitude(Vector3 v);
+VECTOR_API float vector_magnitude(Vector3 v);
 
 /**
  * Normalize a vector to unit length
  * @return Normalized vector with same direction but magnitude 1
  */
-Vector3 vector_normalize(Vector3 v);
+VECTOR_API Vector3 vector_normalize(Vector3 v);
 
 /**
  * Check if two vectors are equal (within a small epsilon)
  * @return true if vectors are approximately equal
  */
-bool vector_equals(Vector3 v1, Vector3 v2, float epsilon);
+VECTOR_API bool vector_equals(Vector3 v1, Vector3 v2, float epsilon);
+
+/**
+ * Check if two vectors are equal to within max_ulps representable floats
+ * per component: a tolerance that scales with the components. Components
+ * closer than the default epsilon also match, since near zero the ulp
+ * distance grows without bound.
+ * @return true if vectors are approximately equal
+ */
+VECTOR_API bool vector_equals_ulps(Vector3 v1, Vector3 v2, unsigned max_ulps);
+
+#ifdef MATHLIB_HEADER_ONLY
+#include "vector_impl.h"
+#endif
 
 #endif /* VECTOR_H */
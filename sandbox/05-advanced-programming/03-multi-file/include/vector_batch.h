@@ -0,0 +1,122 @@
+#ifndef VECTOR_BATCH_H
+#define VECTOR_BATCH_H
+
+#include <stdbool.h> /* For bool type */
+#include <stddef.h>  /* For size_t */
+
+#include "vector.h"
+
+/**
+ * Structure-of-arrays view over N vectors: component i of vector k lives at
+ * x[k], y[k] and z[k]. Keeping each component contiguous lets the batch
+ * functions process 4/8/16 vectors per instruction instead of one call per
+ * Vector3.
+ *
+ * The batch functions accept any alignment; buffers from vector_soa_create
+ * are cache-line aligned. An output may be the same buffers as an input.
+ */
+typedef struct
+{
+    float *x;
+    float *y;
+    float *z;
+} Vector3SoA;
+
+/**
+ * Precision of vector_batch_magnitude and vector_batch_normalize.
+ * FAST replaces sqrt and divide with the hardware reciprocal square root
+ * estimate (rsqrtps/vrsqrte14ps/frsqrte) refined by one Newton-Raphson
+ * step. The other batch functions are always exact.
+ */
+typedef enum
+{
+    VECTOR_PRECISION_EXACT, /* bit-identical to vector_normalize etc. */
+    VECTOR_PRECISION_FAST   /* relative error <= VECTOR_FAST_REL_ERROR */
+} VectorPrecision;
+
+/**
+ * Guaranteed relative error of VECTOR_PRECISION_FAST results (per component
+ * for normalize); main.c's benchmark checks every kernel against it. The
+ * measured maxima are about 3.5e-7 for SSE/AVX2 and 2.8e-7 for AVX-512; the
+ * 8-bit NEON estimate is the loosest case. Vectors with |v|^2 below FLT_MIN
+ * report magnitude 0, and infinite components are not supported.
+ */
+#define VECTOR_FAST_REL_ERROR 1e-4f
+
+/**
+ * Allocate cache-line aligned component arrays for n vectors
+ * @return false if allocation failed (soa is left zeroed)
+ */
+bool vector_soa_create(Vector3SoA *soa, size_t n);
+
+/**
+ * Free arrays allocated by vector_soa_create
+ */
+void vector_soa_destroy(Vector3SoA *soa);
+
+/**
+ * Read vector i out of a SoA buffer
+ */
+Vector3 vector_soa_get(Vector3SoA soa, size_t i);
+
+/**
+ * Store v as vector i of a SoA buffer
+ */
+void vector_soa_set(Vector3SoA soa, size_t i, Vector3 v);
+
+/**
+ * out[i] = a[i] + b[i] for i in [0, n)
+ */
+void vector_batch_add(Vector3SoA out, Vector3SoA a, Vector3SoA b, size_t n);
+
+/**
+ * out[i] = v[i] * scalar for i in [0, n)
+ */
+void vector_batch_scale(Vector3SoA out, Vector3SoA v, float scalar, size_t n);
+
+/**
+ * out[i] = a[i]·b[i] for i in [0, n)
+ */
+void vector_batch_dot(float *out, Vector3SoA a, Vector3SoA b, size_t n);
+
+/**
+ * out[i] = a[i]×b[i] for i in [0, n)
+ */
+void vector_batch_cross(Vector3SoA out, Vector3SoA a, Vector3SoA b, size_t n);
+
+/**
+ * out[i] = |v[i]| for i in [0, n)
+ */
+void vector_batch_magnitude(float *out, Vector3SoA v, size_t n);
+
+/**
+ * out[i] = vector_normalize(v[i]) for i in [0, n); near-zero vectors
+ * become (0, 0, 0) exactly as in the scalar version
+ */
+void vector_batch_normalize(Vector3SoA out, Vector3SoA v, size_t n);
+
+/**
+ * Name of the kernel set in use ("avx512", "avx2", "sse", "neon" or
+ * "scalar"). The best one the CPU supports is picked at startup.
+ */
+const char *vector_batch_kernel(void);
+
+/**
+ * Force a kernel set by name, e.g. to compare them in a benchmark
+ * @return false if that kernel set is not built in or not supported by
+ *         this CPU (the current selection is kept)
+ */
+bool vector_batch_select(const char *name);
+
+/**
+ * Choose exact or fast magnitude/normalize for all threads; exact is the
+ * default
+ */
+void vector_batch_set_precision(VectorPrecision mode);
+
+/**
+ * Current precision mode
+ */
+VectorPrecision vector_batch_precision(void);
+
+#endif /* VECTOR_BATCH_H */
@@ -0,0 +1,109 @@
+#ifndef VECTOR_IMPL_H
+#define VECTOR_IMPL_H
+
+/*
+ * Definitions of the functions declared in vector.h. Compiled once by
+ * src/vector.c normally, or pulled into every caller as static inline when
+ * MATHLIB_HEADER_ONLY is defined.
+ */
+#include "vector.h"
+
+#include <math.h>   /* for sqrt */
+#include <stdint.h> /* for uint32_t */
+#include <string.h> /* for memcpy */
+
+/* Private constant and helper - static, so never exported by vector.o */
+static const float VECTOR_EPSILON = 0.00001f;
+
+static inline bool vector_is_zero(float value)
+{
+    return fabsf(value) < VECTOR_EPSILON;
+}
+
+/*
+ * The bits of a float as an integer that orders like the float: memcpy is
+ * the defined way to read them (a uint32_t * cast breaks strict aliasing)
+ * and compiles to one register move. Flipping negatives makes adjacent
+ * floats, -0.0 and +0.0 included, differ by 1.
+ */
+static inline uint32_t vector_float_key(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof bits);
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+/* Within max_ulps representable floats, or closer than VECTOR_EPSILON */
+static inline bool vector_nearly_equal(float a, float b, unsigned max_ulps)
+{
+    uint32_t ka, kb;
+
+    if (fabsf(a - b) <= VECTOR_EPSILON) return true;
+    if (isnan(a) || isnan(b)) return false;
+    ka = vector_float_key(a);
+    kb = vector_float_key(b);
+    return (ka > kb ? ka - kb : kb - ka) <= max_ulps;
+}
+
+VECTOR_API Vector3 vector_create(float x, float y, float z)
+{
+    Vector3 v = {x, y, z};
+    return v;
+}
+
+VECTOR_API Vector3 vector_add(Vector3 v1, Vector3 v2)
+{
+    return vector_create(v1.x + v2.x, v1.y + v2.y, v1.z + v2.z);
+}
+
+VECTOR_API Vector3 vector_subtract(Vector3 v1, Vector3 v2)
+{
+    return vector_create(v1.x - v2.x, v1.y - v2.y, v1.z - v2.z);
+}
+
+VECTOR_API Vector3 vector_scale(Vector3 v, float scalar)
+{
+    return vector_create(v.x * scalar, v.y * scalar, v.z * scalar);
+}
+
+VECTOR_API float vector_dot(Vector3 v1, Vector3 v2)
+{
+    return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+}
+
+VECTOR_API Vector3 vector_cross(Vector3 v1, Vector3 v2)
+{
+    return vector_create(v1.y * v2.z - v1.z * v2.y,
+                         v1.z * v2.x - v1.x * v2.z,
+                         v1.x * v2.y - v1.y * v2.x);
+}
+
+VECTOR_API float vector_magnitude(Vector3 v)
+{
+    return sqrtf(vector_dot(v, v));
+}
+
+VECTOR_API Vector3 vector_normalize(Vector3 v)
+{
+    float mag = vector_magnitude(v);
+    if (vector_is_zero(mag)) return vector_create(0, 0, 0);
+
+    return vector_scale(v, 1.0f / mag);
+}
+
+VECTOR_API bool vector_equals(Vector3 v1, Vector3 v2, float epsilon)
+{
+    if (epsilon <= 0) epsilon = VECTOR_EPSILON;
+
+    return fabsf(v1.x - v2.x) < epsilon && fabsf(v1.y - v2.y) < epsilon
+           && fabsf(v1.z - v2.z) < epsilon;
+}
+
+VECTOR_API bool vector_equals_ulps(Vector3 v1, Vector3 v2, unsigned max_ulps)
+{
+    return vector_nearly_equal(v1.x, v2.x, max_ulps)
+           && vector_nearly_equal(v1.y, v2.y, max_ulps)
+           && vector_nearly_equal(v1.z, v2.z, max_ulps);
+}
+
+#endif /* VECTOR_IMPL_H */
@@ -1,10 +1,308 @@
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "math_utils.h"
+#include "polynomial.h"
 #include "vector.h"
+#include "vector_batch.h"
 
-int main()
+#define BATCH_SIZE (1 << 20)
+#define BATCH_ROUNDS 20
+#define CALL_ROUNDS 50
+
+static double elapsed_ms(clock_t start)
+{
+    return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/* Largest |got - want| / |want| over n floats; a nonzero result where the
+ * exact one is 0 counts as infinite error */
+static double max_rel_error(const float *got, const float *want, size_t n)
+{
+    double worst = 0.0;
+    for (size_t i = 0; i < n; i++)
+    {
+        double err = want[i] != 0.0f ? fabs((double)got[i] - want[i])
+                                           / fabs((double)want[i])
+                     : got[i] != 0.0f ? INFINITY
+                                      : 0.0;
+        if (err > worst) worst = err;
+    }
+    return worst;
+}
+
+/* Normalize BATCH_SIZE vectors one call at a time vs. through the SoA API,
+ * then repeat in VECTOR_PRECISION_FAST and check its error bound */
+static void batch_benchmark(void)
 {
+    const char *kernels[] = {"scalar", "sse", "avx2", "avx512", "neon"};
+    const char *best = vector_batch_kernel();
+    Vector3 *aos = malloc(BATCH_SIZE * sizeof(Vector3));
+    Vector3SoA in, out, expected;
+
+    if (!aos || !vector_soa_create(&in, BATCH_SIZE)
+        || !vector_soa_create(&out, BATCH_SIZE)
+        || !vector_soa_create(&expected, BATCH_SIZE))
+    {
+        fprintf(stderr, "batch benchmark: out of memory\n");
+        exit(1);
+    }
+
+    srand(42);
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        /* Lengths span 1e-6..1e5; every 64th vector is zero to exercise
+         * the zero-length path */
+        float scale = (i % 64 == 0) ? 0.0f : powf(10.0f, (int)(i % 9) - 4);
+        aos[i] = vector_create(scale * (rand() % 2001 - 1000) / 100.0f,
+                               scale * (rand() % 2001 - 1000) / 100.0f,
+                               scale * (rand() % 2001 - 1000) / 100.0f);
+        vector_soa_set(in, i, aos[i]);
+    }
+
+    clock_t start = clock();
+    for (int r = 0; r < BATCH_ROUNDS; r++)
+    {
+        for (size_t i = 0; i < BATCH_SIZE; i++)
+        {
+            vector_soa_set(expected, i, vector_normalize(aos[i]));
+        }
+    }
+    double per_call_ms = elapsed_ms(start);
+
+    printf("\nNormalizing %d vectors x %d rounds (best kernel: %s)\n",
+           BATCH_SIZE,
+           BATCH_ROUNDS,
+           best);
+    printf("  %-16s %8.1f ms\n", "vector_normalize", per_call_ms);
+
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+    {
+        if (!vector_batch_select(kernels[k])) continue;
+
+        start = clock();
+        for (int r = 0; r < BATCH_ROUNDS; r++)
+        {
+            vector_batch_normalize(out, in, BATCH_SIZE);
+        }
+        double ms = elapsed_ms(start);
+
+        bool same = memcmp(out.x, expected.x, BATCH_SIZE * sizeof(float)) == 0
+                    && memcmp(out.y, expected.y, BATCH_SIZE * sizeof(float))
+                           == 0
+                    && memcmp(out.z, expected.z, BATCH_SIZE * sizeof(float))
+                           == 0;
+        printf("  batch %-10s %8.1f ms  %5.1fx  %s\n",
+               kernels[k],
+               ms,
+               ms > 0 ? per_call_ms / ms : 0.0,
+               same ? "matches scalar" : "MISMATCH");
+    }
+
+    /* Same inputs through the rsqrt estimate + Newton step path */
+    float *mags = malloc(BATCH_SIZE * sizeof(float));
+    float *exact_mags = malloc(BATCH_SIZE * sizeof(float));
+    if (!mags || !exact_mags)
+    {
+        fprintf(stderr, "batch benchmark: out of memory\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        exact_mags[i] = vector_magnitude(aos[i]);
+    }
+
+    printf("  fast precision (bound %.0e):\n", VECTOR_FAST_REL_ERROR);
+    vector_batch_set_precision(VECTOR_PRECISION_FAST);
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+    {
+        if (!vector_batch_select(kernels[k])) continue;
+
+        start = clock();
+        for (int r = 0; r < BATCH_ROUNDS; r++)
+        {
+            vector_batch_normalize(out, in, BATCH_SIZE);
+        }
+        double ms = elapsed_ms(start);
+        vector_batch_magnitude(mags, in, BATCH_SIZE);
+
+        double err = max_rel_error(out.x, expected.x, BATCH_SIZE);
+        err = fmax(err, max_rel_error(out.y, expected.y, BATCH_SIZE));
+        err = fmax(err, max_rel_error(out.z, expected.z, BATCH_SIZE));
+        double mag_err = max_rel_error(mags, exact_mags, BATCH_SIZE);
+
+        printf("  batch %-10s %8.1f ms  %5.1fx  max error %.1e/%.1e %s\n",
+               kernels[k],
+               ms,
+               ms > 0 ? per_call_ms / ms : 0.0,
+               err,
+               mag_err,
+               fmax(err, mag_err) <= VECTOR_FAST_REL_ERROR ? "ok"
+                                                           : "OUT OF BOUND");
+    }
+    vector_batch_set_precision(VECTOR_PRECISION_EXACT);
+    vector_batch_select(best);
+
+    free(exact_mags);
+    free(mags);
+    vector_soa_destroy(&expected);
+    vector_soa_destroy(&out);
+    vector_soa_destroy(&in);
+    free(aos);
+}
+
+/*
+ * One-instruction library calls in a hot loop. Built normally each call is
+ * opaque; with LTO or MATHLIB_HEADER_ONLY the compiler inlines them and can
+ * vectorize the loops (see the release/lto/inline/pgo Makefile targets).
+ */
+static void call_overhead_benchmark(void)
+{
+    double *xs = malloc(BATCH_SIZE * sizeof(double));
+    double *ys = malloc(BATCH_SIZE * sizeof(double));
+    Vector3 *vs = malloc(BATCH_SIZE * sizeof(Vector3));
+    Vector3 *ws = malloc(BATCH_SIZE * sizeof(Vector3));
+    float *dots = malloc(BATCH_SIZE * sizeof(float));
+
+    if (!xs || !ys || !vs || !ws || !dots)
+    {
+        fprintf(stderr, "call overhead benchmark: out of memory\n");
+        exit(1);
+    }
+
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        xs[i] = (double)(i % 1000) / 1000.0;
+        ys[i] = 0.0;
+        vs[i] = vector_create(i % 7, i % 11, i % 13);
+        ws[i] = vector_create(0, 0, 0);
+        dots[i] = 0.0f;
+    }
+
+    clock_t start = clock();
+    for (int r = 0; r < CALL_ROUNDS; r++)
+    {
+        for (size_t i = 0; i < BATCH_SIZE; i++)
+        {
+            ys[i] += square(xs[i]) + cube(xs[i]);
+        }
+    }
+    double math_ms = elapsed_ms(start);
+
+    start = clock();
+    for (int r = 0; r < CALL_ROUNDS; r++)
+    {
+        for (size_t i = 0; i < BATCH_SIZE; i++)
+        {
+            ws[i] = vector_add(ws[i], vector_scale(vs[i], 0.5f));
+            dots[i] += vector_dot(vs[i], ws[i]);
+        }
+    }
+    double vector_ms = elapsed_ms(start);
+
+    /* Accumulating across rounds and printing a checksum keeps the
+     * optimizer from dropping or collapsing the loops */
+    double checksum = 0.0;
+    for (size_t i = 0; i < BATCH_SIZE; i += 4096)
+    {
+        checksum += ys[i] + dots[i];
+    }
+
+    printf("\nPer-element library calls, %d x %d elements\n",
+           CALL_ROUNDS,
+           BATCH_SIZE);
+    printf("  square + cube          %8.1f ms\n", math_ms);
+    printf("  vector add/scale/dot   %8.1f ms  (checksum %.1f)\n",
+           vector_ms,
+           checksum);
+
+    free(dots);
+    free(ws);
+    free(vs);
+    free(ys);
+    free(xs);
+}
+
+/* Evaluate a degree-7 polynomial over BATCH_SIZE points three ways */
+static void polynomial_benchmark(void)
+{
+    /* Taylor series of sin around 0 */
+    const double coeffs[] =
+        {0.0, 1.0, 0.0, -1.0 / 6, 0.0, 1.0 / 120, 0.0, -1.0 / 5040};
+    const int degree = 7;
+    double *xs = malloc(BATCH_SIZE * sizeof(double));
+    double *naive = malloc(BATCH_SIZE * sizeof(double));
+    double *horner = malloc(BATCH_SIZE * sizeof(double));
+    double *estrin = malloc(BATCH_SIZE * sizeof(double));
+
+    if (!xs || !naive || !horner || !estrin)
+    {
+        fprintf(stderr, "polynomial benchmark: out of memory\n");
+        exit(1);
+    }
+
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        xs[i] = (double)(i % 2000) / 1000.0 - 1.0;
+    }
+
+    /* The straightforward version: sum of c[k] * power(x, k) */
+    clock_t start = clock();
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        double sum = 0.0;
+        for (int k = 0; k <= degree; k++)
+        {
+            sum += coeffs[k] * power(xs[i], k);
+        }
+        naive[i] = sum;
+    }
+    double naive_ms = elapsed_ms(start);
+
+    start = clock();
+    poly_eval_horner(horner, xs, BATCH_SIZE, coeffs, degree);
+    double horner_ms = elapsed_ms(start);
+
+    start = clock();
+    poly_eval_estrin(estrin, xs, BATCH_SIZE, coeffs, degree);
+    double estrin_ms = elapsed_ms(start);
+
+    double horner_err = 0.0, estrin_err = 0.0;
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        horner_err = fmax(horner_err, fabs(horner[i] - naive[i]));
+        estrin_err = fmax(estrin_err, fabs(estrin[i] - naive[i]));
+    }
+
+    printf("\nDegree-%d polynomial at %d points\n", degree, BATCH_SIZE);
+    printf("  sum of power() terms   %8.1f ms\n", naive_ms);
+    printf("  Horner (FMA)           %8.1f ms  max diff %.1e\n",
+           horner_ms,
+           horner_err);
+    printf("  Estrin (FMA)           %8.1f ms  max diff %.1e\n",
+           estrin_ms,
+           estrin_err);
+
+    free(estrin);
+    free(horner);
+    free(naive);
+    free(xs);
+}
+
+int main(int argc, char *argv[])
+{
+    /* "main bench" runs only the benchmarks, for comparing build variants */
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+    {
+        call_overhead_benchmark();
+        polynomial_benchmark();
+        batch_benchmark();
+        return 0;
+    }
+
     /* Using math utils */
     double value = 3.0;
     printf("Square of %.1f = %.1f\n", value, square(value));
@@ -27,5 +325,44 @@ int main()
     float mag = vector_magnitude(v1);
     printf("Magnitude of v1 = %.2f\n", mag);
 
+    /* Scaling changes the rounding, so compare in ulps rather than exactly */
+    Vector3 unit = vector_normalize(v1);
+    Vector3 unit_scaled = vector_normalize(vector_scale(v1, 1000.0f));
+    printf("normalize(v1) %s normalize(1000 v1) within 4 ulps\n",
+           vector_equals_ulps(unit, unit_scaled, 4) ? "==" : "!=");
+
+    /* Using the batch API: the same operations over arrays of vectors */
+    Vector3SoA a, b, c;
+    float lengths[3];
+    vector_soa_create(&a, 3);
+    vector_soa_create(&b, 3);
+    vector_soa_create(&c, 3);
+    for (size_t i = 0; i < 3; i++)
+    {
+        vector_soa_set(a, i, vector_create(1.0f + i, 2.0f, 3.0f));
+        vector_soa_set(b, i, v2);
+    }
+
+    vector_batch_cross(c, a, b, 3);
+    vector_batch_magnitude(lengths, c, 3);
+    for (size_t i = 0; i < 3; i++)
+    {
+        Vector3 r = vector_soa_get(c, i);
+        printf("a[%zu] x b[%zu] = (%.1f, %.1f, %.1f), length %.2f\n",
+               i,
+               i,
+               r.x,
+               r.y,
+               r.z,
+               lengths[i]);
+    }
+    vector_soa_destroy(&c);
+    vector_soa_destroy(&b);
+    vector_soa_destroy(&a);
+
+    call_overhead_benchmark();
+    polynomial_benchmark();
+    batch_benchmark();
+
     return 0;
 }
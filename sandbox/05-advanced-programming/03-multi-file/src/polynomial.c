@@ -0,0 +1,144 @@
+#include "polynomial.h"
+
+#include <math.h> /* for fma */
+
+/* Points are processed in blocks small enough that the per-block partial
+ * results stay in L1 while every coefficient is applied to them */
+#define POLY_BLOCK 64
+
+/*
+ * Build an FMA clone next to the baseline one and pick at load time (GCC
+ * function multiversioning). Without hardware FMA, fma() is a slow exact
+ * software routine, so the baseline clone is for portability only.
+ */
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define POLY_TARGETS __attribute__((target_clones("fma", "default")))
+#else
+#define POLY_TARGETS
+#endif
+
+POLY_TARGETS void poly_eval_horner(double *out,
+                                   const double *x,
+                                   size_t n,
+                                   const double *coeffs,
+                                   int degree)
+{
+    double acc[POLY_BLOCK];
+    double xs[POLY_BLOCK];
+
+    for (size_t base = 0; base < n; base += POLY_BLOCK)
+    {
+        size_t count = n - base < POLY_BLOCK ? n - base : POLY_BLOCK;
+
+        /* Copy the points first so out may alias x */
+        for (size_t i = 0; i < count; i++)
+        {
+            xs[i] = x[base + i];
+            acc[i] = degree >= 0 ? coeffs[degree] : 0.0;
+        }
+
+        /* Coefficient loop outside, point loop inside: the inner loop has
+         * no dependency between iterations and vectorizes */
+        for (int k = degree - 1; k >= 0; k--)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                acc[i] = fma(acc[i], xs[i], coeffs[k]);
+            }
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            out[base + i] = acc[i];
+        }
+    }
+}
+
+POLY_TARGETS void poly_eval_estrin(double *out,
+                                   const double *x,
+                                   size_t n,
+                                   const double *coeffs,
+                                   int degree)
+{
+    /* terms[j] holds one partial polynomial per point of the block */
+    double terms[(POLY_MAX_DEGREE + 2) / 2][POLY_BLOCK];
+    double xp[POLY_BLOCK];
+
+    if (degree < 1 || degree > POLY_MAX_DEGREE)
+    {
+        poly_eval_horner(out, x, n, coeffs, degree);
+        return;
+    }
+
+    for (size_t base = 0; base < n; base += POLY_BLOCK)
+    {
+        size_t count = n - base < POLY_BLOCK ? n - base : POLY_BLOCK;
+        int width = (degree + 2) / 2; /* number of live partials */
+
+        /* Level 0: c[2j] + c[2j+1]*x */
+        for (int j = 0; j < width; j++)
+        {
+            if (2 * j + 1 <= degree)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    terms[j][i] = fma(
+                        coeffs[2 * j + 1], x[base + i], coeffs[2 * j]);
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    terms[j][i] = coeffs[2 * j];
+                }
+            }
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            xp[i] = x[base + i] * x[base + i];
+        }
+
+        /* Each level pairs neighbours with the next power x^(2^level) and
+         * halves the number of partials. Partial j only reads 2j and 2j+1,
+         * which are never below j, so the update can run in place. */
+        while (width > 1)
+        {
+            int next = (width + 1) / 2;
+
+            for (int j = 0; j < next; j++)
+            {
+                if (2 * j + 1 < width)
+                {
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        terms[j][i] =
+                            fma(terms[2 * j + 1][i], xp[i], terms[2 * j][i]);
+                    }
+                }
+                else
+                {
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        terms[j][i] = terms[2 * j][i];
+                    }
+                }
+            }
+
+            if (next > 1)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    xp[i] *= xp[i];
+                }
+            }
+            width = next;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            out[base + i] = terms[0][i];
+        }
+    }
+}
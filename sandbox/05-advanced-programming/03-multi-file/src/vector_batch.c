@@ -0,0 +1,446 @@
+#define _POSIX_C_SOURCE 200112L /* for posix_memalign */
+
+#include "vector_batch.h"
+
+#include <float.h>  /* for FLT_MIN */
+#include <math.h>   /* for sqrtf, fabsf */
+#include <stdlib.h> /* for posix_memalign, free */
+#include <string.h> /* for memset, strcmp */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define HAVE_NEON_KERNELS 1
+#include <arm_neon.h>
+#endif
+
+/* Same threshold as vector_normalize in vector.c */
+static const float EPSILON = 0.00001f;
+
+/* One full set of batch operations for a single instruction set */
+typedef struct
+{
+    const char *name;
+    void (*add)(Vector3SoA out, Vector3SoA a, Vector3SoA b, size_t n);
+    void (*scale)(Vector3SoA out, Vector3SoA v, float scalar, size_t n);
+    void (*dot)(float *out, Vector3SoA a, Vector3SoA b, size_t n);
+    void (*cross)(Vector3SoA out, Vector3SoA a, Vector3SoA b, size_t n);
+    void (*magnitude)(float *out, Vector3SoA v, size_t n);
+    void (*normalize)(Vector3SoA out, Vector3SoA v, size_t n);
+    /* VECTOR_PRECISION_FAST versions of magnitude and normalize */
+    void (*magnitude_fast)(float *out, Vector3SoA v, size_t n);
+    void (*normalize_fast)(Vector3SoA out, Vector3SoA v, size_t n);
+} BatchKernels;
+
+/*
+ * Scalar range helpers: the whole scalar kernel set, and the tail loop of
+ * every SIMD kernel. Components are read into locals before any store so
+ * out may alias an input.
+ */
+static void add_range(Vector3SoA out,
+                      Vector3SoA a,
+                      Vector3SoA b,
+                      size_t i,
+                      size_t n)
+{
+    for (; i < n; i++)
+    {
+        out.x[i] = a.x[i] + b.x[i];
+        out.y[i] = a.y[i] + b.y[i];
+        out.z[i] = a.z[i] + b.z[i];
+    }
+}
+
+static void scale_range(Vector3SoA out,
+                        Vector3SoA v,
+                        float scalar,
+                        size_t i,
+                        size_t n)
+{
+    for (; i < n; i++)
+    {
+        out.x[i] = v.x[i] * scalar;
+        out.y[i] = v.y[i] * scalar;
+        out.z[i] = v.z[i] * scalar;
+    }
+}
+
+static void dot_range(float *out,
+                      Vector3SoA a,
+                      Vector3SoA b,
+                      size_t i,
+                      size_t n)
+{
+    for (; i < n; i++)
+    {
+        out[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+    }
+}
+
+static void cross_range(Vector3SoA out,
+                        Vector3SoA a,
+                        Vector3SoA b,
+                        size_t i,
+                        size_t n)
+{
+    for (; i < n; i++)
+    {
+        float ax = a.x[i], ay = a.y[i], az = a.z[i];
+        float bx = b.x[i], by = b.y[i], bz = b.z[i];
+
+        out.x[i] = ay * bz - az * by;
+        out.y[i] = az * bx - ax * bz;
+        out.z[i] = ax * by - ay * bx;
+    }
+}
+
+static void magnitude_range(float *out, Vector3SoA v, size_t i, size_t n)
+{
+    for (; i < n; i++)
+    {
+        out[i] = sqrtf(v.x[i] * v.x[i] + v.y[i] * v.y[i] + v.z[i] * v.z[i]);
+    }
+}
+
+static void normalize_range(Vector3SoA out, Vector3SoA v, size_t i, size_t n)
+{
+    for (; i < n; i++)
+    {
+        float x = v.x[i], y = v.y[i], z = v.z[i];
+        float mag = sqrtf(x * x + y * y + z * z);
+
+        if (fabsf(mag) < EPSILON)
+        {
+            out.x[i] = out.y[i] = out.z[i] = 0.0f;
+            continue;
+        }
+
+        float inv = 1.0f / mag;
+        out.x[i] = x * inv;
+        out.y[i] = y * inv;
+        out.z[i] = z * inv;
+    }
+}
+
+static void add_scalar(Vector3SoA out, Vector3SoA a, Vector3SoA b, size_t n)
+{
+    add_range(out, a, b, 0, n);
+}
+
+static void scale_scalar(Vector3SoA out, Vector3SoA v, float s, size_t n)
+{
+    scale_range(out, v, s, 0, n);
+}
+
+static void dot_scalar(float *out, Vector3SoA a, Vector3SoA b, size_t n)
+{
+    dot_range(out, a, b, 0, n);
+}
+
+static void cross_scalar(Vector3SoA out, Vector3SoA a, Vector3SoA b, size_t n)
+{
+    cross_range(out, a, b, 0, n);
+}
+
+static void magnitude_scalar(float *out, Vector3SoA v, size_t n)
+{
+    magnitude_range(out, v, 0, n);
+}
+
+static void normalize_scalar(Vector3SoA out, Vector3SoA v, size_t n)
+{
+    normalize_range(out, v, 0, n);
+}
+
+/* Scalar code has no estimate instruction, so its fast mode is exact */
+static const BatchKernels kernels_scalar = {
+    "scalar",
+    add_scalar,
+    scale_scalar,
+    dot_scalar,
+    cross_scalar,
+    magnitude_scalar,
+    normalize_scalar,
+    magnitude_scalar,
+    normalize_scalar,
+};
+
+/*
+ * SIMD kernel sets. The x86 ones are compiled with per-function target
+ * attributes, so the library still builds with plain -std=c99 and only
+ * runs AVX2/AVX-512 code on CPUs that report support.
+ */
+#ifdef HAVE_X86_KERNELS
+
+#define KERNEL(name) name##_sse
+#define KERNEL_NAME "sse"
+#define KERNEL_ATTR __attribute__((target("sse2")))
+#define VEC __m128
+#define VEC_WIDTH 4
+#define VEC_LOAD(p) _mm_loadu_ps(p)
+#define VEC_STORE(p, v) _mm_storeu_ps(p, v)
+#define VEC_SET1(f) _mm_set1_ps(f)
+#define VEC_ADD(a, b) _mm_add_ps(a, b)
+#define VEC_SUB(a, b) _mm_sub_ps(a, b)
+#define VEC_MUL(a, b) _mm_mul_ps(a, b)
+#define VEC_DIV(a, b) _mm_div_ps(a, b)
+#define VEC_SQRT(a) _mm_sqrt_ps(a)
+#define VEC_KEEP_UNLESS_ZERO(mag, v) \
+    _mm_andnot_ps(_mm_cmplt_ps(mag, _mm_set1_ps(EPSILON)), v)
+#define VEC_KEEP_WHERE_GE(a, lim, v) \
+    _mm_and_ps(_mm_cmpge_ps(a, _mm_set1_ps(lim)), v)
+#define VEC_RSQRT_EST(a) _mm_rsqrt_ps(a) /* 12-bit estimate */
+#include "vector_batch_kernels.h"
+
+#define KERNEL(name) name##_avx2
+#define KERNEL_NAME "avx2"
+#define KERNEL_ATTR __attribute__((target("avx2")))
+#define VEC __m256
+#define VEC_WIDTH 8
+#define VEC_LOAD(p) _mm256_loadu_ps(p)
+#define VEC_STORE(p, v) _mm256_storeu_ps(p, v)
+#define VEC_SET1(f) _mm256_set1_ps(f)
+#define VEC_ADD(a, b) _mm256_add_ps(a, b)
+#define VEC_SUB(a, b) _mm256_sub_ps(a, b)
+#define VEC_MUL(a, b) _mm256_mul_ps(a, b)
+#define VEC_DIV(a, b) _mm256_div_ps(a, b)
+#define VEC_SQRT(a) _mm256_sqrt_ps(a)
+#define VEC_KEEP_UNLESS_ZERO(mag, v) \
+    _mm256_andnot_ps(                \
+        _mm256_cmp_ps(mag, _mm256_set1_ps(EPSILON), _CMP_LT_OQ), v)
+#define VEC_KEEP_WHERE_GE(a, lim, v) \
+    _mm256_and_ps(_mm256_cmp_ps(a, _mm256_set1_ps(lim), _CMP_GE_OQ), v)
+#define VEC_RSQRT_EST(a) _mm256_rsqrt_ps(a) /* 12-bit estimate */
+#include "vector_batch_kernels.h"
+
+#define KERNEL(name) name##_avx512
+#define KERNEL_NAME "avx512"
+#define KERNEL_ATTR __attribute__((target("avx512f")))
+#define VEC __m512
+#define VEC_WIDTH 16
+#define VEC_LOAD(p) _mm512_loadu_ps(p)
+#define VEC_STORE(p, v) _mm512_storeu_ps(p, v)
+#define VEC_SET1(f) _mm512_set1_ps(f)
+#define VEC_ADD(a, b) _mm512_add_ps(a, b)
+#define VEC_SUB(a, b) _mm512_sub_ps(a, b)
+#define VEC_MUL(a, b) _mm512_mul_ps(a, b)
+#define VEC_DIV(a, b) _mm512_div_ps(a, b)
+#define VEC_SQRT(a) _mm512_sqrt_ps(a)
+#define VEC_KEEP_UNLESS_ZERO(mag, v) \
+    _mm512_maskz_mov_ps(             \
+        _mm512_cmp_ps_mask(mag, _mm512_set1_ps(EPSILON), _CMP_NLT_UQ), v)
+#define VEC_KEEP_WHERE_GE(a, lim, v) \
+    _mm512_maskz_mov_ps(             \
+        _mm512_cmp_ps_mask(a, _mm512_set1_ps(lim), _CMP_GE_OQ), v)
+#define VEC_RSQRT_EST(a) _mm512_rsqrt14_ps(a) /* 14-bit estimate */
+#include "vector_batch_kernels.h"
+
+/* __builtin_cpu_supports needs a string literal, hence one wrapper each */
+static bool cpu_has_sse2(void)
+{
+    return __builtin_cpu_supports("sse2");
+}
+
+static bool cpu_has_avx2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+static bool cpu_has_avx512f(void)
+{
+    return __builtin_cpu_supports("avx512f");
+}
+
+#endif /* HAVE_X86_KERNELS */
+
+#ifdef HAVE_NEON_KERNELS
+
+/* AdvSIMD is mandatory on AArch64, so no runtime check is needed */
+#define KERNEL(name) name##_neon
+#define KERNEL_NAME "neon"
+#define KERNEL_ATTR
+#define VEC float32x4_t
+#define VEC_WIDTH 4
+#define VEC_LOAD(p) vld1q_f32(p)
+#define VEC_STORE(p, v) vst1q_f32(p, v)
+#define VEC_SET1(f) vdupq_n_f32(f)
+#define VEC_ADD(a, b) vaddq_f32(a, b)
+#define VEC_SUB(a, b) vsubq_f32(a, b)
+#define VEC_MUL(a, b) vmulq_f32(a, b)
+#define VEC_DIV(a, b) vdivq_f32(a, b)
+#define VEC_SQRT(a) vsqrtq_f32(a)
+#define VEC_KEEP_UNLESS_ZERO(mag, v)                  \
+    vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(v), \
+                                    vcltq_f32(mag, vdupq_n_f32(EPSILON))))
+#define VEC_KEEP_WHERE_GE(a, lim, v)                           \
+    vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v), \
+                                    vcgeq_f32(a, vdupq_n_f32(lim))))
+#define VEC_RSQRT_EST(a) vrsqrteq_f32(a) /* 8-bit estimate */
+#include "vector_batch_kernels.h"
+
+#endif /* HAVE_NEON_KERNELS */
+
+static bool cpu_always(void)
+{
+    return true;
+}
+
+/* Built-in kernel sets, best first; the scalar set always matches */
+static const struct
+{
+    const BatchKernels *kernels;
+    bool (*supported)(void);
+} kernel_table[] = {
+#ifdef HAVE_X86_KERNELS
+    {&kernels_avx512, cpu_has_avx512f},
+    {&kernels_avx2, cpu_has_avx2},
+    {&kernels_sse, cpu_has_sse2},
+#endif
+#ifdef HAVE_NEON_KERNELS
+    {&kernels_neon, cpu_always},
+#endif
+    {&kernels_scalar, cpu_always},
+};
+
+#define KERNEL_COUNT (sizeof(kernel_table) / sizeof(kernel_table[0]))
+
+static const BatchKernels *active = &kernels_scalar;
+static VectorPrecision precision = VECTOR_PRECISION_EXACT;
+
+/*
+ * Pick the kernels once before main runs, so the per-call dispatch is a
+ * plain pointer load with no first-use race between threads.
+ */
+__attribute__((constructor)) static void select_best_kernels(void)
+{
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init(); /* required before cpu_supports in a constructor */
+#endif
+    for (size_t i = 0; i < KERNEL_COUNT; i++)
+    {
+        if (kernel_table[i].supported())
+        {
+            active = kernel_table[i].kernels;
+            return;
+        }
+    }
+}
+
+const char *vector_batch_kernel(void)
+{
+    return active->name;
+}
+
+bool vector_batch_select(const char *name)
+{
+    for (size_t i = 0; i < KERNEL_COUNT; i++)
+    {
+        if (strcmp(kernel_table[i].kernels->name, name) == 0)
+        {
+            if (!kernel_table[i].supported()) return false;
+
+            active = kernel_table[i].kernels;
+            return true;
+        }
+    }
+    return false;
+}
+
+void vector_batch_set_precision(VectorPrecision mode)
+{
+    precision = mode;
+}
+
+VectorPrecision vector_batch_precision(void)
+{
+    return precision;
+}
+
+bool vector_soa_create(Vector3SoA *soa, size_t n)
+{
+    void *x = NULL, *y = NULL, *z = NULL;
+    size_t bytes = (n > 0 ? n : 1) * sizeof(float);
+
+    memset(soa, 0, sizeof(*soa));
+    if (posix_memalign(&x, 64, bytes) != 0) return false;
+    if (posix_memalign(&y, 64, bytes) != 0)
+    {
+        free(x);
+        return false;
+    }
+    if (posix_memalign(&z, 64, bytes) != 0)
+    {
+        free(x);
+        free(y);
+        return false;
+    }
+
+    soa->x = x;
+    soa->y = y;
+    soa->z = z;
+    return true;
+}
+
+void vector_soa_destroy(Vector3SoA *soa)
+{
+    free(soa->x);
+    free(soa->y);
+    free(soa->z);
+    memset(soa, 0, sizeof(*soa));
+}
+
+Vector3 vector_soa_get(Vector3SoA soa, size_t i)
+{
+    return vector_create(soa.x[i], soa.y[i], soa.z[i]);
+}
+
+void vector_soa_set(Vector3SoA soa, size_t i, Vector3 v)
+{
+    soa.x[i] = v.x;
+    soa.y[i] = v.y;
+    soa.z[i] = v.z;
+}
+
+/* Public entry points: one indirect call per batch, not per vector */
+void vector_batch_add(Vector3SoA out, Vector3SoA a, Vector3SoA b, size_t n)
+{
+    active->add(out, a, b, n);
+}
+
+void vector_batch_scale(Vector3SoA out, Vector3SoA v, float scalar, size_t n)
+{
+    active->scale(out, v, scalar, n);
+}
+
+void vector_batch_dot(float *out, Vector3SoA a, Vector3SoA b, size_t n)
+{
+    active->dot(out, a, b, n);
+}
+
+void vector_batch_cross(Vector3SoA out, Vector3SoA a, Vector3SoA b, size_t n)
+{
+    active->cross(out, a, b, n);
+}
+
+void vector_batch_magnitude(float *out, Vector3SoA v, size_t n)
+{
+    if (precision == VECTOR_PRECISION_FAST)
+    {
+        active->magnitude_fast(out, v, n);
+        return;
+    }
+    active->magnitude(out, v, n);
+}
+
+void vector_batch_normalize(Vector3SoA out, Vector3SoA v, size_t n)
+{
+    if (precision == VECTOR_PRECISION_FAST)
+    {
+        active->normalize_fast(out, v, n);
+        return;
+    }
+    active->normalize(out, v, n);
+}
@@ -0,0 +1,213 @@
+/*
+ * Kernel template for vector_batch.c - private, and deliberately without an
+ * include guard: it is included once per instruction set after defining
+ *
+ *   KERNEL(name)              name mangling, e.g. name##_avx2
+ *   KERNEL_NAME               name reported by vector_batch_kernel()
+ *   KERNEL_ATTR               target attribute for the kernel functions
+ *   VEC, VEC_WIDTH            register type and floats per register
+ *   VEC_LOAD(p), VEC_STORE(p, v), VEC_SET1(f)
+ *   VEC_ADD, VEC_SUB, VEC_MUL, VEC_DIV, VEC_SQRT
+ *   VEC_KEEP_UNLESS_ZERO(mag, v)  v, or 0 where mag < EPSILON
+ *   VEC_KEEP_WHERE_GE(a, lim, v)  v where a >= lim, else 0 (also for NaN)
+ *   VEC_RSQRT_EST(a)          hardware 1/sqrt(a) estimate
+ *
+ * Each kernel handles whole registers and hands the remainder to the scalar
+ * range helpers, so every kernel set gives the same results as the scalar
+ * code (same operation order, no FMA contraction). The *_fast kernels are
+ * the exception: they trade accuracy for speed (see VECTOR_FAST_REL_ERROR).
+ */
+
+static KERNEL_ATTR void KERNEL(batch_add)(Vector3SoA out,
+                                          Vector3SoA a,
+                                          Vector3SoA b,
+                                          size_t n)
+{
+    size_t i = 0;
+    for (; i + VEC_WIDTH <= n; i += VEC_WIDTH)
+    {
+        VEC_STORE(out.x + i, VEC_ADD(VEC_LOAD(a.x + i), VEC_LOAD(b.x + i)));
+        VEC_STORE(out.y + i, VEC_ADD(VEC_LOAD(a.y + i), VEC_LOAD(b.y + i)));
+        VEC_STORE(out.z + i, VEC_ADD(VEC_LOAD(a.z + i), VEC_LOAD(b.z + i)));
+    }
+    add_range(out, a, b, i, n);
+}
+
+static KERNEL_ATTR void KERNEL(batch_scale)(Vector3SoA out,
+                                            Vector3SoA v,
+                                            float scalar,
+                                            size_t n)
+{
+    VEC s = VEC_SET1(scalar);
+    size_t i = 0;
+    for (; i + VEC_WIDTH <= n; i += VEC_WIDTH)
+    {
+        VEC_STORE(out.x + i, VEC_MUL(VEC_LOAD(v.x + i), s));
+        VEC_STORE(out.y + i, VEC_MUL(VEC_LOAD(v.y + i), s));
+        VEC_STORE(out.z + i, VEC_MUL(VEC_LOAD(v.z + i), s));
+    }
+    scale_range(out, v, scalar, i, n);
+}
+
+static KERNEL_ATTR void KERNEL(batch_dot)(float *out,
+                                          Vector3SoA a,
+                                          Vector3SoA b,
+                                          size_t n)
+{
+    size_t i = 0;
+    for (; i + VEC_WIDTH <= n; i += VEC_WIDTH)
+    {
+        VEC xx = VEC_MUL(VEC_LOAD(a.x + i), VEC_LOAD(b.x + i));
+        VEC yy = VEC_MUL(VEC_LOAD(a.y + i), VEC_LOAD(b.y + i));
+        VEC zz = VEC_MUL(VEC_LOAD(a.z + i), VEC_LOAD(b.z + i));
+        VEC_STORE(out + i, VEC_ADD(VEC_ADD(xx, yy), zz));
+    }
+    dot_range(out, a, b, i, n);
+}
+
+static KERNEL_ATTR void KERNEL(batch_cross)(Vector3SoA out,
+                                            Vector3SoA a,
+                                            Vector3SoA b,
+                                            size_t n)
+{
+    size_t i = 0;
+    for (; i + VEC_WIDTH <= n; i += VEC_WIDTH)
+    {
+        /* Load everything first so out may alias a or b */
+        VEC ax = VEC_LOAD(a.x + i), ay = VEC_LOAD(a.y + i);
+        VEC az = VEC_LOAD(a.z + i);
+        VEC bx = VEC_LOAD(b.x + i), by = VEC_LOAD(b.y + i);
+        VEC bz = VEC_LOAD(b.z + i);
+
+        VEC_STORE(out.x + i, VEC_SUB(VEC_MUL(ay, bz), VEC_MUL(az, by)));
+        VEC_STORE(out.y + i, VEC_SUB(VEC_MUL(az, bx), VEC_MUL(ax, bz)));
+        VEC_STORE(out.z + i, VEC_SUB(VEC_MUL(ax, by), VEC_MUL(ay, bx)));
+    }
+    cross_range(out, a, b, i, n);
+}
+
+static KERNEL_ATTR void KERNEL(batch_magnitude)(float *out,
+                                                Vector3SoA v,
+                                                size_t n)
+{
+    size_t i = 0;
+    for (; i + VEC_WIDTH <= n; i += VEC_WIDTH)
+    {
+        VEC x = VEC_LOAD(v.x + i);
+        VEC y = VEC_LOAD(v.y + i);
+        VEC z = VEC_LOAD(v.z + i);
+        VEC dot = VEC_ADD(VEC_ADD(VEC_MUL(x, x), VEC_MUL(y, y)),
+                          VEC_MUL(z, z));
+        VEC_STORE(out + i, VEC_SQRT(dot));
+    }
+    magnitude_range(out, v, i, n);
+}
+
+static KERNEL_ATTR void KERNEL(batch_normalize)(Vector3SoA out,
+                                                Vector3SoA v,
+                                                size_t n)
+{
+    VEC one = VEC_SET1(1.0f);
+    size_t i = 0;
+    for (; i + VEC_WIDTH <= n; i += VEC_WIDTH)
+    {
+        VEC x = VEC_LOAD(v.x + i);
+        VEC y = VEC_LOAD(v.y + i);
+        VEC z = VEC_LOAD(v.z + i);
+        VEC mag = VEC_SQRT(VEC_ADD(VEC_ADD(VEC_MUL(x, x), VEC_MUL(y, y)),
+                                   VEC_MUL(z, z)));
+        /* 1/0 gives inf and 0*inf gives NaN; the mask clears those lanes */
+        VEC inv = VEC_DIV(one, mag);
+
+        VEC_STORE(out.x + i, VEC_KEEP_UNLESS_ZERO(mag, VEC_MUL(x, inv)));
+        VEC_STORE(out.y + i, VEC_KEEP_UNLESS_ZERO(mag, VEC_MUL(y, inv)));
+        VEC_STORE(out.z + i, VEC_KEEP_UNLESS_ZERO(mag, VEC_MUL(z, inv)));
+    }
+    normalize_range(out, v, i, n);
+}
+
+/*
+ * Fast-precision kernels: estimate y ~ 1/sqrt(d) and refine it with one
+ * Newton-Raphson step, y' = y * (1.5 - 0.5 * d * y * y), which roughly
+ * doubles the number of correct bits. No sqrt and no divide.
+ */
+static KERNEL_ATTR VEC KERNEL(rsqrt_refined)(VEC d)
+{
+    VEC y = VEC_RSQRT_EST(d);
+    VEC half_dyy = VEC_MUL(VEC_MUL(VEC_SET1(0.5f), d), VEC_MUL(y, y));
+    return VEC_MUL(y, VEC_SUB(VEC_SET1(1.5f), half_dyy));
+}
+
+static KERNEL_ATTR void KERNEL(batch_magnitude_fast)(float *out,
+                                                     Vector3SoA v,
+                                                     size_t n)
+{
+    size_t i = 0;
+    for (; i + VEC_WIDTH <= n; i += VEC_WIDTH)
+    {
+        VEC x = VEC_LOAD(v.x + i);
+        VEC y = VEC_LOAD(v.y + i);
+        VEC z = VEC_LOAD(v.z + i);
+        VEC dot = VEC_ADD(VEC_ADD(VEC_MUL(x, x), VEC_MUL(y, y)),
+                          VEC_MUL(z, z));
+        /* |v| = d / sqrt(d); the estimate is inf at 0 (and unreliable for
+         * subnormal d), so those lanes are forced to 0 */
+        VEC mag = VEC_MUL(dot, KERNEL(rsqrt_refined)(dot));
+        VEC_STORE(out + i, VEC_KEEP_WHERE_GE(dot, FLT_MIN, mag));
+    }
+    magnitude_range(out, v, i, n);
+}
+
+static KERNEL_ATTR void KERNEL(batch_normalize_fast)(Vector3SoA out,
+                                                     Vector3SoA v,
+                                                     size_t n)
+{
+    size_t i = 0;
+    for (; i + VEC_WIDTH <= n; i += VEC_WIDTH)
+    {
+        VEC x = VEC_LOAD(v.x + i);
+        VEC y = VEC_LOAD(v.y + i);
+        VEC z = VEC_LOAD(v.z + i);
+        VEC dot = VEC_ADD(VEC_ADD(VEC_MUL(x, x), VEC_MUL(y, y)),
+                          VEC_MUL(z, z));
+        VEC inv = KERNEL(rsqrt_refined)(dot);
+
+        /* |v| < EPSILON, compared squared to skip the sqrt */
+        VEC_STORE(out.x + i,
+                  VEC_KEEP_WHERE_GE(dot, EPSILON * EPSILON, VEC_MUL(x, inv)));
+        VEC_STORE(out.y + i,
+                  VEC_KEEP_WHERE_GE(dot, EPSILON * EPSILON, VEC_MUL(y, inv)));
+        VEC_STORE(out.z + i,
+                  VEC_KEEP_WHERE_GE(dot, EPSILON * EPSILON, VEC_MUL(z, inv)));
+    }
+    normalize_range(out, v, i, n);
+}
+
+static const BatchKernels KERNEL(kernels) = {
+    KERNEL_NAME,
+    KERNEL(batch_add),
+    KERNEL(batch_scale),
+    KERNEL(batch_dot),
+    KERNEL(batch_cross),
+    KERNEL(batch_magnitude),
+    KERNEL(batch_normalize),
+    KERNEL(batch_magnitude_fast),
+    KERNEL(batch_normalize_fast),
+};
+
+#undef KERNEL
+#undef KERNEL_NAME
+#undef KERNEL_ATTR
+#undef VEC
+#undef VEC_WIDTH
+#undef VEC_LOAD
+#undef VEC_STORE
+#undef VEC_SET1
+#undef VEC_ADD
+#undef VEC_SUB
+#undef VEC_MUL
+#undef VEC_DIV
+#undef VEC_SQRT
+#undef VEC_KEEP_UNLESS_ZERO
+#undef VEC_KEEP_WHERE_GE
+#undef VEC_RSQRT_EST
@@ -0,0 +1,199 @@
+// String interning: each distinct string is stored once and named by a
+// 32-bit handle.
+//
+// Records that each keep their own copy of a name (a char[50] field, or a
+// strdup per object) pay for every duplicate, and comparing two names
+// means comparing bytes. An InternPool hash-conses strings instead:
+//
+//   InternId id = intern_cstr(&pool, "Apple");    // stores "Apple" once
+//   intern_cstr(&pool, "Apple") == id             // same string, same id
+//   intern_str(&pool, id)                          // "Apple", NUL-terminated
+//
+// so a record holds a 4-byte id, equal names compare with ==, and the id
+// doubles as a dense index for per-name side tables. The bytes live in
+// arena chunks that are never moved or freed individually, so pointers
+// returned by intern_str stay valid until intern_free. Lookup is an
+// open-addressing table of ids keyed by a stored 32-bit FNV-1a hash,
+// which also makes growing the table a pass over the entries without
+// rehashing any string.
+#ifndef INTERN_POOL_H
+#define INTERN_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint32_t InternId;  // 1-based; 0 means no string
+
+#define INTERN_NONE 0
+#define INTERN_CHUNK_SIZE 4096  // Arena chunk; longer strings get their own
+
+typedef struct InternChunk
+{
+    struct InternChunk *older;
+    size_t used;
+    size_t size;
+    char data[];
+} InternChunk;
+
+typedef struct
+{
+    const char *str;
+    uint32_t length;
+    uint32_t hash;
+} InternEntry;
+
+typedef struct
+{
+    InternChunk *chunks;   // Newest first
+    InternEntry *entries;  // entries[id - 1]
+    uint32_t count;
+    uint32_t entry_capacity;
+    InternId *slots;  // Power-of-two table of ids, 0 = empty
+    uint32_t slot_capacity;
+    size_t requests;  // intern_* calls, to report how much was shared
+    size_t bytes;     // String bytes stored, NULs included
+} InternPool;
+
+#define INTERN_POOL_INIT {NULL, NULL, 0, 0, NULL, 0, 0, 0}
+
+static inline uint32_t intern_hash(const char *s, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ (unsigned char) s[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static inline char *intern_arena_alloc(InternPool *pool, size_t size)
+{
+    InternChunk *chunk = pool->chunks;
+    if (chunk == NULL || chunk->size - chunk->used < size)
+    {
+        size_t capacity = size > INTERN_CHUNK_SIZE ? size : INTERN_CHUNK_SIZE;
+        chunk = (InternChunk *) malloc(sizeof(InternChunk) + capacity);
+        if (chunk == NULL) return NULL;
+        chunk->used = 0;
+        chunk->size = capacity;
+        chunk->older = pool->chunks;
+        pool->chunks = chunk;
+    }
+    char *p = chunk->data + chunk->used;
+    chunk->used += size;
+    return p;
+}
+
+static inline bool intern_grow_slots(InternPool *pool)
+{
+    uint32_t capacity = pool->slot_capacity ? pool->slot_capacity * 2 : 64;
+    InternId *slots = (InternId *) calloc(capacity, sizeof(InternId));
+    if (slots == NULL) return false;
+
+    for (uint32_t id = 1; id <= pool->count; id++)
+    {
+        uint32_t slot = pool->entries[id - 1].hash & (capacity - 1);
+        while (slots[slot] != INTERN_NONE) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = id;
+    }
+    free(pool->slots);
+    pool->slots = slots;
+    pool->slot_capacity = capacity;
+    return true;
+}
+
+// Id of the string if it is already interned, else INTERN_NONE
+static inline InternId intern_find(const InternPool *pool,
+                                   const char *s,
+                                   size_t length)
+{
+    if (pool->slot_capacity == 0) return INTERN_NONE;
+    uint32_t hash = intern_hash(s, length);
+    uint32_t mask = pool->slot_capacity - 1;
+    for (uint32_t slot = hash & mask;; slot = (slot + 1) & mask)
+    {
+        InternId id = pool->slots[slot];
+        if (id == INTERN_NONE) return INTERN_NONE;
+        const InternEntry *e = &pool->entries[id - 1];
+        if (e->hash == hash && e->length == length
+            && memcmp(e->str, s, length) == 0)
+        {
+            return id;
+        }
+    }
+}
+
+// Id of the string, adding it if new; INTERN_NONE if out of memory
+static inline InternId intern_n(InternPool *pool, const char *s, size_t length)
+{
+    pool->requests++;
+    InternId id = intern_find(pool, s, length);
+    if (id != INTERN_NONE) return id;
+    if (length >= UINT32_MAX || pool->count == UINT32_MAX - 1) return INTERN_NONE;
+
+    // Keep the table at most half full
+    if (2 * (pool->count + 1) > pool->slot_capacity && !intern_grow_slots(pool))
+    {
+        return INTERN_NONE;
+    }
+    if (pool->count == pool->entry_capacity)
+    {
+        uint32_t capacity = pool->entry_capacity ? pool->entry_capacity * 2 : 64;
+        InternEntry *entries = (InternEntry *) realloc(
+            pool->entries, capacity * sizeof(InternEntry));
+        if (entries == NULL) return INTERN_NONE;
+        pool->entries = entries;
+        pool->entry_capacity = capacity;
+    }
+
+    char *copy = intern_arena_alloc(pool, length + 1);
+    if (copy == NULL) return INTERN_NONE;
+    memcpy(copy, s, length);
+    copy[length] = '\0';
+    pool->bytes += length + 1;
+
+    uint32_t hash = intern_hash(s, length);
+    id = ++pool->count;
+    pool->entries[id - 1] = (InternEntry){copy, (uint32_t) length, hash};
+
+    uint32_t mask = pool->slot_capacity - 1;
+    uint32_t slot = hash & mask;
+    while (pool->slots[slot] != INTERN_NONE) slot = (slot + 1) & mask;
+    pool->slots[slot] = id;
+    return id;
+}
+
+static inline InternId intern_cstr(InternPool *pool, const char *s)
+{
+    return intern_n(pool, s, strlen(s));
+}
+
+// The string for an id, "" for INTERN_NONE
+static inline const char *intern_str(const InternPool *pool, InternId id)
+{
+    return id == INTERN_NONE ? "" : pool->entries[id - 1].str;
+}
+
+static inline size_t intern_length(const InternPool *pool, InternId id)
+{
+    return id == INTERN_NONE ? 0 : pool->entries[id - 1].length;
+}
+
+// Release every string at once; all ids and pointers become invalid
+static inline void intern_free(InternPool *pool)
+{
+    while (pool->chunks)
+    {
+        InternChunk *older = pool->chunks->older;
+        free(pool->chunks);
+        pool->chunks = older;
+    }
+    free(pool->entries);
+    free(pool->slots);
+    *pool = (InternPool) INTERN_POOL_INIT;
+}
+
+#endif  // INTERN_POOL_H
@@ -0,0 +1,271 @@
+// Opt-in timeline tracing with scoped timers.
+//
+// TRACE_SCOPE("name") at the top of a block records how long the block
+// ran, from that point until control leaves it by any path (return,
+// break, goto), using GCC's cleanup attribute:
+//
+//   void handle_request(Request *req)
+//   {
+//       TRACE_FUNCTION();             // same as TRACE_SCOPE(__func__)
+//       parse(req);
+//       {
+//           TRACE_SCOPE("respond");
+//           respond(req);
+//       }
+//   }
+//
+// scope_trace_write_json() then writes every recorded span in the Chrome
+// trace event format, which chrome://tracing, Perfetto (ui.perfetto.dev)
+// and speedscope open as a per-thread timeline.
+//
+// Unless SCOPE_TRACE is defined before this header, every macro and
+// function here compiles to nothing, so annotations can stay in hot code.
+// With it, a span costs two reads of the CPU's tick counter (rdtsc,
+// cntvct_el0, else CLOCK_MONOTONIC) and one 24-byte store into a
+// per-thread buffer: no locks and no formatting. Ticks are converted to
+// microseconds only when the trace is written, by comparing the counter
+// with CLOCK_MONOTONIC over the whole run. Names are stored by pointer and
+// must be string literals (or otherwise outlive the trace).
+//
+// Each thread's buffer holds SCOPE_TRACE_EVENTS spans; later ones are
+// counted as dropped. Buffers are never freed, and the trace should be
+// written once the traced threads have stopped.
+#ifndef SCOPE_TRACE_H
+#define SCOPE_TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define SCOPE_TRACE_CAT_(a, b) a##b
+#define SCOPE_TRACE_CAT(a, b)  SCOPE_TRACE_CAT_(a, b)
+
+#ifdef SCOPE_TRACE
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef SCOPE_TRACE_EVENTS
+#define SCOPE_TRACE_EVENTS 16384  // Spans per thread
+#endif
+
+typedef struct
+{
+    const char *name;
+    uint64_t begin;  // Ticks
+    uint64_t end;
+} ScopeTraceEvent;
+
+typedef struct ScopeTraceBuffer
+{
+    struct ScopeTraceBuffer *next;
+    uint32_t tid;
+    uint32_t count;
+    uint64_t dropped;
+    char thread_name[32];
+    ScopeTraceEvent events[SCOPE_TRACE_EVENTS];
+} ScopeTraceBuffer;
+
+// Registry of every thread's buffer; the lock is only taken when a thread
+// records its first span and when the trace is written
+static struct
+{
+    pthread_mutex_t lock;
+    ScopeTraceBuffer *buffers;
+    uint32_t next_tid;
+    uint64_t origin_ticks;  // Reference points for converting ticks
+    uint64_t origin_ns;
+} scope_trace_state = {PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0, 0};
+
+static __thread ScopeTraceBuffer *scope_trace_local;
+
+static inline uint64_t scope_trace_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+// Unfenced on purpose: a span is microseconds long, and a few cycles of
+// reordering at either end do not show on a timeline
+static inline uint64_t scope_trace_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t low, high;
+    __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t) high << 32) | low;
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return scope_trace_ns();
+#endif
+}
+
+static ScopeTraceBuffer *scope_trace_register(void)
+{
+    ScopeTraceBuffer *buffer = (ScopeTraceBuffer *) malloc(sizeof(*buffer));
+    if (buffer == NULL) return NULL;
+    buffer->count = 0;
+    buffer->dropped = 0;
+    buffer->thread_name[0] = '\0';
+
+    pthread_mutex_lock(&scope_trace_state.lock);
+    if (scope_trace_state.buffers == NULL && scope_trace_state.origin_ns == 0)
+    {
+        scope_trace_state.origin_ticks = scope_trace_ticks();
+        scope_trace_state.origin_ns = scope_trace_ns();
+    }
+    buffer->tid = ++scope_trace_state.next_tid;
+    buffer->next = scope_trace_state.buffers;
+    scope_trace_state.buffers = buffer;
+    pthread_mutex_unlock(&scope_trace_state.lock);
+
+    scope_trace_local = buffer;
+    return buffer;
+}
+
+static inline void scope_trace_record(const char *name,
+                                      uint64_t begin,
+                                      uint64_t end)
+{
+    ScopeTraceBuffer *buffer = scope_trace_local;
+    if (buffer == NULL && (buffer = scope_trace_register()) == NULL) return;
+    if (buffer->count == SCOPE_TRACE_EVENTS)
+    {
+        buffer->dropped++;
+        return;
+    }
+    ScopeTraceEvent *event = &buffer->events[buffer->count++];
+    event->name = name;
+    event->begin = begin;
+    event->end = end;
+}
+
+// Label the calling thread's track in the viewer
+static inline void scope_trace_thread_name(const char *name)
+{
+    ScopeTraceBuffer *buffer = scope_trace_local;
+    if (buffer == NULL && (buffer = scope_trace_register()) == NULL) return;
+    snprintf(buffer->thread_name, sizeof(buffer->thread_name), "%s", name);
+}
+
+typedef struct
+{
+    const char *name;
+    uint64_t begin;
+} ScopeTraceSpan;
+
+static inline void scope_trace_close(ScopeTraceSpan *span)
+{
+    scope_trace_record(span->name, span->begin, scope_trace_ticks());
+}
+
+#define TRACE_SCOPE(name)                                              \
+    ScopeTraceSpan SCOPE_TRACE_CAT(scope_trace_span_, __LINE__)        \
+        __attribute__((cleanup(scope_trace_close), unused)) = {        \
+            (name), scope_trace_ticks()}
+
+#define TRACE_FUNCTION() TRACE_SCOPE(__func__)
+
+static void scope_trace_json_string(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s; s++)
+    {
+        unsigned char c = (unsigned char) *s;
+        if (c == '"' || c == '\\')
+            fprintf(out, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(out, "\\u%04x", c);
+        else
+            fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+// Write all spans recorded so far as Chrome trace JSON. Returns the number
+// of spans written, or -1 if the file cannot be written.
+static inline long scope_trace_write_json(const char *path)
+{
+    FILE *out = fopen(path, "w");
+    if (out == NULL) return -1;
+
+    pthread_mutex_lock(&scope_trace_state.lock);
+
+    // Ticks per microsecond, measured across the whole run
+    uint64_t elapsed_ns = scope_trace_ns() - scope_trace_state.origin_ns;
+    uint64_t elapsed_ticks =
+        scope_trace_ticks() - scope_trace_state.origin_ticks;
+    double ticks_per_us =
+        elapsed_ns > 0 ? elapsed_ticks * 1000.0 / elapsed_ns : 1000.0;
+    if (ticks_per_us <= 0) ticks_per_us = 1000.0;
+
+    long written = 0;
+    uint64_t dropped = 0;
+    int first = 1;
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (ScopeTraceBuffer *b = scope_trace_state.buffers; b; b = b->next)
+    {
+        if (b->thread_name[0])
+        {
+            fprintf(out,
+                    "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,"
+                    "\"tid\":%u,\"args\":{\"name\":",
+                    first ? "" : ",\n",
+                    b->tid);
+            scope_trace_json_string(out, b->thread_name);
+            fputs("}}", out);
+            first = 0;
+        }
+        for (uint32_t i = 0; i < b->count; i++)
+        {
+            const ScopeTraceEvent *e = &b->events[i];
+            fprintf(out, "%s{\"ph\":\"X\",\"name\":", first ? "" : ",\n");
+            scope_trace_json_string(out, e->name);
+            fprintf(out,
+                    ",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    b->tid,
+                    (double) (e->begin - scope_trace_state.origin_ticks)
+                        / ticks_per_us,
+                    (double) (e->end - e->begin) / ticks_per_us);
+            first = 0;
+            written++;
+        }
+        dropped += b->dropped;
+    }
+    fprintf(out, "\n]}\n");
+
+    pthread_mutex_unlock(&scope_trace_state.lock);
+
+    if (dropped > 0)
+    {
+        fprintf(stderr,
+                "scope trace: %llu spans dropped, raise SCOPE_TRACE_EVENTS\n",
+                (unsigned long long) dropped);
+    }
+    if (fclose(out) != 0) return -1;
+    return written;
+}
+
+#else
+
+#define TRACE_SCOPE(name) ((void) 0)
+#define TRACE_FUNCTION()  ((void) 0)
+
+static inline void scope_trace_thread_name(const char *name)
+{
+    (void) name;
+}
+
+static inline long scope_trace_write_json(const char *path)
+{
+    (void) path;
+    return 0;
+}
+
+#endif  // SCOPE_TRACE
+
+#endif  // SCOPE_TRACE_H
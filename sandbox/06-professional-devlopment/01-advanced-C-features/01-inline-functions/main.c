@@ -1,7 +1,10 @@
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
+#include "../../../bench/bench_report.h"
+
 // Basic inline function
 inline int max(int a, int b)
 {
@@ -60,8 +63,8 @@ void benchmark_inline()
 {
     printf("\n=== Benchmark: Inline vs Non-inline ===\n");
 
-    const int ARRAY_SIZE = 10000;
-    const int ITERATIONS = 1000000;
+    const int ARRAY_SIZE = (int) bench_param("SIZE", 10000);
+    const int ITERATIONS = (int) bench_param("ITERATIONS", 1000000);
 
     // Create a large array of values
     double* large_array = (double*) malloc(ARRAY_SIZE * sizeof(double));
@@ -101,15 +104,346 @@ void benchmark_inline()
     printf("Time with non-inline function: %.4f seconds\n", time_noinline);
     printf("Difference: %.2f%%\n",
            (time_noinline - time_inline) / time_noinline * 100.0);
+    bench_report("inline", time_inline * 1e3, "ms", BENCH_LOWER_IS_BETTER);
+    bench_report(
+        "noinline", time_noinline * 1e3, "ms", BENCH_LOWER_IS_BETTER);
 
     // Free allocated memory
     free(large_array);
 }
 
+// ==== Reduction kernels ====
+
+// Independent accumulators per kernel. A single `sum += x` chain is bound
+// by add latency (about 4 cycles per element); 16 lanes keep enough adds
+// in flight, and because each lane is its own chain the compiler can map
+// them onto vector registers without reassociating anything.
+#define REDUCE_LANES 16
+
+// Below this many elements sum_pairwise stops splitting
+#define PAIRWISE_BLOCK 256
+
+// Build AVX-512, AVX2 and baseline clones of each kernel and pick one at
+// load time (GCC function multiversioning)
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define REDUCE_CLONES \
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define REDUCE_CLONES
+#endif
+
+// Summary of one array; variance is the population variance
+typedef struct
+{
+    double sum;
+    double mean;
+    double min;
+    double max;
+    double variance;
+} Stats;
+
+// Same single-accumulator loop as calculate_average, for comparison
+double sum_naive(const double* values, int count)
+{
+    double sum = 0.0;
+    for (int i = 0; i < count; i++)
+    {
+        sum += values[i];
+    }
+    return sum;
+}
+
+REDUCE_CLONES double sum_unrolled(const double* values, int count)
+{
+    double acc[REDUCE_LANES] = {0.0};
+    int i = 0;
+
+    for (; i + REDUCE_LANES <= count; i += REDUCE_LANES)
+    {
+        for (int j = 0; j < REDUCE_LANES; j++)
+        {
+            acc[j] += values[i + j];
+        }
+    }
+    for (; i < count; i++)
+    {
+        acc[0] += values[i];
+    }
+
+    // Combine the lanes as a tree too
+    for (int width = REDUCE_LANES / 2; width > 0; width /= 2)
+    {
+        for (int j = 0; j < width; j++)
+        {
+            acc[j] += acc[j + width];
+        }
+    }
+    return acc[0];
+}
+
+// Pairwise (cascade) summation: error grows with log(n) instead of n, at
+// almost the speed of sum_unrolled since the leaves use it
+double sum_pairwise(const double* values, int count)
+{
+    if (count <= PAIRWISE_BLOCK) return sum_unrolled(values, count);
+
+    int half = count / 2;
+    return sum_pairwise(values, half)
+           + sum_pairwise(values + half, count - half);
+}
+
+// Add x to the compensated sum (sum, comp) - Neumaier's variant of Kahan
+// summation, which also works when x is larger than the running sum
+static inline void kahan_add(double* sum, double* comp, double x)
+{
+    double t = *sum + x;
+    if (fabs(*sum) >= fabs(x))
+    {
+        *comp += (*sum - t) + x;
+    }
+    else
+    {
+        *comp += (x - t) + *sum;
+    }
+    *sum = t;
+}
+
+// Compensated summation: error independent of n. Each lane runs classic
+// Kahan; the lanes and the tail are then merged with kahan_add
+REDUCE_CLONES double sum_kahan(const double* values, int count)
+{
+    double sum[REDUCE_LANES] = {0.0};
+    double comp[REDUCE_LANES] = {0.0};
+    int i = 0;
+
+    for (; i + REDUCE_LANES <= count; i += REDUCE_LANES)
+    {
+        for (int j = 0; j < REDUCE_LANES; j++)
+        {
+            double y = values[i + j] - comp[j];
+            double t = sum[j] + y;
+            comp[j] = (t - sum[j]) - y;  // the part of y that was lost
+            sum[j] = t;
+        }
+    }
+
+    double total = 0.0, total_comp = 0.0;
+    for (int j = 0; j < REDUCE_LANES; j++)
+    {
+        kahan_add(&total, &total_comp, sum[j]);
+        kahan_add(&total, &total_comp, -comp[j]);
+    }
+    for (; i < count; i++)
+    {
+        kahan_add(&total, &total_comp, values[i]);
+    }
+    return total + total_comp;
+}
+
+// Minimum and maximum in one pass; values must not contain NaN
+REDUCE_CLONES void minmax_unrolled(const double* values,
+                                   int count,
+                                   double* min_out,
+                                   double* max_out)
+{
+    double lo[REDUCE_LANES], hi[REDUCE_LANES];
+    int i = 0;
+
+    for (int j = 0; j < REDUCE_LANES; j++)
+    {
+        lo[j] = hi[j] = values[0];
+    }
+    for (; i + REDUCE_LANES <= count; i += REDUCE_LANES)
+    {
+        for (int j = 0; j < REDUCE_LANES; j++)
+        {
+            double v = values[i + j];
+            lo[j] = v < lo[j] ? v : lo[j];  // this exact form maps to minpd
+            hi[j] = v > hi[j] ? v : hi[j];
+        }
+    }
+    for (; i < count; i++)
+    {
+        lo[0] = values[i] < lo[0] ? values[i] : lo[0];
+        hi[0] = values[i] > hi[0] ? values[i] : hi[0];
+    }
+
+    for (int j = 1; j < REDUCE_LANES; j++)
+    {
+        lo[0] = lo[j] < lo[0] ? lo[j] : lo[0];
+        hi[0] = hi[j] > hi[0] ? hi[j] : hi[0];
+    }
+    *min_out = lo[0];
+    *max_out = hi[0];
+}
+
+// Sum of (x - mean) and of (x - mean)^2. Feeding the first back as a
+// correction makes the two-pass variance exact up to rounding even when
+// mean itself is slightly off.
+REDUCE_CLONES void deviation_sums(const double* values,
+                                  int count,
+                                  double mean,
+                                  double* dev_out,
+                                  double* sq_out)
+{
+    double dev[REDUCE_LANES] = {0.0};
+    double sq[REDUCE_LANES] = {0.0};
+    int i = 0;
+
+    for (; i + REDUCE_LANES <= count; i += REDUCE_LANES)
+    {
+        for (int j = 0; j < REDUCE_LANES; j++)
+        {
+            double d = values[i + j] - mean;
+            dev[j] += d;
+            sq[j] += d * d;
+        }
+    }
+    for (; i < count; i++)
+    {
+        double d = values[i] - mean;
+        dev[0] += d;
+        sq[0] += d * d;
+    }
+
+    for (int j = 1; j < REDUCE_LANES; j++)
+    {
+        dev[0] += dev[j];
+        sq[0] += sq[j];
+    }
+    *dev_out = dev[0];
+    *sq_out = sq[0];
+}
+
+// Sum, mean, min, max and variance in three passes over values
+Stats compute_stats(const double* values, int count)
+{
+    Stats stats = {0.0, 0.0, 0.0, 0.0, 0.0};
+    if (count <= 0 || values == NULL) return stats;
+
+    double dev, sq;
+    stats.sum = sum_pairwise(values, count);
+    stats.mean = stats.sum / count;
+    minmax_unrolled(values, count, &stats.min, &stats.max);
+    deviation_sums(values, count, stats.mean, &dev, &sq);
+    stats.variance = (sq - dev * dev / count) / count;
+    return stats;
+}
+
+// Throughput of each kernel, and accuracy of the summation variants
+void benchmark_reductions()
+{
+    printf("\n=== Benchmark: Reduction Kernels ===\n");
+
+    // One size that stays in L2 and one that streams from memory
+    const int SIZES[] = {16 * 1024, 4 * 1024 * 1024};
+    // Bytes to stream per measurement
+    const double TOTAL_BYTES = bench_param("MBYTES", 4000) * 1e6;
+
+    double* values = (double*) malloc(SIZES[1] * sizeof(double));
+    if (values == NULL)
+    {
+        printf("Memory allocation failed\n");
+        return;
+    }
+
+    for (int s = 0; s < 2; s++)
+    {
+        int count = SIZES[s];
+        int iterations = (int) (TOTAL_BYTES / (count * sizeof(double)));
+        double gbytes = (double) iterations * count * sizeof(double) / 1e9;
+
+        for (int i = 0; i < count; i++)
+        {
+            values[i] = (double) (rand() % 10000) / 100.0;
+        }
+        printf("%d doubles (%d KB), GB/s:\n",
+               count,
+               (int) (count * sizeof(double) / 1024));
+
+        const char* names[] = {"naive sum",
+                               "unrolled sum",
+                               "pairwise sum",
+                               "Kahan sum",
+                               "min/max",
+                               "compute_stats"};
+        const char* keys[] = {
+            "naive", "unrolled", "pairwise", "kahan", "minmax", "stats"};
+        for (int kernel = 0; kernel < 6; kernel++)
+        {
+            volatile double sink = 0.0;  // keep every call alive
+            double passes = kernel == 5 ? 3.0 : 1.0;
+            clock_t start = clock();
+
+            for (int it = 0; it < iterations; it++)
+            {
+                double lo, hi;
+                switch (kernel)
+                {
+                case 0: sink = sum_naive(values, count); break;
+                case 1: sink = sum_unrolled(values, count); break;
+                case 2: sink = sum_pairwise(values, count); break;
+                case 3: sink = sum_kahan(values, count); break;
+                case 4:
+                    minmax_unrolled(values, count, &lo, &hi);
+                    sink = lo + hi;
+                    break;
+                case 5: sink = compute_stats(values, count).variance; break;
+                }
+            }
+
+            double seconds = ((double) (clock() - start)) / CLOCKS_PER_SEC;
+            double rate = seconds > 0 ? gbytes * passes / seconds : 0.0;
+            printf("  %-14s %7.2f\n", names[kernel], rate);
+            (void) sink;
+
+            char name[48];
+            snprintf(name,
+                     sizeof(name),
+                     "%s_%dKB",
+                     keys[kernel],
+                     (int) (count * sizeof(double) / 1024));
+            bench_report(name, rate, "GB/s", BENCH_HIGHER_IS_BETTER);
+        }
+    }
+
+    // Accuracy: a large offset plus small parts is where naive summation
+    // loses digits. The reference is accumulated in long double.
+    int count = SIZES[1];
+    long double exact = 0.0L;
+    for (int i = 0; i < count; i++)
+    {
+        values[i] = 1e9 + (double) (i % 1000) * 1e-3;
+        exact += values[i];
+    }
+
+    printf("Absolute error summing %d values near 1e9 (1 ulp = %.2f):\n",
+           count,
+           nextafter((double) exact, INFINITY) - (double) exact);
+    printf("  naive    %.3e\n",
+           fabs((double) (sum_naive(values, count) - exact)));
+    printf("  unrolled %.3e\n",
+           fabs((double) (sum_unrolled(values, count) - exact)));
+    printf("  pairwise %.3e\n",
+           fabs((double) (sum_pairwise(values, count) - exact)));
+    printf("  Kahan    %.3e\n",
+           fabs((double) (sum_kahan(values, count) - exact)));
+
+    Stats stats = compute_stats(values, count);
+    printf("Stats: mean %.6f, min %.3f, max %.3f, variance %.6f\n",
+           stats.mean,
+           stats.min,
+           stats.max,
+           stats.variance);
+
+    free(values);
+}
+
 int main()
 {
     demonstrate_inline();
     benchmark_inline();
+    benchmark_reductions();
 
     return 0;
 }
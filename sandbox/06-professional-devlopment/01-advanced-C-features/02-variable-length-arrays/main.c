@@ -1,6 +1,21 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "../../../bench/bench_report.h"
 
 // Function using VLAs
 void process_data_with_vla(int size)
@@ -115,13 +130,275 @@ void process_matrix(int rows, int cols, int matrix[rows][cols])
     }
 }
 
+// ==== Scratch buffers: VLA speed with a stack budget ====
+
+// Bytes of stack each thread may hand out through SCRATCH_ARRAY at once.
+// Requests that do not fit fall back to a per-thread arena, and requests
+// too large for the arena to malloc.
+#ifndef SCRATCH_STACK_BUDGET
+#define SCRATCH_STACK_BUDGET (64 * 1024)
+#endif
+
+#ifndef SCRATCH_ARENA_SIZE
+#define SCRATCH_ARENA_SIZE (1024 * 1024)
+#endif
+
+// Debug builds put a guard pattern after every buffer and check it on
+// release, so writing past the end aborts instead of silently smashing
+// the stack or the next arena buffer
+#ifndef NDEBUG
+#define SCRATCH_GUARD_BYTES 16
+#else
+#define SCRATCH_GUARD_BYTES 0
+#endif
+#define SCRATCH_GUARD_VALUE 0xFD
+
+typedef enum
+{
+    SCRATCH_STACK,
+    SCRATCH_ARENA,
+    SCRATCH_HEAP
+} ScratchSource;
+
+// One scratch allocation; created by SCRATCH_ARRAY, never by hand
+typedef struct
+{
+    size_t bytes;     // size the caller asked for
+    size_t reserved;  // bytes taken, including guard and alignment
+    ScratchSource source;
+    unsigned char *data;
+} ScratchBuffer;
+
+// Per-thread counters, returned by scratch_usage()
+typedef struct
+{
+    size_t stack_in_use;
+    size_t stack_peak;
+    size_t arena_in_use;
+    size_t arena_peak;
+    unsigned long heap_fallbacks;
+} ScratchUsage;
+
+static _Thread_local ScratchUsage scratch_counters;
+static _Thread_local unsigned char *scratch_arena;
+static pthread_key_t scratch_arena_key;
+static pthread_once_t scratch_arena_once = PTHREAD_ONCE_INIT;
+
+// Declare `type *name` pointing at count elements of scratch memory. The
+// storage is a VLA in the caller's frame when it fits the thread's stack
+// budget, otherwise arena or heap memory. Every SCRATCH_ARRAY needs a
+// matching SCRATCH_RELEASE in the same scope, in reverse order of
+// declaration; name is NULL if the heap fallback fails.
+#define SCRATCH_ARRAY(type, name, count)                                   \
+    ScratchBuffer name##_scratch                                           \
+        = scratch_plan((size_t) (count) * sizeof(type));                   \
+    max_align_t name##_stack[name##_scratch.source == SCRATCH_STACK        \
+                                 ? name##_scratch.reserved                 \
+                                       / sizeof(max_align_t)               \
+                                 : 1];                                     \
+    type *name = (type *) scratch_bind(&name##_scratch, name##_stack)
+
+#define SCRATCH_RELEASE(name) scratch_release(&name##_scratch)
+
+// Decide where a request goes and reserve its share of the stack budget
+static ScratchBuffer scratch_plan(size_t bytes)
+{
+    ScratchBuffer buf = {bytes, 0, SCRATCH_ARENA, NULL};
+    size_t unit = sizeof(max_align_t);
+
+    // Whole max_align_t units, at least one, so any type can live there
+    buf.reserved = (bytes + SCRATCH_GUARD_BYTES + unit - 1) / unit * unit;
+    if (buf.reserved == 0) buf.reserved = unit;
+
+    if (buf.reserved <= SCRATCH_STACK_BUDGET - scratch_counters.stack_in_use)
+    {
+        buf.source = SCRATCH_STACK;
+        scratch_counters.stack_in_use += buf.reserved;
+        if (scratch_counters.stack_in_use > scratch_counters.stack_peak)
+        {
+            scratch_counters.stack_peak = scratch_counters.stack_in_use;
+        }
+    }
+    return buf;
+}
+
+// Runs when a thread that used its arena exits
+static void scratch_arena_free(void *arena)
+{
+    free(arena);
+}
+
+static void scratch_arena_key_create(void)
+{
+    pthread_key_create(&scratch_arena_key, scratch_arena_free);
+}
+
+// Attach memory to a planned buffer: the caller's VLA, the arena, or heap
+static void *scratch_bind(ScratchBuffer *buf, max_align_t *stack)
+{
+    if (buf->source == SCRATCH_STACK)
+    {
+        buf->data = (unsigned char *) stack;
+    }
+    else
+    {
+        if (scratch_arena == NULL)
+        {
+            pthread_once(&scratch_arena_once, scratch_arena_key_create);
+            scratch_arena = (unsigned char *) malloc(SCRATCH_ARENA_SIZE);
+            if (scratch_arena != NULL)
+            {
+                pthread_setspecific(scratch_arena_key, scratch_arena);
+            }
+        }
+
+        if (scratch_arena != NULL
+            && buf->reserved
+                   <= SCRATCH_ARENA_SIZE - scratch_counters.arena_in_use)
+        {
+            // Bump allocation; releases are LIFO, so in_use is the top
+            buf->data = scratch_arena + scratch_counters.arena_in_use;
+            scratch_counters.arena_in_use += buf->reserved;
+            if (scratch_counters.arena_in_use > scratch_counters.arena_peak)
+            {
+                scratch_counters.arena_peak = scratch_counters.arena_in_use;
+            }
+        }
+        else
+        {
+            buf->source = SCRATCH_HEAP;
+            buf->data = (unsigned char *) malloc(buf->reserved);
+            scratch_counters.heap_fallbacks++;
+            if (buf->data == NULL) return NULL;
+        }
+    }
+
+    memset(buf->data + buf->bytes, SCRATCH_GUARD_VALUE, SCRATCH_GUARD_BYTES);
+    return buf->data;
+}
+
+static void scratch_release(ScratchBuffer *buf)
+{
+#ifndef NDEBUG
+    static const unsigned char guard[SCRATCH_GUARD_BYTES] = {
+        [0 ... SCRATCH_GUARD_BYTES - 1] = SCRATCH_GUARD_VALUE};
+
+    if (buf->data != NULL
+        && memcmp(buf->data + buf->bytes, guard, SCRATCH_GUARD_BYTES) != 0)
+    {
+        fprintf(stderr, "scratch buffer of %zu bytes overrun\n", buf->bytes);
+        abort();
+    }
+    if (buf->source == SCRATCH_ARENA
+        && buf->data + buf->reserved
+               != scratch_arena + scratch_counters.arena_in_use)
+    {
+        fprintf(stderr, "scratch buffers released out of order\n");
+        abort();
+    }
+#endif
+
+    switch (buf->source)
+    {
+    case SCRATCH_STACK:
+        scratch_counters.stack_in_use -= buf->reserved;
+        break;
+    case SCRATCH_ARENA:
+        scratch_counters.arena_in_use -= buf->reserved;
+        break;
+    case SCRATCH_HEAP:
+        free(buf->data);
+        break;
+    }
+    buf->data = NULL;
+}
+
+// Scratch usage of the calling thread
+ScratchUsage scratch_usage(void)
+{
+    return scratch_counters;
+}
+
+static const char *scratch_source_name(ScratchSource source)
+{
+    switch (source)
+    {
+    case SCRATCH_STACK: return "stack";
+    case SCRATCH_ARENA: return "arena";
+    case SCRATCH_HEAP: return "heap";
+    }
+    return "?";
+}
+
+// process_data_with_vla without the stack-overflow risk: a 100-million
+// element VLA would crash, a scratch array just moves to the heap
+void process_data_with_scratch(int size)
+{
+    SCRATCH_ARRAY(int, data, size);
+    if (!data)
+    {
+        printf("Memory allocation failed!\n");
+        SCRATCH_RELEASE(data);
+        return;
+    }
+
+    long long sum = 0;
+    for (int i = 0; i < size; i++)
+    {
+        data[i] = i * 10;
+        sum += data[i];
+    }
+
+    ScratchUsage usage = scratch_usage();
+    printf("%10d ints from %-5s (sum %lld; stack in use %zu of %d bytes, "
+           "arena %zu)\n",
+           size,
+           scratch_source_name(data_scratch.source),
+           sum,
+           usage.stack_in_use,
+           SCRATCH_STACK_BUDGET,
+           usage.arena_in_use);
+
+    SCRATCH_RELEASE(data);
+}
+
+void demonstrate_scratch_buffers()
+{
+    printf("\n=== Stack-Budgeted Scratch Buffers ===\n");
+
+    process_data_with_scratch(5);
+    process_data_with_scratch(10000);      // 40 KB: fits the budget
+    process_data_with_scratch(100000);     // 400 KB: arena
+    process_data_with_scratch(100000000);  // 400 MB: heap
+
+    // Nested buffers share one budget: the second no longer fits
+    SCRATCH_ARRAY(char, outer, 48 * 1024);
+    SCRATCH_ARRAY(char, inner, 48 * 1024);
+    if (outer && inner)
+    {
+        memset(outer, 'o', 48 * 1024);
+        memset(inner, 'i', 48 * 1024);
+    }
+    printf("Nested 48 KB buffers: outer from %s, inner from %s\n",
+           scratch_source_name(outer_scratch.source),
+           scratch_source_name(inner_scratch.source));
+    SCRATCH_RELEASE(inner);
+    SCRATCH_RELEASE(outer);
+
+    ScratchUsage usage = scratch_usage();
+    printf("Peaks: stack %zu bytes, arena %zu bytes; heap fallbacks %lu\n",
+           usage.stack_peak,
+           usage.arena_peak,
+           usage.heap_fallbacks);
+}
+
 // Function to benchmark VLA vs malloc
 void benchmark_vla_vs_malloc()
 {
     printf("\n=== Benchmark: VLA vs malloc ===\n");
 
-    const int ITERATIONS = 1000000;
-    const int ARRAY_SIZE = 100;
+    const int ITERATIONS = (int) bench_param("ITERATIONS", 1000000);
+    const int ARRAY_SIZE = (int) bench_param("SIZE", 100);
 
     // Benchmark VLA
     clock_t start_vla = clock();
@@ -156,10 +433,802 @@ void benchmark_vla_vs_malloc()
     double time_malloc
         = ((double) (end_malloc - start_malloc)) / CLOCKS_PER_SEC;
 
+    // Benchmark scratch buffers (stack path, same operations)
+    clock_t start_scratch = clock();
+
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        SCRATCH_ARRAY(int, arr, ARRAY_SIZE);
+        arr[0] = i;
+        arr[ARRAY_SIZE - 1] = i + arr[0];
+        SCRATCH_RELEASE(arr);
+    }
+
+    clock_t end_scratch = clock();
+    double time_scratch
+        = ((double) (end_scratch - start_scratch)) / CLOCKS_PER_SEC;
+
     // Print results
     printf("Time with VLA: %.4f seconds\n", time_vla);
     printf("Time with malloc: %.4f seconds\n", time_malloc);
+    printf("Time with scratch buffer: %.4f seconds\n", time_scratch);
     printf("VLA is %.2f times faster for this test\n", time_malloc / time_vla);
+    printf("Scratch buffer is %.2f times faster than malloc\n",
+           time_malloc / time_scratch);
+
+    bench_report("vla", time_vla * 1e3, "ms", BENCH_LOWER_IS_BETTER);
+    bench_report("malloc", time_malloc * 1e3, "ms", BENCH_LOWER_IS_BETTER);
+    bench_report("scratch", time_scratch * 1e3, "ms", BENCH_LOWER_IS_BETTER);
+}
+
+// ==== Dense matrix multiply on contiguous storage ====
+
+// Row-major matrix in a single allocation. With an array of row pointers
+// (see allocate_2d_array in 01-pointer-to-pointer) every row is a separate
+// block and each access is a dependent load; here element (i, j) is always
+// data[i * cols + j], and the buffer can be viewed as a 2D VLA:
+//     float (*rows)[m.cols] = (float (*)[m.cols]) m.data;
+typedef struct
+{
+    int rows;
+    int cols;
+    float *data;
+} Matrix;
+
+// How matrix_multiply reads an operand. Transposes are folded into the
+// packing step, so no transposed copy is ever materialized.
+typedef enum
+{
+    MATRIX_NORMAL,
+    MATRIX_TRANSPOSED
+} MatrixOp;
+
+// Blocking for the packed GEMM: C is computed in GEMM_MR x GEMM_NR register
+// tiles. A GEMM_KC x GEMM_NR slice of B (16 KB) stays in L1 while every
+// row panel of the GEMM_MC x GEMM_KC block of A (96 KB, L2) streams past it.
+#define GEMM_MR 6
+#define GEMM_NR 16
+#define GEMM_MC 96
+#define GEMM_NC 256
+#define GEMM_KC 256
+
+Matrix matrix_create(int rows, int cols)
+{
+    Matrix m = {rows, cols, NULL};
+    size_t bytes = (size_t) rows * cols * sizeof(float);
+    void *data;
+
+    // Cache-line aligned so rows start on a line when cols is a multiple
+    // of 16
+    if (posix_memalign(&data, 64, bytes > 0 ? bytes : 64) != 0)
+    {
+        printf("Memory allocation failed\n");
+        return m;
+    }
+    memset(data, 0, bytes);
+    m.data = (float *) data;
+    return m;
+}
+
+void matrix_free(Matrix *m)
+{
+    free(m->data);
+    m->data = NULL;
+}
+
+// Element (i, j) of op(m)
+static inline float matrix_op_at(const Matrix *m, MatrixOp op, int i, int j)
+{
+    return op == MATRIX_NORMAL ? m->data[(size_t) i * m->cols + j]
+                               : m->data[(size_t) j * m->cols + i];
+}
+
+// Copy rows [i0, i0 + mc) x depth [k0, k0 + kc) of op(A) into GEMM_MR-row
+// panels, k-major inside a panel, so the microkernel reads it linearly.
+// Rows past mc are zero-filled.
+static void pack_a(float *dst,
+                   const Matrix *a,
+                   MatrixOp op,
+                   int i0,
+                   int mc,
+                   int k0,
+                   int kc)
+{
+    for (int ir = 0; ir < mc; ir += GEMM_MR)
+    {
+        for (int k = 0; k < kc; k++)
+        {
+            for (int i = 0; i < GEMM_MR; i++)
+            {
+                *dst++ = ir + i < mc ? matrix_op_at(a, op, i0 + ir + i, k0 + k)
+                                     : 0.0f;
+            }
+        }
+    }
+}
+
+// Same for depth [k0, k0 + kc) x columns [j0, j0 + nc) of op(B), in
+// GEMM_NR-column panels; columns past nc are zero-filled
+static void pack_b(float *dst,
+                   const Matrix *b,
+                   MatrixOp op,
+                   int k0,
+                   int kc,
+                   int j0,
+                   int nc)
+{
+    for (int jr = 0; jr < nc; jr += GEMM_NR)
+    {
+        for (int k = 0; k < kc; k++)
+        {
+            for (int j = 0; j < GEMM_NR; j++)
+            {
+                *dst++ = jr + j < nc ? matrix_op_at(b, op, k0 + k, j0 + jr + j)
+                                     : 0.0f;
+            }
+        }
+    }
+}
+
+// Microkernel: the GEMM_MR x GEMM_NR tile c (row stride ldc) is set to, or
+// with accumulate incremented by, packed A panel times packed B panel
+typedef void (*GemmKernel)(int kc,
+                           const float *a,
+                           const float *b,
+                           float *c,
+                           int ldc,
+                           bool accumulate);
+
+static void gemm_kernel_scalar(int kc,
+                               const float *a,
+                               const float *b,
+                               float *c,
+                               int ldc,
+                               bool accumulate)
+{
+    float acc[GEMM_MR][GEMM_NR] = {{0}};
+
+    for (int k = 0; k < kc; k++)
+    {
+        for (int i = 0; i < GEMM_MR; i++)
+        {
+            for (int j = 0; j < GEMM_NR; j++)
+            {
+                acc[i][j] += a[i] * b[j];
+            }
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    for (int i = 0; i < GEMM_MR; i++)
+    {
+        for (int j = 0; j < GEMM_NR; j++)
+        {
+            c[i * ldc + j] = accumulate ? c[i * ldc + j] + acc[i][j]
+                                        : acc[i][j];
+        }
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// 6 x 16 tile = 12 ymm accumulators; each k step is two loads of B, six
+// broadcasts of A and twelve FMAs
+__attribute__((target("avx2,fma"))) static void gemm_kernel_avx2(
+    int kc, const float *a, const float *b, float *c, int ldc, bool accumulate)
+{
+    __m256 acc[GEMM_MR][2];
+
+    for (int i = 0; i < GEMM_MR; i++)
+    {
+        acc[i][0] = _mm256_setzero_ps();
+        acc[i][1] = _mm256_setzero_ps();
+    }
+
+    for (int k = 0; k < kc; k++)
+    {
+        __m256 b0 = _mm256_load_ps(b);
+        __m256 b1 = _mm256_load_ps(b + 8);
+
+        for (int i = 0; i < GEMM_MR; i++)
+        {
+            __m256 ai = _mm256_broadcast_ss(a + i);
+            acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    for (int i = 0; i < GEMM_MR; i++)
+    {
+        float *row = c + i * ldc;
+        if (accumulate)
+        {
+            acc[i][0] = _mm256_add_ps(acc[i][0], _mm256_loadu_ps(row));
+            acc[i][1] = _mm256_add_ps(acc[i][1], _mm256_loadu_ps(row + 8));
+        }
+        _mm256_storeu_ps(row, acc[i][0]);
+        _mm256_storeu_ps(row + 8, acc[i][1]);
+    }
+}
+#endif
+
+#if defined(__aarch64__)
+// 6 x 16 tile = 24 of the 32 q registers as accumulators
+static void gemm_kernel_neon(int kc,
+                             const float *a,
+                             const float *b,
+                             float *c,
+                             int ldc,
+                             bool accumulate)
+{
+    float32x4_t acc[GEMM_MR][4];
+
+    for (int i = 0; i < GEMM_MR; i++)
+    {
+        for (int q = 0; q < 4; q++)
+        {
+            acc[i][q] = vdupq_n_f32(0.0f);
+        }
+    }
+
+    for (int k = 0; k < kc; k++)
+    {
+        float32x4_t bq[4];
+        for (int q = 0; q < 4; q++)
+        {
+            bq[q] = vld1q_f32(b + 4 * q);
+        }
+
+        for (int i = 0; i < GEMM_MR; i++)
+        {
+            for (int q = 0; q < 4; q++)
+            {
+                acc[i][q] = vfmaq_n_f32(acc[i][q], bq[q], a[i]);
+            }
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    for (int i = 0; i < GEMM_MR; i++)
+    {
+        float *row = c + i * ldc;
+        for (int q = 0; q < 4; q++)
+        {
+            if (accumulate)
+            {
+                acc[i][q] = vaddq_f32(acc[i][q], vld1q_f32(row + 4 * q));
+            }
+            vst1q_f32(row + 4 * q, acc[i][q]);
+        }
+    }
+}
+#endif
+
+static GemmKernel gemm_kernel = gemm_kernel_scalar;
+static const char *gemm_kernel_name = "scalar";
+static pthread_once_t gemm_kernel_once = PTHREAD_ONCE_INIT;
+
+static void select_gemm_kernel(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        gemm_kernel = gemm_kernel_avx2;
+        gemm_kernel_name = "avx2+fma";
+    }
+#elif defined(__aarch64__)
+    gemm_kernel = gemm_kernel_neon;
+    gemm_kernel_name = "neon";
+#endif
+}
+
+// One C = op(A) * op(B) call, split into GEMM_MC x GEMM_NC output tiles
+// that workers claim from next_tile. Tiles never overlap, so no locking is
+// needed on C.
+typedef struct
+{
+    Matrix *c;
+    const Matrix *a;
+    const Matrix *b;
+    MatrixOp op_a;
+    MatrixOp op_b;
+    int m;
+    int n;
+    int k;
+    int tiles_n;
+    int tile_count;
+    atomic_int next_tile;
+} GemmJob;
+
+// Compute one output tile; pack_a_buf/pack_b_buf are the caller's private
+// GEMM_MC x GEMM_KC and GEMM_KC x GEMM_NC packing buffers
+static void gemm_tile(GemmJob *job,
+                      int tile,
+                      float *pack_a_buf,
+                      float *pack_b_buf)
+{
+    int i0 = (tile / job->tiles_n) * GEMM_MC;
+    int j0 = (tile % job->tiles_n) * GEMM_NC;
+    int mc = job->m - i0 < GEMM_MC ? job->m - i0 : GEMM_MC;
+    int nc = job->n - j0 < GEMM_NC ? job->n - j0 : GEMM_NC;
+    int ldc = job->n;
+
+    for (int k0 = 0; k0 < job->k; k0 += GEMM_KC)
+    {
+        int kc = job->k - k0 < GEMM_KC ? job->k - k0 : GEMM_KC;
+        bool accumulate = k0 > 0;
+
+        pack_a(pack_a_buf, job->a, job->op_a, i0, mc, k0, kc);
+        pack_b(pack_b_buf, job->b, job->op_b, k0, kc, j0, nc);
+
+        // jr outer: one B panel stays in L1 while all A panels pass by
+        for (int jr = 0; jr < nc; jr += GEMM_NR)
+        {
+            for (int ir = 0; ir < mc; ir += GEMM_MR)
+            {
+                const float *ap = pack_a_buf + (size_t) ir * kc;
+                const float *bp = pack_b_buf + (size_t) jr * kc;
+                float *cp = job->c->data + (size_t) (i0 + ir) * ldc + j0 + jr;
+                int rows = mc - ir < GEMM_MR ? mc - ir : GEMM_MR;
+                int cols = nc - jr < GEMM_NR ? nc - jr : GEMM_NR;
+
+                if (rows == GEMM_MR && cols == GEMM_NR)
+                {
+                    gemm_kernel(kc, ap, bp, cp, ldc, accumulate);
+                    continue;
+                }
+
+                // Edge tile: full-size kernel into a scratch tile, then
+                // copy out only the part inside C
+                float edge[GEMM_MR * GEMM_NR];
+                gemm_kernel(kc, ap, bp, edge, GEMM_NR, false);
+                for (int i = 0; i < rows; i++)
+                {
+                    for (int j = 0; j < cols; j++)
+                    {
+                        float v = edge[i * GEMM_NR + j];
+                        cp[i * ldc + j] = accumulate ? cp[i * ldc + j] + v : v;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Packing buffers, allocated once per thread
+typedef struct
+{
+    float *a;
+    float *b;
+} GemmBuffers;
+
+static bool gemm_buffers_create(GemmBuffers *buf)
+{
+    void *a = NULL, *b = NULL;
+
+    if (posix_memalign(&a, 64, GEMM_MC * GEMM_KC * sizeof(float)) != 0)
+    {
+        return false;
+    }
+    if (posix_memalign(&b, 64, GEMM_KC * GEMM_NC * sizeof(float)) != 0)
+    {
+        free(a);
+        return false;
+    }
+    buf->a = (float *) a;
+    buf->b = (float *) b;
+    return true;
+}
+
+static void gemm_buffers_free(GemmBuffers *buf)
+{
+    free(buf->a);
+    free(buf->b);
+}
+
+static void gemm_run_tiles(GemmJob *job, GemmBuffers *buf)
+{
+    int tile;
+    while ((tile = atomic_fetch_add(&job->next_tile, 1)) < job->tile_count)
+    {
+        gemm_tile(job, tile, buf->a, buf->b);
+    }
+}
+
+// Persistent worker threads for matrix_multiply. Creating threads per call
+// would cost more than a small product itself.
+typedef struct MatrixPool MatrixPool;
+
+typedef struct
+{
+    MatrixPool *pool;
+    GemmBuffers buffers;
+} MatrixWorker;
+
+struct MatrixPool
+{
+    pthread_t *threads;
+    MatrixWorker *workers;
+    int count;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    GemmJob *job;
+    unsigned long generation;  // bumped once per job
+    int busy;                  // workers still on the current job
+    bool shutdown;
+};
+
+static void *matrix_worker(void *arg)
+{
+    MatrixWorker *worker = (MatrixWorker *) arg;
+    MatrixPool *pool = worker->pool;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        while (!pool->shutdown && pool->generation == seen)
+        {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->shutdown) break;
+
+        seen = pool->generation;
+        GemmJob *job = pool->job;
+        pthread_mutex_unlock(&pool->lock);
+
+        gemm_run_tiles(job, &worker->buffers);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) pthread_cond_signal(&pool->work_done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+void matrix_pool_destroy(MatrixPool *pool);
+
+MatrixPool *matrix_pool_create(int threads)
+{
+    MatrixPool *pool = (MatrixPool *) calloc(1, sizeof(MatrixPool));
+    if (!pool) return NULL;
+
+    pool->threads = (pthread_t *) calloc(threads, sizeof(pthread_t));
+    pool->workers = (MatrixWorker *) calloc(threads, sizeof(MatrixWorker));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+    if (!pool->threads || !pool->workers)
+    {
+        matrix_pool_destroy(pool);
+        return NULL;
+    }
+
+    for (int i = 0; i < threads; i++)
+    {
+        pool->workers[i].pool = pool;
+        if (!gemm_buffers_create(&pool->workers[i].buffers)
+            || pthread_create(
+                   &pool->threads[i], NULL, matrix_worker, &pool->workers[i])
+                   != 0)
+        {
+            gemm_buffers_free(&pool->workers[i].buffers);
+            matrix_pool_destroy(pool);
+            return NULL;
+        }
+        pool->count++;
+    }
+    return pool;
+}
+
+void matrix_pool_destroy(MatrixPool *pool)
+{
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->count; i++)
+    {
+        pthread_join(pool->threads[i], NULL);
+        gemm_buffers_free(&pool->workers[i].buffers);
+    }
+
+    pthread_cond_destroy(&pool->work_done);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool->threads);
+    free(pool);
+}
+
+// C = op(A) * op(B) with packed, cache-blocked tiles and a SIMD
+// microkernel. Tiles are spread over pool's threads, or computed on the
+// calling thread when pool is NULL. Returns false on mismatched shapes.
+bool matrix_multiply(Matrix *c,
+                     const Matrix *a,
+                     MatrixOp op_a,
+                     const Matrix *b,
+                     MatrixOp op_b,
+                     MatrixPool *pool)
+{
+    int m = op_a == MATRIX_NORMAL ? a->rows : a->cols;
+    int k = op_a == MATRIX_NORMAL ? a->cols : a->rows;
+    int kb = op_b == MATRIX_NORMAL ? b->rows : b->cols;
+    int n = op_b == MATRIX_NORMAL ? b->cols : b->rows;
+
+    if (k != kb || c->rows != m || c->cols != n)
+    {
+        printf("matrix_multiply: shape mismatch\n");
+        return false;
+    }
+
+    pthread_once(&gemm_kernel_once, select_gemm_kernel);
+
+    if (k == 0)
+    {
+        memset(c->data, 0, (size_t) m * n * sizeof(float));
+        return true;
+    }
+
+    GemmJob job = {c, a, b, op_a, op_b, m, n, k, 0, 0, 0};
+    job.tiles_n = (n + GEMM_NC - 1) / GEMM_NC;
+    job.tile_count = ((m + GEMM_MC - 1) / GEMM_MC) * job.tiles_n;
+    atomic_init(&job.next_tile, 0);
+
+    if (!pool)
+    {
+        GemmBuffers buf;
+        if (!gemm_buffers_create(&buf))
+        {
+            printf("Memory allocation failed\n");
+            return false;
+        }
+        gemm_run_tiles(&job, &buf);
+        gemm_buffers_free(&buf);
+        return true;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->job = &job;
+    pool->busy = pool->count;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+    while (pool->busy > 0)
+    {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return true;
+}
+
+// Textbook triple loop over an array of row pointers
+void multiply_row_pointers(int m, int n, int k, float **a, float **b, float **c)
+{
+    for (int i = 0; i < m; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            float sum = 0.0f;
+            for (int p = 0; p < k; p++)
+            {
+                sum += a[i][p] * b[p][j];
+            }
+            c[i][j] = sum;
+        }
+    }
+}
+
+// The same triple loop on contiguous storage passed as VLA parameters
+void multiply_vla(
+    int m, int n, int k, float a[m][k], float b[k][n], float c[m][n])
+{
+    for (int i = 0; i < m; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            float sum = 0.0f;
+            for (int p = 0; p < k; p++)
+            {
+                sum += a[i][p] * b[p][j];
+            }
+            c[i][j] = sum;
+        }
+    }
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Largest |C - op(A) op(B)| against a double-precision reference
+static double matrix_max_error(const Matrix *c,
+                               const Matrix *a,
+                               MatrixOp op_a,
+                               const Matrix *b,
+                               MatrixOp op_b,
+                               int k)
+{
+    double worst = 0.0;
+    for (int i = 0; i < c->rows; i++)
+    {
+        for (int j = 0; j < c->cols; j++)
+        {
+            double want = 0.0;
+            for (int p = 0; p < k; p++)
+            {
+                want += (double) matrix_op_at(a, op_a, i, p)
+                        * matrix_op_at(b, op_b, p, j);
+            }
+            double err = fabs(c->data[(size_t) i * c->cols + j] - want);
+            if (err > worst) worst = err;
+        }
+    }
+    return worst;
+}
+
+static void matrix_fill(Matrix *m, unsigned seed)
+{
+    srand(seed);
+    for (size_t i = 0; i < (size_t) m->rows * m->cols; i++)
+    {
+        m->data[i] = (float) (rand() % 2001 - 1000) / 1000.0f;
+    }
+}
+
+// Compare the naive triple loops with the packed GEMM, single-threaded and
+// on a pool with one thread per CPU
+void benchmark_matrix_multiply()
+{
+    printf("\n=== Benchmark: naive vs blocked matrix multiply ===\n");
+
+    // Correctness first, on odd shapes that exercise every edge tile and
+    // all four transpose combinations
+    const int M = 131, K = 300, N = 77;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    MatrixPool *pool = matrix_pool_create(cpus > 0 ? (int) cpus : 1);
+    if (!pool)
+    {
+        printf("Failed to create thread pool\n");
+        return;
+    }
+
+    for (int op = 0; op < 4; op++)
+    {
+        MatrixOp op_a = (op & 1) ? MATRIX_TRANSPOSED : MATRIX_NORMAL;
+        MatrixOp op_b = (op & 2) ? MATRIX_TRANSPOSED : MATRIX_NORMAL;
+        Matrix a = op_a == MATRIX_NORMAL ? matrix_create(M, K)
+                                         : matrix_create(K, M);
+        Matrix b = op_b == MATRIX_NORMAL ? matrix_create(K, N)
+                                         : matrix_create(N, K);
+        Matrix c = matrix_create(M, N);
+        if (!a.data || !b.data || !c.data) break;
+
+        matrix_fill(&a, 1);
+        matrix_fill(&b, 2);
+        matrix_multiply(&c, &a, op_a, &b, op_b, pool);
+        printf("%dx%dx%d, A%s B%s: max error %.2e\n",
+               M,
+               K,
+               N,
+               op_a == MATRIX_NORMAL ? "" : "^T",
+               op_b == MATRIX_NORMAL ? "" : "^T",
+               matrix_max_error(&c, &a, op_a, &b, op_b, K));
+
+        matrix_free(&c);
+        matrix_free(&b);
+        matrix_free(&a);
+    }
+
+    // Then speed on square matrices
+    const int SIZE = 512;
+    double flops = 2.0 * SIZE * SIZE * SIZE;
+    Matrix a = matrix_create(SIZE, SIZE);
+    Matrix b = matrix_create(SIZE, SIZE);
+    Matrix c = matrix_create(SIZE, SIZE);
+    float **pa = (float **) malloc(SIZE * sizeof(float *));
+    float **pb = (float **) malloc(SIZE * sizeof(float *));
+    float **pc = (float **) malloc(SIZE * sizeof(float *));
+    if (!a.data || !b.data || !c.data || !pa || !pb || !pc)
+    {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    matrix_fill(&a, 3);
+    matrix_fill(&b, 4);
+    for (int i = 0; i < SIZE; i++)
+    {
+        // Separately allocated rows, as allocate_2d_array does
+        pa[i] = (float *) malloc(SIZE * sizeof(float));
+        pb[i] = (float *) malloc(SIZE * sizeof(float));
+        pc[i] = (float *) malloc(SIZE * sizeof(float));
+        if (!pa[i] || !pb[i] || !pc[i])
+        {
+            printf("Memory allocation failed for row %d\n", i);
+            exit(1);
+        }
+        memcpy(pa[i], a.data + (size_t) i * SIZE, SIZE * sizeof(float));
+        memcpy(pb[i], b.data + (size_t) i * SIZE, SIZE * sizeof(float));
+    }
+
+    printf("\n%dx%d multiply (microkernel: %s, pool: %d threads)\n",
+           SIZE,
+           SIZE,
+           gemm_kernel_name,
+           pool->count);
+
+    double start = now_seconds();
+    multiply_row_pointers(SIZE, SIZE, SIZE, pa, pb, pc);
+    double t_pointers = now_seconds() - start;
+
+    start = now_seconds();
+    multiply_vla(SIZE,
+                 SIZE,
+                 SIZE,
+                 (float (*)[SIZE]) a.data,
+                 (float (*)[SIZE]) b.data,
+                 (float (*)[SIZE]) c.data);
+    double t_vla = now_seconds() - start;
+
+    start = now_seconds();
+    matrix_multiply(&c, &a, MATRIX_NORMAL, &b, MATRIX_NORMAL, NULL);
+    double t_packed = now_seconds() - start;
+
+    start = now_seconds();
+    matrix_multiply(&c, &a, MATRIX_NORMAL, &b, MATRIX_NORMAL, pool);
+    double t_pool = now_seconds() - start;
+
+    // The row-pointer result must agree with the packed one
+    double diff = 0.0;
+    for (int i = 0; i < SIZE; i++)
+    {
+        for (int j = 0; j < SIZE; j++)
+        {
+            double d = fabs(pc[i][j] - c.data[(size_t) i * SIZE + j]);
+            if (d > diff) diff = d;
+        }
+    }
+
+    printf("Row pointers, triple loop: %8.4f s  %6.2f GFLOP/s\n",
+           t_pointers,
+           flops / t_pointers / 1e9);
+    printf("Contiguous VLA, triple loop: %6.4f s  %6.2f GFLOP/s\n",
+           t_vla,
+           flops / t_vla / 1e9);
+    printf("Packed GEMM, 1 thread:     %8.4f s  %6.2f GFLOP/s\n",
+           t_packed,
+           flops / t_packed / 1e9);
+    printf("Packed GEMM, thread pool:  %8.4f s  %6.2f GFLOP/s\n",
+           t_pool,
+           flops / t_pool / 1e9);
+    printf("Packed is %.1f times faster than row pointers (max diff %.2e)\n",
+           t_pointers / t_pool,
+           diff);
+
+    for (int i = 0; i < SIZE; i++)
+    {
+        free(pa[i]);
+        free(pb[i]);
+        free(pc[i]);
+    }
+    free(pc);
+    free(pb);
+    free(pa);
+    matrix_free(&c);
+    matrix_free(&b);
+    matrix_free(&a);
+    matrix_pool_destroy(pool);
 }
 
 int main()
@@ -203,8 +1272,14 @@ int main()
         printf("\n");
     }
 
+    // VLA speed without unbounded stack use
+    demonstrate_scratch_buffers();
+
     // Run benchmark
     benchmark_vla_vs_malloc();
 
+    // Run matrix multiply benchmark
+    benchmark_matrix_multiply();
+
     return 0;
 }
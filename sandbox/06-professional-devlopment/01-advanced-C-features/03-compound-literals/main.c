@@ -1,5 +1,9 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#include "../object_arena.h"
 
 // Define some structs for demonstration
 typedef struct
@@ -21,6 +25,25 @@ typedef struct
     float score;
 } Student;
 
+// Constructors that return a value: the compound literal is built in the
+// caller's storage (or in registers), so making one never allocates
+static inline Point point_make(int x, int y)
+{
+    return (Point){.x = x, .y = y};
+}
+
+static inline Rectangle rectangle_make(Point top_left, Point bottom_right)
+{
+    return (Rectangle){.top_left = top_left, .bottom_right = bottom_right};
+}
+
+static inline Student student_make(const char *name, int age, float score)
+{
+    Student s = {.age = age, .score = score};
+    snprintf(s.name, sizeof(s.name), "%s", name);
+    return s;
+}
+
 // Function that accepts a Point
 void print_point(Point p)
 {
@@ -171,6 +194,110 @@ void lifetime_of_compound_literals()
     printf("Modified: [%d, %d, %d, %d]\n", arr[0], arr[1], arr[2], arr[3]);
 }
 
+static double seconds_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Value, arena and heap construction side by side
+void constructors_without_malloc()
+{
+    printf("\n=== Constructors Without malloc ===\n");
+
+    // By value: no pointer, nothing to free
+    Rectangle r = rectangle_make(point_make(0, 0), point_make(4, 3));
+    printf("Value: Rectangle (%d, %d)-(%d, %d)\n", r.top_left.x,
+           r.top_left.y, r.bottom_right.x, r.bottom_right.y);
+
+    // In an arena on this function's stack: a pointer that stays valid
+    // until the function returns, released without any free()
+    OBJECT_ARENA_ON_STACK(arena, 1024);
+    Student *alice = OBJECT_NEW(&arena, Student, .name = "Alice", .age = 21,
+                                .score = 91.5f);
+    Point *corner = OBJECT_NEW(&arena, Point, .x = 7, .y = 9);
+    if (alice != NULL && corner != NULL)
+    {
+        printf("Arena: %s (%d), Point(%d, %d); %zu of %zu bytes used\n",
+               alice->name, alice->age, corner->x, corner->y, arena.used,
+               arena.size);
+    }
+
+    // Escaping to the heap is spelled out at the call site
+    Student *kept = OBJECT_ESCAPE(&(Student){.name = "Bob", .age = 23});
+    if (kept != NULL)
+    {
+        printf("Heap: %s (%d), must be freed by its owner\n", kept->name,
+               kept->age);
+        free(kept);
+    }
+}
+
+// Build and use a short-lived Student per record: heap-allocated as
+// create_student-style code does, returned by value, or placed in a stack
+// arena reset every batch. Each checksum must match.
+void construction_benchmark(int count)
+{
+    printf("\n=== Short-Lived Objects: %d Students ===\n", count);
+    enum
+    {
+        BATCH = 256
+    };
+    static const char *names[] = {"Ann", "Ben", "Cleo", "Dev"};
+    double sums[3] = {0, 0, 0};
+    double times[3];
+    size_t heap[3], placed[3];
+
+    for (int method = 0; method < 3; method++)
+    {
+        size_t heap_before = object_stats.heap_escapes;
+        size_t placed_before = object_stats.arena_objects;
+        OBJECT_ARENA_ON_STACK(arena, BATCH * sizeof(Student));
+        double start = seconds_now();
+        for (int i = 0; i < count; i++)
+        {
+            const char *name = names[i & 3];
+            int age = 18 + i % 10;
+            float score = (float) (i % 101);
+            if (method == 0)
+            {
+                Student value = student_make(name, age, score);
+                Student *s = OBJECT_ESCAPE(&value);
+                if (s == NULL) break;
+                sums[0] += s->score + s->age + s->name[0];
+                free(s);
+            }
+            else if (method == 1)
+            {
+                Student s = student_make(name, age, score);
+                sums[1] += s.score + s.age + s.name[0];
+            }
+            else
+            {
+                if (i % BATCH == 0) object_arena_reset(&arena);
+                Student *s = OBJECT_NEW(&arena, Student, .age = age,
+                                        .score = score);
+                if (s == NULL) break;
+                snprintf(s->name, sizeof(s->name), "%s", name);
+                sums[2] += s->score + s->age + s->name[0];
+            }
+        }
+        times[method] = seconds_now() - start;
+        heap[method] = object_stats.heap_escapes - heap_before;
+        placed[method] = object_stats.arena_objects - placed_before;
+    }
+
+    static const char *labels[] = {"malloc per object", "by value",
+                                   "stack arena"};
+    for (int method = 0; method < 3; method++)
+    {
+        printf("  %-18s %7.2f ms  %8zu mallocs  %8zu arena placements%s\n",
+               labels[method], times[method] * 1e3, heap[method],
+               placed[method], sums[method] == sums[0] ? "" : "  MISMATCH");
+    }
+}
+
 int main()
 {
     printf("==== COMPOUND LITERALS DEMO ====\n\n");
@@ -181,6 +308,8 @@ int main()
     compound_literals_in_functions();
     compound_literals_with_strings();
     lifetime_of_compound_literals();
+    constructors_without_malloc();
+    construction_benchmark(1000000);
 
     return 0;
 }
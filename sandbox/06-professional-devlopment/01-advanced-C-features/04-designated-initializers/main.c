@@ -1,5 +1,10 @@
+#include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#include "../const_tables.h"
 
 // Define some structs for demonstration
 typedef struct
@@ -246,6 +251,124 @@ void updating_specific_values()
     printf("\n");
 }
 
+static double seconds_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct
+{
+    size_t identifiers, numbers, spaces;
+} TokenCounts;
+
+// Count identifiers, numbers and spaces with <ctype.h>, which looks up a
+// per-locale table through a function call (__ctype_b_loc in glibc)
+static TokenCounts count_tokens_ctype(const char *text, size_t n)
+{
+    TokenCounts counts = {0, 0, 0};
+    for (size_t i = 0; i < n;)
+    {
+        unsigned char c = (unsigned char) text[i];
+        if (isalpha(c) || c == '_')
+        {
+            while (i < n
+                   && (isalnum((unsigned char) text[i]) || text[i] == '_'))
+            {
+                i++;
+            }
+            counts.identifiers++;
+        }
+        else if (isdigit(c))
+        {
+            while (i < n && isdigit((unsigned char) text[i])) i++;
+            counts.numbers++;
+        }
+        else
+        {
+            counts.spaces += isspace(c) != 0;
+            i++;
+        }
+    }
+    return counts;
+}
+
+// The same with the constant class table: one load and a mask per byte
+static TokenCounts count_tokens_table(const char *text, size_t n)
+{
+    TokenCounts counts = {0, 0, 0};
+    for (size_t i = 0; i < n;)
+    {
+        unsigned class = table_char_class[(unsigned char) text[i]];
+        if ((class & (TABLE_CHAR_IDENT | TABLE_CHAR_DIGIT)) == TABLE_CHAR_IDENT)
+        {
+            while (i < n && table_char_is(text[i], TABLE_CHAR_IDENT)) i++;
+            counts.identifiers++;
+        }
+        else if (class & TABLE_CHAR_DIGIT)
+        {
+            while (i < n && table_char_is(text[i], TABLE_CHAR_DIGIT)) i++;
+            counts.numbers++;
+        }
+        else
+        {
+            counts.spaces += (class & TABLE_CHAR_SPACE) != 0;
+            i++;
+        }
+    }
+    return counts;
+}
+
+// Tables generated at compile time: every entry is a constant expression
+// produced by a macro through [index] = entry(index), so the arrays are
+// static const data in .rodata with no code to fill them (const_tables.h)
+void generated_lookup_tables()
+{
+    printf("\n=== Generated Lookup Tables ===\n");
+
+    const char *check = "123456789";
+    printf("CRC-32 of \"%s\": 0x%08X (expected 0xCBF43926)\n", check,
+           table_crc32_update(0, check, strlen(check)));
+
+    unsigned char byte = 0xB4;  // 10110100
+    printf("Byte 0x%02X: %d bits set, the third at position %d\n", byte,
+           table_popcount[byte], table_select[byte][2]);
+    printf("Shuffle for 4-byte elements:");
+    for (int i = 0; i < 16; i++)
+    {
+        printf(" %d", table_bswap_shuffle[4][i]);
+    }
+    printf("\n");
+
+    // Tokenize the same text with <ctype.h> and with the class table
+    static const char sample[] = "int x_1 = 42 + y;\n\tcount += 7 * z9;\n";
+    size_t n = 8u << 20;
+    char *text = malloc(n);
+    if (text == NULL) return;
+    for (size_t i = 0; i < n; i++)
+    {
+        text[i] = sample[i % (sizeof(sample) - 1)];
+    }
+
+    double start = seconds_now();
+    TokenCounts with_ctype = count_tokens_ctype(text, n);
+    double ctype_time = seconds_now() - start;
+
+    start = seconds_now();
+    TokenCounts with_table = count_tokens_table(text, n);
+    double table_time = seconds_now() - start;
+
+    int same = memcmp(&with_ctype, &with_table, sizeof(TokenCounts)) == 0;
+    printf("Tokenizing %zu MB: %zu identifiers, %zu numbers, %zu spaces\n",
+           n >> 20, with_table.identifiers, with_table.numbers,
+           with_table.spaces);
+    printf("  <ctype.h> %.2f ms, table_char_class %.2f ms (%.1fx)%s\n",
+           ctype_time * 1e3, table_time * 1e3, ctype_time / table_time,
+           same ? "" : "  MISMATCH");
+    free(text);
+}
+
 int main()
 {
     printf("==== DESIGNATED INITIALIZERS DEMO ====\n\n");
@@ -256,6 +379,7 @@ int main()
     sparse_arrays();
     partial_initialization();
     updating_specific_values();
+    generated_lookup_tables();
 
     return 0;
 }
@@ -0,0 +1,194 @@
+// Lookup tables computed by the compiler, not at startup.
+//
+// A table filled in by an init function lives in .bss: every process
+// pays for the loop that fills it and for its own private copy of the
+// pages, and every lookup has to check (or be sure) that the init ran.
+// Here each table is a static const array whose entries are constant
+// expressions, generated with designated initializers:
+//
+//   TABLE_256(entry)   [0] = entry(0), [1] = entry(1), ... [255] = entry(255)
+//
+// so the values are in the object file. The tables land in .rodata,
+// which is mapped read-only straight from the executable: no init code,
+// no "ready" flag, and one copy in the page cache however many processes
+// run the program.
+//
+//   table_crc32[8][256]        CRC-32 (IEEE, reflected), slicing-by-8
+//   table_popcount[256]        set bits in a byte
+//   table_select[256][8]       position of the k-th set bit in a byte, 8
+//                              if there are not that many
+//   table_char_class[256]      TABLE_CHAR_* flags for ASCII, independent
+//                              of the locale (unlike <ctype.h>)
+//   table_bswap_shuffle[9][16] pshufb masks that reverse the bytes of each
+//                              2-, 4- or 8-byte element, indexed by width
+//
+// Each is only emitted into files that use it. Range designators
+// ([a ... b] = v) are a GNU extension, accepted by GCC and Clang.
+#ifndef CONST_TABLES_H
+#define CONST_TABLES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TABLE_4(entry, n)                                                   \
+    [(n)] = entry(n), [(n) + 1] = entry((n) + 1),                           \
+        [(n) + 2] = entry((n) + 2), [(n) + 3] = entry((n) + 3)
+#define TABLE_16(entry, n)                                                  \
+    TABLE_4(entry, n), TABLE_4(entry, (n) + 4), TABLE_4(entry, (n) + 8),    \
+        TABLE_4(entry, (n) + 12)
+#define TABLE_64(entry, n)                                                  \
+    TABLE_16(entry, n), TABLE_16(entry, (n) + 16),                          \
+        TABLE_16(entry, (n) + 32), TABLE_16(entry, (n) + 48)
+#define TABLE_256(entry)                                                    \
+    TABLE_64(entry, 0), TABLE_64(entry, 64), TABLE_64(entry, 128),          \
+        TABLE_64(entry, 192)
+
+/* ---- CRC-32 ---- */
+
+// CRC is linear over GF(2): the entry for byte i is the XOR of the
+// entries for its set bits, so each slice needs only its eight
+// single-bit entries (k0 = entry[1] ... k7 = entry[128]). Slice t is the
+// CRC of the byte followed by t zero bytes.
+#define TABLE_CRC32_ENTRY(i, k0, k1, k2, k3, k4, k5, k6, k7)                \
+    (((0u - ((i) & 1u)) & k0) ^ ((0u - ((i) >> 1 & 1u)) & k1)               \
+     ^ ((0u - ((i) >> 2 & 1u)) & k2) ^ ((0u - ((i) >> 3 & 1u)) & k3)        \
+     ^ ((0u - ((i) >> 4 & 1u)) & k4) ^ ((0u - ((i) >> 5 & 1u)) & k5)        \
+     ^ ((0u - ((i) >> 6 & 1u)) & k6) ^ ((0u - ((i) >> 7 & 1u)) & k7))
+
+#define TABLE_CRC32_SLICE0(i)                                               \
+    TABLE_CRC32_ENTRY(i, 0x77073096u, 0xEE0E612Cu, 0x076DC419u, 0x0EDB8832u, \
+                      0x1DB71064u, 0x3B6E20C8u, 0x76DC4190u, 0xEDB88320u)
+#define TABLE_CRC32_SLICE1(i)                                               \
+    TABLE_CRC32_ENTRY(i, 0x191B3141u, 0x32366282u, 0x646CC504u, 0xC8D98A08u, \
+                      0x4AC21251u, 0x958424A2u, 0xF0794F05u, 0x3B83984Bu)
+#define TABLE_CRC32_SLICE2(i)                                               \
+    TABLE_CRC32_ENTRY(i, 0x01C26A37u, 0x0384D46Eu, 0x0709A8DCu, 0x0E1351B8u, \
+                      0x1C26A370u, 0x384D46E0u, 0x709A8DC0u, 0xE1351B80u)
+#define TABLE_CRC32_SLICE3(i)                                               \
+    TABLE_CRC32_ENTRY(i, 0xB8BC6765u, 0xAA09C88Bu, 0x8F629757u, 0xC5B428EFu, \
+                      0x5019579Fu, 0xA032AF3Eu, 0x9B14583Du, 0xED59B63Bu)
+#define TABLE_CRC32_SLICE4(i)                                               \
+    TABLE_CRC32_ENTRY(i, 0x3D6029B0u, 0x7AC05360u, 0xF580A6C0u, 0x30704BC1u, \
+                      0x60E09782u, 0xC1C12F04u, 0x58F35849u, 0xB1E6B092u)
+#define TABLE_CRC32_SLICE5(i)                                               \
+    TABLE_CRC32_ENTRY(i, 0xCB5CD3A5u, 0x4DC8A10Bu, 0x9B914216u, 0xEC53826Du, \
+                      0x03D6029Bu, 0x07AC0536u, 0x0F580A6Cu, 0x1EB014D8u)
+#define TABLE_CRC32_SLICE6(i)                                               \
+    TABLE_CRC32_ENTRY(i, 0xA6770BB4u, 0x979F1129u, 0xF44F2413u, 0x33EF4E67u, \
+                      0x67DE9CCEu, 0xCFBD399Cu, 0x440B7579u, 0x8816EAF2u)
+#define TABLE_CRC32_SLICE7(i)                                               \
+    TABLE_CRC32_ENTRY(i, 0xCCAA009Eu, 0x4225077Du, 0x844A0EFAu, 0xD3E51BB5u, \
+                      0x7CBB312Bu, 0xF9766256u, 0x299DC2EDu, 0x533B85DAu)
+
+static const uint32_t table_crc32[8][256] = {
+    [0] = {TABLE_256(TABLE_CRC32_SLICE0)},
+    [1] = {TABLE_256(TABLE_CRC32_SLICE1)},
+    [2] = {TABLE_256(TABLE_CRC32_SLICE2)},
+    [3] = {TABLE_256(TABLE_CRC32_SLICE3)},
+    [4] = {TABLE_256(TABLE_CRC32_SLICE4)},
+    [5] = {TABLE_256(TABLE_CRC32_SLICE5)},
+    [6] = {TABLE_256(TABLE_CRC32_SLICE6)},
+    [7] = {TABLE_256(TABLE_CRC32_SLICE7)},
+};
+
+// Continue a CRC over length more bytes. Start with crc = 0; the result
+// of one call is the crc argument of the next.
+static inline uint32_t table_crc32_update(uint32_t crc,
+                                          const void *data,
+                                          size_t length)
+{
+    const uint8_t *p = (const uint8_t *) data;
+    crc = ~crc;
+    // Eight bytes per step, eight independent lookups
+    for (; length >= 8; length -= 8, p += 8)
+    {
+        uint32_t low = crc ^ ((uint32_t) p[0] | (uint32_t) p[1] << 8
+                              | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24);
+        crc = table_crc32[7][low & 0xFF] ^ table_crc32[6][(low >> 8) & 0xFF]
+              ^ table_crc32[5][(low >> 16) & 0xFF] ^ table_crc32[4][low >> 24]
+              ^ table_crc32[3][p[4]] ^ table_crc32[2][p[5]]
+              ^ table_crc32[1][p[6]] ^ table_crc32[0][p[7]];
+    }
+    for (; length > 0; length--)
+    {
+        crc = (crc >> 8) ^ table_crc32[0][(crc ^ *p++) & 0xFF];
+    }
+    return ~crc;
+}
+
+/* ---- Bit counting ---- */
+
+#define TABLE_POPCOUNT_ENTRY(i)                                             \
+    (((i) & 1) + ((i) >> 1 & 1) + ((i) >> 2 & 1) + ((i) >> 3 & 1)           \
+     + ((i) >> 4 & 1) + ((i) >> 5 & 1) + ((i) >> 6 & 1) + ((i) >> 7 & 1))
+
+// The k-th set bit is at the number of positions p whose prefix
+// i & ((2 << p) - 1) holds at most k set bits; 8 if i has k or fewer
+#define TABLE_SELECT_BELOW(i, p, k)                                         \
+    (TABLE_POPCOUNT_ENTRY((i) & ((2 << (p)) - 1)) <= (k))
+#define TABLE_SELECT_K(i, k)                                                \
+    (TABLE_SELECT_BELOW(i, 0, k) + TABLE_SELECT_BELOW(i, 1, k)              \
+     + TABLE_SELECT_BELOW(i, 2, k) + TABLE_SELECT_BELOW(i, 3, k)            \
+     + TABLE_SELECT_BELOW(i, 4, k) + TABLE_SELECT_BELOW(i, 5, k)            \
+     + TABLE_SELECT_BELOW(i, 6, k) + TABLE_SELECT_BELOW(i, 7, k))
+#define TABLE_SELECT_ENTRY(i)                                               \
+    {TABLE_SELECT_K(i, 0), TABLE_SELECT_K(i, 1), TABLE_SELECT_K(i, 2),      \
+     TABLE_SELECT_K(i, 3), TABLE_SELECT_K(i, 4), TABLE_SELECT_K(i, 5),      \
+     TABLE_SELECT_K(i, 6), TABLE_SELECT_K(i, 7)}
+
+static const uint8_t table_popcount[256] = {TABLE_256(TABLE_POPCOUNT_ENTRY)};
+static const uint8_t table_select[256][8] = {TABLE_256(TABLE_SELECT_ENTRY)};
+
+/* ---- Character classes ---- */
+
+#define TABLE_CHAR_SPACE 0x01  // ' ', \t, \n, \v, \f, \r
+#define TABLE_CHAR_DIGIT 0x02
+#define TABLE_CHAR_UPPER 0x04
+#define TABLE_CHAR_LOWER 0x08
+#define TABLE_CHAR_HEX   0x10  // 0-9, a-f, A-F
+#define TABLE_CHAR_PUNCT 0x20  // Printable, not alphanumeric or space
+#define TABLE_CHAR_IDENT 0x40  // Letters, digits and '_'
+#define TABLE_CHAR_ALPHA (TABLE_CHAR_UPPER | TABLE_CHAR_LOWER)
+#define TABLE_CHAR_ALNUM (TABLE_CHAR_ALPHA | TABLE_CHAR_DIGIT)
+
+// Bytes 0x80 and up have no class
+static const uint8_t table_char_class[256] = {
+    ['\t' ... '\r'] = TABLE_CHAR_SPACE,
+    [' '] = TABLE_CHAR_SPACE,
+    ['!' ... '/'] = TABLE_CHAR_PUNCT,
+    ['0' ... '9'] = TABLE_CHAR_DIGIT | TABLE_CHAR_HEX | TABLE_CHAR_IDENT,
+    [':' ... '@'] = TABLE_CHAR_PUNCT,
+    ['A' ... 'F'] = TABLE_CHAR_UPPER | TABLE_CHAR_HEX | TABLE_CHAR_IDENT,
+    ['G' ... 'Z'] = TABLE_CHAR_UPPER | TABLE_CHAR_IDENT,
+    ['[' ... '^'] = TABLE_CHAR_PUNCT,
+    ['_'] = TABLE_CHAR_PUNCT | TABLE_CHAR_IDENT,
+    ['`'] = TABLE_CHAR_PUNCT,
+    ['a' ... 'f'] = TABLE_CHAR_LOWER | TABLE_CHAR_HEX | TABLE_CHAR_IDENT,
+    ['g' ... 'z'] = TABLE_CHAR_LOWER | TABLE_CHAR_IDENT,
+    ['{' ... '~'] = TABLE_CHAR_PUNCT,
+};
+
+// True if c has any of the TABLE_CHAR_* classes in mask
+static inline int table_char_is(char c, unsigned mask)
+{
+    return (table_char_class[(unsigned char) c] & mask) != 0;
+}
+
+/* ---- Byte-swap shuffles ---- */
+
+// Byte i of a 16-byte lane comes from the mirror position inside its
+// element: the start of the element plus (width - 1 - offset)
+#define TABLE_BSWAP(i, width)                                               \
+    ((i) / (width) * (width) + (width) - 1 - (i) % (width))
+#define TABLE_BSWAP2(i) TABLE_BSWAP(i, 2)
+#define TABLE_BSWAP4(i) TABLE_BSWAP(i, 4)
+#define TABLE_BSWAP8(i) TABLE_BSWAP(i, 8)
+
+// Rows for other widths are zero (they broadcast byte 0; do not use them)
+static const uint8_t table_bswap_shuffle[9][16] = {
+    [2] = {TABLE_16(TABLE_BSWAP2, 0)},
+    [4] = {TABLE_16(TABLE_BSWAP4, 0)},
+    [8] = {TABLE_16(TABLE_BSWAP8, 0)},
+};
+
+#endif  // CONST_TABLES_H
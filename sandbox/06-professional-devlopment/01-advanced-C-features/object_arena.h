@@ -0,0 +1,109 @@
+// Small objects without malloc: values, arena placement, explicit escape.
+//
+// A create_x() that mallocs a 16-byte struct costs a trip through the
+// allocator, a free() the caller has to remember, and a pointer chase on
+// every access, even when the object lives for one loop iteration. Most
+// such objects can be one of:
+//
+//   a value     Point p = point_make(1, 2);  a constructor that returns
+//               a compound literal, e.g. return (Point){x, y}; small
+//               structs come back in registers or are built in place
+//   in an arena Point *p = OBJECT_NEW(&arena, Point, 1, 2);  a bump
+//               allocation in a buffer the caller owns (often on the
+//               stack), released all at once by object_arena_reset()
+//   escaped     Point *p = OBJECT_ESCAPE(&value);  an explicit heap copy,
+//               for the objects that really must outlive the scope
+//
+// OBJECT_NEW returns NULL when the arena is full; falling back to the
+// heap is the caller's decision, never a silent one. object_stats counts
+// heap escapes and arena placements so a demo can show where its objects
+// went.
+#ifndef OBJECT_ARENA_H
+#define OBJECT_ARENA_H
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    unsigned char *base;
+    size_t size;
+    size_t used;
+} ObjectArena;
+
+static struct
+{
+    size_t heap_escapes;   // OBJECT_ESCAPE / object_escape calls that succeeded
+    size_t arena_objects;  // Successful OBJECT_NEW placements
+    size_t arena_full;     // OBJECT_NEW calls that found the arena full
+} object_stats;
+
+static inline ObjectArena object_arena_from(void *storage, size_t size)
+{
+    return (ObjectArena){(unsigned char *) storage, size, 0};
+}
+
+// An arena over a local buffer: released when the enclosing block ends
+#define OBJECT_ARENA_ON_STACK(name, bytes)                              \
+    alignas(max_align_t) unsigned char name##_storage[bytes];           \
+    ObjectArena name =                                                  \
+        object_arena_from(name##_storage, sizeof(name##_storage))
+
+static inline void *object_arena_alloc(ObjectArena *arena,
+                                       size_t size,
+                                       size_t align)
+{
+    uintptr_t start = (uintptr_t) (arena->base + arena->used);
+    size_t pad = (size_t) (-start & (align - 1));
+    if (pad + size > arena->size - arena->used) return NULL;
+    arena->used += pad + size;
+    return (void *) (start + pad);
+}
+
+// Everything placed so far is gone; the buffer is reused from the start
+static inline void object_arena_reset(ObjectArena *arena)
+{
+    arena->used = 0;
+}
+
+static inline void *object_arena_place(ObjectArena *arena,
+                                       const void *value,
+                                       size_t size,
+                                       size_t align)
+{
+    void *p = object_arena_alloc(arena, size, align);
+    if (p == NULL)
+    {
+        object_stats.arena_full++;
+        return NULL;
+    }
+    object_stats.arena_objects++;
+    return memcpy(p, value, size);
+}
+
+// OBJECT_NEW(&arena, Point, .x = 1, .y = 2): the arguments initialize a
+// (Type){...} compound literal, which is copied into the arena
+#define OBJECT_NEW(arena, Type, ...)                                    \
+    ((Type *) object_arena_place((arena), &(Type){__VA_ARGS__},         \
+                                 sizeof(Type), alignof(Type)))
+
+// A heap copy of size bytes at value; free() it as usual
+static inline void *object_escape(const void *value, size_t size)
+{
+    void *p = malloc(size);
+    if (p == NULL) return NULL;
+    object_stats.heap_escapes++;
+    return memcpy(p, value, size);
+}
+
+// Variadic so that a compound literal's commas pass through:
+// OBJECT_ESCAPE(&(Point){1, 2}). Only the object_escape argument is
+// evaluated; __typeof__ and sizeof are not.
+#define OBJECT_ESCAPE(...)                                              \
+    ((__typeof__(__VA_ARGS__)) object_escape((__VA_ARGS__),             \
+                                             sizeof(*(__VA_ARGS__))))
+
+#endif  // OBJECT_ARENA_H
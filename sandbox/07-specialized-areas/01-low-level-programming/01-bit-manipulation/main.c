@@ -1,5 +1,18 @@
+#define _GNU_SOURCE  // CPU pinning in the benchmark harness
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../../../06-professional-devlopment/01-advanced-C-features/const_tables.h"
+#include "../cycle_bench.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BITS_X86 1
+#endif
 
 // Print a byte in binary format
 void print_binary(uint8_t byte)
@@ -22,6 +35,525 @@ void print_binary32(uint32_t value)
     }
 }
 
+// ===== Bit-Operation Kernels =====
+//
+// Reusable word-level operations. The scalar helpers map to single
+// instructions through the compiler builtins; PEXT/PDEP pick the BMI2
+// instruction at run time and fall back to a loop over the mask bits. The
+// bulk array kernels are plain loops built for several ISAs with
+// target_clones, so the loader picks the widest one the CPU supports.
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define BITS_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#define BITS_COUNT_CLONES \
+    __attribute__((target_clones("avx2", "popcnt", "default")))
+#else
+#define BITS_CLONES
+#define BITS_COUNT_CLONES
+#endif
+
+static inline int bits_popcount64(uint64_t x)
+{
+    return __builtin_popcountll(x);
+}
+
+// Index of the lowest set bit; 64 when x is 0
+static inline int bits_ctz64(uint64_t x)
+{
+    return x ? __builtin_ctzll(x) : 64;
+}
+
+// Number of zero bits above the highest set bit; 64 when x is 0
+static inline int bits_clz64(uint64_t x)
+{
+    return x ? __builtin_clzll(x) : 64;
+}
+
+// Gather the bits of x selected by mask into the low bits of the result
+static uint64_t bits_pext_portable(uint64_t x, uint64_t mask)
+{
+    uint64_t result = 0;
+    for (uint64_t bit = 1; mask != 0; bit <<= 1)
+    {
+        if (x & mask & -mask) result |= bit;
+        mask &= mask - 1;
+    }
+    return result;
+}
+
+// Scatter the low bits of x to the positions set in mask
+static uint64_t bits_pdep_portable(uint64_t x, uint64_t mask)
+{
+    uint64_t result = 0;
+    for (uint64_t bit = 1; mask != 0; bit <<= 1)
+    {
+        if (x & bit) result |= mask & -mask;
+        mask &= mask - 1;
+    }
+    return result;
+}
+
+#if defined(BITS_X86) && defined(__x86_64__)
+__attribute__((target("bmi2"))) static uint64_t bits_pext_bmi2(uint64_t x,
+                                                               uint64_t mask)
+{
+    return _pext_u64(x, mask);
+}
+
+__attribute__((target("bmi2"))) static uint64_t bits_pdep_bmi2(uint64_t x,
+                                                               uint64_t mask)
+{
+    return _pdep_u64(x, mask);
+}
+#endif
+
+static uint64_t (*bits_pext_impl)(uint64_t, uint64_t) = bits_pext_portable;
+static uint64_t (*bits_pdep_impl)(uint64_t, uint64_t) = bits_pdep_portable;
+
+// Select the PEXT/PDEP implementations once; safe to call repeatedly
+void bits_init(void)
+{
+#if defined(BITS_X86) && defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("bmi2"))
+    {
+        bits_pext_impl = bits_pext_bmi2;
+        bits_pdep_impl = bits_pdep_bmi2;
+    }
+#endif
+}
+
+bool bits_have_bmi2(void)
+{
+    return bits_pext_impl != bits_pext_portable;
+}
+
+static inline uint64_t bits_pext64(uint64_t x, uint64_t mask)
+{
+    return bits_pext_impl(x, mask);
+}
+
+static inline uint64_t bits_pdep64(uint64_t x, uint64_t mask)
+{
+    return bits_pdep_impl(x, mask);
+}
+
+// Position of the k-th set bit (k counts from 0); 64 if there are not
+// that many
+static int bits_select64(uint64_t x, int k)
+{
+    if (k >= bits_popcount64(x)) return 64;
+    if (bits_have_bmi2()) return bits_ctz64(bits_pdep64(1ULL << k, x));
+
+    // Skip whole bytes, then finish inside the byte: two table lookups
+    // per byte instead of a popcount and a clear-lowest-bit loop
+    int base = 0;
+    for (;;)
+    {
+        int in_byte = table_popcount[x & 0xFF];
+        if (k < in_byte) break;
+        k -= in_byte;
+        x >>= 8;
+        base += 8;
+    }
+    return base + table_select[x & 0xFF][k];
+}
+
+// Gather the same mask out of a whole array; dispatches once per call
+void bits_pext_array(uint64_t *dst,
+                     const uint64_t *src,
+                     size_t count,
+                     uint64_t mask)
+{
+    uint64_t (*pext)(uint64_t, uint64_t) = bits_pext_impl;
+    for (size_t i = 0; i < count; i++)
+    {
+        dst[i] = pext(src[i], mask);
+    }
+}
+
+// Bulk word kernels; dst may be the same array as a or b
+
+BITS_CLONES void bits_and(uint64_t *dst,
+                          const uint64_t *a,
+                          const uint64_t *b,
+                          size_t words)
+{
+    for (size_t i = 0; i < words; i++)
+    {
+        dst[i] = a[i] & b[i];
+    }
+}
+
+BITS_CLONES void bits_or(uint64_t *dst,
+                         const uint64_t *a,
+                         const uint64_t *b,
+                         size_t words)
+{
+    for (size_t i = 0; i < words; i++)
+    {
+        dst[i] = a[i] | b[i];
+    }
+}
+
+BITS_CLONES void bits_xor(uint64_t *dst,
+                          const uint64_t *a,
+                          const uint64_t *b,
+                          size_t words)
+{
+    for (size_t i = 0; i < words; i++)
+    {
+        dst[i] = a[i] ^ b[i];
+    }
+}
+
+// dst = a & ~b: keep the bits of a that b does not exclude
+BITS_CLONES void bits_andnot(uint64_t *dst,
+                             const uint64_t *a,
+                             const uint64_t *b,
+                             size_t words)
+{
+    for (size_t i = 0; i < words; i++)
+    {
+        dst[i] = a[i] & ~b[i];
+    }
+}
+
+BITS_COUNT_CLONES uint64_t bits_count(const uint64_t *words, size_t count)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        total += (uint64_t) __builtin_popcountll(words[i]);
+    }
+    return total;
+}
+
+// Population count of a & b without materializing the intersection
+BITS_COUNT_CLONES uint64_t bits_and_count(const uint64_t *a,
+                                          const uint64_t *b,
+                                          size_t count)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        total += (uint64_t) __builtin_popcountll(a[i] & b[i]);
+    }
+    return total;
+}
+
+// ===== Bit Vector with Rank/Select =====
+//
+// rank(i) counts the ones before position i and select(k) finds the
+// k-th one. A directory holds the number of ones before every 512-bit
+// block (one cache line of words), so rank costs one lookup plus at most
+// eight popcounts, and select binary-searches the directory first.
+
+#define BITVEC_BLOCK_WORDS 8
+
+typedef struct
+{
+    uint64_t *words;
+    size_t bits;
+    size_t word_count;
+    uint64_t *block_ranks;  // ones before each block, plus the total
+    size_t block_count;
+} BitVector;
+
+bool bitvec_init(BitVector *bv, size_t bits)
+{
+    bv->bits = bits;
+    bv->word_count = (bits + 63) / 64;
+    bv->block_count =
+        (bv->word_count + BITVEC_BLOCK_WORDS - 1) / BITVEC_BLOCK_WORDS;
+    bv->words = (uint64_t *) calloc(bv->word_count + 1, sizeof(uint64_t));
+    bv->block_ranks =
+        (uint64_t *) calloc(bv->block_count + 1, sizeof(uint64_t));
+    if (bv->words == NULL || bv->block_ranks == NULL)
+    {
+        free(bv->words);
+        free(bv->block_ranks);
+        bv->words = NULL;
+        bv->block_ranks = NULL;
+        return false;
+    }
+    return true;
+}
+
+void bitvec_free(BitVector *bv)
+{
+    free(bv->words);
+    free(bv->block_ranks);
+    bv->words = NULL;
+    bv->block_ranks = NULL;
+}
+
+static inline void bitvec_set(BitVector *bv, size_t pos)
+{
+    bv->words[pos / 64] |= 1ULL << (pos % 64);
+}
+
+static inline void bitvec_clear(BitVector *bv, size_t pos)
+{
+    bv->words[pos / 64] &= ~(1ULL << (pos % 64));
+}
+
+static inline bool bitvec_test(const BitVector *bv, size_t pos)
+{
+    return (bv->words[pos / 64] >> (pos % 64)) & 1;
+}
+
+// Rebuild the rank directory; call after the last set/clear and before
+// rank or select
+void bitvec_build_rank(BitVector *bv)
+{
+    uint64_t ones = 0;
+    for (size_t block = 0; block < bv->block_count; block++)
+    {
+        bv->block_ranks[block] = ones;
+        size_t first = block * BITVEC_BLOCK_WORDS;
+        size_t words = bv->word_count - first < BITVEC_BLOCK_WORDS
+                           ? bv->word_count - first
+                           : BITVEC_BLOCK_WORDS;
+        ones += bits_count(bv->words + first, words);
+    }
+    bv->block_ranks[bv->block_count] = ones;
+}
+
+// Ones in [0, pos); pos may equal the length
+uint64_t bitvec_rank1(const BitVector *bv, size_t pos)
+{
+    size_t word = pos / 64;
+    size_t block = word / BITVEC_BLOCK_WORDS;
+    uint64_t rank = bv->block_ranks[block];
+    for (size_t i = block * BITVEC_BLOCK_WORDS; i < word; i++)
+    {
+        rank += (uint64_t) bits_popcount64(bv->words[i]);
+    }
+    if (pos % 64 != 0)
+    {
+        rank += (uint64_t) bits_popcount64(bv->words[word]
+                                           & ((1ULL << (pos % 64)) - 1));
+    }
+    return rank;
+}
+
+// Position of the k-th one (k counts from 0); SIZE_MAX if there are not
+// that many
+size_t bitvec_select1(const BitVector *bv, uint64_t k)
+{
+    if (k >= bv->block_ranks[bv->block_count]) return SIZE_MAX;
+
+    // Last block whose rank is <= k
+    size_t low = 0;
+    size_t high = bv->block_count;
+    while (high - low > 1)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (bv->block_ranks[mid] <= k)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    k -= bv->block_ranks[low];
+    size_t word = low * BITVEC_BLOCK_WORDS;
+    for (;;)
+    {
+        uint64_t ones = (uint64_t) bits_popcount64(bv->words[word]);
+        if (k < ones) break;
+        k -= ones;
+        word++;
+    }
+    return word * 64 + (size_t) bits_select64(bv->words[word], (int) k);
+}
+
+static uint64_t xorshift64(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// Loop-per-bit reference for the benchmark
+static uint64_t count_bits_slow(const uint64_t *words, size_t count)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        for (int bit = 0; bit < 64; bit++)
+        {
+            total += (words[i] >> bit) & 1;
+        }
+    }
+    return total;
+}
+
+typedef struct
+{
+    const uint64_t *a;
+    const uint64_t *b;
+    uint64_t *out;
+    size_t words;
+    uint64_t matches;
+} FilterBench;
+
+static void bench_filter_slow(void *arg, uint64_t iterations)
+{
+    FilterBench *bench = (FilterBench *) arg;
+    for (uint64_t r = 0; r < iterations; r++)
+    {
+        for (size_t i = 0; i < bench->words; i++)
+        {
+            bench->out[i] = bench->a[i] & bench->b[i];
+        }
+        bench->matches = count_bits_slow(bench->out, bench->words);
+    }
+}
+
+static void bench_filter_kernels(void *arg, uint64_t iterations)
+{
+    FilterBench *bench = (FilterBench *) arg;
+    for (uint64_t r = 0; r < iterations; r++)
+    {
+        bits_and(bench->out, bench->a, bench->b, bench->words);
+        bench->matches = bits_count(bench->out, bench->words);
+    }
+}
+
+static void bench_filter_fused(void *arg, uint64_t iterations)
+{
+    FilterBench *bench = (FilterBench *) arg;
+    for (uint64_t r = 0; r < iterations; r++)
+    {
+        bench->matches = bits_and_count(bench->a, bench->b, bench->words);
+    }
+}
+
+void demo_bit_kernels(void)
+{
+    printf("\n=== Bit-Operation Kernels ===\n");
+    bits_init();
+    printf("PEXT/PDEP: %s\n",
+           bits_have_bmi2() ? "BMI2 instructions" : "portable fallback");
+
+    uint64_t sample = 0x00F0000000080100ULL;
+    printf("0x%016llX: popcount %d, ctz %d, clz %d\n",
+           (unsigned long long) sample,
+           bits_popcount64(sample),
+           bits_ctz64(sample),
+           bits_clz64(sample));
+
+    // Pull the 5-6-5 fields of an RGB565 pixel apart in one step each
+    uint64_t pixel = 0xF81F;  // red 31, green 0, blue 31
+    printf("RGB565 0x%04llX -> red %llu, green %llu, blue %llu\n",
+           (unsigned long long) pixel,
+           (unsigned long long) bits_pext64(pixel, 0xF800),
+           (unsigned long long) bits_pext64(pixel, 0x07E0),
+           (unsigned long long) bits_pext64(pixel, 0x001F));
+    printf("pdep(0b101, 0xF0) = 0x%02llX\n",
+           (unsigned long long) bits_pdep64(0x5, 0xF0));
+
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    int mismatches = 0;
+    for (int i = 0; i < 100000; i++)
+    {
+        uint64_t x = xorshift64(&state);
+        uint64_t mask = xorshift64(&state);
+        if (bits_pext64(x, mask) != bits_pext_portable(x, mask)
+            || bits_pdep64(x, mask) != bits_pdep_portable(x, mask))
+        {
+            mismatches++;
+        }
+    }
+    printf("PEXT/PDEP vs portable on 100000 random pairs: %d mismatches\n",
+           mismatches);
+
+    // Rank/select on a bit vector with every third position set
+    BitVector bv;
+    size_t length = 1000000;
+    if (!bitvec_init(&bv, length))
+    {
+        printf("Out of memory\n");
+        return;
+    }
+    for (size_t i = 0; i < length; i += 3)
+    {
+        bitvec_set(&bv, i);
+    }
+    bitvec_build_rank(&bv);
+    printf("Bit vector of %zu bits: rank(999999) = %llu, select(1000) = %zu"
+           ", select(400000) = %s\n",
+           length,
+           (unsigned long long) bitvec_rank1(&bv, 999999),
+           bitvec_select1(&bv, 1000),
+           bitvec_select1(&bv, 400000) == SIZE_MAX ? "none" : "found");
+
+    bool consistent = true;
+    for (uint64_t k = 0; k < 333334; k += 997)
+    {
+        size_t pos = bitvec_select1(&bv, k);
+        if (pos != k * 3 || bitvec_rank1(&bv, pos) != k
+            || !bitvec_test(&bv, pos))
+        {
+            consistent = false;
+        }
+    }
+    printf("rank(select(k)) == k: %s\n", consistent ? "yes" : "no");
+    bitvec_free(&bv);
+
+    // Bitmap filtering: intersect two predicates and count the matches
+    size_t words = 1 << 20;  // 64M rows
+    uint64_t *a = (uint64_t *) malloc(words * sizeof(uint64_t));
+    uint64_t *b = (uint64_t *) malloc(words * sizeof(uint64_t));
+    uint64_t *out = (uint64_t *) malloc(words * sizeof(uint64_t));
+    if (a == NULL || b == NULL || out == NULL)
+    {
+        printf("Out of memory\n");
+        free(a);
+        free(b);
+        free(out);
+        return;
+    }
+    for (size_t i = 0; i < words; i++)
+    {
+        a[i] = xorshift64(&state);
+        b[i] = xorshift64(&state);
+    }
+
+    // One iteration is a full pass over both bitmaps
+    FilterBench bench = {a, b, out, words, 0};
+    CycleBenchConfig config = {"loop per bit", 1, 1, 5, true};
+    printf("AND + count over %zu bits:\n", words * 64);
+    CycleBenchResult slow = cycle_bench(&config, bench_filter_slow, &bench);
+    uint64_t slow_matches = bench.matches;
+
+    config.repetitions = 21;
+    config.name = "bits_and + bits_count";
+    CycleBenchResult fast = cycle_bench(&config, bench_filter_kernels, &bench);
+    uint64_t fast_matches = bench.matches;
+
+    config.name = "bits_and_count";
+    CycleBenchResult fused = cycle_bench(&config, bench_filter_fused, &bench);
+
+    printf("Matches %llu / %llu / %llu; speedup %.1fx and %.1fx\n",
+           (unsigned long long) slow_matches,
+           (unsigned long long) fast_matches,
+           (unsigned long long) bench.matches,
+           slow.median_ticks / fast.median_ticks,
+           slow.median_ticks / fused.median_ticks);
+
+    free(a);
+    free(b);
+    free(out);
+}
+
 int main()
 {
     printf("=== Basic Bitwise Operations ===\n");
@@ -226,5 +758,7 @@ int main()
     }
     printf("Most significant bit position: %d\n", position);
 
+    demo_bit_kernels();
+
     return 0;
 }
@@ -1,14 +1,27 @@
+#define _GNU_SOURCE  // CPU pinning in the benchmark harness
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#include "../../../06-professional-devlopment/01-advanced-C-features/const_tables.h"
+#include "../cycle_bench.h"
 
 // Function to check system endianness
 bool is_big_endian()
 {
+#if defined(__BYTE_ORDER__)
+    // Known at compile time, so the conversions below fold to a bswap or
+    // to nothing
+    return __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__;
+#else
     uint16_t value = 0x1234;
     uint8_t *ptr = (uint8_t *) &value;
     return (ptr[0] == 0x12);
+#endif
 }
 
 // Display the bytes of a 32-bit integer
@@ -35,7 +48,7 @@ uint16_t host_to_big_endian_16(uint16_t value)
     else
     {
         // Swap bytes for little endian
-        return ((value & 0xFF) << 8) | ((value & 0xFF00) >> 8);
+        return __builtin_bswap16(value);
     }
 }
 
@@ -49,11 +62,16 @@ uint32_t host_to_big_endian_32(uint32_t value)
     else
     {
         // Swap bytes for little endian
-        return ((value & 0xFF) << 24) | ((value & 0xFF00) << 8)
-               | ((value & 0xFF0000) >> 8) | ((value & 0xFF000000) >> 24);
+        return __builtin_bswap32(value);
     }
 }
 
+// Convert a 64-bit value from host to big-endian
+uint64_t host_to_big_endian_64(uint64_t value)
+{
+    return is_big_endian() ? value : __builtin_bswap64(value);
+}
+
 // Convert a 16-bit value from big-endian to host
 uint16_t big_endian_to_host_16(uint16_t value)
 {
@@ -66,74 +84,766 @@ uint32_t big_endian_to_host_32(uint32_t value)
     return host_to_big_endian_32(value);  // Same algorithm works both ways
 }
 
+// Convert a 64-bit value from big-endian to host
+uint64_t big_endian_to_host_64(uint64_t value)
+{
+    return host_to_big_endian_64(value);
+}
+
+// The unaligned accessors load or store through memcpy, which the compiler
+// turns into one (possibly unaligned) move, followed by a bswap only when
+// the requested order differs from the host's. On x86 with MOVBE the pair
+// becomes a single instruction.
+
 // Read a 16-bit value from unaligned memory with specified endianness
 uint16_t read_unaligned_16(const uint8_t *buffer, bool big_endian)
 {
     uint16_t value;
+    memcpy(&value, buffer, sizeof(value));
+    return big_endian == is_big_endian() ? value : __builtin_bswap16(value);
+}
+
+// Read a 32-bit value from unaligned memory with specified endianness
+uint32_t read_unaligned_32(const uint8_t *buffer, bool big_endian)
+{
+    uint32_t value;
+    memcpy(&value, buffer, sizeof(value));
+    return big_endian == is_big_endian() ? value : __builtin_bswap32(value);
+}
+
+// Read a 64-bit value from unaligned memory with specified endianness
+uint64_t read_unaligned_64(const uint8_t *buffer, bool big_endian)
+{
+    uint64_t value;
+    memcpy(&value, buffer, sizeof(value));
+    return big_endian == is_big_endian() ? value : __builtin_bswap64(value);
+}
+
+// Write a 16-bit value to unaligned memory with specified endianness
+void write_unaligned_16(uint8_t *buffer, uint16_t value, bool big_endian)
+{
+    if (big_endian != is_big_endian()) value = __builtin_bswap16(value);
+    memcpy(buffer, &value, sizeof(value));
+}
+
+// Write a 32-bit value to unaligned memory with specified endianness
+void write_unaligned_32(uint8_t *buffer, uint32_t value, bool big_endian)
+{
+    if (big_endian != is_big_endian()) value = __builtin_bswap32(value);
+    memcpy(buffer, &value, sizeof(value));
+}
 
-    if (big_endian)
+// Write a 64-bit value to unaligned memory with specified endianness
+void write_unaligned_64(uint8_t *buffer, uint64_t value, bool big_endian)
+{
+    if (big_endian != is_big_endian()) value = __builtin_bswap64(value);
+    memcpy(buffer, &value, sizeof(value));
+}
+
+// ===== Bulk Conversion =====
+//
+// Convert whole arrays between host order and big-endian (network order)
+// wire buffers. The wire side is a byte pointer, so it need not be
+// aligned. x86 reverses each element with a byte shuffle (AVX2 or SSSE3,
+// picked at run time) and ARM with NEON's vrev; the tail, and every other
+// target, uses the bswap builtin. A big-endian host just copies.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define ENDIAN_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#ifdef ENDIAN_X86
+// Byte order within each 16-byte lane, indexed by element width:
+// table_bswap_shuffle[2], [4] and [8] from const_tables.h
+__attribute__((target("avx2"))) static size_t swap_copy_avx2(
+    uint8_t *dst, const uint8_t *src, size_t bytes, int width)
+{
+    __m128i lane =
+        _mm_loadu_si128((const __m128i *) table_bswap_shuffle[width]);
+    __m256i mask = _mm256_broadcastsi128_si256(lane);
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32)
     {
-        value = (uint16_t) buffer[0] << 8 | buffer[1];
+        __m256i v = _mm256_loadu_si256((const __m256i *) (src + i));
+        _mm256_storeu_si256((__m256i *) (dst + i),
+                            _mm256_shuffle_epi8(v, mask));
     }
-    else
+    return i;
+}
+
+__attribute__((target("ssse3"))) static size_t swap_copy_ssse3(
+    uint8_t *dst, const uint8_t *src, size_t bytes, int width)
+{
+    __m128i mask =
+        _mm_loadu_si128((const __m128i *) table_bswap_shuffle[width]);
+    size_t i = 0;
+    for (; i + 16 <= bytes; i += 16)
     {
-        value = (uint16_t) buffer[1] << 8 | buffer[0];
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_shuffle_epi8(v, mask));
     }
+    return i;
+}
+#endif
 
-    return value;
+// Vectorised part of a swapping copy; returns how many bytes it handled
+static size_t swap_copy_simd(uint8_t *dst,
+                             const uint8_t *src,
+                             size_t bytes,
+                             int width)
+{
+#ifdef ENDIAN_X86
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return swap_copy_avx2(dst, src, bytes, width);
+    }
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        return swap_copy_ssse3(dst, src, bytes, width);
+    }
+    return 0;
+#elif defined(__ARM_NEON)
+    size_t i = 0;
+    for (; i + 16 <= bytes; i += 16)
+    {
+        uint8x16_t v = vld1q_u8(src + i);
+        if (width == 2)
+        {
+            v = vrev16q_u8(v);
+        }
+        else if (width == 4)
+        {
+            v = vrev32q_u8(v);
+        }
+        else
+        {
+            v = vrev64q_u8(v);
+        }
+        vst1q_u8(dst + i, v);
+    }
+    return i;
+#else
+    (void) dst;
+    (void) src;
+    (void) bytes;
+    (void) width;
+    return 0;
+#endif
 }
 
-// Read a 32-bit value from unaligned memory with specified endianness
-uint32_t read_unaligned_32(const uint8_t *buffer, bool big_endian)
+// Copy count elements of the given width, reversing the bytes of each.
+// dst and src may be the same buffer.
+static void swap_copy(void *dst, const void *src, size_t count, int width)
 {
-    uint32_t value;
+    uint8_t *out = (uint8_t *) dst;
+    const uint8_t *in = (const uint8_t *) src;
+    size_t bytes = count * (size_t) width;
+
+    for (size_t i = swap_copy_simd(out, in, bytes, width); i < bytes;
+         i += (size_t) width)
+    {
+        if (width == 2)
+        {
+            uint16_t v;
+            memcpy(&v, in + i, 2);
+            v = __builtin_bswap16(v);
+            memcpy(out + i, &v, 2);
+        }
+        else if (width == 4)
+        {
+            uint32_t v;
+            memcpy(&v, in + i, 4);
+            v = __builtin_bswap32(v);
+            memcpy(out + i, &v, 4);
+        }
+        else
+        {
+            uint64_t v;
+            memcpy(&v, in + i, 8);
+            v = __builtin_bswap64(v);
+            memcpy(out + i, &v, 8);
+        }
+    }
+}
 
-    if (big_endian)
+// Host array -> big-endian wire bytes (or back); a plain copy on a
+// big-endian host
+static void convert_big_endian(void *dst,
+                               const void *src,
+                               size_t count,
+                               int width)
+{
+    if (is_big_endian())
     {
-        value = (uint32_t) buffer[0] << 24 | (uint32_t) buffer[1] << 16
-                | (uint32_t) buffer[2] << 8 | buffer[3];
+        if (dst != src) memmove(dst, src, count * (size_t) width);
     }
     else
     {
-        value = (uint32_t) buffer[3] << 24 | (uint32_t) buffer[2] << 16
-                | (uint32_t) buffer[1] << 8 | buffer[0];
+        swap_copy(dst, src, count, width);
     }
+}
 
-    return value;
+void store_big_endian_16(uint8_t *out, const uint16_t *values, size_t count)
+{
+    convert_big_endian(out, values, count, 2);
 }
 
-// Write a 16-bit value to unaligned memory with specified endianness
-void write_unaligned_16(uint8_t *buffer, uint16_t value, bool big_endian)
+void store_big_endian_32(uint8_t *out, const uint32_t *values, size_t count)
+{
+    convert_big_endian(out, values, count, 4);
+}
+
+void store_big_endian_64(uint8_t *out, const uint64_t *values, size_t count)
+{
+    convert_big_endian(out, values, count, 8);
+}
+
+void load_big_endian_16(uint16_t *values, const uint8_t *in, size_t count)
+{
+    convert_big_endian(values, in, count, 2);
+}
+
+void load_big_endian_32(uint32_t *values, const uint8_t *in, size_t count)
+{
+    convert_big_endian(values, in, count, 4);
+}
+
+void load_big_endian_64(uint64_t *values, const uint8_t *in, size_t count)
+{
+    convert_big_endian(values, in, count, 8);
+}
+
+// ===== Variable-Length and Packed Integer Codecs =====
+//
+// Building blocks for compressing integer columns on the wire:
+// - LEB128 varints: 7 bits per byte, high bit set on every byte but the
+//   last. Small values take one byte.
+// - Zigzag maps signed values to unsigned ones with small magnitudes
+//   first (0, -1, 1, -2, ... -> 0, 1, 2, 3, ...), so they varint well.
+// - Delta coding stores each value as the zigzagged difference from the
+//   previous one; sorted ids and timestamps turn into small numbers.
+// - Frame-of-reference packing stores a block of up to FOR_BLOCK values
+//   as the block minimum plus every value's offset in just enough bits.
+// All multi-byte fields are little-endian.
+
+#define VARINT_MAX_BYTES 10
+#define FOR_BLOCK        128
+#define FOR_HEADER_SIZE  5  // minimum u32 + bit width u8
+
+// Worst-case size of int_column_encode output for count values
+#define INT_COLUMN_BOUND(count) \
+    ((((count) + FOR_BLOCK - 1) / FOR_BLOCK) * (FOR_HEADER_SIZE + 8) \
+     + (count) * 4)
+
+static inline uint32_t zigzag_encode_32(int32_t value)
+{
+    return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+}
+
+static inline int32_t zigzag_decode_32(uint32_t value)
 {
-    if (big_endian)
+    return (int32_t) ((value >> 1) ^ (0u - (value & 1)));
+}
+
+static inline uint64_t zigzag_encode_64(int64_t value)
+{
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+static inline int64_t zigzag_decode_64(uint64_t value)
+{
+    return (int64_t) ((value >> 1) ^ (0ull - (value & 1)));
+}
+
+// Write value as a varint; returns the bytes used (1 to 10)
+size_t varint_encode_64(uint8_t *out, uint64_t value)
+{
+    size_t length = 0;
+    while (value >= 0x80)
     {
-        buffer[0] = (value >> 8) & 0xFF;
-        buffer[1] = value & 0xFF;
+        out[length++] = (uint8_t) (value | 0x80);
+        value >>= 7;
     }
-    else
+    out[length++] = (uint8_t) value;
+    return length;
+}
+
+// Byte-at-a-time decoder, used near the end of the buffer and for values
+// longer than eight bytes
+static size_t varint_decode_slow(const uint8_t *in,
+                                 const uint8_t *end,
+                                 uint64_t *value)
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < VARINT_MAX_BYTES && in + i < end; i++)
     {
-        buffer[0] = value & 0xFF;
-        buffer[1] = (value >> 8) & 0xFF;
+        result |= (uint64_t) (in[i] & 0x7F) << (7 * i);
+        if ((in[i] & 0x80) == 0)
+        {
+            *value = result;
+            return i + 1;
+        }
     }
+    return 0;
 }
 
-// Write a 32-bit value to unaligned memory with specified endianness
-void write_unaligned_32(uint8_t *buffer, uint32_t value, bool big_endian)
+// Read one varint from [in, end); returns the bytes consumed, or 0 if it
+// is truncated or longer than VARINT_MAX_BYTES.
+//
+// With eight bytes available the decoder loads them as one word, finds
+// the terminating byte from the clear high bits, and squeezes out the
+// continuation bits in three shift-and-mask steps, without a loop.
+size_t varint_decode_64(const uint8_t *in, const uint8_t *end, uint64_t *value)
 {
-    if (big_endian)
+    if (in < end && in[0] < 0x80)
     {
-        buffer[0] = (value >> 24) & 0xFF;
-        buffer[1] = (value >> 16) & 0xFF;
-        buffer[2] = (value >> 8) & 0xFF;
-        buffer[3] = value & 0xFF;
+        *value = in[0];  // the common one-byte case
+        return 1;
     }
-    else
+    if (end - in >= 8)
     {
-        buffer[0] = value & 0xFF;
-        buffer[1] = (value >> 8) & 0xFF;
-        buffer[2] = (value >> 16) & 0xFF;
-        buffer[3] = (value >> 24) & 0xFF;
+        uint64_t word = read_unaligned_64(in, false);
+        uint64_t stops = ~word & 0x8080808080808080ull;
+        if (stops != 0)
+        {
+            size_t length = (size_t) (__builtin_ctzll(stops) >> 3) + 1;
+            if (length < 8) word &= (1ull << (length * 8)) - 1;
+
+            // 7 bits per byte -> 14 per 16 -> 28 per 32 -> 56 per 64
+            word = ((word & 0x7F007F007F007F00ull) >> 1)
+                   | (word & 0x007F007F007F007Full);
+            word = ((word & 0x3FFF00003FFF0000ull) >> 2)
+                   | (word & 0x00003FFF00003FFFull);
+            word = ((word & 0x0FFFFFFF00000000ull) >> 4)
+                   | (word & 0x000000000FFFFFFFull);
+            *value = word;
+            return length;
+        }
     }
+    return varint_decode_slow(in, end, value);
+}
+
+// Encode an array of 32-bit values as consecutive varints; out needs room
+// for count * 5 bytes. Returns the bytes written.
+size_t varint_encode_array_32(uint8_t *out,
+                              const uint32_t *values,
+                              size_t count)
+{
+    size_t used = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        used += varint_encode_64(out + used, values[i]);
+    }
+    return used;
+}
+
+// Decode count varints; returns the bytes consumed, or 0 on malformed
+// input or a value above UINT32_MAX
+size_t varint_decode_array_32(uint32_t *values,
+                              const uint8_t *in,
+                              size_t length,
+                              size_t count)
+{
+    const uint8_t *pos = in;
+    const uint8_t *end = in + length;
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t value;
+        size_t used = varint_decode_64(pos, end, &value);
+        if (used == 0 || value > UINT32_MAX) return 0;
+        values[i] = (uint32_t) value;
+        pos += used;
+    }
+    return (size_t) (pos - in);
+}
+
+// out[i] = zigzag(values[i] - values[i - 1]), with values[-1] = 0.
+// out may be the same array as values.
+void delta_encode_32(uint32_t *out, const uint32_t *values, size_t count)
+{
+    uint32_t previous = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t current = values[i];
+        out[i] = zigzag_encode_32((int32_t) (current - previous));
+        previous = current;
+    }
+}
+
+// Inverse of delta_encode_32; values may be the same array as in
+void delta_decode_32(uint32_t *values, const uint32_t *in, size_t count)
+{
+    uint32_t previous = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        previous += (uint32_t) zigzag_decode_32(in[i]);
+        values[i] = previous;
+    }
+}
+
+// Pack up to FOR_BLOCK values; returns the bytes written
+size_t for_pack_block(uint8_t *out, const uint32_t *values, size_t count)
+{
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        min = values[i] < min ? values[i] : min;
+        max = values[i] > max ? values[i] : max;
+    }
+    if (count == 0) min = 0;
+    int width = max == min ? 0 : 32 - __builtin_clz(max - min);
+
+    write_unaligned_32(out, min, false);
+    out[4] = (uint8_t) width;
+    uint8_t *packed = out + FOR_HEADER_SIZE;
+
+    uint64_t pending = 0;
+    int pending_bits = 0;
+    size_t used = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        pending |= (uint64_t) (values[i] - min) << pending_bits;
+        pending_bits += width;
+        while (pending_bits >= 8)
+        {
+            packed[used++] = (uint8_t) pending;
+            pending >>= 8;
+            pending_bits -= 8;
+        }
+    }
+    if (pending_bits > 0) packed[used++] = (uint8_t) pending;
+    return FOR_HEADER_SIZE + used;
+}
+
+// Unpack a block of count values from [in, in + length); returns the
+// bytes consumed, or 0 if the block is malformed or truncated
+size_t for_unpack_block(uint32_t *values,
+                        const uint8_t *in,
+                        size_t length,
+                        size_t count)
+{
+    if (length < FOR_HEADER_SIZE || in[4] > 32) return 0;
+    uint32_t min = read_unaligned_32(in, false);
+    unsigned width = in[4];
+    size_t packed_bytes = (count * width + 7) / 8;
+    if (length - FOR_HEADER_SIZE < packed_bytes) return 0;
+
+    const uint8_t *packed = in + FOR_HEADER_SIZE;
+    uint64_t mask = (1ull << width) - 1;
+    size_t i = 0;
+
+    // A value starts at most 7 bits into a byte and spans at most 39
+    // bits, so one unaligned 64-bit load covers it while 8 bytes remain
+    for (; i < count && (i * width) / 8 + 8 <= packed_bytes; i++)
+    {
+        size_t bit = i * width;
+        uint64_t word = read_unaligned_64(packed + bit / 8, false);
+        values[i] = min + (uint32_t) ((word >> (bit % 8)) & mask);
+    }
+    for (; i < count; i++)
+    {
+        size_t bit = i * width;
+        uint64_t word = 0;
+        for (size_t b = bit / 8; b < packed_bytes && b < bit / 8 + 8; b++)
+        {
+            word |= (uint64_t) packed[b] << (8 * (b - bit / 8));
+        }
+        values[i] = min + (uint32_t) ((word >> (bit % 8)) & mask);
+    }
+    return FOR_HEADER_SIZE + packed_bytes;
+}
+
+// Delta + frame-of-reference coding of a whole column. out needs
+// INT_COLUMN_BOUND(count) bytes. Returns the bytes written.
+size_t int_column_encode(uint8_t *out, const uint32_t *values, size_t count)
+{
+    uint32_t deltas[FOR_BLOCK];
+    uint32_t previous = 0;
+    size_t used = 0;
+    for (size_t first = 0; first < count; first += FOR_BLOCK)
+    {
+        size_t n = count - first < FOR_BLOCK ? count - first : FOR_BLOCK;
+        for (size_t i = 0; i < n; i++)
+        {
+            uint32_t current = values[first + i];
+            deltas[i] = zigzag_encode_32((int32_t) (current - previous));
+            previous = current;
+        }
+        used += for_pack_block(out + used, deltas, n);
+    }
+    return used;
+}
+
+// Decode count values written by int_column_encode; returns the bytes
+// consumed, or 0 on malformed input
+size_t int_column_decode(uint32_t *values,
+                         const uint8_t *in,
+                         size_t length,
+                         size_t count)
+{
+    uint32_t previous = 0;
+    size_t used = 0;
+    for (size_t first = 0; first < count; first += FOR_BLOCK)
+    {
+        size_t n = count - first < FOR_BLOCK ? count - first : FOR_BLOCK;
+        size_t block = for_unpack_block(values + first, in + used,
+                                        length - used, n);
+        if (block == 0) return 0;
+        used += block;
+        for (size_t i = 0; i < n; i++)
+        {
+            previous += (uint32_t) zigzag_decode_32(values[first + i]);
+            values[first + i] = previous;
+        }
+    }
+    return used;
+}
+
+typedef struct
+{
+    const uint32_t *values;
+    uint8_t *wire;
+    size_t count;
+} EncodeBench;
+
+static void bench_encode_scalar(void *arg, uint64_t iterations)
+{
+    EncodeBench *bench = (EncodeBench *) arg;
+    for (uint64_t r = 0; r < iterations; r++)
+    {
+        for (size_t i = 0; i < bench->count; i++)
+        {
+            write_unaligned_32(bench->wire + i * 4, bench->values[i], true);
+        }
+    }
+}
+
+static void bench_encode_bulk(void *arg, uint64_t iterations)
+{
+    EncodeBench *bench = (EncodeBench *) arg;
+    for (uint64_t r = 0; r < iterations; r++)
+    {
+        store_big_endian_32(bench->wire, bench->values, bench->count);
+    }
+}
+
+// Encode a large array both ways, check they agree and round-trip, and
+// time them
+void bulk_conversion_demo(void)
+{
+    printf("\n=== Bulk Conversion ===\n\n");
+
+    // Odd sizes and an offset buffer exercise the tails and unaligned
+    // wire data
+    bool ok = true;
+    uint8_t wire[8 * 37 + 1];
+    uint64_t v64[37];
+    uint64_t back64[37];
+    for (int i = 0; i < 37; i++)
+    {
+        v64[i] = 0x0102030405060708ULL * (uint64_t) (i + 1);
+    }
+    store_big_endian_64(wire + 1, v64, 37);
+    load_big_endian_64(back64, wire + 1, 37);
+    for (int i = 0; i < 37; i++)
+    {
+        ok &= read_unaligned_64(wire + 1 + i * 8, true) == v64[i];
+        ok &= back64[i] == v64[i];
+    }
+
+    uint16_t v16[37];
+    uint16_t back16[37];
+    for (int i = 0; i < 37; i++)
+    {
+        v16[i] = (uint16_t) (0x0102 * (i + 1));
+    }
+    store_big_endian_16(wire + 1, v16, 37);
+    load_big_endian_16(back16, wire + 1, 37);
+    for (int i = 0; i < 37; i++)
+    {
+        ok &= read_unaligned_16(wire + 1 + i * 2, true) == v16[i];
+        ok &= back16[i] == v16[i];
+    }
+    printf("16/64-bit round trip through unaligned wire buffer: %s\n",
+           ok ? "OK" : "MISMATCH");
+
+    size_t count = 1 << 14;  // 64 KB: stays in cache, so this times the swap
+    uint32_t *values = (uint32_t *) malloc(count * sizeof(uint32_t));
+    uint8_t *scalar_wire = (uint8_t *) malloc(count * 4 + 1);
+    uint8_t *bulk_wire = (uint8_t *) malloc(count * 4 + 1);
+    if (values == NULL || scalar_wire == NULL || bulk_wire == NULL)
+    {
+        printf("Out of memory\n");
+        free(values);
+        free(scalar_wire);
+        free(bulk_wire);
+        return;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        values[i] = (uint32_t) (i * 2654435761u);
+    }
+
+    // One iteration encodes the whole array
+    printf("Encode %zu x 32-bit to big-endian (unaligned output):\n", count);
+    CycleBenchConfig config = {"write_unaligned_32 loop", 10, 5, 51, true};
+    EncodeBench bench = {values, scalar_wire + 1, count};
+    CycleBenchResult scalar = cycle_bench(&config, bench_encode_scalar, &bench);
+
+    config.name = "store_big_endian_32";
+    bench.wire = bulk_wire + 1;
+    CycleBenchResult bulk = cycle_bench(&config, bench_encode_bulk, &bench);
+
+    bool same = memcmp(scalar_wire + 1, bulk_wire + 1, count * 4) == 0;
+    printf("Bulk: %.0f MB/s, %.1fx the loop, output %s\n",
+           count * 4 / bulk.median_ns * 1e3,
+           scalar.median_ticks / bulk.median_ticks,
+           same ? "identical" : "MISMATCH");
+
+    free(values);
+    free(scalar_wire);
+    free(bulk_wire);
+}
+
+typedef struct
+{
+    uint32_t *out;
+    const uint8_t *encoded;
+    size_t length;
+    size_t count;
+    size_t consumed;
+} DecodeBench;
+
+static void bench_decode_varint(void *arg, uint64_t iterations)
+{
+    DecodeBench *bench = (DecodeBench *) arg;
+    for (uint64_t r = 0; r < iterations; r++)
+    {
+        bench->consumed = varint_decode_array_32(
+            bench->out, bench->encoded, bench->length, bench->count);
+        delta_decode_32(bench->out, bench->out, bench->count);
+    }
+}
+
+static void bench_decode_for(void *arg, uint64_t iterations)
+{
+    DecodeBench *bench = (DecodeBench *) arg;
+    for (uint64_t r = 0; r < iterations; r++)
+    {
+        bench->consumed = int_column_decode(
+            bench->out, bench->encoded, bench->length, bench->count);
+    }
+}
+
+// Compress an id column and a jittery sensor column with each codec,
+// verify the round trips, and time the decoders
+void integer_codec_demo(void)
+{
+    printf("\n=== Integer Codecs ===\n\n");
+
+    bool ok = true;
+    int32_t signed_samples[] = {0, -1, 1, -2, INT32_MAX, INT32_MIN};
+    for (size_t i = 0; i < sizeof(signed_samples) / sizeof(int32_t); i++)
+    {
+        ok &= zigzag_decode_32(zigzag_encode_32(signed_samples[i]))
+              == signed_samples[i];
+    }
+    ok &= zigzag_decode_64(zigzag_encode_64(INT64_MIN)) == INT64_MIN;
+
+    uint8_t buffer[VARINT_MAX_BYTES * 4];
+    uint64_t samples[] = {0, 127, 128, 300, UINT32_MAX, UINT64_MAX};
+    for (size_t i = 0; i < sizeof(samples) / sizeof(uint64_t); i++)
+    {
+        // Decode once at the end of the buffer (slow path) and once with
+        // slack after it (word path)
+        size_t length = varint_encode_64(buffer, samples[i]);
+        uint64_t tight = 0;
+        uint64_t loose = 0;
+        ok &= varint_decode_64(buffer, buffer + length, &tight) == length;
+        ok &= varint_decode_64(buffer, buffer + sizeof(buffer), &loose)
+              == length;
+        ok &= tight == samples[i] && loose == samples[i];
+    }
+    uint64_t unused;
+    ok &= varint_decode_64(buffer, buffer + 1, &unused) == 0;  // truncated
+    printf("Zigzag and varint edge cases: %s\n", ok ? "OK" : "MISMATCH");
+
+    size_t count = 1 << 20;
+    uint32_t *ids = (uint32_t *) malloc(count * sizeof(uint32_t));
+    uint32_t *readings = (uint32_t *) malloc(count * sizeof(uint32_t));
+    uint32_t *scratch = (uint32_t *) malloc(count * sizeof(uint32_t));
+    uint8_t *encoded = (uint8_t *) malloc(INT_COLUMN_BOUND(count));
+    if (!ids || !readings || !scratch || !encoded)
+    {
+        printf("Out of memory\n");
+        free(ids);
+        free(readings);
+        free(scratch);
+        free(encoded);
+        return;
+    }
+
+    // Ascending ids with gaps, and readings that wander around 20000
+    uint32_t state = 12345;
+    uint32_t id = 100000;
+    uint32_t reading = 20000;
+    for (size_t i = 0; i < count; i++)
+    {
+        state = state * 1103515245u + 12345u;
+        id += 1 + ((state >> 16) & 7);
+        reading += ((state >> 8) & 63) - 31;
+        ids[i] = id;
+        readings[i] = reading;
+    }
+
+    const char *names[2] = {"ids", "readings"};
+    uint32_t *columns[2] = {ids, readings};
+    for (int c = 0; c < 2; c++)
+    {
+        uint32_t *column = columns[c];
+        size_t raw = count * 4;
+
+        // One iteration decodes the whole column
+        CycleBenchConfig config = {"", 1, 1, 9, false};
+        DecodeBench bench = {scratch, encoded, 0, count, 0};
+
+        delta_encode_32(scratch, column, count);
+        size_t varint_bytes = varint_encode_array_32(encoded, scratch, count);
+        bench.length = varint_bytes;
+        CycleBenchResult varint =
+            cycle_bench_run(&config, bench_decode_varint, &bench);
+        bool varint_ok = bench.consumed == varint_bytes
+                         && memcmp(scratch, column, raw) == 0;
+
+        size_t packed_bytes = int_column_encode(encoded, column, count);
+        bench.length = packed_bytes;
+        CycleBenchResult packed =
+            cycle_bench_run(&config, bench_decode_for, &bench);
+        bool packed_ok = bench.consumed == packed_bytes
+                         && memcmp(scratch, column, raw) == 0;
+
+        printf("%-8s raw %7zu KB | delta+varint %6zu KB (%.1fx) %6.0f MB/s"
+               " %s | delta+FOR %6zu KB (%.1fx) %6.0f MB/s %s\n",
+               names[c],
+               raw / 1024,
+               varint_bytes / 1024,
+               (double) raw / varint_bytes,
+               raw / varint.median_ns * 1e3,
+               varint_ok ? "OK" : "MISMATCH",
+               packed_bytes / 1024,
+               (double) raw / packed_bytes,
+               raw / packed.median_ns * 1e3,
+               packed_ok ? "OK" : "MISMATCH");
+    }
+
+    free(ids);
+    free(readings);
+    free(scratch);
+    free(encoded);
 }
 
 int main()
@@ -265,5 +975,8 @@ int main()
     printf("Message ID: 0x%08X\n", recv_message_id);
     printf("Payload: %.4s\n", packet + 6);
 
+    bulk_conversion_demo();
+    integer_codec_demo();
+
     return 0;
 }
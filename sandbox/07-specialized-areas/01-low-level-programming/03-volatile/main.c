@@ -1,10 +1,13 @@
 #include <pthread.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "../device_poll.h"
+
 // Simulated hardware device registers
 typedef struct
 {
@@ -23,6 +26,10 @@ pthread_t hardware_thread;
 // Flag to stop the hardware simulation
 volatile int stop_simulation = 0;
 
+// The device's interrupt line: raised after every register update so
+// waiters can block instead of spinning
+DeviceEvent device_event;
+
 // Simulated hardware thread function
 void* hardware_simulation(void* arg)
 {
@@ -44,27 +51,33 @@ void* hardware_simulation(void* arg)
             device->INTERRUPT = 1;
         }
 
+        device_event_signal(&device_event);
         usleep(100000);  // Sleep for 100ms
     }
 
     return NULL;
 }
 
-// Wait for a specific device status
-void wait_for_status(uint32_t status)
+// Wait for a specific device status; false if timeout_ns passes first
+bool wait_for_status(uint32_t status, uint64_t timeout_ns)
 {
     printf("Waiting for device status %u...\n", status);
 
-    // Non-volatile approach (might be optimized out!)
-    uint32_t current_status = device->STATUS;
-    while (current_status != status)
+    // device_poll re-reads the register through a volatile pointer, so the
+    // loop cannot be optimized away; without volatile a compiler could
+    // hoist the read out of a plain while loop
+    DevicePollPolicy policy = DEVICE_POLL_DEFAULT;
+    policy.timeout_ns = timeout_ns;
+    DevicePollResult result = device_poll_register(
+        &device->STATUS, 0xFFFFFFFF, status, &policy, &device_event, NULL);
+
+    if (result == DEVICE_POLL_TIMEOUT)
     {
-        // This loop might be optimized away by some compilers
-        // without the volatile keyword on the device registers!
-        current_status = device->STATUS;
+        printf("Timed out waiting for status %u\n", status);
+        return false;
     }
-
     printf("Device reached status %u\n", status);
+    return true;
 }
 
 // Poll device until ready (status == 0)
@@ -72,14 +85,101 @@ void wait_for_device_ready()
 {
     printf("Waiting for device to be ready...\n");
 
-    // Since device->STATUS is volatile, this loop won't be optimized out
-    while ((device->STATUS & 0xFF) != 0)
+    // Since device->STATUS is volatile, the poll loop re-reads it every
+    // time; between reads the waiter backs off and then blocks on the
+    // device's event instead of sleeping a fixed 10 ms
+    DevicePollPolicy policy = DEVICE_POLL_DEFAULT;
+    DevicePollStats stats;
+    device_poll_register(
+        &device->STATUS, 0xFF, 0, &policy, &device_event, &stats);
+
+    printf("Device is ready (status 0) after %.1f ms, %llu reads, %.3f ms CPU\n",
+           stats.wait_ns / 1e6,
+           (unsigned long long) stats.reads,
+           stats.cpu_ns / 1e6);
+}
+
+// Raises INTERRUPT once after a delay, remembering when, so the waiter
+// can work out its wake-up latency
+typedef struct
+{
+    unsigned delay_us;
+    bool notify;  // Signal the device event as well
+    uint64_t raised_ns;
+} PulseArgs;
+
+void* pulse_thread(void* arg)
+{
+    PulseArgs* pulse = (PulseArgs*) arg;
+    usleep(pulse->delay_us);
+    pulse->raised_ns = device_poll_clock_ns(CLOCK_MONOTONIC);
+    device->INTERRUPT = 1;
+    if (pulse->notify) device_event_signal(&device_event);
+    return NULL;
+}
+
+static int compare_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*) a;
+    uint64_t y = *(const uint64_t*) b;
+    return (x > y) - (x < y);
+}
+
+// Wake-up latency against CPU burned for a busy loop, sleep backoff and
+// the event-driven wait, each waiting 20 ms for an interrupt
+void polling_cost_demo()
+{
+    printf("\n=== Polling Cost: Latency vs CPU ===\n");
+
+    enum
     {
-        // The compiler knows the value might change between reads
-        usleep(10000);  // Small delay
+        ROUNDS = 15
+    };
+    const char* names[3] = {"busy spin", "backoff (sleeps)", "backoff + event"};
+    DevicePollPolicy busy = DEVICE_POLL_BUSY;
+    DevicePollPolicy backoff = DEVICE_POLL_DEFAULT;
+    const DevicePollPolicy* policies[3] = {&busy, &backoff, &backoff};
+
+    device->CONTROL = 0;  // Keep the simulator off the interrupt register
+    printf("%-18s %14s %14s %10s\n",
+           "policy",
+           "median wake",
+           "worst wake",
+           "CPU used");
+    for (int p = 0; p < 3; p++)
+    {
+        uint64_t latency[ROUNDS];
+        uint64_t cpu = 0;
+        uint64_t wall = 0;
+        for (int r = 0; r < ROUNDS; r++)
+        {
+            device->INTERRUPT = 0;
+            PulseArgs pulse = {20000, p == 2, 0};
+            pthread_t thread;
+            pthread_create(&thread, NULL, pulse_thread, &pulse);
+
+            DevicePollStats stats;
+            device_poll_register(&device->INTERRUPT,
+                                 1,
+                                 1,
+                                 policies[p],
+                                 p == 2 ? &device_event : NULL,
+                                 &stats);
+            uint64_t woke = device_poll_clock_ns(CLOCK_MONOTONIC);
+            pthread_join(thread, NULL);
+
+            latency[r] = woke - pulse.raised_ns;
+            cpu += stats.cpu_ns;
+            wall += stats.wait_ns;
+        }
+        qsort(latency, ROUNDS, sizeof(uint64_t), compare_u64);
+        printf("%-18s %11.1f us %11.1f us %9.1f%%\n",
+               names[p],
+               latency[ROUNDS / 2] / 1e3,
+               latency[ROUNDS - 1] / 1e3,
+               100.0 * cpu / wall);
     }
-
-    printf("Device is ready (status 0)\n");
+    device->INTERRUPT = 0;
 }
 
 // Example of potential optimization issues without volatile
@@ -186,6 +286,12 @@ int main()
     device->DATA = 0;       // Initial data: 0
     device->INTERRUPT = 0;  // No interrupts pending
 
+    if (!device_event_init(&device_event))
+    {
+        perror("device_event_init");
+        return 1;
+    }
+
     // Start the hardware simulation thread
     pthread_create(&hardware_thread, NULL, hardware_simulation, NULL);
 
@@ -204,10 +310,18 @@ int main()
     // Direct manipulation of registers
     direct_register_manipulation();
 
+    // Wait for a status with a deadline
+    printf("\n=== Waiting With a Timeout ===\n");
+    wait_for_status(4, 2000000000ull);
+
+    // What each way of waiting costs
+    polling_cost_demo();
+
     // Clean up
     printf("\n=== Cleaning Up ===\n");
     stop_simulation = 1;
     pthread_join(hardware_thread, NULL);
+    device_event_destroy(&device_event);
     free(device);
 
     return 0;
@@ -1,9 +1,14 @@
+#define _GNU_SOURCE  // CPU pinning in the benchmark harness
 #include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
+#include "../cpu_primitives.h"
+#include "../cycle_bench.h"
+#include "../../../bench/bench_report.h"
+
 // Note: This code uses GCC inline assembly syntax.
 // Different compilers use different syntax for inline assembly.
 
@@ -24,7 +29,13 @@ float fast_sqrt(float number)
 {
     float result;
 
+#if defined(__x86_64__) || defined(__i386__)
     __asm__ volatile("sqrtss %1, %0" : "=x"(result) : "x"(number));
+#elif defined(__aarch64__)
+    __asm__ volatile("fsqrt %s0, %s1" : "=w"(result) : "w"(number));
+#else
+    result = sqrtf(number);
+#endif
 
     return result;
 }
@@ -35,13 +46,25 @@ void basic_assembly_demo()
     printf("=== Basic Inline Assembly ===\n");
 
     // Push value to stack, pop it back, no actual effect
-    __asm__(
+#if defined(__x86_64__)
+    __asm__ volatile(
+        "pushq $42 \n\t"
+        "popq %%rax \n\t" ::: "rax", "memory");
+#elif defined(__i386__)
+    __asm__ volatile(
         "pushl $42 \n\t"
-        "popl %eax \n\t");
+        "popl %%eax \n\t" ::: "eax", "memory");
+#elif defined(__aarch64__)
+    __asm__ volatile("nop");
+#endif
 
     printf("Basic assembly block executed.\n");
 }
 
+// The arithmetic demos below are x86 assembly; other targets get the
+// same results from the portable builtins in cpu_primitives.h
+#if defined(__x86_64__) || defined(__i386__)
+
 // Addition using inline assembly
 int add_with_assembly(int a, int b)
 {
@@ -80,23 +103,49 @@ int multiply_and_add(int a, int b, int c)
 // Demonstrate accessing CPU flags
 int check_carry_flag(int a, int b)
 {
-    int carry;
+    unsigned char carry;  // setc writes a single byte register
 
     __asm__(
         "addl %2, %1 \n\t"  // Add b to a
         "setc %0"           // Set carry to 1 if carry flag is set, 0 otherwise
-        : "=r"(carry)       // Output
-        : "r"(a), "r"(b)    // Inputs
-        : "cc"              // Clobbered
+        : "=q"(carry), "+r"(a)  // Outputs (a is modified by the add)
+        : "r"(b)                // Inputs
+        : "cc"                  // Clobbered
     );
 
     return carry;
 }
 
+#else
+
+int add_with_assembly(int a, int b)
+{
+    int result;
+    cpu_add_overflow(a, b, &result);  // wraps like addl
+    return result;
+}
+
+int multiply_and_add(int a, int b, int c)
+{
+    int product;
+    int result;
+    cpu_mul_overflow(a, b, &product);
+    cpu_add_overflow(product, c, &result);
+    return result;
+}
+
+int check_carry_flag(int a, int b)
+{
+    unsigned sum;
+    return cpu_add_overflow((unsigned) a, (unsigned) b, &sum);
+}
+
+#endif
+
 // Simple memory barrier
 void memory_barrier()
 {
-    __asm__ volatile("" : : : "memory");
+    cpu_compiler_fence();
     // This serves as a compiler barrier, preventing reordering of
     // memory accesses across this point
 }
@@ -104,9 +153,43 @@ void memory_barrier()
 // Full memory barrier
 void full_memory_barrier()
 {
-    __asm__ volatile("mfence" : : : "memory");
-    // Ensures all memory operations before this instruction
-    // complete before any memory operations after it
+    cpu_full_fence();
+    // Ensures all memory operations before this point complete before
+    // any memory operations after it (a locked RMW on x86, dmb on ARM)
+}
+
+typedef struct
+{
+    float input;
+    float output;  // Consumed so the loop is not optimized away
+} SqrtBench;
+
+static void bench_fast_sqrt(void *arg, uint64_t iterations)
+{
+    SqrtBench *bench = (SqrtBench *) arg;
+    float sum = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        sum += fast_sqrt(bench->input + i * 0.01f);
+    }
+    bench->output = sum;
+}
+
+static void bench_sqrtf(void *arg, uint64_t iterations)
+{
+    SqrtBench *bench = (SqrtBench *) arg;
+    float sum = 0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        sum += sqrtf(bench->input + i * 0.01f);
+    }
+    bench->output = sum;
+}
+
+static void bench_empty(void *arg, uint64_t iterations)
+{
+    (void) arg;
+    (void) iterations;
 }
 
 // Measure timing difference between C and assembly implementation of a function
@@ -114,43 +197,115 @@ void benchmark_sqrt()
 {
     printf("\n=== Benchmark: Standard sqrt vs Assembly sqrtss ===\n");
 
-    float test_value = 12345.6789f;
-    int iterations = 10000000;
+    cycle_bench_calibrate();
+    printf("Counter: %.3f ticks/ns, begin/end overhead %llu ticks\n",
+           cycle_bench_clock.ticks_per_ns,
+           (unsigned long long) cycle_bench_clock.overhead);
+
+    SqrtBench bench = {12345.6789f, 0};
+    CycleBenchConfig config = {"",
+                               (uint64_t) bench_param("ITERATIONS", 10000),
+                               5,
+                               (int) bench_param("REPETITIONS", 101),
+                               true};
+
+    config.name = "empty (overhead check)";
+    cycle_bench(&config, bench_empty, &bench);
+
+    config.name = "assembly sqrtss";
+    CycleBenchResult asm_result = cycle_bench(&config, bench_fast_sqrt, &bench);
+    float asm_output = bench.output;
+
+    config.name = "C library sqrtf";
+    CycleBenchResult c_result = cycle_bench(&config, bench_sqrtf, &bench);
+    float c_output = bench.output;
+
+    printf("Sums: %f (asm) vs %f (C)\n", asm_output, c_output);
+    printf("Assembly version was %.2f%% %s\n",
+           100.0 * fabs(asm_result.median_ticks - c_result.median_ticks)
+               / c_result.median_ticks,
+           asm_result.median_ticks < c_result.median_ticks ? "faster"
+                                                           : "slower");
+
+    bench_report(
+        "sqrtss", asm_result.median_ns, "ns/iter", BENCH_LOWER_IS_BETTER);
+    bench_report("sqrtf", c_result.median_ns, "ns/iter", BENCH_LOWER_IS_BETTER);
+}
 
-    // Warm up the cache
-    float dummy = fast_sqrt(test_value);
-    dummy = sqrtf(test_value);
+static void bench_mfence(void *arg, uint64_t iterations)
+{
+    (void) arg;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __asm__ volatile("mfence" ::: "memory");
+#else
+        atomic_thread_fence(memory_order_seq_cst);
+#endif
+    }
+}
 
-    // Test assembly version
-    uint64_t start_asm = get_cpu_ticks();
-    float asm_result = 0;
-    for (int i = 0; i < iterations; i++)
+static void bench_full_fence(void *arg, uint64_t iterations)
+{
+    (void) arg;
+    for (uint64_t i = 0; i < iterations; i++)
     {
-        asm_result = fast_sqrt(test_value + i * 0.01f);
+        cpu_full_fence();
     }
-    uint64_t end_asm = get_cpu_ticks();
+}
 
-    // Test C library version
-    uint64_t start_c = get_cpu_ticks();
-    float c_result = 0;
-    for (int i = 0; i < iterations; i++)
+static void bench_acquire_fence(void *arg, uint64_t iterations)
+{
+    (void) arg;
+    for (uint64_t i = 0; i < iterations; i++)
     {
-        c_result = sqrtf(test_value + i * 0.01f);
+        cpu_acquire_fence();
+        cpu_compiler_fence();  // keep the empty loop
     }
-    uint64_t end_c = get_cpu_ticks();
-
-    printf("Assembly sqrtss result: %f in %llu cycles\n",
-           asm_result,
-           (end_asm - start_asm));
-    printf("C library sqrtf result: %f in %llu cycles\n",
-           c_result,
-           (end_c - start_c));
-    printf(
-        "Assembly version was %.2f%% %s\n",
-        100.0
-            * abs((long long) end_asm - start_asm - (long long) end_c + start_c)
-            / (double) (end_c - start_c),
-        (end_asm - start_asm < end_c - start_c) ? "faster" : "slower");
+}
+
+static void bench_relax(void *arg, uint64_t iterations)
+{
+    (void) arg;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        cpu_relax();
+    }
+}
+
+// Checked arithmetic and the cost of each fence from cpu_primitives.h
+void demo_portable_primitives()
+{
+    printf("\n=== Portable Primitives ===\n");
+
+    int32_t sum;
+    bool overflow = cpu_add_overflow(INT32_MAX, 1, &sum);
+    printf("INT32_MAX + 1: overflow=%d, wrapped=%d, saturated=%d\n",
+           overflow,
+           sum,
+           cpu_add_saturate_i32(INT32_MAX, 1));
+
+    size_t bytes;
+    overflow = cpu_mul_overflow((size_t) 1 << 40, (size_t) 1 << 30, &bytes);
+    printf("2^40 * 2^30 as size_t: overflow=%d\n", overflow);
+
+    // 128-bit add from two 64-bit halves
+    uint64_t low, high;
+    bool carry = cpu_add_carry_u64(UINT64_MAX, 1, false, &low);
+    cpu_add_carry_u64(0, 0, carry, &high);
+    printf("(2^64 - 1) + 1 = 0x%016llx_%016llx\n",
+           (unsigned long long) high,
+           (unsigned long long) low);
+
+    CycleBenchConfig config = {"", 100000, 2, 31, false};
+    config.name = "mfence / seq_cst fence";
+    cycle_bench(&config, bench_mfence, NULL);
+    config.name = "cpu_full_fence";
+    cycle_bench(&config, bench_full_fence, NULL);
+    config.name = "cpu_acquire_fence";
+    cycle_bench(&config, bench_acquire_fence, NULL);
+    config.name = "cpu_relax";
+    cycle_bench(&config, bench_relax, NULL);
 }
 
 // Demonstrate various inline assembly use cases
@@ -158,6 +313,7 @@ void demo_various_assembly()
 {
     printf("\n=== Various Assembly Examples ===\n");
 
+#if defined(__x86_64__) || defined(__i386__)
     // Get CPU ID information
     uint32_t eax, ebx, ecx, edx;
     eax = 1;  // Set CPUID function
@@ -188,6 +344,9 @@ void demo_various_assembly()
     __asm__ volatile("bsrl %1, %0 \n\t" : "=r"(position) : "r"(x));
 
     printf("Most significant bit position in 0x%08X: %u\n", x, position);
+#else
+    printf("CPUID, BSWAP and BSR are x86 instructions; skipped\n");
+#endif
 }
 
 int main()
@@ -222,7 +381,8 @@ int main()
     }
     uint64_t end_ticks = get_cpu_ticks();
 
-    printf("\nCPU ticks elapsed: %llu\n", (end_ticks - start_ticks));
+    printf("\nCPU ticks elapsed: %llu\n",
+           (unsigned long long) (end_ticks - start_ticks));
 
     // Square root using assembly
     float num = 2.0f;
@@ -235,5 +395,7 @@ int main()
     // Show various assembly examples
     demo_various_assembly();
 
+    demo_portable_primitives();
+
     return 0;
 }
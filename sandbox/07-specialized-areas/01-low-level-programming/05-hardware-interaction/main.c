@@ -1,4 +1,6 @@
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,6 +8,9 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "../device_poll.h"
+#include "../../../bench/bench_report.h"
+
 // === Simulated Hardware Device ===
 
 // LED Controller Register Set
@@ -26,6 +31,8 @@ typedef struct
     volatile uint32_t CHANNEL;     // Channel selection
     volatile uint32_t SAMPLERATE;  // Sample rate
     volatile uint32_t INTERRUPT;   // Interrupt control
+    volatile uint32_t SEQUENCE;    // Scan order, 3 bits per channel
+    volatile uint32_t SEQ_LENGTH;  // Channels in the scan (1-8)
 } ADC_Controller;
 
 // Timer Register Set
@@ -39,12 +46,41 @@ typedef struct
     volatile uint32_t INTERRUPT;  // Interrupt control
 } Timer_Controller;
 
+// DMA Channel Register Set (ADC data register -> memory)
+typedef struct
+{
+    volatile uint32_t CONTROL;   // Control register
+    volatile uint32_t STATUS;    // Transfer flags
+    volatile uint32_t COUNT;     // Transfers per cycle through the buffer
+    volatile uint32_t POSITION;  // Index of the next transfer
+    uint16_t* volatile MEMORY;   // Destination buffer
+} DMA_Channel;
+
+// PWM Register Set: one compare per LED channel against a shared counter,
+// plus a DMA request on every update event that reloads all compares
+// from the next frame of a table in memory
+#define PWM_CHANNELS 4
+
+typedef struct
+{
+    volatile uint32_t CONTROL;                // Control register
+    volatile uint32_t STATUS;                 // Status register
+    volatile uint32_t PERIOD;                 // Counter top (full on)
+    volatile uint32_t DUTY[PWM_CHANNELS];     // Compare value per channel
+    volatile uint32_t FRAME_RATE;             // Update events per second
+    volatile uint32_t FRAME_COUNT;            // Frames in the table
+    volatile uint32_t FRAME_POSITION;         // Next frame DMA loads
+    const uint16_t* volatile FRAMES;          // FRAME_COUNT x PWM_CHANNELS
+} PWM_Controller;
+
 // Full Device Memory Map
 typedef struct
 {
     LED_Controller LED;
     ADC_Controller ADC;
     Timer_Controller TIMER;
+    DMA_Channel DMA;
+    PWM_Controller PWM;
     volatile uint32_t GLOBAL_STATUS;   // Global status register
     volatile uint32_t GLOBAL_CONTROL;  // Global control register
 } Device_Registers;
@@ -52,12 +88,48 @@ typedef struct
 // Global device registers (simulating memory-mapped hardware)
 Device_Registers* device;
 
-// Thread for simulating hardware behavior
-pthread_t hardware_thread;
+// A simulator thread, started the first time a driver needs its device
+// rather than up front in main: a run that never touches the DMA or PWM
+// engines never creates their threads, and nothing sleeps waiting for a
+// thread to come up
+typedef struct
+{
+    void* (*run)(void* arg);
+    pthread_t thread;
+    bool started;
+} Simulator;
+
+static pthread_mutex_t simulator_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void simulator_start(Simulator* simulator)
+{
+    pthread_mutex_lock(&simulator_lock);
+    if (!simulator->started)
+    {
+        simulator->started =
+            pthread_create(&simulator->thread, NULL, simulator->run, NULL)
+            == 0;
+    }
+    pthread_mutex_unlock(&simulator_lock);
+}
+
+// Join the thread if it was ever started; stop_simulation must be set
+void simulator_join(Simulator* simulator)
+{
+    if (simulator->started)
+    {
+        pthread_join(simulator->thread, NULL);
+        simulator->started = false;
+    }
+}
 
 // Flag to stop the hardware simulation
 volatile int stop_simulation = 0;
 
+// Raised by the simulator whenever a status register changes, like an
+// interrupt line, so drivers can block instead of polling
+DeviceEvent device_event;
+
 // === Control Bit Definitions ===
 
 // LED Controller
@@ -75,6 +147,8 @@ volatile int stop_simulation = 0;
 #define ADC_CTRL_ENABLE     (1 << 0)  // Enable ADC
 #define ADC_CTRL_START      (1 << 1)  // Start conversion
 #define ADC_CTRL_CONTINUOUS (1 << 2)  // Continuous conversion mode
+#define ADC_CTRL_SCAN       (1 << 3)  // Convert every channel in SEQUENCE
+#define ADC_CTRL_DMA        (1 << 4)  // Hand results to the DMA channel
 #define ADC_CTRL_RESET      (1 << 7)  // Reset controller
 
 // ADC Status
@@ -105,6 +179,27 @@ volatile int stop_simulation = 0;
 #define TIMER_INT_EXPIRED (1 << 1)  // Timer expired interrupt
 #define TIMER_INT_COMPARE (1 << 2)  // Compare match interrupt
 
+// DMA Controller
+#define DMA_CTRL_ENABLE   (1 << 0)  // Enable the channel
+#define DMA_CTRL_CIRCULAR (1 << 1)  // Wrap to the start after COUNT
+#define DMA_CTRL_HTIE     (1 << 2)  // Interrupt at half transfer
+#define DMA_CTRL_TCIE     (1 << 3)  // Interrupt at transfer complete
+
+// DMA Status
+#define DMA_STATUS_HALF   (1 << 0)  // First half of the buffer written
+#define DMA_STATUS_FULL   (1 << 1)  // Second half written
+#define DMA_STATUS_ACTIVE (1 << 2)  // Channel is mid-transfer
+
+// PWM Controller
+#define PWM_CTRL_ENABLE (1 << 0)  // Run the counter, drive the outputs
+#define PWM_CTRL_DMA    (1 << 1)  // Load DUTY from FRAMES on each update
+#define PWM_CTRL_LOOP   (1 << 2)  // Wrap to frame 0 after the last frame
+#define PWM_CTRL_TCIE   (1 << 3)  // Interrupt after the last frame
+
+// PWM Status
+#define PWM_STATUS_DONE   (1 << 0)  // Last frame loaded (not looping)
+#define PWM_STATUS_ACTIVE (1 << 1)  // Engine is mid-update
+
 // Global registers
 #define GLOBAL_STATUS_POWER (1 << 0)  // Power status
 #define GLOBAL_STATUS_ERROR (1 << 1)  // Global error indicator
@@ -121,6 +216,33 @@ void print_binary(uint32_t value, int bits)
     }
 }
 
+// "Analog" value the simulated ADC reads on a channel
+static uint32_t adc_simulate_sample(uint32_t channel)
+{
+    switch (channel & 0x07)
+    {
+    case 0:
+        return rand() % 100;  // Random 0-99
+    case 1:
+        return 512 + (rand() % 100 - 50);  // ~512 ±50
+    case 2:
+        return 1023;  // Full scale
+    case 3:
+        return 0;  // Zero
+    default:
+        return rand() % 1024;  // Full random 0-1023
+    }
+}
+
+// A reset completes on the next simulator tick, which clears the control
+// register; drivers wait for that rather than sleeping a fixed time
+static bool simulate_reset(volatile uint32_t* control, uint32_t reset_bit)
+{
+    if (!(*control & reset_bit)) return false;
+    *control = 0;
+    return true;
+}
+
 // Simulated hardware thread function
 void* hardware_simulation(void* arg)
 {
@@ -136,6 +258,14 @@ void* hardware_simulation(void* arg)
 
     while (!stop_simulation)
     {
+        bool reset = simulate_reset(&device->LED.CONTROL, LED_CTRL_RESET);
+        reset |= simulate_reset(&device->ADC.CONTROL, ADC_CTRL_RESET);
+        reset |= simulate_reset(&device->TIMER.CONTROL, TIMER_CTRL_RESET);
+
+        uint32_t adc_status = device->ADC.STATUS;
+        uint32_t timer_status = device->TIMER.STATUS;
+        uint32_t global_status = device->GLOBAL_STATUS;
+
         // Simulate LED controller
         if (device->LED.CONTROL & LED_CTRL_ENABLE)
         {
@@ -175,25 +305,10 @@ void* hardware_simulation(void* arg)
                 // Complete the conversion
                 device->ADC.STATUS &= ~ADC_STATUS_BUSY;
                 device->ADC.STATUS |= ADC_STATUS_DONE;
+                device_event_signal(&device_event);
 
                 // Generate "analog" data based on channel
-                switch (device->ADC.CHANNEL & 0x07)
-                {
-                case 0:
-                    device->ADC.DATA = rand() % 100;  // Random 0-99
-                    break;
-                case 1:
-                    device->ADC.DATA = 512 + (rand() % 100 - 50);  // ~512 ±50
-                    break;
-                case 2:
-                    device->ADC.DATA = 1023;  // Full scale
-                    break;
-                case 3:
-                    device->ADC.DATA = 0;  // Zero
-                    break;
-                default:
-                    device->ADC.DATA = rand() % 1024;  // Full random 0-1023
-                }
+                device->ADC.DATA = adc_simulate_sample(device->ADC.CHANNEL);
 
                 // Generate interrupt if enabled
                 if (device->ADC.INTERRUPT & ADC_INT_ENABLE
@@ -271,6 +386,13 @@ void* hardware_simulation(void* arg)
                 &= ~(TIMER_STATUS_ENABLED | TIMER_STATUS_RUNNING);
         }
 
+        if (reset || device->ADC.STATUS != adc_status
+            || device->TIMER.STATUS != timer_status
+            || device->GLOBAL_STATUS != global_status)
+        {
+            device_event_signal(&device_event);
+        }
+
         // Short delay to simulate hardware timing
         usleep(20000);
     }
@@ -278,14 +400,195 @@ void* hardware_simulation(void* arg)
     return NULL;
 }
 
+Simulator hardware_simulator = {.run = hardware_simulation};
+
+// Interrupt handler for the DMA channel (defined with the ADC driver)
+void dma_irq_handler(void);
+
+// Simulated ADC scan feeding a circular DMA channel. Every 500 us it
+// converts as many samples as SAMPLERATE says are due, walking the scan
+// sequence and writing each result to MEMORY[POSITION]. Reaching the
+// middle or the end of the buffer sets HALF or FULL and "fires" the DMA
+// interrupt by calling dma_irq_handler on this thread. It is a thread of
+// its own because it converts far faster than the 20 ms register
+// simulation above.
+void* dma_simulation(void* arg)
+{
+    (void) arg;
+    uint64_t started = 0;
+    uint64_t produced = 0;
+    uint32_t scan_index = 0;
+
+    while (!stop_simulation)
+    {
+        // ACTIVE brackets every look at the registers so adc_dma_stop can
+        // wait for the engine to let go of the buffer
+        device->DMA.STATUS |= DMA_STATUS_ACTIVE;
+        cpu_full_fence();
+
+        uint32_t needed = ADC_CTRL_ENABLE | ADC_CTRL_CONTINUOUS | ADC_CTRL_SCAN
+                          | ADC_CTRL_DMA;
+        bool running = (device->ADC.CONTROL & needed) == needed
+                       && (device->DMA.CONTROL & DMA_CTRL_ENABLE)
+                       && device->DMA.COUNT >= 2;
+        if (!running)
+        {
+            started = 0;
+        }
+        else
+        {
+            uint64_t now = device_poll_clock_ns(CLOCK_MONOTONIC);
+            if (started == 0)
+            {
+                started = now;
+                produced = 0;
+                scan_index = 0;
+            }
+            uint64_t due =
+                (now - started) * device->ADC.SAMPLERATE / 1000000000u;
+            uint32_t count = device->DMA.COUNT;
+            uint32_t length = device->ADC.SEQ_LENGTH;
+            uint16_t* memory = device->DMA.MEMORY;
+
+            for (; produced < due; produced++)
+            {
+                uint32_t channel =
+                    (device->ADC.SEQUENCE >> (3 * scan_index)) & 0x07;
+                scan_index = scan_index + 1 < length ? scan_index + 1 : 0;
+
+                uint32_t position = device->DMA.POSITION;
+                memory[position] = (uint16_t) adc_simulate_sample(channel);
+                position++;
+                if (position == count / 2)
+                {
+                    device->DMA.STATUS |= DMA_STATUS_HALF;
+                    if (device->DMA.CONTROL & DMA_CTRL_HTIE) dma_irq_handler();
+                }
+                if (position == count)
+                {
+                    position = 0;
+                    device->DMA.STATUS |= DMA_STATUS_FULL;
+                    if (device->DMA.CONTROL & DMA_CTRL_TCIE) dma_irq_handler();
+                    if (!(device->DMA.CONTROL & DMA_CTRL_CIRCULAR))
+                    {
+                        device->DMA.CONTROL &= ~DMA_CTRL_ENABLE;
+                        device->DMA.POSITION = position;
+                        break;
+                    }
+                }
+                device->DMA.POSITION = position;
+            }
+        }
+
+        device->DMA.STATUS &= ~DMA_STATUS_ACTIVE;
+        usleep(500);
+    }
+
+    return NULL;
+}
+
+Simulator dma_simulator = {.run = dma_simulation};
+
+// Interrupt handler for the PWM engine (defined with the pattern driver)
+void pwm_irq_handler(void);
+
+// Simulated PWM timer with DMA: FRAME_RATE times per second an update
+// event copies the next frame of the table into the DUTY registers, with
+// no CPU involved, and after the last frame either wraps or stops and
+// raises the PWM interrupt
+void* pwm_simulation(void* arg)
+{
+    (void) arg;
+    uint64_t started = 0;
+    uint64_t loaded = 0;
+
+    while (!stop_simulation)
+    {
+        device->PWM.STATUS |= PWM_STATUS_ACTIVE;
+        cpu_full_fence();
+
+        uint32_t needed = PWM_CTRL_ENABLE | PWM_CTRL_DMA;
+        bool running = (device->PWM.CONTROL & needed) == needed
+                       && device->PWM.FRAME_COUNT > 0
+                       && device->PWM.FRAME_RATE > 0;
+        if (!running)
+        {
+            started = 0;
+        }
+        else
+        {
+            uint64_t now = device_poll_clock_ns(CLOCK_MONOTONIC);
+            if (started == 0)
+            {
+                started = now;
+                loaded = 0;
+            }
+            uint64_t due =
+                (now - started) * device->PWM.FRAME_RATE / 1000000000u + 1;
+            const uint16_t* frames = device->PWM.FRAMES;
+
+            for (; loaded < due; loaded++)
+            {
+                uint32_t position = device->PWM.FRAME_POSITION;
+                for (int c = 0; c < PWM_CHANNELS; c++)
+                {
+                    device->PWM.DUTY[c] = frames[position * PWM_CHANNELS + c];
+                }
+                position++;
+                if (position == device->PWM.FRAME_COUNT)
+                {
+                    position = 0;
+                    if (!(device->PWM.CONTROL & PWM_CTRL_LOOP))
+                    {
+                        device->PWM.CONTROL &= ~PWM_CTRL_DMA;
+                        device->PWM.FRAME_POSITION = position;
+                        device->PWM.STATUS |= PWM_STATUS_DONE;
+                        if (device->PWM.CONTROL & PWM_CTRL_TCIE)
+                        {
+                            pwm_irq_handler();
+                        }
+                        break;
+                    }
+                }
+                device->PWM.FRAME_POSITION = position;
+            }
+        }
+
+        device->PWM.STATUS &= ~PWM_STATUS_ACTIVE;
+        usleep(1000);
+    }
+
+    return NULL;
+}
+
+Simulator pwm_simulator = {.run = pwm_simulation};
+
+// --- Controller Reset ---
+
+// Start the register simulator on first use, then reset one controller
+// and wait until the device acknowledges it by clearing the reset bit
+bool controller_reset(volatile uint32_t* control, uint32_t reset_bit)
+{
+    simulator_start(&hardware_simulator);
+    *control = reset_bit;
+
+    DevicePollPolicy policy = DEVICE_POLL_DEFAULT;
+    policy.timeout_ns = 1000000000;  // 1 s
+    return device_poll_register(
+               control, reset_bit, 0, &policy, &device_event, NULL)
+           == DEVICE_POLL_OK;
+}
+
 // --- LED Controller Functions ---
 
 // Initialize the LED controller
 void led_init()
 {
     // Reset the controller
-    device->LED.CONTROL = LED_CTRL_RESET;
-    usleep(50000);  // Wait for reset to complete
+    if (!controller_reset(&device->LED.CONTROL, LED_CTRL_RESET))
+    {
+        printf("LED controller reset timed out\n");
+    }
 
     // Configure LED controller
     device->LED.CONTROL = 0;
@@ -321,14 +624,140 @@ void led_set_blink(int enable)
     printf("LED blinking %s\n", enable ? "enabled" : "disabled");
 }
 
+// --- LED Pattern Engine ---
+
+// Animations are turned into a table of PWM frames up front and the PWM
+// DMA plays them, so nothing runs on the CPU while an LED fades. A
+// pattern is a list of keyframes; the builder interpolates between them
+// in perceived brightness and maps each step through a lightness curve,
+// because LED output is linear in duty but the eye is not (a linear fade
+// looks like it jumps at the bottom and stalls at the top).
+
+#define PWM_PERIOD 4095  // 12-bit duty
+
+typedef struct
+{
+    uint8_t level[PWM_CHANNELS];  // Perceived brightness, 0-255
+    uint16_t frames;              // Frames to fade here from the last key
+} LedKeyframe;
+
+static uint16_t led_lightness[256];  // Perceived level -> duty
+
+// CIE 1931 lightness: relative luminance for L* = level / 2.55
+static void led_lightness_init(void)
+{
+    for (int level = 0; level < 256; level++)
+    {
+        double l = level * 100.0 / 255.0;
+        double y = l <= 8.0 ? l / 903.3 : ((l + 16.0) / 116.0)
+                                              * ((l + 16.0) / 116.0)
+                                              * ((l + 16.0) / 116.0);
+        led_lightness[level] = (uint16_t) (y * PWM_PERIOD + 0.5);
+    }
+}
+
+// Expand keyframes into frames[capacity][PWM_CHANNELS] duty values.
+// Fades start from the last keyframe, so a looping table joins up
+// seamlessly. Returns the number of frames, or 0 if they do not fit.
+uint32_t led_pattern_build(uint16_t* frames,
+                           uint32_t capacity,
+                           const LedKeyframe* keys,
+                           uint32_t key_count)
+{
+    uint32_t total = 0;
+    for (uint32_t k = 0; k < key_count; k++) total += keys[k].frames;
+    if (key_count == 0 || total == 0 || total > capacity) return 0;
+
+    if (led_lightness[255] == 0) led_lightness_init();
+
+    uint16_t* out = frames;
+    const LedKeyframe* from = &keys[key_count - 1];
+    for (uint32_t k = 0; k < key_count; k++)
+    {
+        const LedKeyframe* to = &keys[k];
+        for (uint32_t f = 1; f <= to->frames; f++)
+        {
+            for (int c = 0; c < PWM_CHANNELS; c++)
+            {
+                int32_t a = from->level[c];
+                int32_t b = to->level[c];
+                int32_t level = a + (b - a) * (int32_t) f / to->frames;
+                *out++ = led_lightness[level];
+            }
+        }
+        from = to;
+    }
+    return total;
+}
+
+static atomic_bool led_pattern_finished;
+
+// PWM interrupt: the last frame of a one-shot pattern is out
+void pwm_irq_handler(void)
+{
+    device->PWM.STATUS &= ~PWM_STATUS_DONE;
+    atomic_store(&led_pattern_finished, true);
+    device_event_signal(&device_event);
+}
+
+// Start playing frame_count frames at frame_rate per second; with loop
+// the table repeats until led_pattern_stop. The table is read by DMA
+// while the pattern plays and must stay valid until it has stopped.
+void led_pattern_play(const uint16_t* frames,
+                      uint32_t frame_count,
+                      uint32_t frame_rate,
+                      bool loop)
+{
+    device->PWM.CONTROL = 0;
+    atomic_store(&led_pattern_finished, false);
+    device->PWM.STATUS &= ~PWM_STATUS_DONE;
+    device->PWM.PERIOD = PWM_PERIOD;
+    device->PWM.FRAMES = frames;
+    device->PWM.FRAME_COUNT = frame_count;
+    device->PWM.FRAME_POSITION = 0;
+    device->PWM.FRAME_RATE = frame_rate;
+    device->PWM.CONTROL = PWM_CTRL_ENABLE | PWM_CTRL_DMA | PWM_CTRL_TCIE
+                          | (loop ? PWM_CTRL_LOOP : 0);
+    simulator_start(&pwm_simulator);
+}
+
+static bool led_pattern_done(void* arg)
+{
+    (void) arg;
+    return atomic_load(&led_pattern_finished);
+}
+
+// Block until a one-shot pattern has played; false after timeout_ns
+bool led_pattern_wait(uint64_t timeout_ns)
+{
+    DevicePollPolicy policy = DEVICE_POLL_DEFAULT;
+    policy.timeout_ns = timeout_ns;
+    return device_poll(led_pattern_done, NULL, &policy, &device_event, NULL)
+           == DEVICE_POLL_OK;
+}
+
+// Stop the pattern, leaving the outputs at their current duty; when this
+// returns DMA no longer reads the table
+void led_pattern_stop(void)
+{
+    device->PWM.CONTROL &= ~(PWM_CTRL_DMA | PWM_CTRL_LOOP);
+    cpu_full_fence();
+
+    DevicePollPolicy policy = DEVICE_POLL_DEFAULT;
+    device_poll_register(
+        &device->PWM.STATUS, PWM_STATUS_ACTIVE, 0, &policy, NULL, NULL);
+}
+
 // --- ADC Functions ---
 
 // Initialize the ADC
 void adc_init()
 {
     // Reset the ADC
-    device->ADC.CONTROL = ADC_CTRL_RESET;
-    usleep(50000);  // Wait for reset to complete
+    if (!controller_reset(&device->ADC.CONTROL, ADC_CTRL_RESET))
+    {
+        printf("ADC reset timed out\n");
+    }
 
     // Configure ADC
     device->ADC.CONTROL = 0;
@@ -351,10 +780,20 @@ uint32_t adc_read(uint32_t channel)
     // Start conversion
     device->ADC.CONTROL |= ADC_CTRL_START;
 
-    // Wait for conversion to complete
-    while (!(device->ADC.STATUS & ADC_STATUS_DONE))
+    // Wait for conversion to complete; the simulator raises the device
+    // event when DONE is set, so this blocks rather than polling
+    DevicePollPolicy policy = DEVICE_POLL_DEFAULT;
+    policy.timeout_ns = 1000000000;  // 1 s
+    if (device_poll_register(&device->ADC.STATUS,
+                             ADC_STATUS_DONE,
+                             ADC_STATUS_DONE,
+                             &policy,
+                             &device_event,
+                             NULL)
+        == DEVICE_POLL_TIMEOUT)
     {
-        usleep(1000);
+        printf("ADC channel %u timed out\n", channel);
+        return 0;
     }
 
     // Read and return the result
@@ -364,14 +803,188 @@ uint32_t adc_read(uint32_t channel)
     return result;
 }
 
+// --- Continuous ADC Sampling (scan + DMA) ---
+//
+// Instead of one conversion per adc_read call, the ADC scans a channel
+// sequence continuously and DMA writes every result into a buffer split
+// into two halves. While DMA fills one half the application processes
+// the other: the half-transfer interrupt hands over the first half, the
+// transfer-complete interrupt the second. Results are interleaved in scan
+// order, and each half holds a whole number of scans.
+
+typedef void (*AdcBlockCallback)(const uint16_t* block,
+                                 uint32_t count,
+                                 void* context);
+
+typedef struct
+{
+    const uint8_t* channels;  // Scan order, up to 8 channels
+    uint32_t channel_count;
+    uint32_t sample_rate;   // Conversions per second, all channels together
+    uint16_t* buffer;       // 2 * half_length samples
+    uint32_t half_length;   // Multiple of channel_count
+    AdcBlockCallback on_half;  // Called from the DMA interrupt; optional
+    AdcBlockCallback on_full;
+    void* context;
+} AdcScanConfig;
+
+typedef struct
+{
+    AdcScanConfig config;
+    atomic_uint_fast64_t completed;  // Halves DMA has finished
+    uint64_t consumed;               // Halves returned by adc_dma_read_block
+    uint64_t overruns;               // Halves lost because the reader lagged
+} AdcDmaStream;
+
+static AdcDmaStream* active_dma_stream;
+
+// DMA interrupt: acknowledge the flags, pass the finished half to the
+// callbacks and wake any reader
+void dma_irq_handler(void)
+{
+    AdcDmaStream* stream = active_dma_stream;
+    uint32_t status = device->DMA.STATUS;
+    device->DMA.STATUS &= ~(DMA_STATUS_HALF | DMA_STATUS_FULL);
+    if (stream == NULL) return;
+
+    const AdcScanConfig* config = &stream->config;
+    if (status & DMA_STATUS_HALF)
+    {
+        if (config->on_half)
+        {
+            config->on_half(config->buffer, config->half_length, config->context);
+        }
+        atomic_fetch_add(&stream->completed, 1);
+    }
+    if (status & DMA_STATUS_FULL)
+    {
+        if (config->on_full)
+        {
+            config->on_full(config->buffer + config->half_length,
+                            config->half_length,
+                            config->context);
+        }
+        atomic_fetch_add(&stream->completed, 1);
+    }
+    device_event_signal(&device_event);
+}
+
+// Start continuous sampling; false if the configuration is invalid
+bool adc_dma_start(AdcDmaStream* stream, const AdcScanConfig* config)
+{
+    if (config->channel_count == 0 || config->channel_count > 8
+        || config->half_length == 0
+        || config->half_length % config->channel_count != 0
+        || config->sample_rate == 0)
+    {
+        return false;
+    }
+
+    stream->config = *config;
+    atomic_store(&stream->completed, 0);
+    stream->consumed = 0;
+    stream->overruns = 0;
+    active_dma_stream = stream;
+
+    uint32_t sequence = 0;
+    for (uint32_t i = 0; i < config->channel_count; i++)
+    {
+        sequence |= (uint32_t) (config->channels[i] & 0x07) << (3 * i);
+    }
+
+    // Program DMA before the ADC so no conversion finds it unarmed
+    device->DMA.CONTROL = 0;
+    device->DMA.STATUS &= ~(DMA_STATUS_HALF | DMA_STATUS_FULL);
+    device->DMA.MEMORY = config->buffer;
+    device->DMA.COUNT = 2 * config->half_length;
+    device->DMA.POSITION = 0;
+    device->DMA.CONTROL =
+        DMA_CTRL_ENABLE | DMA_CTRL_CIRCULAR | DMA_CTRL_HTIE | DMA_CTRL_TCIE;
+
+    device->ADC.SEQUENCE = sequence;
+    device->ADC.SEQ_LENGTH = config->channel_count;
+    device->ADC.SAMPLERATE = config->sample_rate;
+    device->ADC.CONTROL = ADC_CTRL_ENABLE | ADC_CTRL_CONTINUOUS | ADC_CTRL_SCAN
+                          | ADC_CTRL_DMA;
+    simulator_start(&dma_simulator);
+    return true;
+}
+
+static bool adc_dma_block_ready(void* arg)
+{
+    AdcDmaStream* stream = (AdcDmaStream*) arg;
+    return atomic_load(&stream->completed) > stream->consumed;
+}
+
+// Copy the oldest unread half into out (half_length samples) and return
+// its sample count, or 0 if none completes within timeout_ns. A reader
+// that falls more than a half behind skips to the newest complete half;
+// the halves DMA overwrote in the meantime are counted in overruns.
+uint32_t adc_dma_read_block(AdcDmaStream* stream,
+                            uint16_t* out,
+                            uint64_t timeout_ns)
+{
+    const AdcScanConfig* config = &stream->config;
+    DevicePollPolicy policy = DEVICE_POLL_DEFAULT;
+    policy.timeout_ns = timeout_ns;
+
+    for (;;)
+    {
+        if (device_poll(
+                adc_dma_block_ready, stream, &policy, &device_event, NULL)
+            == DEVICE_POLL_TIMEOUT)
+        {
+            return 0;
+        }
+
+        uint64_t completed = atomic_load(&stream->completed);
+        if (completed - stream->consumed > 1)
+        {
+            stream->overruns += completed - 1 - stream->consumed;
+            stream->consumed = completed - 1;
+        }
+
+        uint64_t half = stream->consumed;
+        memcpy(out,
+               config->buffer + (half % 2) * config->half_length,
+               config->half_length * sizeof(uint16_t));
+
+        // Once DMA finishes the next half it starts rewriting this one,
+        // so the copy may be torn; drop it and take a newer half
+        if (atomic_load(&stream->completed) >= half + 2)
+        {
+            stream->overruns++;
+            stream->consumed = half + 1;
+            continue;
+        }
+        stream->consumed = half + 1;
+        return config->half_length;
+    }
+}
+
+// Stop sampling; when this returns DMA no longer touches the buffer
+void adc_dma_stop(AdcDmaStream* stream)
+{
+    device->ADC.CONTROL = ADC_CTRL_ENABLE;
+    device->DMA.CONTROL = 0;
+    cpu_full_fence();
+
+    DevicePollPolicy policy = DEVICE_POLL_DEFAULT;
+    device_poll_register(
+        &device->DMA.STATUS, DMA_STATUS_ACTIVE, 0, &policy, NULL, NULL);
+    if (active_dma_stream == stream) active_dma_stream = NULL;
+}
+
 // --- Timer Functions ---
 
 // Initialize the timer
 void timer_init()
 {
     // Reset the timer
-    device->TIMER.CONTROL = TIMER_CTRL_RESET;
-    usleep(50000);  // Wait for reset to complete
+    if (!controller_reset(&device->TIMER.CONTROL, TIMER_CTRL_RESET))
+    {
+        printf("Timer reset timed out\n");
+    }
 
     // Configure timer
     device->TIMER.CONTROL = 0;
@@ -402,22 +1015,40 @@ void timer_start(int mode)
            device->TIMER.STATUS);
 }
 
-// Wait for timer to expire
-void timer_wait_expire()
+// Wait for timer to expire; returns 0 on expiry, -1 after timeout_ns
+// (0 waits forever)
+int timer_wait_expire(uint64_t timeout_ns)
 {
     printf("Waiting for timer to expire...\n");
 
-    while (!(device->TIMER.STATUS & TIMER_STATUS_EXPIRED))
+    // Block on the device event between status checks, printing the
+    // counter about every 100 ms as before
+    DevicePollPolicy policy = DEVICE_POLL_DEFAULT;
+    policy.timeout_ns = 100000000;
+    uint64_t start = device_poll_clock_ns(CLOCK_MONOTONIC);
+    while (device_poll_register(&device->TIMER.STATUS,
+                                TIMER_STATUS_EXPIRED,
+                                TIMER_STATUS_EXPIRED,
+                                &policy,
+                                &device_event,
+                                NULL)
+           == DEVICE_POLL_TIMEOUT)
     {
         printf("Timer Counter: %u\r", device->TIMER.COUNTER);
         fflush(stdout);
-        usleep(100000);
+        if (timeout_ns
+            && device_poll_clock_ns(CLOCK_MONOTONIC) - start >= timeout_ns)
+        {
+            printf("\nTimer did not expire in time\n");
+            return -1;
+        }
     }
 
     printf("\nTimer expired! Status: 0x%08X\n", device->TIMER.STATUS);
 
     // Clear expired flag
     device->TIMER.STATUS &= ~TIMER_STATUS_EXPIRED;
+    return 0;
 }
 
 // --- Global Device Control ---
@@ -483,6 +1114,7 @@ void run_demo()
     led_init();
     adc_init();
     timer_init();
+    bench_ready();
 
     // Set up interrupts
     printf("Enabling ADC and Timer interrupts\n");
@@ -539,6 +1171,145 @@ void run_demo()
     printf("Demo completed\n");
 }
 
+typedef struct
+{
+    uint64_t half_callbacks;
+    uint64_t full_callbacks;
+} DmaCallbackCounts;
+
+static void count_half(const uint16_t* block, uint32_t count, void* context)
+{
+    (void) block;
+    (void) count;
+    ((DmaCallbackCounts*) context)->half_callbacks++;
+}
+
+static void count_full(const uint16_t* block, uint32_t count, void* context)
+{
+    (void) block;
+    (void) count;
+    ((DmaCallbackCounts*) context)->full_callbacks++;
+}
+
+#define ADC_DMA_HALF 1000  // Samples per half: 10 ms at 100 kS/s
+
+// Sample four channels at 100 kS/s for a second and consume the result
+// block by block
+void run_dma_demo()
+{
+    printf("\n=== Continuous ADC Sampling (scan + DMA) ===\n");
+
+    static uint16_t dma_buffer[2 * ADC_DMA_HALF];
+    static uint16_t block[ADC_DMA_HALF];
+    uint8_t channels[4] = {0, 1, 2, 3};
+    DmaCallbackCounts counts = {0, 0};
+    AdcScanConfig config = {channels,
+                            4,
+                            100000,
+                            dma_buffer,
+                            ADC_DMA_HALF,
+                            count_half,
+                            count_full,
+                            &counts};
+
+    AdcDmaStream stream;
+    if (!adc_dma_start(&stream, &config))
+    {
+        printf("Invalid scan configuration\n");
+        return;
+    }
+
+    uint64_t sums[4] = {0, 0, 0, 0};
+    uint64_t samples = 0;
+    uint64_t start = device_poll_clock_ns(CLOCK_MONOTONIC);
+    while (device_poll_clock_ns(CLOCK_MONOTONIC) - start < 1000000000u)
+    {
+        uint32_t n = adc_dma_read_block(&stream, block, 100000000u);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            sums[i % 4] += block[i];
+        }
+        samples += n;
+    }
+    double seconds = (device_poll_clock_ns(CLOCK_MONOTONIC) - start) / 1e9;
+    adc_dma_stop(&stream);
+
+    printf("Consumed %llu samples in %.2f s (%.1f kS/s), %llu halves lost\n",
+           (unsigned long long) samples,
+           seconds,
+           samples / seconds / 1e3,
+           (unsigned long long) stream.overruns);
+    printf("Callbacks: %llu half-transfer, %llu transfer-complete\n",
+           (unsigned long long) counts.half_callbacks,
+           (unsigned long long) counts.full_callbacks);
+    for (int c = 0; c < 4; c++)
+    {
+        printf("  channel %u mean: %.1f\n",
+               channels[c],
+               samples ? sums[c] / (samples / 4.0) : 0.0);
+    }
+}
+
+static uint64_t thread_cpu_ns(void)
+{
+    return device_poll_clock_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+// Breathe four LEDs out of phase for two seconds from a precomputed
+// table, then play a one-shot fade-out, with the main thread asleep
+void run_pattern_demo()
+{
+    printf("\n=== LED Pattern Engine (PWM + DMA) ===\n");
+
+    static uint16_t frames[256 * PWM_CHANNELS];
+    const LedKeyframe breathe[] = {
+        {{255, 128, 0, 128}, 25},
+        {{128, 255, 128, 0}, 25},
+        {{0, 128, 255, 128}, 25},
+        {{128, 0, 128, 255}, 25},
+    };
+    const LedKeyframe fade_out[] = {
+        {{255, 255, 255, 255}, 1},
+        {{0, 0, 0, 0}, 50},
+    };
+
+    uint32_t count = led_pattern_build(frames, 256, breathe, 4);
+    printf("Breathing table: %u frames, lightness-corrected duty "
+           "(level 128 -> %u of %u)\n",
+           count,
+           led_lightness[128],
+           PWM_PERIOD);
+
+    uint64_t cpu_start = thread_cpu_ns();
+    led_pattern_play(frames, count, 100, true);
+    for (int i = 0; i < 4; i++)
+    {
+        usleep(500000);
+        printf("  t=%.1fs duty: %4u %4u %4u %4u\n",
+               (i + 1) * 0.5,
+               device->PWM.DUTY[0],
+               device->PWM.DUTY[1],
+               device->PWM.DUTY[2],
+               device->PWM.DUTY[3]);
+    }
+    led_pattern_stop();
+
+    count = led_pattern_build(frames, 256, fade_out, 2);
+    led_pattern_play(frames, count, 100, false);
+    bool finished = led_pattern_wait(2000000000u);
+    uint64_t cpu_used = thread_cpu_ns() - cpu_start;
+
+    printf("Fade-out %s; duty now %u %u %u %u\n",
+           finished ? "completed" : "timed out",
+           device->PWM.DUTY[0],
+           device->PWM.DUTY[1],
+           device->PWM.DUTY[2],
+           device->PWM.DUTY[3]);
+    printf("Main thread CPU during 2.5 s of animation: %.2f ms\n",
+           cpu_used / 1e6);
+    device->PWM.CONTROL = 0;
+}
+
 int main()
 {
     printf("==== HARDWARE INTERACTION DEMONSTRATION ====\n");
@@ -550,19 +1321,27 @@ int main()
     device = (Device_Registers*) malloc(sizeof(Device_Registers));
     memset(device, 0, sizeof(Device_Registers));
 
-    // Start the hardware simulation thread
-    pthread_create(&hardware_thread, NULL, hardware_simulation, NULL);
+    if (!device_event_init(&device_event))
+    {
+        perror("device_event_init");
+        return 1;
+    }
 
-    // Wait a moment for the simulation to start
-    usleep(100000);
+    // The simulation threads start with the first driver call that needs
+    // them, and the drivers wait for the device rather than a fixed delay
 
     // Run the demo
     run_demo();
+    run_dma_demo();
+    run_pattern_demo();
 
     // Clean up
     printf("Cleaning up resources\n");
     stop_simulation = 1;
-    pthread_join(hardware_thread, NULL);
+    simulator_join(&hardware_simulator);
+    simulator_join(&dma_simulator);
+    simulator_join(&pwm_simulator);
+    device_event_destroy(&device_event);
     free(device);
 
     return 0;
@@ -0,0 +1,117 @@
+// Portable CPU primitives: fences, spin-wait hints and checked arithmetic.
+//
+// Each primitive picks the lightest instruction that is still correct on
+// x86-64 and AArch64 and falls back to the C11 builtins elsewhere:
+//
+//   primitive            x86-64                 AArch64
+//   cpu_compiler_fence   (none)                 (none)
+//   cpu_acquire_fence    (none, TSO)            dmb ishld
+//   cpu_release_fence    (none, TSO)            dmb ish
+//   cpu_full_fence       lock or to the stack   dmb ish
+//   cpu_store_fence      sfence                 dmb ishst
+//   cpu_relax            pause                  isb
+//
+// x86 only reorders a store with a later load, so acquire and release
+// need nothing beyond stopping the compiler, and a full fence can use a
+// locked RMW on a stack line that is already in cache, which is about
+// twice as fast as mfence (what older compilers emit for a seq_cst
+// fence). cpu_store_fence is only needed to order non-temporal
+// stores. On AArch64, isb stalls for roughly as long as x86's pause;
+// "yield" is a no-op on most cores (Graviton included), so a spin loop
+// built on it hammers the contended line.
+#ifndef CPU_PRIMITIVES_H
+#define CPU_PRIMITIVES_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Stop the compiler moving memory accesses across this point; emits no
+// instruction
+static inline void cpu_compiler_fence(void)
+{
+    atomic_signal_fence(memory_order_seq_cst);
+}
+
+// Later loads and stores stay after earlier loads
+static inline void cpu_acquire_fence(void)
+{
+    atomic_thread_fence(memory_order_acquire);
+}
+
+// Earlier loads and stores stay before later stores
+static inline void cpu_release_fence(void)
+{
+    atomic_thread_fence(memory_order_release);
+}
+
+// Nothing is reordered across this point, store-load included
+static inline void cpu_full_fence(void)
+{
+#if defined(__x86_64__)
+    __asm__ volatile("lock orq $0, (%%rsp)" ::: "memory", "cc");
+#elif defined(__i386__)
+    __asm__ volatile("lock orl $0, (%%esp)" ::: "memory", "cc");
+#elif defined(__aarch64__)
+    __asm__ volatile("dmb ish" ::: "memory");
+#else
+    atomic_thread_fence(memory_order_seq_cst);
+#endif
+}
+
+// Earlier stores, non-temporal ones included, become visible before later
+// stores
+static inline void cpu_store_fence(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ volatile("sfence" ::: "memory");
+#elif defined(__aarch64__)
+    __asm__ volatile("dmb ishst" ::: "memory");
+#else
+    atomic_thread_fence(memory_order_release);
+#endif
+}
+
+// Tell the core a spin-wait is in progress
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("isb" ::: "memory");
+#elif defined(__arm__)
+    __asm__ volatile("yield" ::: "memory");
+#else
+    cpu_compiler_fence();
+#endif
+}
+
+// Checked arithmetic: store the wrapped result and return true if the
+// mathematical result did not fit. Any integer types may be mixed, like
+// C23's ckd_add/ckd_sub/ckd_mul, and the builtins compile to the
+// operation plus a branch on the overflow or carry flag.
+#define cpu_add_overflow(a, b, result) __builtin_add_overflow(a, b, result)
+#define cpu_sub_overflow(a, b, result) __builtin_sub_overflow(a, b, result)
+#define cpu_mul_overflow(a, b, result) __builtin_mul_overflow(a, b, result)
+
+// a + b + carry_in for multi-word arithmetic; returns the carry out
+static inline bool cpu_add_carry_u64(uint64_t a,
+                                     uint64_t b,
+                                     bool carry_in,
+                                     uint64_t* sum)
+{
+    uint64_t partial;
+    bool carry = __builtin_add_overflow(a, b, &partial);
+    carry |= __builtin_add_overflow(partial, (uint64_t) carry_in, sum);
+    return carry;
+}
+
+// a + b, clamped to the int32_t range instead of wrapping
+static inline int32_t cpu_add_saturate_i32(int32_t a, int32_t b)
+{
+    int32_t sum;
+    if (!__builtin_add_overflow(a, b, &sum)) return sum;
+    return b > 0 ? INT32_MAX : INT32_MIN;
+}
+
+#endif  // CPU_PRIMITIVES_H
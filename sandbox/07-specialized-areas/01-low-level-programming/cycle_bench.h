@@ -0,0 +1,325 @@
+// Cycle-level microbenchmark harness shared by the low-level demos.
+//
+// cycle_bench_run() times a callback with the CPU's own counter: rdtsc
+// fenced with lfence/rdtscp on x86, cntvct_el0 behind isb on AArch64 and
+// CLOCK_MONOTONIC anywhere else. The first run calibrates the counter
+// against the monotonic clock and measures the cost of an empty
+// begin/end pair, which is subtracted from every sample. Each benchmark
+// is pinned to the CPU it starts on (when _GNU_SOURCE is defined before
+// this header), warmed up, repeated, and summarised as median and median
+// absolute deviation, which unlike mean and stddev ignore the odd
+// interrupt or migration. With use_perf set, cycles, instructions, cache
+// misses and branch misses are read from perf_event for the whole run;
+// where the kernel refuses, the report just leaves them out.
+#ifndef CYCLE_BENCH_H
+#define CYCLE_BENCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define CYCLE_BENCH_PERF 1
+#endif
+
+#define CYCLE_BENCH_MAX_REPS 1024
+#define CYCLE_BENCH_COUNTERS 4
+
+typedef enum
+{
+    CB_COUNTER_CYCLES,
+    CB_COUNTER_INSTRUCTIONS,
+    CB_COUNTER_CACHE_MISSES,
+    CB_COUNTER_BRANCH_MISSES
+} CycleBenchCounter;
+
+// Runs the code under test `iterations` times
+typedef void (*CycleBenchFn)(void* arg, uint64_t iterations);
+
+typedef struct
+{
+    const char* name;
+    uint64_t iterations;  // Per repetition; the result is per iteration
+    int warmups;
+    int repetitions;  // Capped at CYCLE_BENCH_MAX_REPS
+    bool use_perf;
+} CycleBenchConfig;
+
+typedef struct
+{
+    double median_ticks;  // Per iteration, overhead removed
+    double mad_ticks;
+    double min_ticks;
+    double median_ns;
+    bool have_counters;
+    double counters[CYCLE_BENCH_COUNTERS];  // Per iteration, whole run
+} CycleBenchResult;
+
+static struct
+{
+    bool calibrated;
+    double ticks_per_ns;
+    uint64_t overhead;  // Ticks of an empty begin/end pair
+} cycle_bench_clock;
+
+static inline uint64_t cycle_bench_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+// Counter read that earlier instructions cannot drift past
+static inline uint64_t cycle_bench_begin(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t low, high;
+    __asm__ volatile("lfence\n\trdtsc" : "=a"(low), "=d"(high)::"memory");
+    return ((uint64_t) high << 32) | low;
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ volatile("isb\n\tmrs %0, cntvct_el0" : "=r"(ticks)::"memory");
+    return ticks;
+#else
+    return cycle_bench_monotonic_ns();
+#endif
+}
+
+// Counter read that waits for the measured code to retire, and that
+// later instructions cannot start ahead of
+static inline uint64_t cycle_bench_end(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t low, high, aux;
+    __asm__ volatile("rdtscp\n\tlfence"
+                     : "=a"(low), "=d"(high), "=c"(aux)::"memory");
+    return ((uint64_t) high << 32) | low;
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ volatile("isb\n\tmrs %0, cntvct_el0\n\tisb"
+                     : "=r"(ticks)::"memory");
+    return ticks;
+#else
+    return cycle_bench_monotonic_ns();
+#endif
+}
+
+static int cycle_bench_compare(const void* a, const void* b)
+{
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+// Median of values[0..count); sorts the array
+static double cycle_bench_median(double* values, int count)
+{
+    qsort(values, (size_t) count, sizeof(double), cycle_bench_compare);
+    return count % 2 ? values[count / 2]
+                     : (values[count / 2 - 1] + values[count / 2]) / 2;
+}
+
+// Work out ticks per nanosecond and the begin/end overhead; runs once
+static void cycle_bench_calibrate(void)
+{
+    if (cycle_bench_clock.calibrated) return;
+
+#if defined(__aarch64__)
+    uint64_t frequency;
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+    cycle_bench_clock.ticks_per_ns = frequency / 1e9;
+#elif defined(__x86_64__) || defined(__i386__)
+    // Count ticks across 20 ms of wall time; the TSC runs at a constant
+    // rate on every CPU recent enough to matter
+    uint64_t ns_start = cycle_bench_monotonic_ns();
+    uint64_t ticks_start = cycle_bench_begin();
+    while (cycle_bench_monotonic_ns() - ns_start < 20000000)
+    {
+    }
+    uint64_t ticks = cycle_bench_end() - ticks_start;
+    cycle_bench_clock.ticks_per_ns =
+        (double) ticks / (cycle_bench_monotonic_ns() - ns_start);
+#else
+    cycle_bench_clock.ticks_per_ns = 1.0;
+#endif
+
+    double pairs[CYCLE_BENCH_MAX_REPS];
+    for (int i = 0; i < CYCLE_BENCH_MAX_REPS; i++)
+    {
+        uint64_t start = cycle_bench_begin();
+        pairs[i] = (double) (cycle_bench_end() - start);
+    }
+    cycle_bench_clock.overhead =
+        (uint64_t) cycle_bench_median(pairs, CYCLE_BENCH_MAX_REPS);
+    cycle_bench_clock.calibrated = true;
+}
+
+#ifdef CYCLE_BENCH_PERF
+// One event group led by the cycle counter; -1 if perf is unavailable
+static int cycle_bench_open_counters(int fds[CYCLE_BENCH_COUNTERS])
+{
+    static const uint64_t events[CYCLE_BENCH_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+    for (int i = 0; i < CYCLE_BENCH_COUNTERS; i++)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = events[i];
+        attr.disabled = i == 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        fds[i] = (int) syscall(
+            SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds[0], 0);
+        if (fds[i] < 0)
+        {
+            while (--i >= 0) close(fds[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+#endif
+
+// Pin to the current CPU; returns false if the platform cannot
+static bool cycle_bench_pin(void)
+{
+#if defined(__linux__) && defined(_GNU_SOURCE)
+    int cpu = sched_getcpu();
+    if (cpu < 0) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+static CycleBenchResult cycle_bench_run(const CycleBenchConfig* config,
+                                        CycleBenchFn fn,
+                                        void* arg)
+{
+    CycleBenchResult result;
+    memset(&result, 0, sizeof(result));
+    cycle_bench_calibrate();
+
+#if defined(__linux__) && defined(_GNU_SOURCE)
+    cpu_set_t previous;
+    bool restore = sched_getaffinity(0, sizeof(previous), &previous) == 0
+                   && cycle_bench_pin();
+#endif
+
+    uint64_t iterations = config->iterations ? config->iterations : 1;
+    int reps = config->repetitions;
+    if (reps < 1) reps = 1;
+    if (reps > CYCLE_BENCH_MAX_REPS) reps = CYCLE_BENCH_MAX_REPS;
+
+    for (int i = 0; i < config->warmups; i++)
+    {
+        fn(arg, iterations);
+    }
+
+#ifdef CYCLE_BENCH_PERF
+    int fds[CYCLE_BENCH_COUNTERS];
+    bool perf = config->use_perf && cycle_bench_open_counters(fds) == 0;
+    if (perf)
+    {
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+
+    double samples[CYCLE_BENCH_MAX_REPS];
+    for (int r = 0; r < reps; r++)
+    {
+        uint64_t start = cycle_bench_begin();
+        fn(arg, iterations);
+        uint64_t ticks = cycle_bench_end() - start;
+        ticks = ticks > cycle_bench_clock.overhead
+                    ? ticks - cycle_bench_clock.overhead
+                    : 0;
+        samples[r] = (double) ticks / iterations;
+    }
+
+#ifdef CYCLE_BENCH_PERF
+    if (perf)
+    {
+        ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        uint64_t values[1 + CYCLE_BENCH_COUNTERS];
+        if (read(fds[0], values, sizeof(values)) == (ssize_t) sizeof(values)
+            && values[0] == CYCLE_BENCH_COUNTERS)
+        {
+            result.have_counters = true;
+            for (int i = 0; i < CYCLE_BENCH_COUNTERS; i++)
+            {
+                result.counters[i] =
+                    (double) values[1 + i] / ((double) iterations * reps);
+            }
+        }
+        for (int i = 0; i < CYCLE_BENCH_COUNTERS; i++) close(fds[i]);
+    }
+#endif
+
+#if defined(__linux__) && defined(_GNU_SOURCE)
+    if (restore) sched_setaffinity(0, sizeof(previous), &previous);
+#endif
+
+    result.median_ticks = cycle_bench_median(samples, reps);
+    result.min_ticks = samples[0];
+    for (int r = 0; r < reps; r++)
+    {
+        double deviation = samples[r] - result.median_ticks;
+        samples[r] = deviation < 0 ? -deviation : deviation;
+    }
+    result.mad_ticks = cycle_bench_median(samples, reps);
+    result.median_ns = result.median_ticks / cycle_bench_clock.ticks_per_ns;
+    return result;
+}
+
+static void cycle_bench_print(const char* name, const CycleBenchResult* result)
+{
+    printf("%-28s %10.2f ticks/iter (MAD %.2f, min %.2f) %9.3f ns/iter",
+           name,
+           result->median_ticks,
+           result->mad_ticks,
+           result->min_ticks,
+           result->median_ns);
+    if (result->have_counters)
+    {
+        printf(" | %.1f cyc %.1f ins (IPC %.2f) %.3f cache-miss %.3f br-miss",
+               result->counters[CB_COUNTER_CYCLES],
+               result->counters[CB_COUNTER_INSTRUCTIONS],
+               result->counters[CB_COUNTER_INSTRUCTIONS]
+                   / result->counters[CB_COUNTER_CYCLES],
+               result->counters[CB_COUNTER_CACHE_MISSES],
+               result->counters[CB_COUNTER_BRANCH_MISSES]);
+    }
+    printf("\n");
+}
+
+// Run and print in one step; the config name labels the line
+static CycleBenchResult cycle_bench(const CycleBenchConfig* config,
+                                    CycleBenchFn fn,
+                                    void* arg)
+{
+    CycleBenchResult result = cycle_bench_run(config, fn, arg);
+    cycle_bench_print(config->name, &result);
+    return result;
+}
+
+#endif  // CYCLE_BENCH_H
@@ -0,0 +1,264 @@
+// Device polling with backoff and event-driven wake-up, shared by the
+// simulated-hardware demos.
+//
+// device_poll() waits until a condition on device registers holds. It
+// escalates through four phases so a short wait stays fast and a long one
+// stops burning CPU:
+//
+//   spin   re-read the register back to back
+//   pause  re-read with cpu_relax() in between
+//   yield  re-read after sched_yield()
+//   block  sleep with exponential backoff, or, when the device has a
+//          DeviceEvent, block until the simulator signals a change
+//
+// A DeviceEvent is the simulator's "interrupt line": an eventfd on Linux
+// (so it can also go into poll/epoll sets) and a condition variable
+// elsewhere. The hardware thread calls device_event_signal() whenever it
+// changes a register, and the waiter re-checks the condition on every
+// wake-up, so spurious or coalesced signals are harmless. Every wait has
+// an optional timeout and fills in DevicePollStats for the latency versus
+// CPU comparisons in the demos.
+#ifndef DEVICE_POLL_H
+#define DEVICE_POLL_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cpu_primitives.h"
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/eventfd.h>
+#define DEVICE_POLL_EVENTFD 1
+#endif
+
+typedef struct
+{
+    unsigned spins;         // Back-to-back reads before pausing
+    unsigned pauses;        // Reads separated by cpu_relax()
+    unsigned yields;        // Reads separated by sched_yield()
+    unsigned sleep_min_us;  // First sleep of the block phase
+    unsigned sleep_max_us;  // Sleeps double up to this
+    uint64_t timeout_ns;    // 0 waits forever
+} DevicePollPolicy;
+
+// Spin briefly, then back off to sleeps of at most 1 ms
+#define DEVICE_POLL_DEFAULT {64, 256, 16, 10, 1000, 0}
+
+// Never leave the spin phase; the baseline the other policies are
+// measured against
+#define DEVICE_POLL_BUSY {UINT32_MAX, 0, 0, 0, 0, 0}
+
+typedef enum
+{
+    DEVICE_POLL_OK,
+    DEVICE_POLL_TIMEOUT
+} DevicePollResult;
+
+typedef struct
+{
+    uint64_t reads;    // Times the condition was evaluated
+    uint64_t sleeps;   // Sleeps or event waits in the block phase
+    uint64_t wait_ns;  // Wall time until the condition held
+    uint64_t cpu_ns;   // CPU time the waiting thread used meanwhile
+} DevicePollStats;
+
+typedef struct
+{
+#ifdef DEVICE_POLL_EVENTFD
+    int fd;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint64_t count;
+#endif
+} DeviceEvent;
+
+typedef bool (*DevicePollCondition)(void* arg);
+
+static inline uint64_t device_poll_clock_ns(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static inline bool device_event_init(DeviceEvent* event)
+{
+#ifdef DEVICE_POLL_EVENTFD
+    event->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    return event->fd >= 0;
+#else
+    event->count = 0;
+    return pthread_mutex_init(&event->lock, NULL) == 0
+           && pthread_cond_init(&event->changed, NULL) == 0;
+#endif
+}
+
+static inline void device_event_destroy(DeviceEvent* event)
+{
+#ifdef DEVICE_POLL_EVENTFD
+    if (event->fd >= 0) close(event->fd);
+    event->fd = -1;
+#else
+    pthread_cond_destroy(&event->changed);
+    pthread_mutex_destroy(&event->lock);
+#endif
+}
+
+// Raise the line; called by the hardware thread after a register change
+static inline void device_event_signal(DeviceEvent* event)
+{
+#ifdef DEVICE_POLL_EVENTFD
+    uint64_t one = 1;
+    ssize_t written = write(event->fd, &one, sizeof(one));
+    (void) written;  // Only fails when the counter is saturated
+#else
+    pthread_mutex_lock(&event->lock);
+    event->count++;
+    pthread_cond_broadcast(&event->changed);
+    pthread_mutex_unlock(&event->lock);
+#endif
+}
+
+// Block until the line is raised or timeout_ns passes, then clear it
+static inline void device_event_wait(DeviceEvent* event, uint64_t timeout_ns)
+{
+#ifdef DEVICE_POLL_EVENTFD
+    struct pollfd pfd = {event->fd, POLLIN, 0};
+    int timeout_ms = (int) ((timeout_ns + 999999) / 1000000);
+    if (poll(&pfd, 1, timeout_ms) > 0)
+    {
+        uint64_t count;
+        ssize_t got = read(event->fd, &count, sizeof(count));
+        (void) got;
+    }
+#else
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    uint64_t ns = (uint64_t) deadline.tv_nsec + timeout_ns;
+    deadline.tv_sec += (time_t) (ns / 1000000000u);
+    deadline.tv_nsec = (long) (ns % 1000000000u);
+
+    pthread_mutex_lock(&event->lock);
+    uint64_t seen = event->count;
+    while (event->count == seen
+           && pthread_cond_timedwait(&event->changed, &event->lock, &deadline)
+                  == 0)
+    {
+    }
+    pthread_mutex_unlock(&event->lock);
+#endif
+}
+
+// Wait for condition(arg) under policy. event may be NULL (sleep-based
+// backoff) and stats may be NULL.
+static DevicePollResult device_poll(DevicePollCondition condition,
+                                    void* arg,
+                                    const DevicePollPolicy* policy,
+                                    DeviceEvent* event,
+                                    DevicePollStats* stats)
+{
+    uint64_t start = device_poll_clock_ns(CLOCK_MONOTONIC);
+    uint64_t cpu_start = device_poll_clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    uint64_t deadline = policy->timeout_ns ? start + policy->timeout_ns : 0;
+    uint64_t reads = 0;
+    uint64_t sleeps = 0;
+    unsigned sleep_us = policy->sleep_min_us ? policy->sleep_min_us : 1;
+    DevicePollResult result = DEVICE_POLL_OK;
+
+    for (uint64_t attempt = 0;; attempt++)
+    {
+        reads++;
+        if (condition(arg)) break;
+
+        uint64_t now = 0;
+        if (deadline || attempt >= policy->spins)
+        {
+            // The spin phase only reads the clock when it has a deadline
+            now = device_poll_clock_ns(CLOCK_MONOTONIC);
+            if (deadline && now >= deadline)
+            {
+                result = DEVICE_POLL_TIMEOUT;
+                break;
+            }
+        }
+
+        uint64_t phase = attempt;
+        if (phase < policy->spins) continue;
+        phase -= policy->spins;
+        if (phase < policy->pauses)
+        {
+            cpu_relax();
+            continue;
+        }
+        phase -= policy->pauses;
+        if (phase < policy->yields)
+        {
+            sched_yield();
+            continue;
+        }
+
+        uint64_t nap_ns = (uint64_t) sleep_us * 1000;
+        if (deadline && deadline - now < nap_ns) nap_ns = deadline - now;
+        if (event != NULL)
+        {
+            // The line wakes us early; the nap is only a safety net
+            device_event_wait(event, nap_ns);
+        }
+        else
+        {
+            struct timespec nap = {(time_t) (nap_ns / 1000000000u),
+                                   (long) (nap_ns % 1000000000u)};
+            nanosleep(&nap, NULL);
+        }
+        sleeps++;
+        if (sleep_us < policy->sleep_max_us) sleep_us *= 2;
+        if (sleep_us > policy->sleep_max_us && policy->sleep_max_us)
+        {
+            sleep_us = policy->sleep_max_us;
+        }
+    }
+
+    if (stats != NULL)
+    {
+        stats->reads = reads;
+        stats->sleeps = sleeps;
+        stats->wait_ns = device_poll_clock_ns(CLOCK_MONOTONIC) - start;
+        stats->cpu_ns =
+            device_poll_clock_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+    }
+    return result;
+}
+
+// Condition for the common case: (*reg & mask) == value
+typedef struct
+{
+    const volatile uint32_t* reg;
+    uint32_t mask;
+    uint32_t value;
+} DeviceRegisterMatch;
+
+static inline bool device_register_matches(void* arg)
+{
+    const DeviceRegisterMatch* match = (const DeviceRegisterMatch*) arg;
+    return (*match->reg & match->mask) == match->value;
+}
+
+static inline DevicePollResult device_poll_register(
+    const volatile uint32_t* reg,
+    uint32_t mask,
+    uint32_t value,
+    const DevicePollPolicy* policy,
+    DeviceEvent* event,
+    DevicePollStats* stats)
+{
+    DeviceRegisterMatch match = {reg, mask, value};
+    return device_poll(device_register_matches, &match, policy, event, stats);
+}
+
+#endif  // DEVICE_POLL_H
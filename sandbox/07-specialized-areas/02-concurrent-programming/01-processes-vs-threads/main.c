@@ -1,12 +1,21 @@
+#define _GNU_SOURCE
 #include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "../../../bench/bench_report.h"
+
+extern char** environ;
+
 // Global variables
 int global_var = 0;
 
@@ -147,7 +156,7 @@ void measure_performance()
 {
     printf("\n=== PERFORMANCE COMPARISON ===\n");
 
-    const int NUM_CHILDREN = 5;
+    const int NUM_CHILDREN = (int) bench_param("THREADS", 5);
 
     printf("Creating %d processes...\n", NUM_CHILDREN);
 
@@ -208,6 +217,334 @@ void measure_performance()
     printf("Time taken to create and join %d threads: %.6f seconds\n",
            NUM_CHILDREN,
            thread_time);
+
+    bench_report("processes", process_time * 1e3, "ms", BENCH_LOWER_IS_BETTER);
+    bench_report("threads", thread_time * 1e3, "ms", BENCH_LOWER_IS_BETTER);
+}
+
+// Startup latency of every way to get a new flow of control, measured
+// per iteration with CLOCK_MONOTONIC and reported as percentiles. Each
+// sample covers create + wait for a child/thread that exits immediately.
+#define SPAWN_SAMPLES 200
+#define SPAWN_STACK_SIZE (64 * 1024)
+#define POOL_WORKERS 4
+
+typedef double (*SpawnOnce)(void);
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double spawn_fork()
+{
+    double start = now_ns();
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        _exit(0);
+    }
+    if (pid < 0)
+    {
+        return -1;
+    }
+    waitpid(pid, NULL, 0);
+    return now_ns() - start;
+}
+
+// vfork borrows the parent's address space until the child execs or
+// exits, so no page tables are copied at all
+static double spawn_vfork()
+{
+    double start = now_ns();
+    pid_t pid = vfork();
+    if (pid == 0)
+    {
+        _exit(0);
+    }
+    if (pid < 0)
+    {
+        return -1;
+    }
+    waitpid(pid, NULL, 0);
+    return now_ns() - start;
+}
+
+// posix_spawn includes the exec of a real program; glibc implements it
+// with CLONE_VM | CLONE_VFORK, so it stays flat as the parent grows
+static double spawn_posix_spawn()
+{
+    char* argv[] = {"true", NULL};
+    pid_t pid;
+
+    double start = now_ns();
+    if (posix_spawn(&pid, "/bin/true", NULL, NULL, argv, environ) != 0)
+    {
+        return -1;
+    }
+    waitpid(pid, NULL, 0);
+    return now_ns() - start;
+}
+
+static char* clone_stack;
+
+static int clone_child(void* arg)
+{
+    (void) arg;
+    return 0;
+}
+
+// A raw clone sharing the address space: a process that behaves like a
+// thread, without vfork's suspension of the parent
+static double spawn_clone_vm()
+{
+    double start = now_ns();
+    pid_t pid = clone(
+        clone_child, clone_stack + SPAWN_STACK_SIZE, CLONE_VM | SIGCHLD, NULL);
+    if (pid < 0)
+    {
+        return -1;
+    }
+    waitpid(pid, NULL, 0);
+    return now_ns() - start;
+}
+
+static void* empty_thread(void* arg)
+{
+    return arg;
+}
+
+static double spawn_thread()
+{
+    pthread_t thread;
+
+    double start = now_ns();
+    if (pthread_create(&thread, NULL, empty_thread, NULL) != 0)
+    {
+        return -1;
+    }
+    pthread_join(thread, NULL);
+    return now_ns() - start;
+}
+
+static char* thread_stack;
+
+// Same thread, but on a stack we allocated once: no mmap/munmap of a
+// fresh 8 MiB stack and guard page per thread
+static double spawn_thread_prealloc()
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, thread_stack, SPAWN_STACK_SIZE);
+    double start = now_ns();
+    int rc = pthread_create(&thread, &attr, empty_thread, NULL);
+    pthread_attr_destroy(&attr);
+    if (rc != 0)
+    {
+        return -1;
+    }
+    pthread_join(thread, NULL);
+    return now_ns() - start;
+}
+
+// Pre-forked pool: workers are forked once, up front, and block on a pipe;
+// "starting" one is a request/reply round trip
+typedef struct
+{
+    pid_t pid;
+    int request_fd;
+    int reply_fd;
+} PoolWorker;
+
+static PoolWorker pool[POOL_WORKERS];
+static int pool_next;
+
+static int pool_start()
+{
+    for (int i = 0; i < POOL_WORKERS; i++)
+    {
+        int request[2], reply[2];
+        if (pipe(request) != 0 || pipe(reply) != 0)
+        {
+            return -1;
+        }
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            return -1;
+        }
+        if (pid == 0)
+        {
+            char job;
+            close(request[1]);
+            close(reply[0]);
+            // Drop earlier workers' pipes, or their EOF never arrives
+            for (int j = 0; j < i; j++)
+            {
+                close(pool[j].request_fd);
+                close(pool[j].reply_fd);
+            }
+            while (read(request[0], &job, 1) == 1)
+            {
+                if (write(reply[1], &job, 1) != 1)
+                {
+                    break;
+                }
+            }
+            _exit(0);
+        }
+        close(request[0]);
+        close(reply[1]);
+        pool[i] = (PoolWorker) {pid, request[1], reply[0]};
+    }
+    return 0;
+}
+
+static void pool_stop()
+{
+    for (int i = 0; i < POOL_WORKERS; i++)
+    {
+        close(pool[i].request_fd);  // EOF ends the worker
+        close(pool[i].reply_fd);
+        waitpid(pool[i].pid, NULL, 0);
+    }
+}
+
+static double spawn_pool()
+{
+    PoolWorker* w = &pool[pool_next++ % POOL_WORKERS];
+    char job = 'j';
+
+    double start = now_ns();
+    if (write(w->request_fd, &job, 1) != 1
+        || read(w->reply_fd, &job, 1) != 1)
+    {
+        return -1;
+    }
+    return now_ns() - start;
+}
+
+static int compare_doubles(const void* a, const void* b)
+{
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+// Take 'samples' timings and print p50/p90/p99/max in microseconds;
+// returns the p50, or -1 if the method failed
+static double spawn_report(const char* name, SpawnOnce once, int samples)
+{
+    double times[SPAWN_SAMPLES];
+
+    for (int i = 0; i < samples; i++)
+    {
+        times[i] = once();
+        if (times[i] < 0)
+        {
+            printf("  %-24s failed\n", name);
+            return -1;
+        }
+    }
+    qsort(times, samples, sizeof(double), compare_doubles);
+    printf("  %-24s %9.1f %9.1f %9.1f %9.1f\n",
+           name,
+           times[samples / 2] / 1e3,
+           times[samples * 9 / 10] / 1e3,
+           times[samples * 99 / 100] / 1e3,
+           times[samples - 1] / 1e3);
+    return times[samples / 2] / 1e3;
+}
+
+// Make the parent's resident set 'mib' MiB by touching every page
+static char* grow_rss(size_t mib)
+{
+    size_t bytes = mib << 20;
+    char* block = mmap(NULL,
+                       bytes,
+                       PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS,
+                       -1,
+                       0);
+    if (block == MAP_FAILED)
+    {
+        return NULL;
+    }
+    long page = sysconf(_SC_PAGESIZE);
+    for (size_t off = 0; off < bytes; off += page)
+    {
+        block[off] = 1;
+    }
+    return block;
+}
+
+// Startup latency percentiles for processes, threads and a warm pool, then
+// how fork-style creation scales with the parent's RSS
+void spawn_latency_benchmark()
+{
+    printf("\n=== STARTUP LATENCY BENCHMARK ===\n");
+
+    clone_stack = malloc(SPAWN_STACK_SIZE);
+    thread_stack = malloc(SPAWN_STACK_SIZE);
+    if (clone_stack == NULL || thread_stack == NULL || pool_start() != 0)
+    {
+        fprintf(stderr, "Benchmark setup failed\n");
+        free(clone_stack);
+        free(thread_stack);
+        return;
+    }
+
+    printf("%d samples each (microseconds):\n", SPAWN_SAMPLES);
+    printf("  %-24s %9s %9s %9s %9s\n", "method", "p50", "p90", "p99", "max");
+    const struct
+    {
+        const char* name;
+        const char* key;  // For bench_report
+        SpawnOnce once;
+    } methods[] = {
+        {"fork + waitpid", "spawn_fork", spawn_fork},
+        {"vfork + waitpid", "spawn_vfork", spawn_vfork},
+        {"posix_spawn /bin/true", "spawn_posix_spawn", spawn_posix_spawn},
+        {"clone(CLONE_VM)", "spawn_clone_vm", spawn_clone_vm},
+        {"pthread_create", "spawn_thread", spawn_thread},
+        {"pthread, own stack", "spawn_thread_stack", spawn_thread_prealloc},
+        {"pre-forked pool", "spawn_pool", spawn_pool},
+    };
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++)
+    {
+        double p50 =
+            spawn_report(methods[i].name, methods[i].once, SPAWN_SAMPLES);
+        if (p50 >= 0)
+        {
+            bench_report(methods[i].key, p50, "us", BENCH_LOWER_IS_BETTER);
+        }
+    }
+    pool_stop();
+
+    // fork copies page tables in proportion to what the parent has mapped;
+    // vfork and posix_spawn share them and should not move
+    const size_t sizes[] = {64, 256, 1024};
+    for (int i = 0; i < 3; i++)
+    {
+        char* block = grow_rss(sizes[i]);
+        if (block == NULL)
+        {
+            printf("\nCould not grow RSS to %zu MiB\n", sizes[i]);
+            break;
+        }
+        printf("\nParent RSS grown by %zu MiB:\n", sizes[i]);
+        spawn_report("fork + waitpid", spawn_fork, 50);
+        spawn_report("vfork + waitpid", spawn_vfork, 50);
+        spawn_report("posix_spawn /bin/true", spawn_posix_spawn, 50);
+        munmap(block, sizes[i] << 20);
+    }
+
+    free(clone_stack);
+    free(thread_stack);
 }
 
 int main()
@@ -222,6 +559,7 @@ int main()
 
     // Measure and compare creation time
     measure_performance();
+    spawn_latency_benchmark();
 
     return 0;
 }
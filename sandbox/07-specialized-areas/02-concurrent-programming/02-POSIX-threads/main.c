@@ -1,7 +1,14 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 // Simple thread function
@@ -78,61 +85,1552 @@ void* cancellable_thread(void* arg)
     return NULL;
 }
 
+// Thread slots: per-thread storage without pthread_getspecific. Each
+// thread owns one ThreadSlot found through a _Thread_local pointer (a
+// single TLS load). Keys reserve bytes inside every slot, initialized the
+// first time the owning thread asks for them. Slots are linked into a
+// registry that is only ever prepended to and never freed, so aggregators
+// can walk every thread's data without locks. When a thread exits its key
+// destructors run and the slot is recycled for the next new thread.
+#define TLS_MAX_KEYS 16
+#define TLS_SLOT_BYTES 2048
+
+typedef void (*TlsCallback)(void* data);
+
+typedef struct ThreadSlot
+{
+    _Alignas(64) unsigned char storage[TLS_SLOT_BYTES];
+    _Atomic uint32_t initialized;  // Bit per key, written by the owner only
+    _Atomic int live;
+    struct ThreadSlot* next;       // Registry link, immutable once published
+    struct ThreadSlot* next_free;
+} ThreadSlot;
+
+static struct
+{
+    pthread_once_t once;
+    pthread_key_t exit_key;  // Only used to run destructors at thread exit
+    pthread_mutex_t lock;    // Serializes key creation and slot turnover
+    _Atomic(ThreadSlot*) registry;
+    ThreadSlot* free_slots;
+    _Atomic int key_count;
+    size_t used_bytes;
+    size_t offset[TLS_MAX_KEYS];
+    TlsCallback init[TLS_MAX_KEYS];
+    TlsCallback destructor[TLS_MAX_KEYS];
+} tls = {.once = PTHREAD_ONCE_INIT, .lock = PTHREAD_MUTEX_INITIALIZER};
+
+static _Thread_local ThreadSlot* tls_current;
+
+static void tls_thread_exit(void* arg)
+{
+    ThreadSlot* slot = arg;
+    uint32_t initialized = atomic_load(&slot->initialized);
+    int keys = atomic_load(&tls.key_count);
+
+    for (int key = 0; key < keys; key++)
+    {
+        if ((initialized & (1u << key)) && tls.destructor[key])
+        {
+            tls.destructor[key](slot->storage + tls.offset[key]);
+        }
+    }
+
+    // Walkers may still be reading; the storage itself stays valid
+    atomic_store_explicit(&slot->initialized, 0, memory_order_release);
+    atomic_store_explicit(&slot->live, 0, memory_order_release);
+    pthread_mutex_lock(&tls.lock);
+    slot->next_free = tls.free_slots;
+    tls.free_slots = slot;
+    pthread_mutex_unlock(&tls.lock);
+}
+
+static void tls_setup(void)
+{
+    pthread_key_create(&tls.exit_key, tls_thread_exit);
+}
+
+// Reserve 'size' bytes in every thread's slot. 'init' runs on a thread's
+// first tls_get of the key, 'destructor' when that thread exits; either
+// may be NULL. Keys last for the life of the process. Returns the key or
+// -1 when the slots are full.
+int tls_key_create(size_t size, TlsCallback init, TlsCallback destructor)
+{
+    pthread_once(&tls.once, tls_setup);
+    size = (size + 15) & ~(size_t) 15;
+
+    pthread_mutex_lock(&tls.lock);
+    int key = atomic_load(&tls.key_count);
+    if (key == TLS_MAX_KEYS || tls.used_bytes + size > TLS_SLOT_BYTES)
+    {
+        pthread_mutex_unlock(&tls.lock);
+        return -1;
+    }
+    tls.offset[key] = tls.used_bytes;
+    tls.init[key] = init;
+    tls.destructor[key] = destructor;
+    tls.used_bytes += size;
+    atomic_store_explicit(&tls.key_count, key + 1, memory_order_release);
+    pthread_mutex_unlock(&tls.lock);
+    return key;
+}
+
+// Slow path: attach a slot to this thread and/or run the key's init
+static void* tls_get_slow(int key)
+{
+    ThreadSlot* slot = tls_current;
+
+    if (!slot)
+    {
+        pthread_once(&tls.once, tls_setup);
+        pthread_mutex_lock(&tls.lock);
+        slot = tls.free_slots;
+        if (slot)
+        {
+            tls.free_slots = slot->next_free;
+        }
+        pthread_mutex_unlock(&tls.lock);
+
+        if (!slot)
+        {
+            slot = aligned_alloc(64, sizeof(ThreadSlot));
+            if (!slot)
+            {
+                return NULL;
+            }
+            atomic_init(&slot->initialized, 0);
+            atomic_init(&slot->live, 0);
+            // Publish to the registry: a single-word CAS keeps walkers
+            // lock-free
+            slot->next = atomic_load(&tls.registry);
+            while (!atomic_compare_exchange_weak(
+                &tls.registry, &slot->next, slot))
+            {
+            }
+        }
+        atomic_store_explicit(&slot->live, 1, memory_order_release);
+        pthread_setspecific(tls.exit_key, slot);
+        tls_current = slot;
+    }
+
+    void* data = slot->storage + tls.offset[key];
+    if (tls.init[key])
+    {
+        tls.init[key](data);
+    }
+    atomic_fetch_or_explicit(
+        &slot->initialized, 1u << key, memory_order_release);
+    return data;
+}
+
+// Calling thread's data for 'key'; NULL only if no slot could be
+// allocated. The fast path is a TLS load and a bit test.
+static inline void* tls_get(int key)
+{
+    ThreadSlot* slot = tls_current;
+    if (slot
+        && (atomic_load_explicit(&slot->initialized, memory_order_relaxed)
+            & (1u << key)))
+    {
+        return slot->storage + tls.offset[key];
+    }
+    return tls_get_slow(key);
+}
+
+// Visit 'key' data of every live thread that has initialized it, without
+// taking a lock. Data is read while its owner may be writing it, so
+// aggregated fields should be atomics.
+void tls_for_each(int key,
+                  void (*visit)(void* data, void* context),
+                  void* context)
+{
+    for (ThreadSlot* slot = atomic_load_explicit(&tls.registry,
+                                                 memory_order_acquire);
+         slot != NULL;
+         slot = slot->next)
+    {
+        uint32_t initialized =
+            atomic_load_explicit(&slot->initialized, memory_order_acquire);
+        if (atomic_load_explicit(&slot->live, memory_order_acquire)
+            && (initialized & (1u << key)))
+        {
+            visit(slot->storage + tls.offset[key], context);
+        }
+    }
+}
+
 // Thread function that uses thread-specific data
-pthread_key_t thread_log_key;
+#define THREAD_LOG_SIZE 1024
+
+int thread_log_key = -1;
+
+void init_log(void* buffer)
+{
+    // First time initialization
+    ((char*) buffer)[0] = '\0';
+}
+
+void cleanup_log(void* buffer)
+{
+    printf("Cleaning up thread log: %s\n", (char*) buffer);
+}
+
+void thread_log(const char* message)
+{
+    char* buffer = tls_get(thread_log_key);
+    if (!buffer)
+    {
+        return;
+    }
+
+    // Append the message to the buffer
+    size_t used = strlen(buffer);
+    snprintf(buffer + used, THREAD_LOG_SIZE - used, "%s\n", message);
+}
+
+void* logging_thread(void* arg)
+{
+    int thread_id = *(int*) arg;
+
+    char msg[100];
+
+    snprintf(msg, sizeof(msg), "[Thread %d] Starting work", thread_id);
+    thread_log(msg);
+
+    sleep(1);
+
+    snprintf(msg, sizeof(msg), "[Thread %d] Making progress", thread_id);
+    thread_log(msg);
+
+    sleep(1);
+
+    snprintf(msg, sizeof(msg), "[Thread %d] Finishing work", thread_id);
+    thread_log(msg);
+
+    // The log buffer will be freed by the cleanup function
+    char* log = tls_get(thread_log_key);
+    printf("Thread %d log:\n%s", thread_id, log ? log : "");
+
+    return NULL;
+}
+
+// Asynchronous logger. Each producer thread appends fixed-size binary
+// records to its own single-producer ring; a background writer drains all
+// rings, formats the records and writes them in large batches. The hot
+// path is a vDSO timestamp, a handful of stores and one release store - no
+// formatting, no FILE lock and no syscalls.
+#define LOG_RING_SIZE 4096  // Records per thread, power of two
+#define LOG_MAX_ARGS 5
+#define LOG_BATCH 2048                // Records merged per writer pass
+#define LOG_OUT_BUFFER (256 * 1024)   // Formatted bytes per write()
+#define LOG_LINE_MAX 512              // Longest formatted line
+
+typedef struct
+{
+    uint64_t timestamp;  // CLOCK_MONOTONIC nanoseconds
+    const char* format;  // Stored by pointer: must be a string literal
+    int64_t args[LOG_MAX_ARGS];
+    uint32_t thread;  // Filled in by the writer when draining
+} LogRecord;
+
+typedef struct LogRing
+{
+    // Producer and consumer indices live on separate cache lines so the
+    // two sides only share a line when the ring is actually full or empty
+    _Alignas(64) _Atomic uint64_t head;
+    uint64_t cached_tail;  // Producer's last view of tail
+    _Alignas(64) _Atomic uint64_t tail;
+    _Atomic int retired;  // Owning thread has exited
+    uint32_t thread;
+    struct LogRing* next;
+    LogRecord records[LOG_RING_SIZE];
+} LogRing;
+
+typedef enum
+{
+    LOG_DROP,  // Count and discard records when a ring is full
+    LOG_WAIT   // Yield until the writer frees a slot
+} LogOverflow;
+
+typedef struct
+{
+    uint64_t id;  // Distinguishes loggers reusing the same address
+    int fd;
+    LogOverflow overflow;
+    pthread_t writer;
+    pthread_key_t ring_key;      // Retires a ring when its thread exits
+    pthread_mutex_t rings_lock;  // Guards list membership, not records
+    LogRing* rings;
+    _Atomic uint32_t next_thread;
+    _Atomic int running;
+    _Atomic uint64_t dropped;
+    _Atomic uint64_t waits;
+    uint64_t written;  // Writer thread only
+    uint64_t batches;
+} AsyncLogger;
+
+static _Atomic uint64_t log_generation;
+static __thread LogRing* log_thread_ring;
+static __thread uint64_t log_thread_logger;
+
+static void log_ring_retire(void* ring)
+{
+    atomic_store_explicit(&((LogRing*) ring)->retired, 1, memory_order_release);
+}
+
+static LogRing* log_ring_register(AsyncLogger* lg)
+{
+    LogRing* ring = aligned_alloc(64, sizeof(LogRing));
+    if (!ring)
+    {
+        return NULL;
+    }
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->retired, 0);
+    ring->cached_tail = 0;
+    ring->thread = atomic_fetch_add(&lg->next_thread, 1) + 1;
+
+    // Registration is once per thread, so a mutex here costs nothing on
+    // the logging path
+    pthread_mutex_lock(&lg->rings_lock);
+    ring->next = lg->rings;
+    lg->rings = ring;
+    pthread_mutex_unlock(&lg->rings_lock);
+
+    pthread_setspecific(lg->ring_key, ring);
+    log_thread_ring = ring;
+    log_thread_logger = lg->id;
+    return ring;
+}
+
+// Hot path: reserve a slot in the calling thread's ring and publish it.
+// Returns 0 on success, -1 if the record was dropped.
+int async_log_record(AsyncLogger* lg,
+                     const char* format,
+                     const int64_t* args,
+                     int nargs)
+{
+    LogRing* ring = log_thread_ring;
+    if (log_thread_logger != lg->id)
+    {
+        ring = log_ring_register(lg);
+        if (!ring)
+        {
+            atomic_fetch_add_explicit(&lg->dropped, 1, memory_order_relaxed);
+            return -1;
+        }
+    }
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head - ring->cached_tail >= LOG_RING_SIZE)
+    {
+        // Only touch the consumer's cache line when the ring looks full
+        ring->cached_tail =
+            atomic_load_explicit(&ring->tail, memory_order_acquire);
+        while (head - ring->cached_tail >= LOG_RING_SIZE)
+        {
+            if (lg->overflow == LOG_DROP)
+            {
+                atomic_fetch_add_explicit(
+                    &lg->dropped, 1, memory_order_relaxed);
+                return -1;
+            }
+            atomic_fetch_add_explicit(&lg->waits, 1, memory_order_relaxed);
+            sched_yield();
+            ring->cached_tail =
+                atomic_load_explicit(&ring->tail, memory_order_acquire);
+        }
+    }
+
+    LogRecord* record = &ring->records[head & (LOG_RING_SIZE - 1)];
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    record->timestamp =
+        (uint64_t) now.tv_sec * UINT64_C(1000000000) + now.tv_nsec;
+    record->format = format;
+    for (int i = 0; i < nargs && i < LOG_MAX_ARGS; i++)
+    {
+        record->args[i] = args[i];
+    }
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return 0;
+}
+
+// ASYNC_LOG(lg, "x=%" PRId64 " y=%" PRId64, x, y)
+// Arguments are captured as int64_t, so conversions must use PRId64 (or
+// PRIx64 and friends). At most LOG_MAX_ARGS arguments are kept.
+#define ASYNC_LOG(lg, format, ...)                                  \
+    async_log_record((lg),                                          \
+                     (format),                                      \
+                     (const int64_t[]) {0, __VA_ARGS__} + 1,        \
+                     (int) (sizeof((int64_t[]) {0, __VA_ARGS__})    \
+                            / sizeof(int64_t))                      \
+                         - 1)
+
+static int log_record_compare(const void* a, const void* b)
+{
+    const LogRecord* x = a;
+    const LogRecord* y = b;
+    return (x->timestamp > y->timestamp) - (x->timestamp < y->timestamp);
+}
+
+// Move up to max records out of all rings, reclaiming rings whose threads
+// have exited and which are fully drained
+static size_t log_collect(AsyncLogger* lg, LogRecord* batch, size_t max)
+{
+    size_t count = 0;
+
+    pthread_mutex_lock(&lg->rings_lock);
+    LogRing** link = &lg->rings;
+    while (*link)
+    {
+        LogRing* ring = *link;
+
+        // Read retired before head: once it is set, head is final
+        int retired =
+            atomic_load_explicit(&ring->retired, memory_order_acquire);
+        uint64_t head =
+            atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint64_t tail =
+            atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+        while (tail != head && count < max)
+        {
+            batch[count] = ring->records[tail & (LOG_RING_SIZE - 1)];
+            batch[count].thread = ring->thread;
+            count++;
+            tail++;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+        if (retired && tail == head)
+        {
+            *link = ring->next;
+            free(ring);
+        }
+        else
+        {
+            link = &ring->next;
+        }
+    }
+    pthread_mutex_unlock(&lg->rings_lock);
+
+    return count;
+}
+
+static int log_write_all(int fd, const char* data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t n = write(fd, data, length);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        length -= n;
+    }
+    return 0;
+}
+
+static void log_format_batch(AsyncLogger* lg,
+                             LogRecord* batch,
+                             size_t count,
+                             char* out)
+{
+    // Rings are drained one after another; sorting the batch restores
+    // timestamp order across threads within each pass
+    qsort(batch, count, sizeof(LogRecord), log_record_compare);
+
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (LOG_OUT_BUFFER - length < LOG_LINE_MAX)
+        {
+            log_write_all(lg->fd, out, length);
+            length = 0;
+        }
+
+        const LogRecord* r = &batch[i];
+        char* line = out + length;
+        int n = snprintf(line,
+                         LOG_LINE_MAX,
+                         "%" PRIu64 ".%09" PRIu64 " [%u] ",
+                         r->timestamp / UINT64_C(1000000000),
+                         r->timestamp % UINT64_C(1000000000),
+                         r->thread);
+        int m = snprintf(line + n,
+                         LOG_LINE_MAX - n - 1,
+                         r->format,
+                         r->args[0],
+                         r->args[1],
+                         r->args[2],
+                         r->args[3],
+                         r->args[4]);
+        if (m < 0)
+        {
+            m = 0;
+        }
+        else if (m >= LOG_LINE_MAX - n - 1)
+        {
+            m = LOG_LINE_MAX - n - 2;  // Truncated
+        }
+        line[n + m] = '\n';
+        length += n + m + 1;
+    }
+
+    log_write_all(lg->fd, out, length);
+    lg->written += count;
+    lg->batches++;
+}
+
+static void* log_writer_thread(void* arg)
+{
+    AsyncLogger* lg = arg;
+    LogRecord* batch = malloc(LOG_BATCH * sizeof(LogRecord));
+    char* out = malloc(LOG_OUT_BUFFER);
+    int idle = 0;
+
+    for (;;)
+    {
+        // Sample running before draining: records published before the
+        // stop request are then guaranteed to be seen by this pass
+        int running = atomic_load_explicit(&lg->running, memory_order_acquire);
+        size_t count = log_collect(lg, batch, LOG_BATCH);
+
+        if (count > 0)
+        {
+            log_format_batch(lg, batch, count, out);
+            idle = 0;
+        }
+        else if (!running)
+        {
+            break;
+        }
+        else
+        {
+            // Back off while idle; producers never signal the writer
+            struct timespec pause = {0, idle < 16 ? 50000 : 1000000};
+            nanosleep(&pause, NULL);
+            idle++;
+        }
+    }
+
+    free(out);
+    free(batch);
+    return NULL;
+}
+
+int async_logger_start(AsyncLogger* lg, int fd, LogOverflow overflow)
+{
+    memset(lg, 0, sizeof(*lg));
+    lg->id = atomic_fetch_add(&log_generation, 1) + 1;
+    lg->fd = fd;
+    lg->overflow = overflow;
+    atomic_init(&lg->running, 1);
+
+    if (pthread_key_create(&lg->ring_key, log_ring_retire) != 0)
+    {
+        return -1;
+    }
+    pthread_mutex_init(&lg->rings_lock, NULL);
+
+    if (pthread_create(&lg->writer, NULL, log_writer_thread, lg) != 0)
+    {
+        pthread_mutex_destroy(&lg->rings_lock);
+        pthread_key_delete(lg->ring_key);
+        return -1;
+    }
+    return 0;
+}
+
+// Drain everything logged so far and stop the writer. Producer threads
+// must not log to lg once this has been called.
+void async_logger_stop(AsyncLogger* lg)
+{
+    atomic_store_explicit(&lg->running, 0, memory_order_release);
+    pthread_join(lg->writer, NULL);
+
+    while (lg->rings)
+    {
+        LogRing* ring = lg->rings;
+        lg->rings = ring->next;
+        free(ring);
+    }
+
+    // The calling thread may own a ring that was freed above
+    if (log_thread_logger == lg->id)
+    {
+        log_thread_ring = NULL;
+        log_thread_logger = 0;
+    }
+
+    pthread_key_delete(lg->ring_key);
+    pthread_mutex_destroy(&lg->rings_lock);
+}
+
+typedef struct
+{
+    int id;
+    int messages;
+    AsyncLogger* logger;  // NULL: log through stream
+    FILE* stream;
+    uint32_t* samples;  // Latency of every LOG_SAMPLE_EVERY-th call
+    int sample_count;
+} LogWorker;
+
+#define LOG_SAMPLE_EVERY 16
+
+static uint64_t log_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+static void* log_worker_thread(void* arg)
+{
+    LogWorker* w = arg;
+
+    for (int i = 0; i < w->messages; i++)
+    {
+        int sample = i % LOG_SAMPLE_EVERY == 0;
+        uint64_t start = sample ? log_now_ns() : 0;
+
+        if (w->logger)
+        {
+            ASYNC_LOG(w->logger,
+                      "worker %" PRId64 " step %" PRId64 " value %" PRId64,
+                      w->id,
+                      i,
+                      i * 7);
+        }
+        else
+        {
+            uint64_t t = log_now_ns();
+            fprintf(w->stream,
+                    "%" PRIu64 ".%09" PRIu64
+                    " [%d] worker %d step %d value %d\n",
+                    t / UINT64_C(1000000000),
+                    t % UINT64_C(1000000000),
+                    w->id,
+                    w->id,
+                    i,
+                    i * 7);
+        }
+
+        if (sample)
+        {
+            w->samples[w->sample_count++] = (uint32_t) (log_now_ns() - start);
+        }
+    }
+    return NULL;
+}
+
+static int log_sample_compare(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*) a;
+    uint32_t y = *(const uint32_t*) b;
+    return (x > y) - (x < y);
+}
+
+static long count_lines(const char* filename)
+{
+    FILE* f = fopen(filename, "r");
+    if (!f)
+    {
+        return -1;
+    }
+
+    long lines = 0;
+    int c;
+    while ((c = getc(f)) != EOF)
+    {
+        lines += c == '\n';
+    }
+    fclose(f);
+    return lines;
+}
+
+// Run workers against stdio (line buffered, shared FILE lock) or the
+// async logger and report call latency percentiles
+static void log_benchmark(const char* label,
+                          const char* filename,
+                          int use_async,
+                          int threads,
+                          int messages)
+{
+    pthread_t tids[threads];
+    LogWorker workers[threads];
+    int per_thread = (messages + LOG_SAMPLE_EVERY - 1) / LOG_SAMPLE_EVERY;
+    uint32_t* samples = malloc(sizeof(uint32_t) * per_thread * threads);
+    AsyncLogger logger;
+    FILE* stream = NULL;
+
+    if (!samples)
+    {
+        return;
+    }
+
+    if (use_async)
+    {
+        int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || async_logger_start(&logger, fd, LOG_WAIT) != 0)
+        {
+            perror("async_logger_start");
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            free(samples);
+            return;
+        }
+    }
+    else
+    {
+        stream = fopen(filename, "w");
+        if (!stream)
+        {
+            perror("fopen");
+            free(samples);
+            return;
+        }
+        setvbuf(stream, NULL, _IOLBF, BUFSIZ);
+    }
+
+    uint64_t start = log_now_ns();
+    for (int i = 0; i < threads; i++)
+    {
+        workers[i] = (LogWorker) {i + 1,
+                                  messages,
+                                  use_async ? &logger : NULL,
+                                  stream,
+                                  samples + (size_t) i * per_thread,
+                                  0};
+        pthread_create(&tids[i], NULL, log_worker_thread, &workers[i]);
+    }
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_join(tids[i], NULL);
+    }
+    uint64_t produced = log_now_ns();
+
+    uint64_t written = 0, dropped = 0, waits = 0, batches = 0;
+    if (use_async)
+    {
+        async_logger_stop(&logger);
+        close(logger.fd);
+        written = logger.written;
+        dropped = atomic_load(&logger.dropped);
+        waits = atomic_load(&logger.waits);
+        batches = logger.batches;
+    }
+    else
+    {
+        fclose(stream);
+    }
+    uint64_t finished = log_now_ns();
+
+    // Compact the per-thread sample blocks and take percentiles
+    size_t total = 0;
+    for (int i = 0; i < threads; i++)
+    {
+        memmove(samples + total,
+                workers[i].samples,
+                sizeof(uint32_t) * workers[i].sample_count);
+        total += workers[i].sample_count;
+    }
+    qsort(samples, total, sizeof(uint32_t), log_sample_compare);
+
+    printf("%-22s p50 %5u ns  p99 %6u ns  p99.9 %7u ns  max %8u ns\n",
+           label,
+           samples[total / 2],
+           samples[total * 99 / 100],
+           samples[total * 999 / 1000],
+           samples[total - 1]);
+    printf("%-22s producers %.1f ms, drained %.1f ms, %ld lines on disk\n",
+           "",
+           (produced - start) / 1e6,
+           (finished - start) / 1e6,
+           count_lines(filename));
+    if (use_async)
+    {
+        printf("%-22s %" PRIu64 " records in %" PRIu64 " batches, %" PRIu64
+               " dropped, %" PRIu64 " full-ring waits\n",
+               "",
+               written,
+               batches,
+               dropped,
+               waits);
+    }
+
+    free(samples);
+    remove(filename);
+}
+
+// Asynchronous logging demonstration
+void async_logger_demo()
+{
+    printf("\n=== ASYNCHRONOUS LOGGER DEMO ===\n");
+
+    // Small example straight to stdout; flush stdio first so its buffered
+    // output does not interleave with the writer's direct write() calls
+    fflush(stdout);
+    AsyncLogger logger;
+    if (async_logger_start(&logger, STDOUT_FILENO, LOG_DROP) == 0)
+    {
+        for (int64_t i = 1; i <= 3; i++)
+        {
+            ASYNC_LOG(&logger, "main thread message %" PRId64 " of 3", i);
+        }
+        ASYNC_LOG(&logger, "no arguments needed");
+        async_logger_stop(&logger);
+    }
+
+    printf("\n%d threads x %d messages each:\n", 4, 200000);
+    log_benchmark("stdio _IOLBF", "stdio_log.txt", 0, 4, 200000);
+    log_benchmark("async ring logger", "async_log.txt", 1, 4, 200000);
+}
+
+// Work-stealing executor. Each worker owns a Chase-Lev deque: it pushes
+// and pops tasks at the bottom without locks while idle workers steal from
+// the top. Threads outside the pool submit through a shared injection
+// queue. Tasks live in caller-provided storage, so spawning allocates
+// nothing, and joining a task runs other tasks instead of blocking.
+#define EXECUTOR_MAX_WORKERS 64
+#define DEQUE_INITIAL_CAPACITY 256  // Power of two
+#define EXECUTOR_SPIN_ROUNDS 64     // Failed searches before parking
+
+typedef void (*TaskFunc)(void* arg);
+
+typedef struct Task
+{
+    TaskFunc func;
+    void* arg;
+    _Atomic int done;   // Set once func has returned: the join handle
+    struct Task* next;  // Injection queue link
+} Task;
+
+typedef struct DequeArray
+{
+    int64_t capacity;
+    struct DequeArray* retired;  // Older arrays, freed with the deque
+    _Atomic(Task*) slots[];
+} DequeArray;
+
+typedef struct
+{
+    _Alignas(64) _Atomic int64_t top;  // Stealers take from here
+    _Alignas(64) _Atomic int64_t bottom;  // Owner pushes and pops here
+    _Atomic(DequeArray*) array;
+} WorkDeque;
+
+typedef struct Executor Executor;
+
+typedef struct
+{
+    WorkDeque deque;
+    Executor* executor;
+    pthread_t thread;
+    unsigned seed;  // Victim selection
+    uint64_t executed;
+    uint64_t stolen;
+} Worker;
+
+struct Executor
+{
+    Worker workers[EXECUTOR_MAX_WORKERS];
+    int worker_count;
+
+    pthread_mutex_t inject_lock;
+    Task* inject_head;
+    Task* inject_tail;
+    _Atomic int injected;  // Tasks in the injection queue
+
+    pthread_mutex_t park_lock;
+    pthread_cond_t park_cond;  // Idle workers
+    pthread_cond_t done_cond;  // Outside threads waiting in a join
+    _Atomic int sleepers;
+    _Atomic int outside_waiters;
+    _Atomic int stopping;
+};
+
+static _Thread_local Worker* current_worker;
+
+static DequeArray* deque_array_new(int64_t capacity)
+{
+    DequeArray* a =
+        malloc(sizeof(DequeArray) + capacity * sizeof(_Atomic(Task*)));
+    if (a != NULL)
+    {
+        a->capacity = capacity;
+        a->retired = NULL;
+    }
+    return a;
+}
+
+static void deque_init(WorkDeque* d)
+{
+    atomic_init(&d->top, 0);
+    atomic_init(&d->bottom, 0);
+    atomic_init(&d->array, deque_array_new(DEQUE_INITIAL_CAPACITY));
+}
+
+static void deque_destroy(WorkDeque* d)
+{
+    DequeArray* a = atomic_load(&d->array);
+    while (a != NULL)
+    {
+        DequeArray* older = a->retired;
+        free(a);
+        a = older;
+    }
+}
+
+// Owner only. Doubles the array when full; the old one is kept alive
+// because a concurrent stealer may still be reading from it.
+static void deque_push(WorkDeque* d, Task* task)
+{
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    DequeArray* a = atomic_load_explicit(&d->array, memory_order_relaxed);
+
+    if (b - t > a->capacity - 1)
+    {
+        DequeArray* grown = deque_array_new(a->capacity * 2);
+        if (grown == NULL)
+        {
+            // Out of memory: run in place rather than lose the task
+            task->func(task->arg);
+            atomic_store_explicit(&task->done, 1, memory_order_release);
+            return;
+        }
+        for (int64_t i = t; i < b; i++)
+        {
+            atomic_store_explicit(
+                &grown->slots[i & (grown->capacity - 1)],
+                atomic_load_explicit(&a->slots[i & (a->capacity - 1)],
+                                     memory_order_relaxed),
+                memory_order_relaxed);
+        }
+        grown->retired = a;
+        atomic_store_explicit(&d->array, grown, memory_order_release);
+        a = grown;
+    }
 
-void cleanup_log(void* buffer)
+    // The release store of bottom publishes both the slot and the task
+    atomic_store_explicit(
+        &a->slots[b & (a->capacity - 1)], task, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_release);
+}
+
+// Owner only: most recently pushed task, or NULL
+static Task* deque_pop(WorkDeque* d)
 {
-    if (buffer)
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    DequeArray* a = atomic_load_explicit(&d->array, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (t > b)
+    {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return NULL;  // Empty
+    }
+
+    Task* task = atomic_load_explicit(&a->slots[b & (a->capacity - 1)],
+                                      memory_order_relaxed);
+    if (t == b)
     {
-        printf("Cleaning up thread log: %s\n", (char*) buffer);
-        free(buffer);
+        // Last task: race any stealer for it through top
+        if (!atomic_compare_exchange_strong_explicit(&d->top,
+                                                     &t,
+                                                     t + 1,
+                                                     memory_order_seq_cst,
+                                                     memory_order_relaxed))
+        {
+            task = NULL;
+        }
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
     }
+    return task;
 }
 
-void thread_log(const char* message)
+// Any thread: oldest task, or NULL if empty or another thief won
+static Task* deque_steal(WorkDeque* d)
 {
-    char* buffer = pthread_getspecific(thread_log_key);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
 
-    if (!buffer)
+    if (t >= b)
     {
-        // First time initialization
-        buffer = malloc(1024);
-        buffer[0] = '\0';
-        pthread_setspecific(thread_log_key, buffer);
+        return NULL;
     }
 
-    // Append the message to the buffer
-    strcat(buffer, message);
-    strcat(buffer, "\n");
+    DequeArray* a = atomic_load_explicit(&d->array, memory_order_acquire);
+    Task* task = atomic_load_explicit(&a->slots[t & (a->capacity - 1)],
+                                      memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top,
+                                                 &t,
+                                                 t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed))
+    {
+        return NULL;
+    }
+    return task;
 }
 
-void* logging_thread(void* arg)
+static void executor_wake(Executor* ex)
 {
-    int thread_id = *(int*) arg;
+    // Pairs with the fence in executor_park: either the sleeper sees the
+    // new task on its final check, or we see it counted and signal it
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&ex->sleepers, memory_order_relaxed) > 0)
+    {
+        pthread_mutex_lock(&ex->park_lock);
+        pthread_cond_signal(&ex->park_cond);
+        pthread_mutex_unlock(&ex->park_lock);
+    }
+}
 
-    char msg[100];
+static Task* executor_take_injected(Executor* ex)
+{
+    if (atomic_load_explicit(&ex->injected, memory_order_relaxed) == 0)
+    {
+        return NULL;
+    }
 
-    snprintf(msg, sizeof(msg), "[Thread %d] Starting work", thread_id);
-    thread_log(msg);
+    pthread_mutex_lock(&ex->inject_lock);
+    Task* task = ex->inject_head;
+    if (task != NULL)
+    {
+        ex->inject_head = task->next;
+        if (ex->inject_head == NULL)
+        {
+            ex->inject_tail = NULL;
+        }
+        atomic_fetch_sub_explicit(&ex->injected, 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&ex->inject_lock);
+    return task;
+}
 
-    sleep(1);
+// Own deque first (newest, cache-warm), then the injection queue, then
+// one pass over the other workers starting at a random victim
+static Task* executor_find_task(Executor* ex, Worker* self, unsigned* seed)
+{
+    Task* task = self ? deque_pop(&self->deque) : NULL;
+    if (task != NULL)
+    {
+        return task;
+    }
 
-    snprintf(msg, sizeof(msg), "[Thread %d] Making progress", thread_id);
-    thread_log(msg);
+    task = executor_take_injected(ex);
+    if (task != NULL)
+    {
+        return task;
+    }
 
-    sleep(1);
+    int start = rand_r(seed) % ex->worker_count;
+    for (int i = 0; i < ex->worker_count; i++)
+    {
+        Worker* victim = &ex->workers[(start + i) % ex->worker_count];
+        if (victim != self)
+        {
+            task = deque_steal(&victim->deque);
+            if (task != NULL)
+            {
+                if (self)
+                {
+                    self->stolen++;
+                }
+                return task;
+            }
+        }
+    }
+    return NULL;
+}
 
-    snprintf(msg, sizeof(msg), "[Thread %d] Finishing work", thread_id);
-    thread_log(msg);
+static int executor_has_work(Executor* ex)
+{
+    if (atomic_load_explicit(&ex->injected, memory_order_relaxed) > 0)
+    {
+        return 1;
+    }
+    for (int i = 0; i < ex->worker_count; i++)
+    {
+        WorkDeque* d = &ex->workers[i].deque;
+        if (atomic_load_explicit(&d->bottom, memory_order_relaxed)
+            > atomic_load_explicit(&d->top, memory_order_relaxed))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
 
-    // The log buffer will be freed by the cleanup function
-    char* log = pthread_getspecific(thread_log_key);
-    printf("Thread %d log:\n%s", thread_id, log);
+static void executor_park(Executor* ex)
+{
+    pthread_mutex_lock(&ex->park_lock);
+    atomic_fetch_add_explicit(&ex->sleepers, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!executor_has_work(ex) && !atomic_load(&ex->stopping))
+    {
+        pthread_cond_wait(&ex->park_cond, &ex->park_lock);
+    }
+    atomic_fetch_sub_explicit(&ex->sleepers, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&ex->park_lock);
+}
+
+static void task_run(Executor* ex, Task* task)
+{
+    task->func(task->arg);
+    atomic_store_explicit(&task->done, 1, memory_order_release);
+
+    // Same handshake as executor_wake, for threads blocked in a join
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&ex->outside_waiters, memory_order_relaxed) > 0)
+    {
+        pthread_mutex_lock(&ex->park_lock);
+        pthread_cond_broadcast(&ex->done_cond);
+        pthread_mutex_unlock(&ex->park_lock);
+    }
+}
+
+static void* executor_worker_thread(void* arg)
+{
+    Worker* self = arg;
+    Executor* ex = self->executor;
+    int idle = 0;
+
+    current_worker = self;
+    while (!atomic_load_explicit(&ex->stopping, memory_order_acquire))
+    {
+        Task* task = executor_find_task(ex, self, &self->seed);
+        if (task != NULL)
+        {
+            task_run(ex, task);
+            self->executed++;
+            idle = 0;
+        }
+        else if (++idle < EXECUTOR_SPIN_ROUNDS)
+        {
+            sched_yield();
+        }
+        else
+        {
+            executor_park(ex);
+            idle = 0;
+        }
+    }
+    current_worker = NULL;
+    return NULL;
+}
+
+// Start workers (0 = one per online CPU). Returns 0 on success.
+int executor_create(Executor* ex, int workers)
+{
+    memset(ex, 0, sizeof(*ex));
+    if (workers <= 0)
+    {
+        workers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (workers < 1)
+    {
+        workers = 1;
+    }
+    if (workers > EXECUTOR_MAX_WORKERS)
+    {
+        workers = EXECUTOR_MAX_WORKERS;
+    }
+
+    pthread_mutex_init(&ex->inject_lock, NULL);
+    pthread_mutex_init(&ex->park_lock, NULL);
+    pthread_cond_init(&ex->park_cond, NULL);
+    pthread_cond_init(&ex->done_cond, NULL);
+
+    // All deques exist before any worker starts stealing
+    for (int i = 0; i < workers; i++)
+    {
+        deque_init(&ex->workers[i].deque);
+        if (atomic_load(&ex->workers[i].deque.array) == NULL)
+        {
+            return -1;
+        }
+        ex->workers[i].executor = ex;
+        ex->workers[i].seed = 0x9e3779b9u * (i + 1);
+    }
+    ex->worker_count = workers;
+
+    for (int i = 0; i < workers; i++)
+    {
+        if (pthread_create(&ex->workers[i].thread,
+                           NULL,
+                           executor_worker_thread,
+                           &ex->workers[i])
+            != 0)
+        {
+            fprintf(stderr, "Error creating executor worker %d\n", i);
+            atomic_store(&ex->stopping, 1);
+            pthread_mutex_lock(&ex->park_lock);
+            pthread_cond_broadcast(&ex->park_cond);
+            pthread_mutex_unlock(&ex->park_lock);
+            for (int j = 0; j < i; j++)
+            {
+                pthread_join(ex->workers[j].thread, NULL);
+            }
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Schedule func(arg) using the caller's Task as storage. From a worker the
+// task goes on its own deque; from any other thread, the injection queue.
+void executor_spawn(Executor* ex, Task* task, TaskFunc func, void* arg)
+{
+    task->func = func;
+    task->arg = arg;
+    task->next = NULL;
+    atomic_store_explicit(&task->done, 0, memory_order_relaxed);
+
+    Worker* self = current_worker;
+    if (self != NULL && self->executor == ex)
+    {
+        deque_push(&self->deque, task);
+    }
+    else
+    {
+        pthread_mutex_lock(&ex->inject_lock);
+        if (ex->inject_tail != NULL)
+        {
+            ex->inject_tail->next = task;
+        }
+        else
+        {
+            ex->inject_head = task;
+        }
+        ex->inject_tail = task;
+        atomic_fetch_add_explicit(&ex->injected, 1, memory_order_relaxed);
+        pthread_mutex_unlock(&ex->inject_lock);
+    }
+    executor_wake(ex);
+}
+
+// Wait for a spawned task. A worker keeps executing other tasks meanwhile,
+// so nested spawn/join never deadlocks the pool. Any other thread sleeps:
+// if it helped too, each task it picked up would nest on its stack.
+void executor_join(Executor* ex, Task* task)
+{
+    Worker* self = current_worker;
+
+    if (self == NULL || self->executor != ex)
+    {
+        pthread_mutex_lock(&ex->park_lock);
+        atomic_fetch_add_explicit(
+            &ex->outside_waiters, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        while (!atomic_load_explicit(&task->done, memory_order_acquire))
+        {
+            pthread_cond_wait(&ex->done_cond, &ex->park_lock);
+        }
+        atomic_fetch_sub_explicit(
+            &ex->outside_waiters, 1, memory_order_relaxed);
+        pthread_mutex_unlock(&ex->park_lock);
+        return;
+    }
+
+    while (!atomic_load_explicit(&task->done, memory_order_acquire))
+    {
+        Task* other = executor_find_task(ex, self, &self->seed);
+        if (other != NULL)
+        {
+            task_run(ex, other);
+            self->executed++;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+}
+
+typedef void (*RangeFunc)(void* context, long begin, long end);
+
+typedef struct
+{
+    Executor* executor;
+    long begin;
+    long end;
+    long grain;
+    RangeFunc body;
+    void* context;
+} ParallelRange;
+
+// Split in halves down to the grain size: the far half is offered for
+// stealing while this thread keeps working through the near half
+static void parallel_for_task(void* arg)
+{
+    ParallelRange* range = arg;
+
+    if (range->end - range->begin <= range->grain)
+    {
+        range->body(range->context, range->begin, range->end);
+        return;
+    }
+
+    long mid = range->begin + (range->end - range->begin) / 2;
+    ParallelRange upper = *range;
+    ParallelRange lower = *range;
+    upper.begin = mid;
+    lower.end = mid;
 
+    Task task;
+    executor_spawn(range->executor, &task, parallel_for_task, &upper);
+    parallel_for_task(&lower);
+    executor_join(range->executor, &task);
+}
+
+// Run body over [begin, end) in chunks of at most grain indices
+void executor_parallel_for(Executor* ex,
+                           long begin,
+                           long end,
+                           long grain,
+                           RangeFunc body,
+                           void* context)
+{
+    ParallelRange range = {
+        ex, begin, end, grain > 0 ? grain : 1, body, context};
+    Task root;
+    executor_spawn(ex, &root, parallel_for_task, &range);
+    executor_join(ex, &root);
+}
+
+// Stop the workers. Every spawned task must have been joined.
+void executor_destroy(Executor* ex)
+{
+    atomic_store_explicit(&ex->stopping, 1, memory_order_release);
+    pthread_mutex_lock(&ex->park_lock);
+    pthread_cond_broadcast(&ex->park_cond);
+    pthread_mutex_unlock(&ex->park_lock);
+
+    for (int i = 0; i < ex->worker_count; i++)
+    {
+        pthread_join(ex->workers[i].thread, NULL);
+        deque_destroy(&ex->workers[i].deque);
+    }
+    pthread_cond_destroy(&ex->done_cond);
+    pthread_cond_destroy(&ex->park_cond);
+    pthread_mutex_destroy(&ex->park_lock);
+    pthread_mutex_destroy(&ex->inject_lock);
+}
+
+static void tiny_task(void* arg)
+{
+    atomic_fetch_add_explicit((_Atomic long*) arg, 1, memory_order_relaxed);
+}
+
+static void* tiny_thread(void* arg)
+{
+    tiny_task(arg);
     return NULL;
 }
 
+typedef struct
+{
+    const double* values;
+    _Atomic long visited;
+    double partial[EXECUTOR_MAX_WORKERS + 1];  // One slot per thread
+} SumContext;
+
+static void sum_range(void* context, long begin, long end)
+{
+    SumContext* ctx = context;
+    double sum = 0;
+    for (long i = begin; i < end; i++)
+    {
+        sum += ctx->values[i];
+    }
+
+    // Slot 0 is the submitting thread, 1..n the workers
+    Worker* self = current_worker;
+    int slot = self ? (int) (self - self->executor->workers) + 1 : 0;
+    ctx->partial[slot] += sum;
+    atomic_fetch_add_explicit(&ctx->visited, end - begin, memory_order_relaxed);
+}
+
+typedef struct
+{
+    Executor* executor;
+    int n;
+    long result;
+} FibTask;
+
+static long fib_serial(int n)
+{
+    return n < 2 ? n : fib_serial(n - 1) + fib_serial(n - 2);
+}
+
+// Fine-grained nested parallelism: one spawn per call above the cutoff
+static void fib_task(void* arg)
+{
+    FibTask* f = arg;
+    if (f->n < 20)
+    {
+        f->result = fib_serial(f->n);
+        return;
+    }
+
+    FibTask left = {f->executor, f->n - 1, 0};
+    FibTask right = {f->executor, f->n - 2, 0};
+    Task task;
+    executor_spawn(f->executor, &task, fib_task, &left);
+    fib_task(&right);
+    executor_join(f->executor, &task);
+    f->result = left.result + right.result;
+}
+
+static double elapsed_seconds(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Work-stealing executor demonstration
+void executor_demo()
+{
+    printf("\n=== WORK-STEALING EXECUTOR DEMO ===\n");
+
+    Executor ex;
+    if (executor_create(&ex, 0) != 0)
+    {
+        return;
+    }
+    printf("Executor running %d workers\n", ex.worker_count);
+
+    // Per-task overhead: a fresh thread per task versus spawn/join
+    enum
+    {
+        TINY_TASKS = 2000
+    };
+    static Task tasks[TINY_TASKS];
+    _Atomic long counter = 0;
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TINY_TASKS; i++)
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, tiny_thread, &counter) == 0)
+        {
+            pthread_join(thread, NULL);
+        }
+    }
+    double thread_time = elapsed_seconds(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TINY_TASKS; i++)
+    {
+        executor_spawn(&ex, &tasks[i], tiny_task, &counter);
+    }
+    for (int i = 0; i < TINY_TASKS; i++)
+    {
+        executor_join(&ex, &tasks[i]);
+    }
+    double spawn_time = elapsed_seconds(&start);
+
+    printf("Tiny tasks: thread per task %.2f us each, executor %.2f us each"
+           " (%ld ran)\n",
+           thread_time * 1e6 / TINY_TASKS,
+           spawn_time * 1e6 / TINY_TASKS,
+           atomic_load(&counter));
+
+    // Data parallelism: sum an array with parallel_for
+    long count = 20000000;
+    double* values = malloc(count * sizeof(double));
+    if (values != NULL)
+    {
+        for (long i = 0; i < count; i++)
+        {
+            values[i] = (double) (i % 1000) * 0.5;
+        }
+
+        SumContext* ctx = calloc(1, sizeof(SumContext));
+        if (ctx != NULL)
+        {
+            ctx->values = values;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            double serial = 0;
+            for (long i = 0; i < count; i++)
+            {
+                serial += values[i];
+            }
+            double serial_time = elapsed_seconds(&start);
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            executor_parallel_for(&ex, 0, count, 65536, sum_range, ctx);
+            double parallel = 0;
+            for (int i = 0; i <= EXECUTOR_MAX_WORKERS; i++)
+            {
+                parallel += ctx->partial[i];
+            }
+            double parallel_time = elapsed_seconds(&start);
+
+            printf("parallel_for sum of %ld doubles: serial %.1f ms, "
+                   "executor %.1f ms, %s (%ld visited)\n",
+                   count,
+                   serial_time * 1e3,
+                   parallel_time * 1e3,
+                   serial == parallel ? "sums match" : "sums differ",
+                   atomic_load(&ctx->visited));
+            free(ctx);
+        }
+        free(values);
+    }
+
+    // Nested fork/join
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    long expected = fib_serial(32);
+    double fib_serial_time = elapsed_seconds(&start);
+
+    FibTask root = {&ex, 32, 0};
+    Task root_task;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    executor_spawn(&ex, &root_task, fib_task, &root);
+    executor_join(&ex, &root_task);
+    double fib_parallel_time = elapsed_seconds(&start);
+
+    printf("fib(32) = %ld: serial %.1f ms, fork/join %.1f ms%s\n",
+           root.result,
+           fib_serial_time * 1e3,
+           fib_parallel_time * 1e3,
+           root.result == expected ? "" : " (WRONG)");
+
+    uint64_t executed = 0;
+    uint64_t stolen = 0;
+    executor_destroy(&ex);
+    for (int i = 0; i < ex.worker_count; i++)
+    {
+        executed += ex.workers[i].executed;
+        stolen += ex.workers[i].stolen;
+    }
+    printf("Workers executed %" PRIu64 " tasks, %" PRIu64 " of them stolen\n",
+           executed,
+           stolen);
+}
+
 // Basic thread creation and joining
 void basic_thread_demo()
 {
@@ -306,8 +1804,11 @@ void thread_specific_data_demo()
 {
     printf("\n=== THREAD-SPECIFIC DATA DEMO ===\n");
 
-    // Create a key for thread-specific data
-    pthread_key_create(&thread_log_key, cleanup_log);
+    // Reserve each thread's log buffer in its thread slot
+    if (thread_log_key < 0)
+    {
+        thread_log_key = tls_key_create(THREAD_LOG_SIZE, init_log, cleanup_log);
+    }
 
     pthread_t threads[2];
     int thread_ids[2] = {1, 2};
@@ -323,9 +1824,116 @@ void thread_specific_data_demo()
     {
         pthread_join(threads[i], NULL);
     }
+}
+
+// Per-thread counters on thread slots: owners bump their own cache line,
+// readers sum every live slot with tls_for_each, and a thread's count is
+// folded into 'retired' by the key destructor when it exits
+static int slot_counter_key = -1;
+static atomic_long slot_counter_retired;
+static volatile uintptr_t lookup_sink;
+
+static void slot_counter_init(void* data)
+{
+    atomic_init((atomic_long*) data, 0);
+}
+
+static void slot_counter_retire(void* data)
+{
+    atomic_fetch_add(&slot_counter_retired, atomic_load((atomic_long*) data));
+}
+
+static void slot_counter_visit(void* data, void* context)
+{
+    *(long*) context += atomic_load_explicit((atomic_long*) data,
+                                             memory_order_relaxed);
+}
+
+static long slot_counter_read(void)
+{
+    long total = atomic_load(&slot_counter_retired);
+    tls_for_each(slot_counter_key, slot_counter_visit, &total);
+    return total;
+}
+
+static void* slot_counter_thread(void* arg)
+{
+    long increments = *(long*) arg;
+    for (long i = 0; i < increments; i++)
+    {
+        atomic_long* counter = tls_get(slot_counter_key);
+        // Only this thread writes: a relaxed load/store, no locked RMW
+        atomic_store_explicit(
+            counter,
+            atomic_load_explicit(counter, memory_order_relaxed) + 1,
+            memory_order_relaxed);
+    }
+    return NULL;
+}
+
+// Compare lookup cost with pthread_getspecific and aggregate per-thread
+// counters through the slot registry
+void thread_slots_demo()
+{
+    printf("\n=== THREAD SLOTS DEMO ===\n");
+
+    const long lookups = 50000000;
+    pthread_key_t key;
+    int slot_key = tls_key_create(sizeof(long), NULL, NULL);
+    static long value;
+    struct timespec start;
+    uintptr_t sink = 0;
+
+    if (slot_key < 0 || pthread_key_create(&key, NULL) != 0)
+    {
+        printf("Could not create keys\n");
+        return;
+    }
+    pthread_setspecific(key, &value);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < lookups; i++)
+    {
+        sink += (uintptr_t) pthread_getspecific(key);
+        __asm__ __volatile__("" ::: "memory");  // Keep every lookup
+    }
+    double key_ns = elapsed_seconds(&start) * 1e9 / lookups;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < lookups; i++)
+    {
+        sink += (uintptr_t) tls_get(slot_key);
+        __asm__ __volatile__("" ::: "memory");
+    }
+    double slot_ns = elapsed_seconds(&start) * 1e9 / lookups;
+    pthread_key_delete(key);
+
+    printf("pthread_getspecific: %.2f ns/lookup\n", key_ns);
+    printf("tls_get:             %.2f ns/lookup\n", slot_ns);
+    lookup_sink = sink;
+
+    if (slot_counter_key < 0)
+    {
+        slot_counter_key = tls_key_create(
+            sizeof(atomic_long), slot_counter_init, slot_counter_retire);
+    }
 
-    // Destroy the key
-    pthread_key_delete(thread_log_key);
+    pthread_t threads[4];
+    long increments = 2000000;
+    long before = slot_counter_read();
+    for (int i = 0; i < 4; i++)
+    {
+        pthread_create(&threads[i], NULL, slot_counter_thread, &increments);
+    }
+    usleep(2000);
+    printf("Counter while threads run: %ld\n", slot_counter_read() - before);
+    for (int i = 0; i < 4; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    printf("Counter after join:        %ld (expected %ld)\n",
+           slot_counter_read() - before,
+           4 * increments);
 }
 
 int main()
@@ -338,6 +1946,9 @@ int main()
     thread_attributes_demo();
     thread_cancellation_demo();
     thread_specific_data_demo();
+    thread_slots_demo();
+    async_logger_demo();
+    executor_demo();
 
     return 0;
 }
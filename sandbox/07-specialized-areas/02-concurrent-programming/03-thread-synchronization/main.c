@@ -1,10 +1,22 @@
 
+#define _GNU_SOURCE
 #include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+// The demos' lock calls go through the prof_* wrappers; build with
+// -DLOCK_PROFILE to record contention and print a report at exit
+#include "../lock_profile.h"
+
+#define CACHE_LINE 64
+
 // Global data that will be shared between threads
 int shared_counter = 0;
 
@@ -55,10 +67,10 @@ void* increment_with_mutex(void* arg)
     // Update the counter with mutex protection
     for (int i = 0; i < 100000; i++)
     {
-        pthread_mutex_lock(&counter_mutex);
+        prof_mutex_lock(&counter_mutex);
         shared_counter++;
         local_counter++;
-        pthread_mutex_unlock(&counter_mutex);
+        prof_mutex_unlock(&counter_mutex);
     }
 
     printf("[Thread %d] Done. Added %d, counter = %d\n",
@@ -79,14 +91,14 @@ void* counter_worker(void* arg)
     // Increment the counter until threshold
     while (1)
     {
-        pthread_mutex_lock(&counter_mutex);
+        prof_mutex_lock(&counter_mutex);
 
         // Check if we need to increment or we're done
         if (shared_counter >= 10)
         {
             printf("[Worker %d] Counter reached threshold, exiting\n",
                    thread_id);
-            pthread_mutex_unlock(&counter_mutex);
+            prof_mutex_unlock(&counter_mutex);
             break;
         }
 
@@ -104,7 +116,7 @@ void* counter_worker(void* arg)
             pthread_cond_signal(&counter_threshold_cv);
         }
 
-        pthread_mutex_unlock(&counter_mutex);
+        prof_mutex_unlock(&counter_mutex);
 
         // Simulate work
         usleep(500000);  // 500ms
@@ -119,18 +131,18 @@ void* counter_watcher(void* arg)
     printf("[Watcher] Starting...\n");
 
     // Wait for the counter to reach the threshold
-    pthread_mutex_lock(&counter_mutex);
+    prof_mutex_lock(&counter_mutex);
 
     while (shared_counter < 10)
     {
         printf("[Watcher] Counter = %d, waiting for threshold...\n",
                shared_counter);
-        pthread_cond_wait(&counter_threshold_cv, &counter_mutex);
+        prof_cond_wait(&counter_threshold_cv, &counter_mutex);
     }
 
     printf("[Watcher] Received signal! Counter = %d\n", shared_counter);
 
-    pthread_mutex_unlock(&counter_mutex);
+    prof_mutex_unlock(&counter_mutex);
 
     return NULL;
 }
@@ -143,7 +155,7 @@ void* resource_user(void* arg)
     printf("[Thread %d] Waiting to access resource...\n", thread_id);
 
     // Wait for semaphore
-    sem_wait(&resource_semaphore);
+    prof_sem_wait(&resource_semaphore);
 
     printf("[Thread %d] Acquired resource, using it...\n", thread_id);
 
@@ -153,7 +165,7 @@ void* resource_user(void* arg)
     printf("[Thread %d] Finished using resource, releasing\n", thread_id);
 
     // Release semaphore
-    sem_post(&resource_semaphore);
+    prof_sem_post(&resource_semaphore);
 
     return NULL;
 }
@@ -167,7 +179,7 @@ void* reader_thread(void* arg)
     {
         // Acquire read lock
         printf("[Reader %d] Trying to acquire read lock...\n", thread_id);
-        pthread_rwlock_rdlock(&shared_data_lock);
+        prof_rwlock_rdlock(&shared_data_lock);
 
         // Read data
         printf("[Reader %d] Read lock acquired. Reading data: %d\n",
@@ -179,7 +191,7 @@ void* reader_thread(void* arg)
 
         // Release lock
         printf("[Reader %d] Releasing read lock\n", thread_id);
-        pthread_rwlock_unlock(&shared_data_lock);
+        prof_rwlock_unlock(&shared_data_lock);
 
         // Wait a bit before next read
         usleep((rand() % 500) * 1000);  // 0-500ms
@@ -200,7 +212,7 @@ void* writer_thread(void* arg)
 
         // Acquire write lock
         printf("[Writer %d] Trying to acquire write lock...\n", thread_id);
-        pthread_rwlock_wrlock(&shared_data_lock);
+        prof_rwlock_wrlock(&shared_data_lock);
 
         // Update data
         shared_data += 10 * thread_id;
@@ -213,7 +225,7 @@ void* writer_thread(void* arg)
 
         // Release lock
         printf("[Writer %d] Releasing write lock\n", thread_id);
-        pthread_rwlock_unlock(&shared_data_lock);
+        prof_rwlock_unlock(&shared_data_lock);
     }
 
     return NULL;
@@ -312,6 +324,522 @@ void condition_variable_demo()
     printf("All threads completed, final counter value: %d\n", shared_counter);
 }
 
+// Bounded MPMC queue (Vyukov-style cell array). Each cell carries a
+// sequence number that tells producers and consumers whether it is free
+// for the current lap, so the fast path is one CAS on a position counter
+// and no lock. Threads only block on the mutex/condvar pair when the queue
+// is empty or full, and the other side signals only if someone is parked.
+typedef struct
+{
+    atomic_size_t sequence;
+    void* item;
+} QueueCell;
+
+typedef struct
+{
+    _Alignas(CACHE_LINE) atomic_size_t enqueue_pos;
+    _Alignas(CACHE_LINE) atomic_size_t dequeue_pos;
+    _Alignas(CACHE_LINE) QueueCell* cells;
+    size_t mask;
+    atomic_int closed;
+
+    // Slow path, touched only when a side runs dry
+    _Alignas(CACHE_LINE) pthread_mutex_t park_lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    atomic_int consumers_parked;
+    atomic_int producers_parked;
+    atomic_long wakeups;  // Signals actually sent
+} MpmcQueue;
+
+#define MPMC_SPIN_TRIES 64
+
+// Capacity must be a power of two. Returns 0 on success.
+int mpmc_init(MpmcQueue* q, size_t capacity)
+{
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+    {
+        return -1;
+    }
+    q->cells = malloc(capacity * sizeof(QueueCell));
+    if (q->cells == NULL)
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < capacity; i++)
+    {
+        atomic_init(&q->cells[i].sequence, i);
+    }
+    q->mask = capacity - 1;
+    atomic_init(&q->enqueue_pos, 0);
+    atomic_init(&q->dequeue_pos, 0);
+    atomic_init(&q->closed, 0);
+    pthread_mutex_init(&q->park_lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+    atomic_init(&q->consumers_parked, 0);
+    atomic_init(&q->producers_parked, 0);
+    atomic_init(&q->wakeups, 0);
+    return 0;
+}
+
+void mpmc_destroy(MpmcQueue* q)
+{
+    pthread_mutex_destroy(&q->park_lock);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+    free(q->cells);
+}
+
+// Non-blocking batch enqueue: claims the run of free cells at the tail
+// with one CAS and returns how many items were stored (0 when full)
+size_t mpmc_try_enqueue(MpmcQueue* q, void* const* items, size_t count)
+{
+    size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+
+    for (;;)
+    {
+        size_t n = 0;
+        while (n < count)
+        {
+            QueueCell* cell = &q->cells[(pos + n) & q->mask];
+            size_t seq =
+                atomic_load_explicit(&cell->sequence, memory_order_acquire);
+            if (seq != pos + n)
+            {
+                break;
+            }
+            n++;
+        }
+
+        if (n == 0)
+        {
+            // Cell still holds last lap's item (full) or another producer
+            // moved the tail; re-read to tell the two apart
+            size_t now =
+                atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+            if (now == pos)
+            {
+                return 0;
+            }
+            pos = now;
+            continue;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos,
+                                                  &pos,
+                                                  pos + n,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed))
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                QueueCell* cell = &q->cells[(pos + i) & q->mask];
+                cell->item = items[i];
+                atomic_store_explicit(
+                    &cell->sequence, pos + i + 1, memory_order_release);
+            }
+            return n;
+        }
+    }
+}
+
+// Non-blocking batch dequeue: returns how many items were taken (0 when
+// empty)
+size_t mpmc_try_dequeue(MpmcQueue* q, void** items, size_t max)
+{
+    size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+
+    for (;;)
+    {
+        size_t n = 0;
+        while (n < max)
+        {
+            QueueCell* cell = &q->cells[(pos + n) & q->mask];
+            size_t seq =
+                atomic_load_explicit(&cell->sequence, memory_order_acquire);
+            if (seq != pos + n + 1)
+            {
+                break;
+            }
+            n++;
+        }
+
+        if (n == 0)
+        {
+            size_t now =
+                atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+            if (now == pos)
+            {
+                return 0;
+            }
+            pos = now;
+            continue;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&q->dequeue_pos,
+                                                  &pos,
+                                                  pos + n,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed))
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                QueueCell* cell = &q->cells[(pos + i) & q->mask];
+                items[i] = cell->item;
+                // Free the cell for the producer one lap ahead
+                atomic_store_explicit(&cell->sequence,
+                                      pos + i + q->mask + 1,
+                                      memory_order_release);
+            }
+            return n;
+        }
+    }
+}
+
+// Wake parked threads on the other side; a no-op (no lock, no syscall)
+// while nobody is parked
+static void mpmc_wake(MpmcQueue* q,
+                      atomic_int* parked,
+                      pthread_cond_t* cond,
+                      size_t count)
+{
+    // Pairs with the fence in mpmc_park: either we see the parked count
+    // or the parking thread sees our items
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(parked, memory_order_relaxed) == 0)
+    {
+        return;
+    }
+    pthread_mutex_lock(&q->park_lock);
+    if (count > 1)
+    {
+        pthread_cond_broadcast(cond);
+    }
+    else
+    {
+        pthread_cond_signal(cond);
+    }
+    pthread_mutex_unlock(&q->park_lock);
+    atomic_fetch_add_explicit(&q->wakeups, 1, memory_order_relaxed);
+}
+
+// Blocking enqueue of all 'count' items. Returns the number stored, which
+// is less than 'count' only if the queue was closed.
+size_t mpmc_push(MpmcQueue* q, void* const* items, size_t count)
+{
+    size_t done = 0;
+    int spins = 0;
+
+    while (done < count)
+    {
+        size_t n = mpmc_try_enqueue(q, items + done, count - done);
+        if (n > 0)
+        {
+            done += n;
+            spins = 0;
+            mpmc_wake(q, &q->consumers_parked, &q->not_empty, n);
+            continue;
+        }
+        if (atomic_load(&q->closed))
+        {
+            break;
+        }
+        if (++spins < MPMC_SPIN_TRIES)
+        {
+            sched_yield();
+            continue;
+        }
+
+        pthread_mutex_lock(&q->park_lock);
+        atomic_fetch_add(&q->producers_parked, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        n = mpmc_try_enqueue(q, items + done, count - done);
+        if (n == 0 && !atomic_load(&q->closed))
+        {
+            pthread_cond_wait(&q->not_full, &q->park_lock);
+        }
+        atomic_fetch_sub(&q->producers_parked, 1);
+        pthread_mutex_unlock(&q->park_lock);
+        if (n > 0)
+        {
+            done += n;
+            mpmc_wake(q, &q->consumers_parked, &q->not_empty, n);
+        }
+        spins = 0;
+    }
+    return done;
+}
+
+// Blocking batch dequeue: waits for at least one item and returns up to
+// 'max'. Returns 0 once the queue is closed and drained.
+size_t mpmc_pop(MpmcQueue* q, void** items, size_t max)
+{
+    int spins = 0;
+
+    for (;;)
+    {
+        size_t n = mpmc_try_dequeue(q, items, max);
+        if (n > 0)
+        {
+            mpmc_wake(q, &q->producers_parked, &q->not_full, n);
+            return n;
+        }
+        if (atomic_load(&q->closed))
+        {
+            // Producers may have pushed right before closing
+            return mpmc_try_dequeue(q, items, max);
+        }
+        if (++spins < MPMC_SPIN_TRIES)
+        {
+            sched_yield();
+            continue;
+        }
+
+        pthread_mutex_lock(&q->park_lock);
+        atomic_fetch_add(&q->consumers_parked, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        n = mpmc_try_dequeue(q, items, max);
+        if (n == 0 && !atomic_load(&q->closed))
+        {
+            pthread_cond_wait(&q->not_empty, &q->park_lock);
+        }
+        atomic_fetch_sub(&q->consumers_parked, 1);
+        pthread_mutex_unlock(&q->park_lock);
+        if (n > 0)
+        {
+            mpmc_wake(q, &q->producers_parked, &q->not_full, n);
+            return n;
+        }
+        spins = 0;
+    }
+}
+
+// Wake everyone; pushes fail and pops drain what is left
+void mpmc_close(MpmcQueue* q)
+{
+    pthread_mutex_lock(&q->park_lock);
+    atomic_store(&q->closed, 1);
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_cond_broadcast(&q->not_full);
+    pthread_mutex_unlock(&q->park_lock);
+}
+
+// Baseline: the classic one-slot handoff with a mutex and two condvars,
+// one signal per item
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t filled;
+    pthread_cond_t emptied;
+    void* item;
+    int full;
+    int closed;
+} HandoffSlot;
+
+#define PIPE_PRODUCERS 2
+#define PIPE_CONSUMERS 2
+#define PIPE_ITEMS_PER_PRODUCER 200000
+
+typedef struct
+{
+    HandoffSlot* slot;
+    MpmcQueue* queue;
+    size_t batch;
+    int producer_id;
+    uint64_t sum;  // Consumers: checksum of received items
+    long items;
+} PipeWorker;
+
+void* handoff_producer(void* arg)
+{
+    PipeWorker* w = arg;
+    HandoffSlot* s = w->slot;
+
+    for (long i = 1; i <= PIPE_ITEMS_PER_PRODUCER; i++)
+    {
+        pthread_mutex_lock(&s->lock);
+        while (s->full)
+        {
+            pthread_cond_wait(&s->emptied, &s->lock);
+        }
+        s->item = (void*) (uintptr_t) i;
+        s->full = 1;
+        pthread_cond_signal(&s->filled);
+        pthread_mutex_unlock(&s->lock);
+    }
+    return NULL;
+}
+
+void* handoff_consumer(void* arg)
+{
+    PipeWorker* w = arg;
+    HandoffSlot* s = w->slot;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&s->lock);
+        while (!s->full && !s->closed)
+        {
+            pthread_cond_wait(&s->filled, &s->lock);
+        }
+        if (!s->full)
+        {
+            pthread_mutex_unlock(&s->lock);
+            return NULL;
+        }
+        w->sum += (uintptr_t) s->item;
+        w->items++;
+        s->full = 0;
+        pthread_cond_signal(&s->emptied);
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+void* queue_producer(void* arg)
+{
+    PipeWorker* w = arg;
+    void* batch[64];
+    long next = 1;
+
+    while (next <= PIPE_ITEMS_PER_PRODUCER)
+    {
+        size_t n = 0;
+        while (n < w->batch && next <= PIPE_ITEMS_PER_PRODUCER)
+        {
+            batch[n++] = (void*) (uintptr_t) next++;
+        }
+        mpmc_push(w->queue, batch, n);
+    }
+    return NULL;
+}
+
+void* queue_consumer(void* arg)
+{
+    PipeWorker* w = arg;
+    void* batch[64];
+    size_t n;
+
+    while ((n = mpmc_pop(w->queue, batch, w->batch)) > 0)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            w->sum += (uintptr_t) batch[i];
+        }
+        w->items += n;
+    }
+    return NULL;
+}
+
+static double pipe_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Run one producer/consumer pipeline; batch 0 selects the handoff slot
+static void run_pipeline(const char* name, size_t batch)
+{
+    HandoffSlot slot = {.full = 0, .closed = 0};
+    MpmcQueue queue;
+    PipeWorker producers[PIPE_PRODUCERS];
+    PipeWorker consumers[PIPE_CONSUMERS];
+    pthread_t producer_threads[PIPE_PRODUCERS];
+    pthread_t consumer_threads[PIPE_CONSUMERS];
+
+    if (batch == 0)
+    {
+        pthread_mutex_init(&slot.lock, NULL);
+        pthread_cond_init(&slot.filled, NULL);
+        pthread_cond_init(&slot.emptied, NULL);
+    }
+    else if (mpmc_init(&queue, 1024) != 0)
+    {
+        printf("  %-22s queue allocation failed\n", name);
+        return;
+    }
+
+    double start = pipe_now();
+    for (int i = 0; i < PIPE_CONSUMERS; i++)
+    {
+        consumers[i] = (PipeWorker) {&slot, &queue, batch, 0, 0, 0};
+        pthread_create(&consumer_threads[i],
+                       NULL,
+                       batch == 0 ? handoff_consumer : queue_consumer,
+                       &consumers[i]);
+    }
+    for (int i = 0; i < PIPE_PRODUCERS; i++)
+    {
+        producers[i] = (PipeWorker) {&slot, &queue, batch, i, 0, 0};
+        pthread_create(&producer_threads[i],
+                       NULL,
+                       batch == 0 ? handoff_producer : queue_producer,
+                       &producers[i]);
+    }
+    for (int i = 0; i < PIPE_PRODUCERS; i++)
+    {
+        pthread_join(producer_threads[i], NULL);
+    }
+
+    if (batch == 0)
+    {
+        pthread_mutex_lock(&slot.lock);
+        slot.closed = 1;
+        pthread_cond_broadcast(&slot.filled);
+        pthread_mutex_unlock(&slot.lock);
+    }
+    else
+    {
+        mpmc_close(&queue);
+    }
+
+    uint64_t sum = 0;
+    long items = 0;
+    for (int i = 0; i < PIPE_CONSUMERS; i++)
+    {
+        pthread_join(consumer_threads[i], NULL);
+        sum += consumers[i].sum;
+        items += consumers[i].items;
+    }
+    double elapsed = pipe_now() - start;
+
+    uint64_t n = PIPE_ITEMS_PER_PRODUCER;
+    uint64_t expected = PIPE_PRODUCERS * (n * (n + 1) / 2);
+    printf("  %-22s %7.2f M items/s  %s",
+           name,
+           items / elapsed / 1e6,
+           sum == expected ? "checksum ok" : "CHECKSUM MISMATCH");
+
+    if (batch == 0)
+    {
+        printf("  (one signal per item)\n");
+        pthread_mutex_destroy(&slot.lock);
+        pthread_cond_destroy(&slot.filled);
+        pthread_cond_destroy(&slot.emptied);
+    }
+    else
+    {
+        printf("  (%ld wakeups)\n", atomic_load(&queue.wakeups));
+        mpmc_destroy(&queue);
+    }
+}
+
+// Compare the cond-var handoff with the MPMC queue at several batch sizes
+void mpmc_queue_demo()
+{
+    printf("\n=== BOUNDED MPMC QUEUE DEMO ===\n");
+    printf("%d producers x %d items -> %d consumers:\n",
+           PIPE_PRODUCERS,
+           PIPE_ITEMS_PER_PRODUCER,
+           PIPE_CONSUMERS);
+
+    run_pipeline("condvar handoff", 0);
+    run_pipeline("mpmc queue, batch 1", 1);
+    run_pipeline("mpmc queue, batch 16", 16);
+    run_pipeline("mpmc queue, batch 64", 64);
+}
+
 // Demonstrate semaphores
 void semaphore_demo()
 {
@@ -386,16 +914,380 @@ void rwlock_demo()
     printf("Final shared data value: %d\n", shared_data);
 }
 
+// Read-mostly data: a small routing table that readers consult constantly
+// and a writer replaces rarely. Every word is derived from 'version', so a
+// reader can tell if it ever saw a torn (half-updated) copy.
+#define ROUTE_WORDS 15
+
+typedef struct
+{
+    unsigned version;
+    unsigned routes[ROUTE_WORDS];
+} RouteTable;
+
+static void route_table_fill(RouteTable* table, unsigned version)
+{
+    table->version = version;
+    for (int i = 0; i < ROUTE_WORDS; i++)
+    {
+        table->routes[i] = version * 31 + i;
+    }
+}
+
+static int route_table_consistent(const RouteTable* table)
+{
+    for (int i = 0; i < ROUTE_WORDS; i++)
+    {
+        if (table->routes[i] != table->version * 31 + i)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Seqlock for small POD snapshots. The writer makes the sequence odd while
+// it updates; readers copy without writing anything shared and retry if
+// the sequence was odd or changed underneath them. The payload is kept as
+// relaxed atomic words so the racy copy is well-defined C.
+typedef struct
+{
+    _Alignas(CACHE_LINE) atomic_uint sequence;
+    atomic_uint words[sizeof(RouteTable) / sizeof(unsigned)];
+    pthread_mutex_t writer_lock;  // Serializes writers only
+} SeqLock;
+
+void seqlock_init(SeqLock* lock, const RouteTable* initial)
+{
+    const unsigned* src = (const unsigned*) initial;
+    atomic_init(&lock->sequence, 0);
+    for (size_t i = 0; i < sizeof(RouteTable) / sizeof(unsigned); i++)
+    {
+        atomic_init(&lock->words[i], src[i]);
+    }
+    pthread_mutex_init(&lock->writer_lock, NULL);
+}
+
+void seqlock_read(SeqLock* lock, RouteTable* out)
+{
+    unsigned* dst = (unsigned*) out;
+    unsigned before, after;
+
+    do
+    {
+        before = atomic_load_explicit(&lock->sequence, memory_order_acquire);
+        for (size_t i = 0; i < sizeof(RouteTable) / sizeof(unsigned); i++)
+        {
+            dst[i] =
+                atomic_load_explicit(&lock->words[i], memory_order_relaxed);
+        }
+        // Keep the copy from sinking below the second sequence read
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&lock->sequence, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+}
+
+void seqlock_write(SeqLock* lock, const RouteTable* table)
+{
+    const unsigned* src = (const unsigned*) table;
+
+    pthread_mutex_lock(&lock->writer_lock);
+    unsigned seq = atomic_load_explicit(&lock->sequence, memory_order_relaxed);
+    atomic_store_explicit(&lock->sequence, seq + 1, memory_order_relaxed);
+    // Readers must see the odd sequence before any new word
+    atomic_thread_fence(memory_order_release);
+    for (size_t i = 0; i < sizeof(RouteTable) / sizeof(unsigned); i++)
+    {
+        atomic_store_explicit(&lock->words[i], src[i], memory_order_relaxed);
+    }
+    atomic_store_explicit(&lock->sequence, seq + 2, memory_order_release);
+    pthread_mutex_unlock(&lock->writer_lock);
+}
+
+// Epoch-based RCU for pointer-published data. Readers announce the global
+// epoch in their own padded slot while they hold a pointer; a writer swaps
+// the pointer, advances the epoch and waits until every reader is idle or
+// has announced the new epoch before freeing the old copy. Readers never
+// write a shared cache line.
+#define RCU_MAX_READERS 64
+#define RCU_IDLE 0
+
+typedef struct
+{
+    _Alignas(CACHE_LINE) atomic_ulong epoch;  // RCU_IDLE when not reading
+} RcuReaderSlot;
+
+typedef struct
+{
+    _Alignas(CACHE_LINE) _Atomic(RouteTable*) current;
+    _Alignas(CACHE_LINE) atomic_ulong epoch;
+    atomic_int reader_count;
+    pthread_mutex_t writer_lock;
+    RcuReaderSlot readers[RCU_MAX_READERS];
+} RcuDomain;
+
+static _Thread_local RcuReaderSlot* rcu_slot;
+
+void rcu_init(RcuDomain* rcu, RouteTable* initial)
+{
+    atomic_init(&rcu->current, initial);
+    atomic_init(&rcu->epoch, 1);
+    atomic_init(&rcu->reader_count, 0);
+    pthread_mutex_init(&rcu->writer_lock, NULL);
+    for (int i = 0; i < RCU_MAX_READERS; i++)
+    {
+        atomic_init(&rcu->readers[i].epoch, RCU_IDLE);
+    }
+}
+
+// Each reading thread registers once. Returns 0 on success.
+int rcu_register_reader(RcuDomain* rcu)
+{
+    int index = atomic_fetch_add(&rcu->reader_count, 1);
+    if (index >= RCU_MAX_READERS)
+    {
+        return -1;
+    }
+    rcu_slot = &rcu->readers[index];
+    return 0;
+}
+
+const RouteTable* rcu_read_lock(RcuDomain* rcu)
+{
+    unsigned long epoch =
+        atomic_load_explicit(&rcu->epoch, memory_order_relaxed);
+    atomic_store_explicit(&rcu_slot->epoch, epoch, memory_order_relaxed);
+    // The announcement must be visible before the pointer is read; this
+    // is the one full fence on the read side (StoreLoad ordering)
+    atomic_thread_fence(memory_order_seq_cst);
+    return atomic_load_explicit(&rcu->current, memory_order_acquire);
+}
+
+void rcu_read_unlock(RcuDomain* rcu)
+{
+    (void) rcu;
+    atomic_store_explicit(&rcu_slot->epoch, RCU_IDLE, memory_order_release);
+}
+
+// Publish a new table and return the old one once no reader can still be
+// using it, ready to be freed
+RouteTable* rcu_replace(RcuDomain* rcu, RouteTable* table)
+{
+    pthread_mutex_lock(&rcu->writer_lock);
+    RouteTable* old =
+        atomic_exchange_explicit(&rcu->current, table, memory_order_acq_rel);
+    unsigned long next =
+        atomic_fetch_add_explicit(&rcu->epoch, 1, memory_order_seq_cst) + 1;
+
+    // Grace period: readers that announced an older epoch may hold 'old'
+    int count = atomic_load(&rcu->reader_count);
+    for (int i = 0; i < count && i < RCU_MAX_READERS; i++)
+    {
+        for (;;)
+        {
+            unsigned long e = atomic_load_explicit(&rcu->readers[i].epoch,
+                                                   memory_order_acquire);
+            if (e == RCU_IDLE || e >= next)
+            {
+                break;
+            }
+            sched_yield();
+        }
+    }
+    pthread_mutex_unlock(&rcu->writer_lock);
+    return old;
+}
+
+typedef enum
+{
+    READ_RWLOCK,
+    READ_SEQLOCK,
+    READ_RCU
+} ReadScheme;
+
+typedef struct
+{
+    ReadScheme scheme;
+    pthread_rwlock_t rwlock;
+    RouteTable locked_table;
+    SeqLock seqlock;
+    RcuDomain rcu;
+    atomic_int stop;
+    atomic_long reads;
+    atomic_long torn;
+    atomic_long writes;
+} ReadBench;
+
+void* read_bench_reader(void* arg)
+{
+    ReadBench* b = arg;
+    long reads = 0;
+    long torn = 0;
+    unsigned checksum = 0;
+
+    if (b->scheme == READ_RCU && rcu_register_reader(&b->rcu) != 0)
+    {
+        return NULL;
+    }
+
+    while (!atomic_load_explicit(&b->stop, memory_order_relaxed))
+    {
+        RouteTable copy;
+        const RouteTable* t = &copy;
+
+        switch (b->scheme)
+        {
+        case READ_RWLOCK:
+            pthread_rwlock_rdlock(&b->rwlock);
+            copy = b->locked_table;
+            pthread_rwlock_unlock(&b->rwlock);
+            break;
+        case READ_SEQLOCK:
+            seqlock_read(&b->seqlock, &copy);
+            break;
+        case READ_RCU:
+            t = rcu_read_lock(&b->rcu);
+            break;
+        }
+
+        // Look up a "route" and validate the whole snapshot
+        checksum += t->routes[reads % ROUTE_WORDS];
+        torn += !route_table_consistent(t);
+
+        if (b->scheme == READ_RCU)
+        {
+            rcu_read_unlock(&b->rcu);
+        }
+        reads++;
+    }
+
+    atomic_fetch_add(&b->reads, reads);
+    atomic_fetch_add(&b->torn, torn + (checksum == 1));  // Keep 'checksum'
+    return NULL;
+}
+
+void* read_bench_writer(void* arg)
+{
+    ReadBench* b = arg;
+    unsigned version = 1;
+
+    while (!atomic_load_explicit(&b->stop, memory_order_relaxed))
+    {
+        usleep(1000);  // Rare updates: about a thousand per second
+        version++;
+
+        switch (b->scheme)
+        {
+        case READ_RWLOCK:
+            pthread_rwlock_wrlock(&b->rwlock);
+            route_table_fill(&b->locked_table, version);
+            pthread_rwlock_unlock(&b->rwlock);
+            break;
+        case READ_SEQLOCK:
+        {
+            RouteTable table;
+            route_table_fill(&table, version);
+            seqlock_write(&b->seqlock, &table);
+            break;
+        }
+        case READ_RCU:
+        {
+            RouteTable* table = malloc(sizeof(RouteTable));
+            if (table == NULL)
+            {
+                continue;
+            }
+            route_table_fill(table, version);
+            free(rcu_replace(&b->rcu, table));
+            break;
+        }
+        }
+        atomic_fetch_add(&b->writes, 1);
+    }
+    return NULL;
+}
+
+// Benchmark rwlock, seqlock and RCU on the same read-mostly workload
+void read_mostly_benchmark()
+{
+    printf("\n=== READ-MOSTLY BENCHMARK: RWLOCK vs SEQLOCK vs RCU ===\n");
+
+    const char* names[] = {"pthread_rwlock", "seqlock", "epoch RCU"};
+    static ReadBench bench;
+
+    printf("Readers look up routes for 200 ms while a writer replaces the\n"
+           "table about every millisecond. Fewer updates than expected\n"
+           "means readers starved the writer:\n");
+
+    for (int readers = 1; readers <= 4; readers *= 2)
+    {
+        for (int s = READ_RWLOCK; s <= READ_RCU; s++)
+        {
+            memset(&bench, 0, sizeof(bench));
+            bench.scheme = (ReadScheme) s;
+            pthread_rwlock_init(&bench.rwlock, NULL);
+            route_table_fill(&bench.locked_table, 1);
+            seqlock_init(&bench.seqlock, &bench.locked_table);
+            RouteTable* initial = malloc(sizeof(RouteTable));
+            if (initial == NULL)
+            {
+                return;
+            }
+            route_table_fill(initial, 1);
+            rcu_init(&bench.rcu, initial);
+
+            pthread_t reader_threads[readers];
+            pthread_t writer;
+            for (int i = 0; i < readers; i++)
+            {
+                pthread_create(
+                    &reader_threads[i], NULL, read_bench_reader, &bench);
+            }
+            pthread_create(&writer, NULL, read_bench_writer, &bench);
+
+            usleep(200000);
+            atomic_store(&bench.stop, 1);
+            for (int i = 0; i < readers; i++)
+            {
+                pthread_join(reader_threads[i], NULL);
+            }
+            pthread_join(writer, NULL);
+
+            free(atomic_load(&bench.rcu.current));
+            pthread_rwlock_destroy(&bench.rwlock);
+            pthread_mutex_destroy(&bench.seqlock.writer_lock);
+            pthread_mutex_destroy(&bench.rcu.writer_lock);
+
+            printf("  %d reader%s %-15s %8.2f M reads/s, %4ld updates, "
+                   "%ld torn\n",
+                   readers,
+                   readers == 1 ? " " : "s",
+                   names[s],
+                   atomic_load(&bench.reads) / 0.2 / 1e6,
+                   atomic_load(&bench.writes),
+                   atomic_load(&bench.torn));
+        }
+    }
+}
+
 int main()
 {
     printf("==== THREAD SYNCHRONIZATION DEMONSTRATION ====\n");
 
+    // Names for the contention report (no-ops unless LOCK_PROFILE)
+    prof_name(&counter_mutex, PROF_LOCK_MUTEX, "counter_mutex");
+    prof_name(&resource_semaphore, PROF_LOCK_SEMAPHORE, "resource_semaphore");
+    prof_name(&shared_data_lock, PROF_LOCK_RWLOCK, "shared_data_lock");
+
     // Run demonstrations
     data_race_demo();
     mutex_demo();
     condition_variable_demo();
+    mpmc_queue_demo();
     semaphore_demo();
     rwlock_demo();
+    read_mostly_benchmark();
+    prof_print_report();
 
     // Clean up synchronization primitives
     pthread_mutex_destroy(&counter_mutex);
@@ -1,11 +1,21 @@
+#define _GNU_SOURCE
+#include <linux/futex.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
 #include <time.h>
 #include <unistd.h>
 
+// The spinlock demo goes through the prof_* wrappers; build with
+// -DLOCK_PROFILE to record contention and print a report at exit
+#include "../../01-low-level-programming/cpu_primitives.h"
+#include "../lock_profile.h"
+
 // Global counter variables
 int non_atomic_counter = 0;
 atomic_int atomic_counter = 0;
@@ -159,13 +169,9 @@ void* spinlock_thread(void* arg)
 
     printf("[Thread %d] Trying to acquire spinlock\n", thread_id);
 
-    // Try to acquire the spinlock by setting the flag
-    while (atomic_flag_test_and_set(&exit_flag))
-    {
-        // If flag was already set, we spin and try again
-        printf("[Thread %d] Spinlock busy, spinning...\n", thread_id);
-        usleep(500000);  // 500ms
-    }
+    // Try to acquire the spinlock by setting the flag; while it is
+    // already set we spin, then yield and nap between attempts
+    prof_spin_lock(&exit_flag);
 
     // We have the spinlock now
     printf("[Thread %d] Acquired spinlock, working...\n", thread_id);
@@ -175,7 +181,7 @@ void* spinlock_thread(void* arg)
 
     // Release the spinlock
     printf("[Thread %d] Releasing spinlock\n", thread_id);
-    atomic_flag_clear(&exit_flag);
+    prof_spin_unlock(&exit_flag);
 
     return NULL;
 }
@@ -244,6 +250,569 @@ void atomic_counter_demo()
     printf("With atomic operations, the result should be exactly 4,000,000\n");
 }
 
+// Sharded counter: increments go to one of many cache-line-sized slots, so
+// threads updating the same logical counter do not fight over one line.
+// Reading sums the slots.
+#define COUNTER_SHARDS 64  // Power of two
+#define CACHE_LINE 64
+
+typedef struct
+{
+    _Alignas(CACHE_LINE) atomic_long value;
+} CounterShard;
+
+typedef struct
+{
+    CounterShard shards[COUNTER_SHARDS];
+} ShardedCounter;
+
+// Threads get slots round-robin on first use. Slots can be shared once
+// there are more threads than shards, so updates stay atomic, but an
+// uncontended relaxed add never leaves the core's own cache.
+static atomic_int next_counter_slot = 0;
+static _Thread_local int counter_slot = -1;
+
+void sharded_counter_init(ShardedCounter* counter)
+{
+    for (int i = 0; i < COUNTER_SHARDS; i++)
+    {
+        atomic_init(&counter->shards[i].value, 0);
+    }
+}
+
+static inline int counter_thread_slot()
+{
+    if (counter_slot < 0)
+    {
+        counter_slot = atomic_fetch_add_explicit(
+                           &next_counter_slot, 1, memory_order_relaxed)
+                       & (COUNTER_SHARDS - 1);
+    }
+    return counter_slot;
+}
+
+// Per-thread slot
+static inline void sharded_counter_add(ShardedCounter* counter, long delta)
+{
+    atomic_fetch_add_explicit(&counter->shards[counter_thread_slot()].value,
+                              delta,
+                              memory_order_relaxed);
+}
+
+// Per-CPU slot: threads running on the same CPU share a line, which stays
+// in that CPU's cache; falls back to the thread slot if the CPU is unknown
+static inline void sharded_counter_add_percpu(ShardedCounter* counter,
+                                              long delta)
+{
+    int cpu = sched_getcpu();
+    int slot = cpu >= 0 ? cpu & (COUNTER_SHARDS - 1) : counter_thread_slot();
+    atomic_fetch_add_explicit(
+        &counter->shards[slot].value, delta, memory_order_relaxed);
+}
+
+// Sum of all slots. While increments are in flight the result lies
+// between the counter's value when the read started and when it ended;
+// once writers are quiescent (e.g. after join) it is exact.
+long sharded_counter_read(ShardedCounter* counter)
+{
+    long sum = 0;
+    for (int i = 0; i < COUNTER_SHARDS; i++)
+    {
+        sum += atomic_load_explicit(&counter->shards[i].value,
+                                    memory_order_relaxed);
+    }
+    return sum;
+}
+
+typedef enum
+{
+    COUNT_MUTEX,
+    COUNT_ATOMIC,
+    COUNT_SHARDED,
+    COUNT_PERCPU
+} CounterKind;
+
+typedef struct
+{
+    CounterKind kind;
+    long iterations;
+    pthread_barrier_t* start;
+    pthread_mutex_t* mutex;
+    long* plain;
+    atomic_long* shared;
+    ShardedCounter* sharded;
+} CounterBenchArgs;
+
+void* counter_bench_thread(void* arg)
+{
+    CounterBenchArgs* a = arg;
+
+    pthread_barrier_wait(a->start);
+    for (long i = 0; i < a->iterations; i++)
+    {
+        switch (a->kind)
+        {
+        case COUNT_MUTEX:
+            pthread_mutex_lock(a->mutex);
+            (*a->plain)++;
+            pthread_mutex_unlock(a->mutex);
+            break;
+        case COUNT_ATOMIC:
+            atomic_fetch_add(a->shared, 1);
+            break;
+        case COUNT_SHARDED:
+            sharded_counter_add(a->sharded, 1);
+            break;
+        case COUNT_PERCPU:
+            sharded_counter_add_percpu(a->sharded, 1);
+            break;
+        }
+    }
+    return NULL;
+}
+
+// Run one counter kind with the given thread count; returns Mops/s and
+// stores the final count
+double counter_bench_run(CounterKind kind,
+                         int threads,
+                         long iterations,
+                         long* total)
+{
+    pthread_t tids[threads];
+    pthread_barrier_t start;
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    long plain = 0;
+    atomic_long shared = 0;
+    static ShardedCounter sharded;  // 4 KiB, keep it off the stack
+    CounterBenchArgs args = {
+        kind, iterations, &start, &mutex, &plain, &shared, &sharded};
+
+    sharded_counter_init(&sharded);
+    pthread_barrier_init(&start, NULL, threads + 1);
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_create(&tids[i], NULL, counter_bench_thread, &args);
+    }
+
+    struct timespec t0, t1;
+    pthread_barrier_wait(&start);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_join(tids[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    pthread_barrier_destroy(&start);
+
+    switch (kind)
+    {
+    case COUNT_MUTEX:
+        *total = plain;
+        break;
+    case COUNT_ATOMIC:
+        *total = atomic_load(&shared);
+        break;
+    default:
+        *total = sharded_counter_read(&sharded);
+        break;
+    }
+
+    double seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    return threads * iterations / seconds / 1e6;
+}
+
+// Benchmark of counter implementations at increasing thread counts
+void sharded_counter_demo()
+{
+    printf("\n=== SHARDED COUNTER DEMONSTRATION ===\n");
+
+    const long iterations = 500000;
+    const char* names[] = {"mutex", "atomic_fetch_add", "sharded", "per-cpu"};
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    printf("%ld increments per thread, %ld CPUs online (Mops/s):\n",
+           iterations,
+           cpus);
+    printf("%-8s", "threads");
+    for (int k = 0; k < 4; k++)
+    {
+        printf("%18s", names[k]);
+    }
+    printf("\n");
+
+    for (int threads = 1; threads <= 32; threads *= 2)
+    {
+        printf("%-8d", threads);
+        for (int k = 0; k < 4; k++)
+        {
+            long total;
+            double rate =
+                counter_bench_run((CounterKind) k, threads, iterations, &total);
+            printf("%17.1f%s", rate, total == threads * iterations ? " " : "!");
+        }
+        printf("\n");
+    }
+    printf("('!' marks a final count that is not exact)\n");
+}
+
+// Lock implementations. All of them spin politely: cpu_relax() (from
+// cpu_primitives.h) tells the core a spin-wait is in progress, and after
+// SPIN_LIMIT pauses a waiter yields so a preempted lock holder can run
+// when threads outnumber CPUs.
+
+#define SPIN_LIMIT 1024
+
+static inline void spin_pause(unsigned* spent, unsigned pauses)
+{
+    for (unsigned i = 0; i < pauses; i++)
+    {
+        cpu_relax();
+    }
+    *spent += pauses;
+    if (*spent >= SPIN_LIMIT)
+    {
+        *spent = 0;
+        sched_yield();
+    }
+}
+
+// Ticket lock: FIFO by construction. Each waiter takes a number and spins
+// reading 'serving', backing off in proportion to its place in line.
+typedef struct
+{
+    _Alignas(CACHE_LINE) atomic_uint next;
+    _Alignas(CACHE_LINE) atomic_uint serving;
+} TicketLock;
+
+void ticket_lock(TicketLock* lock)
+{
+    unsigned ticket =
+        atomic_fetch_add_explicit(&lock->next, 1, memory_order_relaxed);
+    unsigned spins = 0;
+
+    for (;;)
+    {
+        unsigned serving =
+            atomic_load_explicit(&lock->serving, memory_order_acquire);
+        if (serving == ticket)
+        {
+            return;
+        }
+        spin_pause(&spins, (ticket - serving) * 16);
+    }
+}
+
+void ticket_unlock(TicketLock* lock)
+{
+    // Only the holder writes 'serving', so a plain increment is enough
+    unsigned serving =
+        atomic_load_explicit(&lock->serving, memory_order_relaxed);
+    atomic_store_explicit(&lock->serving, serving + 1, memory_order_release);
+}
+
+// MCS queue lock: waiters form a linked list and each spins on its own
+// node, so a release touches exactly one other cache line. The node is
+// owned by the caller (usually on the stack) for the duration of the hold.
+typedef struct McsNode
+{
+    _Alignas(CACHE_LINE) _Atomic(struct McsNode*) next;
+    atomic_int locked;
+} McsNode;
+
+typedef struct
+{
+    _Atomic(McsNode*) tail;
+} McsLock;
+
+void mcs_lock(McsLock* lock, McsNode* node)
+{
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+    atomic_store_explicit(&node->locked, 1, memory_order_relaxed);
+
+    McsNode* prev =
+        atomic_exchange_explicit(&lock->tail, node, memory_order_acq_rel);
+    if (prev == NULL)
+    {
+        return;  // Lock was free
+    }
+
+    atomic_store_explicit(&prev->next, node, memory_order_release);
+    unsigned spins = 0;
+    while (atomic_load_explicit(&node->locked, memory_order_acquire))
+    {
+        spin_pause(&spins, 1);
+    }
+}
+
+void mcs_unlock(McsLock* lock, McsNode* node)
+{
+    McsNode* next = atomic_load_explicit(&node->next, memory_order_acquire);
+    if (next == NULL)
+    {
+        // No visible successor: try to swing tail back to empty
+        McsNode* expected = node;
+        if (atomic_compare_exchange_strong_explicit(&lock->tail,
+                                                    &expected,
+                                                    NULL,
+                                                    memory_order_release,
+                                                    memory_order_relaxed))
+        {
+            return;
+        }
+
+        // A successor is between its exchange and linking itself in
+        unsigned spins = 0;
+        while ((next = atomic_load_explicit(&node->next, memory_order_acquire))
+               == NULL)
+        {
+            spin_pause(&spins, 1);
+        }
+    }
+    atomic_store_explicit(&next->locked, 0, memory_order_release);
+}
+
+// Adaptive mutex: spin briefly with exponential backoff in the hope that
+// the holder is about to release, then sleep on a futex. State is 0 when
+// unlocked, 1 when locked and 2 when locked with possible sleepers, so an
+// uncontended unlock needs no system call.
+#define ADAPTIVE_SPINS 100
+
+typedef struct
+{
+    atomic_int state;
+    atomic_long parks;  // Times a thread went to sleep
+} AdaptiveMutex;
+
+static void futex_wait(atomic_int* address, int expected)
+{
+    syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static void futex_wake(atomic_int* address, int count)
+{
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+void adaptive_lock(AdaptiveMutex* mutex)
+{
+    int c = 0;
+    if (atomic_compare_exchange_strong_explicit(
+            &mutex->state, &c, 1, memory_order_acquire, memory_order_relaxed))
+    {
+        return;
+    }
+
+    // Spin phase: test before test-and-set, so waiting stays read-only
+    unsigned backoff = 1;
+    for (int i = 0; i < ADAPTIVE_SPINS; i++)
+    {
+        for (unsigned j = 0; j < backoff; j++)
+        {
+            cpu_relax();
+        }
+        if (backoff < 64)
+        {
+            backoff *= 2;
+        }
+
+        c = atomic_load_explicit(&mutex->state, memory_order_relaxed);
+        if (c == 0
+            && atomic_compare_exchange_weak_explicit(&mutex->state,
+                                                     &c,
+                                                     1,
+                                                     memory_order_acquire,
+                                                     memory_order_relaxed))
+        {
+            return;
+        }
+        if (c == 2)
+        {
+            break;  // Others are already asleep: don't jump the queue
+        }
+    }
+
+    // Park phase: mark the lock contended and sleep until it is free
+    c = atomic_exchange_explicit(&mutex->state, 2, memory_order_acquire);
+    while (c != 0)
+    {
+        atomic_fetch_add_explicit(&mutex->parks, 1, memory_order_relaxed);
+        futex_wait(&mutex->state, 2);
+        c = atomic_exchange_explicit(&mutex->state, 2, memory_order_acquire);
+    }
+}
+
+void adaptive_unlock(AdaptiveMutex* mutex)
+{
+    if (atomic_fetch_sub_explicit(&mutex->state, 1, memory_order_release)
+        != 1)
+    {
+        // State was 2: someone may be sleeping
+        atomic_store_explicit(&mutex->state, 0, memory_order_release);
+        futex_wake(&mutex->state, 1);
+    }
+}
+
+typedef enum
+{
+    LOCK_PTHREAD,
+    LOCK_FLAG,
+    LOCK_TICKET,
+    LOCK_MCS,
+    LOCK_ADAPTIVE,
+    LOCK_KINDS
+} LockKind;
+
+typedef struct
+{
+    LockKind kind;
+    long iterations;
+    pthread_barrier_t* start;
+    pthread_mutex_t pthread_mutex;
+    atomic_flag flag;
+    TicketLock ticket;
+    McsLock mcs;
+    AdaptiveMutex adaptive;
+    long shared[16];  // Protected data: two cache lines
+} LockBench;
+
+static void lock_bench_critical(LockBench* b)
+{
+    for (int i = 0; i < 16; i += 8)
+    {
+        b->shared[i]++;
+    }
+}
+
+void* lock_bench_thread(void* arg)
+{
+    LockBench* b = arg;
+    McsNode node;
+
+    pthread_barrier_wait(b->start);
+    for (long i = 0; i < b->iterations; i++)
+    {
+        switch (b->kind)
+        {
+        case LOCK_PTHREAD:
+            pthread_mutex_lock(&b->pthread_mutex);
+            lock_bench_critical(b);
+            pthread_mutex_unlock(&b->pthread_mutex);
+            break;
+        case LOCK_FLAG:
+            // The spinlock_thread pattern without the sleeps: a bare
+            // test-and-set loop (yielding only to survive oversubscription)
+            for (unsigned spins = 1; atomic_flag_test_and_set(&b->flag);
+                 spins++)
+            {
+                if (spins % SPIN_LIMIT == 0)
+                {
+                    sched_yield();
+                }
+            }
+            lock_bench_critical(b);
+            atomic_flag_clear(&b->flag);
+            break;
+        case LOCK_TICKET:
+            ticket_lock(&b->ticket);
+            lock_bench_critical(b);
+            ticket_unlock(&b->ticket);
+            break;
+        case LOCK_MCS:
+            mcs_lock(&b->mcs, &node);
+            lock_bench_critical(b);
+            mcs_unlock(&b->mcs, &node);
+            break;
+        default:
+            adaptive_lock(&b->adaptive);
+            lock_bench_critical(b);
+            adaptive_unlock(&b->adaptive);
+            break;
+        }
+    }
+    return NULL;
+}
+
+// Contention benchmark: every thread hammers one lock around a tiny
+// critical section. Reports Mops/s and whether the count came out exact.
+// FIFO spin locks (ticket, MCS) are skipped when threads outnumber CPUs:
+// handing the lock to a preempted waiter stalls the whole queue for a
+// scheduler time slice, which is exactly why they need real cores.
+void lock_contention_demo()
+{
+    printf("\n=== LOCK CONTENTION BENCHMARK ===\n");
+
+    const char* names[] = {
+        "pthread_mutex", "atomic_flag", "ticket", "MCS", "adaptive"};
+    const long total_ops = 400000;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    static LockBench bench;
+
+    printf("%ld lock/unlock pairs split across threads, %ld CPUs (Mops/s):\n",
+           total_ops,
+           cpus);
+    printf("%-8s", "threads");
+    for (int k = 0; k < LOCK_KINDS; k++)
+    {
+        printf("%15s", names[k]);
+    }
+    printf("%15s\n", "adaptive parks");
+
+    for (int threads = 1; threads <= 8; threads *= 2)
+    {
+        long parks = 0;
+        printf("%-8d", threads);
+        for (int k = 0; k < LOCK_KINDS; k++)
+        {
+            if ((k == LOCK_TICKET || k == LOCK_MCS) && threads > cpus)
+            {
+                printf("%15s", "-");
+                continue;
+            }
+
+            pthread_t tids[threads];
+            pthread_barrier_t start;
+
+            memset(&bench, 0, sizeof(bench));
+            bench.kind = (LockKind) k;
+            bench.iterations = total_ops / threads;
+            bench.start = &start;
+            pthread_mutex_init(&bench.pthread_mutex, NULL);
+            atomic_flag_clear(&bench.flag);
+            pthread_barrier_init(&start, NULL, threads + 1);
+
+            for (int i = 0; i < threads; i++)
+            {
+                pthread_create(&tids[i], NULL, lock_bench_thread, &bench);
+            }
+
+            struct timespec t0, t1;
+            pthread_barrier_wait(&start);
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            for (int i = 0; i < threads; i++)
+            {
+                pthread_join(tids[i], NULL);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            pthread_barrier_destroy(&start);
+            pthread_mutex_destroy(&bench.pthread_mutex);
+
+            double seconds =
+                (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+            long done = bench.iterations * threads;
+            printf("%14.2f%s",
+                   done / seconds / 1e6,
+                   bench.shared[0] == done && bench.shared[8] == done ? " "
+                                                                       : "!");
+            if (k == LOCK_ADAPTIVE)
+            {
+                parks = atomic_load(&bench.adaptive.parks);
+            }
+        }
+        printf("%15ld\n", parks);
+    }
+    printf("('!' marks a lost update, '-' an oversubscribed FIFO lock)\n");
+}
+
 // Demonstration of atomic compare-exchange operations
 void compare_exchange_demo()
 {
@@ -302,6 +871,326 @@ void memory_ordering_demo()
     printf("Final atomic counter value: %d\n", atomic_load(&atomic_counter));
 }
 
+// Cost of each memory ordering, measured rather than described. On x86
+// acquire loads and release stores compile to plain moves and only seq_cst
+// stores (xchg) and seq_cst fences (mfence) add a barrier; on AArch64
+// acquire/release map to ldar/stlr and fences to dmb, so the gaps differ.
+static atomic_long order_cell;
+static long order_sink;  // Keeps loaded values observable
+
+static double timespec_ns(const struct timespec* t0, const struct timespec* t1)
+{
+    return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+// Defines a function timing 'n' repetitions of one statement, in ns/op
+#define ORDER_BENCH(fn, stmt)                           \
+    static double fn(long n)                            \
+    {                                                   \
+        long sink = 0;                                  \
+        struct timespec t0, t1;                         \
+        atomic_store(&order_cell, 0);                   \
+        clock_gettime(CLOCK_MONOTONIC, &t0);            \
+        for (long i = 0; i < n; i++)                    \
+        {                                               \
+            stmt;                                       \
+        }                                               \
+        clock_gettime(CLOCK_MONOTONIC, &t1);            \
+        order_sink += sink;                             \
+        return timespec_ns(&t0, &t1) / n;               \
+    }
+
+#define LOAD_AS(mo) sink += atomic_load_explicit(&order_cell, mo)
+#define STORE_AS(mo) atomic_store_explicit(&order_cell, i, mo)
+#define ADD_AS(mo) sink += atomic_fetch_add_explicit(&order_cell, 1, mo)
+#define CAS_AS(mo, fail)                                          \
+    do                                                            \
+    {                                                             \
+        long expected = i;                                        \
+        sink += atomic_compare_exchange_strong_explicit(          \
+            &order_cell, &expected, i + 1, mo, fail);             \
+    } while (0)
+
+ORDER_BENCH(bench_barrier, atomic_signal_fence(memory_order_seq_cst))
+ORDER_BENCH(bench_load_relaxed, LOAD_AS(memory_order_relaxed))
+ORDER_BENCH(bench_load_acquire, LOAD_AS(memory_order_acquire))
+ORDER_BENCH(bench_load_seq_cst, LOAD_AS(memory_order_seq_cst))
+ORDER_BENCH(bench_store_relaxed, STORE_AS(memory_order_relaxed))
+ORDER_BENCH(bench_store_release, STORE_AS(memory_order_release))
+ORDER_BENCH(bench_store_seq_cst, STORE_AS(memory_order_seq_cst))
+ORDER_BENCH(bench_add_relaxed, ADD_AS(memory_order_relaxed))
+ORDER_BENCH(bench_add_acq_rel, ADD_AS(memory_order_acq_rel))
+ORDER_BENCH(bench_add_seq_cst, ADD_AS(memory_order_seq_cst))
+ORDER_BENCH(bench_cas_relaxed,
+            CAS_AS(memory_order_relaxed, memory_order_relaxed))
+ORDER_BENCH(bench_cas_acq_rel,
+            CAS_AS(memory_order_acq_rel, memory_order_acquire))
+ORDER_BENCH(bench_cas_seq_cst,
+            CAS_AS(memory_order_seq_cst, memory_order_seq_cst))
+ORDER_BENCH(bench_fence_acq_rel, atomic_thread_fence(memory_order_acq_rel))
+ORDER_BENCH(bench_fence_seq_cst, atomic_thread_fence(memory_order_seq_cst))
+ORDER_BENCH(bench_cpu_release_fence, cpu_release_fence())
+ORDER_BENCH(bench_cpu_full_fence, cpu_full_fence())
+
+// Create a thread, pinned to 'cpu' unless it is negative
+static int create_pinned(pthread_t* thread,
+                         int cpu,
+                         void* (*func)(void*),
+                         void* arg)
+{
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    }
+    int rc = pthread_create(thread, &attr, func, arg);
+    pthread_attr_destroy(&attr);
+    return rc;
+}
+
+// CPUs this process may run on (containers often allow fewer than are
+// online). Returns how many were stored.
+static int allowed_cpus(int* cpus, int max)
+{
+    cpu_set_t set;
+    int count = 0;
+
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+    {
+        return 0;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE && count < max; cpu++)
+    {
+        if (CPU_ISSET(cpu, &set))
+        {
+            cpus[count++] = cpu;
+        }
+    }
+    return count;
+}
+
+// False sharing: two threads bump their own counters with a plain
+// load/store (no RMW), so any slowdown comes from the line bouncing
+static _Alignas(128) atomic_long sharing_slots[32];
+
+typedef struct
+{
+    atomic_long* counter;
+    long iterations;
+} SharingArgs;
+
+void* sharing_thread(void* arg)
+{
+    SharingArgs* a = arg;
+
+    for (long i = 0; i < a->iterations; i++)
+    {
+        long v = atomic_load_explicit(a->counter, memory_order_relaxed);
+        atomic_store_explicit(a->counter, v + 1, memory_order_relaxed);
+    }
+    return NULL;
+}
+
+// Returns ns per increment with the second counter 'distance' slots away
+static double false_sharing_run(int distance, const int* cpus, long n)
+{
+    pthread_t threads[2];
+    SharingArgs args[2] = {{&sharing_slots[0], n},
+                           {&sharing_slots[distance], n}};
+    struct timespec t0, t1;
+
+    atomic_store(&sharing_slots[0], 0);
+    atomic_store(&sharing_slots[distance], 0);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < 2; i++)
+    {
+        create_pinned(&threads[i], cpus[i], sharing_thread, &args[i]);
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return timespec_ns(&t0, &t1) / n;
+}
+
+// Cache-line ping-pong: two pinned threads take turns flipping one flag,
+// so each round trip moves the line across and back
+typedef struct
+{
+    _Alignas(CACHE_LINE) atomic_int turn;
+    _Alignas(CACHE_LINE) long rounds;
+    pthread_barrier_t start;
+    double one_way_ns;
+} PingPong;
+
+void* pong_thread(void* arg)
+{
+    PingPong* p = arg;
+    unsigned spent = 0;
+
+    pthread_barrier_wait(&p->start);
+    for (long i = 0; i < p->rounds; i++)
+    {
+        while (atomic_load_explicit(&p->turn, memory_order_acquire) != 1)
+        {
+            spin_pause(&spent, 1);
+        }
+        atomic_store_explicit(&p->turn, 0, memory_order_release);
+    }
+    return NULL;
+}
+
+void* ping_thread(void* arg)
+{
+    PingPong* p = arg;
+    unsigned spent = 0;
+    struct timespec t0, t1;
+
+    pthread_barrier_wait(&p->start);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < p->rounds; i++)
+    {
+        atomic_store_explicit(&p->turn, 1, memory_order_release);
+        while (atomic_load_explicit(&p->turn, memory_order_acquire) != 0)
+        {
+            spin_pause(&spent, 1);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    p->one_way_ns = timespec_ns(&t0, &t1) / (2.0 * p->rounds);
+    return NULL;
+}
+
+// One-way latency between two CPUs in ns
+static double ping_pong_run(int cpu_a, int cpu_b, long rounds)
+{
+    static PingPong p;
+    pthread_t ping, pong;
+
+    atomic_store(&p.turn, 0);
+    p.rounds = rounds;
+    pthread_barrier_init(&p.start, NULL, 2);
+    create_pinned(&pong, cpu_b, pong_thread, &p);
+    create_pinned(&ping, cpu_a, ping_thread, &p);
+    pthread_join(ping, NULL);
+    pthread_join(pong, NULL);
+    pthread_barrier_destroy(&p.start);
+    return p.one_way_ns;
+}
+
+#define MATRIX_MAX_CPUS 16
+
+// Microbenchmarks for memory orderings, false sharing and core-to-core
+// latency
+void memory_ordering_cost_demo()
+{
+    printf("\n=== MEMORY ORDERING COST BENCHMARK ===\n");
+
+    const long n = 20000000;
+    typedef double (*OrderBench)(long);
+    const char* rows[] = {"load",
+                          "store",
+                          "fetch_add",
+                          "compare_exchange",
+                          "fence",
+                          "cpu_*_fence"};
+    OrderBench table[6][3] = {
+        {bench_load_relaxed, bench_load_acquire, bench_load_seq_cst},
+        {bench_store_relaxed, bench_store_release, bench_store_seq_cst},
+        {bench_add_relaxed, bench_add_acq_rel, bench_add_seq_cst},
+        {bench_cas_relaxed, bench_cas_acq_rel, bench_cas_seq_cst},
+        {NULL, bench_fence_acq_rel, bench_fence_seq_cst},
+        {NULL, bench_cpu_release_fence, bench_cpu_full_fence},
+    };
+
+    printf("Uncontended, one thread (ns/op; compiler barrier alone %.2f):\n",
+           bench_barrier(n));
+    printf("%-18s%10s%10s%10s\n", "operation", "relaxed", "acq/rel", "seq_cst");
+    for (int r = 0; r < 6; r++)
+    {
+        printf("%-18s", rows[r]);
+        for (int c = 0; c < 3; c++)
+        {
+            if (table[r][c] == NULL)
+            {
+                printf("%10s", "-");
+            }
+            else
+            {
+                // Best of three hides frequency ramp-up and interrupts
+                double best = table[r][c](n);
+                for (int rep = 0; rep < 2; rep++)
+                {
+                    double t = table[r][c](n);
+                    best = t < best ? t : best;
+                }
+                printf("%10.2f", best);
+            }
+        }
+        printf("\n");
+    }
+
+    int cpus[MATRIX_MAX_CPUS];
+    int count = allowed_cpus(cpus, MATRIX_MAX_CPUS);
+    int pair[2] = {-1, -1};
+    if (count >= 2)
+    {
+        pair[0] = cpus[0];
+        pair[1] = cpus[1];
+    }
+
+    // 128 B as well as 64 B: Intel's adjacent-line prefetcher pulls lines
+    // in pairs, so neighbours one line apart can still interfere
+    const long sharing_n = 10000000;
+    const int distances[] = {1, 8, 16};  // In 8-byte slots
+    const char* layouts[] = {"same cache line", "64 B apart", "128 B apart"};
+    printf("\nTwo threads incrementing separate counters (ns/increment%s):\n",
+           count >= 2 ? ", pinned to two CPUs" : ", 1 CPU so no contention");
+    for (int d = 0; d < 3; d++)
+    {
+        printf("  %-18s %6.2f\n",
+               layouts[d],
+               false_sharing_run(distances[d], pair, sharing_n));
+    }
+
+    if (count < 2)
+    {
+        printf("\nCore-to-core latency needs at least 2 CPUs; %d allowed.\n",
+               count);
+        return;
+    }
+
+    printf("\nCore-to-core one-way latency (ns), first %d allowed CPUs:\n",
+           count);
+    printf("%6s", "");
+    for (int j = 0; j < count; j++)
+    {
+        printf("%6d", cpus[j]);
+    }
+    printf("\n");
+    for (int i = 0; i < count; i++)
+    {
+        printf("%6d", cpus[i]);
+        for (int j = 0; j < count; j++)
+        {
+            if (i == j)
+            {
+                printf("%6s", "-");
+            }
+            else
+            {
+                printf("%6.0f", ping_pong_run(cpus[i], cpus[j], 20000));
+            }
+        }
+        printf("\n");
+    }
+}
+
 // Demonstration of atomic flag as spinlock
 void atomic_flag_demo()
 {
@@ -335,6 +1224,7 @@ void atomic_flag_demo()
 int main()
 {
     printf("==== ATOMIC OPERATIONS DEMONSTRATION ====\n");
+    prof_name(&exit_flag, PROF_LOCK_SPINLOCK, "exit_flag spinlock");
 
     // Seed random number generator
     srand(time(NULL));
@@ -342,9 +1232,13 @@ int main()
     // Run demonstrations
     race_condition_demo();
     atomic_counter_demo();
+    sharded_counter_demo();
     compare_exchange_demo();
     memory_ordering_demo();
+    memory_ordering_cost_demo();
     atomic_flag_demo();
+    lock_contention_demo();
+    prof_print_report();
 
     return 0;
 }
@@ -0,0 +1,556 @@
+// Opt-in lock contention profiler shared by the concurrency demos.
+//
+// Lock calls written with the prof_* macros expand to the plain primitives
+// unless LOCK_PROFILE is defined before this header, so a normal build
+// pays nothing. With profiling compiled in, every acquire first tries the
+// lock without blocking: an uncontended acquire costs a counter bump and a
+// timestamp (for hold time), and only contended acquires are timed end to
+// end. Their wait goes into a per-lock log2 histogram and is charged to
+// the caller's file:line. lock_profile_print_report() dumps the locks that
+// waited longest, the same way memory_print_report() reports allocations.
+#ifndef LOCK_PROFILE_H
+#define LOCK_PROFILE_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "../01-low-level-programming/cpu_primitives.h"
+
+// Test-and-set spinlock on an atomic_flag: spins with a CPU pause, then
+// yields and finally sleeps so a preempted holder is not starved
+static inline void lock_profile_spin_wait(atomic_flag* flag)
+{
+    for (unsigned spins = 1;
+         atomic_flag_test_and_set_explicit(flag, memory_order_acquire);
+         spins++)
+    {
+        if (spins < 64)
+        {
+            cpu_relax();
+        }
+        else if (spins < 1024)
+        {
+            sched_yield();
+        }
+        else
+        {
+            struct timespec nap = {0, 50000};
+            nanosleep(&nap, NULL);
+        }
+    }
+}
+
+#ifdef LOCK_PROFILE
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOCK_PROFILE_LOCKS 64    // Locks tracked, power of two
+#define LOCK_PROFILE_SITES 8     // Contending call sites kept per lock
+#define LOCK_PROFILE_BUCKETS 40  // Wait histogram: bucket b holds < 2^b ns
+
+typedef enum
+{
+    PROF_LOCK_MUTEX,
+    PROF_LOCK_RWLOCK,
+    PROF_LOCK_SEMAPHORE,
+    PROF_LOCK_SPINLOCK
+} ProfLockKind;
+
+typedef struct
+{
+    const char* file;
+    int line;
+    atomic_ulong count;
+    atomic_ulong wait_ns;
+} ProfLockSite;
+
+typedef struct
+{
+    _Atomic(const void*) lock;  // NULL while the entry is free
+    const char* name;
+    ProfLockKind kind;
+    atomic_ulong acquisitions;
+    atomic_ulong contended;
+    atomic_ulong wait_ns;
+    atomic_ulong max_wait_ns;
+    atomic_ulong holds;
+    atomic_ulong hold_ns;
+    atomic_ulong max_hold_ns;
+    atomic_ulong hold_start;  // Written by the exclusive holder; 0 if none
+    atomic_ulong histogram[LOCK_PROFILE_BUCKETS];
+    ProfLockSite sites[LOCK_PROFILE_SITES];
+    atomic_ulong other_sites;  // Contended waits that found no free site
+} ProfLockStats;
+
+static ProfLockStats lock_profile_table[LOCK_PROFILE_LOCKS];
+static atomic_int lock_profile_enabled = 1;
+static atomic_ulong lock_profile_dropped;  // Locks beyond the table
+
+// Guards entry and site creation only; taken the first time a lock is
+// seen and on contended acquires, which have already waited anyway
+static pthread_mutex_t lock_profile_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char* const lock_kind_names[] = {
+    "mutex", "rwlock", "semaphore", "spinlock"};
+
+static inline uint64_t lock_profile_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static inline void lock_profile_max(atomic_ulong* max, uint64_t value)
+{
+    unsigned long seen = atomic_load_explicit(max, memory_order_relaxed);
+    while (value > seen
+           && !atomic_compare_exchange_weak_explicit(
+               max, &seen, value, memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+}
+
+// Find (or create) the entry for a lock; NULL once the table is full
+static ProfLockStats* lock_profile_stats(const void* lock,
+                                         ProfLockKind kind,
+                                         const char* name)
+{
+    // Fibonacci hash of the address, then linear probing
+    size_t start = ((uintptr_t) lock >> 4) * 0x9E3779B97F4A7C15ull >> 32;
+
+    for (size_t i = 0; i < LOCK_PROFILE_LOCKS; i++)
+    {
+        size_t index = (start + i) & (LOCK_PROFILE_LOCKS - 1);
+        ProfLockStats* s = &lock_profile_table[index];
+        const void* owner =
+            atomic_load_explicit(&s->lock, memory_order_acquire);
+        if (owner == lock)
+        {
+            return s;
+        }
+        if (owner == NULL)
+        {
+            pthread_mutex_lock(&lock_profile_lock);
+            owner = atomic_load_explicit(&s->lock, memory_order_relaxed);
+            if (owner == NULL)
+            {
+                s->name = name;
+                s->kind = kind;
+                atomic_store_explicit(&s->lock, lock, memory_order_release);
+                owner = lock;
+            }
+            pthread_mutex_unlock(&lock_profile_lock);
+            if (owner == lock)
+            {
+                return s;
+            }
+        }
+    }
+    atomic_fetch_add_explicit(&lock_profile_dropped, 1, memory_order_relaxed);
+    return NULL;
+}
+
+// Give a lock a readable name in the report
+static inline void lock_profile_name(const void* lock,
+                                     ProfLockKind kind,
+                                     const char* name)
+{
+    ProfLockStats* s = lock_profile_stats(lock, kind, name);
+    if (s)
+    {
+        s->name = name;
+    }
+}
+
+// Turn recording on or off at run time; off costs one relaxed load
+static inline void lock_profile_set_enabled(int enabled)
+{
+    atomic_store(&lock_profile_enabled, enabled);
+}
+
+static void lock_profile_contended(ProfLockStats* s,
+                                   uint64_t wait,
+                                   const char* file,
+                                   int line)
+{
+    int bucket = 64 - __builtin_clzll(wait | 1);
+    if (bucket >= LOCK_PROFILE_BUCKETS)
+    {
+        bucket = LOCK_PROFILE_BUCKETS - 1;
+    }
+    atomic_fetch_add_explicit(&s->contended, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->wait_ns, wait, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->histogram[bucket], 1, memory_order_relaxed);
+    lock_profile_max(&s->max_wait_ns, wait);
+
+    pthread_mutex_lock(&lock_profile_lock);
+    ProfLockSite* site = NULL;
+    for (int i = 0; i < LOCK_PROFILE_SITES; i++)
+    {
+        ProfLockSite* candidate = &s->sites[i];
+        if (candidate->file == NULL)
+        {
+            candidate->file = file;
+            candidate->line = line;
+        }
+        if (candidate->line == line && strcmp(candidate->file, file) == 0)
+        {
+            site = candidate;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&lock_profile_lock);
+
+    if (site)
+    {
+        atomic_fetch_add_explicit(&site->count, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&site->wait_ns, wait, memory_order_relaxed);
+    }
+    else
+    {
+        atomic_fetch_add_explicit(&s->other_sites, 1, memory_order_relaxed);
+    }
+}
+
+static inline void lock_profile_acquired(ProfLockStats* s, int exclusive)
+{
+    atomic_fetch_add_explicit(&s->acquisitions, 1, memory_order_relaxed);
+    if (exclusive)
+    {
+        atomic_store_explicit(
+            &s->hold_start, lock_profile_now(), memory_order_relaxed);
+    }
+}
+
+// Called by the holder just before it lets go
+static inline void lock_profile_released(ProfLockStats* s)
+{
+    uint64_t start =
+        atomic_exchange_explicit(&s->hold_start, 0, memory_order_relaxed);
+    if (start != 0)
+    {
+        uint64_t held = lock_profile_now() - start;
+        atomic_fetch_add_explicit(&s->holds, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&s->hold_ns, held, memory_order_relaxed);
+        lock_profile_max(&s->max_hold_ns, held);
+    }
+}
+
+static inline ProfLockStats* lock_profile_active(const void* lock,
+                                                 ProfLockKind kind)
+{
+    if (!atomic_load_explicit(&lock_profile_enabled, memory_order_relaxed))
+    {
+        return NULL;
+    }
+    return lock_profile_stats(lock, kind, NULL);
+}
+
+static inline int lock_profile_mutex_lock(pthread_mutex_t* mutex,
+                                          const char* file,
+                                          int line)
+{
+    ProfLockStats* s = lock_profile_active(mutex, PROF_LOCK_MUTEX);
+    if (!s)
+    {
+        return pthread_mutex_lock(mutex);
+    }
+
+    int rc = pthread_mutex_trylock(mutex);
+    if (rc == EBUSY)
+    {
+        uint64_t start = lock_profile_now();
+        rc = pthread_mutex_lock(mutex);
+        lock_profile_contended(s, lock_profile_now() - start, file, line);
+    }
+    if (rc == 0)
+    {
+        lock_profile_acquired(s, 1);
+    }
+    return rc;
+}
+
+static inline int lock_profile_mutex_unlock(pthread_mutex_t* mutex)
+{
+    ProfLockStats* s = lock_profile_active(mutex, PROF_LOCK_MUTEX);
+    if (s)
+    {
+        lock_profile_released(s);
+    }
+    return pthread_mutex_unlock(mutex);
+}
+
+// Waiting on a condition is not contention: close the hold before the
+// wait and open a new one once the mutex is reacquired
+static inline int lock_profile_cond_wait(pthread_cond_t* cond,
+                                         pthread_mutex_t* mutex)
+{
+    ProfLockStats* s = lock_profile_active(mutex, PROF_LOCK_MUTEX);
+    if (s)
+    {
+        lock_profile_released(s);
+    }
+    int rc = pthread_cond_wait(cond, mutex);
+    if (s)
+    {
+        atomic_store_explicit(
+            &s->hold_start, lock_profile_now(), memory_order_relaxed);
+    }
+    return rc;
+}
+
+static inline int lock_profile_rwlock_lock(pthread_rwlock_t* rwlock,
+                                           int write,
+                                           const char* file,
+                                           int line)
+{
+    ProfLockStats* s = lock_profile_active(rwlock, PROF_LOCK_RWLOCK);
+    if (!s)
+    {
+        return write ? pthread_rwlock_wrlock(rwlock)
+                     : pthread_rwlock_rdlock(rwlock);
+    }
+
+    int rc = write ? pthread_rwlock_trywrlock(rwlock)
+                   : pthread_rwlock_tryrdlock(rwlock);
+    if (rc == EBUSY)
+    {
+        uint64_t start = lock_profile_now();
+        rc = write ? pthread_rwlock_wrlock(rwlock)
+                   : pthread_rwlock_rdlock(rwlock);
+        lock_profile_contended(s, lock_profile_now() - start, file, line);
+    }
+    if (rc == 0)
+    {
+        // Hold time is tracked for writers; readers overlap each other
+        lock_profile_acquired(s, write);
+    }
+    return rc;
+}
+
+static inline int lock_profile_rwlock_unlock(pthread_rwlock_t* rwlock)
+{
+    ProfLockStats* s = lock_profile_active(rwlock, PROF_LOCK_RWLOCK);
+    if (s)
+    {
+        // hold_start is only set while a writer holds the lock, and then
+        // the writer is the only thread that can be unlocking
+        lock_profile_released(s);
+    }
+    return pthread_rwlock_unlock(rwlock);
+}
+
+static inline int lock_profile_sem_wait(sem_t* sem, const char* file, int line)
+{
+    ProfLockStats* s = lock_profile_active(sem, PROF_LOCK_SEMAPHORE);
+    if (!s)
+    {
+        return sem_wait(sem);
+    }
+
+    int rc = sem_trywait(sem);
+    if (rc != 0 && errno == EAGAIN)
+    {
+        uint64_t start = lock_profile_now();
+        while ((rc = sem_wait(sem)) != 0 && errno == EINTR)
+        {
+        }
+        lock_profile_contended(s, lock_profile_now() - start, file, line);
+    }
+    if (rc == 0)
+    {
+        // Permits can be posted by any thread, so no hold time
+        lock_profile_acquired(s, 0);
+    }
+    return rc;
+}
+
+static inline void lock_profile_spin_lock(atomic_flag* flag,
+                                          const char* file,
+                                          int line)
+{
+    ProfLockStats* s = lock_profile_active(flag, PROF_LOCK_SPINLOCK);
+    if (!atomic_flag_test_and_set_explicit(flag, memory_order_acquire))
+    {
+        if (s)
+        {
+            lock_profile_acquired(s, 1);
+        }
+        return;
+    }
+
+    uint64_t start = s ? lock_profile_now() : 0;
+    lock_profile_spin_wait(flag);
+    if (s)
+    {
+        lock_profile_contended(s, lock_profile_now() - start, file, line);
+        lock_profile_acquired(s, 1);
+    }
+}
+
+static inline void lock_profile_spin_unlock(atomic_flag* flag)
+{
+    ProfLockStats* s = lock_profile_active(flag, PROF_LOCK_SPINLOCK);
+    if (s)
+    {
+        lock_profile_released(s);
+    }
+    atomic_flag_clear_explicit(flag, memory_order_release);
+}
+
+// Smallest bucket bound covering 'fraction' of a lock's contended waits
+static uint64_t lock_profile_percentile(const ProfLockStats* s, double fraction)
+{
+    unsigned long total = atomic_load(&s->contended);
+    unsigned long target = (unsigned long) (total * fraction + 0.5);
+    unsigned long seen = 0;
+
+    for (int b = 0; b < LOCK_PROFILE_BUCKETS; b++)
+    {
+        seen += atomic_load(&s->histogram[b]);
+        if (seen >= target && seen > 0)
+        {
+            return (uint64_t) 1 << b;
+        }
+    }
+    return 0;
+}
+
+static int lock_profile_compare(const void* a, const void* b)
+{
+    unsigned long x = atomic_load(&(*(ProfLockStats* const*) a)->wait_ns);
+    unsigned long y = atomic_load(&(*(ProfLockStats* const*) b)->wait_ns);
+    return (x < y) - (x > y);
+}
+
+// Print every lock seen, worst total wait first, with its hottest sites
+void lock_profile_print_report(void)
+{
+    ProfLockStats* order[LOCK_PROFILE_LOCKS];
+    int count = 0;
+
+    for (int i = 0; i < LOCK_PROFILE_LOCKS; i++)
+    {
+        if (atomic_load(&lock_profile_table[i].lock) != NULL)
+        {
+            order[count++] = &lock_profile_table[i];
+        }
+    }
+    qsort(order, count, sizeof(order[0]), lock_profile_compare);
+
+    printf("\n=== Lock Contention Report ===\n");
+    printf("%-22s %-9s %9s %9s %10s %9s %9s %10s %10s\n",
+           "lock",
+           "kind",
+           "acquired",
+           "contended",
+           "wait ms",
+           "p50 us",
+           "p99 us",
+           "max us",
+           "avg hold");
+    for (int i = 0; i < count; i++)
+    {
+        ProfLockStats* s = order[i];
+        char label[32];
+        if (s->name)
+        {
+            snprintf(label, sizeof(label), "%s", s->name);
+        }
+        else
+        {
+            snprintf(label, sizeof(label), "%p", (const void*) s->lock);
+        }
+
+        unsigned long holds = atomic_load(&s->holds);
+        unsigned long hold_ns = atomic_load(&s->hold_ns);
+        char hold[16] = "-";
+        if (holds > 0)
+        {
+            snprintf(hold, sizeof(hold), "%.1fus", hold_ns / 1e3 / holds);
+        }
+
+        printf("%-22s %-9s %9lu %9lu %10.3f %9.1f %9.1f %10.1f %10s\n",
+               label,
+               lock_kind_names[s->kind],
+               atomic_load(&s->acquisitions),
+               atomic_load(&s->contended),
+               atomic_load(&s->wait_ns) / 1e6,
+               lock_profile_percentile(s, 0.50) / 1e3,
+               lock_profile_percentile(s, 0.99) / 1e3,
+               atomic_load(&s->max_wait_ns) / 1e3,
+               hold);
+
+        for (int j = 0; j < LOCK_PROFILE_SITES && s->sites[j].file; j++)
+        {
+            const ProfLockSite* site = &s->sites[j];
+            const char* base = strrchr(site->file, '/');
+            printf("    waited at %s:%d  %lu times, %.3f ms\n",
+                   base ? base + 1 : site->file,
+                   site->line,
+                   atomic_load(&site->count),
+                   atomic_load(&site->wait_ns) / 1e6);
+        }
+        if (atomic_load(&s->other_sites) > 0)
+        {
+            printf("    %lu waits at other sites\n",
+                   atomic_load(&s->other_sites));
+        }
+    }
+    if (atomic_load(&lock_profile_dropped) > 0)
+    {
+        printf("%lu acquisitions on untracked locks (table full)\n",
+               atomic_load(&lock_profile_dropped));
+    }
+}
+
+// Forget all recorded locks and samples
+void lock_profile_reset(void)
+{
+    pthread_mutex_lock(&lock_profile_lock);
+    memset(lock_profile_table, 0, sizeof(lock_profile_table));
+    atomic_store(&lock_profile_dropped, 0);
+    pthread_mutex_unlock(&lock_profile_lock);
+}
+
+#define prof_mutex_lock(m) lock_profile_mutex_lock((m), __FILE__, __LINE__)
+#define prof_mutex_unlock(m) lock_profile_mutex_unlock(m)
+#define prof_cond_wait(c, m) lock_profile_cond_wait((c), (m))
+#define prof_rwlock_rdlock(l) \
+    lock_profile_rwlock_lock((l), 0, __FILE__, __LINE__)
+#define prof_rwlock_wrlock(l) \
+    lock_profile_rwlock_lock((l), 1, __FILE__, __LINE__)
+#define prof_rwlock_unlock(l) lock_profile_rwlock_unlock(l)
+#define prof_sem_wait(s) lock_profile_sem_wait((s), __FILE__, __LINE__)
+#define prof_sem_post(s) sem_post(s)
+#define prof_spin_lock(f) lock_profile_spin_lock((f), __FILE__, __LINE__)
+#define prof_spin_unlock(f) lock_profile_spin_unlock(f)
+#define prof_name(lock, kind, name) lock_profile_name((lock), (kind), (name))
+#define prof_print_report() lock_profile_print_report()
+
+#else  // !LOCK_PROFILE: the plain primitives, nothing recorded
+
+#define prof_mutex_lock(m) pthread_mutex_lock(m)
+#define prof_mutex_unlock(m) pthread_mutex_unlock(m)
+#define prof_cond_wait(c, m) pthread_cond_wait((c), (m))
+#define prof_rwlock_rdlock(l) pthread_rwlock_rdlock(l)
+#define prof_rwlock_wrlock(l) pthread_rwlock_wrlock(l)
+#define prof_rwlock_unlock(l) pthread_rwlock_unlock(l)
+#define prof_sem_wait(s) sem_wait(s)
+#define prof_sem_post(s) sem_post(s)
+#define prof_spin_lock(f) lock_profile_spin_wait(f)
+#define prof_spin_unlock(f) \
+    atomic_flag_clear_explicit((f), memory_order_release)
+#define prof_name(lock, kind, name) ((void) 0)
+#define prof_print_report() ((void) 0)
+
+#endif  // LOCK_PROFILE
+
+#endif  // LOCK_PROFILE_H
@@ -1,16 +1,22 @@
+#include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/poll.h>
 #include <sys/select.h>
+#include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include "../readiness.h"
+
 // Function to make a file descriptor non-blocking
 int set_nonblocking(int fd)
 {
@@ -336,6 +342,232 @@ void demo_poll()
     }
 }
 
+// --- One loop for everything ---
+//
+// The select() and poll() demos above each own a loop that serves two
+// pipes. Below, a TCP echo server, a pipe carrying messages from another
+// process, a signal and two timers all share one ReadyLoop on one thread.
+
+typedef struct
+{
+    ReadyLoop *loop;
+    int listen_fd;
+    int pipe_fd;
+    pid_t child;
+    int echoed;    // Bytes echoed back to TCP clients
+    int messages;  // Reads from the pipe
+    int ticks;     // Repeating timer callbacks
+    bool child_done;
+    bool pipe_done;
+} LoopDemo;
+
+static void loop_demo_finish_if_done(LoopDemo *demo)
+{
+    if (demo->child_done && demo->pipe_done) ready_loop_stop(demo->loop);
+}
+
+// Edge-triggered: echo everything available, until EAGAIN or EOF
+static void on_client_ready(ReadyLoop *loop, int fd, unsigned events, void *arg)
+{
+    LoopDemo *demo = (LoopDemo *) arg;
+    (void) events;
+    char buffer[256];
+    for (;;)
+    {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n > 0)
+        {
+            if (write(fd, buffer, (size_t) n) == n) demo->echoed += (int) n;
+            continue;
+        }
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n == -1 && errno == EINTR) continue;
+        ready_remove(loop, fd);  // EOF or error
+        close(fd);
+        return;
+    }
+}
+
+static void on_accept_ready(ReadyLoop *loop, int fd, unsigned events, void *arg)
+{
+    (void) events;
+    for (;;)
+    {
+        int client = accept(fd, NULL, NULL);
+        if (client == -1) return;  // EAGAIN: accepted everything queued
+        set_nonblocking(client);
+        if (ready_add(loop, client, READY_IN | READY_EDGE, on_client_ready, arg) != 0)
+        {
+            close(client);
+        }
+    }
+}
+
+// Re-arm the one-shot pipe registration once the deferred work is done
+static void rearm_pipe(ReadyLoop *loop, void *arg)
+{
+    LoopDemo *demo = (LoopDemo *) arg;
+    if (!demo->pipe_done) ready_rearm(loop, demo->pipe_fd);
+}
+
+// One-shot: the loop reports the pipe once, then leaves it alone until
+// rearm_pipe runs
+static void on_pipe_ready(ReadyLoop *loop, int fd, unsigned events, void *arg)
+{
+    LoopDemo *demo = (LoopDemo *) arg;
+    (void) events;
+    char buffer[256];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer) - 1)) > 0)
+    {
+        buffer[n] = '\0';
+        printf("  pipe: %s", buffer);
+        demo->messages++;
+    }
+    if (n == 0)
+    {
+        ready_remove(loop, fd);
+        close(fd);
+        demo->pipe_done = true;
+        loop_demo_finish_if_done(demo);
+        return;
+    }
+    ready_timer_add(loop, 0, 0, rearm_pipe, demo);
+}
+
+static void on_child_signal(ReadyLoop *loop, int signo, void *arg)
+{
+    LoopDemo *demo = (LoopDemo *) arg;
+    (void) loop;
+    (void) signo;
+    if (waitpid(demo->child, NULL, WNOHANG) == demo->child)
+    {
+        printf("  signal: SIGCHLD, child exited\n");
+        demo->child_done = true;
+        loop_demo_finish_if_done(demo);
+    }
+}
+
+static void on_tick(ReadyLoop *loop, void *arg)
+{
+    (void) loop;
+    ((LoopDemo *) arg)->ticks++;
+}
+
+static void on_deadline(ReadyLoop *loop, void *arg)
+{
+    (void) arg;
+    printf("  timer: deadline reached\n");
+    ready_loop_stop(loop);
+}
+
+// Child: talk to the TCP server and send messages down the pipe
+static void loop_demo_child(int port, int pipe_fd)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t) port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (sock == -1 || connect(sock, (struct sockaddr *) &addr, sizeof(addr)) == -1)
+    {
+        perror("connect");
+        exit(1);
+    }
+
+    char buffer[64];
+    for (int i = 1; i <= 3; i++)
+    {
+        int len = snprintf(buffer, sizeof(buffer), "ping %d\n", i);
+        if (write(sock, buffer, (size_t) len) != len) break;
+        ssize_t n = read(sock, buffer, sizeof(buffer));  // Echo
+        (void) n;
+
+        len = snprintf(buffer, sizeof(buffer), "message %d\n", i);
+        if (write(pipe_fd, buffer, (size_t) len) != len) break;
+        usleep(100000);
+    }
+    close(sock);
+    close(pipe_fd);
+    exit(0);
+}
+
+void demo_ready_loop(ReadyBackendType backend)
+{
+    ReadyLoop loop;
+    int error = ready_loop_init(&loop, backend);
+    if (error != 0)
+    {
+        printf("\n(backend unavailable: %s)\n", strerror(-error));
+        return;
+    }
+    printf("\n=== One Loop Demo (%s) ===\n", ready_backend_name(&loop));
+
+    LoopDemo demo = {&loop, -1, -1, -1, 0, 0, 0, false, false};
+
+    // Signals first: SIGCHLD must be blocked before the child can exit
+    ready_signal_add(&loop, SIGCHLD, on_child_signal, &demo);
+
+    demo.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {0};
+    socklen_t addr_len = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int pipefd[2];
+    if (demo.listen_fd == -1
+        || bind(demo.listen_fd, (struct sockaddr *) &addr, sizeof(addr)) == -1
+        || listen(demo.listen_fd, 16) == -1
+        || getsockname(demo.listen_fd, (struct sockaddr *) &addr, &addr_len) == -1
+        || pipe(pipefd) == -1)
+    {
+        perror("setup");
+        if (demo.listen_fd != -1) close(demo.listen_fd);
+        ready_loop_destroy(&loop);
+        return;
+    }
+
+    fflush(stdout);  // The child must not inherit buffered output
+    demo.child = fork();
+    if (demo.child == -1)
+    {
+        perror("fork");
+        close(pipefd[0]);
+        close(pipefd[1]);
+        close(demo.listen_fd);
+        ready_loop_destroy(&loop);
+        return;
+    }
+    if (demo.child == 0)
+    {
+        close(pipefd[0]);
+        close(demo.listen_fd);
+        loop_demo_child(ntohs(addr.sin_port), pipefd[1]);
+    }
+    close(pipefd[1]);
+    demo.pipe_fd = pipefd[0];
+
+    set_nonblocking(demo.listen_fd);
+    set_nonblocking(demo.pipe_fd);
+    ready_add(&loop, demo.listen_fd, READY_IN | READY_EDGE, on_accept_ready, &demo);
+    ready_add(&loop, demo.pipe_fd, READY_IN | READY_ONESHOT, on_pipe_ready, &demo);
+    ready_timer_add(&loop, 50, 50, on_tick, &demo);
+    ready_timer_add(&loop, 5000, 0, on_deadline, &demo);
+
+    ready_loop_run(&loop);
+
+    printf("  echoed %d bytes over TCP, %d pipe reads, %d timer ticks\n",
+           demo.echoed,
+           demo.messages,
+           demo.ticks);
+
+    // Remaining client connections are closed with the process
+    ready_remove(&loop, demo.listen_fd);
+    close(demo.listen_fd);
+    if (!demo.pipe_done) close(demo.pipe_fd);
+    if (!demo.child_done) waitpid(demo.child, NULL, 0);
+    ready_loop_destroy(&loop);
+}
+
 int main()
 {
     printf("=== Non-blocking I/O Demo ===\n");
@@ -344,6 +576,8 @@ int main()
     demo_nonblocking_read();
     demo_select();
     demo_poll();
+    demo_ready_loop(READY_BACKEND_AUTO);
+    demo_ready_loop(READY_BACKEND_POLL);
 
     return 0;
 }
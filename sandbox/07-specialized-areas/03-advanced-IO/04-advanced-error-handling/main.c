@@ -1,4 +1,6 @@
+#define _POSIX_C_SOURCE 200809L
 #include <errno.h>
+#include <pthread.h>
 #include <setjmp.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -16,33 +18,120 @@ typedef enum
     ERROR_FATAL
 } ErrorLevel;
 
-// Global error state
+// Error state
 typedef struct
 {
-    int code;           // Error code (e.g., errno)
-    ErrorLevel level;   // Error severity
-    char message[256];  // Error message
-    char function[64];  // Function where error occurred
-    int line;           // Line number where error occurred
-    time_t timestamp;   // When the error occurred
-    int has_error;      // Whether an error is set
+    int code;                  // Error code (e.g., errno)
+    ErrorLevel level;          // Error severity
+    char message[256];         // Error message
+    char function[64];         // Function where error occurred
+    int line;                  // Line number where error occurred
+    time_t timestamp;          // When the error occurred
+    int has_error;             // Whether an error is set
+    unsigned long suppressed;  // Same-site errors not logged before this one
 } ErrorState;
 
-// Global error state
-static ErrorState g_error_state = {0};
+// Each thread has its own error state, so concurrent failures never
+// overwrite each other's details
+static _Thread_local ErrorState t_error_state = {0};
 
 // Error logger function pointer
 typedef void (*ErrorLoggerFunc)(const ErrorState *error);
 static ErrorLoggerFunc g_error_logger = NULL;
 
-// Jump buffer for error recovery
-jmp_buf error_jmp_buf;
-int error_jmp_active = 0;
+// Jump buffer for error recovery (a longjmp must stay on its own thread)
+_Thread_local jmp_buf error_jmp_buf;
+_Thread_local int error_jmp_active = 0;
 
-// Function to clear the error state
+// Function to clear the calling thread's error state
 void error_clear()
 {
-    memset(&g_error_state, 0, sizeof(ErrorState));
+    memset(&t_error_state, 0, sizeof(ErrorState));
+}
+
+// Function to get the calling thread's error state
+const ErrorState *error_get()
+{
+    return &t_error_state;
+}
+
+// Rate limiting for loggers: every call site (function + line) gets a
+// token bucket, so an error storm from one site is logged at a bounded
+// rate while other sites are unaffected. Dropped errors are counted and
+// reported with the next one that gets through.
+#define ERROR_RATE_SITES 64
+#define ERROR_RATE_BURST 5.0     // Errors logged back to back
+#define ERROR_RATE_PER_SEC 2.0   // Sustained errors logged per second
+
+typedef struct
+{
+    const char *function;  // __func__ of the site, NULL if slot unused
+    int line;
+    double tokens;
+    struct timespec refilled;
+    unsigned long suppressed;
+} ErrorRateSite;
+
+static ErrorRateSite g_error_rate_sites[ERROR_RATE_SITES];
+static pthread_mutex_t g_error_rate_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Returns 1 if an error from this site may be logged now, storing how many
+// were suppressed since the last one that was
+static int error_rate_allow(const char *function,
+                            int line,
+                            unsigned long *suppressed)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    size_t slot = ((size_t) function ^ (size_t) line * 2654435761u)
+                  % ERROR_RATE_SITES;
+    int allowed = 1;
+    *suppressed = 0;
+
+    pthread_mutex_lock(&g_error_rate_lock);
+    for (int probe = 0; probe < ERROR_RATE_SITES; probe++)
+    {
+        ErrorRateSite *site =
+            &g_error_rate_sites[(slot + probe) % ERROR_RATE_SITES];
+
+        if (site->function == NULL)
+        {
+            site->function = function;
+            site->line = line;
+            site->tokens = ERROR_RATE_BURST;
+            site->refilled = now;
+        }
+        else if (site->function != function || site->line != line)
+        {
+            continue;
+        }
+
+        double elapsed = (now.tv_sec - site->refilled.tv_sec)
+                         + (now.tv_nsec - site->refilled.tv_nsec) / 1e9;
+        site->tokens += elapsed * ERROR_RATE_PER_SEC;
+        if (site->tokens > ERROR_RATE_BURST)
+        {
+            site->tokens = ERROR_RATE_BURST;
+        }
+        site->refilled = now;
+
+        if (site->tokens >= 1.0)
+        {
+            site->tokens -= 1.0;
+            *suppressed = site->suppressed;
+            site->suppressed = 0;
+        }
+        else
+        {
+            site->suppressed++;
+            allowed = 0;
+        }
+        break;
+    }
+    pthread_mutex_unlock(&g_error_rate_lock);
+
+    return allowed;  // Table full: log rather than lose the error
 }
 
 // Function to set an error with variable arguments
@@ -53,25 +142,29 @@ void error_set(ErrorLevel level,
                const char *format,
                ...)
 {
-    g_error_state.code = code;
-    g_error_state.level = level;
-    g_error_state.timestamp = time(NULL);
-    g_error_state.has_error = 1;
+    t_error_state.code = code;
+    t_error_state.level = level;
+    t_error_state.timestamp = time(NULL);
+    t_error_state.has_error = 1;
     strncpy(
-        g_error_state.function, function, sizeof(g_error_state.function) - 1);
-    g_error_state.line = line;
+        t_error_state.function, function, sizeof(t_error_state.function) - 1);
+    t_error_state.line = line;
+    t_error_state.suppressed = 0;
 
     // Format the error message
     va_list args;
     va_start(args, format);
     vsnprintf(
-        g_error_state.message, sizeof(g_error_state.message), format, args);
+        t_error_state.message, sizeof(t_error_state.message), format, args);
     va_end(args);
 
-    // Call the error logger if registered
-    if (g_error_logger != NULL)
+    // Call the error logger if registered and this site is within its rate
+    // (fatal errors are always logged)
+    if (g_error_logger != NULL
+        && (level == ERROR_FATAL
+            || error_rate_allow(function, line, &t_error_state.suppressed)))
     {
-        g_error_logger(&g_error_state);
+        g_error_logger(&t_error_state);
     }
 
     // If this is a fatal error and error recovery is active, longjmp
@@ -112,6 +205,15 @@ void error_logger_stderr(const ErrorState *error)
             error->function,
             error->line,
             error->message);
+
+    if (error->suppressed > 0)
+    {
+        fprintf(stderr,
+                "        (%lu similar errors from %s:%d were suppressed)\n",
+                error->suppressed,
+                error->function,
+                error->line);
+    }
 }
 
 // Function to register an error logger
@@ -135,6 +237,365 @@ FILE *safe_fopen(const char *filename, const char *mode)
     return file;
 }
 
+// Asynchronous I/O with bounded retries. Operations run on a small worker
+// pool; a failed attempt with a transient errno is rescheduled with
+// exponential backoff instead of sleeping, so a slow or flaky filesystem
+// neither blocks the submitting thread nor holds up other requests.
+
+// An operation returns 0 on success or an errno value. It may use
+// SET_ERROR for detail; that error state is copied into the request.
+typedef int (*AsyncIoOperation)(void *arg);
+
+typedef struct
+{
+    int max_attempts;       // Including the first one
+    long initial_delay_ms;  // Delay before the second attempt
+    long max_delay_ms;      // Upper bound for any single delay
+    long deadline_ms;       // No retry is scheduled past this budget
+} RetryPolicy;
+
+typedef enum
+{
+    ASYNC_IO_PENDING = 0,
+    ASYNC_IO_DONE,
+    ASYNC_IO_FAILED
+} AsyncIoStatus;
+
+typedef struct AsyncIoRequest
+{
+    AsyncIoOperation operation;
+    void *arg;
+    RetryPolicy policy;
+    int attempts;
+    struct timespec not_before;  // Earliest time of the next attempt
+    struct timespec deadline;
+    AsyncIoStatus status;
+    ErrorState error;  // Final error of a failed request
+    struct AsyncIoRequest *next;
+} AsyncIoRequest;
+
+#define ASYNC_IO_MAX_WORKERS 8
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t work;  // Queue changed
+    pthread_cond_t done;  // A request finished
+    AsyncIoRequest *queue;  // Sorted by not_before
+    pthread_t workers[ASYNC_IO_MAX_WORKERS];
+    int worker_count;
+    int stopping;
+} AsyncIo;
+
+static const RetryPolicy default_retry_policy = {5, 10, 1000, 10000};
+
+static void timespec_add_ms(struct timespec *t, long ms)
+{
+    t->tv_sec += ms / 1000;
+    t->tv_nsec += (ms % 1000) * 1000000L;
+    if (t->tv_nsec >= 1000000000L)
+    {
+        t->tv_sec++;
+        t->tv_nsec -= 1000000000L;
+    }
+}
+
+static int timespec_before(const struct timespec *a, const struct timespec *b)
+{
+    return a->tv_sec < b->tv_sec
+           || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+// Errors worth another attempt: interrupted or temporarily unavailable
+// resources and the usual symptoms of a flaky network filesystem
+static int error_is_transient(int code)
+{
+    switch (code)
+    {
+    case EINTR:
+    case EAGAIN:
+    case EBUSY:
+    case EIO:
+    case ETIMEDOUT:
+    case ESTALE:
+    case ENOLCK:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+// Insert keeping the queue ordered by due time (caller holds the lock)
+static void async_io_enqueue(AsyncIo *io, AsyncIoRequest *request)
+{
+    AsyncIoRequest **link = &io->queue;
+    while (*link
+           && !timespec_before(&request->not_before, &(*link)->not_before))
+    {
+        link = &(*link)->next;
+    }
+    request->next = *link;
+    *link = request;
+    pthread_cond_signal(&io->work);
+}
+
+// Exponential backoff with jitter in [delay/2, delay]
+static long retry_delay_ms(const RetryPolicy *policy,
+                           int attempts,
+                           unsigned *seed)
+{
+    long delay = policy->initial_delay_ms;
+    for (int i = 1; i < attempts && delay < policy->max_delay_ms; i++)
+    {
+        delay *= 2;
+    }
+    if (delay > policy->max_delay_ms)
+    {
+        delay = policy->max_delay_ms;
+    }
+    return delay / 2 + rand_r(seed) % (delay / 2 + 1);
+}
+
+static void *async_io_worker(void *arg)
+{
+    AsyncIo *io = arg;
+    unsigned seed = (unsigned) time(NULL) ^ (unsigned) (size_t) &seed;
+
+    pthread_mutex_lock(&io->lock);
+    while (!io->stopping)
+    {
+        AsyncIoRequest *request = io->queue;
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        if (request == NULL)
+        {
+            pthread_cond_wait(&io->work, &io->lock);
+            continue;
+        }
+        if (timespec_before(&now, &request->not_before))
+        {
+            // Sleep until the earliest retry is due, or new work arrives
+            pthread_cond_timedwait(&io->work, &io->lock, &request->not_before);
+            continue;
+        }
+        io->queue = request->next;
+        pthread_mutex_unlock(&io->lock);
+
+        // The attempt runs unlocked; its errors land in this worker's
+        // thread-local state and are copied out if the request fails
+        error_clear();
+        request->attempts++;
+        int rc = request->operation(request->arg);
+
+        long delay = 0;
+        if (rc != 0 && error_is_transient(rc)
+            && request->attempts < request->policy.max_attempts)
+        {
+            delay = retry_delay_ms(&request->policy, request->attempts, &seed);
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            request->not_before = now;
+            timespec_add_ms(&request->not_before, delay);
+            if (!timespec_before(&request->not_before, &request->deadline))
+            {
+                delay = 0;  // Out of time budget
+            }
+        }
+
+        if (rc != 0 && delay > 0)
+        {
+            SET_ERROR(ERROR_WARNING,
+                      rc,
+                      "Attempt %d failed, retrying in %ld ms",
+                      request->attempts,
+                      delay);
+        }
+        else if (rc != 0)
+        {
+            if (!t_error_state.has_error || t_error_state.code != rc)
+            {
+                SET_ERROR(ERROR_ERROR,
+                          rc,
+                          "Operation failed after %d attempts",
+                          request->attempts);
+            }
+            request->error = t_error_state;
+        }
+
+        pthread_mutex_lock(&io->lock);
+        if (rc != 0 && delay > 0)
+        {
+            async_io_enqueue(io, request);
+        }
+        else
+        {
+            request->status = rc == 0 ? ASYNC_IO_DONE : ASYNC_IO_FAILED;
+            pthread_cond_broadcast(&io->done);
+        }
+    }
+    pthread_mutex_unlock(&io->lock);
+    return NULL;
+}
+
+// Start the worker pool. Returns 0 on success.
+int async_io_start(AsyncIo *io, int workers)
+{
+    pthread_condattr_t attr;
+
+    memset(io, 0, sizeof(*io));
+    pthread_mutex_init(&io->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&io->work, &attr);
+    pthread_cond_init(&io->done, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (workers < 1 || workers > ASYNC_IO_MAX_WORKERS)
+    {
+        workers = 2;
+    }
+    for (int i = 0; i < workers; i++)
+    {
+        if (pthread_create(&io->workers[i], NULL, async_io_worker, io) != 0)
+        {
+            SET_ERROR(ERROR_ERROR, errno, "Failed to start I/O worker");
+            break;
+        }
+        io->worker_count++;
+    }
+    return io->worker_count > 0 ? 0 : -1;
+}
+
+// Queue a request and return immediately. The request must stay valid
+// until it has completed.
+void async_io_submit(AsyncIo *io,
+                     AsyncIoRequest *request,
+                     AsyncIoOperation operation,
+                     void *arg,
+                     const RetryPolicy *policy)
+{
+    memset(request, 0, sizeof(*request));
+    request->operation = operation;
+    request->arg = arg;
+    request->policy = policy ? *policy : default_retry_policy;
+    clock_gettime(CLOCK_MONOTONIC, &request->not_before);
+    request->deadline = request->not_before;
+    timespec_add_ms(&request->deadline, request->policy.deadline_ms);
+
+    pthread_mutex_lock(&io->lock);
+    async_io_enqueue(io, request);
+    pthread_mutex_unlock(&io->lock);
+}
+
+// Non-blocking status check
+AsyncIoStatus async_io_poll(AsyncIo *io, AsyncIoRequest *request)
+{
+    pthread_mutex_lock(&io->lock);
+    AsyncIoStatus status = request->status;
+    pthread_mutex_unlock(&io->lock);
+    return status;
+}
+
+// Wait up to timeout_ms (negative: no limit) for a request to complete
+AsyncIoStatus async_io_wait(AsyncIo *io,
+                            AsyncIoRequest *request,
+                            long timeout_ms)
+{
+    struct timespec until;
+    clock_gettime(CLOCK_MONOTONIC, &until);
+    timespec_add_ms(&until, timeout_ms < 0 ? 0 : timeout_ms);
+
+    pthread_mutex_lock(&io->lock);
+    while (request->status == ASYNC_IO_PENDING)
+    {
+        if (timeout_ms < 0)
+        {
+            pthread_cond_wait(&io->done, &io->lock);
+        }
+        else if (pthread_cond_timedwait(&io->done, &io->lock, &until)
+                 == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+    AsyncIoStatus status = request->status;
+    pthread_mutex_unlock(&io->lock);
+    return status;
+}
+
+// Stop the workers. Requests still queued fail with ECANCELED.
+void async_io_stop(AsyncIo *io)
+{
+    pthread_mutex_lock(&io->lock);
+    io->stopping = 1;
+    pthread_cond_broadcast(&io->work);
+    pthread_mutex_unlock(&io->lock);
+
+    for (int i = 0; i < io->worker_count; i++)
+    {
+        pthread_join(io->workers[i], NULL);
+    }
+
+    for (AsyncIoRequest *r = io->queue; r != NULL; r = r->next)
+    {
+        memset(&r->error, 0, sizeof(r->error));
+        r->error.code = ECANCELED;
+        r->error.level = ERROR_ERROR;
+        r->error.has_error = 1;
+        snprintf(r->error.message,
+                 sizeof(r->error.message),
+                 "Cancelled after %d attempts",
+                 r->attempts);
+        r->status = ASYNC_IO_FAILED;
+    }
+    io->queue = NULL;
+
+    pthread_cond_destroy(&io->done);
+    pthread_cond_destroy(&io->work);
+    pthread_mutex_destroy(&io->lock);
+}
+
+// Write a buffer to a file through safe_fopen, as one async operation
+typedef struct
+{
+    const char *filename;
+    const void *data;
+    size_t length;
+    int fail_first;  // Simulated transient failures (flaky mount)
+} WriteFileJob;
+
+int write_file_operation(void *arg)
+{
+    WriteFileJob *job = arg;
+
+    if (job->fail_first > 0)
+    {
+        job->fail_first--;
+        SET_ERROR(
+            ERROR_ERROR, EIO, "Simulated I/O error on '%s'", job->filename);
+        return EIO;
+    }
+
+    FILE *file = safe_fopen(job->filename, "w");
+    if (file == NULL)
+    {
+        return t_error_state.code ? t_error_state.code : EIO;
+    }
+
+    int rc = 0;
+    if (fwrite(job->data, 1, job->length, file) != job->length)
+    {
+        rc = errno ? errno : EIO;
+        SET_ERROR(ERROR_ERROR, rc, "Short write to '%s'", job->filename);
+    }
+    if (fclose(file) != 0 && rc == 0)
+    {
+        rc = errno;
+        SET_ERROR(ERROR_ERROR, rc, "Failed to close '%s'", job->filename);
+    }
+    return rc;
+}
+
 // Function that demonstrates error recovery using setjmp/longjmp
 void demonstrate_error_recovery()
 {
@@ -157,7 +618,7 @@ void demonstrate_error_recovery()
     else
     {
         // Recovery path after longjmp
-        printf("Recovered from fatal error: %s\n", g_error_state.message);
+        printf("Recovered from fatal error: %s\n", t_error_state.message);
         error_clear();
     }
 
@@ -220,11 +681,130 @@ cleanup:
     }
     else
     {
-        printf("Failed to write file: %s\n", g_error_state.message);
+        printf("Failed to write file: %s\n", t_error_state.message);
         error_clear();
     }
 }
 
+// Function to demonstrate non-blocking writes with retries
+void demonstrate_async_io()
+{
+    printf("\n=== Async I/O With Retries Demo ===\n");
+
+    AsyncIo io;
+    if (async_io_start(&io, 2) != 0)
+    {
+        printf("Could not start async I/O: %s\n", t_error_state.message);
+        error_clear();
+        return;
+    }
+
+    char data[256];
+    memset(data, 'B', sizeof(data));
+
+    // Healthy writes, two flaky ones that recover, one that keeps failing
+    // until its attempts run out, and one that can never succeed
+    WriteFileJob jobs[] = {
+        {"async_ok_1.txt", data, sizeof(data), 0},
+        {"async_ok_2.txt", data, sizeof(data), 0},
+        {"async_flaky_1.txt", data, sizeof(data), 2},
+        {"async_flaky_2.txt", data, sizeof(data), 3},
+        {"async_gives_up.txt", data, sizeof(data), 100},
+        {"/nonexistent-dir/async.txt", data, sizeof(data), 0},
+    };
+    enum
+    {
+        JOB_COUNT = sizeof(jobs) / sizeof(jobs[0])
+    };
+    AsyncIoRequest requests[JOB_COUNT];
+    RetryPolicy policy = {4, 20, 200, 2000};
+
+    struct timespec start, submitted, finished;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < JOB_COUNT; i++)
+    {
+        async_io_submit(
+            &io, &requests[i], write_file_operation, &jobs[i], &policy);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &submitted);
+
+    printf("Submitted %d writes in %ld us; caller is free to continue\n",
+           JOB_COUNT,
+           (submitted.tv_sec - start.tv_sec) * 1000000L
+               + (submitted.tv_nsec - start.tv_nsec) / 1000);
+
+    for (int i = 0; i < JOB_COUNT; i++)
+    {
+        AsyncIoStatus status = async_io_wait(&io, &requests[i], -1);
+        if (status == ASYNC_IO_DONE)
+        {
+            printf("  %-28s done after %d attempt(s)\n",
+                   jobs[i].filename,
+                   requests[i].attempts);
+        }
+        else
+        {
+            printf("  %-28s failed after %d attempt(s): %s (%s)\n",
+                   jobs[i].filename,
+                   requests[i].attempts,
+                   requests[i].error.message,
+                   strerror(requests[i].error.code));
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+    printf("All requests settled in %ld ms\n",
+           (finished.tv_sec - start.tv_sec) * 1000L
+               + (finished.tv_nsec - start.tv_nsec) / 1000000);
+
+    async_io_stop(&io);
+
+    for (int i = 0; i < JOB_COUNT; i++)
+    {
+        unlink(jobs[i].filename);
+    }
+}
+
+static void *error_storm_thread(void *arg)
+{
+    int id = *(int *) arg;
+
+    for (int i = 0; i < 10000; i++)
+    {
+        SET_ERROR(ERROR_ERROR, EIO, "Storm error %d from thread %d", i, id);
+    }
+
+    // The last error set on this thread is still this thread's own
+    printf("Thread %d last error: %s\n", id, error_get()->message);
+    error_clear();
+    return NULL;
+}
+
+// Function to demonstrate thread-local errors and rate-limited logging
+void demonstrate_error_storm()
+{
+    printf("\n=== Error Storm Demo ===\n");
+    printf("4 threads x 10000 errors from one call site:\n");
+    fflush(stdout);
+
+    pthread_t threads[4];
+    int ids[4] = {1, 2, 3, 4};
+    for (int i = 0; i < 4; i++)
+    {
+        pthread_create(&threads[i], NULL, error_storm_thread, &ids[i]);
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    // After a pause the bucket has refilled; the summary of what was
+    // dropped rides along with the next logged error from that site
+    struct timespec pause = {1, 0};
+    nanosleep(&pause, NULL);
+    int id = 5;
+    error_storm_thread(&id);
+}
+
 int main()
 {
     printf("=== Advanced Error Handling Demo ===\n");
@@ -241,6 +821,12 @@ int main()
     // Demonstrate complete file handling with cleanup
     write_file_with_error_handling();
 
+    // Demonstrate non-blocking I/O with bounded retries
+    demonstrate_async_io();
+
+    // Demonstrate thread-local errors and rate-limited logging
+    demonstrate_error_storm();
+
     // Clean up
     unlink("test_error_handling.txt");
 
@@ -0,0 +1,829 @@
+// One readiness loop for descriptors, timers and signals.
+//
+// Instead of each subsystem running its own select/poll loop on its own
+// thread, everything registers with a ReadyLoop and one thread waits on
+// all of it:
+//
+//   ReadyLoop loop;
+//   ready_loop_init(&loop, READY_BACKEND_AUTO);
+//   ready_add(&loop, sock, READY_IN | READY_EDGE, on_accept, &server);
+//   ready_timer_add(&loop, 1000, 1000, on_tick, NULL);   // every second
+//   ready_signal_add(&loop, SIGTERM, on_term, NULL);
+//   ready_loop_run(&loop);   // until ready_loop_stop()
+//
+// Interest is READY_IN and/or READY_OUT, plus two modes:
+//
+//   READY_EDGE     report a descriptor when it becomes ready, not for as
+//                  long as it is ready (EPOLLET, EV_CLEAR). The callback
+//                  must read or write until EAGAIN, or it will not hear
+//                  about that descriptor again. Saves one wakeup per
+//                  still-ready descriptor per iteration.
+//   READY_ONESHOT  disarm after one report until ready_rearm(). Lets a
+//                  descriptor be handed to another thread or deferred
+//                  without the loop reporting it again meanwhile.
+//
+// Backends: epoll (Linux), kqueue (BSD, macOS) and poll (anywhere). The
+// poll backend treats READY_EDGE as level-triggered, which a callback
+// that drains to EAGAIN cannot tell apart. Signals arrive through
+// signalfd on Linux and EVFILT_SIGNAL under kqueue; they are blocked for
+// the calling thread, so set them up before starting other threads.
+//
+// Callbacks run on the loop's thread and may add, modify and remove any
+// registration, including their own.
+#ifndef READINESS_H
+#define READINESS_H
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#define READY_HAVE_EPOLL 1
+#endif
+
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) \
+    || defined(__NetBSD__) || defined(__DragonFly__)
+#include <sys/event.h>
+#define READY_HAVE_KQUEUE 1
+#endif
+
+// Interest and reported events
+#define READY_IN  0x01u
+#define READY_OUT 0x02u
+#define READY_HUP 0x04u  // Reported only: hangup or error; read/write says which
+
+// Registration modes
+#define READY_EDGE    0x10u
+#define READY_ONESHOT 0x20u
+
+#define READY_MAX_EVENTS 64  // Reported per wait
+
+typedef enum
+{
+    READY_BACKEND_AUTO,
+    READY_BACKEND_EPOLL,
+    READY_BACKEND_KQUEUE,
+    READY_BACKEND_POLL
+} ReadyBackendType;
+
+typedef struct ReadyLoop ReadyLoop;
+
+typedef void (*ReadyCallback)(ReadyLoop *loop, int fd, unsigned events, void *arg);
+typedef void (*ReadyTimerCallback)(ReadyLoop *loop, void *arg);
+typedef void (*ReadySignalCallback)(ReadyLoop *loop, int signo, void *arg);
+
+typedef struct
+{
+    ReadyCallback callback;  // NULL when the fd is not registered
+    void *arg;
+    unsigned interest;  // READY_IN/OUT plus mode flags
+    bool armed;         // False once a one-shot report was delivered
+} ReadyWatch;
+
+typedef struct
+{
+    int fd;      // -1: dropped because the fd was removed mid-batch
+    int signo;   // Non-zero: a kqueue signal event
+    unsigned events;
+} ReadyEvent;
+
+typedef struct
+{
+    uint64_t deadline_ns;
+    uint64_t interval_ns;  // 0: one-shot
+    ReadyTimerCallback callback;
+    void *arg;
+    unsigned id;
+} ReadyTimer;
+
+typedef struct
+{
+    const char *name;
+    int (*init)(ReadyLoop *loop);
+    int (*add)(ReadyLoop *loop, int fd, unsigned interest);
+    int (*modify)(ReadyLoop *loop, int fd, unsigned interest);
+    void (*remove)(ReadyLoop *loop, int fd);
+    // Fill loop->fired; returns the count or -errno
+    int (*wait)(ReadyLoop *loop, int timeout_ms);
+    void (*destroy)(ReadyLoop *loop);
+} ReadyBackend;
+
+struct ReadyLoop
+{
+    const ReadyBackend *backend;
+    int fd;  // epoll or kqueue descriptor
+
+    ReadyWatch *watches;  // Indexed by fd
+    int watch_capacity;
+    int watch_count;
+
+    struct pollfd *pollfds;  // poll backend: disarmed entries hold ~fd
+    int *poll_slot;          // fd -> index in pollfds, -1 if none
+    int poll_count;
+    int poll_capacity;
+
+    ReadyEvent fired[READY_MAX_EVENTS];
+    int fired_count;
+
+    ReadyTimer *timers;  // Min-heap on deadline_ns
+    size_t timer_count;
+    size_t timer_capacity;
+    unsigned next_timer_id;
+    unsigned firing_timer;  // Id of the timer whose callback is running
+    bool firing_cancelled;
+
+    int signal_fd;  // signalfd, -1 until the first ready_signal_add
+    sigset_t signals;
+    ReadySignalCallback signal_callbacks[NSIG];
+    void *signal_args[NSIG];
+
+    bool stop;
+};
+
+static inline uint64_t ready_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static inline int ready_grow_watches(ReadyLoop *loop, int fd)
+{
+    if (fd < loop->watch_capacity) return 0;
+    int capacity = loop->watch_capacity ? loop->watch_capacity : 64;
+    while (capacity <= fd) capacity *= 2;
+    ReadyWatch *watches =
+        (ReadyWatch *) realloc(loop->watches, capacity * sizeof(ReadyWatch));
+    if (watches == NULL) return -ENOMEM;
+    memset(watches + loop->watch_capacity, 0,
+           (capacity - loop->watch_capacity) * sizeof(ReadyWatch));
+    loop->watches = watches;
+    loop->watch_capacity = capacity;
+    return 0;
+}
+
+// Queue a descriptor event for dispatch after the wait
+static inline void ready_fire(ReadyLoop *loop, int fd, unsigned events)
+{
+    ReadyEvent *e = &loop->fired[loop->fired_count++];
+    e->fd = fd;
+    e->signo = 0;
+    e->events = events;
+}
+
+/* ---- epoll backend ---- */
+
+#ifdef READY_HAVE_EPOLL
+
+static inline uint32_t ready_epoll_events(unsigned interest)
+{
+    uint32_t events = 0;
+    if (interest & READY_IN) events |= EPOLLIN | EPOLLRDHUP;
+    if (interest & READY_OUT) events |= EPOLLOUT;
+    if (interest & READY_EDGE) events |= EPOLLET;
+    if (interest & READY_ONESHOT) events |= EPOLLONESHOT;
+    return events;
+}
+
+static inline int ready_epoll_init(ReadyLoop *loop)
+{
+    loop->fd = epoll_create1(EPOLL_CLOEXEC);
+    return loop->fd == -1 ? -errno : 0;
+}
+
+static inline int ready_epoll_ctl(ReadyLoop *loop, int op, int fd, unsigned interest)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = ready_epoll_events(interest);
+    ev.data.fd = fd;
+    return epoll_ctl(loop->fd, op, fd, &ev) == -1 ? -errno : 0;
+}
+
+static inline int ready_epoll_add(ReadyLoop *loop, int fd, unsigned interest)
+{
+    return ready_epoll_ctl(loop, EPOLL_CTL_ADD, fd, interest);
+}
+
+// Also re-arms a disarmed EPOLLONESHOT registration
+static inline int ready_epoll_modify(ReadyLoop *loop, int fd, unsigned interest)
+{
+    return ready_epoll_ctl(loop, EPOLL_CTL_MOD, fd, interest);
+}
+
+static inline void ready_epoll_remove(ReadyLoop *loop, int fd)
+{
+    epoll_ctl(loop->fd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+static inline int ready_epoll_wait(ReadyLoop *loop, int timeout_ms)
+{
+    struct epoll_event events[READY_MAX_EVENTS];
+    int n = epoll_wait(loop->fd, events, READY_MAX_EVENTS, timeout_ms);
+    if (n == -1) return errno == EINTR ? 0 : -errno;
+    for (int i = 0; i < n; i++)
+    {
+        unsigned ready = 0;
+        if (events[i].events & EPOLLIN) ready |= READY_IN;
+        if (events[i].events & EPOLLOUT) ready |= READY_OUT;
+        if (events[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) ready |= READY_HUP;
+        ready_fire(loop, events[i].data.fd, ready);
+    }
+    return n;
+}
+
+static inline void ready_epoll_destroy(ReadyLoop *loop)
+{
+    close(loop->fd);
+}
+
+static const ReadyBackend ready_epoll_backend = {"epoll",
+                                                 ready_epoll_init,
+                                                 ready_epoll_add,
+                                                 ready_epoll_modify,
+                                                 ready_epoll_remove,
+                                                 ready_epoll_wait,
+                                                 ready_epoll_destroy};
+
+#endif  // READY_HAVE_EPOLL
+
+/* ---- kqueue backend ---- */
+
+#ifdef READY_HAVE_KQUEUE
+
+static inline int ready_kqueue_init(ReadyLoop *loop)
+{
+    loop->fd = kqueue();
+    return loop->fd == -1 ? -errno : 0;
+}
+
+// Read and write are separate filters: each is added, or deleted when
+// not in the interest. EV_DISPATCH disables a filter after it fires and
+// EV_ENABLE (via EV_ADD) turns it back on.
+static inline int ready_kqueue_modify(ReadyLoop *loop, int fd, unsigned interest)
+{
+    unsigned short mode = 0;
+    if (interest & READY_EDGE) mode |= EV_CLEAR;
+    if (interest & READY_ONESHOT) mode |= EV_DISPATCH;
+
+    struct kevent changes[2];
+    EV_SET(&changes[0], fd, EVFILT_READ,
+           (interest & READY_IN) ? EV_ADD | EV_ENABLE | mode : EV_DELETE, 0, 0, NULL);
+    EV_SET(&changes[1], fd, EVFILT_WRITE,
+           (interest & READY_OUT) ? EV_ADD | EV_ENABLE | mode : EV_DELETE, 0, 0, NULL);
+    for (int i = 0; i < 2; i++)
+    {
+        // Deleting a filter that was never added fails with ENOENT
+        if (kevent(loop->fd, &changes[i], 1, NULL, 0, NULL) == -1
+            && !(changes[i].flags & EV_DELETE && errno == ENOENT))
+        {
+            return -errno;
+        }
+    }
+    return 0;
+}
+
+static inline void ready_kqueue_remove(ReadyLoop *loop, int fd)
+{
+    ready_kqueue_modify(loop, fd, 0);
+}
+
+static inline int ready_kqueue_wait(ReadyLoop *loop, int timeout_ms)
+{
+    struct kevent events[READY_MAX_EVENTS];
+    struct timespec timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+    int n = kevent(loop->fd, NULL, 0, events, READY_MAX_EVENTS,
+                   timeout_ms < 0 ? NULL : &timeout);
+    if (n == -1) return errno == EINTR ? 0 : -errno;
+    for (int i = 0; i < n; i++)
+    {
+        if (events[i].filter == EVFILT_SIGNAL)
+        {
+            ReadyEvent *e = &loop->fired[loop->fired_count++];
+            e->fd = -1;
+            e->signo = (int) events[i].ident;
+            e->events = 0;
+            continue;
+        }
+        int fd = (int) events[i].ident;
+        unsigned ready = events[i].filter == EVFILT_READ ? READY_IN : READY_OUT;
+        if (events[i].flags & (EV_EOF | EV_ERROR)) ready |= READY_HUP;
+        ready_fire(loop, fd, ready);
+
+        // EV_DISPATCH disabled only the filter that fired; a one-shot
+        // registration disarms as a whole
+        unsigned interest = loop->watches[fd].interest;
+        if ((interest & READY_ONESHOT) && (interest & READY_IN)
+            && (interest & READY_OUT))
+        {
+            struct kevent other;
+            EV_SET(&other, fd, ready & READY_IN ? EVFILT_WRITE : EVFILT_READ,
+                   EV_DISABLE, 0, 0, NULL);
+            kevent(loop->fd, &other, 1, NULL, 0, NULL);
+        }
+    }
+    return n;
+}
+
+static inline void ready_kqueue_destroy(ReadyLoop *loop)
+{
+    close(loop->fd);
+}
+
+static const ReadyBackend ready_kqueue_backend = {"kqueue",
+                                                  ready_kqueue_init,
+                                                  ready_kqueue_modify,
+                                                  ready_kqueue_modify,
+                                                  ready_kqueue_remove,
+                                                  ready_kqueue_wait,
+                                                  ready_kqueue_destroy};
+
+#endif  // READY_HAVE_KQUEUE
+
+/* ---- poll backend ---- */
+
+static inline short ready_poll_events(unsigned interest)
+{
+    short events = 0;
+    if (interest & READY_IN) events |= POLLIN;
+    if (interest & READY_OUT) events |= POLLOUT;
+    return events;
+}
+
+static inline int ready_poll_init(ReadyLoop *loop)
+{
+    loop->fd = -1;
+    return 0;
+}
+
+static inline int ready_poll_add(ReadyLoop *loop, int fd, unsigned interest)
+{
+    if (loop->poll_count == loop->poll_capacity)
+    {
+        int capacity = loop->poll_capacity ? loop->poll_capacity * 2 : 64;
+        struct pollfd *pollfds = (struct pollfd *) realloc(
+            loop->pollfds, capacity * sizeof(struct pollfd));
+        if (pollfds == NULL) return -ENOMEM;
+        loop->pollfds = pollfds;
+        loop->poll_capacity = capacity;
+    }
+    int *slots = (int *) realloc(loop->poll_slot, loop->watch_capacity * sizeof(int));
+    if (slots == NULL) return -ENOMEM;
+    loop->poll_slot = slots;
+
+    int slot = loop->poll_count++;
+    loop->pollfds[slot].fd = fd;
+    loop->pollfds[slot].events = ready_poll_events(interest);
+    loop->pollfds[slot].revents = 0;
+    loop->poll_slot[fd] = slot;
+    return 0;
+}
+
+static inline int ready_poll_modify(ReadyLoop *loop, int fd, unsigned interest)
+{
+    struct pollfd *p = &loop->pollfds[loop->poll_slot[fd]];
+    p->fd = fd;  // Re-arms a one-shot entry
+    p->events = ready_poll_events(interest);
+    return 0;
+}
+
+static inline void ready_poll_remove(ReadyLoop *loop, int fd)
+{
+    int slot = loop->poll_slot[fd];
+    int last = --loop->poll_count;
+    if (slot != last)
+    {
+        loop->pollfds[slot] = loop->pollfds[last];
+        int moved = loop->pollfds[slot].fd;
+        loop->poll_slot[moved < 0 ? ~moved : moved] = slot;
+    }
+}
+
+static inline int ready_poll_wait(ReadyLoop *loop, int timeout_ms)
+{
+    int n = poll(loop->pollfds, (nfds_t) loop->poll_count, timeout_ms);
+    if (n == -1) return errno == EINTR ? 0 : -errno;
+
+    int count = 0;
+    for (int i = 0; i < loop->poll_count && count < n; i++)
+    {
+        struct pollfd *p = &loop->pollfds[i];
+        if (p->revents == 0) continue;
+        count++;
+        if (loop->fired_count == READY_MAX_EVENTS) continue;  // Next wait
+
+        unsigned ready = 0;
+        if (p->revents & POLLIN) ready |= READY_IN;
+        if (p->revents & POLLOUT) ready |= READY_OUT;
+        if (p->revents & (POLLERR | POLLHUP | POLLNVAL)) ready |= READY_HUP;
+        ready_fire(loop, p->fd, ready);
+        // poll skips negative descriptors: that is how one-shot disarms
+        if (loop->watches[p->fd].interest & READY_ONESHOT) p->fd = ~p->fd;
+    }
+    return loop->fired_count;
+}
+
+static inline void ready_poll_destroy(ReadyLoop *loop)
+{
+    free(loop->pollfds);
+    free(loop->poll_slot);
+}
+
+static const ReadyBackend ready_poll_backend = {"poll",
+                                                ready_poll_init,
+                                                ready_poll_add,
+                                                ready_poll_modify,
+                                                ready_poll_remove,
+                                                ready_poll_wait,
+                                                ready_poll_destroy};
+
+/* ---- Loop ---- */
+
+static inline const char *ready_backend_name(const ReadyLoop *loop)
+{
+    return loop->backend->name;
+}
+
+// Returns 0, or -errno; -ENOTSUP if the backend does not exist here
+static inline int ready_loop_init(ReadyLoop *loop, ReadyBackendType type)
+{
+    memset(loop, 0, sizeof(*loop));
+    loop->fd = -1;
+    loop->signal_fd = -1;
+    sigemptyset(&loop->signals);
+
+    switch (type)
+    {
+    case READY_BACKEND_AUTO:
+#if defined(READY_HAVE_EPOLL)
+        loop->backend = &ready_epoll_backend;
+#elif defined(READY_HAVE_KQUEUE)
+        loop->backend = &ready_kqueue_backend;
+#else
+        loop->backend = &ready_poll_backend;
+#endif
+        break;
+#ifdef READY_HAVE_EPOLL
+    case READY_BACKEND_EPOLL:
+        loop->backend = &ready_epoll_backend;
+        break;
+#endif
+#ifdef READY_HAVE_KQUEUE
+    case READY_BACKEND_KQUEUE:
+        loop->backend = &ready_kqueue_backend;
+        break;
+#endif
+    case READY_BACKEND_POLL:
+        loop->backend = &ready_poll_backend;
+        break;
+    default:
+        return -ENOTSUP;
+    }
+    return loop->backend->init(loop);
+}
+
+// Watch fd for interest (READY_IN/OUT plus READY_EDGE/READY_ONESHOT)
+static inline int ready_add(ReadyLoop *loop,
+                            int fd,
+                            unsigned interest,
+                            ReadyCallback callback,
+                            void *arg)
+{
+    if (fd < 0 || callback == NULL) return -EINVAL;
+    int error = ready_grow_watches(loop, fd);
+    if (error != 0) return error;
+    if (loop->watches[fd].callback != NULL) return -EEXIST;
+
+    // The poll backend reads the watch while adding
+    loop->watches[fd] = (ReadyWatch){callback, arg, interest, true};
+    error = loop->backend->add(loop, fd, interest);
+    if (error != 0)
+    {
+        loop->watches[fd].callback = NULL;
+        return error;
+    }
+    loop->watch_count++;
+    return 0;
+}
+
+// Change what fd is watched for; also re-arms a one-shot registration
+static inline int ready_modify(ReadyLoop *loop, int fd, unsigned interest)
+{
+    if (fd < 0 || fd >= loop->watch_capacity || !loop->watches[fd].callback)
+    {
+        return -ENOENT;
+    }
+    int error = loop->backend->modify(loop, fd, interest);
+    if (error == 0)
+    {
+        loop->watches[fd].interest = interest;
+        loop->watches[fd].armed = true;
+    }
+    return error;
+}
+
+// Re-arm a one-shot registration with its current interest
+static inline int ready_rearm(ReadyLoop *loop, int fd)
+{
+    if (fd < 0 || fd >= loop->watch_capacity || !loop->watches[fd].callback)
+    {
+        return -ENOENT;
+    }
+    return ready_modify(loop, fd, loop->watches[fd].interest);
+}
+
+// Stop watching fd; call before closing it
+static inline void ready_remove(ReadyLoop *loop, int fd)
+{
+    if (fd < 0 || fd >= loop->watch_capacity || !loop->watches[fd].callback)
+    {
+        return;
+    }
+    loop->backend->remove(loop, fd);
+    loop->watches[fd].callback = NULL;
+    loop->watch_count--;
+
+    // Drop reports for it still waiting in this batch: the number may be
+    // reused by the next open before they are dispatched
+    for (int i = 0; i < loop->fired_count; i++)
+    {
+        if (loop->fired[i].fd == fd) loop->fired[i].fd = -1;
+    }
+}
+
+/* ---- Timers ---- */
+
+static inline void ready_timer_sift_up(ReadyLoop *loop, size_t i)
+{
+    ReadyTimer t = loop->timers[i];
+    while (i > 0)
+    {
+        size_t parent = (i - 1) / 2;
+        if (loop->timers[parent].deadline_ns <= t.deadline_ns) break;
+        loop->timers[i] = loop->timers[parent];
+        i = parent;
+    }
+    loop->timers[i] = t;
+}
+
+static inline void ready_timer_sift_down(ReadyLoop *loop, size_t i)
+{
+    ReadyTimer t = loop->timers[i];
+    for (;;)
+    {
+        size_t child = 2 * i + 1;
+        if (child >= loop->timer_count) break;
+        if (child + 1 < loop->timer_count
+            && loop->timers[child + 1].deadline_ns < loop->timers[child].deadline_ns)
+        {
+            child++;
+        }
+        if (t.deadline_ns <= loop->timers[child].deadline_ns) break;
+        loop->timers[i] = loop->timers[child];
+        i = child;
+    }
+    loop->timers[i] = t;
+}
+
+static inline int ready_timer_push(ReadyLoop *loop, const ReadyTimer *timer)
+{
+    if (loop->timer_count == loop->timer_capacity)
+    {
+        size_t capacity = loop->timer_capacity ? loop->timer_capacity * 2 : 16;
+        ReadyTimer *timers =
+            (ReadyTimer *) realloc(loop->timers, capacity * sizeof(ReadyTimer));
+        if (timers == NULL) return -ENOMEM;
+        loop->timers = timers;
+        loop->timer_capacity = capacity;
+    }
+    loop->timers[loop->timer_count] = *timer;
+    ready_timer_sift_up(loop, loop->timer_count++);
+    return 0;
+}
+
+static inline void ready_timer_remove_at(ReadyLoop *loop, size_t i)
+{
+    loop->timers[i] = loop->timers[--loop->timer_count];
+    if (i < loop->timer_count)
+    {
+        ready_timer_sift_down(loop, i);
+        ready_timer_sift_up(loop, i);
+    }
+}
+
+// Call callback after delay_ms, then every interval_ms if that is
+// non-zero. Returns a timer id (> 0) for ready_timer_cancel, or -errno.
+static inline int ready_timer_add(ReadyLoop *loop,
+                                  unsigned delay_ms,
+                                  unsigned interval_ms,
+                                  ReadyTimerCallback callback,
+                                  void *arg)
+{
+    ReadyTimer timer = {ready_now_ns() + (uint64_t) delay_ms * 1000000u,
+                        (uint64_t) interval_ms * 1000000u, callback, arg,
+                        ++loop->next_timer_id};
+    if (timer.id > INT32_MAX) timer.id = loop->next_timer_id = 1;  // Wrapped
+    int error = ready_timer_push(loop, &timer);
+    return error != 0 ? error : (int) timer.id;
+}
+
+// Cancel a pending timer, or a repeating one from inside its callback
+static inline void ready_timer_cancel(ReadyLoop *loop, int id)
+{
+    if ((unsigned) id == loop->firing_timer)
+    {
+        loop->firing_cancelled = true;
+        return;
+    }
+    for (size_t i = 0; i < loop->timer_count; i++)
+    {
+        if (loop->timers[i].id == (unsigned) id)
+        {
+            ready_timer_remove_at(loop, i);
+            return;
+        }
+    }
+}
+
+// Milliseconds until the earliest timer, rounded up so the wait never
+// returns just before it is due; -1 if there is none
+static inline int ready_timer_timeout(const ReadyLoop *loop, uint64_t now)
+{
+    if (loop->timer_count == 0) return -1;
+    uint64_t deadline = loop->timers[0].deadline_ns;
+    if (deadline <= now) return 0;
+    uint64_t ms = (deadline - now + 999999) / 1000000;
+    return ms > INT32_MAX ? INT32_MAX : (int) ms;
+}
+
+static inline void ready_run_timers(ReadyLoop *loop)
+{
+    uint64_t now = ready_now_ns();
+    while (loop->timer_count > 0 && loop->timers[0].deadline_ns <= now
+           && !loop->stop)
+    {
+        ReadyTimer timer = loop->timers[0];
+        ready_timer_remove_at(loop, 0);
+
+        loop->firing_timer = timer.id;
+        loop->firing_cancelled = false;
+        timer.callback(loop, timer.arg);
+        loop->firing_timer = 0;
+
+        if (timer.interval_ns != 0 && !loop->firing_cancelled)
+        {
+            // Skip missed ticks rather than firing them back to back
+            timer.deadline_ns += timer.interval_ns;
+            if (timer.deadline_ns <= now) timer.deadline_ns = now + timer.interval_ns;
+            ready_timer_push(loop, &timer);
+        }
+    }
+}
+
+/* ---- Signals ---- */
+
+static inline void ready_dispatch_signal(ReadyLoop *loop, int signo)
+{
+    if (signo > 0 && signo < NSIG && loop->signal_callbacks[signo])
+    {
+        loop->signal_callbacks[signo](loop, signo, loop->signal_args[signo]);
+    }
+}
+
+#ifdef __linux__
+static inline void ready_signalfd_ready(ReadyLoop *loop, int fd, unsigned events, void *arg)
+{
+    (void) events;
+    (void) arg;
+    struct signalfd_siginfo info[8];
+    ssize_t n;
+    while ((n = read(fd, info, sizeof(info))) > 0)
+    {
+        for (size_t i = 0; i < (size_t) n / sizeof(info[0]); i++)
+        {
+            ready_dispatch_signal(loop, (int) info[i].ssi_signo);
+        }
+    }
+}
+#endif
+
+// Deliver signo to callback on the loop's thread instead of to a signal
+// handler. The signal is blocked in the calling thread.
+static inline int ready_signal_add(ReadyLoop *loop,
+                                   int signo,
+                                   ReadySignalCallback callback,
+                                   void *arg)
+{
+    if (signo <= 0 || signo >= NSIG) return -EINVAL;
+    loop->signal_callbacks[signo] = callback;
+    loop->signal_args[signo] = arg;
+
+#if defined(READY_HAVE_KQUEUE)
+    if (loop->backend == &ready_kqueue_backend)
+    {
+        // kqueue sees signals even when ignored; ignoring stops the default
+        // action (usually termination) from running first
+        signal(signo, SIG_IGN);
+        struct kevent change;
+        EV_SET(&change, signo, EVFILT_SIGNAL, EV_ADD, 0, 0, NULL);
+        return kevent(loop->fd, &change, 1, NULL, 0, NULL) == -1 ? -errno : 0;
+    }
+#endif
+#ifdef __linux__
+    sigaddset(&loop->signals, signo);
+    if (sigprocmask(SIG_BLOCK, &loop->signals, NULL) == -1) return -errno;
+    int fd = signalfd(loop->signal_fd, &loop->signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd == -1) return -errno;
+    if (loop->signal_fd == -1)
+    {
+        loop->signal_fd = fd;
+        int error = ready_add(loop, fd, READY_IN | READY_EDGE, ready_signalfd_ready, NULL);
+        if (error != 0) return error;
+        loop->watch_count--;  // Does not keep ready_loop_run going
+    }
+    return 0;
+#else
+    return -ENOTSUP;
+#endif
+}
+
+/* ---- Running ---- */
+
+// Wait up to timeout_ms (-1: until something happens) and dispatch what
+// is ready, timers included. Returns the number of descriptor events, or
+// -errno.
+static inline int ready_loop_run_once(ReadyLoop *loop, int timeout_ms)
+{
+    int timer_ms = ready_timer_timeout(loop, ready_now_ns());
+    if (timer_ms >= 0 && (timeout_ms < 0 || timer_ms < timeout_ms)) timeout_ms = timer_ms;
+
+    loop->fired_count = 0;
+    int n = loop->backend->wait(loop, timeout_ms);
+    if (n < 0) return n;
+
+    for (int i = 0; i < loop->fired_count && !loop->stop; i++)
+    {
+        ReadyEvent e = loop->fired[i];
+        if (e.signo != 0)
+        {
+            ready_dispatch_signal(loop, e.signo);
+            continue;
+        }
+        if (e.fd < 0) continue;  // Removed earlier in this batch
+        ReadyWatch *w = &loop->watches[e.fd];
+        if (w->callback == NULL || !w->armed) continue;
+        if (w->interest & READY_ONESHOT) w->armed = false;
+        w->callback(loop, e.fd, e.events, w->arg);
+    }
+    loop->fired_count = 0;
+
+    ready_run_timers(loop);
+    return n;
+}
+
+// Dispatch until ready_loop_stop, or until no descriptors or timers are
+// left to wait for. Returns 0, or -errno if waiting failed.
+static inline int ready_loop_run(ReadyLoop *loop)
+{
+    loop->stop = false;
+    while (!loop->stop && (loop->watch_count > 0 || loop->timer_count > 0))
+    {
+        int n = ready_loop_run_once(loop, -1);
+        if (n < 0) return n;
+    }
+    return 0;
+}
+
+static inline void ready_loop_stop(ReadyLoop *loop)
+{
+    loop->stop = true;
+}
+
+// Does not close the registered descriptors; restores the signal mask
+static inline void ready_loop_destroy(ReadyLoop *loop)
+{
+#ifdef __linux__
+    if (loop->signal_fd != -1)
+    {
+        loop->backend->remove(loop, loop->signal_fd);
+        close(loop->signal_fd);
+        sigprocmask(SIG_UNBLOCK, &loop->signals, NULL);
+    }
+#endif
+    loop->backend->destroy(loop);
+    free(loop->watches);
+    free(loop->timers);
+    memset(loop, 0, sizeof(*loop));
+    loop->fd = -1;
+    loop->signal_fd = -1;
+}
+
+#endif  // READINESS_H
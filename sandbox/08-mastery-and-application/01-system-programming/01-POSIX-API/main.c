@@ -1,17 +1,31 @@
+#define _GNU_SOURCE
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
 
+// Build with -DSCOPE_TRACE to record file operations and per-directory
+// walker spans into posix_trace.json
+#include "../../../05-advanced-programming/scope_trace.h"
+#include "../fast_clock.h"
+#include "../file_copy.h"
+
 // Demonstrate POSIX file operations
 void posix_file_operations()
 {
+    TRACE_FUNCTION();
+
     // Create a file using open()
     int fd = open(
         "posix_test.txt", O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
@@ -76,6 +90,22 @@ void posix_file_operations()
     // Close the file
     close(fd);
 
+    // Copy the file without passing the data through user space
+    FileCopyStatus copy_status;
+    int copy_error =
+        file_copy("posix_test.txt", "posix_test_copy.txt", NULL, &copy_status);
+    if (copy_error != 0)
+    {
+        fprintf(stderr, "file_copy: %s\n", strerror(-copy_error));
+    }
+    else
+    {
+        printf("Copied %llu bytes with %s\n",
+               (unsigned long long) copy_status.copied,
+               file_copy_method_name(copy_status.method));
+        unlink("posix_test_copy.txt");
+    }
+
     // Rename the file using rename()
     if (rename("posix_test.txt", "posix_test_renamed.txt") == -1)
     {
@@ -240,10 +270,23 @@ void time_functions()
            ts.tv_sec,
            ts.tv_nsec);
 
+    // Time the sleep with the monotonic clock and the cheaper clocks from
+    // fast_clock.h; CLOCK_REALTIME can jump if the system time is set
+    fast_clock_calibrate();
+    uint64_t monotonic_start = fast_clock_monotonic_ns();
+    uint64_t coarse_start = fast_clock_coarse_ns();
+    uint64_t tsc_start = fast_clock_tsc_ns();
+
     // Sleep for a brief period
     printf("Sleeping for 2 seconds...\n");
     sleep(2);
 
+    printf("Slept for: %.6f s (CLOCK_MONOTONIC), %.6f s (coarse), "
+           "%.6f s (TSC)\n",
+           (fast_clock_monotonic_ns() - monotonic_start) / 1e9,
+           (fast_clock_coarse_ns() - coarse_start) / 1e9,
+           (fast_clock_tsc_ns() - tsc_start) / 1e9);
+
     // Get time again
     if (clock_gettime(CLOCK_REALTIME, &ts) == -1)
     {
@@ -255,8 +298,847 @@ void time_functions()
         "After sleep: %ld.%09ld seconds since Epoch\n", ts.tv_sec, ts.tv_nsec);
 }
 
-int main()
+// ===== Parallel Tree Walker =====
+//
+// Recursive walk built for very large trees. Each worker reads directories
+// with getdents64 into a large buffer (far fewer syscalls than readdir),
+// stats entries relative to the open directory fd with statx and only the
+// fields the caller asked for, and skips the stat entirely when d_type
+// already answers the question. Entries are stat'ed in inode order, which
+// keeps inode-table reads sequential on disk.
+//
+// Parallelism is per directory: every worker owns a deque of pending
+// directories, works depth-first from its own end and, when empty, steals
+// the oldest (shallowest, usually largest) directory from another worker.
+// Results stream to the caller in batches through a bounded queue, so
+// entries arrive while the walk is running and a slow consumer throttles
+// the workers instead of growing memory.
+
+#define WALK_DENTS_BUFFER (256 * 1024)
+#define WALK_BATCH_ENTRIES 256
+#define WALK_BATCH_POOL (64 * 1024)
+#define WALK_QUEUE_LIMIT 64
+
+typedef struct
+{
+    const char *path;    // Full path, valid until the next tree_walker_next
+    const char *name;    // Points into path
+    uint64_t ino;
+    unsigned char type;  // DT_* value
+    int depth;           // 1 for children of the root
+    int stat_ok;         // stx holds the requested fields
+    struct statx stx;
+} WalkEntry;
+
+typedef struct
+{
+    int threads;            // Worker count, 0 = online CPUs
+    unsigned int stat_mask; // STATX_* fields wanted, 0 = none
+} WalkOptions;
+
+typedef struct
+{
+    unsigned long long directories;
+    unsigned long long entries;
+    unsigned long long errors;
+    unsigned long long steals;
+} WalkStats;
+
+typedef struct WalkBatch
+{
+    struct WalkBatch *next;
+    int count;
+    size_t pool_used;
+    WalkEntry entries[WALK_BATCH_ENTRIES];
+    char pool[WALK_BATCH_POOL];
+} WalkBatch;
+
+typedef struct
+{
+    char *path;
+    int depth;
+} WalkDir;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    WalkDir *items;
+    size_t head;  // Thieves take from here
+    size_t tail;  // Owner pushes and pops here
+    size_t capacity;
+} WalkDeque;
+
+typedef struct TreeWalker TreeWalker;
+
+typedef struct
+{
+    TreeWalker *walker;
+    int index;
+    pthread_t thread;
+    char *dents;
+    WalkBatch *batch;
+} WalkWorker;
+
+struct TreeWalker
+{
+    WalkOptions options;
+    int worker_count;
+    WalkWorker *workers;
+    WalkDeque *deques;
+
+    // Directories queued or being read; the walk ends when this hits zero
+    atomic_long pending;
+    atomic_int idle;
+    atomic_int stop;
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle_cond;
+
+    // Output queue of filled batches
+    pthread_mutex_t out_lock;
+    pthread_cond_t out_ready;
+    pthread_cond_t out_space;
+    WalkBatch *out_head;
+    WalkBatch *out_tail;
+    int out_count;
+    int workers_running;
+
+    WalkBatch *current;  // Consumer's batch
+    int current_index;
+
+    atomic_ullong directories;
+    atomic_ullong entries;
+    atomic_ullong errors;
+    atomic_ullong steals;
+};
+
+// getdents64 record layout
+struct walk_dirent64
+{
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+static void walk_deque_push(WalkDeque *dq, WalkDir dir)
+{
+    pthread_mutex_lock(&dq->lock);
+    if (dq->tail == dq->capacity)
+    {
+        if (dq->head > 0)
+        {
+            // Reclaim the slots thieves have emptied
+            memmove(dq->items,
+                    dq->items + dq->head,
+                    (dq->tail - dq->head) * sizeof(WalkDir));
+            dq->tail -= dq->head;
+            dq->head = 0;
+        }
+        else
+        {
+            size_t capacity = dq->capacity ? dq->capacity * 2 : 64;
+            WalkDir *items =
+                (WalkDir *) realloc(dq->items, capacity * sizeof(WalkDir));
+            if (!items)
+            {
+                pthread_mutex_unlock(&dq->lock);
+                abort();
+            }
+            dq->items = items;
+            dq->capacity = capacity;
+        }
+    }
+    dq->items[dq->tail++] = dir;
+    pthread_mutex_unlock(&dq->lock);
+}
+
+// Take from the owner's end (newest) or the thief's end (oldest)
+static int walk_deque_take(WalkDeque *dq, WalkDir *out, int steal)
+{
+    int found = 0;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->head < dq->tail)
+    {
+        *out = steal ? dq->items[dq->head++] : dq->items[--dq->tail];
+        if (dq->head == dq->tail) dq->head = dq->tail = 0;
+        found = 1;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+static void walk_publish(TreeWalker *w, WalkBatch *batch)
+{
+    pthread_mutex_lock(&w->out_lock);
+    while (w->out_count >= WALK_QUEUE_LIMIT && !atomic_load(&w->stop))
+    {
+        pthread_cond_wait(&w->out_space, &w->out_lock);
+    }
+    batch->next = NULL;
+    if (w->out_tail)
+        w->out_tail->next = batch;
+    else
+        w->out_head = batch;
+    w->out_tail = batch;
+    w->out_count++;
+    pthread_cond_signal(&w->out_ready);
+    pthread_mutex_unlock(&w->out_lock);
+}
+
+static WalkBatch *walk_new_batch(void)
+{
+    WalkBatch *batch = (WalkBatch *) malloc(sizeof(WalkBatch));
+    if (batch)
+    {
+        batch->count = 0;
+        batch->pool_used = 0;
+    }
+    return batch;
+}
+
+// Reserve an entry and path storage, flushing the batch when it is full
+static WalkEntry *walk_add_entry(WalkWorker *worker, size_t path_len)
+{
+    WalkBatch *batch = worker->batch;
+    if (batch
+        && (batch->count == WALK_BATCH_ENTRIES
+            || batch->pool_used + path_len + 1 > WALK_BATCH_POOL))
+    {
+        walk_publish(worker->walker, batch);
+        batch = NULL;
+    }
+    if (!batch)
+    {
+        batch = worker->batch = walk_new_batch();
+        if (!batch) return NULL;
+    }
+
+    WalkEntry *entry = &batch->entries[batch->count++];
+    entry->path = batch->pool + batch->pool_used;
+    batch->pool_used += path_len + 1;
+    return entry;
+}
+
+static void walk_push_dir(TreeWalker *w, int worker, const char *path,
+                          int depth)
+{
+    WalkDir dir = {strdup(path), depth};
+    if (!dir.path) abort();
+
+    atomic_fetch_add(&w->pending, 1);
+    walk_deque_push(&w->deques[worker], dir);
+
+    // An idling worker registers before re-checking the deques, so either
+    // it sees this push or we see it and wake it
+    if (atomic_load(&w->idle) > 0)
+    {
+        pthread_mutex_lock(&w->idle_lock);
+        pthread_cond_signal(&w->idle_cond);
+        pthread_mutex_unlock(&w->idle_lock);
+    }
+}
+
+typedef struct
+{
+    uint64_t ino;
+    unsigned char type;
+    const char *name;
+} WalkName;
+
+static int walk_compare_ino(const void *a, const void *b)
+{
+    uint64_t x = ((const WalkName *) a)->ino;
+    uint64_t y = ((const WalkName *) b)->ino;
+    return x < y ? -1 : x > y;
+}
+
+static unsigned char walk_type_from_mode(unsigned int mode)
+{
+    switch (mode & S_IFMT)
+    {
+    case S_IFDIR:
+        return DT_DIR;
+    case S_IFREG:
+        return DT_REG;
+    case S_IFLNK:
+        return DT_LNK;
+    case S_IFIFO:
+        return DT_FIFO;
+    case S_IFSOCK:
+        return DT_SOCK;
+    case S_IFCHR:
+        return DT_CHR;
+    case S_IFBLK:
+        return DT_BLK;
+    default:
+        return DT_UNKNOWN;
+    }
+}
+
+// Read one directory: emit its entries and queue its subdirectories
+static void walk_directory(WalkWorker *worker, WalkDir *dir)
+{
+    TRACE_FUNCTION();
+    TreeWalker *w = worker->walker;
+    int fd = open(dir->path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1)
+    {
+        atomic_fetch_add(&w->errors, 1);
+        return;
+    }
+    atomic_fetch_add(&w->directories, 1);
+
+    size_t prefix_len = strlen(dir->path);
+    WalkName *names = NULL;
+    size_t name_count = 0, name_capacity = 0;
+    long n;
+
+    while ((n = syscall(SYS_getdents64, fd, worker->dents, WALK_DENTS_BUFFER))
+           > 0)
+    {
+        name_count = 0;
+        for (long off = 0; off < n;)
+        {
+            struct walk_dirent64 *d =
+                (struct walk_dirent64 *) (worker->dents + off);
+            off += d->d_reclen;
+
+            if (d->d_name[0] == '.'
+                && (d->d_name[1] == '\0'
+                    || (d->d_name[1] == '.' && d->d_name[2] == '\0')))
+            {
+                continue;
+            }
+            if (name_count == name_capacity)
+            {
+                name_capacity = name_capacity ? name_capacity * 2 : 256;
+                WalkName *grown = (WalkName *) realloc(
+                    names, name_capacity * sizeof(WalkName));
+                if (!grown) abort();
+                names = grown;
+            }
+            names[name_count++] =
+                (WalkName) {d->d_ino, d->d_type, d->d_name};
+        }
+
+        // Stat in inode order: neighbouring inodes share disk blocks
+        unsigned int mask = w->options.stat_mask;
+        if (mask && name_count > 1)
+        {
+            qsort(names, name_count, sizeof(WalkName), walk_compare_ino);
+        }
+
+        for (size_t i = 0; i < name_count; i++)
+        {
+            size_t name_len = strlen(names[i].name);
+            if (prefix_len + 1 + name_len >= PATH_MAX)
+            {
+                atomic_fetch_add(&w->errors, 1);
+                continue;
+            }
+
+            size_t path_len = prefix_len + 1 + name_len;
+            WalkEntry *entry = walk_add_entry(worker, path_len);
+            if (!entry) abort();
+
+            char *path = (char *) entry->path;
+            memcpy(path, dir->path, prefix_len);
+            path[prefix_len] = '/';
+            memcpy(path + prefix_len + 1, names[i].name, name_len + 1);
+            entry->name = path + prefix_len + 1;
+            entry->ino = names[i].ino;
+            entry->type = names[i].type;
+            entry->depth = dir->depth + 1;
+            entry->stat_ok = 0;
+
+            // Some filesystems leave d_type unknown: the type is the
+            // least we need to decide whether to descend
+            unsigned int want = mask;
+            if (entry->type == DT_UNKNOWN) want |= STATX_TYPE;
+            if (want)
+            {
+                if (statx(fd,
+                          names[i].name,
+                          AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC,
+                          want,
+                          &entry->stx)
+                    == 0)
+                {
+                    entry->stat_ok = 1;
+                    if (entry->type == DT_UNKNOWN)
+                    {
+                        entry->type = walk_type_from_mode(entry->stx.stx_mode);
+                    }
+                }
+                else
+                {
+                    atomic_fetch_add(&w->errors, 1);
+                }
+            }
+
+            if (entry->type == DT_DIR)
+            {
+                walk_push_dir(w, worker->index, path, entry->depth);
+            }
+        }
+        atomic_fetch_add(&w->entries, name_count);
+    }
+    if (n < 0) atomic_fetch_add(&w->errors, 1);
+
+    free(names);
+    close(fd);
+}
+
+// Find work: own deque first, then steal. Returns 0 when the walk is over.
+static int walk_next_dir(WalkWorker *worker, WalkDir *dir)
+{
+    TreeWalker *w = worker->walker;
+
+    while (!atomic_load(&w->stop))
+    {
+        if (walk_deque_take(&w->deques[worker->index], dir, 0)) return 1;
+        for (int i = 1; i < w->worker_count; i++)
+        {
+            int victim = (worker->index + i) % w->worker_count;
+            if (walk_deque_take(&w->deques[victim], dir, 1))
+            {
+                atomic_fetch_add(&w->steals, 1);
+                return 1;
+            }
+        }
+
+        // Nothing anywhere: hand over what we have, then sleep until a
+        // push or the end of the walk
+        if (worker->batch && worker->batch->count)
+        {
+            walk_publish(w, worker->batch);
+            worker->batch = NULL;
+        }
+
+        pthread_mutex_lock(&w->idle_lock);
+        atomic_fetch_add(&w->idle, 1);
+        int found = 0;
+        for (int i = 0; i < w->worker_count && !found; i++)
+        {
+            found = walk_deque_take(&w->deques[i], dir, 1);
+        }
+        while (!found && atomic_load(&w->pending) > 0
+               && !atomic_load(&w->stop))
+        {
+            pthread_cond_wait(&w->idle_cond, &w->idle_lock);
+            for (int i = 0; i < w->worker_count && !found; i++)
+            {
+                found = walk_deque_take(&w->deques[i], dir, 1);
+            }
+        }
+        atomic_fetch_sub(&w->idle, 1);
+        pthread_mutex_unlock(&w->idle_lock);
+
+        if (found) return 1;
+        if (atomic_load(&w->pending) == 0) return 0;
+    }
+    return 0;
+}
+
+static void *walk_worker_main(void *arg)
+{
+    WalkWorker *worker = (WalkWorker *) arg;
+    TreeWalker *w = worker->walker;
+    WalkDir dir;
+
+    char thread_name[32];
+    snprintf(thread_name, sizeof(thread_name), "walker %d", worker->index);
+    scope_trace_thread_name(thread_name);
+
+    while (walk_next_dir(worker, &dir))
+    {
+        if (!atomic_load(&w->stop)) walk_directory(worker, &dir);
+        free(dir.path);
+
+        if (atomic_fetch_sub(&w->pending, 1) == 1)
+        {
+            // Last directory done: release every sleeping worker
+            pthread_mutex_lock(&w->idle_lock);
+            pthread_cond_broadcast(&w->idle_cond);
+            pthread_mutex_unlock(&w->idle_lock);
+        }
+    }
+
+    if (worker->batch && worker->batch->count && !atomic_load(&w->stop))
+    {
+        walk_publish(w, worker->batch);
+    }
+    else
+    {
+        free(worker->batch);
+    }
+    worker->batch = NULL;
+
+    pthread_mutex_lock(&w->out_lock);
+    if (--w->workers_running == 0) pthread_cond_broadcast(&w->out_ready);
+    pthread_mutex_unlock(&w->out_lock);
+    return NULL;
+}
+
+// Start walking root in the background. Returns NULL on failure.
+TreeWalker *tree_walker_open(const char *root, const WalkOptions *options)
+{
+    TreeWalker *w = (TreeWalker *) calloc(1, sizeof(TreeWalker));
+    if (!w) return NULL;
+
+    if (options) w->options = *options;
+    w->worker_count = w->options.threads;
+    if (w->worker_count <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        w->worker_count = cpus > 0 ? (int) cpus : 1;
+    }
+
+    w->workers = (WalkWorker *) calloc(w->worker_count, sizeof(WalkWorker));
+    w->deques = (WalkDeque *) calloc(w->worker_count, sizeof(WalkDeque));
+    if (!w->workers || !w->deques)
+    {
+        free(w->workers);
+        free(w->deques);
+        free(w);
+        return NULL;
+    }
+
+    pthread_mutex_init(&w->idle_lock, NULL);
+    pthread_cond_init(&w->idle_cond, NULL);
+    pthread_mutex_init(&w->out_lock, NULL);
+    pthread_cond_init(&w->out_ready, NULL);
+    pthread_cond_init(&w->out_space, NULL);
+
+    // Strip trailing slashes so joined paths stay clean
+    char start[PATH_MAX];
+    snprintf(start, sizeof(start), "%s", root);
+    size_t len = strlen(start);
+    while (len > 1 && start[len - 1] == '/') start[--len] = '\0';
+
+    for (int i = 0; i < w->worker_count; i++)
+    {
+        pthread_mutex_init(&w->deques[i].lock, NULL);
+        w->workers[i].walker = w;
+        w->workers[i].index = i;
+    }
+    walk_push_dir(w, 0, start, 0);
+
+    w->workers_running = w->worker_count;
+    for (int i = 0; i < w->worker_count; i++)
+    {
+        w->workers[i].dents = (char *) malloc(WALK_DENTS_BUFFER);
+        if (!w->workers[i].dents) abort();
+        pthread_create(
+            &w->workers[i].thread, NULL, walk_worker_main, &w->workers[i]);
+    }
+    return w;
+}
+
+// Next entry in arrival order (not sorted), or NULL when the walk is done.
+// The entry stays valid until the following call. Consumer side only.
+const WalkEntry *tree_walker_next(TreeWalker *w)
+{
+    if (w->current && w->current_index < w->current->count)
+    {
+        return &w->current->entries[w->current_index++];
+    }
+
+    pthread_mutex_lock(&w->out_lock);
+    free(w->current);
+    w->current = NULL;
+    while (!w->out_head && w->workers_running > 0)
+    {
+        pthread_cond_wait(&w->out_ready, &w->out_lock);
+    }
+    if (w->out_head)
+    {
+        w->current = w->out_head;
+        w->out_head = w->current->next;
+        if (!w->out_head) w->out_tail = NULL;
+        w->out_count--;
+        pthread_cond_signal(&w->out_space);
+    }
+    pthread_mutex_unlock(&w->out_lock);
+
+    if (!w->current) return NULL;
+    w->current_index = 1;
+    return &w->current->entries[0];
+}
+
+void tree_walker_stats(TreeWalker *w, WalkStats *stats)
+{
+    stats->directories = atomic_load(&w->directories);
+    stats->entries = atomic_load(&w->entries);
+    stats->errors = atomic_load(&w->errors);
+    stats->steals = atomic_load(&w->steals);
+}
+
+// Stop (if still running) and free everything
+void tree_walker_close(TreeWalker *w)
+{
+    atomic_store(&w->stop, 1);
+    pthread_mutex_lock(&w->idle_lock);
+    pthread_cond_broadcast(&w->idle_cond);
+    pthread_mutex_unlock(&w->idle_lock);
+    pthread_mutex_lock(&w->out_lock);
+    pthread_cond_broadcast(&w->out_space);
+    pthread_mutex_unlock(&w->out_lock);
+
+    for (int i = 0; i < w->worker_count; i++)
+    {
+        pthread_join(w->workers[i].thread, NULL);
+        free(w->workers[i].dents);
+    }
+
+    free(w->current);
+    while (w->out_head)
+    {
+        WalkBatch *next = w->out_head->next;
+        free(w->out_head);
+        w->out_head = next;
+    }
+    for (int i = 0; i < w->worker_count; i++)
+    {
+        WalkDeque *dq = &w->deques[i];
+        for (size_t j = dq->head; j < dq->tail; j++) free(dq->items[j].path);
+        free(dq->items);
+        pthread_mutex_destroy(&dq->lock);
+    }
+
+    pthread_mutex_destroy(&w->idle_lock);
+    pthread_cond_destroy(&w->idle_cond);
+    pthread_mutex_destroy(&w->out_lock);
+    pthread_cond_destroy(&w->out_ready);
+    pthread_cond_destroy(&w->out_space);
+    free(w->workers);
+    free(w->deques);
+    free(w);
+}
+
+// Baseline: the readdir + stat-per-entry approach, recursively
+static void readdir_walk(const char *path, unsigned long long *count,
+                         unsigned long long *bytes)
+{
+    TRACE_FUNCTION();
+    DIR *dir = opendir(path);
+    if (!dir) return;
+
+    struct dirent *entry;
+    char child[PATH_MAX];
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+        snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+
+        struct stat info;
+        if (lstat(child, &info) == -1) continue;
+        (*count)++;
+        *bytes += info.st_size;
+        if (S_ISDIR(info.st_mode)) readdir_walk(child, count, bytes);
+    }
+    closedir(dir);
+}
+
+static double walk_seconds(void)
 {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Walk a tree and print totals; threads 0 = one per CPU
+static void walk_and_report(const char *root, int threads,
+                            unsigned int stat_mask)
+{
+    WalkOptions options = {threads, stat_mask};
+    double start = walk_seconds();
+    TreeWalker *w = tree_walker_open(root, &options);
+    if (!w)
+    {
+        perror("tree_walker_open");
+        return;
+    }
+
+    unsigned long long count = 0, bytes = 0;
+    const WalkEntry *entry;
+    while ((entry = tree_walker_next(w)) != NULL)
+    {
+        count++;
+        if (entry->stat_ok && (stat_mask & STATX_SIZE))
+        {
+            bytes += entry->stx.stx_size;
+        }
+    }
+    double elapsed = walk_seconds() - start;
+
+    WalkStats stats;
+    tree_walker_stats(w, &stats);
+    int workers = w->worker_count;
+    tree_walker_close(w);
+
+    printf("walker %2d thread(s)%s: %llu entries, %llu bytes, %llu dirs, "
+           "%llu steals, %llu errors in %.3f s\n",
+           workers,
+           stat_mask ? " +size" : "      ",
+           count,
+           bytes,
+           stats.directories,
+           stats.steals,
+           stats.errors,
+           elapsed);
+}
+
+// Progress callback: one status line per quarter of the file
+static void copy_progress(const FileCopyStatus *status, void *arg)
+{
+    int *last_quarter = (int *) arg;
+    int quarter = status->total ? (int) (status->copied * 4 / status->total) : 4;
+    if (quarter == *last_quarter) return;
+    *last_quarter = quarter;
+    printf("    %-15s %3d%%  %llu / %llu bytes\n",
+           file_copy_method_name(status->method),
+           quarter * 25,
+           (unsigned long long) status->copied,
+           (unsigned long long) status->total);
+}
+
+// Copy one file and print which method did it and how fast
+static int copy_and_report(const char *source, const char *destination,
+                           FileCopyMethod first, int verbose)
+{
+    int last_quarter = 0;
+    FileCopyOptions options = {first, verbose ? copy_progress : NULL,
+                               &last_quarter};
+    FileCopyStatus status;
+    double start = walk_seconds();
+    int error = file_copy(source, destination, &options, &status);
+    double elapsed = walk_seconds() - start;
+    if (error != 0)
+    {
+        fprintf(stderr, "file_copy %s: %s\n", source, strerror(-error));
+        return -1;
+    }
+    printf("  start at %-15s -> done by %-15s %8.1f MB/s (%.3f s)\n",
+           file_copy_method_name(first),
+           file_copy_method_name(status.method),
+           elapsed > 0 ? status.copied / elapsed / 1e6 : 0.0,
+           elapsed);
+    return 0;
+}
+
+// Stage a larger file through each method in turn
+void file_copy_demo()
+{
+    const char *source = "posix_copy_src.bin";
+    const char *destination = "posix_copy_dst.bin";
+    const size_t size = 64u << 20;
+
+    int fd = open(source, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        perror("open");
+        return;
+    }
+    char block[65536];
+    for (size_t i = 0; i < sizeof(block); i++) block[i] = (char) (i * 131);
+    for (size_t done = 0; done < size; done += sizeof(block))
+    {
+        if (write(fd, block, sizeof(block)) != (ssize_t) sizeof(block))
+        {
+            perror("write");
+            break;
+        }
+    }
+    close(fd);
+
+    printf("Copying a %zu MiB file:\n", size >> 20);
+    for (FileCopyMethod m = FILE_COPY_CLONE; m < FILE_COPY_METHODS; m++)
+    {
+        if (copy_and_report(source, destination, m, m == FILE_COPY_BUFFERED)
+            != 0)
+        {
+            break;
+        }
+    }
+
+    unlink(source);
+    unlink(destination);
+}
+
+// Demonstrate the parallel walker against readdir + stat
+void tree_walk_demo()
+{
+    const char *root = "posix_walk";
+    const int top = 40, sub = 25, files = 20;
+
+    printf("Building %d directories with %d files each...\n",
+           top * sub,
+           files);
+    mkdir(root, 0755);
+    char path[PATH_MAX];
+    for (int i = 0; i < top; i++)
+    {
+        snprintf(path, sizeof(path), "%s/d%02d", root, i);
+        mkdir(path, 0755);
+        for (int j = 0; j < sub; j++)
+        {
+            snprintf(path, sizeof(path), "%s/d%02d/s%02d", root, i, j);
+            mkdir(path, 0755);
+            for (int k = 0; k < files; k++)
+            {
+                snprintf(path,
+                         sizeof(path),
+                         "%s/d%02d/s%02d/f%02d",
+                         root,
+                         i,
+                         j,
+                         k);
+                int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (fd == -1) continue;
+                if (write(fd, path, k) != k) perror("write");
+                close(fd);
+            }
+        }
+    }
+
+    unsigned long long count = 0, bytes = 0;
+    double start = walk_seconds();
+    readdir_walk(root, &count, &bytes);
+    printf("readdir + stat:     %llu entries, %llu bytes in %.3f s\n",
+           count,
+           bytes,
+           walk_seconds() - start);
+
+    walk_and_report(root, 1, 0);
+    walk_and_report(root, 1, STATX_SIZE);
+    walk_and_report(root, 4, STATX_SIZE);
+    walk_and_report(root, 0, STATX_SIZE);
+
+    system("rm -rf posix_walk");
+}
+
+int main(int argc, char *argv[])
+{
+    // ./main --walk <dir> [threads]: walk a real tree and report totals
+    scope_trace_thread_name("main");
+    if (argc > 2 && strcmp(argv[1], "--walk") == 0)
+    {
+        walk_and_report(argv[2], argc > 3 ? atoi(argv[3]) : 0, STATX_SIZE);
+        scope_trace_write_json("posix_trace.json");
+        return 0;
+    }
+
+    // ./main --copy <src> <dst>: copy a file with the fastest method
+    if (argc > 3 && strcmp(argv[1], "--copy") == 0)
+    {
+        return copy_and_report(argv[2], argv[3], FILE_COPY_CLONE, 1) == 0 ? 0 : 1;
+    }
+
     printf("=== POSIX API Demonstration ===\n\n");
 
     printf("--- POSIX File Operations ---\n");
@@ -265,11 +1147,20 @@ int main()
     printf("\n--- Directory Operations ---\n");
     directory_operations();
 
+    printf("\n--- Parallel Tree Walk ---\n");
+    tree_walk_demo();
+
+    printf("\n--- File Copy ---\n");
+    file_copy_demo();
+
     printf("\n--- POSIX Time Functions ---\n");
     time_functions();
 
     // Clean up the directory created for demonstration
     system("rm -rf posix_dir");
 
+    long spans = scope_trace_write_json("posix_trace.json");
+    if (spans > 0) printf("\nWrote %ld spans to posix_trace.json\n", spans);
+
     return 0;
 }
@@ -1,25 +1,59 @@
+#define _GNU_SOURCE
 #include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
 #include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
 #include <sys/select.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <linux/errqueue.h>
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#endif
+
+// Build with -DSCOPE_TRACE to record accept/read/flush/wait spans per
+// shard thread into network_trace.json on exit
+#include "../../../05-advanced-programming/scope_trace.h"
+#include "../fast_clock.h"
+
 // Flag for graceful termination
 volatile sig_atomic_t keep_running = 1;
 
+// Set by SIGUSR1 to request a stats dump from the sharded server
+volatile sig_atomic_t dump_stats = 0;
+
 // Signal handler
 void handle_signal(int sig)
 {
     keep_running = 0;
 }
 
+void handle_stats_signal(int sig)
+{
+    (void) sig;
+    dump_stats = 1;
+}
+
 // Function to make a socket non-blocking
 int make_nonblocking(int sockfd)
 {
@@ -39,265 +73,2664 @@ int make_nonblocking(int sockfd)
     return 0;
 }
 
-// TCP Server implementation
-void tcp_server(int port)
+static long monotonic_ms(void)
 {
-    int server_fd, client_fd;
-    struct sockaddr_in server_addr, client_addr;
-    socklen_t client_len = sizeof(client_addr);
-    char buffer[1024];
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
 
-    // Create socket
-    server_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd < 0)
+// ===== Signal Delivery =====
+//
+// The servers do not react to signals from asynchronous handlers that set
+// flags for the loop to poll. SIGINT/SIGTERM (drain and stop), SIGHUP
+// (reload) and SIGUSR1 (stats) are blocked and read from a descriptor that
+// sits in the event loop next to the sockets: a signalfd on Linux, a
+// self-pipe fed by a one-line handler elsewhere. The loop can then block
+// without a timeout and still see a signal at once, and no syscall on the
+// I/O path is interrupted with EINTR.
+
+static const int server_signals[] = {SIGINT, SIGTERM, SIGHUP, SIGUSR1};
+#define SERVER_SIGNAL_COUNT ((int) (sizeof(server_signals) / sizeof(server_signals[0])))
+
+#ifndef __linux__
+static int signal_pipe[2] = {-1, -1};
+
+static void signal_pipe_handler(int sig)
+{
+    int saved_errno = errno;
+    unsigned char byte = (unsigned char) sig;
+    if (write(signal_pipe[1], &byte, 1) < 0)
     {
-        perror("socket creation failed");
-        return;
+        // Pipe full: a wakeup is already pending
     }
+    errno = saved_errno;
+}
+#endif
 
-    // Set socket options to reuse address
-    int opt = 1;
-    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0)
+// Start routing the server signals to a non-blocking descriptor; returns
+// it, or -1 if the caller has to fall back to signal handlers. Call before
+// creating threads so they inherit the blocked mask.
+int signal_channel_open(void)
+{
+#ifdef __linux__
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int i = 0; i < SERVER_SIGNAL_COUNT; i++)
     {
-        perror("setsockopt");
-        close(server_fd);
-        return;
+        sigaddset(&mask, server_signals[i]);
+    }
+    if (pthread_sigmask(SIG_BLOCK, &mask, NULL) != 0)
+    {
+        return -1;
     }
 
-    // Set up server address structure
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(port);
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0)
+    {
+        perror("signalfd");
+        pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+    }
+    return fd;
+#else
+    if (pipe(signal_pipe) < 0)
+    {
+        perror("pipe");
+        return -1;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        make_nonblocking(signal_pipe[i]);
+        fcntl(signal_pipe[i], F_SETFD, FD_CLOEXEC);
+    }
 
-    // Bind socket to specified port
-    if (bind(server_fd, (struct sockaddr *) &server_addr, sizeof(server_addr))
-        < 0)
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = signal_pipe_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    for (int i = 0; i < SERVER_SIGNAL_COUNT; i++)
     {
-        perror("bind failed");
-        close(server_fd);
-        return;
+        sigaction(server_signals[i], &action, NULL);
     }
+    return signal_pipe[0];
+#endif
+}
 
-    // Start listening for connections
-    if (listen(server_fd, 5) < 0)
+// Next pending signal number, or 0 when none is queued
+int signal_channel_next(int fd)
+{
+#ifdef __linux__
+    struct signalfd_siginfo info;
+    if (read(fd, &info, sizeof(info)) == (ssize_t) sizeof(info))
+    {
+        return (int) info.ssi_signo;
+    }
+#else
+    unsigned char byte;
+    if (read(fd, &byte, 1) == 1)
+    {
+        return byte;
+    }
+#endif
+    return 0;
+}
+
+// Close the channel and restore default signal delivery
+void signal_channel_close(int fd)
+{
+    if (fd < 0)
     {
-        perror("listen failed");
-        close(server_fd);
         return;
     }
+    close(fd);
+#ifdef __linux__
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int i = 0; i < SERVER_SIGNAL_COUNT; i++)
+    {
+        sigaddset(&mask, server_signals[i]);
+    }
+    pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+#else
+    for (int i = 0; i < SERVER_SIGNAL_COUNT; i++)
+    {
+        signal(server_signals[i], SIG_DFL);
+    }
+    close(signal_pipe[1]);
+    signal_pipe[0] = signal_pipe[1] = -1;
+#endif
+}
 
-    printf("TCP Server listening on port %d...\n", port);
+// ===== Event Loop Backends =====
+//
+// tcp_server waits for ready sockets through a small backend interface.
+// epoll (edge-triggered) and io_uring (multishot poll) report only the
+// sockets that became ready; select is the portable fallback and limited
+// to FD_SETSIZE descriptors. With edge-triggered readiness every handler
+// must drain its socket until EAGAIN, which is also correct for select.
+// Sockets are watched for reading; write interest is switched on only
+// while a connection has output the kernel would not take.
 
-    // Set up signal handler for graceful termination
-    signal(SIGINT, handle_signal);
+#define MAX_READY_EVENTS 1024
 
-    // Make server socket non-blocking
-    make_nonblocking(server_fd);
+typedef enum
+{
+    EVENT_BACKEND_SELECT,
+    EVENT_BACKEND_EPOLL,
+    EVENT_BACKEND_IO_URING,
+} EventBackendType;
+
+typedef struct EventLoop EventLoop;
+
+typedef struct
+{
+    const char *name;
+    int (*init)(EventLoop *loop);
+    int (*add)(EventLoop *loop, int fd);
+    void (*remove)(EventLoop *loop, int fd);
+    void (*set_write)(EventLoop *loop, int fd, int enabled);
+    // Fill ready[] with ready descriptors; returns count or -1. A negative
+    // timeout blocks until something is ready.
+    int (*wait)(EventLoop *loop, int *ready, int max_ready, int timeout_ms);
+    void (*destroy)(EventLoop *loop);
+} EventBackend;
+
+#ifdef __linux__
+typedef struct
+{
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_entries, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_size, cq_ring_size, sqes_size;
+    unsigned *generation;   // Per-fd counter so stale CQEs can be ignored
+    unsigned char *armed;   // Per-fd: a poll request is registered
+    unsigned char *write_armed;  // Per-fd: a one-shot POLLOUT is pending
+    int max_fds;
+} IoUring;
+#endif
+
+struct EventLoop
+{
+    const EventBackend *backend;
 
-    // Set up file descriptor set for select()
-    fd_set read_fds, master_fds;
-    int max_fd = server_fd;
+    // select
+    fd_set master_fds;
+    fd_set write_fds;
+    int max_fd;
 
-    FD_ZERO(&master_fds);
-    FD_SET(server_fd, &master_fds);
+#ifdef __linux__
+    // epoll
+    int epoll_fd;
+    struct epoll_event events[MAX_READY_EVENTS];
 
-    // Server main loop
-    while (keep_running)
+    // io_uring
+    IoUring ring;
+#endif
+};
+
+// --- select ---
+
+int select_init(EventLoop *loop)
+{
+    FD_ZERO(&loop->master_fds);
+    FD_ZERO(&loop->write_fds);
+    loop->max_fd = -1;
+    return 0;
+}
+
+int select_add(EventLoop *loop, int fd)
+{
+    if (fd >= FD_SETSIZE)
     {
-        // Copy master set to read_fds for select()
-        read_fds = master_fds;
+        fprintf(stderr, "select: fd %d exceeds FD_SETSIZE (%d)\n", fd, FD_SETSIZE);
+        return -1;
+    }
 
-        // Set timeout for select (100ms)
-        struct timeval timeout;
-        timeout.tv_sec = 0;
-        timeout.tv_usec = 100000;
+    FD_SET(fd, &loop->master_fds);
+    if (fd > loop->max_fd)
+    {
+        loop->max_fd = fd;
+    }
+    return 0;
+}
+
+void select_remove(EventLoop *loop, int fd)
+{
+    FD_CLR(fd, &loop->master_fds);
+    FD_CLR(fd, &loop->write_fds);
+    while (loop->max_fd >= 0 && !FD_ISSET(loop->max_fd, &loop->master_fds))
+    {
+        loop->max_fd--;
+    }
+}
+
+void select_set_write(EventLoop *loop, int fd, int enabled)
+{
+    if (enabled)
+    {
+        FD_SET(fd, &loop->write_fds);
+    }
+    else
+    {
+        FD_CLR(fd, &loop->write_fds);
+    }
+}
 
-        // Wait for activity on any of the sockets
-        int activity = select(max_fd + 1, &read_fds, NULL, NULL, &timeout);
+int select_wait(EventLoop *loop, int *ready, int max_ready, int timeout_ms)
+{
+    // select() overwrites its sets, so they are rebuilt from the masters
+    fd_set read_fds = loop->master_fds;
+    fd_set write_fds = loop->write_fds;
+    struct timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+    int activity = select(
+        loop->max_fd + 1, &read_fds, &write_fds, NULL, timeout_ms < 0 ? NULL : &timeout);
+    if (activity <= 0)
+    {
+        return activity < 0 && errno != EINTR ? -1 : 0;
+    }
 
-        if (activity < 0 && errno != EINTR)
+    int count = 0;
+    for (int fd = 0; fd <= loop->max_fd && count < max_ready; fd++)
+    {
+        if (FD_ISSET(fd, &read_fds) || FD_ISSET(fd, &write_fds))
         {
-            perror("select");
-            break;
+            ready[count++] = fd;
         }
+    }
+    return count;
+}
 
-        // Check for new connections on server socket
-        if (FD_ISSET(server_fd, &read_fds))
-        {
-            client_fd = accept(
-                server_fd, (struct sockaddr *) &client_addr, &client_len);
-            if (client_fd < 0)
-            {
-                if (errno != EAGAIN && errno != EWOULDBLOCK)
-                {
-                    perror("accept");
-                }
-            }
-            else
-            {
-                printf("New connection from %s:%d\n",
-                       inet_ntoa(client_addr.sin_addr),
-                       ntohs(client_addr.sin_port));
+void select_destroy(EventLoop *loop)
+{
+    (void) loop;
+}
 
-                // Add new client to master set
-                FD_SET(client_fd, &master_fds);
-                if (client_fd > max_fd)
-                {
-                    max_fd = client_fd;
-                }
+static const EventBackend select_backend = {"select",
+                                            select_init,
+                                            select_add,
+                                            select_remove,
+                                            select_set_write,
+                                            select_wait,
+                                            select_destroy};
 
-                // Send welcome message
-                const char *welcome = "Welcome to the TCP server!\n";
-                send(client_fd, welcome, strlen(welcome), 0);
-            }
-        }
+#ifdef __linux__
+// --- epoll (edge-triggered) ---
 
-        // Check existing connections for data
-        for (int i = 0; i <= max_fd; i++)
-        {
-            if (i != server_fd && FD_ISSET(i, &read_fds))
-            {
-                memset(buffer, 0, sizeof(buffer));
-                int bytes_read = recv(i, buffer, sizeof(buffer) - 1, 0);
+int epoll_backend_init(EventLoop *loop)
+{
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->epoll_fd < 0)
+    {
+        perror("epoll_create1");
+        return -1;
+    }
+    return 0;
+}
 
-                if (bytes_read <= 0)
-                {
-                    // Connection closed or error
-                    if (bytes_read == 0)
-                    {
-                        printf("Client disconnected\n");
-                    }
-                    else
-                    {
-                        perror("recv");
-                    }
+int epoll_backend_add(EventLoop *loop, int fd)
+{
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    event.data.fd = fd;
 
-                    close(i);
-                    FD_CLR(i, &master_fds);
-                }
-                else
-                {
-                    // Process received data
-                    buffer[bytes_read] = '\0';
-                    printf("Received from client %d: %s", i, buffer);
-
-                    // Echo back the message
-                    char response[1100];
-                    snprintf(
-                        response, sizeof(response), "Server echo: %s", buffer);
-                    send(i, response, strlen(response), 0);
-                }
-            }
-        }
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+        perror("epoll_ctl EPOLL_CTL_ADD");
+        return -1;
+    }
+    return 0;
+}
+
+void epoll_backend_remove(EventLoop *loop, int fd)
+{
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+void epoll_backend_set_write(EventLoop *loop, int fd, int enabled)
+{
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLET | (enabled ? EPOLLOUT : 0);
+    event.data.fd = fd;
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, fd, &event);
+}
+
+int epoll_backend_wait(EventLoop *loop, int *ready, int max_ready, int timeout_ms)
+{
+    if (max_ready > MAX_READY_EVENTS)
+    {
+        max_ready = MAX_READY_EVENTS;
+    }
+
+    int count = epoll_wait(loop->epoll_fd, loop->events, max_ready, timeout_ms);
+    if (count < 0)
+    {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        ready[i] = loop->events[i].data.fd;
+    }
+    return count;
+}
+
+void epoll_backend_destroy(EventLoop *loop)
+{
+    close(loop->epoll_fd);
+}
+
+static const EventBackend epoll_backend = {"epoll",
+                                           epoll_backend_init,
+                                           epoll_backend_add,
+                                           epoll_backend_remove,
+                                           epoll_backend_set_write,
+                                           epoll_backend_wait,
+                                           epoll_backend_destroy};
+
+// --- io_uring (multishot poll, raw syscalls, no liburing) ---
+
+#define IO_URING_ENTRIES   4096
+#define IO_URING_IGNORE    (~0ULL)  // user_data for POLL_REMOVE completions
+#define IO_URING_WRITE_BIT (1ULL << 63)  // Marks one-shot POLLOUT requests
+#define IO_URING_USER_DATA(fd, gen) \
+    (((uint64_t) ((gen) & 0x7fffffff) << 32) | (uint32_t) (fd))
+
+// Submit queued SQEs and optionally wait for completions
+static int io_uring_flush(IoUring *ring, unsigned min_complete, unsigned flags, void *arg, size_t arg_size)
+{
+    unsigned to_submit = *ring->sq_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    return (int) syscall(
+        __NR_io_uring_enter, ring->fd, to_submit, min_complete, flags, arg, arg_size);
+}
+
+static struct io_uring_sqe *io_uring_get_sqe(IoUring *ring)
+{
+    unsigned tail = *ring->sq_tail;
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+    if (tail - head == *ring->sq_entries)
+    {
+        // Ring full: hand what we have to the kernel first
+        if (io_uring_flush(ring, 0, 0, NULL, 0) < 0) return NULL;
+        head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        if (tail - head == *ring->sq_entries) return NULL;
+    }
+
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+static int io_uring_arm_poll(IoUring *ring, int fd)
+{
+    struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+    if (!sqe) return -1;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN | POLLRDHUP;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = IO_URING_USER_DATA(fd, ring->generation[fd]);
+    ring->armed[fd] = 1;
+    return 0;
+}
+
+int io_uring_backend_init(EventLoop *loop)
+{
+    IoUring *ring = &loop->ring;
+    memset(ring, 0, sizeof(*ring));
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int) syscall(__NR_io_uring_setup, IO_URING_ENTRIES, &params);
+    if (ring->fd < 0)
+    {
+        perror("io_uring_setup");
+        return -1;
+    }
+
+    // Waiting with a timeout needs IORING_ENTER_EXT_ARG (Linux 5.11)
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_SINGLE_MMAP))
+    {
+        fprintf(stderr, "io_uring: kernel lacks EXT_ARG/SINGLE_MMAP\n");
+        close(ring->fd);
+        return -1;
+    }
+
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (ring->cq_ring_size > ring->sq_ring_size)
+    {
+        ring->sq_ring_size = ring->cq_ring_size;
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    // One mapping covers both rings (IORING_FEAT_SINGLE_MMAP)
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sq_ring == MAP_FAILED || ring->sqes == MAP_FAILED)
+    {
+        perror("io_uring mmap");
+        if (ring->sq_ring != MAP_FAILED) munmap(ring->sq_ring, ring->sq_ring_size);
+        if (ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_size);
+        close(ring->fd);
+        return -1;
+    }
+    ring->cq_ring = ring->sq_ring;
+
+    char *sq = (char *) ring->sq_ring;
+    ring->sq_head = (unsigned *) (sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *) (sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *) (sq + params.sq_off.ring_mask);
+    ring->sq_entries = (unsigned *) (sq + params.sq_off.ring_entries);
+    ring->sq_array = (unsigned *) (sq + params.sq_off.array);
+    ring->cq_head = (unsigned *) (sq + params.cq_off.head);
+    ring->cq_tail = (unsigned *) (sq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *) (sq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (sq + params.cq_off.cqes);
+
+    struct rlimit limit;
+    ring->max_fds = getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY
+                        ? (int) limit.rlim_cur
+                        : 65536;
+    ring->generation = (unsigned *) calloc(ring->max_fds, sizeof(unsigned));
+    ring->armed = (unsigned char *) calloc(ring->max_fds, 1);
+    ring->write_armed = (unsigned char *) calloc(ring->max_fds, 1);
+    if (!ring->generation || !ring->armed || !ring->write_armed)
+    {
+        fprintf(stderr, "io_uring: out of memory\n");
+        free(ring->generation);
+        free(ring->armed);
+        free(ring->write_armed);
+        munmap(ring->sqes, ring->sqes_size);
+        munmap(ring->sq_ring, ring->sq_ring_size);
+        close(ring->fd);
+        return -1;
+    }
+
+    return 0;
+}
+
+int io_uring_backend_add(EventLoop *loop, int fd)
+{
+    IoUring *ring = &loop->ring;
+    if (fd >= ring->max_fds)
+    {
+        fprintf(stderr, "io_uring: fd %d exceeds RLIMIT_NOFILE\n", fd);
+        return -1;
+    }
+    return io_uring_arm_poll(ring, fd);
+}
+
+// Cancel a poll request; the pending request keeps the file open until then
+static void io_uring_cancel_poll(IoUring *ring, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+    if (sqe)
+    {
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = user_data;
+        sqe->user_data = IO_URING_IGNORE;
+    }
+}
+
+void io_uring_backend_remove(EventLoop *loop, int fd)
+{
+    IoUring *ring = &loop->ring;
+    if (fd >= ring->max_fds || !ring->armed[fd]) return;
+
+    uint64_t user_data = IO_URING_USER_DATA(fd, ring->generation[fd]);
+    io_uring_cancel_poll(ring, user_data);
+    if (ring->write_armed[fd])
+    {
+        io_uring_cancel_poll(ring, user_data | IO_URING_WRITE_BIT);
+    }
+
+    // Completions still in flight for the old generation are dropped
+    ring->generation[fd]++;
+    ring->armed[fd] = 0;
+    ring->write_armed[fd] = 0;
+}
+
+// POLLOUT is one-shot: the connection asks again if it is still blocked
+void io_uring_backend_set_write(EventLoop *loop, int fd, int enabled)
+{
+    IoUring *ring = &loop->ring;
+    if (!enabled || fd >= ring->max_fds || ring->write_armed[fd]) return;
+
+    struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+    if (!sqe) return;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLOUT;
+    sqe->user_data = IO_URING_USER_DATA(fd, ring->generation[fd]) | IO_URING_WRITE_BIT;
+    ring->write_armed[fd] = 1;
+}
+
+int io_uring_backend_wait(EventLoop *loop, int *ready, int max_ready, int timeout_ms)
+{
+    IoUring *ring = &loop->ring;
+
+    struct __kernel_timespec ts;
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (long long) (timeout_ms % 1000) * 1000000;
+
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.ts = timeout_ms < 0 ? 0 : (uint64_t) (uintptr_t) &ts;
+
+    // Only block if nothing is waiting in the completion queue already
+    unsigned min_complete
+        = *ring->cq_head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE) ? 1 : 0;
+    if (io_uring_flush(ring, min_complete, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg,
+                       sizeof(arg))
+            < 0
+        && errno != ETIME && errno != EINTR && errno != EBUSY)
+    {
+        perror("io_uring_enter");
+        return -1;
     }
 
-    // Clean up - close all sockets
-    for (int i = 0; i <= max_fd; i++)
+    int count = 0;
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail && count < max_ready)
     {
-        if (FD_ISSET(i, &master_fds))
+        struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+        head++;
+
+        if (cqe->user_data == IO_URING_IGNORE) continue;
+
+        int fd = (int) (uint32_t) cqe->user_data;
+        unsigned gen = (unsigned) (cqe->user_data >> 32) & 0x7fffffff;
+        if (fd >= ring->max_fds || gen != (ring->generation[fd] & 0x7fffffff)
+            || !ring->armed[fd])
+        {
+            continue;
+        }
+
+        if (cqe->res > 0)
+        {
+            ready[count++] = fd;
+        }
+
+        if (cqe->user_data & IO_URING_WRITE_BIT)
+        {
+            ring->write_armed[fd] = 0;
+            continue;
+        }
+
+        // Kernel ended the multishot request (e.g. CQ overflow): re-arm
+        if (!(cqe->flags & IORING_CQE_F_MORE))
         {
-            close(i);
+            io_uring_arm_poll(ring, fd);
         }
     }
 
-    printf("\nTCP Server shut down\n");
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    return count;
 }
 
-// TCP Client implementation
-void tcp_client(const char *server_ip, int port)
+void io_uring_backend_destroy(EventLoop *loop)
 {
-    int sock_fd;
-    struct sockaddr_in server_addr;
-    char buffer[1024];
+    IoUring *ring = &loop->ring;
+    free(ring->generation);
+    free(ring->armed);
+    free(ring->write_armed);
+    munmap(ring->sqes, ring->sqes_size);
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+}
 
-    // Create socket
-    sock_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock_fd < 0)
+static const EventBackend io_uring_backend = {"io_uring",
+                                              io_uring_backend_init,
+                                              io_uring_backend_add,
+                                              io_uring_backend_remove,
+                                              io_uring_backend_set_write,
+                                              io_uring_backend_wait,
+                                              io_uring_backend_destroy};
+#endif
+
+// Start the requested backend, falling back io_uring -> epoll -> select
+int event_loop_init(EventLoop *loop, EventBackendType type)
+{
+#ifdef __linux__
+    if (type == EVENT_BACKEND_IO_URING)
+    {
+        loop->backend = &io_uring_backend;
+        if (loop->backend->init(loop) == 0) return 0;
+        fprintf(stderr, "io_uring unavailable, falling back to epoll\n");
+        type = EVENT_BACKEND_EPOLL;
+    }
+    if (type == EVENT_BACKEND_EPOLL)
+    {
+        loop->backend = &epoll_backend;
+        if (loop->backend->init(loop) == 0) return 0;
+        fprintf(stderr, "epoll unavailable, falling back to select\n");
+    }
+#else
+    (void) type;
+#endif
+    loop->backend = &select_backend;
+    return loop->backend->init(loop);
+}
+
+// Parse a backend name from the command line
+EventBackendType parse_event_backend(const char *name)
+{
+    if (name && strcmp(name, "select") == 0) return EVENT_BACKEND_SELECT;
+    if (name && strcmp(name, "io_uring") == 0) return EVENT_BACKEND_IO_URING;
+    return EVENT_BACKEND_EPOLL;
+}
+
+// Lift the soft descriptor limit to the hard limit so the server can hold
+// tens of thousands of connections
+void raise_fd_limit(void)
+{
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// ===== Per-Connection Buffers =====
+//
+// Each client has an input ring that also serves as the output payload:
+// the echo for a message is the constant prefix plus the received bytes,
+// so responses are gathered straight out of the ring with sendmsg()
+// instead of being formatted into a separate buffer. Connections with
+// output are put on a dirty list and flushed once per loop iteration,
+// coalescing every response queued for a client into one syscall. When
+// the kernel will not take more, the connection waits for writability,
+// and a full ring stops reads so TCP flow control pushes back on the
+// client. Large flushes use MSG_ZEROCOPY where available; those ring bytes
+// stay pinned until the kernel reports completion on the error queue.
+
+#define CONN_RING_SIZE        65536  // Power of two; allocated on first data
+#define CONN_MAX_MESSAGES     256    // Messages queued for echo
+#define CONN_MAX_IOV          64     // iovecs gathered per sendmsg
+#define ZEROCOPY_THRESHOLD    16384  // Smaller sends are cheaper to copy
+#define ZEROCOPY_MAX_PENDING  32     // Zerocopy sends awaiting completion
+
+static const char echo_prefix[] = "Server echo: ";
+#define ECHO_PREFIX_LEN (sizeof(echo_prefix) - 1)
+
+typedef struct
+{
+    uint32_t id;     // Zerocopy send id (kernel counts from 0)
+    size_t release;  // Ring position freed once it completes
+} ZerocopySend;
+
+typedef struct Connection
+{
+    int fd;
+    char *ring;
+    size_t head;      // Oldest byte still needed (pinned by zerocopy)
+    size_t send_pos;  // Next payload byte to send
+    size_t tail;      // Next free byte
+
+    // Unsent messages; msg_len[msg_head] counts only its unsent payload
+    uint32_t msg_len[CONN_MAX_MESSAGES];
+    unsigned msg_head, msg_count;
+    size_t prefix_sent;  // Prefix bytes of the head message already sent
+
+    int zerocopy;  // SO_ZEROCOPY enabled on the socket
+    uint32_t zc_next_id;
+    ZerocopySend zc[ZEROCOPY_MAX_PENDING];
+    unsigned zc_head, zc_count;
+
+    int peer_closed;    // EOF seen; close once queued output is sent
+    int read_blocked;   // Stopped reading because the ring was full
+    int write_blocked;  // Waiting for the socket to become writable
+    int dirty;
+    struct Connection *next_dirty;
+} Connection;
+
+// One event loop with its own listening socket. tcp_server runs a single
+// shard on the calling thread; tcp_server_sharded runs one per core.
+typedef struct
+{
+    int id;
+    int port;
+    int cpu;  // CPU to pin to, or -1
+    int listen_fd;
+    EventBackendType backend_type;
+    pthread_t thread;
+
+    // Control descriptors watched by the loop alongside the sockets
+    int signal_fd;    // Signal channel this loop reads itself, or -1
+    int wake_fds[2];  // Pipe the owner writes to start a drain, or -1
+    int draining;     // Stopped accepting; exits once output is flushed
+    long drain_deadline_ms;
+
+    // Open clients, indexed by fd
+    Connection **connections;
+    int connection_capacity;
+    Connection *dirty;  // Connections with output to flush this iteration
+
+    // Counters, readable from other threads while the shard runs
+    atomic_ulong accepted;
+    atomic_long active;
+    atomic_ulong messages;
+    atomic_ulong bytes_in;
+    atomic_ulong bytes_out;
+    atomic_ulong send_calls;
+    atomic_ulong zerocopy_sends;
+} ServerShard;
+
+// Create the connection for an accepted client; returns NULL on failure
+Connection *shard_add_connection(ServerShard *shard, int fd)
+{
+    if (fd >= shard->connection_capacity)
+    {
+        int capacity = shard->connection_capacity ? shard->connection_capacity : 1024;
+        while (capacity <= fd) capacity *= 2;
+
+        Connection **grown = (Connection **) realloc(
+            shard->connections, capacity * sizeof(Connection *));
+        if (!grown) return NULL;
+        memset(grown + shard->connection_capacity,
+               0,
+               (capacity - shard->connection_capacity) * sizeof(Connection *));
+        shard->connections = grown;
+        shard->connection_capacity = capacity;
+    }
+
+    Connection *conn = (Connection *) calloc(1, sizeof(Connection));
+    if (!conn) return NULL;
+    conn->fd = fd;
+
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+    int one = 1;
+    conn->zerocopy = setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+#endif
+
+    shard->connections[fd] = conn;
+    return conn;
+}
+
+// Unlink from the dirty list, close the socket and free the connection
+void shard_close_connection(ServerShard *shard, Connection *conn)
+{
+    for (Connection **link = &shard->dirty; *link; link = &(*link)->next_dirty)
+    {
+        if (*link == conn)
+        {
+            *link = conn->next_dirty;
+            break;
+        }
+    }
+
+    shard->connections[conn->fd] = NULL;
+    close(conn->fd);
+    free(conn->ring);
+    free(conn);
+}
+
+void connection_mark_dirty(ServerShard *shard, Connection *conn)
+{
+    if (!conn->dirty && !conn->write_blocked)
+    {
+        conn->dirty = 1;
+        conn->next_dirty = shard->dirty;
+        shard->dirty = conn;
+    }
+}
+
+// Collect zerocopy completions from the socket's error queue
+void connection_reap_zerocopy(Connection *conn)
+{
+#if defined(SO_EE_ORIGIN_ZEROCOPY) && defined(MSG_ZEROCOPY)
+    while (conn->zc_count > 0)
+    {
+        char control[128];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (recvmsg(conn->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) break;
+
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm))
+        {
+            struct sock_extended_err *err = (struct sock_extended_err *) CMSG_DATA(cm);
+            if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+
+            // Sends ee_info..ee_data are done; TCP completes them in order
+            while (conn->zc_count > 0
+                   && (int32_t) (conn->zc[conn->zc_head].id - err->ee_data) <= 0)
+            {
+                conn->head = conn->zc[conn->zc_head].release;
+                conn->zc_head = (conn->zc_head + 1) % ZEROCOPY_MAX_PENDING;
+                conn->zc_count--;
+            }
+        }
+    }
+#endif
+
+    if (conn->zc_count == 0)
+    {
+        conn->head = conn->send_pos;
+    }
+}
+
+// Read until the socket is drained or the ring is full; returns 0 once
+// the client is gone
+int connection_read(ServerShard *shard, Connection *conn)
+{
+    TRACE_FUNCTION();
+    if (conn->peer_closed)
+    {
+        // Zerocopy pages must not be freed while the kernel may still send them
+        return conn->msg_count > 0 || conn->zc_count > 0;
+    }
+
+    if (!conn->ring)
+    {
+        conn->ring = (char *) malloc(CONN_RING_SIZE);
+        if (!conn->ring) return 0;
+    }
+
+    while (1)
+    {
+        size_t space = CONN_RING_SIZE - (conn->tail - conn->head);
+        conn->read_blocked = space == 0 || conn->msg_count == CONN_MAX_MESSAGES;
+        if (conn->read_blocked) return 1;
+
+        // Free space may wrap around the end of the ring
+        size_t offset = conn->tail & (CONN_RING_SIZE - 1);
+        size_t first = CONN_RING_SIZE - offset < space ? CONN_RING_SIZE - offset : space;
+        struct iovec iov[2] = {{conn->ring + offset, first},
+                               {conn->ring, space - first}};
+
+        ssize_t bytes_read = readv(conn->fd, iov, space > first ? 2 : 1);
+        if (bytes_read < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 1;
+            if (errno == EINTR) continue;
+            perror("recv");
+            return 0;
+        }
+        if (bytes_read == 0)
+        {
+            printf("Client disconnected\n");
+            conn->peer_closed = 1;
+            return conn->msg_count > 0 || conn->zc_count > 0;
+        }
+
+        // Process received data
+        size_t shown = (size_t) bytes_read < first ? (size_t) bytes_read : first;
+        printf("Received from client %d: %.*s%.*s",
+               conn->fd,
+               (int) shown,
+               (char *) iov[0].iov_base,
+               (int) (bytes_read - shown),
+               conn->ring);
+
+        // Queue the echo; the payload stays in the ring until it is sent
+        conn->msg_len[(conn->msg_head + conn->msg_count) % CONN_MAX_MESSAGES]
+            = (uint32_t) bytes_read;
+        conn->msg_count++;
+        conn->tail += bytes_read;
+        connection_mark_dirty(shard, conn);
+
+        atomic_fetch_add_explicit(&shard->messages, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&shard->bytes_in, bytes_read, memory_order_relaxed);
+    }
+}
+
+// Send queued echoes with as few sendmsg() calls as possible. Returns 0
+// on a fatal error, 1 otherwise; sets write_blocked if the kernel pushed
+// back.
+int connection_flush(ServerShard *shard, Connection *conn)
+{
+    TRACE_FUNCTION();
+    while (conn->msg_count > 0)
+    {
+        struct iovec iov[CONN_MAX_IOV];
+        int iov_count = 0;
+        size_t payload = 0;
+        size_t requested = 0;
+        size_t pos = conn->send_pos;
+
+        // Gather prefix + ring segments for as many messages as fit
+        for (unsigned i = 0; i < conn->msg_count && iov_count + 3 <= CONN_MAX_IOV; i++)
+        {
+            size_t prefix_done = i == 0 ? conn->prefix_sent : 0;
+            if (prefix_done < ECHO_PREFIX_LEN)
+            {
+                iov[iov_count].iov_base = (void *) (echo_prefix + prefix_done);
+                iov[iov_count++].iov_len = ECHO_PREFIX_LEN - prefix_done;
+                requested += ECHO_PREFIX_LEN - prefix_done;
+            }
+
+            size_t len = conn->msg_len[(conn->msg_head + i) % CONN_MAX_MESSAGES];
+            while (len > 0)
+            {
+                size_t offset = pos & (CONN_RING_SIZE - 1);
+                size_t chunk = CONN_RING_SIZE - offset < len ? CONN_RING_SIZE - offset : len;
+                iov[iov_count].iov_base = conn->ring + offset;
+                iov[iov_count++].iov_len = chunk;
+                pos += chunk;
+                payload += chunk;
+                requested += chunk;
+                len -= chunk;
+            }
+        }
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iov_count;
+
+        int flags = MSG_NOSIGNAL | MSG_DONTWAIT;
+        int use_zerocopy = 0;
+#ifdef MSG_ZEROCOPY
+        use_zerocopy = conn->zerocopy && payload >= ZEROCOPY_THRESHOLD
+                       && conn->zc_count < ZEROCOPY_MAX_PENDING;
+        if (use_zerocopy) flags |= MSG_ZEROCOPY;
+#endif
+
+        ssize_t sent = sendmsg(conn->fd, &msg, flags);
+        if (sent < 0 && use_zerocopy && errno == ENOBUFS)
+        {
+            // Out of pinned-page budget: fall back to a copying send
+            use_zerocopy = 0;
+            sent = sendmsg(conn->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        }
+        if (sent < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                conn->write_blocked = 1;
+                return 1;
+            }
+            perror("sendmsg");
+            return 0;
+        }
+        atomic_fetch_add_explicit(&shard->send_calls, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&shard->bytes_out, sent, memory_order_relaxed);
+
+        // Consume what the kernel took, message by message
+        size_t left = (size_t) sent;
+        while (left > 0 && conn->msg_count > 0)
+        {
+            size_t prefix_left = ECHO_PREFIX_LEN - conn->prefix_sent;
+            size_t step = left < prefix_left ? left : prefix_left;
+            conn->prefix_sent += step;
+            left -= step;
+
+            uint32_t *len = &conn->msg_len[conn->msg_head];
+            step = left < *len ? left : *len;
+            *len -= step;
+            conn->send_pos += step;
+            left -= step;
+
+            if (conn->prefix_sent == ECHO_PREFIX_LEN && *len == 0)
+            {
+                conn->msg_head = (conn->msg_head + 1) % CONN_MAX_MESSAGES;
+                conn->msg_count--;
+                conn->prefix_sent = 0;
+            }
+        }
+
+        if (use_zerocopy)
+        {
+            unsigned slot = (conn->zc_head + conn->zc_count) % ZEROCOPY_MAX_PENDING;
+            conn->zc[slot].id = conn->zc_next_id++;
+            conn->zc[slot].release = conn->send_pos;
+            conn->zc_count++;
+            atomic_fetch_add_explicit(&shard->zerocopy_sends, 1, memory_order_relaxed);
+        }
+        else if (conn->zc_count == 0)
+        {
+            conn->head = conn->send_pos;
+        }
+
+        // A short write means the socket buffer is full
+        if ((size_t) sent < requested)
+        {
+            conn->write_blocked = 1;
+            return 1;
+        }
+    }
+
+    return 1;
+}
+
+// Flush every dirty connection; returns 1 if some still have work queued
+int shard_flush_dirty(ServerShard *shard, EventLoop *loop)
+{
+    TRACE_FUNCTION();
+    Connection *conn = shard->dirty;
+    shard->dirty = NULL;
+    int more = 0;
+
+    while (conn)
+    {
+        Connection *next = conn->next_dirty;
+        conn->dirty = 0;
+
+        int alive = connection_flush(shard, conn);
+        if (alive && conn->write_blocked)
+        {
+            loop->backend->set_write(loop, conn->fd, 1);
+        }
+        else if (alive && (conn->read_blocked || conn->peer_closed))
+        {
+            // Ring space was freed: edge-triggered readiness will not fire
+            // again for data already waiting, so resume reading now. This
+            // also closes half-closed clients whose output is now sent.
+            alive = connection_read(shard, conn);
+        }
+
+        if (!alive)
+        {
+            loop->backend->remove(loop, conn->fd);
+            shard_close_connection(shard, conn);
+            atomic_fetch_sub_explicit(&shard->active, 1, memory_order_relaxed);
+        }
+        else
+        {
+            more |= conn->dirty;
+        }
+        conn = next;
+    }
+
+    return more;
+}
+
+// Handle readiness on a client socket; returns 0 once the client is gone
+int connection_on_ready(ServerShard *shard, EventLoop *loop, Connection *conn)
+{
+    if (conn->zc_count > 0)
+    {
+        connection_reap_zerocopy(conn);
+    }
+
+    if (conn->write_blocked)
+    {
+        conn->write_blocked = 0;
+        loop->backend->set_write(loop, conn->fd, 0);
+        if (conn->msg_count > 0) connection_mark_dirty(shard, conn);
+    }
+
+    return connection_read(shard, conn);
+}
+
+// Accept every pending connection (required with edge-triggered events)
+void tcp_server_accept(EventLoop *loop, ServerShard *shard)
+{
+    TRACE_FUNCTION();
+    struct sockaddr_in client_addr;
+    socklen_t client_len;
+
+    while (1)
+    {
+        client_len = sizeof(client_addr);
+#ifdef __linux__
+        int client_fd = accept4(shard->listen_fd,
+                                (struct sockaddr *) &client_addr,
+                                &client_len,
+                                SOCK_NONBLOCK);
+#else
+        int client_fd = accept(
+            shard->listen_fd, (struct sockaddr *) &client_addr, &client_len);
+        if (client_fd >= 0) make_nonblocking(client_fd);
+#endif
+        if (client_fd < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                perror("accept");
+            }
+            return;
+        }
+
+        Connection *conn = shard_add_connection(shard, client_fd);
+        if (!conn)
+        {
+            close(client_fd);
+            continue;
+        }
+        if (loop->backend->add(loop, client_fd) < 0)
+        {
+            shard_close_connection(shard, conn);
+            continue;
+        }
+        atomic_fetch_add_explicit(&shard->accepted, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&shard->active, 1, memory_order_relaxed);
+
+        printf("New connection from %s:%d\n",
+               inet_ntoa(client_addr.sin_addr),
+               ntohs(client_addr.sin_port));
+
+        // Send welcome message
+        const char *welcome = "Welcome to the TCP server!\n";
+        ssize_t sent = send(client_fd, welcome, strlen(welcome), MSG_NOSIGNAL);
+        if (sent > 0)
+        {
+            atomic_fetch_add_explicit(&shard->bytes_out, sent, memory_order_relaxed);
+        }
+    }
+}
+
+// Create a non-blocking listening socket. With reuse_port several sockets
+// bind the same port and the kernel spreads incoming connections across
+// them.
+int create_server_socket(int port, int reuse_port)
+{
+    struct sockaddr_in server_addr;
+
+    // Create socket
+    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server_fd < 0)
+    {
+        perror("socket creation failed");
+        return -1;
+    }
+
+    // Set socket options to reuse address
+    int opt = 1;
+    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0)
+    {
+        perror("setsockopt");
+        close(server_fd);
+        return -1;
+    }
+
+#ifdef SO_REUSEPORT
+    if (reuse_port
+        && setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt))
+               < 0)
+    {
+        perror("setsockopt SO_REUSEPORT");
+        close(server_fd);
+        return -1;
+    }
+#else
+    if (reuse_port)
+    {
+        fprintf(stderr, "SO_REUSEPORT is not supported on this platform\n");
+        close(server_fd);
+        return -1;
+    }
+#endif
+
+    // Set up server address structure
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(port);
+
+    // Bind socket to specified port
+    if (bind(server_fd, (struct sockaddr *) &server_addr, sizeof(server_addr))
+        < 0)
+    {
+        perror("bind failed");
+        close(server_fd);
+        return -1;
+    }
+
+    // Start listening for connections; a deep backlog absorbs connect bursts
+    if (listen(server_fd, SOMAXCONN) < 0)
+    {
+        perror("listen failed");
+        close(server_fd);
+        return -1;
+    }
+
+    // Make server socket non-blocking
+    make_nonblocking(server_fd);
+
+    return server_fd;
+}
+
+// Print per-shard counters (on SIGUSR1 and at shutdown)
+void print_shard_stats(ServerShard *shards, int count)
+{
+    printf("%-6s %10s %8s %10s %12s %12s %10s %10s\n",
+           "shard", "accepted", "active", "messages", "bytes in", "bytes out", "sends",
+           "zerocopy");
+    for (int i = 0; i < count; i++)
+    {
+        printf("%-6d %10lu %8ld %10lu %12lu %12lu %10lu %10lu\n",
+               shards[i].id,
+               atomic_load_explicit(&shards[i].accepted, memory_order_relaxed),
+               atomic_load_explicit(&shards[i].active, memory_order_relaxed),
+               atomic_load_explicit(&shards[i].messages, memory_order_relaxed),
+               atomic_load_explicit(&shards[i].bytes_in, memory_order_relaxed),
+               atomic_load_explicit(&shards[i].bytes_out, memory_order_relaxed),
+               atomic_load_explicit(&shards[i].send_calls, memory_order_relaxed),
+               atomic_load_explicit(&shards[i].zerocopy_sends, memory_order_relaxed));
+    }
+    fflush(stdout);
+}
+
+#define SERVER_DRAIN_TIMEOUT_MS 5000
+
+// Stop accepting and let queued responses go out before closing. With
+// the listening socket out of the loop, the kernel no longer hands this
+// shard new clients (sharded siblings are draining too).
+void shard_begin_drain(ServerShard *shard, EventLoop *loop)
+{
+    if (shard->draining) return;
+    shard->draining = 1;
+    shard->drain_deadline_ms = monotonic_ms() + SERVER_DRAIN_TIMEOUT_MS;
+    loop->backend->remove(loop, shard->listen_fd);
+    printf("Shard %d draining %ld connection(s)...\n",
+           shard->id,
+           atomic_load_explicit(&shard->active, memory_order_relaxed));
+}
+
+// True once no connection has output left to send
+int shard_drained(ServerShard *shard)
+{
+    if (shard->dirty) return 0;
+    for (int fd = 0; fd < shard->connection_capacity; fd++)
+    {
+        Connection *conn = shard->connections[fd];
+        if (conn && (conn->msg_count > 0 || conn->zc_count > 0)) return 0;
+    }
+    return 1;
+}
+
+// React to a signal read from the channel; SIGINT/SIGTERM start a drain
+void shard_handle_signal(ServerShard *shard, EventLoop *loop, int sig)
+{
+    switch (sig)
+    {
+    case SIGINT:
+    case SIGTERM:
+        keep_running = 0;
+        shard_begin_drain(shard, loop);
+        break;
+    case SIGHUP:
+        // Configuration would be re-read here; the echo server has none
+        printf("Shard %d: reload requested\n", shard->id);
+        raise_fd_limit();
+        break;
+    case SIGUSR1:
+        print_shard_stats(shard, 1);
+        break;
+    }
+}
+
+// Run one shard's event loop until it is told to stop and has drained.
+// Without signal or wake descriptors it falls back to polling
+// keep_running every 100ms.
+int server_shard_run(ServerShard *shard)
+{
+    char thread_name[32];
+    snprintf(thread_name, sizeof(thread_name), "shard %d", shard->id);
+    scope_trace_thread_name(thread_name);
+
+    EventLoop *loop = (EventLoop *) malloc(sizeof(EventLoop));
+    if (!loop || event_loop_init(loop, shard->backend_type) < 0)
+    {
+        fprintf(stderr, "failed to start event loop\n");
+        free(loop);
+        return -1;
+    }
+    if (loop->backend->add(loop, shard->listen_fd) < 0
+        || (shard->signal_fd >= 0 && loop->backend->add(loop, shard->signal_fd) < 0)
+        || (shard->wake_fds[0] >= 0 && loop->backend->add(loop, shard->wake_fds[0]) < 0))
+    {
+        loop->backend->destroy(loop);
+        free(loop);
+        return -1;
+    }
+    int event_driven = shard->signal_fd >= 0 || shard->wake_fds[0] >= 0;
+
+    printf("Shard %d listening on port %d (%s backend)...\n",
+           shard->id,
+           shard->port,
+           loop->backend->name);
+
+    int ready[MAX_READY_EVENTS];
+    int flush_pending = 0;
+
+    // Server main loop
+    for (;;)
+    {
+        if (!keep_running && !event_driven) shard_begin_drain(shard, loop);
+        if (shard->draining
+            && (shard_drained(shard) || monotonic_ms() >= shard->drain_deadline_ms))
+        {
+            break;
+        }
+
+        // Block until activity (or poll keep_running every 100ms without
+        // control descriptors); don't block while connections still have
+        // buffered work, and wake for the drain deadline
+        int timeout = event_driven ? -1 : 100;
+        if (shard->draining)
+        {
+            long left = shard->drain_deadline_ms - monotonic_ms();
+            timeout = left < 100 ? (int) (left > 0 ? left : 0) : 100;
+        }
+        int count;
+        {
+            TRACE_SCOPE("wait");
+            count = loop->backend->wait(loop, ready, MAX_READY_EVENTS, flush_pending ? 0 : timeout);
+        }
+        if (count < 0)
+        {
+            perror("event loop wait");
+            break;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            int fd = ready[i];
+
+            if (fd == shard->listen_fd)
+            {
+                if (!shard->draining) tcp_server_accept(loop, shard);
+                continue;
+            }
+            if (fd == shard->signal_fd)
+            {
+                // Edge-triggered: drain every queued signal
+                int sig;
+                while ((sig = signal_channel_next(fd)) > 0)
+                {
+                    shard_handle_signal(shard, loop, sig);
+                }
+                continue;
+            }
+            if (fd == shard->wake_fds[0])
+            {
+                char drain[64];
+                while (read(fd, drain, sizeof(drain)) > 0)
+                {
+                }
+                if (!keep_running) shard_begin_drain(shard, loop);
+                continue;
+            }
+
+            Connection *conn = fd < shard->connection_capacity ? shard->connections[fd] : NULL;
+            if (conn && !connection_on_ready(shard, loop, conn))
+            {
+                // Connection closed or error
+                loop->backend->remove(loop, fd);
+                shard_close_connection(shard, conn);
+                atomic_fetch_sub_explicit(&shard->active, 1, memory_order_relaxed);
+            }
+        }
+
+        // One coalesced send per connection for everything read above
+        flush_pending = shard_flush_dirty(shard, loop);
+    }
+
+    // Clean up - close all client sockets
+    loop->backend->destroy(loop);
+    free(loop);
+    for (int fd = 0; fd < shard->connection_capacity; fd++)
+    {
+        if (shard->connections[fd]) shard_close_connection(shard, shard->connections[fd]);
+    }
+    free(shard->connections);
+    shard->connections = NULL;
+    shard->connection_capacity = 0;
+    return 0;
+}
+
+// TCP Server implementation
+void tcp_server(int port, EventBackendType backend_type)
+{
+    raise_fd_limit();
+
+    ServerShard shard;
+    memset(&shard, 0, sizeof(shard));
+    shard.port = port;
+    shard.cpu = -1;
+    shard.backend_type = backend_type;
+    shard.wake_fds[0] = shard.wake_fds[1] = -1;
+
+    // Signals arrive through the event loop; plain handlers are the
+    // fallback if the channel cannot be opened
+    shard.signal_fd = signal_channel_open();
+    if (shard.signal_fd < 0)
+    {
+        signal(SIGINT, handle_signal);
+        signal(SIGTERM, handle_signal);
+    }
+
+    shard.listen_fd = create_server_socket(port, 0);
+    if (shard.listen_fd < 0)
+    {
+        signal_channel_close(shard.signal_fd);
+        return;
+    }
+
+    server_shard_run(&shard);
+    close(shard.listen_fd);
+    signal_channel_close(shard.signal_fd);
+
+    printf("\nTCP Server shut down\n");
+}
+
+void *server_shard_thread(void *arg)
+{
+    ServerShard *shard = (ServerShard *) arg;
+
+#ifdef __linux__
+    if (shard->cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(shard->cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        {
+            fprintf(stderr, "shard %d: could not pin to CPU %d\n", shard->id, shard->cpu);
+        }
+    }
+#endif
+
+    server_shard_run(shard);
+    return NULL;
+}
+
+// Multi-core TCP server: one event loop per worker, each with its own
+// SO_REUSEPORT listening socket so the kernel load-balances accepts.
+// Send SIGUSR1 to print per-shard counters while running.
+void tcp_server_sharded(int port, int workers, EventBackendType backend_type, int pin)
+{
+    raise_fd_limit();
+
+    // Termination, reload and stats signals are read from the signal
+    // channel by this thread; blocking them first means every shard
+    // thread inherits the mask. Handlers remain as the fallback.
+    int signal_fd = signal_channel_open();
+    if (signal_fd < 0)
+    {
+        signal(SIGINT, handle_signal);
+        signal(SIGTERM, handle_signal);
+        signal(SIGUSR1, handle_stats_signal);
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers <= 0)
+    {
+        workers = cpus > 0 ? (int) cpus : 1;
+    }
+
+    ServerShard *shards = (ServerShard *) calloc(workers, sizeof(ServerShard));
+    if (!shards)
+    {
+        perror("calloc");
+        signal_channel_close(signal_fd);
+        return;
+    }
+
+    // Bind every socket before starting threads so a failure is reported
+    // up front rather than from a half-started server
+    int started = 0;
+    for (int i = 0; i < workers; i++)
+    {
+        shards[i].id = i;
+        shards[i].port = port;
+        shards[i].cpu = pin && cpus > 0 ? (int) (i % cpus) : -1;
+        shards[i].backend_type = backend_type;
+        shards[i].signal_fd = -1;
+        shards[i].wake_fds[0] = shards[i].wake_fds[1] = -1;
+        shards[i].listen_fd = create_server_socket(port, 1);
+        if (shards[i].listen_fd < 0)
+        {
+            workers = i;
+            keep_running = 0;
+            break;
+        }
+        if (signal_fd >= 0)
+        {
+            // Wake pipe: lets this thread start the shard's drain at once
+            if (pipe(shards[i].wake_fds) < 0)
+            {
+                perror("pipe");
+                shards[i].wake_fds[0] = shards[i].wake_fds[1] = -1;
+            }
+            else
+            {
+                make_nonblocking(shards[i].wake_fds[0]);
+                make_nonblocking(shards[i].wake_fds[1]);
+            }
+        }
+    }
+
+    for (int i = 0; i < workers && keep_running; i++)
+    {
+        if (pthread_create(&shards[i].thread, NULL, server_shard_thread, &shards[i]) != 0)
+        {
+            perror("pthread_create");
+            keep_running = 0;
+            break;
+        }
+        started++;
+    }
+
+    printf("TCP Server running %d shard(s) on port %d (pid %d, SIGUSR1 for stats)\n",
+           started,
+           port,
+           (int) getpid());
+
+    while (keep_running && signal_fd >= 0)
+    {
+        struct pollfd pfd = {signal_fd, POLLIN, 0};
+        if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+        {
+            perror("poll");
+            keep_running = 0;
+            break;
+        }
+
+        int sig;
+        while ((sig = signal_channel_next(signal_fd)) > 0)
+        {
+            if (sig == SIGINT || sig == SIGTERM)
+            {
+                keep_running = 0;
+            }
+            else if (sig == SIGHUP)
+            {
+                // Configuration would be re-read here; the echo server has none
+                printf("Reload requested\n");
+                raise_fd_limit();
+            }
+            else if (sig == SIGUSR1)
+            {
+                print_shard_stats(shards, started);
+            }
+        }
+    }
+
+    // Fallback without a signal channel: poll the handler flags
+    while (keep_running)
+    {
+        usleep(100000);
+        if (dump_stats)
+        {
+            dump_stats = 0;
+            print_shard_stats(shards, started);
+        }
+    }
+
+    // Tell every shard to drain now instead of on its next timeout
+    for (int i = 0; i < workers; i++)
+    {
+        char byte = 1;
+        if (shards[i].wake_fds[1] >= 0 && write(shards[i].wake_fds[1], &byte, 1) < 0
+            && errno != EAGAIN)
+        {
+            perror("shard wake");
+        }
+    }
+
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(shards[i].thread, NULL);
+    }
+    for (int i = 0; i < workers; i++)
+    {
+        close(shards[i].listen_fd);
+        if (shards[i].wake_fds[0] >= 0)
+        {
+            close(shards[i].wake_fds[0]);
+            close(shards[i].wake_fds[1]);
+        }
+    }
+    signal_channel_close(signal_fd);
+
+    printf("\nTCP Server shut down\n");
+    print_shard_stats(shards, started);
+    free(shards);
+}
+
+// ===== Asynchronous Resolver =====
+//
+// getaddrinfo() blocks, so lookups run on a small thread pool. Results are
+// cached per hostname and concurrent lookups of the same name share one
+// query. Completions are delivered on the caller's thread: poll
+// resolver_fd() for readability (it fits any event loop) and call
+// resolver_dispatch() to run the callbacks. getaddrinfo does not expose
+// record TTLs, so entries live for a fixed TTL chosen at creation;
+// failures are cached briefly so a bad name does not hammer DNS.
+
+#define RESOLVER_BUCKETS      64
+#define RESOLVER_NEGATIVE_TTL 5     // Seconds a failed lookup is cached
+#define RESOLVER_DEFAULT_TTL  60
+
+typedef void (*ResolveCallback)(const char *host,
+                                const struct addrinfo *addrs,
+                                int status,  // getaddrinfo() code, 0 on success
+                                void *user);
+
+// A getaddrinfo() result shared by the cache and pending callbacks
+typedef struct
+{
+    atomic_int refs;
+    struct addrinfo *list;
+} ResolvedAddrs;
+
+typedef struct ResolveRequest
+{
+    char *host;
+    ResolveCallback callback;
+    void *user;
+    ResolvedAddrs *addrs;
+    int status;
+    struct ResolveRequest *next;
+} ResolveRequest;
+
+typedef struct CacheEntry
+{
+    char *host;
+    int pending;  // A worker is resolving this name
+    ResolvedAddrs *addrs;
+    int status;
+    time_t expires;
+    ResolveRequest *waiters;  // Callers coalesced onto the pending lookup
+    struct CacheEntry *next;
+    struct CacheEntry *job_next;
+} CacheEntry;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    CacheEntry *buckets[RESOLVER_BUCKETS];
+    CacheEntry *jobs_head, *jobs_tail;
+    ResolveRequest *done_head, *done_tail;
+    int notify_fds[2];  // Pipe: readable while completions are waiting
+    pthread_t *threads;
+    int thread_count;
+    int ttl;
+    int stopping;
+
+    unsigned long hits, misses, coalesced;
+} Resolver;
+
+static void resolved_addrs_release(ResolvedAddrs *addrs)
+{
+    if (addrs && atomic_fetch_sub(&addrs->refs, 1) == 1)
+    {
+        if (addrs->list) freeaddrinfo(addrs->list);
+        free(addrs);
+    }
+}
+
+static unsigned resolver_hash(const char *host)
+{
+    unsigned hash = 2166136261u;  // FNV-1a
+    for (; *host; host++)
+    {
+        hash = (hash ^ (unsigned char) *host) * 16777619u;
+    }
+    return hash % RESOLVER_BUCKETS;
+}
+
+// Caller holds the lock
+static void resolver_complete(Resolver *r, ResolveRequest *req, CacheEntry *entry)
+{
+    req->status = entry->status;
+    req->addrs = entry->addrs;
+    if (req->addrs) atomic_fetch_add(&req->addrs->refs, 1);
+    req->next = NULL;
+
+    if (r->done_tail)
+    {
+        r->done_tail->next = req;
+    }
+    else
+    {
+        r->done_head = req;
+    }
+    r->done_tail = req;
+}
+
+static void resolver_notify(Resolver *r)
+{
+    char byte = 1;
+    if (write(r->notify_fds[1], &byte, 1) < 0 && errno != EAGAIN)
+    {
+        perror("resolver notify");
+    }
+}
+
+static void *resolver_worker(void *arg)
+{
+    Resolver *r = (Resolver *) arg;
+
+    pthread_mutex_lock(&r->lock);
+    while (1)
+    {
+        while (!r->jobs_head && !r->stopping)
+        {
+            pthread_cond_wait(&r->work, &r->lock);
+        }
+        if (r->stopping) break;
+
+        CacheEntry *entry = r->jobs_head;
+        r->jobs_head = entry->job_next;
+        if (!r->jobs_head) r->jobs_tail = NULL;
+
+        // The entry is pinned while pending, so the host stays valid
+        pthread_mutex_unlock(&r->lock);
+
+        struct addrinfo hints, *list = NULL;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_ADDRCONFIG;
+        int status = getaddrinfo(entry->host, NULL, &hints, &list);
+
+        ResolvedAddrs *addrs = NULL;
+        if (status == 0)
+        {
+            addrs = (ResolvedAddrs *) malloc(sizeof(ResolvedAddrs));
+            if (addrs)
+            {
+                atomic_init(&addrs->refs, 1);  // Held by the cache
+                addrs->list = list;
+            }
+            else
+            {
+                freeaddrinfo(list);
+                status = EAI_MEMORY;
+            }
+        }
+
+        pthread_mutex_lock(&r->lock);
+        entry->addrs = addrs;
+        entry->status = status;
+        entry->expires = time(NULL) + (status == 0 ? r->ttl : RESOLVER_NEGATIVE_TTL);
+        entry->pending = 0;
+
+        ResolveRequest *req = entry->waiters;
+        entry->waiters = NULL;
+        while (req)
+        {
+            ResolveRequest *next = req->next;
+            resolver_complete(r, req, entry);
+            req = next;
+        }
+        resolver_notify(r);
+    }
+    pthread_mutex_unlock(&r->lock);
+
+    return NULL;
+}
+
+Resolver *resolver_create(int threads, int ttl_seconds)
+{
+    Resolver *r = (Resolver *) calloc(1, sizeof(Resolver));
+    if (!r) return NULL;
+
+    if (pipe(r->notify_fds) < 0)
+    {
+        perror("pipe");
+        free(r);
+        return NULL;
+    }
+    make_nonblocking(r->notify_fds[0]);
+    make_nonblocking(r->notify_fds[1]);
+
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->work, NULL);
+    r->ttl = ttl_seconds > 0 ? ttl_seconds : RESOLVER_DEFAULT_TTL;
+    r->threads = (pthread_t *) calloc(threads, sizeof(pthread_t));
+
+    for (int i = 0; r->threads && i < threads; i++)
+    {
+        if (pthread_create(&r->threads[i], NULL, resolver_worker, r) != 0) break;
+        r->thread_count++;
+    }
+
+    if (r->thread_count == 0)
+    {
+        fprintf(stderr, "resolver: could not start worker threads\n");
+        close(r->notify_fds[0]);
+        close(r->notify_fds[1]);
+        free(r->threads);
+        free(r);
+        return NULL;
+    }
+
+    return r;
+}
+
+// Start a lookup; the callback runs later from resolver_dispatch().
+// Returns -1 only if memory runs out.
+int resolver_resolve(Resolver *r, const char *host, ResolveCallback callback, void *user)
+{
+    ResolveRequest *req = (ResolveRequest *) calloc(1, sizeof(ResolveRequest));
+    if (!req || !(req->host = strdup(host)))
+    {
+        free(req);
+        return -1;
+    }
+    req->callback = callback;
+    req->user = user;
+
+    unsigned bucket = resolver_hash(host);
+    time_t now = time(NULL);
+
+    pthread_mutex_lock(&r->lock);
+
+    // Look up the name, dropping expired entries on the way
+    CacheEntry *entry = NULL;
+    for (CacheEntry **link = &r->buckets[bucket]; *link;)
+    {
+        CacheEntry *e = *link;
+        if (strcmp(e->host, host) == 0)
+        {
+            entry = e;
+            break;
+        }
+        if (!e->pending && e->expires <= now)
+        {
+            *link = e->next;
+            resolved_addrs_release(e->addrs);
+            free(e->host);
+            free(e);
+            continue;
+        }
+        link = &e->next;
+    }
+
+    int notify = 0;
+    if (entry && !entry->pending && entry->expires > now)
     {
-        perror("socket creation failed");
+        r->hits++;
+        resolver_complete(r, req, entry);
+        notify = 1;
+    }
+    else if (entry && entry->pending)
+    {
+        r->coalesced++;
+        req->next = entry->waiters;
+        entry->waiters = req;
+    }
+    else
+    {
+        if (!entry)
+        {
+            entry = (CacheEntry *) calloc(1, sizeof(CacheEntry));
+            if (!entry || !(entry->host = strdup(host)))
+            {
+                pthread_mutex_unlock(&r->lock);
+                free(entry);
+                free(req->host);
+                free(req);
+                return -1;
+            }
+            entry->next = r->buckets[bucket];
+            r->buckets[bucket] = entry;
+        }
+
+        // Expired or new: refresh it
+        r->misses++;
+        resolved_addrs_release(entry->addrs);
+        entry->addrs = NULL;
+        entry->pending = 1;
+        req->next = NULL;
+        entry->waiters = req;
+
+        entry->job_next = NULL;
+        if (r->jobs_tail)
+        {
+            r->jobs_tail->job_next = entry;
+        }
+        else
+        {
+            r->jobs_head = entry;
+        }
+        r->jobs_tail = entry;
+        pthread_cond_signal(&r->work);
+    }
+
+    pthread_mutex_unlock(&r->lock);
+
+    if (notify) resolver_notify(r);
+    return 0;
+}
+
+// Readable while completions are waiting for resolver_dispatch()
+int resolver_fd(Resolver *r)
+{
+    return r->notify_fds[0];
+}
+
+// Run callbacks for finished lookups; returns how many ran
+int resolver_dispatch(Resolver *r)
+{
+    char drain[64];
+    while (read(r->notify_fds[0], drain, sizeof(drain)) > 0)
+    {
+    }
+
+    pthread_mutex_lock(&r->lock);
+    ResolveRequest *req = r->done_head;
+    r->done_head = r->done_tail = NULL;
+    pthread_mutex_unlock(&r->lock);
+
+    int count = 0;
+    while (req)
+    {
+        ResolveRequest *next = req->next;
+        req->callback(req->host, req->addrs ? req->addrs->list : NULL, req->status, req->user);
+        resolved_addrs_release(req->addrs);
+        free(req->host);
+        free(req);
+        req = next;
+        count++;
+    }
+    return count;
+}
+
+// Block up to timeout_ms for completions and dispatch them
+int resolver_wait(Resolver *r, int timeout_ms)
+{
+    struct pollfd pfd = {resolver_fd(r), POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) <= 0) return 0;
+    return resolver_dispatch(r);
+}
+
+void resolver_destroy(Resolver *r)
+{
+    pthread_mutex_lock(&r->lock);
+    r->stopping = 1;
+    pthread_cond_broadcast(&r->work);
+    pthread_mutex_unlock(&r->lock);
+
+    for (int i = 0; i < r->thread_count; i++)
+    {
+        pthread_join(r->threads[i], NULL);
+    }
+
+    // Lookups that never ran are dropped without callbacks
+    for (int b = 0; b < RESOLVER_BUCKETS; b++)
+    {
+        CacheEntry *entry = r->buckets[b];
+        while (entry)
+        {
+            CacheEntry *next = entry->next;
+            for (ResolveRequest *req = entry->waiters; req;)
+            {
+                ResolveRequest *req_next = req->next;
+                free(req->host);
+                free(req);
+                req = req_next;
+            }
+            resolved_addrs_release(entry->addrs);
+            free(entry->host);
+            free(entry);
+            entry = next;
+        }
+    }
+    for (ResolveRequest *req = r->done_head; req;)
+    {
+        ResolveRequest *next = req->next;
+        resolved_addrs_release(req->addrs);
+        free(req->host);
+        free(req);
+        req = next;
+    }
+
+    close(r->notify_fds[0]);
+    close(r->notify_fds[1]);
+    pthread_mutex_destroy(&r->lock);
+    pthread_cond_destroy(&r->work);
+    free(r->threads);
+    free(r);
+}
+
+// Shared resolver for the command-line tools
+static Resolver *default_resolver;
+
+Resolver *get_default_resolver(void)
+{
+    if (!default_resolver)
+    {
+        default_resolver = resolver_create(4, RESOLVER_DEFAULT_TTL);
+    }
+    return default_resolver;
+}
+
+// Blocking convenience wrapper: copy the result out for the caller
+typedef struct
+{
+    int done;
+    int status;
+    struct sockaddr_storage addrs[16];
+    socklen_t lengths[16];
+    int count;
+} ResolveResult;
+
+static void resolve_result_callback(const char *host,
+                                    const struct addrinfo *addrs,
+                                    int status,
+                                    void *user)
+{
+    ResolveResult *result = (ResolveResult *) user;
+    (void) host;
+
+    result->done = 1;
+    result->status = status;
+    for (const struct addrinfo *p = addrs; p && result->count < 16; p = p->ai_next)
+    {
+        if (p->ai_family != AF_INET && p->ai_family != AF_INET6) continue;
+        memcpy(&result->addrs[result->count], p->ai_addr, p->ai_addrlen);
+        result->lengths[result->count++] = p->ai_addrlen;
+    }
+}
+
+int resolve_blocking(const char *host, ResolveResult *result, int timeout_ms)
+{
+    memset(result, 0, sizeof(*result));
+    Resolver *r = get_default_resolver();
+    if (!r || resolver_resolve(r, host, resolve_result_callback, result) < 0)
+    {
+        return EAI_MEMORY;
+    }
+
+    while (!result->done && timeout_ms > 0)
+    {
+        resolver_wait(r, 50);
+        timeout_ms -= 50;
+    }
+    return result->done ? result->status : EAI_AGAIN;
+}
+
+// ===== Happy Eyeballs (RFC 8305) =====
+//
+// Connection attempts to the resolved addresses are raced: families are
+// interleaved, a new attempt starts every HAPPY_EYEBALLS_DELAY_MS (or at
+// once when one fails), and the first socket to connect wins.
+
+#define HAPPY_EYEBALLS_DELAY_MS   250
+#define HAPPY_EYEBALLS_TIMEOUT_MS 10000
+
+// Returns a connected, blocking socket or -1; *winner gets its index
+int happy_eyeballs_connect(ResolveResult *result, int port, int *winner)
+{
+    // Interleave families, keeping getaddrinfo's preference order
+    int preferred[16], other[16], preferred_count = 0, other_count = 0;
+    for (int i = 0; i < result->count; i++)
+    {
+        if (result->addrs[i].ss_family == result->addrs[0].ss_family)
+        {
+            preferred[preferred_count++] = i;
+        }
+        else
+        {
+            other[other_count++] = i;
+        }
+    }
+
+    int order[16], count = 0;
+    for (int i = 0; i < preferred_count || i < other_count; i++)
+    {
+        if (i < preferred_count) order[count++] = preferred[i];
+        if (i < other_count) order[count++] = other[i];
+    }
+
+    struct pollfd attempts[16];
+    int attempt_index[16];
+    int active = 0, next = 0, connected = -1;
+    int last_error = ETIMEDOUT;
+    long deadline = monotonic_ms() + HAPPY_EYEBALLS_TIMEOUT_MS;
+    long next_start = 0;
+
+    while (connected < 0 && (next < count || active > 0))
+    {
+        long now = monotonic_ms();
+        if (now >= deadline) break;
+
+        if (next < count && (now >= next_start || active == 0))
+        {
+            int i = order[next++];
+            struct sockaddr_storage addr = result->addrs[i];
+            if (addr.ss_family == AF_INET)
+            {
+                ((struct sockaddr_in *) &addr)->sin_port = htons(port);
+            }
+            else
+            {
+                ((struct sockaddr_in6 *) &addr)->sin6_port = htons(port);
+            }
+
+            int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+            if (fd >= 0 && make_nonblocking(fd) == 0)
+            {
+                if (connect(fd, (struct sockaddr *) &addr, result->lengths[i]) == 0
+                    || errno == EINPROGRESS)
+                {
+                    attempts[active].fd = fd;
+                    attempts[active].events = POLLOUT;
+                    attempt_index[active++] = i;
+                    next_start = now + HAPPY_EYEBALLS_DELAY_MS;
+                    continue;
+                }
+            }
+            last_error = errno;
+            if (fd >= 0) close(fd);
+            continue;  // Failed immediately: try the next address now
+        }
+
+        long wait = (next < count ? next_start : deadline) - now;
+        if (poll(attempts, active, wait > 0 ? (int) wait : 0) <= 0) continue;
+
+        for (int a = 0; a < active; a++)
+        {
+            if (!attempts[a].revents) continue;
+
+            int error = 0;
+            socklen_t len = sizeof(error);
+            getsockopt(attempts[a].fd, SOL_SOCKET, SO_ERROR, &error, &len);
+            if (error == 0)
+            {
+                connected = a;
+                break;
+            }
+
+            // This attempt failed: drop it and start the next one at once
+            last_error = error;
+            close(attempts[a].fd);
+            attempts[a] = attempts[active - 1];
+            attempt_index[a] = attempt_index[active - 1];
+            active--;
+            a--;
+            next_start = 0;
+        }
+    }
+
+    int fd = -1;
+    for (int a = 0; a < active; a++)
+    {
+        if (a == connected)
+        {
+            fd = attempts[a].fd;
+            *winner = attempt_index[a];
+        }
+        else
+        {
+            close(attempts[a].fd);
+        }
+    }
+
+    if (fd < 0)
+    {
+        errno = last_error;
+        return -1;
+    }
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    return fd;
+}
+
+// TCP Client implementation
+void tcp_client(const char *server, int port)
+{
+    int sock_fd;
+    char buffer[1024];
+
+    // Resolve names off-thread (literal addresses resolve immediately)
+    ResolveResult result;
+    int status = resolve_blocking(server, &result, 5000);
+    if (status != 0 || result.count == 0)
+    {
+        fprintf(stderr, "could not resolve %s: %s\n",
+                server,
+                status ? gai_strerror(status) : "no addresses");
+        return;
+    }
+
+    // Race connections across the resolved addresses
+    int winner = 0;
+    sock_fd = happy_eyeballs_connect(&result, port, &winner);
+    if (sock_fd < 0)
+    {
+        perror("connect failed");
         return;
     }
 
-    // Set up server address structure
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
+    char server_ip[INET6_ADDRSTRLEN];
+    struct sockaddr_storage *addr = &result.addrs[winner];
+    inet_ntop(addr->ss_family,
+              addr->ss_family == AF_INET
+                  ? (void *) &((struct sockaddr_in *) addr)->sin_addr
+                  : (void *) &((struct sockaddr_in6 *) addr)->sin6_addr,
+              server_ip,
+              sizeof(server_ip));
+
+    printf("Connected to server at %s:%d\n", server_ip, port);
+
+    // Set up signal handler
+    signal(SIGINT, handle_signal);
+
+    // Receive initial welcome message
+    memset(buffer, 0, sizeof(buffer));
+    int bytes_read = recv(sock_fd, buffer, sizeof(buffer) - 1, 0);
+    if (bytes_read > 0)
+    {
+        buffer[bytes_read] = '\0';
+        printf("%s", buffer);
+    }
+
+    // Main communication loop
+    while (keep_running)
+    {
+        printf("Enter message (or 'exit' to quit): ");
+        fgets(buffer, sizeof(buffer), stdin);
+
+        // Check for exit
+        if (strncmp(buffer, "exit", 4) == 0)
+        {
+            break;
+        }
+
+        // Send message to server
+        ssize_t bytes_sent = send(sock_fd, buffer, strlen(buffer), 0);
+        if (bytes_sent < 0)
+        {
+            perror("send failed");
+            break;
+        }
+
+        // Receive response
+        memset(buffer, 0, sizeof(buffer));
+        bytes_read = recv(sock_fd, buffer, sizeof(buffer) - 1, 0);
+        if (bytes_read <= 0)
+        {
+            if (bytes_read == 0)
+            {
+                printf("Server closed the connection\n");
+            }
+            else
+            {
+                perror("recv failed");
+            }
+            break;
+        }
+
+        buffer[bytes_read] = '\0';
+        printf("Server response: %s", buffer);
+    }
+
+    // Clean up
+    close(sock_fd);
+    printf("\nDisconnected from server\n");
+}
+
+// ===== Load Generator =====
+//
+// A client-side library for benchmarking the server modes above: a pool
+// of persistent connections, each keeping `pipeline` requests in flight.
+// Requests are newline-terminated lines; since the echo server prefixes
+// echoes but keeps every newline, each '\n' received completes the oldest
+// outstanding request on that connection. Latencies go into a log-linear
+// histogram (HDR style: 16 sub-buckets per power of two, ~6% error).
+
+#define HISTOGRAM_SUB_BUCKETS 16
+#define HISTOGRAM_BUCKETS     (61 * HISTOGRAM_SUB_BUCKETS)
+#define BENCH_MAX_PIPELINE    1024
+#define BENCH_SEND_BATCH      64  // Requests per send() when refilling
+
+typedef struct
+{
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t total;
+    uint64_t min, max;
+} LatencyHistogram;
+
+static int histogram_index(uint64_t value)
+{
+    if (value < HISTOGRAM_SUB_BUCKETS) return (int) value;
+    int exponent = 63 - __builtin_clzll(value);
+    int sub = (int) (value >> (exponent - 4)) & (HISTOGRAM_SUB_BUCKETS - 1);
+    return (exponent - 3) * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+// Upper edge of a bucket, the value reported for its percentiles
+static uint64_t histogram_value(int index)
+{
+    if (index < HISTOGRAM_SUB_BUCKETS) return (uint64_t) index;
+    int exponent = index / HISTOGRAM_SUB_BUCKETS + 3;
+    uint64_t sub = (uint64_t) (index % HISTOGRAM_SUB_BUCKETS) | HISTOGRAM_SUB_BUCKETS;
+    return ((sub + 1) << (exponent - 4)) - 1;
+}
+
+void histogram_record(LatencyHistogram *h, uint64_t value)
+{
+    h->counts[histogram_index(value)]++;
+    if (h->total == 0 || value < h->min) h->min = value;
+    if (value > h->max) h->max = value;
+    h->total++;
+}
+
+uint64_t histogram_percentile(const LatencyHistogram *h, double percentile)
+{
+    uint64_t target = (uint64_t) (h->total * percentile / 100.0 + 0.5);
+    if (target == 0) target = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        seen += h->counts[i];
+        if (seen >= target)
+        {
+            uint64_t value = histogram_value(i);
+            return value < h->max ? value : h->max;
+        }
+    }
+    return h->max;
+}
+
+typedef struct
+{
+    int connections;
+    int pipeline;  // Outstanding requests per connection
+    int seconds;
+    int request_size;  // Bytes per request, including the newline
+    EventBackendType backend_type;
+} LoadConfig;
+
+typedef struct
+{
+    int fd;
+    int welcome_pending;  // Server greets every connection first
+    uint64_t sent_at[BENCH_MAX_PIPELINE];  // Send times, FIFO
+    unsigned send_head, outstanding;
+    int unsent;         // Requests queued but not yet written
+    size_t unsent_offset;  // Bytes of the first unsent request written
+    int write_blocked;
+} BenchConnection;
+
+typedef struct
+{
+    uint64_t completed;
+    uint64_t errors;
+    double elapsed;
+    LatencyHistogram latency;  // Nanoseconds
+} LoadResult;
+
+// Every send and receive batch is timestamped, so use the calibrated TSC
+// clock (CLOCK_MONOTONIC where there is no invariant counter)
+static uint64_t bench_now_ns(void)
+{
+    return fast_clock_tsc_ns();
+}
+
+// Write queued requests; returns 0 if the connection failed
+static int bench_send(BenchConnection *c, const char *requests, int request_size)
+{
+    while (c->unsent > 0)
+    {
+        int batch = c->unsent < BENCH_SEND_BATCH ? c->unsent : BENCH_SEND_BATCH;
+        size_t length = (size_t) batch * request_size - c->unsent_offset;
+        ssize_t sent = send(c->fd, requests + c->unsent_offset, length, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                c->write_blocked = 1;
+                return 1;
+            }
+            return 0;
+        }
+
+        // Requests are timed from when their last byte is written
+        size_t done = c->unsent_offset + sent;
+        int finished = (int) (done / request_size);
+        uint64_t now = bench_now_ns();
+        for (int i = 0; i < finished; i++)
+        {
+            c->sent_at[(c->send_head + c->outstanding++) % BENCH_MAX_PIPELINE] = now;
+        }
+        c->unsent -= finished;
+        c->unsent_offset = done % request_size;
+    }
+    c->write_blocked = 0;
+    return 1;
+}
+
+// Read responses; returns 0 if the connection closed or failed
+static int bench_receive(BenchConnection *c, LoadResult *result, int *completed)
+{
+    char buffer[16384];
+    *completed = 0;
+
+    while (1)
+    {
+        ssize_t bytes = recv(c->fd, buffer, sizeof(buffer), 0);
+        if (bytes < 0)
+        {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        if (bytes == 0) return 0;
+
+        uint64_t now = bench_now_ns();
+        for (char *p = buffer, *end = buffer + bytes;
+             (p = memchr(p, '\n', end - p)) != NULL;
+             p++)
+        {
+            if (c->welcome_pending)
+            {
+                c->welcome_pending = 0;
+                continue;
+            }
+            if (c->outstanding == 0) continue;  // Not ours; ignore
+
+            histogram_record(&result->latency, now - c->sent_at[c->send_head]);
+            c->send_head = (c->send_head + 1) % BENCH_MAX_PIPELINE;
+            c->outstanding--;
+            (*completed)++;
+        }
+    }
+}
+
+// Run a closed-loop load test against host:port; fills *result
+int load_generator_run(const char *host, int port, const LoadConfig *config, LoadResult *result)
+{
+    memset(result, 0, sizeof(*result));
+    fast_clock_calibrate();
+
+    ResolveResult resolved;
+    int status = resolve_blocking(host, &resolved, 5000);
+    if (status != 0 || resolved.count == 0)
+    {
+        fprintf(stderr, "could not resolve %s\n", host);
+        return -1;
+    }
+
+    int pipeline = config->pipeline;
+    if (pipeline < 1) pipeline = 1;
+    if (pipeline > BENCH_MAX_PIPELINE) pipeline = BENCH_MAX_PIPELINE;
+    int request_size = config->request_size < 2 ? 2 : config->request_size;
+
+    // A batch of identical requests, so refills are a single send()
+    char *requests = (char *) malloc((size_t) BENCH_SEND_BATCH * request_size);
+    BenchConnection *conns
+        = (BenchConnection *) calloc(config->connections, sizeof(BenchConnection));
+    EventLoop *loop = (EventLoop *) malloc(sizeof(EventLoop));
+    if (!requests || !conns || !loop || event_loop_init(loop, config->backend_type) < 0)
+    {
+        fprintf(stderr, "load generator: setup failed\n");
+        free(requests);
+        free(conns);
+        free(loop);
+        return -1;
+    }
+    for (int i = 0; i < BENCH_SEND_BATCH; i++)
+    {
+        memset(requests + (size_t) i * request_size, 'x', request_size - 1);
+        requests[(size_t) (i + 1) * request_size - 1] = '\n';
+    }
 
-    // Convert IP address from text to binary
-    if (inet_pton(AF_INET, server_ip, &server_addr.sin_addr) <= 0)
+    // fd -> connection lookup for readiness events
+    int max_fd = 0;
+    int open_count = 0;
+    for (int i = 0; i < config->connections; i++)
     {
-        perror("invalid address");
-        close(sock_fd);
-        return;
+        int winner;
+        conns[i].fd = happy_eyeballs_connect(&resolved, port, &winner);
+        if (conns[i].fd < 0)
+        {
+            perror("connect");
+            break;
+        }
+        make_nonblocking(conns[i].fd);
+        int one = 1;
+        setsockopt(conns[i].fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        conns[i].welcome_pending = 1;
+        if (loop->backend->add(loop, conns[i].fd) < 0)
+        {
+            close(conns[i].fd);
+            break;
+        }
+        if (conns[i].fd > max_fd) max_fd = conns[i].fd;
+        open_count++;
     }
 
-    // Connect to server
-    if (connect(sock_fd, (struct sockaddr *) &server_addr, sizeof(server_addr))
-        < 0)
+    BenchConnection **by_fd = (BenchConnection **) calloc(max_fd + 1, sizeof(BenchConnection *));
+    for (int i = 0; by_fd && i < open_count; i++)
     {
-        perror("connect failed");
-        close(sock_fd);
-        return;
+        by_fd[conns[i].fd] = &conns[i];
     }
 
-    printf("Connected to server at %s:%d\n", server_ip, port);
+    printf("Load: %d connection(s) x %d pipelined, %d-byte requests, %d s (%s)\n",
+           open_count,
+           pipeline,
+           request_size,
+           config->seconds,
+           loop->backend->name);
 
-    // Set up signal handler
-    signal(SIGINT, handle_signal);
+    uint64_t start = bench_now_ns();
+    uint64_t end = start + (uint64_t) config->seconds * 1000000000ull;
+    uint64_t next_report = start + 1000000000ull;
+    uint64_t last_completed = 0;
 
-    // Receive initial welcome message
-    memset(buffer, 0, sizeof(buffer));
-    int bytes_read = recv(sock_fd, buffer, sizeof(buffer) - 1, 0);
-    if (bytes_read > 0)
+    // Fill every pipeline
+    for (int i = 0; by_fd && i < open_count; i++)
     {
-        buffer[bytes_read] = '\0';
-        printf("%s", buffer);
+        conns[i].unsent = pipeline;
+        if (!bench_send(&conns[i], requests, request_size)) result->errors++;
+        if (conns[i].write_blocked) loop->backend->set_write(loop, conns[i].fd, 1);
     }
 
-    // Main communication loop
-    while (keep_running)
+    int ready[MAX_READY_EVENTS];
+    while (by_fd && keep_running && open_count > 0)
     {
-        printf("Enter message (or 'exit' to quit): ");
-        fgets(buffer, sizeof(buffer), stdin);
+        uint64_t now = bench_now_ns();
+        if (now >= end) break;
 
-        // Check for exit
-        if (strncmp(buffer, "exit", 4) == 0)
+        if (now >= next_report)
         {
-            break;
+            printf("  %6.1f s: %10.0f req/s\n",
+                   (now - start) / 1e9,
+                   (double) (result->completed - last_completed));
+            last_completed = result->completed;
+            next_report += 1000000000ull;
         }
 
-        // Send message to server
-        ssize_t bytes_sent = send(sock_fd, buffer, strlen(buffer), 0);
-        if (bytes_sent < 0)
+        int count = loop->backend->wait(loop, ready, MAX_READY_EVENTS, 10);
+        for (int i = 0; i < count; i++)
         {
-            perror("send failed");
-            break;
-        }
+            if (ready[i] > max_fd || !by_fd[ready[i]]) continue;
+            BenchConnection *c = by_fd[ready[i]];
 
-        // Receive response
-        memset(buffer, 0, sizeof(buffer));
-        bytes_read = recv(sock_fd, buffer, sizeof(buffer) - 1, 0);
-        if (bytes_read <= 0)
-        {
-            if (bytes_read == 0)
-            {
-                printf("Server closed the connection\n");
-            }
-            else
+            int completed = 0;
+            int alive = bench_receive(c, result, &completed);
+            result->completed += completed;
+
+            // Closed loop: every completion releases one more request
+            c->unsent += completed;
+            if (alive) alive = bench_send(c, requests, request_size);
+            loop->backend->set_write(loop, c->fd, c->write_blocked);
+
+            if (!alive)
             {
-                perror("recv failed");
+                result->errors++;
+                loop->backend->remove(loop, c->fd);
+                close(c->fd);
+                by_fd[c->fd] = NULL;
+                open_count--;
             }
-            break;
         }
+    }
+    result->elapsed = (bench_now_ns() - start) / 1e9;
 
-        buffer[bytes_read] = '\0';
-        printf("Server response: %s", buffer);
+    for (int fd = 0; by_fd && fd <= max_fd; fd++)
+    {
+        if (by_fd[fd]) close(fd);
     }
+    loop->backend->destroy(loop);
+    free(loop);
+    free(by_fd);
+    free(conns);
+    free(requests);
+    return 0;
+}
 
-    // Clean up
-    close(sock_fd);
-    printf("\nDisconnected from server\n");
+void print_load_result(const LoadResult *result)
+{
+    const LatencyHistogram *h = &result->latency;
+    printf("\nCompleted %llu request(s) in %.2f s: %.0f req/s sustained, %llu error(s)\n",
+           (unsigned long long) result->completed,
+           result->elapsed,
+           result->elapsed > 0 ? result->completed / result->elapsed : 0.0,
+           (unsigned long long) result->errors);
+    if (h->total == 0) return;
+
+    printf("Latency (us): min %.1f  p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+           h->min / 1e3,
+           histogram_percentile(h, 50) / 1e3,
+           histogram_percentile(h, 90) / 1e3,
+           histogram_percentile(h, 99) / 1e3,
+           histogram_percentile(h, 99.9) / 1e3,
+           h->max / 1e3);
+}
+
+// Command-line wrapper around the load generator
+void tcp_bench(const char *host, int port, int connections, int pipeline, int seconds, int size)
+{
+    signal(SIGINT, handle_signal);
+    raise_fd_limit();
+
+    LoadConfig config;
+    config.connections = connections > 0 ? connections : 16;
+    config.pipeline = pipeline > 0 ? pipeline : 8;
+    config.seconds = seconds > 0 ? seconds : 5;
+    config.request_size = size > 0 ? size : 16;
+    config.backend_type = EVENT_BACKEND_EPOLL;
+
+    LoadResult result;
+    if (load_generator_run(host, port, &config, &result) == 0)
+    {
+        print_load_result(&result);
+    }
 }
 
 // UDP Server implementation
@@ -385,6 +2818,400 @@ void udp_server(int port)
     printf("\nUDP Server shut down\n");
 }
 
+// ===== Batched UDP Server =====
+//
+// udp_server pays two syscalls per datagram. The batched server drains up
+// to `batch` datagrams per recvmmsg() and answers them with one
+// sendmmsg(). With offload enabled the kernel also coalesces same-flow
+// datagrams on receive (UDP_GRO), and replies for such a train are sent
+// as one buffer that the kernel splits again (UDP_SEGMENT). Each worker
+// owns a SO_REUSEPORT socket, so the kernel spreads flows across cores.
+
+#define UDP_BATCH_MAX      128
+#define UDP_DATAGRAM_MAX   2048    // Receive buffer without GRO
+#define UDP_GRO_BUFFER     65535   // A GRO train can fill a whole datagram
+#define UDP_MAX_SEGMENTS   64      // Kernel limit per GSO send
+#define UDP_PAYLOAD_MAX    65507
+
+static const char udp_echo_prefix[] = "UDP Server echo: ";
+#define UDP_ECHO_PREFIX_LEN (sizeof(udp_echo_prefix) - 1)
+
+typedef struct
+{
+    int id;
+    int port;
+    int cpu;  // CPU to pin to, or -1
+    int fd;
+    int batch;
+    int offload;  // UDP_GRO on receive, UDP_SEGMENT on reply
+    pthread_t thread;
+
+    // Counters, readable from other threads while the shard runs
+    atomic_ulong datagrams;
+    atomic_ulong bytes_in;
+    atomic_ulong recv_calls;
+    atomic_ulong send_calls;
+    atomic_ulong gso_sends;
+} UdpShard;
+
+// Per-worker buffers, sized once for the configured batch
+typedef struct
+{
+    char *buffers;
+    size_t buffer_size;
+    struct mmsghdr in[UDP_BATCH_MAX];
+    struct iovec in_iov[UDP_BATCH_MAX];
+    struct sockaddr_in peers[UDP_BATCH_MAX];
+    char in_control[UDP_BATCH_MAX][CMSG_SPACE(sizeof(int))];
+
+    // Replies; one received GRO train may need several GSO sends
+    struct mmsghdr out[UDP_BATCH_MAX];
+    struct iovec out_iov[UDP_BATCH_MAX][2 * UDP_MAX_SEGMENTS];
+    char out_control[UDP_BATCH_MAX][CMSG_SPACE(sizeof(uint16_t))];
+    int out_count;
+} UdpBatch;
+
+int create_udp_socket(int port, int reuse_port, int offload)
+{
+    struct sockaddr_in server_addr;
+
+    // Create UDP socket
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+    {
+        perror("socket creation failed");
+        return -1;
+    }
+
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+#ifdef SO_REUSEPORT
+    if (reuse_port && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0)
+    {
+        perror("setsockopt SO_REUSEPORT");
+        close(fd);
+        return -1;
+    }
+#endif
+
+    // Bursts arrive faster than a batch is processed; give them room
+    int rcvbuf = 4 * 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+#ifdef UDP_GRO
+    if (offload && setsockopt(fd, SOL_UDP, UDP_GRO, &opt, sizeof(opt)) < 0)
+    {
+        perror("setsockopt UDP_GRO (continuing without GRO)");
+    }
+#endif
+
+    // Set up server address structure
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(port);
+
+    // Bind socket to specified port
+    if (bind(fd, (struct sockaddr *) &server_addr, sizeof(server_addr)) < 0)
+    {
+        perror("bind failed");
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// Send every queued reply, looping over partial sendmmsg results
+static void udp_flush_replies(UdpShard *shard, UdpBatch *b)
+{
+    TRACE_FUNCTION();
+    int sent = 0;
+    while (sent < b->out_count)
+    {
+        int n = sendmmsg(shard->fd, b->out + sent, b->out_count - sent, 0);
+        atomic_fetch_add_explicit(&shard->send_calls, 1, memory_order_relaxed);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            // Drop the rest of this batch, like a lost datagram
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("sendmmsg");
+            break;
+        }
+        sent += n;
+    }
+    b->out_count = 0;
+}
+
+// Queue echoes for a received buffer holding `segment`-byte datagrams
+// (the last may be shorter), addressed to peer. An empty datagram still
+// gets a bare prefix.
+static void udp_queue_replies(UdpShard *shard,
+                              UdpBatch *b,
+                              struct sockaddr_in *peer,
+                              char *data,
+                              size_t length,
+                              size_t segment)
+{
+    size_t reply_segment = UDP_ECHO_PREFIX_LEN + segment;
+    size_t per_send = 1;
+#ifdef UDP_SEGMENT
+    if (shard->offload)
+    {
+        per_send = UDP_PAYLOAD_MAX / reply_segment;
+        if (per_send > UDP_MAX_SEGMENTS) per_send = UDP_MAX_SEGMENTS;
+        if (per_send == 0) per_send = 1;
+    }
+#endif
+
+    do
+    {
+        if (b->out_count == UDP_BATCH_MAX) udp_flush_replies(shard, b);
+
+        struct mmsghdr *out = &b->out[b->out_count];
+        struct iovec *iov = b->out_iov[b->out_count];
+        int iov_count = 0;
+        size_t segments = 0;
+
+        // Gather prefix + payload pairs; no reply is copied
+        do
+        {
+            size_t chunk = length < segment ? length : segment;
+            iov[iov_count].iov_base = (void *) udp_echo_prefix;
+            iov[iov_count++].iov_len = UDP_ECHO_PREFIX_LEN;
+            iov[iov_count].iov_base = data;
+            iov[iov_count++].iov_len = chunk;
+            data += chunk;
+            length -= chunk;
+            segments++;
+        } while (length > 0 && segments < per_send);
+
+        memset(out, 0, sizeof(*out));
+        out->msg_hdr.msg_name = peer;
+        out->msg_hdr.msg_namelen = sizeof(*peer);
+        out->msg_hdr.msg_iov = iov;
+        out->msg_hdr.msg_iovlen = iov_count;
+
+#ifdef UDP_SEGMENT
+        if (segments > 1)
+        {
+            // The kernel cuts the buffer back into reply_segment datagrams
+            out->msg_hdr.msg_control = b->out_control[b->out_count];
+            out->msg_hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+            struct cmsghdr *cm = CMSG_FIRSTHDR(&out->msg_hdr);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            *(uint16_t *) CMSG_DATA(cm) = (uint16_t) reply_segment;
+            atomic_fetch_add_explicit(&shard->gso_sends, 1, memory_order_relaxed);
+        }
+#endif
+        b->out_count++;
+    } while (length > 0);
+}
+
+void *udp_batch_worker(void *arg)
+{
+    UdpShard *shard = (UdpShard *) arg;
+
+    char thread_name[32];
+    snprintf(thread_name, sizeof(thread_name), "udp %d", shard->id);
+    scope_trace_thread_name(thread_name);
+
+#ifdef __linux__
+    if (shard->cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(shard->cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+
+    UdpBatch *b = (UdpBatch *) calloc(1, sizeof(UdpBatch));
+    if (!b) return NULL;
+    b->buffer_size = shard->offload ? UDP_GRO_BUFFER : UDP_DATAGRAM_MAX;
+    b->buffers = (char *) malloc(b->buffer_size * shard->batch);
+    if (!b->buffers)
+    {
+        free(b);
+        return NULL;
+    }
+
+    for (int i = 0; i < shard->batch; i++)
+    {
+        b->in_iov[i].iov_base = b->buffers + i * b->buffer_size;
+        b->in_iov[i].iov_len = b->buffer_size;
+        b->in[i].msg_hdr.msg_iov = &b->in_iov[i];
+        b->in[i].msg_hdr.msg_iovlen = 1;
+        b->in[i].msg_hdr.msg_name = &b->peers[i];
+    }
+
+    struct pollfd pfd = {shard->fd, POLLIN, 0};
+
+    while (keep_running)
+    {
+        // Wake every 100ms to check keep_running
+        if (poll(&pfd, 1, 100) <= 0) continue;
+
+        while (1)
+        {
+            TRACE_SCOPE("udp batch");
+
+            // Reset the fields recvmmsg overwrites
+            for (int i = 0; i < shard->batch; i++)
+            {
+                b->in[i].msg_hdr.msg_namelen = sizeof(b->peers[i]);
+                b->in[i].msg_hdr.msg_control = b->in_control[i];
+                b->in[i].msg_hdr.msg_controllen = sizeof(b->in_control[i]);
+            }
+
+            int n = recvmmsg(shard->fd, b->in, shard->batch, MSG_DONTWAIT, NULL);
+            if (n <= 0)
+            {
+                if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                {
+                    perror("recvmmsg");
+                }
+                break;
+            }
+            atomic_fetch_add_explicit(&shard->recv_calls, 1, memory_order_relaxed);
+
+            unsigned long datagrams = 0, bytes = 0;
+            for (int i = 0; i < n; i++)
+            {
+                size_t length = b->in[i].msg_len;
+                size_t segment = length;
+
+#ifdef UDP_GRO
+                // A GRO train carries its original datagram size
+                for (struct cmsghdr *cm = CMSG_FIRSTHDR(&b->in[i].msg_hdr); cm;
+                     cm = CMSG_NXTHDR(&b->in[i].msg_hdr, cm))
+                {
+                    if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO)
+                    {
+                        segment = *(int *) CMSG_DATA(cm);
+                    }
+                }
+#endif
+                if (segment == 0) segment = 1;  // Empty datagram
+
+                datagrams += length ? (length + segment - 1) / segment : 1;
+                bytes += length;
+                udp_queue_replies(
+                    shard, b, &b->peers[i], b->in_iov[i].iov_base, length, segment);
+            }
+
+            // Replies point into the receive buffers: send before reusing them
+            udp_flush_replies(shard, b);
+
+            atomic_fetch_add_explicit(&shard->datagrams, datagrams, memory_order_relaxed);
+            atomic_fetch_add_explicit(&shard->bytes_in, bytes, memory_order_relaxed);
+
+            if (n < shard->batch) break;  // Socket drained
+        }
+    }
+
+    free(b->buffers);
+    free(b);
+    return NULL;
+}
+
+void print_udp_shard_stats(UdpShard *shards, int count)
+{
+    printf("%-6s %12s %12s %10s %10s %10s\n",
+           "shard", "datagrams", "bytes in", "recv calls", "send calls", "gso sends");
+    for (int i = 0; i < count; i++)
+    {
+        printf("%-6d %12lu %12lu %10lu %10lu %10lu\n",
+               shards[i].id,
+               atomic_load_explicit(&shards[i].datagrams, memory_order_relaxed),
+               atomic_load_explicit(&shards[i].bytes_in, memory_order_relaxed),
+               atomic_load_explicit(&shards[i].recv_calls, memory_order_relaxed),
+               atomic_load_explicit(&shards[i].send_calls, memory_order_relaxed),
+               atomic_load_explicit(&shards[i].gso_sends, memory_order_relaxed));
+    }
+    fflush(stdout);
+}
+
+// Batched UDP echo server. Datagrams are not printed individually; send
+// SIGUSR1 for per-shard counters.
+void udp_server_batched(int port, int workers, int batch, int offload)
+{
+    signal(SIGINT, handle_signal);
+    signal(SIGUSR1, handle_stats_signal);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers <= 0) workers = cpus > 0 ? (int) cpus : 1;
+    if (batch <= 0 || batch > UDP_BATCH_MAX) batch = 32;
+
+    UdpShard *shards = (UdpShard *) calloc(workers, sizeof(UdpShard));
+    if (!shards)
+    {
+        perror("calloc");
+        return;
+    }
+
+    // Bind every socket before starting threads
+    for (int i = 0; i < workers; i++)
+    {
+        shards[i].id = i;
+        shards[i].port = port;
+        shards[i].cpu = cpus > 0 ? (int) (i % cpus) : -1;
+        shards[i].batch = batch;
+        shards[i].offload = offload;
+        shards[i].fd = create_udp_socket(port, workers > 1, offload);
+        if (shards[i].fd < 0)
+        {
+            workers = i;
+            keep_running = 0;
+            break;
+        }
+    }
+
+    int started = 0;
+    for (int i = 0; i < workers && keep_running; i++)
+    {
+        if (pthread_create(&shards[i].thread, NULL, udp_batch_worker, &shards[i]) != 0)
+        {
+            perror("pthread_create");
+            keep_running = 0;
+            break;
+        }
+        started++;
+    }
+
+    printf("UDP Server listening on port %d: %d worker(s), batch %d%s (pid %d, SIGUSR1 for stats)\n",
+           port,
+           started,
+           batch,
+           offload ? ", GRO/GSO" : "",
+           (int) getpid());
+
+    while (keep_running)
+    {
+        usleep(100000);
+        if (dump_stats)
+        {
+            dump_stats = 0;
+            print_udp_shard_stats(shards, started);
+        }
+    }
+
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(shards[i].thread, NULL);
+    }
+    for (int i = 0; i < workers; i++)
+    {
+        close(shards[i].fd);
+    }
+
+    printf("\nUDP Server shut down\n");
+    print_udp_shard_stats(shards, started);
+    free(shards);
+}
+
 // UDP Client implementation
 void udp_client(const char *server_ip, int port)
 {
@@ -491,26 +3318,24 @@ void udp_client(const char *server_ip, int port)
     printf("\nUDP Client shut down\n");
 }
 
-// Function to resolve a hostname to IP address
-void resolve_hostname(const char *hostname)
+// Print one lookup result
+static void print_resolved(const char *host,
+                           const struct addrinfo *addrs,
+                           int status,
+                           void *user)
 {
-    struct addrinfo hints, *res, *p;
-    int status;
+    long started = *(long *) user;
     char ipstr[INET6_ADDRSTRLEN];
 
-    memset(&hints, 0, sizeof hints);
-    hints.ai_family = AF_UNSPEC;  // AF_INET or AF_INET6 for IPv4/IPv6
-    hints.ai_socktype = SOCK_STREAM;
-
-    if ((status = getaddrinfo(hostname, NULL, &hints, &res)) != 0)
+    if (status != 0)
     {
         fprintf(stderr, "getaddrinfo: %s\n", gai_strerror(status));
         return;
     }
 
-    printf("\nIP addresses for %s:\n\n", hostname);
+    printf("\nIP addresses for %s (%ld ms):\n\n", host, monotonic_ms() - started);
 
-    for (p = res; p != NULL; p = p->ai_next)
+    for (const struct addrinfo *p = addrs; p != NULL; p = p->ai_next)
     {
         void *addr;
         const char *ipver;
@@ -537,8 +3362,34 @@ void resolve_hostname(const char *hostname)
         inet_ntop(p->ai_family, addr, ipstr, sizeof(ipstr));
         printf("  %s: %s\n", ipver, ipstr);
     }
+}
+
+// Resolve a hostname through the asynchronous resolver. Three lookups are
+// issued at once (sharing one query), then a fourth is served from cache.
+void resolve_hostname(const char *hostname)
+{
+    Resolver *r = get_default_resolver();
+    if (!r) return;
+
+    long started = monotonic_ms();
+    for (int i = 0; i < 3; i++)
+    {
+        resolver_resolve(r, hostname, print_resolved, &started);
+    }
+    for (int done = 0; done < 3;)
+    {
+        done += resolver_wait(r, 1000);
+        if (monotonic_ms() - started > 10000) break;
+    }
 
-    freeaddrinfo(res);
+    started = monotonic_ms();
+    resolver_resolve(r, hostname, print_resolved, &started);
+    resolver_wait(r, 1000);
+
+    printf("\nResolver: %lu miss(es), %lu coalesced, %lu cache hit(s)\n",
+           r->misses,
+           r->coalesced,
+           r->hits);
 }
 
 int main(int argc, char *argv[])
@@ -551,11 +3402,21 @@ int main(int argc, char *argv[])
         printf("Usage: %s [option]\n", argv[0]);
         printf("Options:\n");
         printf(
-            "  tcpserver <port>       - Run a TCP server on specified port\n");
+            "  tcpserver <port> [select|epoll|io_uring]\n"
+            "                         - Run a TCP server on specified port\n");
+        printf(
+            "  tcpshards <port> [workers] [backend] [pin]\n"
+            "                         - Run one SO_REUSEPORT event loop per worker\n");
         printf(
-            "  tcpclient <ip> <port>  - Run a TCP client connecting to specified IP and port\n");
+            "  tcpclient <host> <port> - Run a TCP client connecting to specified host and port\n");
+        printf(
+            "  tcpbench <host> <port> [connections] [pipeline] [seconds] [size]\n"
+            "                         - Load-test a TCP server with pipelined requests\n");
         printf(
             "  udpserver <port>       - Run a UDP server on specified port\n");
+        printf(
+            "  udpbatch <port> [workers] [batch] [gro]\n"
+            "                         - Run a batched recvmmsg/sendmmsg UDP server\n");
         printf(
             "  udpclient <ip> <port>  - Run a UDP client connecting to specified IP and port\n");
         printf("  resolve <hostname>     - Resolve hostname to IP addresses\n");
@@ -570,17 +3431,43 @@ int main(int argc, char *argv[])
             printf("Error: Port number required for TCP server\n");
             return 1;
         }
-        tcp_server(atoi(argv[2]));
+        tcp_server(atoi(argv[2]), parse_event_backend(argc > 3 ? argv[3] : NULL));
+    }
+    else if (strcmp(argv[1], "tcpshards") == 0)
+    {
+        if (argc < 3)
+        {
+            printf("Error: Port number required for TCP server\n");
+            return 1;
+        }
+        tcp_server_sharded(atoi(argv[2]),
+                           argc > 3 ? atoi(argv[3]) : 0,
+                           parse_event_backend(argc > 4 ? argv[4] : NULL),
+                           argc > 5 && strcmp(argv[5], "pin") == 0);
     }
     else if (strcmp(argv[1], "tcpclient") == 0)
     {
         if (argc < 4)
         {
-            printf("Error: IP address and port required for TCP client\n");
+            printf("Error: Host and port required for TCP client\n");
             return 1;
         }
         tcp_client(argv[2], atoi(argv[3]));
     }
+    else if (strcmp(argv[1], "tcpbench") == 0)
+    {
+        if (argc < 4)
+        {
+            printf("Error: Host and port required for TCP benchmark\n");
+            return 1;
+        }
+        tcp_bench(argv[2],
+                  atoi(argv[3]),
+                  argc > 4 ? atoi(argv[4]) : 0,
+                  argc > 5 ? atoi(argv[5]) : 0,
+                  argc > 6 ? atoi(argv[6]) : 0,
+                  argc > 7 ? atoi(argv[7]) : 0);
+    }
     else if (strcmp(argv[1], "udpserver") == 0)
     {
         if (argc < 3)
@@ -590,6 +3477,18 @@ int main(int argc, char *argv[])
         }
         udp_server(atoi(argv[2]));
     }
+    else if (strcmp(argv[1], "udpbatch") == 0)
+    {
+        if (argc < 3)
+        {
+            printf("Error: Port number required for UDP server\n");
+            return 1;
+        }
+        udp_server_batched(atoi(argv[2]),
+                           argc > 3 ? atoi(argv[3]) : 0,
+                           argc > 4 ? atoi(argv[4]) : 0,
+                           argc > 5 && strcmp(argv[5], "gro") == 0);
+    }
     else if (strcmp(argv[1], "udpclient") == 0)
     {
         if (argc < 4)
@@ -614,5 +3513,13 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    if (default_resolver)
+    {
+        resolver_destroy(default_resolver);
+    }
+
+    long spans = scope_trace_write_json("network_trace.json");
+    if (spans > 0) printf("Wrote %ld spans to network_trace.json\n", spans);
+
     return 0;
 }
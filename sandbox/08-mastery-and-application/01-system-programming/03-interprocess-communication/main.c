@@ -1,6 +1,13 @@
+#define _GNU_SOURCE
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <semaphore.h>
 #include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,12 +16,26 @@
 #include <sys/msg.h>
 #include <sys/sem.h>
 #include <sys/shm.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
 
+// semctl's argument; glibc leaves it to the caller and says so with
+// _SEM_SEMUN_UNDEFINED, while BSD and macOS define it in <sys/sem.h>
+#if defined(_SEM_SEMUN_UNDEFINED)
+union semun
+{
+    int val;
+    struct semid_ds *buf;
+    unsigned short *array;
+};
+#endif
+
 // Flag for graceful termination
 volatile sig_atomic_t keep_running = 1;
 
@@ -749,9 +770,1611 @@ void posix_shm_demo()
     }
 }
 
-int main(int argc, char *argv[])
+// ===== Shared-Memory Ring Buffer =====
+//
+// A bounded queue of fixed-size messages in POSIX shared memory. Producer
+// and consumer indices live on separate cache lines so the two sides do
+// not bounce one line between cores, and both sides work in batches:
+// one index update publishes or releases many messages. SPSC mode uses
+// plain head/tail indices; MPMC mode gives every slot a sequence number
+// (Vyukov's bounded queue) and claims runs of slots with one CAS. An idle
+// consumer sleeps on a futex; producers only make the wake syscall when
+// someone is actually sleeping.
+
+#define CACHE_LINE_SIZE 64
+
+typedef enum
 {
-    printf("=== Interprocess Communication (IPC) Demonstration ===\n");
+    RING_SPSC,
+    RING_MPMC,
+} RingMode;
+
+typedef struct
+{
+    atomic_uint_fast64_t seq;  // MPMC: readiness of this slot
+    uint64_t data[];           // Payload, message_size bytes
+} RingSlot;
+
+typedef struct
+{
+    // Producer side
+    _Alignas(CACHE_LINE_SIZE) atomic_uint_fast64_t head;
+    // Consumer side
+    _Alignas(CACHE_LINE_SIZE) atomic_uint_fast64_t tail;
+    // Wakeup state, touched only around sleeps
+    _Alignas(CACHE_LINE_SIZE) atomic_uint futex_word;
+    atomic_uint sleepers;
+    atomic_uint closed;  // No more messages will be published
+
+    // Read-only after creation
+    _Alignas(CACHE_LINE_SIZE) uint32_t mode;
+    uint32_t capacity;  // Power of two
+    uint32_t message_size;
+    uint32_t slot_size;
+    size_t map_size;
+    _Alignas(CACHE_LINE_SIZE) unsigned char slots[];
+} SharedRing;
+
+// Process-local view of a ring, with SPSC index caches
+typedef struct
+{
+    SharedRing *shared;
+    uint64_t cached_tail;  // Producer's last view of tail
+    uint64_t cached_head;  // Consumer's last view of head
+} RingHandle;
+
+static long futex_call(atomic_uint *word, int op, unsigned value)
+{
+    // Not FUTEX_PRIVATE: the word is shared between processes
+    return syscall(SYS_futex, (unsigned *) word, op, value, NULL, NULL, 0);
+}
+
+static RingSlot *ring_slot(SharedRing *ring, uint64_t index)
+{
+    return (RingSlot *) (ring->slots + (size_t) (index & (ring->capacity - 1)) * ring->slot_size);
+}
+
+// Create (or replace) a named ring; capacity is rounded up to a power of two
+int shm_ring_create(RingHandle *handle,
+                    const char *name,
+                    uint32_t capacity,
+                    uint32_t message_size,
+                    RingMode mode)
+{
+    uint32_t rounded = 1;
+    while (rounded < capacity) rounded <<= 1;
+
+    uint32_t slot_size = sizeof(RingSlot) + ((message_size + 7) & ~7u);
+    size_t map_size = sizeof(SharedRing) + (size_t) rounded * slot_size;
+
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd == -1)
+    {
+        perror("shm_open");
+        return -1;
+    }
+    if (ftruncate(fd, map_size) == -1)
+    {
+        perror("ftruncate");
+        close(fd);
+        shm_unlink(name);
+        return -1;
+    }
+
+    SharedRing *ring = (SharedRing *) mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ring == MAP_FAILED)
+    {
+        perror("mmap");
+        shm_unlink(name);
+        return -1;
+    }
+
+    // ftruncate zero-fills, so only non-zero fields need setting
+    ring->mode = mode;
+    ring->capacity = rounded;
+    ring->message_size = message_size;
+    ring->slot_size = slot_size;
+    ring->map_size = map_size;
+    for (uint32_t i = 0; i < rounded; i++)
+    {
+        atomic_store_explicit(&ring_slot(ring, i)->seq, i, memory_order_relaxed);
+    }
+
+    memset(handle, 0, sizeof(*handle));
+    handle->shared = ring;
+    return 0;
+}
+
+// Map a ring created by another process
+int shm_ring_open(RingHandle *handle, const char *name)
+{
+    int fd = shm_open(name, O_RDWR, 0600);
+    if (fd == -1)
+    {
+        perror("shm_open");
+        return -1;
+    }
+
+    size_t map_size = 0;
+    struct stat st;
+    if (fstat(fd, &st) == 0) map_size = st.st_size;
+
+    SharedRing *ring = map_size ? (SharedRing *) mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                                : (SharedRing *) MAP_FAILED;
+    close(fd);
+    if (ring == MAP_FAILED)
+    {
+        perror("mmap");
+        return -1;
+    }
+
+    memset(handle, 0, sizeof(*handle));
+    handle->shared = ring;
+    return 0;
+}
+
+void shm_ring_close(RingHandle *handle)
+{
+    munmap(handle->shared, handle->shared->map_size);
+    handle->shared = NULL;
+}
+
+// Wake the consumer if it went to sleep. The fence orders our publish
+// before the sleepers check, pairing with the consumer's re-check.
+static void ring_wake(SharedRing *ring)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&ring->sleepers, memory_order_relaxed) > 0)
+    {
+        atomic_fetch_add_explicit(&ring->futex_word, 1, memory_order_release);
+        futex_call(&ring->futex_word, FUTEX_WAKE, INT_MAX);
+    }
+}
+
+// Publish up to count messages from a contiguous array; returns how many
+// fit. One index update (SPSC) or one CAS (MPMC) covers the whole batch.
+uint32_t shm_ring_try_publish(RingHandle *handle, const void *messages, uint32_t count)
+{
+    SharedRing *ring = handle->shared;
+    const unsigned char *src = (const unsigned char *) messages;
+    uint64_t start;
+    uint32_t n;
+
+    if (ring->mode == RING_SPSC)
+    {
+        start = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        uint64_t free_slots = ring->capacity - (start - handle->cached_tail);
+        if (free_slots < count)
+        {
+            // Only read the consumer's line when the cached view runs out
+            handle->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+            free_slots = ring->capacity - (start - handle->cached_tail);
+        }
+        n = count < free_slots ? count : (uint32_t) free_slots;
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            memcpy(ring_slot(ring, start + i)->data, src + (size_t) i * ring->message_size, ring->message_size);
+        }
+        if (n) atomic_store_explicit(&ring->head, start + n, memory_order_release);
+    }
+    else
+    {
+        // Claim the run of free slots starting at head
+        start = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        do
+        {
+            n = 0;
+            while (n < count
+                   && atomic_load_explicit(&ring_slot(ring, start + n)->seq, memory_order_acquire)
+                          == start + n)
+            {
+                n++;
+            }
+            if (n == 0) return 0;
+        } while (!atomic_compare_exchange_weak_explicit(
+            &ring->head, &start, start + n, memory_order_relaxed, memory_order_relaxed));
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            RingSlot *slot = ring_slot(ring, start + i);
+            memcpy(slot->data, src + (size_t) i * ring->message_size, ring->message_size);
+            atomic_store_explicit(&slot->seq, start + i + 1, memory_order_release);
+        }
+    }
+
+    if (n) ring_wake(ring);
+    return n;
+}
+
+// Publish every message, yielding while the ring is full
+void shm_ring_publish(RingHandle *handle, const void *messages, uint32_t count)
+{
+    const unsigned char *src = (const unsigned char *) messages;
+    while (count > 0)
+    {
+        uint32_t n = shm_ring_try_publish(handle, src, count);
+        if (n == 0)
+        {
+            sched_yield();
+            continue;
+        }
+        src += (size_t) n * handle->shared->message_size;
+        count -= n;
+    }
+}
+
+// Copy up to max messages out; returns how many were available
+uint32_t shm_ring_try_consume(RingHandle *handle, void *out, uint32_t max)
+{
+    SharedRing *ring = handle->shared;
+    unsigned char *dst = (unsigned char *) out;
+    uint64_t start;
+    uint32_t n;
+
+    if (ring->mode == RING_SPSC)
+    {
+        start = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint64_t available = handle->cached_head - start;
+        if (available < max)
+        {
+            handle->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+            available = handle->cached_head - start;
+        }
+        n = max < available ? max : (uint32_t) available;
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            memcpy(dst + (size_t) i * ring->message_size, ring_slot(ring, start + i)->data, ring->message_size);
+        }
+        if (n) atomic_store_explicit(&ring->tail, start + n, memory_order_release);
+        return n;
+    }
+
+    // Claim the run of filled slots starting at tail
+    start = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    do
+    {
+        n = 0;
+        while (n < max
+               && atomic_load_explicit(&ring_slot(ring, start + n)->seq, memory_order_acquire)
+                      == start + n + 1)
+        {
+            n++;
+        }
+        if (n == 0) return 0;
+    } while (!atomic_compare_exchange_weak_explicit(
+        &ring->tail, &start, start + n, memory_order_relaxed, memory_order_relaxed));
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        RingSlot *slot = ring_slot(ring, start + i);
+        memcpy(dst + (size_t) i * ring->message_size, slot->data, ring->message_size);
+        // Free the slot for the producer one lap ahead
+        atomic_store_explicit(&slot->seq, start + i + ring->capacity, memory_order_release);
+    }
+    return n;
+}
+
+// Consume, spinning briefly and then sleeping on the futex while the ring
+// is empty. Returns 0 once the ring is closed and drained.
+uint32_t shm_ring_consume(RingHandle *handle, void *out, uint32_t max)
+{
+    SharedRing *ring = handle->shared;
+
+    while (1)
+    {
+        for (int spin = 0; spin < 256; spin++)
+        {
+            uint32_t n = shm_ring_try_consume(handle, out, max);
+            if (n) return n;
+            if (atomic_load_explicit(&ring->closed, memory_order_acquire))
+            {
+                // Messages published before close must still be drained
+                return shm_ring_try_consume(handle, out, max);
+            }
+        }
+
+        unsigned seen = atomic_load_explicit(&ring->futex_word, memory_order_acquire);
+        atomic_fetch_add_explicit(&ring->sleepers, 1, memory_order_seq_cst);
+
+        // Re-check after announcing ourselves: a producer that published
+        // before seeing sleepers > 0 is caught here
+        uint32_t n = shm_ring_try_consume(handle, out, max);
+        if (n == 0 && !atomic_load_explicit(&ring->closed, memory_order_acquire))
+        {
+            futex_call(&ring->futex_word, FUTEX_WAIT, seen);
+        }
+        atomic_fetch_sub_explicit(&ring->sleepers, 1, memory_order_relaxed);
+        if (n) return n;
+    }
+}
+
+// Producer side: no more messages; wakes sleeping consumers
+void shm_ring_close_producer(RingHandle *handle)
+{
+    atomic_store_explicit(&handle->shared->closed, 1, memory_order_release);
+    atomic_fetch_add_explicit(&handle->shared->futex_word, 1, memory_order_release);
+    futex_call(&handle->shared->futex_word, FUTEX_WAKE, INT_MAX);
+}
+
+#define RING_DEMO_MESSAGES 5000000
+#define RING_DEMO_BATCH    64
+
+typedef struct
+{
+    uint64_t producer;
+    uint64_t sequence;
+    uint64_t payload[6];  // Pad the message to a cache line
+} RingMessage;
+
+static double ring_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Consumer process body: drain until closed, checking per-producer order
+// in SPSC mode; reports count and checksum through a pipe
+static void ring_consumer(const char *name, int report_fd)
+{
+    RingHandle handle;
+    if (shm_ring_open(&handle, name) < 0) exit(1);
+
+    RingMessage batch[RING_DEMO_BATCH];
+    uint64_t received = 0, checksum = 0, expected = 0, out_of_order = 0;
+    uint32_t n;
+
+    while ((n = shm_ring_consume(&handle, batch, RING_DEMO_BATCH)) > 0)
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            if (handle.shared->mode == RING_SPSC && batch[i].sequence != expected++)
+            {
+                out_of_order++;
+            }
+            checksum += batch[i].sequence + batch[i].producer;
+        }
+        received += n;
+    }
+
+    uint64_t report[3] = {received, checksum, out_of_order};
+    if (write(report_fd, report, sizeof(report)) != sizeof(report)) exit(1);
+    shm_ring_close(&handle);
+    exit(0);
+}
+
+static void ring_producer(const char *name, uint64_t id, uint64_t count)
+{
+    RingHandle handle;
+    if (shm_ring_open(&handle, name) < 0) exit(1);
+
+    RingMessage batch[RING_DEMO_BATCH];
+    memset(batch, 0, sizeof(batch));
+
+    for (uint64_t sent = 0; sent < count;)
+    {
+        uint32_t n = count - sent < RING_DEMO_BATCH ? (uint32_t) (count - sent) : RING_DEMO_BATCH;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            batch[i].producer = id;
+            batch[i].sequence = sent + i;
+        }
+        shm_ring_publish(&handle, batch, n);
+        sent += n;
+    }
+
+    shm_ring_close(&handle);
+    exit(0);
+}
+
+// Run producers and consumers as separate processes over one ring
+static void run_ring_benchmark(RingMode mode, int producers, int consumers)
+{
+    const char *name = "/ipc_ring_demo";
+    RingHandle handle;
+    if (shm_ring_create(&handle, name, 4096, sizeof(RingMessage), mode) < 0) return;
+
+    int report[2];
+    if (pipe(report) == -1)
+    {
+        perror("pipe");
+        shm_ring_close(&handle);
+        shm_unlink(name);
+        return;
+    }
+
+    uint64_t per_producer = RING_DEMO_MESSAGES / producers;
+    double start = ring_seconds();
+
+    for (int i = 0; i < consumers; i++)
+    {
+        if (fork() == 0)
+        {
+            close(report[0]);
+            ring_consumer(name, report[1]);
+        }
+    }
+    pid_t producer_pids[producers];
+    for (int i = 0; i < producers; i++)
+    {
+        producer_pids[i] = fork();
+        if (producer_pids[i] == 0)
+        {
+            ring_producer(name, i, per_producer);
+        }
+    }
+    close(report[1]);
+
+    for (int i = 0; i < producers; i++)
+    {
+        waitpid(producer_pids[i], NULL, 0);
+    }
+    shm_ring_close_producer(&handle);
+
+    uint64_t received = 0, checksum = 0, out_of_order = 0, part[3];
+    while (read(report[0], part, sizeof(part)) == sizeof(part))
+    {
+        received += part[0];
+        checksum += part[1];
+        out_of_order += part[2];
+    }
+    while (wait(NULL) > 0)
+    {
+    }
+    double elapsed = ring_seconds() - start;
+
+    uint64_t expected_sum = 0;
+    for (int p = 0; p < producers; p++)
+    {
+        expected_sum += per_producer * (per_producer - 1) / 2 + per_producer * p;
+    }
+
+    printf("%s %dP/%dC: %llu messages in %.3f s = %.2f M msg/s (%s)\n",
+           mode == RING_SPSC ? "SPSC" : "MPMC",
+           producers,
+           consumers,
+           (unsigned long long) received,
+           elapsed,
+           received / elapsed / 1e6,
+           received == per_producer * producers && checksum == expected_sum && !out_of_order
+               ? "verified"
+               : "MISMATCH");
+
+    close(report[0]);
+    shm_ring_close(&handle);
+    shm_unlink(name);
+}
+
+// Function to demonstrate the shared-memory ring buffer
+void shm_ring_demo()
+{
+    printf("\n=== Shared-Memory Ring Buffer Demonstration ===\n");
+    printf("64-byte messages, batches of %d, 4096-slot ring\n", RING_DEMO_BATCH);
+
+    run_ring_benchmark(RING_SPSC, 1, 1);
+    run_ring_benchmark(RING_MPMC, 2, 2);
+}
+
+// ===== Zero-Copy Large Messages: memfd + SCM_RIGHTS =====
+//
+// Pipes and message queues copy every payload into the kernel and out
+// again. Here the sender writes payloads straight into a memfd arena that
+// both processes map; only a small descriptor (slot, length) crosses the
+// UNIX socket, and the arena's fd itself is passed once with SCM_RIGHTS.
+// The receiver hands each slot back when done with it. Payloads too large
+// for a slot travel in a memfd of their own, sealed so the receiver can
+// map it without fearing a shrink (SIGBUS).
+
+#define MEMFD_SLOT_COUNT 8
+#define MEMFD_SLOT_SIZE  (8u << 20)
+
+typedef struct
+{
+    uint32_t slot;    // Arena slot, or MEMFD_OWN_FD when an fd is attached
+    uint32_t flags;
+    uint64_t length;
+    uint64_t checksum;
+} MemfdMessage;
+
+#define MEMFD_OWN_FD    0xffffffffu
+#define MEMFD_MSG_ARENA 0x1  // Carries the arena fd
+#define MEMFD_MSG_DONE  0x2  // Sender is finished
+
+typedef struct
+{
+    int sock;
+    int arena_fd;
+    unsigned char *arena;
+    int arena_sent;
+    uint32_t free_mask;  // Sender: slots not lent to the receiver
+} MemfdChannel;
+
+// Send a descriptor message, optionally attaching one fd
+static int memfd_send_message(int sock, const MemfdMessage *msg, int fd)
+{
+    struct iovec iov = {(void *) msg, sizeof(*msg)};
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+
+    if (fd >= 0)
+    {
+        memset(control, 0, sizeof(control));
+        hdr.msg_control = control;
+        hdr.msg_controllen = sizeof(control);
+        struct cmsghdr *cm = CMSG_FIRSTHDR(&hdr);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cm), &fd, sizeof(int));
+    }
+
+    return sendmsg(sock, &hdr, 0) == sizeof(*msg) ? 0 : -1;
+}
+
+// Receive a descriptor message; *fd gets an attached descriptor or -1
+static int memfd_recv_message(int sock, MemfdMessage *msg, int *fd)
+{
+    struct iovec iov = {msg, sizeof(*msg)};
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof(control);
+
+    *fd = -1;
+    if (recvmsg(sock, &hdr, MSG_CMSG_CLOEXEC) != sizeof(*msg)) return -1;
+
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&hdr); cm; cm = CMSG_NXTHDR(&hdr, cm))
+    {
+        if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS)
+        {
+            memcpy(fd, CMSG_DATA(cm), sizeof(int));
+        }
+    }
+    return 0;
+}
+
+static uint64_t payload_checksum(const unsigned char *data, uint64_t length)
+{
+    // Sample one word per page: enough to catch a wrong or stale mapping
+    uint64_t sum = length;
+    for (uint64_t i = 0; i + sizeof(uint64_t) <= length; i += 4096)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        sum = sum * 31 + word;
+    }
+    return sum;
+}
+
+// Mark one word per page so both demo paths do the same producer work
+static void payload_stamp(unsigned char *data, uint64_t length, uint64_t value)
+{
+    for (uint64_t i = 0; i + sizeof(uint64_t) <= length; i += 4096)
+    {
+        memcpy(data + i, &value, sizeof(value));
+    }
+}
+
+static int memfd_create_sized(const char *name, size_t size)
+{
+    int fd = (int) syscall(SYS_memfd_create, name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0)
+    {
+        perror("memfd_create");
+        return -1;
+    }
+    if (ftruncate(fd, size) == -1)
+    {
+        perror("ftruncate");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int memfd_channel_init_sender(MemfdChannel *ch, int sock)
+{
+    memset(ch, 0, sizeof(*ch));
+    ch->sock = sock;
+    ch->arena_fd = memfd_create_sized("ipc-arena", (size_t) MEMFD_SLOT_COUNT * MEMFD_SLOT_SIZE);
+    if (ch->arena_fd < 0) return -1;
+
+    // The arena never changes size, so the receiver's mapping stays valid
+    fcntl(ch->arena_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+
+    ch->arena = (unsigned char *) mmap(NULL,
+                                       (size_t) MEMFD_SLOT_COUNT * MEMFD_SLOT_SIZE,
+                                       PROT_READ | PROT_WRITE,
+                                       MAP_SHARED | MAP_POPULATE,
+                                       ch->arena_fd,
+                                       0);
+    // Populated up front: slots are reused, so faults are paid only once
+    if (ch->arena == MAP_FAILED)
+    {
+        perror("mmap");
+        close(ch->arena_fd);
+        return -1;
+    }
+    ch->free_mask = (1u << MEMFD_SLOT_COUNT) - 1;
+    return 0;
+}
+
+// Reserve a buffer of `length` bytes to fill in place. Returns the buffer
+// and sets *slot (MEMFD_OWN_FD plus *own_fd for oversized payloads).
+unsigned char *memfd_channel_reserve(MemfdChannel *ch, uint64_t length, uint32_t *slot, int *own_fd)
+{
+    *own_fd = -1;
+
+    if (length > MEMFD_SLOT_SIZE)
+    {
+        *own_fd = memfd_create_sized("ipc-payload", length);
+        if (*own_fd < 0) return NULL;
+        fcntl(*own_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+        *slot = MEMFD_OWN_FD;
+        void *map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, *own_fd, 0);
+        if (map == MAP_FAILED)
+        {
+            close(*own_fd);
+            *own_fd = -1;
+            return NULL;
+        }
+        return (unsigned char *) map;
+    }
+
+    // Wait for the receiver to return a slot if all are lent out
+    while (ch->free_mask == 0)
+    {
+        MemfdMessage ack;
+        int fd;
+        if (memfd_recv_message(ch->sock, &ack, &fd) < 0) return NULL;
+        if (ack.slot < MEMFD_SLOT_COUNT) ch->free_mask |= 1u << ack.slot;
+    }
+
+    *slot = (uint32_t) __builtin_ctz(ch->free_mask);
+    ch->free_mask &= ~(1u << *slot);
+    return ch->arena + (size_t) *slot * MEMFD_SLOT_SIZE;
+}
+
+// Hand a filled buffer to the receiver: only the descriptor is sent
+int memfd_channel_send(MemfdChannel *ch, unsigned char *buffer, uint64_t length, uint32_t slot, int own_fd)
+{
+    MemfdMessage msg = {slot, 0, length, payload_checksum(buffer, length)};
+    int fd = own_fd;
+
+    if (slot != MEMFD_OWN_FD && !ch->arena_sent)
+    {
+        msg.flags |= MEMFD_MSG_ARENA;
+        fd = ch->arena_fd;
+        ch->arena_sent = 1;
+    }
+
+    int result = memfd_send_message(ch->sock, &msg, fd);
+    if (own_fd >= 0)
+    {
+        // The receiver holds its own reference now
+        munmap(buffer, length);
+        close(own_fd);
+    }
+    return result;
+}
+
+void memfd_channel_finish(MemfdChannel *ch)
+{
+    MemfdMessage done = {0, MEMFD_MSG_DONE, 0, 0};
+    memfd_send_message(ch->sock, &done, -1);
+
+    munmap(ch->arena, (size_t) MEMFD_SLOT_COUNT * MEMFD_SLOT_SIZE);
+    close(ch->arena_fd);
+}
+
+// Receiver loop: map payloads, verify them and return arena slots.
+// Returns the number of bytes received.
+uint64_t memfd_channel_receive_all(int sock, uint64_t *bad)
+{
+    unsigned char *arena = NULL;
+    uint64_t total = 0;
+    *bad = 0;
+
+    while (1)
+    {
+        MemfdMessage msg;
+        int fd;
+        if (memfd_recv_message(sock, &msg, &fd) < 0 || (msg.flags & MEMFD_MSG_DONE)) break;
+
+        const unsigned char *data;
+        if (msg.flags & MEMFD_MSG_ARENA)
+        {
+            arena = (unsigned char *) mmap(NULL,
+                                           (size_t) MEMFD_SLOT_COUNT * MEMFD_SLOT_SIZE,
+                                           PROT_READ,
+                                           MAP_SHARED | MAP_POPULATE,
+                                           fd,
+                                           0);
+            close(fd);
+            fd = -1;
+            if (arena == MAP_FAILED) break;
+        }
+
+        if (msg.slot == MEMFD_OWN_FD)
+        {
+            data = (const unsigned char *) mmap(NULL, msg.length, PROT_READ, MAP_SHARED, fd, 0);
+            close(fd);
+            if (data == MAP_FAILED) break;
+        }
+        else
+        {
+            data = arena + (size_t) msg.slot * MEMFD_SLOT_SIZE;
+        }
+
+        if (payload_checksum(data, msg.length) != msg.checksum) (*bad)++;
+        total += msg.length;
+
+        if (msg.slot == MEMFD_OWN_FD)
+        {
+            munmap((void *) data, msg.length);
+        }
+        else
+        {
+            // Give the slot back to the sender
+            MemfdMessage ack = {msg.slot, 0, 0, 0};
+            memfd_send_message(sock, &ack, -1);
+        }
+    }
+
+    if (arena && arena != MAP_FAILED)
+    {
+        munmap(arena, (size_t) MEMFD_SLOT_COUNT * MEMFD_SLOT_SIZE);
+    }
+    return total;
+}
+
+// Baseline: stream the payload through the socket, copying both ways
+static uint64_t copy_receive_all(int sock, uint64_t expected)
+{
+    unsigned char *buffer = (unsigned char *) malloc(1 << 20);
+    uint64_t total = 0;
+    ssize_t n;
+    while (buffer && total < expected && (n = read(sock, buffer, 1 << 20)) > 0)
+    {
+        total += n;
+    }
+    free(buffer);
+    return total;
+}
+
+#define MEMFD_DEMO_MESSAGES 64
+#define MEMFD_DEMO_SIZE     (8u << 20)
+
+// Function to demonstrate memfd payload passing against copying
+void memfd_ipc_demo()
+{
+    printf("\n=== Zero-Copy memfd + SCM_RIGHTS Demonstration ===\n");
+
+    uint64_t total = (uint64_t) MEMFD_DEMO_MESSAGES * MEMFD_DEMO_SIZE;
+
+    // Copying baseline over a stream socket
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1)
+    {
+        perror("socketpair");
+        return;
+    }
+    unsigned char *source = (unsigned char *) malloc(MEMFD_DEMO_SIZE);
+    if (!source)
+    {
+        close(sv[0]);
+        close(sv[1]);
+        return;
+    }
+    memset(source, 0x5a, MEMFD_DEMO_SIZE);
+
+    double start = ring_seconds();
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(sv[0]);
+        uint64_t got = copy_receive_all(sv[1], total);
+        exit(got == total ? 0 : 1);
+    }
+    close(sv[1]);
+    for (int i = 0; i < MEMFD_DEMO_MESSAGES; i++)
+    {
+        // Stamp each payload, as the memfd path below does
+        payload_stamp(source, MEMFD_DEMO_SIZE, i);
+        for (size_t off = 0; off < MEMFD_DEMO_SIZE;)
+        {
+            ssize_t n = write(sv[0], source + off, MEMFD_DEMO_SIZE - off);
+            if (n <= 0) break;
+            off += n;
+        }
+    }
+    close(sv[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    double copy_time = ring_seconds() - start;
+    printf("Socket copy:   %3d x %u MB in %.3f s = %.2f GB/s\n",
+           MEMFD_DEMO_MESSAGES,
+           MEMFD_DEMO_SIZE >> 20,
+           copy_time,
+           total / copy_time / 1e9);
+
+    // memfd arena: only descriptors cross the socket
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) == -1)
+    {
+        perror("socketpair");
+        free(source);
+        return;
+    }
+
+    int report[2];
+    if (pipe(report) == -1)
+    {
+        perror("pipe");
+        close(sv[0]);
+        close(sv[1]);
+        free(source);
+        return;
+    }
+
+    start = ring_seconds();
+    pid = fork();
+    if (pid == 0)
+    {
+        close(sv[0]);
+        close(report[0]);
+        uint64_t got[2];
+        got[0] = memfd_channel_receive_all(sv[1], &got[1]);
+        if (write(report[1], got, sizeof(got)) != sizeof(got)) exit(1);
+        exit(0);
+    }
+    close(sv[1]);
+    close(report[1]);
+
+    MemfdChannel ch;
+    if (memfd_channel_init_sender(&ch, sv[0]) == 0)
+    {
+        for (int i = 0; i < MEMFD_DEMO_MESSAGES; i++)
+        {
+            // Last message is oversized to exercise fd-per-payload passing
+            uint64_t length = i == MEMFD_DEMO_MESSAGES - 1 ? MEMFD_SLOT_SIZE + 4096 : MEMFD_DEMO_SIZE;
+            uint32_t slot;
+            int own_fd;
+            unsigned char *buffer = memfd_channel_reserve(&ch, length, &slot, &own_fd);
+            if (!buffer) break;
+
+            // Write the payload in place; in real use this is where the
+            // data is produced, so no extra copy exists at all
+            payload_stamp(buffer, length, i);
+            memfd_channel_send(&ch, buffer, length, slot, own_fd);
+        }
+        memfd_channel_finish(&ch);
+    }
+
+    uint64_t got[2] = {0, 0};
+    if (read(report[0], got, sizeof(got)) != sizeof(got)) got[1] = 1;
+    waitpid(pid, &status, 0);
+    close(sv[0]);
+    close(report[0]);
+    double memfd_time = ring_seconds() - start;
+    printf("memfd arena:   %3d x %u MB in %.3f s = %.2f GB/s (%llu MB received, %llu bad)\n",
+           MEMFD_DEMO_MESSAGES,
+           MEMFD_DEMO_SIZE >> 20,
+           memfd_time,
+           got[0] / memfd_time / 1e9,
+           (unsigned long long) (got[0] >> 20),
+           (unsigned long long) got[1]);
+
+    free(source);
+}
+
+// ===== Pipes: vmsplice / splice =====
+//
+// vmsplice() hands user pages to a pipe by reference instead of copying
+// them in, and splice() moves pipe pages into another fd without a trip
+// through user space. The sender must not modify spliced pages until the
+// reader has consumed them. Falls back to write() where unsupported.
+
+// Write a buffer into a pipe, by page reference where possible
+ssize_t pipe_send_zero_copy(int pipe_fd, const void *data, size_t length)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        struct iovec iov = {(char *) data + done, length - done};
+        ssize_t n = vmsplice(pipe_fd, &iov, 1, 0);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno == ENOSYS || errno == EINVAL)
+            {
+                n = write(pipe_fd, (const char *) data + done, length - done);
+                if (n < 0) return -1;
+            }
+            else
+            {
+                return -1;
+            }
+        }
+        done += n;
+    }
+    return (ssize_t) done;
+}
+
+// Function to demonstrate vmsplice against write on a pipe. Only the
+// sending side differs: vmsplice maps the source pages into the pipe
+// where write copies them. The reader is the same in both modes and reads
+// and checksums every byte, so the rates are end-to-end transfer rates.
+void splice_pipe_demo()
+{
+    printf("\n=== vmsplice Pipe Demonstration ===\n");
+
+    const size_t chunk = 1 << 20;
+    const int chunks = 512;
+    unsigned char *source = (unsigned char *) aligned_alloc(4096, chunk);
+    if (!source) return;
+    memset(source, 0xa5, chunk);
+
+    for (int mode = 0; mode < 2; mode++)
+    {
+        int fds[2];
+        if (pipe(fds) == -1)
+        {
+            perror("pipe");
+            break;
+        }
+#ifdef F_SETPIPE_SZ
+        fcntl(fds[1], F_SETPIPE_SZ, (int) chunk);
+#endif
+
+        double start = ring_seconds();
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            close(fds[1]);
+            unsigned char *buffer = (unsigned char *) malloc(chunk);
+            uint64_t total = 0, sum = 0;
+            ssize_t n;
+            while (buffer && (n = read(fds[0], buffer, chunk)) > 0)
+            {
+                for (ssize_t i = 0; i < n; i++) sum += buffer[i];
+                total += n;
+            }
+            free(buffer);
+            uint64_t expected = (uint64_t) chunk * chunks;
+            exit(total == expected && sum == expected * 0xa5 ? 0 : 1);
+        }
+    close(fds[0]);
+
+        for (int i = 0; i < chunks; i++)
+        {
+            if (mode == 1)
+            {
+                pipe_send_zero_copy(fds[1], source, chunk);
+            }
+            else
+            {
+                for (size_t off = 0; off < chunk;)
+                {
+                    ssize_t n = write(fds[1], source + off, chunk - off);
+                    if (n <= 0) break;
+                    off += n;
+                }
+            }
+        }
+        close(fds[1]);
+
+        int status;
+        waitpid(pid, &status, 0);
+        double elapsed = ring_seconds() - start;
+        printf("%-18s %d MB in %.3f s = %.2f GB/s%s\n",
+               mode ? "vmsplice+read:" : "write+read:",
+               chunks,
+               elapsed,
+               (double) chunk * chunks / elapsed / 1e9,
+               WIFEXITED(status) && WEXITSTATUS(status) == 0 ? "" : " (reader failed)");
+    }
+
+    // The source was never modified while pages were in flight
+    free(source);
+}
+
+// ===== IPC Transport Benchmark Matrix =====
+//
+// Runs the same two workloads over every transport above:
+//   ping-pong - parent sends one message, child echoes it back; per-trip
+//               latency percentiles
+//   streaming - parent sends a burst of messages, child acknowledges the
+//               last one; throughput
+// Run with: ./main --bench
+
+typedef struct
+{
+    int fds[4];  // Descriptor transports: direction d reads fds[2d], writes fds[2d+1]
+    int msqid;
+    int semid;
+    unsigned char *shm;  // Shared segment: control block, then one buffer per direction
+    size_t shm_size;
+    size_t max_size;
+    size_t chunk;  // Largest unit the transport moves at once
+    RingHandle rings[2];
+} IpcChannel;
+
+typedef struct
+{
+    const char *name;
+    int duplex;  // Has a reply direction (ping-pong needs one)
+    int (*open)(IpcChannel *ch, size_t max_size);
+    int (*send)(IpcChannel *ch, int dir, const void *buf, size_t len);
+    int (*recv)(IpcChannel *ch, int dir, void *buf, size_t len);
+    void (*close)(IpcChannel *ch);
+} IpcTransport;
+
+// ---- Descriptor transports: pipes, FIFOs, UNIX sockets ----
+
+static int fd_send(IpcChannel *ch, int dir, const void *buf, size_t len)
+{
+    const unsigned char *p = (const unsigned char *) buf;
+    while (len > 0)
+    {
+        ssize_t n = write(ch->fds[dir * 2 + 1], p, len);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int fd_recv(IpcChannel *ch, int dir, void *buf, size_t len)
+{
+    unsigned char *p = (unsigned char *) buf;
+    while (len > 0)
+    {
+        ssize_t n = read(ch->fds[dir * 2], p, len);
+        if (n <= 0)
+        {
+            if (n < 0 && errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static void fd_close(IpcChannel *ch)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        if (ch->fds[i] >= 0) close(ch->fds[i]);
+    }
+}
+
+static int pipe_open(IpcChannel *ch, size_t max_size)
+{
+    (void) max_size;
+    if (pipe(ch->fds) == -1) return -1;
+    ch->fds[2] = ch->fds[3] = -1;
+    return 0;
+}
+
+static int pipe_pair_open(IpcChannel *ch, size_t max_size)
+{
+    (void) max_size;
+    if (pipe(ch->fds) == -1) return -1;
+    if (pipe(ch->fds + 2) == -1)
+    {
+        close(ch->fds[0]);
+        close(ch->fds[1]);
+        return -1;
+    }
+    return 0;
+}
+
+static int fifo_open(IpcChannel *ch, size_t max_size)
+{
+    (void) max_size;
+    for (int d = 0; d < 2; d++)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/ipc_bench_fifo_%d_%d", (int) getpid(), d);
+        if (mkfifo(path, 0600) == -1) return -1;
+
+        // O_RDWR does not wait for a peer (Linux), so both ends can be
+        // opened here and inherited; the name is not needed after that
+        int fd = open(path, O_RDWR);
+        unlink(path);
+        if (fd == -1) return -1;
+        ch->fds[d * 2] = fd;
+        ch->fds[d * 2 + 1] = dup(fd);
+    }
+    return 0;
+}
+
+static int unix_socket_open(IpcChannel *ch, size_t max_size)
+{
+    (void) max_size;
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) return -1;
+
+    // Parent end sv[0], child end sv[1]; dup so each slot owns its fd
+    ch->fds[0] = sv[1];
+    ch->fds[1] = sv[0];
+    ch->fds[2] = dup(sv[0]);
+    ch->fds[3] = dup(sv[1]);
+    return 0;
+}
+
+// ---- SysV message queue ----
+
+typedef struct
+{
+    long mtype;  // Direction + 1
+    char mtext[];
+} BenchMsg;
+
+static int msgq_open(IpcChannel *ch, size_t max_size)
+{
+    (void) max_size;
+    ch->msqid = msgget(IPC_PRIVATE, IPC_CREAT | 0600);
+    if (ch->msqid == -1) return -1;
+
+    // Messages above msgmax (8 KiB by default) are split
+    ch->chunk = 8192;
+    FILE *f = fopen("/proc/sys/kernel/msgmax", "r");
+    if (f)
+    {
+        unsigned long max;
+        if (fscanf(f, "%lu", &max) == 1 && max > 0) ch->chunk = max;
+        fclose(f);
+    }
+
+    ch->shm = (unsigned char *) malloc(sizeof(BenchMsg) + ch->chunk);
+    return ch->shm ? 0 : -1;
+}
+
+static int msgq_send(IpcChannel *ch, int dir, const void *buf, size_t len)
+{
+    BenchMsg *msg = (BenchMsg *) ch->shm;
+    for (size_t off = 0; off < len; off += ch->chunk)
+    {
+        size_t n = len - off < ch->chunk ? len - off : ch->chunk;
+        msg->mtype = dir + 1;
+        memcpy(msg->mtext, (const char *) buf + off, n);
+        while (msgsnd(ch->msqid, msg, n, 0) == -1)
+        {
+            if (errno != EINTR) return -1;
+        }
+    }
+    return 0;
+}
+
+static int msgq_recv(IpcChannel *ch, int dir, void *buf, size_t len)
+{
+    BenchMsg *msg = (BenchMsg *) ch->shm;
+    for (size_t off = 0; off < len;)
+    {
+        ssize_t n = msgrcv(ch->msqid, msg, ch->chunk, dir + 1, 0);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        memcpy((char *) buf + off, msg->mtext, n);
+        off += n;
+    }
+    return 0;
+}
+
+static void msgq_close(IpcChannel *ch)
+{
+    msgctl(ch->msqid, IPC_RMID, NULL);
+    free(ch->shm);
+}
+
+// ---- Shared memory with one buffer per direction ----
+//
+// Each direction has an "empty" and a "full" semaphore guarding its buffer:
+// the sender waits for empty, copies in, posts full; the receiver mirrors it.
+
+static unsigned char *shm_buffer(IpcChannel *ch, size_t header, int dir)
+{
+    return ch->shm + header + (size_t) dir * ch->max_size;
+}
+
+static int sysv_shm_open(IpcChannel *ch, size_t max_size)
+{
+    ch->max_size = max_size;
+    int shmid = shmget(IPC_PRIVATE, 2 * max_size, IPC_CREAT | 0600);
+    if (shmid == -1) return -1;
+    ch->shm = (unsigned char *) shmat(shmid, NULL, 0);
+
+    // Marked for removal now; it lives until the last detach (Linux)
+    shmctl(shmid, IPC_RMID, NULL);
+    if (ch->shm == (void *) -1) return -1;
+
+    // Semaphores: empty[0], full[0], empty[1], full[1]
+    ch->semid = semget(IPC_PRIVATE, 4, IPC_CREAT | 0600);
+    if (ch->semid == -1)
+    {
+        shmdt(ch->shm);
+        return -1;
+    }
+    unsigned short initial[4] = {1, 0, 1, 0};
+    union semun arg;
+    arg.array = initial;
+    semctl(ch->semid, 0, SETALL, arg);
+    return 0;
+}
+
+static int sysv_sem_op(int semid, int index, int delta)
+{
+    struct sembuf op = {(unsigned short) index, (short) delta, 0};
+    while (semop(semid, &op, 1) == -1)
+    {
+        if (errno != EINTR) return -1;
+    }
+    return 0;
+}
+
+static int sysv_shm_send(IpcChannel *ch, int dir, const void *buf, size_t len)
+{
+    if (sysv_sem_op(ch->semid, dir * 2, -1) < 0) return -1;
+    memcpy(shm_buffer(ch, 0, dir), buf, len);
+    return sysv_sem_op(ch->semid, dir * 2 + 1, 1);
+}
+
+static int sysv_shm_recv(IpcChannel *ch, int dir, void *buf, size_t len)
+{
+    if (sysv_sem_op(ch->semid, dir * 2 + 1, -1) < 0) return -1;
+    memcpy(buf, shm_buffer(ch, 0, dir), len);
+    return sysv_sem_op(ch->semid, dir * 2, 1);
+}
+
+static void sysv_shm_close(IpcChannel *ch)
+{
+    shmdt(ch->shm);
+    semctl(ch->semid, 0, IPC_RMID);
+}
+
+typedef struct
+{
+    sem_t empty[2];
+    sem_t full[2];
+} PosixShmControl;
+
+#define POSIX_SHM_HEADER ((sizeof(PosixShmControl) + CACHE_LINE_SIZE - 1) & ~(size_t) (CACHE_LINE_SIZE - 1))
+
+static int posix_shm_open(IpcChannel *ch, size_t max_size)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/ipc_bench_shm_%d", (int) getpid());
+
+    ch->max_size = max_size;
+    ch->shm_size = POSIX_SHM_HEADER + 2 * max_size;
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd == -1) return -1;
+    shm_unlink(name);
+    if (ftruncate(fd, ch->shm_size) == -1)
+    {
+        close(fd);
+        return -1;
+    }
+    ch->shm = (unsigned char *) mmap(NULL, ch->shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ch->shm == MAP_FAILED) return -1;
+
+    // Process-shared semaphores live inside the mapping itself
+    PosixShmControl *control = (PosixShmControl *) ch->shm;
+    for (int d = 0; d < 2; d++)
+    {
+        sem_init(&control->empty[d], 1, 1);
+        sem_init(&control->full[d], 1, 0);
+    }
+    return 0;
+}
+
+static int posix_sem_wait(sem_t *sem)
+{
+    while (sem_wait(sem) == -1)
+    {
+        if (errno != EINTR) return -1;
+    }
+    return 0;
+}
+
+static int posix_shm_send(IpcChannel *ch, int dir, const void *buf, size_t len)
+{
+    PosixShmControl *control = (PosixShmControl *) ch->shm;
+    if (posix_sem_wait(&control->empty[dir]) < 0) return -1;
+    memcpy(shm_buffer(ch, POSIX_SHM_HEADER, dir), buf, len);
+    return sem_post(&control->full[dir]);
+}
+
+static int posix_shm_recv(IpcChannel *ch, int dir, void *buf, size_t len)
+{
+    PosixShmControl *control = (PosixShmControl *) ch->shm;
+    if (posix_sem_wait(&control->full[dir]) < 0) return -1;
+    memcpy(buf, shm_buffer(ch, POSIX_SHM_HEADER, dir), len);
+    return sem_post(&control->empty[dir]);
+}
+
+static void posix_shm_close(IpcChannel *ch)
+{
+    PosixShmControl *control = (PosixShmControl *) ch->shm;
+    for (int d = 0; d < 2; d++)
+    {
+        sem_destroy(&control->empty[d]);
+        sem_destroy(&control->full[d]);
+    }
+    munmap(ch->shm, ch->shm_size);
+}
+
+// ---- Shared-memory ring, one SPSC ring per direction ----
+//
+// Ring slots are fixed-size, so a message spans size / chunk slots and is
+// published as one batch.
+
+#define BENCH_RING_CHUNK 4096
+
+static int ring_transport_open(IpcChannel *ch, size_t max_size)
+{
+    ch->chunk = max_size < BENCH_RING_CHUNK ? max_size : BENCH_RING_CHUNK;
+    for (int d = 0; d < 2; d++)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "/ipc_bench_ring_%d_%d", (int) getpid(), d);
+        if (shm_ring_create(&ch->rings[d], name, 256, (uint32_t) ch->chunk, RING_SPSC) < 0) return -1;
+
+        // The mapping is inherited across fork; the name is not needed
+        shm_unlink(name);
+    }
+    return 0;
+}
+
+static int ring_transport_send(IpcChannel *ch, int dir, const void *buf, size_t len)
+{
+    shm_ring_publish(&ch->rings[dir], buf, (uint32_t) ((len + ch->chunk - 1) / ch->chunk));
+    return 0;
+}
+
+static int ring_transport_recv(IpcChannel *ch, int dir, void *buf, size_t len)
+{
+    uint32_t want = (uint32_t) ((len + ch->chunk - 1) / ch->chunk);
+    unsigned char *p = (unsigned char *) buf;
+    while (want > 0)
+    {
+        uint32_t n = shm_ring_consume(&ch->rings[dir], p, want);
+        if (n == 0) return -1;
+        p += (size_t) n * ch->chunk;
+        want -= n;
+    }
+    return 0;
+}
+
+static void ring_transport_close(IpcChannel *ch)
+{
+    shm_ring_close(&ch->rings[0]);
+    shm_ring_close(&ch->rings[1]);
+}
+
+static const IpcTransport ipc_transports[] = {
+    {"pipe", 0, pipe_open, fd_send, fd_recv, fd_close},
+    {"pipe pair", 1, pipe_pair_open, fd_send, fd_recv, fd_close},
+    {"FIFO", 1, fifo_open, fd_send, fd_recv, fd_close},
+    {"SysV msgq", 1, msgq_open, msgq_send, msgq_recv, msgq_close},
+    {"SysV shm+sem", 1, sysv_shm_open, sysv_shm_send, sysv_shm_recv, sysv_shm_close},
+    {"POSIX shm+sem", 1, posix_shm_open, posix_shm_send, posix_shm_recv, posix_shm_close},
+    {"UNIX socket", 1, unix_socket_open, fd_send, fd_recv, fd_close},
+    {"shm ring", 1, ring_transport_open, ring_transport_send, ring_transport_recv, ring_transport_close},
+};
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+typedef struct
+{
+    int ok;
+    double p50_us, p99_us, p999_us;
+    double stream_mb_s, stream_msg_s;
+} IpcBenchResult;
+
+#define BENCH_WARMUP 100
+
+// Iteration counts shrink with message size so every cell takes similar time
+static int bench_pingpong_count(size_t size)
+{
+    return size <= 4096 ? 20000 : size <= 65536 ? 4000 : 400;
+}
+
+static int bench_stream_count(size_t size)
+{
+    size_t count = (256u << 20) / size;
+    return count > 200000 ? 200000 : (int) count;
+}
+
+// Child side: echo the ping-pong phase, then drain the stream and ack
+static void ipc_bench_child(const IpcTransport *t, IpcChannel *ch, size_t size, unsigned char *buf)
+{
+    if (t->duplex)
+    {
+        for (int i = 0; i < BENCH_WARMUP + bench_pingpong_count(size); i++)
+        {
+            if (t->recv(ch, 0, buf, size) < 0 || t->send(ch, 1, buf, size) < 0) exit(1);
+        }
+    }
+
+    int count = bench_stream_count(size);
+    for (int i = 0; i < count; i++)
+    {
+        if (t->recv(ch, 0, buf, size) < 0) exit(1);
+    }
+    if (t->duplex && t->send(ch, 1, buf, size) < 0) exit(1);
+    exit(0);
+}
+
+static IpcBenchResult ipc_bench_run(const IpcTransport *t, size_t size)
+{
+    IpcBenchResult result;
+    memset(&result, 0, sizeof(result));
+
+    IpcChannel ch;
+    memset(&ch, 0, sizeof(ch));
+    for (int i = 0; i < 4; i++) ch.fds[i] = -1;
+
+    unsigned char *buf = (unsigned char *) malloc(size);
+    int iterations = bench_pingpong_count(size);
+    uint64_t *samples = (uint64_t *) malloc(iterations * sizeof(uint64_t));
+    if (!buf || !samples || t->open(&ch, size) < 0)
+    {
+        free(buf);
+        free(samples);
+        return result;
+    }
+    memset(buf, 0x3c, size);
+
+    // Don't let the child inherit (and later flush) buffered output
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        t->close(&ch);
+        free(buf);
+        free(samples);
+        return result;
+    }
+    if (pid == 0)
+    {
+        ipc_bench_child(t, &ch, size, buf);
+    }
+
+    int failed = 0;
+    if (t->duplex)
+    {
+        for (int i = 0; i < BENCH_WARMUP + iterations && !failed; i++)
+        {
+            uint64_t start = bench_now_ns();
+            failed = t->send(&ch, 0, buf, size) < 0 || t->recv(&ch, 1, buf, size) < 0;
+            if (i >= BENCH_WARMUP) samples[i - BENCH_WARMUP] = bench_now_ns() - start;
+        }
+    }
+
+    int count = bench_stream_count(size);
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < count && !failed; i++)
+    {
+        failed = t->send(&ch, 0, buf, size) < 0;
+    }
+
+    // One-way transports learn of completion from the child's exit
+    if (!failed && t->duplex) failed = t->recv(&ch, 1, buf, size) < 0;
+    int status;
+    waitpid(pid, &status, 0);
+    double elapsed = (bench_now_ns() - start) / 1e9;
+
+    if (!failed && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+    {
+        result.ok = 1;
+        result.stream_msg_s = count / elapsed;
+        result.stream_mb_s = (double) count * size / elapsed / 1e6;
+        if (t->duplex)
+        {
+            qsort(samples, iterations, sizeof(uint64_t), compare_u64);
+            result.p50_us = samples[iterations / 2] / 1e3;
+            result.p99_us = samples[(int) (iterations * 0.99)] / 1e3;
+            result.p999_us = samples[(int) (iterations * 0.999)] / 1e3;
+        }
+    }
+
+    t->close(&ch);
+    free(buf);
+    free(samples);
+    return result;
+}
+
+// Function to compare every transport over a range of message sizes
+void ipc_benchmark_matrix()
+{
+    printf("\n=== IPC Transport Benchmark Matrix ===\n");
+    printf("Ping-pong: round-trip time; streaming: one-way burst, one ack\n\n");
+    printf("%-14s %8s %10s %10s %10s %12s %12s\n",
+           "transport",
+           "size",
+           "p50 us",
+           "p99 us",
+           "p99.9 us",
+           "stream MB/s",
+           "stream msg/s");
+
+    const size_t sizes[] = {64, 4096, 65536, 1 << 20};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        for (size_t i = 0; i < sizeof(ipc_transports) / sizeof(ipc_transports[0]); i++)
+        {
+            const IpcTransport *t = &ipc_transports[i];
+            IpcBenchResult r = ipc_bench_run(t, sizes[s]);
+            if (!r.ok)
+            {
+                printf("%-14s %8zu   failed\n", t->name, sizes[s]);
+            }
+            else if (!t->duplex)
+            {
+                printf("%-14s %8zu %10s %10s %10s %12.1f %12.0f\n",
+                       t->name,
+                       sizes[s],
+                       "-",
+                       "-",
+                       "-",
+                       r.stream_mb_s,
+                       r.stream_msg_s);
+            }
+            else
+            {
+                printf("%-14s %8zu %10.2f %10.2f %10.2f %12.1f %12.0f\n",
+                       t->name,
+                       sizes[s],
+                       r.p50_us,
+                       r.p99_us,
+                       r.p999_us,
+                       r.stream_mb_s,
+                       r.stream_msg_s);
+            }
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    printf("=== Interprocess Communication (IPC) Demonstration ===\n");
+
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+    {
+        ipc_benchmark_matrix();
+        return 0;
+    }
 
     // Register signal handler
     signal(SIGINT, handle_signal);
@@ -764,6 +2387,9 @@ int main(int argc, char *argv[])
     shared_memory_demo();
     semaphore_demo();
     posix_shm_demo();
+    shm_ring_demo();
+    memfd_ipc_demo();
+    splice_pipe_demo();
 
     return 0;
 }
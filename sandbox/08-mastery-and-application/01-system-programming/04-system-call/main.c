@@ -4,12 +4,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "../fast_clock.h"
+#include "../syscall_batch.h"
+
 // Function to demonstrate file-related system calls
 void demonstrate_file_syscalls(const char *filename)
 {
@@ -71,26 +76,31 @@ void demonstrate_file_syscalls(const char *filename)
     buffer[bytes_read] = '\0';  // Null-terminate the string
     printf("Read %zd bytes: %s", bytes_read, buffer);
 
-    // lseek() system call - repositions read/write offset
-    printf("\nUsing lseek() to move to the beginning of the file...\n");
-    offset = lseek(fd, 0, SEEK_SET);
-    if (offset == -1)
-    {
-        perror("lseek failed");
-        close(fd);
-        return;
-    }
-
-    // Read from the new position
-    bytes_read = read(fd, buffer, 5);  // Read just 5 bytes
+    // preadv() - read at an explicit offset, scattering into several
+    // buffers. Replaces an lseek() + read() pair with one system call and
+    // leaves the file offset where it was.
+    printf("\nUsing preadv() to read from the beginning of the file...\n");
+    char word[6], rest[16];
+    struct iovec pieces[2] = {
+        {word, 5},
+        {rest, sizeof(rest) - 1},
+    };
+    bytes_read = preadv(fd, pieces, 2, 0);
     if (bytes_read == -1)
     {
-        perror("read failed");
+        perror("preadv failed");
         close(fd);
         return;
     }
-    buffer[bytes_read] = '\0';
-    printf("Read %zd bytes after seeking: %s\n", bytes_read, buffer);
+    size_t in_word = bytes_read < 5 ? (size_t) bytes_read : 5;
+    word[in_word] = '\0';
+    rest[(size_t) bytes_read - in_word] = '\0';
+    printf("Read %zd bytes at offset 0 into two buffers: \"%s\" + \"%s\"\n",
+           bytes_read,
+           word,
+           rest);
+    offset = lseek(fd, 0, SEEK_CUR);  // Unchanged by preadv
+    printf("File offset is still %lld\n", (long long) offset);
 
     // stat() system call - gets file status
     printf("\nGetting file information with stat()...\n");
@@ -213,11 +223,372 @@ void demonstrate_time_syscalls()
     printf("  Microseconds: %ld\n", (long) tv.tv_usec);
 }
 
-// Error handling with resource cleanup example
+// One clock source for the benchmark: returns a timestamp in any unit
+typedef uint64_t (*ClockSource)(void);
+
+static uint64_t source_time(void)
+{
+    return (uint64_t) time(NULL);
+}
+
+static uint64_t source_gettimeofday(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t) tv.tv_sec * 1000000u + (uint64_t) tv.tv_usec;
+}
+
+static uint64_t source_realtime(void)
+{
+    return fast_clock_read(CLOCK_REALTIME);
+}
+
+#ifdef SYS_clock_gettime
+// The same call made as a real system call, bypassing the vDSO
+static uint64_t source_syscall(void)
+{
+    struct timespec ts;
+    syscall(SYS_clock_gettime, CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+#endif
+
+// Time `calls` reads of a clock; the results are folded into a sink so
+// the calls cannot be optimised away
+static volatile uint64_t clock_sink;
+
+static double clock_ns_per_call(ClockSource source, int calls)
+{
+    uint64_t acc = 0;
+    uint64_t start = fast_clock_monotonic_ns();
+    for (int i = 0; i < calls; i++) acc += source();
+    uint64_t elapsed = fast_clock_monotonic_ns() - start;
+    clock_sink = acc;
+    return (double) elapsed / calls;
+}
+
+// Cost per call of each way of getting the time. Every call to the
+// vDSO-backed functions stays in user space; the raw syscall shows what
+// they cost when the kernel has to be entered.
+void demonstrate_clock_sources()
+{
+    printf("\n=== Clock Sources: Cost per Call ===\n");
+
+    char source[64];
+    if (fast_clock_source(source, sizeof(source)))
+    {
+        printf("Kernel clocksource: %s\n", source);
+    }
+    printf("Resolution: CLOCK_MONOTONIC %llu ns, "
+           "CLOCK_MONOTONIC_COARSE %llu ns\n",
+           (unsigned long long) fast_clock_resolution_ns(CLOCK_MONOTONIC),
+           (unsigned long long) fast_clock_resolution_ns(FAST_CLOCK_COARSE));
+
+    bool tsc = fast_clock_calibrate();
+    printf("TSC clock: %s\n",
+           tsc ? "calibrated against CLOCK_MONOTONIC"
+               : "no invariant counter, falls back to CLOCK_MONOTONIC");
+
+    const int calls = 1000000;
+    struct
+    {
+        const char *name;
+        ClockSource source;
+        int calls;
+    } sources[] = {
+        {"time()", source_time, calls},
+        {"gettimeofday()", source_gettimeofday, calls},
+        {"clock_gettime(REALTIME)", source_realtime, calls},
+        {"clock_gettime(MONOTONIC)", fast_clock_monotonic_ns, calls},
+        {"clock_gettime(MONOTONIC_COARSE)", fast_clock_coarse_ns, calls},
+#ifdef SYS_clock_gettime
+        {"syscall(SYS_clock_gettime)", source_syscall, calls / 10},
+#endif
+        {"fast_clock_tsc_ns()", fast_clock_tsc_ns, calls},
+        {"fast_clock_now() (cached)", fast_clock_now, calls},
+    };
+
+    fast_clock_tick();
+    for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++)
+    {
+        printf("  %-34s %7.1f ns/call\n",
+               sources[i].name,
+               clock_ns_per_call(sources[i].source, sources[i].calls));
+    }
+
+    // How far the cheap clocks are from the reference
+    uint64_t reference = fast_clock_monotonic_ns();
+    long long tsc_offset = (long long) (fast_clock_tsc_ns() - reference);
+    long long coarse_offset = (long long) (fast_clock_coarse_ns() - reference);
+    printf("Offset from CLOCK_MONOTONIC: TSC clock %lld ns, coarse %lld ns\n",
+           tsc_offset,
+           coarse_offset);
+}
+
+// One system call (or short sequence) for the benchmark, on bench_fd
+typedef long (*SyscallOp)(void);
+
+static int bench_fd = -1;
+static char bench_buffer[64];
+
+static long op_getpid(void)
+{
+    return getpid();
+}
+
+static long op_syscall_getpid(void)
+{
+    return syscall(SYS_getpid);
+}
+
+static long op_raw_getpid(void)
+{
+    return syscall_raw3(SYS_getpid, 0, 0, 0);
+}
+
+static long op_fstat(void)
+{
+    struct stat st;
+    return fstat(bench_fd, &st) == 0 ? (long) st.st_size : -1;
+}
+
+static long op_raw_fstat(void)
+{
+    struct stat st;
+    return syscall_raw3(SYS_fstat, bench_fd, (long) &st, 0);
+}
+
+static long op_lseek_read(void)
+{
+    if (lseek(bench_fd, 0, SEEK_SET) == -1) return -1;
+    return read(bench_fd, bench_buffer, sizeof(bench_buffer));
+}
+
+static long op_preadv(void)
+{
+    struct iovec iov[2] = {
+        {bench_buffer, 16},
+        {bench_buffer + 16, sizeof(bench_buffer) - 16},
+    };
+    return preadv(bench_fd, iov, 2, 0);
+}
+
+static long op_lseek_write(void)
+{
+    if (lseek(bench_fd, 0, SEEK_SET) == -1) return -1;
+    return write(bench_fd, "Hello", 5);
+}
+
+static long op_pwritev(void)
+{
+    struct iovec iov[2] = {{"Hel", 3}, {"lo", 2}};
+    return pwritev(bench_fd, iov, 2, 0);
+}
+
+static double syscall_ns_per_call(SyscallOp op, int calls)
+{
+    uint64_t acc = 0;
+    uint64_t start = fast_clock_monotonic_ns();
+    for (int i = 0; i < calls; i++) acc += (uint64_t) op();
+    uint64_t elapsed = fast_clock_monotonic_ns() - start;
+    clock_sink = acc;
+    return (double) elapsed / calls;
+}
+
+#define CHAIN_FILES     256
+#define CHAIN_FILE_SIZE 64
+
+// open -> read -> close over many small files: three system calls per
+// file, against linked io_uring chains that cost one io_uring_enter per
+// batch of files
+static void compare_open_read_close(void)
+{
+    char dir[] = "/tmp/syscall_chainsXXXXXX";
+    if (mkdtemp(dir) == NULL)
+    {
+        perror("mkdtemp failed");
+        return;
+    }
+
+    static char paths[CHAIN_FILES][64];
+    static const char *path_list[CHAIN_FILES];
+    static char buffers[CHAIN_FILES * CHAIN_FILE_SIZE];
+    static long results[CHAIN_FILES];
+    size_t created = 0;
+    for (; created < CHAIN_FILES; created++)
+    {
+        snprintf(paths[created], sizeof(paths[created]), "%s/f%03zu", dir, created);
+        path_list[created] = paths[created];
+        int fd = open(paths[created], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1) break;
+        ssize_t written = write(fd, paths[created], strlen(paths[created]));
+        close(fd);
+        if (written == -1) break;
+    }
+
+    const int rounds = 20;
+    long total = 0;
+    uint64_t start = fast_clock_monotonic_ns();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (size_t i = 0; i < created; i++)
+        {
+            int fd = open(path_list[i], O_RDONLY);
+            if (fd == -1) continue;
+            total += read(fd, buffers + i * CHAIN_FILE_SIZE, CHAIN_FILE_SIZE);
+            close(fd);
+        }
+    }
+    double sequential = (double) (fast_clock_monotonic_ns() - start)
+                        / ((double) rounds * created);
+    printf("  %-34s %7.1f ns/file (%ld bytes)\n",
+           "open + read + close",
+           sequential,
+           total / rounds);
+
+#ifdef __linux__
+    SyscallRing ring;
+    int ret = syscall_ring_init(&ring);
+    if (ret < 0)
+    {
+        printf("  io_uring unavailable: %s\n", strerror(-ret));
+    }
+    else
+    {
+        total = 0;
+        start = fast_clock_monotonic_ns();
+        for (int r = 0; r < rounds && ret == 0; r++)
+        {
+            ret = syscall_ring_read_files(
+                &ring, path_list, created, buffers, CHAIN_FILE_SIZE, results);
+            for (size_t i = 0; i < created; i++)
+            {
+                if (results[i] > 0) total += results[i];
+            }
+        }
+        double chained = (double) (fast_clock_monotonic_ns() - start)
+                         / ((double) rounds * created);
+        if (ret < 0)
+        {
+            printf("  io_uring_enter failed: %s\n", strerror(-ret));
+        }
+        else if (created > 0 && results[0] < 0)
+        {
+            // Direct descriptors need Linux 5.15
+            printf("  io_uring chains failed: %s\n", strerror((int) -results[0]));
+        }
+        else
+        {
+            printf("  %-34s %7.1f ns/file (%ld bytes, %u files per enter)\n",
+                   "io_uring linked chains",
+                   chained,
+                   total / rounds,
+                   ring.slots);
+        }
+        syscall_ring_destroy(&ring);
+    }
+#endif
+
+    for (size_t i = 0; i < created; i++) unlink(paths[i]);
+    rmdir(dir);
+}
+
+// What one trip into the kernel costs, and what it saves to make fewer
+// of them. getpid() does almost no work in the kernel, so its time is
+// nearly all entry and exit.
+void demonstrate_syscall_costs(const char *filename)
+{
+    printf("\n=== System Call Cost and Batching ===\n");
+
+    bench_fd = open(filename, O_RDWR);
+    if (bench_fd == -1)
+    {
+        perror("open failed");
+        return;
+    }
+
+    const int calls = 200000;
+    struct
+    {
+        const char *name;
+        SyscallOp op;
+    } ops[] = {
+        {"getpid() (libc)", op_getpid},
+        {"syscall(SYS_getpid)", op_syscall_getpid},
+        {"syscall_raw3(SYS_getpid)", op_raw_getpid},
+        {"fstat() (libc)", op_fstat},
+        {"syscall_raw3(SYS_fstat)", op_raw_fstat},
+        {"lseek + read", op_lseek_read},
+        {"preadv (2 buffers)", op_preadv},
+        {"lseek + write", op_lseek_write},
+        {"pwritev (2 buffers)", op_pwritev},
+    };
+
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+    {
+        printf("  %-34s %7.1f ns/call\n",
+               ops[i].name,
+               syscall_ns_per_call(ops[i].op, calls));
+    }
+    close(bench_fd);
+    bench_fd = -1;
+
+    compare_open_read_close();
+}
+
+// Probing for files that mostly do not exist (search paths, config
+// lookups): formatting a message at every failure costs more than the
+// failed open itself. Capturing the errno value is a few stores, and only
+// the failure that matters gets formatted.
+static void compare_error_capture(void)
+{
+    const int probes = 100000;
+    char message[128];
+    size_t formatted = 0;
+
+    uint64_t start = fast_clock_monotonic_ns();
+    for (int i = 0; i < probes; i++)
+    {
+        int fd = open("/nonexistent/probe.conf", O_RDONLY);
+        if (fd == -1)
+        {
+            formatted += (size_t) snprintf(message, sizeof(message),
+                                           "open failed: %s", strerror(errno));
+        }
+        else
+        {
+            close(fd);
+        }
+    }
+    double per_format = (double) (fast_clock_monotonic_ns() - start) / probes;
+
+    SyscallError err = SYSCALL_ERROR_INIT;
+    start = fast_clock_monotonic_ns();
+    for (int i = 0; i < probes; i++)
+    {
+        long fd = SYSCALL_CAPTURE_RAW(
+            &err,
+            syscall_raw3(SYS_openat, AT_FDCWD, (long) "/nonexistent/probe.conf",
+                         O_RDONLY));
+        if (fd >= 0) close((int) fd);
+    }
+    double per_capture = (double) (fast_clock_monotonic_ns() - start) / probes;
+
+    printf("Failed open, message formatted each time: %6.1f ns (%zu chars)\n",
+           per_format,
+           formatted);
+    printf("Failed open, errno captured:              %6.1f ns\n", per_capture);
+    printf("First captured failure: ");
+    if (!syscall_error_report(&err, stdout)) printf("none\n");
+}
+
+// Error handling with resource cleanup example. Failures are captured as
+// plain data where they happen and reported once, during cleanup.
 void demonstrate_error_handling()
 {
     printf("\n=== Error Handling for System Calls ===\n");
 
+    SyscallError err = SYSCALL_ERROR_INIT;
     int fd = -1;
     char *buffer = NULL;
 
@@ -230,29 +601,25 @@ void demonstrate_error_handling()
     }
 
     // Try to open a file in a restricted location (should fail)
-    fd = open("/root/restricted_file.txt", O_RDONLY);
+    fd = SYSCALL_CAPTURE(&err, open("/root/restricted_file.txt", O_RDONLY));
     if (fd == -1)
     {
-        // Check specific error codes
-        if (errno == EACCES)
+        // Check specific error codes; errno itself may have been
+        // overwritten by now, the captured value has not
+        if (err.error == EACCES)
         {
             printf("Permission denied: cannot open restricted file\n");
         }
-        else if (errno == ENOENT)
+        else if (err.error == ENOENT)
         {
             printf("File does not exist\n");
         }
-        else
-        {
-            printf("Error opening file: %s (errno = %d)\n",
-                   strerror(errno),
-                   errno);
-        }
         goto cleanup;
     }
 
 cleanup:
     printf("\nCleaning up resources...\n");
+    syscall_error_report(&err, stdout);
 
     if (fd != -1)
     {
@@ -267,9 +634,10 @@ cleanup:
     }
 
     printf("Cleanup complete\n");
-}
 
-// Main function
+    printf("\n");
+    compare_error_capture();
+}
 int main()
 {
     printf("===== System Call Demonstration Program =====\n");
@@ -278,6 +646,8 @@ int main()
     demonstrate_file_syscalls("syscall_test.txt");
     demonstrate_process_syscalls();
     demonstrate_time_syscalls();
+    demonstrate_clock_sources();
+    demonstrate_syscall_costs("syscall_test.txt");
     demonstrate_error_handling();
 
     printf("\nAll demonstrations completed!\n");
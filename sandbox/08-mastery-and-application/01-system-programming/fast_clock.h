@@ -0,0 +1,184 @@
+// Cheap timestamps: coarse, TSC-based and cached clocks.
+//
+// clock_gettime() does not enter the kernel for the common clocks: glibc
+// calls into the vDSO, a page of kernel code mapped into every process
+// that reads the clocksource directly. That still costs a few dozen
+// nanoseconds (a fenced counter read, a seqlock retry loop and a
+// conversion), and if the kernel's clocksource cannot be read from user
+// space (hpet, acpi_pm, some VMs) every call becomes a real system call.
+// For timestamping every request there are cheaper options, each giving
+// something up:
+//
+//   fast_clock_monotonic_ns  CLOCK_MONOTONIC via the vDSO; the reference
+//   fast_clock_coarse_ns     CLOCK_MONOTONIC_COARSE: the time of the last
+//                            timer tick, so 1-4 ms resolution, but only a
+//                            couple of loads
+//   fast_clock_tsc_ns        the CPU's own counter (rdtsc, cntvct_el0)
+//                            scaled to ns with a multiply and shift
+//                            calibrated against CLOCK_MONOTONIC; needs an
+//                            invariant TSC, and drifts from NTP-adjusted
+//                            time until recalibrated
+//   fast_clock_now           a per-thread value refreshed by
+//                            fast_clock_tick(), e.g. once per event-loop
+//                            iteration; free to read, as precise as the
+//                            loop is fast
+//
+// Call fast_clock_calibrate() once before using the TSC clock; where no
+// usable counter exists it returns false and fast_clock_tsc_ns falls back
+// to CLOCK_MONOTONIC.
+#ifndef FAST_CLOCK_H
+#define FAST_CLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#ifdef CLOCK_MONOTONIC_COARSE
+#define FAST_CLOCK_COARSE CLOCK_MONOTONIC_COARSE
+#else
+#define FAST_CLOCK_COARSE CLOCK_MONOTONIC
+#endif
+
+#define FAST_CLOCK_CALIBRATE_NS 20000000  // 20 ms of wall time
+
+static inline uint64_t fast_clock_read(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static inline uint64_t fast_clock_monotonic_ns(void)
+{
+    return fast_clock_read(CLOCK_MONOTONIC);
+}
+
+static inline uint64_t fast_clock_coarse_ns(void)
+{
+    return fast_clock_read(FAST_CLOCK_COARSE);
+}
+
+/* ---- TSC clock ---- */
+
+// ns = base_ns + ((ticks - base_ticks) * mult) >> 32
+static struct
+{
+    bool usable;
+    uint64_t base_ticks;
+    uint64_t base_ns;
+    uint64_t mult;
+} fast_clock_tsc;
+
+static inline uint64_t fast_clock_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t low, high;
+    __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t) high << 32) | low;
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return 0;
+#endif
+}
+
+// The counter must tick at a constant rate whatever the core's frequency
+// and sleep state; the AArch64 generic timer always does
+static inline bool fast_clock_counter_invariant(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned eax, ebx, ecx, edx;
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0) return false;
+    return (edx >> 8) & 1;  // Invariant TSC
+#elif defined(__aarch64__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Measure ticks per nanosecond over FAST_CLOCK_CALIBRATE_NS and anchor
+// the TSC clock at the current CLOCK_MONOTONIC time
+static inline bool fast_clock_calibrate(void)
+{
+    fast_clock_tsc.usable = false;
+    if (!fast_clock_counter_invariant()) return false;
+
+    uint64_t start_ns = fast_clock_monotonic_ns();
+    uint64_t start_ticks = fast_clock_ticks();
+    uint64_t end_ns;
+    do
+    {
+        end_ns = fast_clock_monotonic_ns();
+    } while (end_ns - start_ns < FAST_CLOCK_CALIBRATE_NS);
+    uint64_t end_ticks = fast_clock_ticks();
+
+    uint64_t ticks = end_ticks - start_ticks;
+    if (ticks == 0) return false;
+    fast_clock_tsc.mult =
+        (uint64_t) ((((unsigned __int128) (end_ns - start_ns)) << 32) / ticks);
+    fast_clock_tsc.base_ticks = end_ticks;
+    fast_clock_tsc.base_ns = end_ns;
+    fast_clock_tsc.usable = true;
+    return true;
+}
+
+static inline uint64_t fast_clock_tsc_ns(void)
+{
+    if (!fast_clock_tsc.usable) return fast_clock_monotonic_ns();
+    uint64_t delta = fast_clock_ticks() - fast_clock_tsc.base_ticks;
+    return fast_clock_tsc.base_ns
+           + (uint64_t) (((unsigned __int128) delta * fast_clock_tsc.mult)
+                         >> 32);
+}
+
+/* ---- Cached per-thread time ---- */
+
+static __thread uint64_t fast_clock_cached_ns;
+
+// Refresh the calling thread's cached time; call at the top of each
+// event-loop iteration, so every request handled in that iteration gets
+// the same timestamp for the price of one clock read
+static inline uint64_t fast_clock_tick(void)
+{
+    fast_clock_cached_ns = fast_clock_tsc_ns();
+    return fast_clock_cached_ns;
+}
+
+static inline uint64_t fast_clock_now(void)
+{
+    return fast_clock_cached_ns;
+}
+
+/* ---- Diagnostics ---- */
+
+// The kernel clocksource, e.g. "tsc" or "kvm-clock". The vDSO can only
+// serve clock_gettime for clocksources it can read from user space; with
+// "hpet" or "acpi_pm" every call is a full system call.
+static inline bool fast_clock_source(char *name, size_t size)
+{
+    FILE *f = fopen(
+        "/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+    if (f == NULL) return false;
+    bool ok = fgets(name, (int) size, f) != NULL;
+    fclose(f);
+    if (ok) name[strcspn(name, "\n")] = '\0';
+    return ok;
+}
+
+static inline uint64_t fast_clock_resolution_ns(clockid_t clock)
+{
+    struct timespec res;
+    if (clock_getres(clock, &res) != 0) return 0;
+    return (uint64_t) res.tv_sec * 1000000000u + (uint64_t) res.tv_nsec;
+}
+
+#endif  // FAST_CLOCK_H
@@ -0,0 +1,360 @@
+// File copies that keep the data in the kernel.
+//
+// A read()/write() loop moves every byte twice across the user/kernel
+// boundary: page cache into the user buffer, user buffer back into the
+// page cache of the destination. For large files that doubles the memory
+// traffic and the cache pollution. file_copy() tries, in order:
+//
+//   FILE_COPY_CLONE     ioctl(FICLONE): share the source's extents (btrfs,
+//                       XFS with reflink, bcachefs); no data is copied at
+//                       all until one side is modified
+//   FILE_COPY_RANGE     copy_file_range(): the kernel copies between page
+//                       caches, and some filesystems (NFS 4.2, SMB) copy
+//                       server-side
+//   FILE_COPY_SENDFILE  sendfile(): in-kernel copy from a file to any fd
+//   FILE_COPY_SPLICE    splice() through a pipe: moves page references
+//                       where it can
+//   FILE_COPY_BUFFERED  pread/pwrite through a large page-aligned buffer,
+//                       with posix_fadvise telling the kernel to read ahead
+//                       and to drop source pages once copied
+//
+// and falls through to the next when one is not supported for this pair
+// of files (other filesystem, old kernel, EXDEV across mounts). Each
+// method continues at the offset the previous one reached, so a copy can
+// even switch methods part way. A progress callback sees every chunk.
+//
+// Needs _GNU_SOURCE defined before the first #include, for
+// copy_file_range and splice.
+#ifndef FILE_COPY_H
+#define FILE_COPY_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/fs.h>  // FICLONE
+#endif
+
+#define FILE_COPY_CHUNK   (8u << 20)  // Bytes per call, and per progress report
+#define FILE_COPY_BUFFER  (1u << 20)  // Buffered fallback: 1 MiB ...
+#define FILE_COPY_ALIGN   4096        // ... on a page boundary
+
+typedef enum
+{
+    FILE_COPY_CLONE,
+    FILE_COPY_RANGE,
+    FILE_COPY_SENDFILE,
+    FILE_COPY_SPLICE,
+    FILE_COPY_BUFFERED,
+    FILE_COPY_METHODS
+} FileCopyMethod;
+
+typedef struct
+{
+    FileCopyMethod method;  // Method that copied the latest chunk
+    uint64_t copied;        // Bytes done so far
+    uint64_t total;         // Source size
+} FileCopyStatus;
+
+// Called after each chunk and once at the end
+typedef void (*FileCopyProgress)(const FileCopyStatus *status, void *arg);
+
+typedef struct
+{
+    FileCopyMethod first;  // Start the fallback chain here
+    FileCopyProgress progress;
+    void *arg;
+} FileCopyOptions;
+
+static inline const char *file_copy_method_name(FileCopyMethod method)
+{
+    static const char *const names[FILE_COPY_METHODS] = {
+        "reflink", "copy_file_range", "sendfile", "splice", "buffered"};
+    return method < FILE_COPY_METHODS ? names[method] : "?";
+}
+
+// Errors that mean "this method cannot copy between these files", as
+// opposed to a real I/O error
+static inline bool file_copy_unsupported(int error)
+{
+    return error == ENOSYS || error == EOPNOTSUPP || error == ENOTTY
+           || error == EXDEV || error == EINVAL || error == EBADF
+           || error == ENOTSUP;
+}
+
+static inline void file_copy_report(const FileCopyOptions *options,
+                                    FileCopyStatus *status)
+{
+    if (options && options->progress) options->progress(status, options->arg);
+}
+
+/* ---- Methods ---- */
+
+// Each copies from status->copied up to status->total and returns 0, or
+// -errno. A method that fails before copying anything leaves the offsets
+// untouched for the next one.
+
+static inline int file_copy_clone(int in, int out, FileCopyStatus *status)
+{
+#ifdef FICLONE
+    if (status->copied != 0) return -EINVAL;  // All or nothing
+    if (ioctl(out, FICLONE, in) == -1) return -errno;
+    status->copied = status->total;
+    return 0;
+#else
+    (void) in;
+    (void) out;
+    (void) status;
+    return -EOPNOTSUPP;
+#endif
+}
+
+static inline int file_copy_range(int in,
+                                  int out,
+                                  FileCopyStatus *status,
+                                  const FileCopyOptions *options)
+{
+    while (status->copied < status->total)
+    {
+        uint64_t left = status->total - status->copied;
+        loff_t off_in = (loff_t) status->copied, off_out = off_in;
+        ssize_t n = copy_file_range(in, &off_in, out, &off_out,
+                                    left < FILE_COPY_CHUNK ? left : FILE_COPY_CHUNK,
+                                    0);
+        if (n == -1)
+        {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        if (n == 0) break;  // Source shrank
+        status->copied += (uint64_t) n;
+        file_copy_report(options, status);
+    }
+    return 0;
+}
+
+static inline int file_copy_sendfile(int in,
+                                     int out,
+                                     FileCopyStatus *status,
+                                     const FileCopyOptions *options)
+{
+    // sendfile writes at the output's file position
+    if (lseek(out, (off_t) status->copied, SEEK_SET) == -1) return -errno;
+    while (status->copied < status->total)
+    {
+        uint64_t left = status->total - status->copied;
+        off_t offset = (off_t) status->copied;
+        ssize_t n = sendfile(
+            out, in, &offset, left < FILE_COPY_CHUNK ? left : FILE_COPY_CHUNK);
+        if (n == -1)
+        {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        if (n == 0) break;
+        status->copied += (uint64_t) n;
+        file_copy_report(options, status);
+    }
+    return 0;
+}
+
+static inline int file_copy_splice(int in,
+                                   int out,
+                                   FileCopyStatus *status,
+                                   const FileCopyOptions *options)
+{
+    int pipe_fds[2];
+    if (pipe(pipe_fds) == -1) return -errno;
+    // A bigger pipe moves more per call; the default is 64 KiB
+    fcntl(pipe_fds[1], F_SETPIPE_SZ, FILE_COPY_BUFFER);
+
+    int error = 0;
+    while (status->copied < status->total && error == 0)
+    {
+        uint64_t left = status->total - status->copied;
+        loff_t off_in = (loff_t) status->copied;
+        ssize_t filled = splice(in, &off_in, pipe_fds[1], NULL,
+                                left < FILE_COPY_BUFFER ? left : FILE_COPY_BUFFER,
+                                SPLICE_F_MOVE);
+        if (filled == -1)
+        {
+            if (errno != EINTR) error = -errno;
+            continue;
+        }
+        if (filled == 0) break;
+
+        // Drain the pipe completely before the next fill
+        loff_t off_out = (loff_t) status->copied;
+        while (filled > 0)
+        {
+            ssize_t n = splice(pipe_fds[0], NULL, out, &off_out, (size_t) filled,
+                               SPLICE_F_MOVE);
+            if (n == -1)
+            {
+                if (errno == EINTR) continue;
+                error = -errno;
+                break;
+            }
+            filled -= n;
+            status->copied += (uint64_t) n;
+        }
+        file_copy_report(options, status);
+    }
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    return error;
+}
+
+static inline int file_copy_buffered(int in,
+                                     int out,
+                                     FileCopyStatus *status,
+                                     const FileCopyOptions *options)
+{
+    void *buffer;
+    if (posix_memalign(&buffer, FILE_COPY_ALIGN, FILE_COPY_BUFFER) != 0)
+    {
+        return -ENOMEM;
+    }
+    // Read ahead aggressively; the source is read exactly once
+    posix_fadvise(in, (off_t) status->copied, 0, POSIX_FADV_SEQUENTIAL);
+
+    int error = 0;
+    uint64_t reported = status->copied;
+    while (status->copied < status->total && error == 0)
+    {
+        ssize_t got = pread(in, buffer, FILE_COPY_BUFFER, (off_t) status->copied);
+        if (got == -1)
+        {
+            if (errno != EINTR) error = -errno;
+            continue;
+        }
+        if (got == 0) break;
+
+        for (ssize_t done = 0; done < got;)
+        {
+            ssize_t n = pwrite(out, (char *) buffer + done, (size_t) (got - done),
+                               (off_t) (status->copied + (uint64_t) done));
+            if (n == -1)
+            {
+                if (errno == EINTR) continue;
+                error = -errno;
+                break;
+            }
+            done += n;
+        }
+        if (error != 0) break;
+        status->copied += (uint64_t) got;
+
+        if (status->copied - reported >= FILE_COPY_CHUNK
+            || status->copied == status->total)
+        {
+            // Copied source pages will not be read again: let them go
+            // rather than pushing everything else out of the page cache
+            posix_fadvise(in, (off_t) reported,
+                          (off_t) (status->copied - reported),
+                          POSIX_FADV_DONTNEED);
+            reported = status->copied;
+            file_copy_report(options, status);
+        }
+    }
+    free(buffer);
+    return error;
+}
+
+/* ---- Entry points ---- */
+
+// Copy all of `in` to `out` (regular files; out is truncated first).
+// Returns 0 on success, -EINVAL if in and out are the same file, else
+// -errno of the first method that failed for a reason other than lack of
+// support. *status (optional) says which method finished the copy and
+// how much it copied.
+static inline int file_copy_fd(int in,
+                               int out,
+                               const FileCopyOptions *options,
+                               FileCopyStatus *result)
+{
+    if (result) *result = (FileCopyStatus){FILE_COPY_CLONE, 0, 0};
+    struct stat st, out_st;
+    if (fstat(in, &st) == -1 || fstat(out, &out_st) == -1) return -errno;
+    if (st.st_dev == out_st.st_dev && st.st_ino == out_st.st_ino)
+    {
+        return -EINVAL;  // Truncating out would destroy the source
+    }
+
+    FileCopyStatus status = {FILE_COPY_CLONE, 0, (uint64_t) st.st_size};
+    if (ftruncate(out, 0) == -1) return -errno;
+
+    int error = -EOPNOTSUPP;
+    FileCopyMethod method = options ? options->first : FILE_COPY_CLONE;
+    for (; method < FILE_COPY_METHODS; method++)
+    {
+        status.method = method;
+        switch (method)
+        {
+        case FILE_COPY_CLONE:
+            error = file_copy_clone(in, out, &status);
+            break;
+        case FILE_COPY_RANGE:
+            error = file_copy_range(in, out, &status, options);
+            break;
+        case FILE_COPY_SENDFILE:
+            error = file_copy_sendfile(in, out, &status, options);
+            break;
+        case FILE_COPY_SPLICE:
+            error = file_copy_splice(in, out, &status, options);
+            break;
+        default:
+            error = file_copy_buffered(in, out, &status, options);
+            break;
+        }
+        if (error == 0 || !file_copy_unsupported(-error)) break;
+    }
+
+    // A clone reports nothing chunk by chunk; everyone gets the final call
+    if (error == 0 && method == FILE_COPY_CLONE) file_copy_report(options, &status);
+    if (result) *result = status;
+    return error;
+}
+
+static inline int file_copy(const char *source,
+                            const char *destination,
+                            const FileCopyOptions *options,
+                            FileCopyStatus *result)
+{
+    if (result) *result = (FileCopyStatus){FILE_COPY_CLONE, 0, 0};
+    int in = open(source, O_RDONLY | O_CLOEXEC);
+    if (in == -1) return -errno;
+
+    struct stat st;
+    if (fstat(in, &st) == -1)
+    {
+        int error = -errno;
+        close(in);
+        return error;
+    }
+    // No O_TRUNC: file_copy_fd truncates only once it knows destination
+    // is not source
+    int out = open(destination, O_WRONLY | O_CREAT | O_CLOEXEC,
+                   st.st_mode & 0777);
+    if (out == -1)
+    {
+        int error = -errno;
+        close(in);
+        return error;
+    }
+
+    int error = file_copy_fd(in, out, options, result);
+    if (close(out) == -1 && error == 0) error = -errno;
+    close(in);
+    return error;
+}
+
+#endif  // FILE_COPY_H
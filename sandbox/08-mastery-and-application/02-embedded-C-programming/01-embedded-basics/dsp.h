@@ -0,0 +1,324 @@
+// Fixed-point filter stages for sensor sample blocks.
+//
+// Samples are Q15 (int16_t, -1.0 .. 1.0). Every stage works on a whole
+// block and keeps its history in a state struct, so a block from the ADC
+// (e.g. a DMA half-buffer) runs through each stage in one tight loop with
+// no per-sample calls and no floating point:
+//
+//   dsp_from_adc        12-bit unsigned ADC codes (any stride) -> Q15
+//   dsp_median_*        median of the last N samples, removes spikes
+//   dsp_average_*       moving average over 2^k samples
+//   dsp_cic_*           3rd-order CIC decimator by 2^k (oversampling)
+//   dsp_biquad_*        cascade of IIR biquads, Q14 coefficients
+//
+// Each *_process takes (state, in, out, count), may run in place
+// (out == in) and returns the number of samples written. On cores with
+// the DSP extension (Cortex-M4/M7, __ARM_FEATURE_SIMD32) the biquad uses
+// SMLALD to do two multiply-accumulates per instruction, as the CMSIS-DSP
+// kernels do; elsewhere it is the same arithmetic in plain C.
+#ifndef DSP_H
+#define DSP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+// Coefficient in Q14 (-2.0 .. 2.0), rounded at compile time
+#define DSP_Q14(x) ((int16_t) ((x) * 16384.0 + ((x) < 0 ? -0.5 : 0.5)))
+
+static inline int16_t dsp_saturate16(int32_t x)
+{
+    if (x > INT16_MAX) return INT16_MAX;
+    if (x < INT16_MIN) return INT16_MIN;
+    return (int16_t) x;
+}
+
+// Centre unsigned 12-bit ADC codes on zero and scale to Q15, taking every
+// stride-th input (one channel of an interleaved scan block)
+static inline size_t dsp_from_adc(int16_t *out,
+                                  const uint16_t *adc,
+                                  size_t stride,
+                                  size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = (int16_t) (((int32_t) adc[i * stride] - 2048) * 16);
+    }
+    return count;
+}
+
+/* ---- Median (despiking) ---- */
+
+// Median of the current and previous N-1 samples (N odd, up to 7). A
+// single-sample spike never reaches the output, while steps pass with a
+// delay of N/2 samples.
+#define DSP_MEDIAN_MAX 7
+
+typedef struct
+{
+    int16_t window[DSP_MEDIAN_MAX];  // Oldest first
+    uint8_t length;
+} DspMedian;
+
+static inline void dsp_median_init(DspMedian *state, uint8_t length)
+{
+    state->length = length;
+    for (int i = 0; i < DSP_MEDIAN_MAX; i++) state->window[i] = 0;
+}
+
+static inline int16_t dsp_median3(int16_t a, int16_t b, int16_t c)
+{
+    int16_t low = a < b ? a : b;
+    int16_t high = a < b ? b : a;
+    int16_t mid = high < c ? high : c;
+    return low > mid ? low : mid;
+}
+
+static inline size_t dsp_median_process(DspMedian *state,
+                                        const int16_t *in,
+                                        int16_t *out,
+                                        size_t count)
+{
+    int n = state->length;
+    int16_t *window = state->window;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        for (int k = 0; k < n - 1; k++) window[k] = window[k + 1];
+        window[n - 1] = in[i];
+
+        if (n == 3)
+        {
+            out[i] = dsp_median3(window[0], window[1], window[2]);
+            continue;
+        }
+
+        // Insertion sort of a copy; N is tiny
+        int16_t sorted[DSP_MEDIAN_MAX];
+        for (int k = 0; k < n; k++)
+        {
+            int16_t v = window[k];
+            int j = k;
+            for (; j > 0 && sorted[j - 1] > v; j--) sorted[j] = sorted[j - 1];
+            sorted[j] = v;
+        }
+        out[i] = sorted[n / 2];
+    }
+    return count;
+}
+
+/* ---- Moving average ---- */
+
+// Boxcar over 2^log2_length samples: a running sum plus the samples still
+// inside the window, so the cost per sample is one add and one subtract
+// whatever the length
+#define DSP_AVERAGE_MAX_LOG2 6
+
+typedef struct
+{
+    int32_t sum;
+    int16_t history[1 << DSP_AVERAGE_MAX_LOG2];
+    uint8_t log2_length;
+    uint8_t index;
+} DspAverage;
+
+static inline void dsp_average_init(DspAverage *state, uint8_t log2_length)
+{
+    state->sum = 0;
+    state->log2_length = log2_length;
+    state->index = 0;
+    for (int i = 0; i < (1 << DSP_AVERAGE_MAX_LOG2); i++) state->history[i] = 0;
+}
+
+static inline size_t dsp_average_process(DspAverage *state,
+                                         const int16_t *in,
+                                         int16_t *out,
+                                         size_t count)
+{
+    uint32_t mask = (1U << state->log2_length) - 1;
+    int32_t sum = state->sum;
+    uint32_t index = state->index;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        sum += in[i] - state->history[index];
+        state->history[index] = in[i];
+        index = (index + 1) & mask;
+        out[i] = (int16_t) (sum >> state->log2_length);
+    }
+
+    state->sum = sum;
+    state->index = (uint8_t) index;
+    return count;
+}
+
+/* ---- CIC decimator ---- */
+
+// Three integrators at the input rate, decimation by R = 2^log2_rate,
+// three combs at the output rate: a steep anti-alias low-pass with no
+// multiplies, used to trade oversampling for resolution. The integrators
+// wrap by design (two's complement arithmetic cancels the wrap in the
+// combs), so they are unsigned. Gain is R^3, removed with a shift; with
+// Q15 input that needs 16 + 3 * log2_rate <= 32 bits.
+#define DSP_CIC_MAX_LOG2 5
+
+typedef struct
+{
+    uint32_t integrator[3];
+    uint32_t comb_delay[3];
+    uint8_t log2_rate;
+    uint8_t phase;  // Input samples since the last output
+} DspCic;
+
+static inline void dsp_cic_init(DspCic *state, uint8_t log2_rate)
+{
+    for (int k = 0; k < 3; k++)
+    {
+        state->integrator[k] = 0;
+        state->comb_delay[k] = 0;
+    }
+    state->log2_rate = log2_rate;
+    state->phase = 0;
+}
+
+// Writes one output per 2^log2_rate inputs; the phase carries over
+// between blocks, so blocks need not be a multiple of the rate
+static inline size_t dsp_cic_process(DspCic *state,
+                                     const int16_t *in,
+                                     int16_t *out,
+                                     size_t count)
+{
+    uint32_t i0 = state->integrator[0];
+    uint32_t i1 = state->integrator[1];
+    uint32_t i2 = state->integrator[2];
+    uint32_t rate_mask = (1U << state->log2_rate) - 1;
+    uint32_t phase = state->phase;
+    size_t written = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        i0 += (uint32_t) (int32_t) in[i];
+        i1 += i0;
+        i2 += i1;
+
+        phase = (phase + 1) & rate_mask;
+        if (phase != 0) continue;
+
+        uint32_t c0 = i2 - state->comb_delay[0];
+        state->comb_delay[0] = i2;
+        uint32_t c1 = c0 - state->comb_delay[1];
+        state->comb_delay[1] = c0;
+        uint32_t c2 = c1 - state->comb_delay[2];
+        state->comb_delay[2] = c1;
+
+        out[written++] = dsp_saturate16((int32_t) c2 >> (3 * state->log2_rate));
+    }
+
+    state->integrator[0] = i0;
+    state->integrator[1] = i1;
+    state->integrator[2] = i2;
+    state->phase = (uint8_t) phase;
+    return written;
+}
+
+/* ---- Biquad cascade ---- */
+
+// Direct form I with Q14 coefficients:
+//   y = b0 x + b1 x[-1] + b2 x[-2] - a1 y[-1] - a2 y[-2]
+// a1 and a2 are stored negated, and each pair of coefficients and each
+// pair of past samples sits in one 32-bit word, which is the operand
+// layout SMLALD wants. Accumulation is 64-bit, so no intermediate can
+// overflow; the result is saturated to Q15.
+typedef struct
+{
+    int16_t b0, b1, b2, a1, a2;  // As designed (a0 = 1), DSP_Q14()
+} DspBiquadCoeffs;
+
+#define DSP_BIQUAD_MAX_STAGES 4
+
+typedef struct
+{
+    int32_t b12[DSP_BIQUAD_MAX_STAGES];  // b1 | b2 << 16
+    int32_t a12[DSP_BIQUAD_MAX_STAGES];  // -a1 | -a2 << 16
+    int16_t b0[DSP_BIQUAD_MAX_STAGES];
+    uint32_t x12[DSP_BIQUAD_MAX_STAGES];  // x[-1] | x[-2] << 16
+    uint32_t y12[DSP_BIQUAD_MAX_STAGES];  // y[-1] | y[-2] << 16
+    uint8_t stages;
+} DspBiquad;
+
+static inline uint32_t dsp_pack16(int16_t low, int16_t high)
+{
+    return (uint16_t) low | (uint32_t) (uint16_t) high << 16;
+}
+
+static inline void dsp_biquad_init(DspBiquad *state,
+                                   const DspBiquadCoeffs *coeffs,
+                                   uint8_t stages)
+{
+    state->stages = stages;
+    for (int s = 0; s < stages; s++)
+    {
+        state->b0[s] = coeffs[s].b0;
+        state->b12[s] = (int32_t) dsp_pack16(coeffs[s].b1, coeffs[s].b2);
+        state->a12[s] = (int32_t) dsp_pack16((int16_t) -coeffs[s].a1,
+                                             (int16_t) -coeffs[s].a2);
+        state->x12[s] = 0;
+        state->y12[s] = 0;
+    }
+}
+
+// Sum of the two 16x16 products of packed pairs, added to acc
+static inline int64_t dsp_dual_mac(uint32_t x, int32_t y, int64_t acc)
+{
+#if defined(__ARM_FEATURE_SIMD32)
+    return __smlald((int16x2_t) x, (int16x2_t) y, acc);
+#else
+    return acc + (int32_t) (int16_t) x * (int16_t) y
+           + (int32_t) (int16_t) (x >> 16) * (int16_t) ((uint32_t) y >> 16);
+#endif
+}
+
+static inline size_t dsp_biquad_process(DspBiquad *state,
+                                        const int16_t *in,
+                                        int16_t *out,
+                                        size_t count)
+{
+    // Stage by stage over the whole block keeps each stage's coefficients
+    // and state in registers for the inner loop
+    const int16_t *src = in;
+    for (int s = 0; s < state->stages; s++)
+    {
+        int32_t b0 = state->b0[s];
+        int32_t b12 = state->b12[s];
+        int32_t a12 = state->a12[s];
+        uint32_t x12 = state->x12[s];
+        uint32_t y12 = state->y12[s];
+
+        for (size_t i = 0; i < count; i++)
+        {
+            int16_t x = src[i];
+            int64_t acc = (int64_t) b0 * x;
+            acc = dsp_dual_mac(x12, b12, acc);
+            acc = dsp_dual_mac(y12, a12, acc);
+            int16_t y = dsp_saturate16((int32_t) (acc >> 14));
+
+            x12 = (x12 << 16) | (uint16_t) x;
+            y12 = (y12 << 16) | (uint16_t) y;
+            out[i] = y;
+        }
+
+        state->x12[s] = x12;
+        state->y12[s] = y12;
+        src = out;
+    }
+    if (state->stages == 0 && out != in)
+    {
+        for (size_t i = 0; i < count; i++) out[i] = in[i];
+    }
+    return count;
+}
+
+#endif  // DSP_H
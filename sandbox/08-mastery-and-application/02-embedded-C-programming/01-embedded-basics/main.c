@@ -3,8 +3,11 @@
 // Standard headers are often limited or unavailable in embedded systems
 // But we include them here for educational purposes
 #include <stdbool.h>  // For boolean types
+#include <stddef.h>   // For NULL
 #include <stdint.h>   // For fixed-width integers (crucial in embedded)
 
+#include "dsp.h"  // Fixed-point filter stages
+
 /* ---- Memory Management in Constrained Environments ---- */
 
 // Use fixed-width integers to ensure consistent size across platforms
@@ -15,6 +18,7 @@ uint32_t system_time_ms;  // Exactly 32 bits (4 bytes)
 // Use static allocation instead of dynamic to avoid fragmentation
 #define MAX_SAMPLES 64
 uint16_t sample_buffer[MAX_SAMPLES];
+volatile bool samples_ready;  // Set by acquisition once the buffer is full
 
 // Memory-efficient data structures using bit-fields
 typedef struct
@@ -35,6 +39,7 @@ typedef struct
 #define GPIO_PORT_B    (*(volatile uint32_t*) (IO_BASE_ADDR + 0x04))
 #define TIMER1_CTRL    (*(volatile uint32_t*) (IO_BASE_ADDR + 0x10))
 #define TIMER1_COUNTER (*(volatile uint32_t*) (IO_BASE_ADDR + 0x14))
+#define TIMER1_COMPARE (*(volatile uint32_t*) (IO_BASE_ADDR + 0x18))
 
 // Bit manipulation macros (avoiding function calls for efficiency)
 #define SET_BIT(REG, BIT)    ((REG) |= (1UL << (BIT)))
@@ -73,6 +78,194 @@ void led_control(uint8_t led_num, bool state)
 
 /* ---- Interrupt Handling ---- */
 
+// Interrupt masking around data shared with interrupt handlers
+#if defined(__arm__)
+#define irq_disable()        __asm__ volatile("cpsid i" ::: "memory")
+#define irq_enable()         __asm__ volatile("cpsie i" ::: "memory")
+#define wait_for_interrupt() __asm__ volatile("wfi" ::: "memory")
+#else
+#define irq_disable()        ((void) 0)
+#define irq_enable()         ((void) 0)
+#define wait_for_interrupt() ((void) 0)
+#endif
+
+/* ---- Timing and Delays ---- */
+
+// TIMER1_COUNTER counts milliseconds and runs freely; TIMER1_COMPARE
+// raises TIMER1_IRQHandler when the counter reaches it (assuming the
+// timer is set up that way). The interrupt is only programmed for the
+// next deadline, so the MCU sleeps between events instead of waking every
+// millisecond.
+
+// Software timers on a hierarchical timer wheel: level 0 has one slot per
+// tick for the next 64 ms, each higher level has 64 slots that are 64
+// times wider. A timer goes into the slot its deadline falls in, so
+// starting and cancelling are O(1) list operations; when a lower level
+// wraps, the next slot of the level above is redistributed downwards.
+// Deadlines up to 2^24 ms (about 4.6 hours) ahead fit directly, later
+// ones are parked at the top and re-sorted on the way down.
+#define WHEEL_LEVELS 4
+#define WHEEL_BITS   6
+#define WHEEL_SLOTS  (1U << WHEEL_BITS)
+#define WHEEL_RANGE  (1UL << (WHEEL_LEVELS * WHEEL_BITS))
+
+typedef void (*TimerCallback)(void* arg);
+
+typedef enum
+{
+    TIMER_IDLE,
+    TIMER_ARMED,    // On the wheel
+    TIMER_PENDING,  // Expired, callback waiting for timer_dispatch
+} TimerState;
+
+// Owned by the caller (static or on the stack); the wheel only links them,
+// so the number of timers is limited by RAM, not by a table size
+typedef struct SoftTimer
+{
+    struct SoftTimer* next;
+    struct SoftTimer** pprev;  // Link that points at this timer
+    uint32_t expires;          // Tick of the deadline
+    uint32_t period;           // Reload in ms, 0 for one-shot
+    TimerCallback callback;    // Runs from timer_dispatch, not the ISR
+    void* arg;
+    uint16_t bucket;           // level * WHEEL_SLOTS + slot while armed
+    uint8_t state;             // TimerState
+} SoftTimer;
+
+static SoftTimer* wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+static uint64_t wheel_occupied[WHEEL_LEVELS];  // Bit per non-empty slot
+static uint32_t wheel_time;  // Last tick the wheel has processed
+static SoftTimer* pending_head;
+static SoftTimer** pending_tail = &pending_head;
+
+static void list_unlink(SoftTimer* timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next != NULL) timer->next->pprev = timer->pprev;
+}
+
+static void wheel_insert(SoftTimer* timer)
+{
+    uint32_t delta = timer->expires - wheel_time;
+    if (delta >= WHEEL_RANGE) delta = WHEEL_RANGE - 1;
+
+    int level = 0;
+    while (delta >= (1UL << (WHEEL_BITS * (level + 1)))) level++;
+    uint32_t slot =
+        ((wheel_time + delta) >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1);
+
+    SoftTimer** head = &wheel[level][slot];
+    timer->next = *head;
+    if (*head != NULL) (*head)->pprev = &timer->next;
+    timer->pprev = head;
+    *head = timer;
+    timer->bucket = (uint16_t) (level * WHEEL_SLOTS + slot);
+    timer->state = TIMER_ARMED;
+    wheel_occupied[level] |= 1ULL << slot;
+}
+
+static void wheel_remove(SoftTimer* timer)
+{
+    list_unlink(timer);
+    int level = timer->bucket / WHEEL_SLOTS;
+    int slot = timer->bucket % WHEEL_SLOTS;
+    if (wheel[level][slot] == NULL) wheel_occupied[level] &= ~(1ULL << slot);
+}
+
+// Queue for timer_dispatch, in expiry order
+static void pending_append(SoftTimer* timer)
+{
+    timer->next = NULL;
+    timer->pprev = pending_tail;
+    *pending_tail = timer;
+    pending_tail = &timer->next;
+    timer->state = TIMER_PENDING;
+}
+
+static void pending_remove(SoftTimer* timer)
+{
+    if (pending_tail == &timer->next) pending_tail = timer->pprev;
+    list_unlink(timer);
+}
+
+// Take a whole slot off the wheel
+static SoftTimer* wheel_take_slot(int level, uint32_t slot)
+{
+    SoftTimer* list = wheel[level][slot];
+    wheel[level][slot] = NULL;
+    wheel_occupied[level] &= ~(1ULL << slot);
+    return list;
+}
+
+// Process tick `now`: redistribute the higher-level slots that start
+// here, then expire the level 0 slot
+static void wheel_process_tick(uint32_t now)
+{
+    wheel_time = now;
+
+    for (int level = 1; level < WHEEL_LEVELS; level++)
+    {
+        if (now & ((1UL << (WHEEL_BITS * level)) - 1)) break;
+        uint32_t slot = (now >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1);
+        for (SoftTimer* t = wheel_take_slot(level, slot); t != NULL;)
+        {
+            SoftTimer* next = t->next;
+            if (t->expires == now)
+                pending_append(t);
+            else
+                wheel_insert(t);
+            t = next;
+        }
+    }
+
+    for (SoftTimer* t = wheel_take_slot(0, now & (WHEEL_SLOTS - 1)); t != NULL;)
+    {
+        SoftTimer* next = t->next;
+        pending_append(t);
+        t = next;
+    }
+}
+
+static uint64_t rotate_right64(uint64_t x, unsigned n)
+{
+    n &= 63;
+    return n == 0 ? x : (x >> n) | (x << (64 - n));
+}
+
+// Earliest tick at which the wheel has work: a level 0 slot to expire or
+// an occupied higher slot to redistribute. Empty ticks in between can be
+// skipped (and slept through).
+static uint32_t wheel_next_event(void)
+{
+    uint32_t next = wheel_time + WHEEL_RANGE;
+    for (int level = 0; level < WHEEL_LEVELS; level++)
+    {
+        if (wheel_occupied[level] == 0) continue;
+        unsigned shift = WHEEL_BITS * level;
+        uint32_t index = wheel_time >> shift;
+        // Slots index+1 .. index+64 in order
+        uint64_t ahead = rotate_right64(wheel_occupied[level], index + 1);
+        uint32_t at = (index + 1 + (uint32_t) __builtin_ctzll(ahead)) << shift;
+        if (at - wheel_time < next - wheel_time) next = at;
+    }
+    return next;
+}
+
+// Bring the wheel up to `now`, jumping over ticks with nothing to do
+static void wheel_advance(uint32_t now)
+{
+    while (wheel_time != now)
+    {
+        uint32_t next = wheel_next_event();
+        if (next - wheel_time > now - wheel_time)
+        {
+            wheel_time = now;
+            break;
+        }
+        wheel_process_tick(next);
+    }
+}
+
 // Interrupt service routine declaration
 // In actual code, this would use specific compiler attributes
 void TIMER1_IRQHandler(void)
@@ -80,43 +273,123 @@ void TIMER1_IRQHandler(void)
     // Clear interrupt flag first (device specific)
     TIMER1_CTRL |= (1UL << 0);  // Assuming bit 0 is the flag clear bit
 
-    // Handle the interrupt - toggle status LED
-    TOGGLE_BIT(GPIO_PORT_A, 0);
+    // Critical: keep ISRs short and fast. Only move expired timers to the
+    // pending list; their callbacks run later from the main loop.
+    wheel_advance(TIMER1_COUNTER);
+}
 
-    // Critical: keep ISRs short and fast
-    // Don't use floating point or complex logic in ISRs
+// Current time in ms
+uint32_t timer_now(void)
+{
+    return TIMER1_COUNTER;
 }
 
-/* ---- Timing and Delays ---- */
+// Stop a timer; harmless if it is not running. A timer that has expired
+// but not been dispatched yet is dropped too.
+void timer_cancel(SoftTimer* timer)
+{
+    irq_disable();
+    if (timer->state == TIMER_ARMED)
+        wheel_remove(timer);
+    else if (timer->state == TIMER_PENDING)
+        pending_remove(timer);
+    timer->state = TIMER_IDLE;
+    irq_enable();
+}
 
-// Blocking delay (avoid in production code if possible)
-void delay_ms(uint32_t ms)
+// (Re)start a timer: callback(arg) runs from timer_dispatch delay_ms from
+// now, then every period_ms if that is non-zero
+void timer_start(SoftTimer* timer,
+                 uint32_t delay_ms,
+                 uint32_t period_ms,
+                 TimerCallback callback,
+                 void* arg)
 {
-    // Reset timer counter
-    TIMER1_COUNTER = 0;
+    timer_cancel(timer);
+    timer->period = period_ms;
+    timer->callback = callback;
+    timer->arg = arg;
+
+    irq_disable();
+    wheel_advance(TIMER1_COUNTER);
+    timer->expires = TIMER1_COUNTER + delay_ms;
+    if (delay_ms == 0)
+        pending_append(timer);
+    else
+        wheel_insert(timer);
+    irq_enable();
+}
+
+bool timer_is_active(const SoftTimer* timer)
+{
+    return timer->state != TIMER_IDLE;
+}
 
-    // Assuming timer is configured to increment every 1ms
-    while (TIMER1_COUNTER < ms)
+// Run the callbacks of expired timers; call from the main loop. Periodic
+// timers are re-armed from their previous deadline, so they do not drift
+// however late the dispatch runs.
+void timer_dispatch(void)
+{
+    for (;;)
     {
-        // Could add a low-power wait instruction here
-        // e.g., __WFI() (Wait For Interrupt) on ARM
+        irq_disable();
+        SoftTimer* timer = pending_head;
+        if (timer == NULL)
+        {
+            irq_enable();
+            return;
+        }
+        pending_remove(timer);
+        timer->state = TIMER_IDLE;
+        if (timer->period != 0)
+        {
+            timer->expires += timer->period;
+            if ((int32_t) (timer->expires - wheel_time) <= 0)
+                pending_append(timer);  // Fell behind; run again next pass
+            else
+                wheel_insert(timer);
+        }
+        TimerCallback callback = timer->callback;
+        void* arg = timer->arg;
+        irq_enable();
+
+        if (callback != NULL) callback(arg);
     }
 }
 
-// Non-blocking timing example
-bool is_elapsed(uint32_t start_time, uint32_t duration_ms)
+// Sleep until the next timer deadline or another interrupt. Interrupts
+// stay masked from the check to the WFI, which still wakes on a pending
+// interrupt, so an event arriving in between cannot be slept through.
+void timer_sleep(void)
 {
-    uint32_t current_time = TIMER1_COUNTER;
-
-    // Handle timer overflow
-    if (current_time < start_time)
+    irq_disable();
+    wheel_advance(TIMER1_COUNTER);
+    if (pending_head == NULL)
     {
-        return (0xFFFFFFFF - start_time + current_time) >= duration_ms;
+        uint32_t wake = wheel_next_event();
+        TIMER1_COMPARE = wake;
+        if ((int32_t) (wake - TIMER1_COUNTER) > 0) wait_for_interrupt();
     }
-    else
+    irq_enable();
+}
+
+// Blocking delay, spent asleep rather than spinning
+void delay_ms(uint32_t ms)
+{
+    SoftTimer timer = {0};
+    timer_start(&timer, ms, 0, NULL, NULL);
+    while (timer.state == TIMER_ARMED)
     {
-        return (current_time - start_time) >= duration_ms;
+        timer_sleep();
     }
+    timer_cancel(&timer);  // Off the pending list before it goes out of scope
+}
+
+// Non-blocking timing example
+bool is_elapsed(uint32_t start_time, uint32_t duration_ms)
+{
+    // Unsigned subtraction is correct across counter overflow
+    return (uint32_t) (TIMER1_COUNTER - start_time) >= duration_ms;
 }
 
 /* ---- Low Power Techniques ---- */
@@ -130,42 +403,105 @@ void enter_sleep_mode(void)
     // Set power-saving mode bits (device specific)
     TIMER1_CTRL |= (1UL << 8);  // Assuming bit 8 enables low-power mode
 
-    // Execute sleep instruction (architecture specific)
-    // For ARM: __WFI();  // Wait For Interrupt
+    // Sleep until the next software timer deadline or another wake-up
+    // interrupt (WFI on ARM)
+    timer_sleep();
 
     // Code resumes here after waking up
     // Restore peripherals as needed
 }
 
+/* ---- Signal Processing ---- */
+
+// Sensor pipeline: despike, oversample by 8 with a CIC decimator, then a
+// 2nd-order Butterworth low-pass at 1/8 of the decimated rate. All stages
+// are integer, block-at-a-time and run in place in one scratch buffer;
+// the FPU is never touched, so there is no FP context to save in
+// interrupts either.
+#define OVERSAMPLE_LOG2 3
+
+static DspMedian despike;
+static DspCic decimator;
+static DspBiquad lowpass;
+static int16_t filter_scratch[MAX_SAMPLES];
+int16_t filtered_value;  // Latest output, Q15
+
+static const DspBiquadCoeffs lowpass_coeffs[] = {
+    {DSP_Q14(0.09763), DSP_Q14(0.19526), DSP_Q14(0.09763),
+     DSP_Q14(-0.94281), DSP_Q14(0.33333)},
+};
+
+void sensor_pipeline_init(void)
+{
+    dsp_median_init(&despike, 3);
+    dsp_cic_init(&decimator, OVERSAMPLE_LOG2);
+    dsp_biquad_init(&lowpass, lowpass_coeffs, 1);
+}
+
+// Filter a block of raw ADC codes (every stride-th one, so a single
+// channel can be taken from an interleaved scan block); returns the
+// number of decimated outputs
+size_t sensor_pipeline_process(const uint16_t* adc, size_t stride, size_t count)
+{
+    if (count > MAX_SAMPLES) count = MAX_SAMPLES;
+
+    int16_t* block = filter_scratch;
+    count = dsp_from_adc(block, adc, stride, count);
+    count = dsp_median_process(&despike, block, block, count);
+    count = dsp_cic_process(&decimator, block, block, count);
+    count = dsp_biquad_process(&lowpass, block, block, count);
+
+    if (count > 0) filtered_value = block[count - 1];
+    return count;
+}
+
 /* ---- Main Function ---- */
 
+static void toggle_led(void* arg)
+{
+    TOGGLE_BIT(GPIO_PORT_A, (uintptr_t) arg);
+}
+
 int main(void)
 {
     // System initialization
     gpio_init();
+    sensor_pipeline_init();
 
-    // Main loop - never exits in embedded systems
-    uint32_t last_led_toggle = 0;
+    // Status LED heartbeat
+    static SoftTimer heartbeat, blink;
+    timer_start(&heartbeat, 500, 500, toggle_led, (void*) 0);
 
+    // Main loop - never exits in embedded systems
     while (1)
     {  // Infinite loop
+        timer_dispatch();
+
+        // Filter each full sample buffer
+        if (samples_ready)
+        {
+            sensor_pipeline_process(sample_buffer, 1, MAX_SAMPLES);
+            samples_ready = false;
+        }
+
         // Check if button is pressed (active low)
         if (READ_BIT(GPIO_PORT_B, 7) == 0)
         {
             // Button pressed, toggle LED 1 every 100ms
-            if (is_elapsed(last_led_toggle, 100))
+            if (!timer_is_active(&blink))
             {
-                TOGGLE_BIT(GPIO_PORT_A, 1);
-                last_led_toggle = TIMER1_COUNTER;
+                timer_start(&blink, 100, 100, toggle_led, (void*) 1);
             }
         }
         else
         {
-            // Button not pressed, enter low power mode
-            // This is just for demonstration - in practice you'd
-            // configure wake-up sources before sleeping
-            enter_sleep_mode();
+            timer_cancel(&blink);
         }
+
+        // Sleep until the next timer is due. This is just for
+        // demonstration - in practice you'd also configure the button
+        // as a wake-up source before sleeping
+        enter_sleep_mode();
     }
 
     // Will never reach this point
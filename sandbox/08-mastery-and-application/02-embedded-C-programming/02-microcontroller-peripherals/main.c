@@ -2,6 +2,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 /* ---- ADC (Analog-to-Digital Converter) ---- */
 
@@ -15,6 +16,8 @@
     (*(volatile uint32_t*) (ADC_BASE + 0x0C))  // Sample time register 2
 #define ADC_SQR1 \
     (*(volatile uint32_t*) (ADC_BASE + 0x10))  // Regular sequence register 1
+#define ADC_SQR3 \
+    (*(volatile uint32_t*) (ADC_BASE + 0x34))  // Regular sequence register 3
 #define ADC_DR (*(volatile uint32_t*) (ADC_BASE + 0x4C))  // Data register
 
 // Initialize ADC for single channel reading
@@ -62,6 +65,131 @@ uint16_t adc_read(uint8_t channel)
     return (uint16_t) (ADC_DR & 0x0000FFFF);
 }
 
+/* ---- Continuous ADC scan with circular DMA ---- */
+
+// One adc_read per sample costs a full conversion of CPU time spent
+// polling EOC. For continuous sampling the ADC instead scans a channel
+// sequence on its own and DMA moves every result into a RAM buffer split
+// in two halves: the half-transfer interrupt hands the first half to the
+// application while DMA fills the second, transfer-complete the other way
+// round. The CPU only sees one interrupt per half, not per sample.
+
+// DMA register definitions (example: ADC on DMA2 stream 0)
+#define DMA_BASE 0x40026400
+#define DMA_LISR \
+    (*(volatile uint32_t*) (DMA_BASE + 0x00))  // Interrupt status register
+#define DMA_LIFCR \
+    (*(volatile uint32_t*) (DMA_BASE + 0x08))  // Interrupt flag clear register
+#define DMA_S0CR \
+    (*(volatile uint32_t*) (DMA_BASE + 0x10))  // Stream configuration
+#define DMA_S0NDTR \
+    (*(volatile uint32_t*) (DMA_BASE + 0x14))  // Number of data items
+#define DMA_S0PAR \
+    (*(volatile uint32_t*) (DMA_BASE + 0x18))  // Peripheral address
+#define DMA_S0M0AR \
+    (*(volatile uint32_t*) (DMA_BASE + 0x1C))  // Memory address
+
+#define DMA_FLAG_HT (1u << 4)  // Assuming bit 4 is half transfer (stream 0)
+#define DMA_FLAG_TC (1u << 5)  // Assuming bit 5 is transfer complete
+
+#define ADC_SCAN_CHANNELS 4
+#define ADC_SCAN_HALF     (ADC_SCAN_CHANNELS * 64)  // Samples per half
+
+typedef void (*adc_block_callback_t)(const uint16_t* block, uint16_t count);
+
+static volatile uint16_t adc_scan_buffer[2 * ADC_SCAN_HALF];
+static adc_block_callback_t adc_on_half;  // Optional, run in the interrupt
+static adc_block_callback_t adc_on_full;
+static volatile uint32_t adc_blocks_completed;  // Written by the interrupt
+static uint32_t adc_blocks_consumed;
+static uint32_t adc_blocks_lost;
+
+// Scan the channels continuously at the ADC's own pace; results land in
+// adc_scan_buffer in scan order
+void adc_scan_start(const uint8_t channels[ADC_SCAN_CHANNELS],
+                    adc_block_callback_t on_half,
+                    adc_block_callback_t on_full)
+{
+    adc_on_half = on_half;
+    adc_on_full = on_full;
+    adc_blocks_completed = 0;
+    adc_blocks_consumed = 0;
+    adc_blocks_lost = 0;
+
+    // Stream: ADC data register -> buffer, 16-bit items, circular
+    DMA_S0CR = 0;
+    DMA_LIFCR = 0x3D;  // Clear every stream 0 flag
+    DMA_S0PAR = (uint32_t) (uintptr_t) &ADC_DR;
+    DMA_S0M0AR = (uint32_t) (uintptr_t) adc_scan_buffer;
+    DMA_S0NDTR = 2 * ADC_SCAN_HALF;
+    DMA_S0CR = (1u << 13)    // Assuming bits [14:13] = 01 is 16-bit memory
+               | (1u << 11)  // Assuming bits [12:11] = 01 is 16-bit peripheral
+               | (1u << 10)  // Memory increment
+               | (1u << 8)   // Circular mode
+               | (1u << 4)   // Transfer complete interrupt
+               | (1u << 3);  // Half transfer interrupt
+    DMA_S0CR |= 0x00000001;  // Enable stream
+
+    // Regular sequence: up to six channels in SQR3, 5 bits each
+    ADC_SQR3 = 0;
+    for (int i = 0; i < ADC_SCAN_CHANNELS; i++)
+    {
+        ADC_SQR3 |= (uint32_t) channels[i] << (5 * i);
+    }
+    ADC_SQR1 = (ADC_SCAN_CHANNELS - 1) << 20;  // Assuming bits [23:20] are L
+
+    ADC_CR1 |= 0x00000100;   // Assuming bit 8 is SCAN
+    ADC_CR2 |= 0x00000302    // Assuming bits 9, 8, 1 are DDS, DMA, CONT
+               | 0x00000001;  // ADC on
+    ADC_CR2 |= 0x40000000;   // SWSTART; CONT keeps it going from here
+}
+
+void adc_scan_stop(void)
+{
+    ADC_CR2 &= ~0x00000302u;
+    DMA_S0CR &= ~0x00000001u;
+}
+
+// DMA stream interrupt: acknowledge, run the callback for the finished
+// half and count it for adc_scan_next_block
+void DMA2_Stream0_IRQHandler(void)
+{
+    uint32_t flags = DMA_LISR;
+    if (flags & DMA_FLAG_HT)
+    {
+        DMA_LIFCR = DMA_FLAG_HT;
+        if (adc_on_half)
+            adc_on_half((const uint16_t*) adc_scan_buffer, ADC_SCAN_HALF);
+        adc_blocks_completed++;
+    }
+    if (flags & DMA_FLAG_TC)
+    {
+        DMA_LIFCR = DMA_FLAG_TC;
+        if (adc_on_full)
+            adc_on_full((const uint16_t*) adc_scan_buffer + ADC_SCAN_HALF,
+                        ADC_SCAN_HALF);
+        adc_blocks_completed++;
+    }
+}
+
+// Oldest half not yet consumed, or NULL if DMA has not finished one. The
+// block stays valid until DMA comes back round to it, one half-period
+// from now; if the caller fell further behind, older halves are skipped
+// and counted in adc_blocks_lost.
+const uint16_t* adc_scan_next_block(void)
+{
+    uint32_t completed = adc_blocks_completed;
+    if (completed == adc_blocks_consumed) return NULL;
+    if (completed - adc_blocks_consumed > 1)
+    {
+        adc_blocks_lost += completed - 1 - adc_blocks_consumed;
+        adc_blocks_consumed = completed - 1;
+    }
+
+    uint32_t half = adc_blocks_consumed++;
+    return (const uint16_t*) adc_scan_buffer + (half % 2) * ADC_SCAN_HALF;
+}
+
 /* ---- UART (Universal Asynchronous Receiver-Transmitter) ---- */
 
 // UART register definitions
@@ -72,6 +200,88 @@ uint16_t adc_read(uint8_t channel)
     (*(volatile uint32_t*) (UART_BASE + 0x08))  // Baud rate register
 #define UART_CR1 \
     (*(volatile uint32_t*) (UART_BASE + 0x0C))  // Control register 1
+#define UART_CR3 \
+    (*(volatile uint32_t*) (UART_BASE + 0x14))  // Control register 3
+
+#define UART_SR_RXNE   0x00000020  // Assuming bit 5 is RXNE
+#define UART_SR_TXE    0x00000080  // Assuming bit 7 is TXE
+#define UART_SR_ORE    0x00000008  // Assuming bit 3 is overrun error
+#define UART_CR1_RXNEIE 0x00000020  // RX not empty interrupt enable
+#define UART_CR1_TXEIE  0x00000080  // TX empty interrupt enable
+#define UART_CR3_DMAT   0x00000080  // Assuming bit 7 is DMA transmit
+
+// TX DMA on stream 7 of the controller used by the ADC
+#define DMA_HISR \
+    (*(volatile uint32_t*) (DMA_BASE + 0x04))  // High interrupt status
+#define DMA_HIFCR \
+    (*(volatile uint32_t*) (DMA_BASE + 0x0C))  // High interrupt flag clear
+#define DMA_S7CR   (*(volatile uint32_t*) (DMA_BASE + 0xB8))
+#define DMA_S7NDTR (*(volatile uint32_t*) (DMA_BASE + 0xBC))
+#define DMA_S7PAR  (*(volatile uint32_t*) (DMA_BASE + 0xC0))
+#define DMA_S7M0AR (*(volatile uint32_t*) (DMA_BASE + 0xC4))
+#define DMA_S7_TC  (1u << 27)  // Assuming bit 27 is transfer complete
+
+// Polling the status register stalls the CPU for a whole character time
+// per byte: about 87 us at 115200 baud, so several milliseconds per log
+// line. Instead the application and the UART interrupt exchange bytes
+// through two single-producer single-consumer rings. The application
+// only ever writes tx.head and rx.tail, the interrupt only tx.tail and
+// rx.head, so no locking is needed: each side publishes its index after
+// the data it covers (release) and reads the other side's index before
+// touching the data (acquire).
+
+#define UART_RING_SIZE 256  // Power of two
+#define UART_RING_MASK (UART_RING_SIZE - 1)
+
+typedef struct
+{
+    uint8_t data[UART_RING_SIZE];
+    uint16_t head;  // Next slot to write; owned by the producer
+    uint16_t tail;  // Next slot to read; owned by the consumer
+} uart_ring_t;
+
+static uart_ring_t uart_tx;  // Application -> interrupt
+static uart_ring_t uart_rx;  // Interrupt -> application
+static volatile uint32_t uart_rx_dropped;  // Bytes lost to a full ring
+static volatile bool uart_dma_busy;
+
+// Indices run freely and wrap at 2^16; head - tail is the fill level
+static inline uint16_t ring_count(uart_ring_t* ring)
+{
+    uint16_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint16_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    return (uint16_t) (head - tail);
+}
+
+// Producer side: copy up to len bytes in, return how many fit
+static size_t ring_write(uart_ring_t* ring, const uint8_t* src, size_t len)
+{
+    uint16_t head = ring->head;
+    uint16_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    size_t space = UART_RING_SIZE - (uint16_t) (head - tail);
+    if (len > space) len = space;
+    for (size_t i = 0; i < len; i++)
+    {
+        ring->data[(head + i) & UART_RING_MASK] = src[i];
+    }
+    __atomic_store_n(&ring->head, (uint16_t) (head + len), __ATOMIC_RELEASE);
+    return len;
+}
+
+// Consumer side: copy up to len bytes out, return how many there were
+static size_t ring_read(uart_ring_t* ring, uint8_t* dst, size_t len)
+{
+    uint16_t tail = ring->tail;
+    uint16_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    size_t available = (uint16_t) (head - tail);
+    if (len > available) len = available;
+    for (size_t i = 0; i < len; i++)
+    {
+        dst[i] = ring->data[(tail + i) & UART_RING_MASK];
+    }
+    __atomic_store_n(&ring->tail, (uint16_t) (tail + len), __ATOMIC_RELEASE);
+    return len;
+}
 
 // Initialize UART with specified baud rate
 void uart_init(uint32_t baud_rate)
@@ -80,37 +290,122 @@ void uart_init(uint32_t baud_rate)
     // In real systems, this would depend on clock frequencies
     UART_BRR = 0x00000683;  // Example: 9600 baud at 8MHz
 
-    // Enable UART, transmitter and receiver
-    UART_CR1 = 0x0000200C;  // UART enable, TX enable, RX enable
+    uart_tx.head = uart_tx.tail = 0;
+    uart_rx.head = uart_rx.tail = 0;
+    uart_rx_dropped = 0;
+    uart_dma_busy = false;
+
+    // Enable UART, transmitter and receiver, and the receive interrupt;
+    // the transmit interrupt is only enabled while there is data to send
+    UART_CR1 = 0x0000200C | UART_CR1_RXNEIE;
 }
 
-// Send a single character over UART
-void uart_putc(char c)
+// UART interrupt: drain the data register into the RX ring and refill it
+// from the TX ring
+void USART1_IRQHandler(void)
 {
-    // Wait until transmit data register is empty
-    while (!(UART_SR & 0x00000080));  // Assuming bit 7 is TXE
+    uint32_t status = UART_SR;
+
+    if (status & (UART_SR_RXNE | UART_SR_ORE))
+    {
+        // Reading DR clears RXNE (and ORE after the SR read above)
+        uint8_t byte = (uint8_t) (UART_DR & 0xFF);
+        if (ring_write(&uart_rx, &byte, 1) == 0) uart_rx_dropped++;
+    }
+
+    if ((status & UART_SR_TXE) && (UART_CR1 & UART_CR1_TXEIE))
+    {
+        uint8_t byte;
+        if (ring_read(&uart_tx, &byte, 1))
+        {
+            UART_DR = byte;
+        }
+        else
+        {
+            UART_CR1 &= ~UART_CR1_TXEIE;  // Nothing left; stop the interrupt
+        }
+    }
+}
 
-    // Write character to data register
-    UART_DR = c;
+// Queue up to len bytes for transmission without waiting; returns how
+// many were queued. Nothing is queued while a DMA transfer is running, so
+// the two paths never interleave on the wire.
+size_t uart_write(const void* data, size_t len)
+{
+    if (uart_dma_busy) return 0;
+    size_t queued = ring_write(&uart_tx, (const uint8_t*) data, len);
+    if (queued) UART_CR1 |= UART_CR1_TXEIE;
+    return queued;
+}
+
+// Take up to len received bytes without waiting; returns how many
+size_t uart_read(void* data, size_t len)
+{
+    return ring_read(&uart_rx, (uint8_t*) data, len);
+}
+
+// Send a single character over UART; only waits if the TX ring is full
+void uart_putc(char c)
+{
+    while (uart_write(&c, 1) == 0);
 }
 
 // Send a string over UART
 void uart_puts(const char* str)
 {
-    while (*str)
+    size_t len = strlen(str);
+    while (len)
     {
-        uart_putc(*str++);
+        size_t queued = uart_write(str, len);
+        str += queued;
+        len -= queued;
     }
 }
 
 // Receive a character from UART (blocking)
 char uart_getc(void)
 {
-    // Wait until data is received
-    while (!(UART_SR & 0x00000020));  // Assuming bit 5 is RXNE
+    char c;
+    while (uart_read(&c, 1) == 0);
+    return c;
+}
 
-    // Read and return received data
-    return (char) (UART_DR & 0xFF);
+// Hand a whole buffer to DMA: no per-byte interrupts at all. The buffer
+// must stay untouched until uart_tx_dma_busy() returns false. Returns
+// false if DMA is still busy or the TX ring has not drained yet.
+bool uart_write_dma(const void* data, uint16_t len)
+{
+    if (uart_dma_busy || ring_count(&uart_tx) != 0 || len == 0) return false;
+    uart_dma_busy = true;
+
+    DMA_S7CR = 0;
+    DMA_HIFCR = 0x0F400000;  // Clear every stream 7 flag
+    DMA_S7PAR = (uint32_t) (uintptr_t) &UART_DR;
+    DMA_S7M0AR = (uint32_t) (uintptr_t) data;
+    DMA_S7NDTR = len;
+    DMA_S7CR = (4u << 25)    // Assuming bits [27:25] select the USART1_TX channel
+               | (1u << 10)  // Memory increment
+               | (1u << 6)   // Memory to peripheral
+               | (1u << 4);  // Transfer complete interrupt
+    UART_CR3 |= UART_CR3_DMAT;
+    DMA_S7CR |= 0x00000001;  // Enable stream
+    return true;
+}
+
+bool uart_tx_dma_busy(void)
+{
+    return uart_dma_busy;
+}
+
+// DMA stream 7 interrupt: the last byte is in the UART, the buffer is free
+void DMA2_Stream7_IRQHandler(void)
+{
+    if (DMA_HISR & DMA_S7_TC)
+    {
+        DMA_HIFCR = DMA_S7_TC;
+        UART_CR3 &= ~UART_CR3_DMAT;
+        uart_dma_busy = false;
+    }
 }
 
 /* ---- I2C (Inter-Integrated Circuit) ---- */
@@ -123,6 +418,89 @@ char uart_getc(void)
 #define I2C_SR1  (*(volatile uint32_t*) (I2C_BASE + 0x14))
 #define I2C_SR2  (*(volatile uint32_t*) (I2C_BASE + 0x18))
 
+#define I2C_CR1_PE    0x0001
+#define I2C_CR1_START 0x0100  // Assuming bit 8 is START
+#define I2C_CR1_STOP  0x0200  // Assuming bit 9 is STOP
+#define I2C_CR1_ACK   0x0400  // Assuming bit 10 is ACK
+#define I2C_CR2_ITERREN 0x0100  // Error interrupt enable
+#define I2C_CR2_ITEVTEN 0x0200  // Event interrupt enable
+#define I2C_CR2_ITBUFEN 0x0400  // TXE/RXNE interrupt enable
+#define I2C_CR2_DMAEN   0x0800  // DMA requests enable
+#define I2C_CR2_LAST    0x1000  // NACK the last DMA byte
+#define I2C_SR1_SB    0x0001  // Assuming bit 0 is SB
+#define I2C_SR1_ADDR  0x0002  // Assuming bit 1 is ADDR
+#define I2C_SR1_BTF   0x0004  // Assuming bit 2 is byte transfer finished
+#define I2C_SR1_RXNE  0x0040
+#define I2C_SR1_TXE   0x0080  // Assuming bit 7 is TXE
+#define I2C_SR1_BERR  0x0100  // Bus error
+#define I2C_SR1_ARLO  0x0200  // Arbitration lost
+#define I2C_SR1_AF    0x0400  // No acknowledge
+#define I2C_SR2_BUSY  0x0002  // Assuming bit 1 is BUSY
+
+// Received bytes go to memory on DMA1 stream 0
+#define DMA1_BASE   0x40026000
+#define DMA1_LISR   (*(volatile uint32_t*) (DMA1_BASE + 0x00))
+#define DMA1_LIFCR  (*(volatile uint32_t*) (DMA1_BASE + 0x08))
+#define DMA1_S0CR   (*(volatile uint32_t*) (DMA1_BASE + 0x10))
+#define DMA1_S0NDTR (*(volatile uint32_t*) (DMA1_BASE + 0x14))
+#define DMA1_S0PAR  (*(volatile uint32_t*) (DMA1_BASE + 0x18))
+#define DMA1_S0M0AR (*(volatile uint32_t*) (DMA1_BASE + 0x1C))
+
+// Interrupt masking around the transfer queue (PRIMASK on Cortex-M)
+#if defined(__arm__)
+#define irq_disable() __asm__ volatile("cpsid i" ::: "memory")
+#define irq_enable()  __asm__ volatile("cpsie i" ::: "memory")
+#else
+#define irq_disable() ((void) 0)
+#define irq_enable()  ((void) 0)
+#endif
+
+// A polled transaction spins on a status flag for every byte, roughly
+// 90 us per byte at 100 kHz, and the main loop stalls the whole time.
+// Instead transactions go into a queue and the I2C event interrupt walks
+// each one through start, address, data and stop; received data of two
+// or more bytes goes straight to memory by DMA. When one transaction
+// ends the next starts from the interrupt, so several sensors on the bus
+// are serviced back-to-back while the CPU does other work.
+
+typedef enum
+{
+    I2C_IDLE,       // Never submitted, or finished and collected
+    I2C_QUEUED,
+    I2C_ACTIVE,
+    I2C_DONE,
+    I2C_NACK,       // Device did not acknowledge
+    I2C_BUS_ERROR,  // Bus error or arbitration lost
+} i2c_status_t;
+
+struct i2c_transfer;
+typedef void (*i2c_callback_t)(struct i2c_transfer* transfer);
+
+// One transaction: header (usually the register address) and tx bytes are
+// written, then, after a repeated start, rx_len bytes are read. Any part
+// can be empty, which gives plain writes, plain reads and
+// write-then-read. Owned by the caller and must stay valid, with its
+// buffers, until the status is no longer QUEUED or ACTIVE.
+typedef struct i2c_transfer
+{
+    uint8_t address;  // 7-bit device address
+    uint8_t header[2];
+    uint8_t header_len;
+    const uint8_t* tx;
+    uint16_t tx_len;
+    uint8_t* rx;
+    uint16_t rx_len;
+    i2c_callback_t done;  // Optional; runs in the I2C interrupt
+    void* context;        // For the callback
+    volatile i2c_status_t status;
+    struct i2c_transfer* next;
+} i2c_transfer_t;
+
+static i2c_transfer_t* i2c_queue_head;  // Active transfer, then waiting ones
+static i2c_transfer_t* i2c_queue_tail;
+static uint16_t i2c_tx_index;           // Bytes of header + tx sent
+static bool i2c_reading;                // Past the (repeated) start for rx
+
 // Initialize I2C peripheral
 void i2c_init(void)
 {
@@ -133,47 +511,241 @@ void i2c_init(void)
     I2C_CR1 = 0x0000;  // Disable I2C during configuration
     // Clock control register would be set here (CCR)
 
+    i2c_queue_head = i2c_queue_tail = NULL;
+
+    // Event and error interrupts stay on; buffer interrupts only while a
+    // byte-by-byte phase needs them
+    I2C_CR2 |= I2C_CR2_ITEVTEN | I2C_CR2_ITERREN;
+
     // Enable I2C
-    I2C_CR1 |= 0x0001;
+    I2C_CR1 |= I2C_CR1_PE;
 }
 
-// Write data to I2C device
-bool i2c_write(uint8_t device_addr, uint8_t reg_addr, uint8_t data)
+static void i2c_start_current(void)
 {
-    // Wait until bus is not busy
-    while (I2C_SR2 & 0x0002);  // Assuming bit 1 is BUSY
+    i2c_transfer_t* t = i2c_queue_head;
+    t->status = I2C_ACTIVE;
+    i2c_tx_index = 0;
+    i2c_reading = t->header_len + t->tx_len == 0;
+    I2C_CR1 |= I2C_CR1_ACK | I2C_CR1_START;
+}
 
-    // Generate START condition
-    I2C_CR1 |= 0x0100;  // Assuming bit 8 is START
+// Finish the active transfer and start the next; interrupt context
+static void i2c_complete(i2c_status_t status)
+{
+    i2c_transfer_t* t = i2c_queue_head;
+    I2C_CR2 &= ~(I2C_CR2_ITBUFEN | I2C_CR2_DMAEN | I2C_CR2_LAST);
 
-    // Wait for START to be generated
-    while (!(I2C_SR1 & 0x0001));  // Assuming bit 0 is SB
+    i2c_queue_head = t->next;
+    if (i2c_queue_head == NULL) i2c_queue_tail = NULL;
+    t->next = NULL;
+    t->status = status;
+    if (t->done) t->done(t);
 
-    // Send device address (write mode)
-    I2C_DR = device_addr << 1;  // LSB = 0 for write
+    if (i2c_queue_head != NULL) i2c_start_current();
+}
 
-    // Wait for address to be sent
-    while (!(I2C_SR1 & 0x0002));  // Assuming bit 1 is ADDR
+// Queue a transfer; returns false if it is already queued or running, or
+// has nothing to transfer
+bool i2c_submit(i2c_transfer_t* t)
+{
+    if (t->status == I2C_QUEUED || t->status == I2C_ACTIVE) return false;
+    if (t->header_len + t->tx_len + t->rx_len == 0) return false;
+    t->next = NULL;
+    t->status = I2C_QUEUED;
+
+    irq_disable();
+    bool idle = i2c_queue_head == NULL;
+    if (idle)
+        i2c_queue_head = t;
+    else
+        i2c_queue_tail->next = t;
+    i2c_queue_tail = t;
+    if (idle) i2c_start_current();
+    irq_enable();
+    return true;
+}
 
-    // Clear ADDR flag by reading SR2
-    volatile uint32_t temp = I2C_SR2;
+bool i2c_busy(const i2c_transfer_t* t)
+{
+    return t->status == I2C_QUEUED || t->status == I2C_ACTIVE;
+}
 
-    // Send register address
-    I2C_DR = reg_addr;
-    while (!(I2C_SR1 & 0x0080));  // Assuming bit 7 is TXE
+// Fill in a register write: reg, then len bytes of data
+void i2c_prepare_write(i2c_transfer_t* t,
+                       uint8_t device_addr,
+                       uint8_t reg_addr,
+                       const uint8_t* data,
+                       uint16_t len)
+{
+    t->address = device_addr;
+    t->header[0] = reg_addr;
+    t->header_len = 1;
+    t->tx = data;
+    t->tx_len = len;
+    t->rx = NULL;
+    t->rx_len = 0;
+}
 
-    // Send data
-    I2C_DR = data;
-    while (!(I2C_SR1 & 0x0080));  // Wait for TXE
+// Fill in a burst read of len consecutive registers starting at reg; one
+// transaction instead of one per register (most sensors auto-increment
+// the register address, some need a flag in reg for it)
+void i2c_prepare_read(i2c_transfer_t* t,
+                      uint8_t device_addr,
+                      uint8_t reg_addr,
+                      uint8_t* buffer,
+                      uint16_t len)
+{
+    t->address = device_addr;
+    t->header[0] = reg_addr;
+    t->header_len = 1;
+    t->tx = NULL;
+    t->tx_len = 0;
+    t->rx = buffer;
+    t->rx_len = len;
+}
 
-    // Generate STOP condition
-    I2C_CR1 |= 0x0200;  // Assuming bit 9 is STOP
+static void i2c_start_rx_dma(i2c_transfer_t* t)
+{
+    DMA1_S0CR = 0;
+    DMA1_LIFCR = 0x3D;  // Clear every stream 0 flag
+    DMA1_S0PAR = (uint32_t) (uintptr_t) &I2C_DR;
+    DMA1_S0M0AR = (uint32_t) (uintptr_t) t->rx;
+    DMA1_S0NDTR = t->rx_len;
+    DMA1_S0CR = (1u << 25)   // Assuming bits [27:25] select the I2C1_RX channel
+                | (1u << 10)  // Memory increment
+                | (1u << 4);  // Transfer complete interrupt
+    DMA1_S0CR |= 0x00000001;  // Enable stream
+    I2C_CR2 |= I2C_CR2_DMAEN | I2C_CR2_LAST;
+}
 
-    return true;
+// Event interrupt: advances the active transfer one bus event at a time
+void I2C1_EV_IRQHandler(void)
+{
+    i2c_transfer_t* t = i2c_queue_head;
+    uint32_t sr1 = I2C_SR1;
+    if (t == NULL) return;
+
+    if (sr1 & I2C_SR1_SB)
+    {
+        // Start sent: address with the direction bit
+        I2C_DR = (uint32_t) (t->address << 1) | (i2c_reading ? 1u : 0u);
+        return;
+    }
+
+    if (sr1 & I2C_SR1_ADDR)
+    {
+        if (!i2c_reading)
+        {
+            (void) I2C_SR2;  // Clears ADDR
+            I2C_CR2 |= I2C_CR2_ITBUFEN;
+        }
+        else if (t->rx_len == 1)
+        {
+            // NACK and STOP must be set before ADDR is cleared
+            I2C_CR1 &= ~I2C_CR1_ACK;
+            (void) I2C_SR2;
+            I2C_CR1 |= I2C_CR1_STOP;
+            I2C_CR2 |= I2C_CR2_ITBUFEN;
+        }
+        else
+        {
+            i2c_start_rx_dma(t);
+            (void) I2C_SR2;
+        }
+        return;
+    }
+
+    if (!i2c_reading && (sr1 & (I2C_SR1_TXE | I2C_SR1_BTF)))
+    {
+        uint16_t total = t->header_len + t->tx_len;
+        if (i2c_tx_index < total)
+        {
+            I2C_DR = i2c_tx_index < t->header_len
+                         ? t->header[i2c_tx_index]
+                         : t->tx[i2c_tx_index - t->header_len];
+            i2c_tx_index++;
+        }
+        else if (sr1 & I2C_SR1_BTF)
+        {
+            // Last byte is on the wire; read next or finish
+            I2C_CR2 &= ~I2C_CR2_ITBUFEN;
+            if (t->rx_len > 0)
+            {
+                i2c_reading = true;
+                I2C_CR1 |= I2C_CR1_START;  // Repeated start
+            }
+            else
+            {
+                I2C_CR1 |= I2C_CR1_STOP;
+                i2c_complete(I2C_DONE);
+            }
+        }
+        else
+        {
+            // Everything written; wait for BTF instead of more TXE
+            I2C_CR2 &= ~I2C_CR2_ITBUFEN;
+        }
+        return;
+    }
+
+    if (i2c_reading && (sr1 & I2C_SR1_RXNE) && t->rx_len == 1)
+    {
+        t->rx[0] = (uint8_t) I2C_DR;
+        i2c_complete(I2C_DONE);
+    }
+}
+
+// Error interrupt: release the bus and report the failure
+void I2C1_ER_IRQHandler(void)
+{
+    uint32_t sr1 = I2C_SR1;
+    I2C_SR1 = ~(sr1 & (I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO));
+    DMA1_S0CR &= ~0x00000001u;
+    if (!(sr1 & I2C_SR1_ARLO)) I2C_CR1 |= I2C_CR1_STOP;
+    if (i2c_queue_head != NULL)
+    {
+        i2c_complete(sr1 & I2C_SR1_AF ? I2C_NACK : I2C_BUS_ERROR);
+    }
+}
+
+// DMA1 stream 0: all received bytes are in memory; the hardware NACKed
+// the last one (LAST), so only STOP is left
+void DMA1_Stream0_IRQHandler(void)
+{
+    if (DMA1_LISR & DMA_FLAG_TC)
+    {
+        DMA1_LIFCR = DMA_FLAG_TC;
+        I2C_CR1 |= I2C_CR1_STOP;
+        i2c_complete(I2C_DONE);
+    }
+}
+
+// Write data to I2C device; queues the write and waits for it
+bool i2c_write(uint8_t device_addr, uint8_t reg_addr, uint8_t data)
+{
+    i2c_transfer_t t = {0};
+    i2c_prepare_write(&t, device_addr, reg_addr, &data, 1);
+    i2c_submit(&t);
+    while (i2c_busy(&t));
+    return t.status == I2C_DONE;
 }
 
 /* ---- Main Function ---- */
 
+static int16_t accel_xyz[3];  // Latest accelerometer sample
+
+// Completion callback of the accelerometer read (interrupt context)
+static void accel_decode(i2c_transfer_t* t)
+{
+    if (t->status != I2C_DONE) return;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        accel_xyz[axis] =
+            (int16_t) (t->rx[2 * axis] | (uint16_t) t->rx[2 * axis + 1] << 8);
+    }
+}
+
 int main(void)
 {
     // Initialize peripherals
@@ -181,23 +753,51 @@ int main(void)
     uart_init(9600);  // Initialize UART with 9600 baud
     i2c_init();       // Initialize I2C
 
-    char buffer[50];
+    // Sample temperature plus three other inputs continuously
+    const uint8_t channels[ADC_SCAN_CHANNELS] = {0, 1, 2, 3};
+    adc_scan_start(channels, NULL, NULL);
+
+    static char buffer[50];  // Read by DMA after uart_write_dma returns
+
+    // I2C transfers are reused every pass; their buffers must outlive them
+    static uint8_t eeprom_byte;
+    static uint8_t accel_data[6];
+    static i2c_transfer_t eeprom_write, accel_read;
+    i2c_prepare_write(&eeprom_write, 0x50, 0x10, &eeprom_byte, 1);
+    i2c_prepare_read(&accel_read, 0x1D, 0x28 | 0x80, accel_data, 6);
+    accel_read.done = accel_decode;
     uint16_t adc_value;
 
     // Main loop
     while (1)
     {
-        // Read temperature from ADC
-        adc_value = adc_read(0);
-
-        // Format a message
-        sprintf(buffer, "Temperature ADC: %d\r\n", adc_value);
-
-        // Send via UART
-        uart_puts(buffer);
-
-        // Write to an I2C device (e.g., an external EEPROM)
-        i2c_write(0x50, 0x10, (uint8_t) adc_value);
+        // Average the temperature channel over the newest block instead
+        // of taking one conversion
+        const uint16_t* block;
+        while ((block = adc_scan_next_block()) == NULL);
+        uint32_t sum = 0;
+        for (int i = 0; i < ADC_SCAN_HALF; i += ADC_SCAN_CHANNELS)
+        {
+            sum += block[i];
+        }
+        adc_value = (uint16_t) (sum / (ADC_SCAN_HALF / ADC_SCAN_CHANNELS));
+
+        // Format a message once DMA has finished with the previous one
+        while (uart_tx_dma_busy());
+        int length = sprintf(buffer, "Temperature ADC: %d\r\n", adc_value);
+
+        // Send via UART; the CPU moves on while DMA feeds the line
+        if (!uart_write_dma(buffer, (uint16_t) length)) uart_puts(buffer);
+
+        // Log to an external EEPROM and poll the accelerometer's six
+        // output registers; both run from the I2C interrupt while the
+        // loop carries on, and a transfer still in flight is skipped
+        if (!i2c_busy(&eeprom_write) && !i2c_busy(&accel_read))
+        {
+            eeprom_byte = (uint8_t) adc_value;
+            i2c_submit(&eeprom_write);
+            i2c_submit(&accel_read);
+        }
 
         // Delay
         for (volatile int i = 0; i < 1000000; i++);
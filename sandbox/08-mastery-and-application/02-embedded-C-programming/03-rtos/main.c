@@ -8,17 +8,46 @@
 
 /* ---- Task Management ---- */
 
-#define MAX_TASKS  5
+// Both limits can be overridden on the command line (-DMAX_TASKS=64).
+// Scheduling cost does not depend on either: the highest ready priority
+// is one CLZ on a bitmap and the task to run is the head of that
+// priority's FIFO.
+#ifndef MAX_TASKS
+#define MAX_TASKS 8
+#endif
+#ifndef MAX_PRIORITIES
+#define MAX_PRIORITIES 32  // 0 is highest; the idle task takes the lowest
+#endif
 #define STACK_SIZE 128
 
+_Static_assert(MAX_TASKS >= 2 && MAX_TASKS < 255, "task ids are uint8_t");
+_Static_assert(MAX_PRIORITIES <= 32, "ready bitmap is one 32-bit word");
+
+#define TASK_NONE     0xFF
+#define IDLE_PRIORITY (MAX_PRIORITIES - 1)
+
+typedef enum
+{
+    TASK_READY,    // In its priority's ready list (includes the running task)
+    TASK_DELAYED,  // In the delay queue until wake_tick
+    TASK_BLOCKED   // Waiting on a synchronization object
+} TaskState;
+
 typedef struct
 {
     uint32_t stack[STACK_SIZE];  // Task stack
     uint32_t *sp;                // Stack pointer
     void (*function)(void *);    // Task function
     void *argument;              // Task argument
-    uint8_t priority;            // Task priority (0-highest)
-    bool ready;                  // Task ready state
+    uint8_t priority;            // Task priority (0-highest), inherited
+    uint8_t base_priority;       // Priority the task was created with
+    TaskState state;             // Which list the task is on
+    uint8_t next;                // Next task in its ready, delay or wait list
+    uint32_t wake_tick;          // When a delayed task becomes ready
+    uint64_t run_cycles;         // Cycles spent running
+    uint32_t switches;           // Times the task was switched in
+    struct Mutex *waiting_on;    // Mutex a blocked task waits for, if any
+    struct Mutex *held;          // Mutexes the task owns
 } Task;
 
 // Task control block array
@@ -26,55 +55,322 @@ static Task tasks[MAX_TASKS];
 static uint8_t current_task = 0;
 static uint8_t next_task_id = 0;
 
+// Ready lists: one FIFO per priority, and bit (31 - p) of ready_bitmap set
+// while priority p has a ready task, so the highest ready priority is
+// __builtin_clz(ready_bitmap), a single CLZ instruction on Cortex-M3 and up
+static uint32_t ready_bitmap;
+static uint8_t ready_head[MAX_PRIORITIES];
+static uint8_t ready_tail[MAX_PRIORITIES];
+
+// Delayed tasks sorted by wake_tick, earliest first; the tick handler only
+// ever looks at the head
+static uint8_t delay_head = TASK_NONE;
+
+// Interrupt masking around list updates (PRIMASK on Cortex-M)
+#if defined(__arm__)
+#define enter_critical() __asm__ volatile("cpsid i" ::: "memory")
+#define exit_critical()  __asm__ volatile("cpsie i" ::: "memory")
+#define wait_for_interrupt() __asm__ volatile("wfi" ::: "memory")
+#else
+#define enter_critical()
+#define exit_critical()
+#define wait_for_interrupt()
+#endif
+
+// Empty ready lists; must run before the first task_create
+static void ready_lists_init(void)
+{
+    ready_bitmap = 0;
+    for (int p = 0; p < MAX_PRIORITIES; p++)
+    {
+        ready_head[p] = TASK_NONE;
+        ready_tail[p] = TASK_NONE;
+    }
+}
+
+static void ready_push(uint8_t id)
+{
+    uint8_t p = tasks[id].priority;
+    tasks[id].state = TASK_READY;
+    tasks[id].next = TASK_NONE;
+    if (ready_head[p] == TASK_NONE)
+    {
+        ready_head[p] = id;
+        ready_bitmap |= 1u << (31 - p);
+    }
+    else
+    {
+        tasks[ready_tail[p]].next = id;
+    }
+    ready_tail[p] = id;
+}
+
+// Remove a task from its ready list. The task removed is nearly always
+// the head (the running task), so a singly linked list is enough.
+static void ready_remove(uint8_t id)
+{
+    uint8_t p = tasks[id].priority;
+    uint8_t prev = TASK_NONE;
+    for (uint8_t t = ready_head[p]; t != id; t = tasks[t].next)
+    {
+        if (t == TASK_NONE) return;
+        prev = t;
+    }
+
+    if (prev == TASK_NONE)
+        ready_head[p] = tasks[id].next;
+    else
+        tasks[prev].next = tasks[id].next;
+    if (ready_tail[p] == id) ready_tail[p] = prev;
+    if (ready_head[p] == TASK_NONE) ready_bitmap &= ~(1u << (31 - p));
+}
+
+// Wrap-safe "a is before b" on the 32-bit tick counter
+static inline bool tick_before(uint32_t a, uint32_t b)
+{
+    return (int32_t) (a - b) < 0;
+}
+
+static void delay_insert(uint8_t id, uint32_t wake_tick)
+{
+    tasks[id].state = TASK_DELAYED;
+    tasks[id].wake_tick = wake_tick;
+
+    uint8_t *link = &delay_head;
+    while (*link != TASK_NONE
+           && !tick_before(wake_tick, tasks[*link].wake_tick))
+    {
+        link = &tasks[*link].next;
+    }
+    tasks[id].next = *link;
+    *link = id;
+}
+
+/* ---- Runtime Statistics and Trace ---- */
+
+// Timestamps come from the DWT cycle counter, which costs one load to
+// read. Every context switch charges the cycles since the previous one to
+// the outgoing task, so per-task CPU usage is exact, not sampled.
+#define DEMCR      (*(volatile uint32_t *) 0xE000EDFC)
+#define DWT_CTRL   (*(volatile uint32_t *) 0xE0001000)
+#define DWT_CYCCNT (*(volatile uint32_t *) 0xE0001004)
+
+extern volatile uint32_t system_ticks;
+
+static inline uint32_t cycle_count(void)
+{
+#if defined(__arm__)
+    return DWT_CYCCNT;
+#else
+    return system_ticks;  // No cycle counter off target
+#endif
+}
+
+static void cycle_counter_init(void)
+{
+#if defined(__arm__)
+    DEMCR |= 1u << 24;  // TRCENA: enable DWT
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= 1u;  // CYCCNTENA
+#endif
+}
+
+static uint32_t switched_in_at;  // Cycle count when current_task started
+
+// Trace buffer: with RTOS_TRACE defined, scheduler, interrupt and queue
+// events go into a ring of 8-byte records that overwrites the oldest
+// entry, cheap enough to leave on in the field and dump from a debugger
+// or over UART after something goes wrong. Without it, TRACE() compiles
+// to nothing.
+typedef enum
+{
+    TRACE_SWITCH,         // task = incoming, arg = outgoing
+    TRACE_ISR_ENTER,      // arg = exception number
+    TRACE_ISR_EXIT,       // arg = exception number
+    TRACE_BLOCK,          // task blocked on a wait list
+    TRACE_WAKE,           // task made ready by a give, release or timeout
+    TRACE_INHERIT,        // task raised to priority arg
+    TRACE_QUEUE_SEND,     // arg = low bits of the queue address
+    TRACE_QUEUE_RECEIVE,  // arg = low bits of the queue address
+} TraceType;
+
+typedef struct
+{
+    uint32_t cycles;
+    uint8_t type;  // TraceType
+    uint8_t task;
+    uint16_t arg;
+} TraceEvent;
+
+#ifdef RTOS_TRACE
+#ifndef TRACE_CAPACITY
+#define TRACE_CAPACITY 256  // Power of two
+#endif
+
+static TraceEvent trace_buffer[TRACE_CAPACITY];
+static uint32_t trace_count;  // Events ever written
+
+void trace_record(TraceType type, uint8_t task, uint16_t arg)
+{
+    enter_critical();
+    TraceEvent *event = &trace_buffer[trace_count++ & (TRACE_CAPACITY - 1)];
+    event->cycles = cycle_count();
+    event->type = (uint8_t) type;
+    event->task = task;
+    event->arg = arg;
+    exit_critical();
+}
+
+#define TRACE(type, task, arg) trace_record(type, task, (uint16_t) (arg))
+#else
+#define TRACE(type, task, arg) ((void) 0)
+#endif
+
+// For application interrupt handlers
+#define trace_isr_enter(irq) TRACE(TRACE_ISR_ENTER, current_task, irq)
+#define trace_isr_exit(irq)  TRACE(TRACE_ISR_EXIT, current_task, irq)
+
+// Charge the running time to the outgoing task and record the switch
+static void account_switch(uint8_t from, uint8_t to)
+{
+    uint32_t now = cycle_count();
+    tasks[from].run_cycles += now - switched_in_at;
+    tasks[to].switches++;
+    switched_in_at = now;
+    TRACE(TRACE_SWITCH, to, from);
+}
+
+// Stacks are filled with a pattern at creation; the deepest word that no
+// longer holds it marks the most the task has ever used
+#define STACK_PAINT 0xA5A5A5A5u
+
+static void stack_paint(Task *task)
+{
+    for (int i = 0; i < STACK_SIZE; i++) task->stack[i] = STACK_PAINT;
+}
+
+// Words of the task's stack that have never been touched
+uint32_t task_stack_free(uint8_t id)
+{
+    uint32_t words = 0;
+    while (words < STACK_SIZE && tasks[id].stack[words] == STACK_PAINT)
+    {
+        words++;
+    }
+    return words;
+}
+
 // Initialize a task
 uint8_t task_create(void (*task_func)(void *), void *arg, uint8_t priority)
 {
-    if (next_task_id >= MAX_TASKS)
+    if (next_task_id >= MAX_TASKS || priority >= MAX_PRIORITIES)
     {
-        return 0xFF;  // Error: task limit reached
+        return TASK_NONE;  // Error: task limit reached or bad priority
     }
 
     uint8_t task_id = next_task_id++;
+    Task *task = &tasks[task_id];
 
-    tasks[task_id].function = task_func;
-    tasks[task_id].argument = arg;
-    tasks[task_id].priority = priority;
-    tasks[task_id].ready = true;
+    task->function = task_func;
+    task->argument = arg;
+    task->priority = priority;
+    task->base_priority = priority;
+    task->waiting_on = NULL;
+    task->held = NULL;
+    task->run_cycles = 0;
+    task->switches = 0;
+    stack_paint(task);
 
-    // Initialize stack (simplified, architecture dependent)
-    // In a real implementation, this would set up stack frame for context switching
-    tasks[task_id].sp = &tasks[task_id].stack[STACK_SIZE - 16];
+    // Initial frame as if the task had been interrupted just before its
+    // first instruction: R4-R11 for PendSV_Handler to restore, then the
+    // registers the core unstacks on exception return (R0-R3, R12, LR,
+    // PC, xPSR)
+    uint32_t *frame = &task->stack[STACK_SIZE - 16];
+    for (int i = 0; i < 16; i++) frame[i] = 0;
+    frame[8] = (uint32_t) (uintptr_t) arg;         // R0
+    frame[14] = (uint32_t) (uintptr_t) task_func;  // PC
+    frame[15] = 0x01000000;                        // xPSR: Thumb bit
+    task->sp = frame;
 
+    enter_critical();
+    ready_push(task_id);
+    exit_critical();
     return task_id;
 }
 
-// Simple task scheduler (priority-based)
-void scheduler(void)
+// Highest-priority ready task, O(1). The idle task is always ready, so the
+// bitmap is never empty once the scheduler runs.
+static inline uint8_t highest_ready_task(void)
 {
-    uint8_t highest_priority = 0xFF;
-    uint8_t task_to_run = current_task;
+    return ready_head[__builtin_clz(ready_bitmap)];
+}
 
-    // Find highest priority ready task
-    for (uint8_t i = 0; i < next_task_id; i++)
-    {
-        if (tasks[i].ready && tasks[i].priority < highest_priority)
-        {
-            highest_priority = tasks[i].priority;
-            task_to_run = i;
-        }
-    }
+/* ---- Context Switching ---- */
+
+// The switch itself happens in PendSV, the lowest-priority exception, so
+// it runs only after every other interrupt has finished. Anything that
+// changes the ready lists just pends it.
+#define SCB_ICSR       (*(volatile uint32_t *) 0xE000ED04)
+#define ICSR_PENDSVSET (1u << 28)
+
+static volatile uint8_t switch_to = TASK_NONE;
+
+// Pick the task to run; called with interrupts masked
+void scheduler(void)
+{
+    uint8_t task_to_run = highest_ready_task();
 
     if (task_to_run != current_task)
     {
-        // Save context of current task and load context of new task
-        // This would involve architecture-specific context switching code
-        // (registers, stack pointer, program counter, etc.)
-
-        // For demonstration only:
+        switch_to = task_to_run;
+#if defined(__arm__)
+        SCB_ICSR = ICSR_PENDSVSET;
+#else
+        // No PendSV off target: switch bookkeeping only
+        account_switch(current_task, task_to_run);
         current_task = task_to_run;
+#endif
     }
 }
 
+// Give up the CPU; the current task keeps running if nothing of higher
+// priority is ready
+void task_yield(void)
+{
+    enter_critical();
+    scheduler();
+    exit_critical();
+}
+
+// Called from PendSV_Handler with the outgoing SP; returns the incoming SP
+uint32_t *rtos_switch_stack(uint32_t *sp)
+{
+    tasks[current_task].sp = sp;
+    account_switch(current_task, switch_to);
+    current_task = switch_to;
+    switch_to = TASK_NONE;
+    return tasks[current_task].sp;
+}
+
+#if defined(__arm__) && (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
+// Save R4-R11 of the outgoing task on its stack (the core pushed the rest
+// on exception entry), swap stack pointers, restore the incoming task's
+// R4-R11 and return into it on the process stack
+__attribute__((naked)) void PendSV_Handler(void)
+{
+    __asm__ volatile(
+        "cpsid   i                 \n"
+        "mrs     r0, psp           \n"
+        "stmdb   r0!, {r4-r11}     \n"
+        "bl      rtos_switch_stack \n"
+        "ldmia   r0!, {r4-r11}     \n"
+        "msr     psp, r0           \n"
+        "cpsie   i                 \n"
+        "ldr     lr, =0xFFFFFFFD   \n"  // Thread mode, process stack
+        "bx      lr                \n");
+}
+#endif
+
 /* ---- Timing and Deadlines ---- */
 
 // System tick counter
@@ -83,10 +379,32 @@ volatile uint32_t system_ticks = 0;
 // Tick interrupt handler
 void SysTick_Handler(void)
 {
+    trace_isr_enter(15);
+    enter_critical();
     system_ticks++;
 
-    // Run scheduler on every tick
+    // Wake every delayed task that is due; the queue is sorted, so this
+    // stops at the first one that is not
+    while (delay_head != TASK_NONE
+           && !tick_before(system_ticks, tasks[delay_head].wake_tick))
+    {
+        uint8_t id = delay_head;
+        delay_head = tasks[id].next;
+        ready_push(id);
+        TRACE(TRACE_WAKE, id, 0);
+    }
+
+    // Round-robin between tasks of the running task's priority
+    if (tasks[current_task].state == TASK_READY
+        && tasks[current_task].next != TASK_NONE)
+    {
+        ready_remove(current_task);
+        ready_push(current_task);
+    }
+
     scheduler();
+    exit_critical();
+    trace_isr_exit(15);
 }
 
 // Get current system time
@@ -95,70 +413,478 @@ uint32_t get_time_ms(void)
     return system_ticks;
 }
 
-// Sleep for specified number of milliseconds
+// Block the calling task for the specified number of milliseconds; other
+// tasks run meanwhile
 void task_delay(uint32_t ms)
 {
-    uint32_t start = get_time_ms();
-    while (get_time_ms() - start < ms)
+    if (ms == 0)
     {
-        // In a real RTOS, this would yield to other tasks
-        // by triggering context switch
+        task_yield();
+        return;
     }
+
+    enter_critical();
+    ready_remove(current_task);
+    delay_insert(current_task, system_ticks + ms);
+    scheduler();
+    exit_critical();
+}
+
+/* ---- Idle Task and Tickless Idle ---- */
+
+// SysTick registers
+#define SYST_CSR (*(volatile uint32_t *) 0xE000E010)  // Control and status
+#define SYST_RVR (*(volatile uint32_t *) 0xE000E014)  // Reload value
+#define SYST_CVR (*(volatile uint32_t *) 0xE000E018)  // Current value
+#define SYSTICK_MAX_RELOAD 0x00FFFFFF               // 24-bit counter
+
+static uint32_t cycles_per_tick;
+
+#ifdef RTOS_TICKLESS_IDLE
+// With nothing but idle ready, stop the 1 ms tick, program a single
+// SysTick period that ends when the first delayed task is due, sleep, and
+// credit the ticks that passed. An idle system then wakes once per delay
+// instead of once per millisecond.
+static void tickless_sleep(void)
+{
+    enter_critical();
+    uint32_t idle_only = 1u << (31 - IDLE_PRIORITY);
+    if (delay_head == TASK_NONE || ready_bitmap != idle_only)
+    {
+        exit_critical();
+        return;
+    }
+
+    uint32_t idle_ticks = tasks[delay_head].wake_tick - system_ticks - 1;
+    uint32_t max_ticks = SYSTICK_MAX_RELOAD / cycles_per_tick - 1;
+    if (idle_ticks > max_ticks) idle_ticks = max_ticks;
+    if (idle_ticks == 0)
+    {
+        exit_critical();
+        return;
+    }
+
+    SYST_CSR &= ~1u;  // Stop the counter
+    SYST_RVR = SYST_CVR + idle_ticks * cycles_per_tick;
+    SYST_CVR = 0;
+    SYST_CSR |= 1u;
+
+    // WFI wakes on a pending interrupt even with PRIMASK set, so the tick
+    // cannot be lost between the check above and going to sleep
+    wait_for_interrupt();
+
+    SYST_CSR &= ~1u;
+    uint32_t elapsed = (SYST_RVR - SYST_CVR) / cycles_per_tick;
+    system_ticks += elapsed < idle_ticks ? elapsed : idle_ticks;
+    SYST_RVR = cycles_per_tick - 1;
+    SYST_CVR = 0;
+    SYST_CSR |= 1u;
+    exit_critical();
+}
+#endif
+
+// Lowest-priority task; keeps the ready bitmap non-empty
+static void idle_task(void *arg)
+{
+    (void) arg;
+    while (1)
+    {
+#ifdef RTOS_TICKLESS_IDLE
+        tickless_sleep();
+#else
+        wait_for_interrupt();  // Sleep until the next interrupt
+#endif
+    }
+}
+
+// Create the idle task, start the 1 ms tick and enter the highest-priority
+// task; does not return on target
+void rtos_start(uint32_t core_clock_hz)
+{
+    task_create(idle_task, NULL, IDLE_PRIORITY);
+    cycles_per_tick = core_clock_hz / 1000;
+    current_task = highest_ready_task();
+    cycle_counter_init();
+    switched_in_at = cycle_count();
+
+#if defined(__arm__)
+    SYST_RVR = cycles_per_tick - 1;
+    SYST_CVR = 0;
+    SYST_CSR = 0x07;  // Core clock, interrupt enabled, counter enabled
+#endif
+
+#if defined(__arm__) && (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
+    // Drop the prepared frame, move thread mode onto the task's process
+    // stack and call it directly; later switches go through PendSV
+    uint32_t *sp = tasks[current_task].sp + 16;
+    __asm__ volatile(
+        "msr  psp, %0     \n"
+        "movs r0, #2      \n"
+        "msr  control, r0 \n"
+        "isb              \n"
+        :
+        : "r"(sp)
+        : "r0", "memory");
+    tasks[current_task].function(tasks[current_task].argument);
+#endif
 }
 
 /* ---- Synchronization Primitives ---- */
 
-// Mutex implementation
+// Tasks waiting on an object, highest priority first and FIFO among
+// equals, linked through Task.next like the ready lists
 typedef struct
 {
-    bool locked;
-    uint8_t owner;
+    uint8_t head;
+} WaitList;
+
+static void wait_list_insert(WaitList *list, uint8_t id)
+{
+    uint8_t *link = &list->head;
+    while (*link != TASK_NONE
+           && tasks[*link].priority <= tasks[id].priority)
+    {
+        link = &tasks[*link].next;
+    }
+    tasks[id].next = *link;
+    *link = id;
+}
+
+static void wait_list_remove(WaitList *list, uint8_t id)
+{
+    for (uint8_t *link = &list->head; *link != TASK_NONE;
+         link = &tasks[*link].next)
+    {
+        if (*link == id)
+        {
+            *link = tasks[id].next;
+            return;
+        }
+    }
+}
+
+// Move the current task from the ready lists onto list; the switch
+// happens once the caller leaves its critical section
+static void block_current(WaitList *list)
+{
+    ready_remove(current_task);
+    tasks[current_task].state = TASK_BLOCKED;
+    wait_list_insert(list, current_task);
+    TRACE(TRACE_BLOCK, current_task, 0);
+    scheduler();
+}
+
+// Make the first waiter ready; returns it, or TASK_NONE if there was none
+static uint8_t wake_first(WaitList *list)
+{
+    uint8_t id = list->head;
+    if (id != TASK_NONE)
+    {
+        list->head = tasks[id].next;
+        ready_push(id);
+        TRACE(TRACE_WAKE, id, 0);
+    }
+    return id;
+}
+
+// Mutex with priority inheritance. While a task waits, the owner runs at
+// the waiter's priority (and so does the owner's own blocker, along the
+// chain), so a medium-priority task can no longer keep a low-priority
+// owner off the CPU while a high-priority task waits. Release hands the
+// mutex straight to the highest waiter.
+typedef struct Mutex
+{
+    uint8_t owner;              // TASK_NONE when free
+    WaitList waiters;
+    struct Mutex *next_held;    // Other mutexes held by the same owner
 } Mutex;
 
+// Change a task's effective priority, keeping whatever list it is on in
+// order
+static void task_set_priority(uint8_t id, uint8_t priority)
+{
+    Task *task = &tasks[id];
+    if (task->priority == priority) return;
+
+    if (task->state == TASK_READY)
+    {
+        ready_remove(id);
+        task->priority = priority;
+        ready_push(id);
+    }
+    else if (task->state == TASK_BLOCKED && task->waiting_on != NULL)
+    {
+        wait_list_remove(&task->waiting_on->waiters, id);
+        task->priority = priority;
+        wait_list_insert(&task->waiting_on->waiters, id);
+    }
+    else
+    {
+        task->priority = priority;
+    }
+}
+
 // Initialize mutex
 void mutex_init(Mutex *mutex)
 {
-    mutex->locked = false;
-    mutex->owner = 0xFF;  // Invalid task ID
+    mutex->owner = TASK_NONE;
+    mutex->waiters.head = TASK_NONE;
+    mutex->next_held = NULL;
+}
+
+static void mutex_take(Mutex *mutex, uint8_t id)
+{
+    mutex->owner = id;
+    mutex->next_held = tasks[id].held;
+    tasks[id].held = mutex;
 }
 
-// Acquire mutex (blocking)
+// Acquire mutex, blocking while another task owns it
 void mutex_acquire(Mutex *mutex)
 {
-    // Disable interrupts for atomic operation
-    // In real code: __disable_irq();
+    enter_critical();
 
-    while (mutex->locked)
+    if (mutex->owner == TASK_NONE)
     {
-        // In a real RTOS, we'd block the task here
-        // and re-enable interrupts while waiting
-
-        // For demonstration, just spin (BAD practice!)
+        mutex_take(mutex, current_task);
+        exit_critical();
+        return;
     }
 
-    mutex->locked = true;
-    mutex->owner = current_task;
+    // Lend our priority to the owner, and on to whatever it waits for
+    uint8_t priority = tasks[current_task].priority;
+    for (Mutex *m = mutex; m != NULL && m->owner != TASK_NONE;)
+    {
+        Task *owner = &tasks[m->owner];
+        if (owner->priority <= priority) break;
+        task_set_priority(m->owner, priority);
+        TRACE(TRACE_INHERIT, m->owner, priority);
+        m = owner->state == TASK_BLOCKED ? owner->waiting_on : NULL;
+    }
 
-    // Re-enable interrupts
-    // In real code: __enable_irq();
+    tasks[current_task].waiting_on = mutex;
+    block_current(&mutex->waiters);
+    exit_critical();
+    // Resumes here as the owner: mutex_release handed the mutex over
 }
 
-// Release mutex
+// Release mutex; only the owner may
 void mutex_release(Mutex *mutex)
 {
-    // Disable interrupts for atomic operation
-    // In real code: __disable_irq();
+    enter_critical();
+
+    Task *self = &tasks[current_task];
+    if (mutex->owner != current_task)
+    {
+        exit_critical();
+        return;
+    }
+
+    for (Mutex **link = &self->held; *link != NULL;
+         link = &(*link)->next_held)
+    {
+        if (*link == mutex)
+        {
+            *link = mutex->next_held;
+            break;
+        }
+    }
+
+    // Drop back to the highest priority still owed to us
+    uint8_t priority = self->base_priority;
+    for (Mutex *m = self->held; m != NULL; m = m->next_held)
+    {
+        uint8_t waiter = m->waiters.head;
+        if (waiter != TASK_NONE && tasks[waiter].priority < priority)
+        {
+            priority = tasks[waiter].priority;
+        }
+    }
+    task_set_priority(current_task, priority);
 
-    if (mutex->owner == current_task)
+    uint8_t next = wake_first(&mutex->waiters);
+    mutex->owner = TASK_NONE;
+    if (next != TASK_NONE)
     {
-        mutex->locked = false;
-        mutex->owner = 0xFF;
+        tasks[next].waiting_on = NULL;
+        mutex_take(mutex, next);
     }
 
-    // Re-enable interrupts
-    // In real code: __enable_irq();
+    scheduler();
+    exit_critical();
+}
+
+// Counting semaphore. sem_give and sem_try_take are safe in interrupt
+// handlers; a give with a task waiting hands the unit straight to it.
+typedef struct
+{
+    uint32_t count;
+    WaitList waiters;
+} Semaphore;
+
+void sem_init(Semaphore *sem, uint32_t initial)
+{
+    sem->count = initial;
+    sem->waiters.head = TASK_NONE;
+}
+
+bool sem_try_take(Semaphore *sem)
+{
+    enter_critical();
+    bool taken = sem->count > 0;
+    if (taken) sem->count--;
+    exit_critical();
+    return taken;
+}
+
+// Take one unit, blocking until one is available
+void sem_take(Semaphore *sem)
+{
+    enter_critical();
+    if (sem->count > 0)
+    {
+        sem->count--;
+    }
+    else
+    {
+        tasks[current_task].waiting_on = NULL;
+        block_current(&sem->waiters);
+    }
+    exit_critical();
 }
 
+void sem_give(Semaphore *sem)
+{
+    enter_critical();
+    if (wake_first(&sem->waiters) == TASK_NONE) sem->count++;
+    scheduler();
+    exit_critical();
+}
+
+// Zero-copy message queue: a ring of pointers, so sending a message moves
+// one word however large the message is. Each queue has one producer and
+// one consumer (a task or an interrupt handler), which lets the ring run
+// without locks: only the producer writes head and only the consumer
+// writes tail. The two semaphores count filled and free slots and are
+// what blocked tasks sleep on; the try_ variants never block and are the
+// ones to call from interrupt handlers.
+#define MSG_QUEUE_CAPACITY 8  // Power of two
+
+typedef struct
+{
+    void *slots[MSG_QUEUE_CAPACITY];
+    volatile uint32_t head;  // Next slot to fill
+    volatile uint32_t tail;  // Next slot to drain
+    Semaphore filled;
+    Semaphore free;
+} MsgQueue;
+
+void msg_queue_init(MsgQueue *queue)
+{
+    queue->head = 0;
+    queue->tail = 0;
+    sem_init(&queue->filled, 0);
+    sem_init(&queue->free, MSG_QUEUE_CAPACITY);
+}
+
+static void msg_queue_put(MsgQueue *queue, void *message)
+{
+    queue->slots[queue->head % MSG_QUEUE_CAPACITY] = message;
+    __atomic_thread_fence(__ATOMIC_RELEASE);  // Slot before index
+    queue->head = queue->head + 1;
+    TRACE(TRACE_QUEUE_SEND, current_task, (uintptr_t) queue);
+    sem_give(&queue->filled);
+}
+
+static void *msg_queue_get(MsgQueue *queue)
+{
+    void *message = queue->slots[queue->tail % MSG_QUEUE_CAPACITY];
+    __atomic_thread_fence(__ATOMIC_RELEASE);  // Read before freeing slot
+    queue->tail = queue->tail + 1;
+    TRACE(TRACE_QUEUE_RECEIVE, current_task, (uintptr_t) queue);
+    sem_give(&queue->free);
+    return message;
+}
+
+// Queue a message; false if the queue is full
+bool msg_queue_try_send(MsgQueue *queue, void *message)
+{
+    if (!sem_try_take(&queue->free)) return false;
+    msg_queue_put(queue, message);
+    return true;
+}
+
+// Queue a message, blocking while the queue is full
+void msg_queue_send(MsgQueue *queue, void *message)
+{
+    sem_take(&queue->free);
+    msg_queue_put(queue, message);
+}
+
+// Next message, or NULL if the queue is empty
+void *msg_queue_try_receive(MsgQueue *queue)
+{
+    if (!sem_try_take(&queue->filled)) return NULL;
+    return msg_queue_get(queue);
+}
+
+// Next message, blocking while the queue is empty
+void *msg_queue_receive(MsgQueue *queue)
+{
+    sem_take(&queue->filled);
+    return msg_queue_get(queue);
+}
+
+/* ---- Reporting ---- */
+
+// Per-task CPU share, switch count and stack headroom since start-up
+void rtos_print_stats(void)
+{
+    uint64_t total = 0;
+    for (uint8_t i = 0; i < next_task_id; i++) total += tasks[i].run_cycles;
+
+    printf("task prio  cpu%%   switches  stack used/free (words)\n");
+    for (uint8_t i = 0; i < next_task_id; i++)
+    {
+        uint32_t free_words = task_stack_free(i);
+        printf("%4u %4u %5.1f %10lu  %u/%lu\n",
+               i,
+               tasks[i].base_priority,
+               total ? 100.0 * tasks[i].run_cycles / total : 0.0,
+               (unsigned long) tasks[i].switches,
+               STACK_SIZE - free_words,
+               (unsigned long) free_words);
+    }
+}
+
+#ifdef RTOS_TRACE
+// Oldest to newest; cycle deltas wrap correctly across counter overflow
+void trace_dump(void)
+{
+    static const char *names[] = {"switch",
+                                  "isr-enter",
+                                  "isr-exit",
+                                  "block",
+                                  "wake",
+                                  "inherit",
+                                  "send",
+                                  "receive"};
+    uint32_t first = trace_count > TRACE_CAPACITY ? trace_count - TRACE_CAPACITY
+                                                  : 0;
+    uint32_t previous = trace_buffer[first & (TRACE_CAPACITY - 1)].cycles;
+    for (uint32_t n = first; n < trace_count; n++)
+    {
+        const TraceEvent *event = &trace_buffer[n & (TRACE_CAPACITY - 1)];
+        printf("+%8lu %-10s task %u arg %u\n",
+               (unsigned long) (event->cycles - previous),
+               names[event->type],
+               event->task,
+               event->arg);
+        previous = event->cycles;
+    }
+}
+#endif
+
 /* ---- Example Tasks ---- */
 
 // Example mutex for shared resource
@@ -182,6 +908,53 @@ void led_task(void *arg)
     }
 }
 
+// Samples travel from sensor_task to control_task by pointer: the sensor
+// takes an empty buffer from free_samples, fills it and sends it on
+// sample_queue; the consumer hands it back when done. Nothing is copied
+// and neither side polls.
+typedef struct
+{
+    uint32_t timestamp;
+    uint16_t value;
+} SensorSample;
+
+static SensorSample sample_pool[MSG_QUEUE_CAPACITY];
+static MsgQueue free_samples;
+static MsgQueue sample_queue;
+
+static void sample_queues_init(void)
+{
+    msg_queue_init(&free_samples);
+    msg_queue_init(&sample_queue);
+
+    // Runs before rtos_start, with no task ready, so the ring is filled
+    // directly: msg_queue_try_send would give the semaphore and so call
+    // the scheduler
+    for (int i = 0; i < MSG_QUEUE_CAPACITY; i++)
+    {
+        free_samples.slots[i] = &sample_pool[i];
+    }
+    free_samples.head = MSG_QUEUE_CAPACITY;
+    sem_init(&free_samples.filled, MSG_QUEUE_CAPACITY);
+    sem_init(&free_samples.free, 0);
+}
+
+// Control loop: blocks until a sample arrives
+void control_task(void *arg)
+{
+    (void) arg;
+
+    while (1)
+    {
+        SensorSample *sample = msg_queue_receive(&sample_queue);
+
+        // Run the control law on sample->value
+        // ...
+
+        msg_queue_send(&free_samples, sample);
+    }
+}
+
 // Sensor reading task with deadline
 void sensor_task(void *arg)
 {
@@ -195,8 +968,16 @@ void sensor_task(void *arg)
         // Read sensor (simulated with delay)
         uint16_t sensor_value = 123;  // Placeholder value
 
-        // Process sensor data
-        // ...
+        // Hand the sample to the control loop. If the consumer has fallen
+        // so far behind that no buffer is free, drop the sample rather
+        // than miss the deadline.
+        SensorSample *sample = msg_queue_try_receive(&free_samples);
+        if (sample != NULL)
+        {
+            sample->timestamp = start_time;
+            sample->value = sensor_value;
+            msg_queue_send(&sample_queue, sample);
+        }
 
         mutex_acquire(&uart_mutex);
         // uart_puts("Sensor read\r\n");
@@ -235,8 +1016,10 @@ int main(void)
     // setup_clocks();
     // setup_systick();
 
-    // Initialize synchronization primitives
+    // Initialize scheduler and synchronization primitives
+    ready_lists_init();
     mutex_init(&uart_mutex);
+    sample_queues_init();
 
     // Create tasks
     uint8_t led1_pin = 0;
@@ -244,15 +1027,14 @@ int main(void)
     task_create(led_task, &led1_pin, 2);  // Lower priority
     task_create(led_task, &led2_pin, 2);
     task_create(sensor_task, NULL, 1);  // Higher priority
+    task_create(control_task, NULL, 0);  // Highest: runs as samples arrive
 
     // Start scheduler
-    // start_systick();
+    rtos_start(16000000);  // 16 MHz core clock
 
     // This point should never be reached if scheduler is running
     while (1)
     {
-        // Idle task
-        // Could implement power saving here
     }
 
     return 0;
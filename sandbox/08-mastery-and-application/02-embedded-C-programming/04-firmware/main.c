@@ -1,6 +1,7 @@
 /* firmware_example.c - Firmware and bootloader concepts */
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 /* ---- Flash Memory Operations ---- */
 
@@ -92,12 +93,128 @@ bool flash_program_word(uint32_t address, uint32_t data)
     return (*(volatile uint32_t *) address == data);
 }
 
+// Flash status and control bits
+#define FLASH_SR_BSY      0x00000001  // Operation in progress
+#define FLASH_SR_PGERR    0x00000004  // Programming error (target not erased)
+#define FLASH_SR_WRPRTERR 0x00000010  // Write protection error
+#define FLASH_SR_EOP      0x00000020  // End of operation
+#define FLASH_CR_PG       0x00000001  // Programming
+#define FLASH_CR_PER      0x00000002  // Page erase
+#define FLASH_CR_STRT     0x00000040  // Start erase
+
+#define FLASH_PAGE_SIZE 0x800  // Assuming 2KB pages
+
+// Start erasing a page and return without waiting, so the caller can do
+// other work (receive the next chunk) while the erase runs
+bool flash_start_erase(uint32_t page_address)
+{
+    if (FLASH_SR & FLASH_SR_BSY) return false;
+
+    FLASH_CR |= FLASH_CR_PER;
+    FLASH_AR = page_address;
+    FLASH_CR |= FLASH_CR_STRT;
+    return true;
+}
+
+// True while an erase or program operation is running
+static inline bool flash_busy(void)
+{
+    return (FLASH_SR & FLASH_SR_BSY) != 0;
+}
+
+// Finish an erase started by flash_start_erase
+void flash_finish_erase(void)
+{
+    flash_wait_for_complete();
+    FLASH_CR &= ~FLASH_CR_PER;
+}
+
+// Program a block of words as double-words. Compared with calling
+// flash_program_word per word, PG is set once for the whole block, each
+// busy-wait covers eight bytes, double-words that are still in the erased
+// state (all ones) are skipped, and the block is verified in one pass at
+// the end instead of re-reading after every write.
+bool flash_program_block(uint32_t address, const uint32_t *data, uint32_t words)
+{
+    if (address % 8 != 0 || words % 2 != 0) return false;
+
+    flash_wait_for_complete();  // An erase may still be running
+    FLASH_SR = FLASH_SR_PGERR | FLASH_SR_WRPRTERR | FLASH_SR_EOP;
+    FLASH_CR |= FLASH_CR_PG;
+
+    volatile uint32_t *dst = (volatile uint32_t *) address;
+    for (uint32_t i = 0; i < words; i += 2)
+    {
+        if (data[i] == 0xFFFFFFFF && data[i + 1] == 0xFFFFFFFF) continue;
+
+        dst[i] = data[i];
+        dst[i + 1] = data[i + 1];
+        flash_wait_for_complete();
+    }
+
+    FLASH_CR &= ~FLASH_CR_PG;
+    if (FLASH_SR & (FLASH_SR_PGERR | FLASH_SR_WRPRTERR)) return false;
+
+    for (uint32_t i = 0; i < words; i++)
+    {
+        if (dst[i] != data[i]) return false;
+    }
+    return true;
+}
+
+/* ---- Image Checksum ---- */
+
+// CRC-32 (IEEE 802.3, reflected, polynomial 0xEDB88320) updated
+// incrementally, so an image can be checked chunk by chunk as it is
+// written instead of in a second pass over flash. Slicing-by-8 looks up
+// eight table entries per 8 bytes instead of eight dependent steps of one
+// byte each, about 5x faster than the bytewise loop. Its 8KB of tables
+// are computed by the compiler (const_tables.h), so they stay in flash
+// instead of taking RAM and a fill loop at boot; cores with the ARMv8
+// CRC32 instructions use those instead.
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#else
+#include "../../../06-professional-devlopment/01-advanced-C-features/const_tables.h"
+#endif
+
+// Continue a CRC over length more bytes. Start with crc = 0; the result
+// of one call is the crc argument of the next.
+uint32_t crc32_update(uint32_t crc, const void *data, uint32_t length)
+{
+#if defined(__ARM_FEATURE_CRC32)
+    const uint8_t *p = (const uint8_t *) data;
+    crc = ~crc;
+    for (; length >= 4; length -= 4, p += 4)
+    {
+        uint32_t word;
+        memcpy(&word, p, 4);
+        crc = __crc32w(crc, word);
+    }
+    for (; length > 0; length--) crc = __crc32b(crc, *p++);
+    return ~crc;
+#else
+    return table_crc32_update(crc, data, length);
+#endif
+}
+
 /* ---- Bootloader Concepts ---- */
 
 // Memory map definitions
 #define BOOTLOADER_ADDR  0x08000000  // Bootloader start address
-#define APPLICATION_ADDR 0x08010000  // Application start address
+#define APPLICATION_ADDR 0x08010000  // Application start address (slot A)
 #define BOOTLOADER_SIZE  0x00010000  // 64KB bootloader size
+#define UPDATE_INFO_ADDR 0x08020000  // Staged update: info, then image
+
+// A/B slots: an update is written to the slot that is not running, so a
+// failed or interrupted update leaves the old image bootable. Each image
+// is linked for its own slot's address. The last page of a slot holds its
+// descriptor.
+#define SLOT_A_ADDR APPLICATION_ADDR
+#define SLOT_B_ADDR 0x08030000
+#define SLOT_SIZE   0x00010000
+#define SLOT_IMAGE_MAX (SLOT_SIZE - FLASH_PAGE_SIZE)
+#define SLOT_DESCRIPTOR(slot) ((slot) + SLOT_SIZE - FLASH_PAGE_SIZE)
 
 // Magic value to indicate firmware update is pending
 #define UPDATE_PENDING_MAGIC 0xBEEFCAFE
@@ -111,11 +228,166 @@ typedef struct
     uint32_t version;   // Version number
 } FirmwareUpdateInfo;
 
-// Bootloader jump to application
-void jump_to_application(void)
+#define SLOT_MAGIC       0x534C4F54  // "SLOT"
+#define SLOT_CONFIRMED   0xC0FFEE00
+#define BOOT_MAX_ATTEMPTS 3
+
+// Flash bits can only be cleared between erases, so every marker that is
+// written after the descriptor gets a double-word of its own and is
+// programmed exactly once
+typedef struct
+{
+    uint32_t value;
+    uint32_t unused;
+} FlashMarker;
+
+// Written once the whole image is in flash and its CRC matched, so the
+// descriptor's presence means "verified"; booting does not re-read the
+// image
+typedef struct
+{
+    uint32_t magic;       // SLOT_MAGIC
+    uint32_t image_size;  // Bytes
+    uint32_t image_crc;   // CRC-32 of the image
+    uint32_t version;
+    uint32_t sequence;    // Higher is newer
+    uint32_t reserved;
+    FlashMarker attempts[BOOT_MAX_ATTEMPTS];  // One cleared per trial boot
+    FlashMarker confirmed;  // SLOT_CONFIRMED once the image checked in
+} SlotDescriptor;
+
+static const SlotDescriptor *slot_descriptor(uint32_t slot)
+{
+    return (const SlotDescriptor *) SLOT_DESCRIPTOR(slot);
+}
+
+// Plausible vector table: initial SP in RAM, reset handler inside the slot
+static bool slot_vectors_valid(uint32_t slot)
+{
+    uint32_t sp = *(volatile uint32_t *) slot;
+    uint32_t reset = *(volatile uint32_t *) (slot + 4);
+    return (sp & 0xFFF00000) == 0x20000000 && reset >= slot
+           && reset < slot + SLOT_IMAGE_MAX;
+}
+
+static bool slot_has_image(uint32_t slot)
+{
+    const SlotDescriptor *desc = slot_descriptor(slot);
+    return desc->magic == SLOT_MAGIC && desc->image_size <= SLOT_IMAGE_MAX
+           && slot_vectors_valid(slot);
+}
+
+static bool slot_confirmed(uint32_t slot)
+{
+    return slot_descriptor(slot)->confirmed.value == SLOT_CONFIRMED;
+}
+
+static uint32_t slot_attempts_used(uint32_t slot)
+{
+    uint32_t used = 0;
+    while (used < BOOT_MAX_ATTEMPTS
+           && slot_descriptor(slot)->attempts[used].value != 0xFFFFFFFF)
+    {
+        used++;
+    }
+    return used;
+}
+
+static bool program_marker(const FlashMarker *marker, uint32_t value)
+{
+    uint32_t words[2] = {value, 0xFFFFFFFF};
+    flash_unlock();
+    bool ok = flash_program_block((uint32_t) (uintptr_t) marker, words, 2);
+    flash_lock();
+    return ok;
+}
+
+// Check if the application in a slot is valid. The descriptor is only
+// written after the CRC matched, so by default this is a few reads; with
+// BOOT_FULL_VERIFY the image CRC is recomputed as well (guards against
+// flash that has degraded since it was written, at the cost of reading
+// the whole image on every cold boot).
+bool is_application_valid(uint32_t slot)
+{
+    if (!slot_has_image(slot)) return false;
+
+#ifdef BOOT_FULL_VERIFY
+    const SlotDescriptor *desc = slot_descriptor(slot);
+    uint32_t crc = crc32_update(0, (const void *) slot, desc->image_size);
+    if (crc != desc->image_crc) return false;
+#endif
+
+    return true;
+}
+
+// How much select_boot_slot would want a slot: 2 confirmed, 1 on trial
+// with attempts left, 0 not bootable at all
+static int slot_boot_rank(uint32_t slot)
+{
+    if (!is_application_valid(slot)) return 0;
+    if (slot_confirmed(slot)) return 2;
+    return slot_attempts_used(slot) < BOOT_MAX_ATTEMPTS ? 1 : 0;
+}
+
+// Slot to write the next update to: the one select_boot_slot would not
+// boot, so an interrupted update still leaves the other image to fall
+// back on. A confirmed image is never overwritten while the other slot
+// holds anything less; between equals the older image goes, since the
+// newer one is what runs.
+uint32_t slot_for_update(void)
+{
+    int rank_a = slot_boot_rank(SLOT_A_ADDR);
+    int rank_b = slot_boot_rank(SLOT_B_ADDR);
+    if (rank_a != rank_b) return rank_a < rank_b ? SLOT_A_ADDR : SLOT_B_ADDR;
+
+    if (!slot_has_image(SLOT_A_ADDR)) return SLOT_A_ADDR;
+    if (!slot_has_image(SLOT_B_ADDR)) return SLOT_B_ADDR;
+    return slot_descriptor(SLOT_A_ADDR)->sequence
+                   > slot_descriptor(SLOT_B_ADDR)->sequence
+               ? SLOT_B_ADDR
+               : SLOT_A_ADDR;
+}
+
+// Invalidate a slot before writing to it: with the descriptor gone, a
+// half-written image can never be booted
+static void slot_begin_update(uint32_t slot)
+{
+    flash_start_erase(SLOT_DESCRIPTOR(slot));
+    flash_finish_erase();
+}
+
+// Make a fully written slot bootable if the CRC computed while writing
+// matches the expected one. Flash was read back block by block as it was
+// programmed, so the running CRC covers what is actually in flash.
+bool slot_commit(uint32_t slot,
+                 uint32_t size,
+                 uint32_t crc,
+                 uint32_t expected_crc,
+                 uint32_t version)
+{
+    if (crc != expected_crc || !slot_vectors_valid(slot)) return false;
+
+    uint32_t other = slot == SLOT_A_ADDR ? SLOT_B_ADDR : SLOT_A_ADDR;
+    uint32_t sequence =
+        slot_has_image(other) ? slot_descriptor(other)->sequence + 1 : 1;
+
+    uint32_t header[6] = {SLOT_MAGIC, size, crc, version, sequence, 0};
+    return flash_program_block(SLOT_DESCRIPTOR(slot), header, 6);
+}
+
+// Called by the application once it has started up properly; until then
+// each boot of a new image uses up one of BOOT_MAX_ATTEMPTS
+bool firmware_confirm(uint32_t slot)
+{
+    if (slot_confirmed(slot)) return true;
+    return program_marker(&slot_descriptor(slot)->confirmed, SLOT_CONFIRMED);
+}
+
+// Bootloader jump to the application in a slot
+void jump_to_application(uint32_t slot)
 {
     // Application reset handler address
-    uint32_t jump_address = *(volatile uint32_t *) (APPLICATION_ADDR + 4);
+    uint32_t jump_address = *(volatile uint32_t *) (slot + 4);
 
     // Function pointer to application reset handler
     void (*app_reset_handler)(void) = (void (*)(void)) jump_address;
@@ -127,10 +399,10 @@ void jump_to_application(void)
     // ...
 
     // Set up vector table offset register to application vectors
-    // SCB->VTOR = APPLICATION_ADDR;
+    // SCB->VTOR = slot;
 
     // Initialize application stack pointer
-    // MSP = *(volatile uint32_t*)APPLICATION_ADDR;
+    // MSP = *(volatile uint32_t*)slot;
 
     // Jump to application reset handler
     app_reset_handler();
@@ -139,28 +411,43 @@ void jump_to_application(void)
     while (1);
 }
 
-// Check if application is valid
-bool is_application_valid(void)
+// Pick the slot to boot: the newest valid image, as long as it is either
+// confirmed or still has trial boots left; otherwise the older one. A
+// trial boot uses up an attempt before jumping, so an image that keeps
+// crashing before firmware_confirm falls back automatically.
+uint32_t select_boot_slot(void)
 {
-    // Check for valid reset vector
-    if (*(volatile uint32_t *) (APPLICATION_ADDR + 4) == 0xFFFFFFFF)
+    uint32_t slots[2] = {SLOT_A_ADDR, SLOT_B_ADDR};
+    if (slot_has_image(SLOT_B_ADDR)
+        && (!slot_has_image(SLOT_A_ADDR)
+            || slot_descriptor(SLOT_B_ADDR)->sequence
+                   > slot_descriptor(SLOT_A_ADDR)->sequence))
     {
-        return false;  // No valid reset vector
+        slots[0] = SLOT_B_ADDR;
+        slots[1] = SLOT_A_ADDR;
     }
 
-    // Additional checks could include:
-    // - Check stack pointer value is reasonable
-    // - Verify CRC or checksum of application
-    // - Check for specific markers
+    for (int i = 0; i < 2; i++)
+    {
+        uint32_t slot = slots[i];
+        if (!is_application_valid(slot)) continue;
+        if (slot_confirmed(slot)) return slot;
 
-    return true;
+        uint32_t used = slot_attempts_used(slot);
+        if (used < BOOT_MAX_ATTEMPTS)
+        {
+            program_marker(&slot_descriptor(slot)->attempts[used], 0);
+            return slot;
+        }
+    }
+    return 0;  // Nothing bootable
 }
 
 // Simple firmware update checker
 bool check_for_firmware_update(void)
 {
     // Check if update information structure is valid
-    FirmwareUpdateInfo *update_info = (FirmwareUpdateInfo *) 0x08020000;
+    FirmwareUpdateInfo *update_info = (FirmwareUpdateInfo *) UPDATE_INFO_ADDR;
 
     if (update_info->magic == UPDATE_PENDING_MAGIC)
     {
@@ -170,35 +457,173 @@ bool check_for_firmware_update(void)
     return false;
 }
 
-// Simplified update process
-void process_firmware_update(void)
+// Erase pages from *next_erase up to (not including) end; used to erase
+// just ahead of the write cursor instead of the whole region up front
+static void erase_up_to(uint32_t *next_erase, uint32_t end)
+{
+    while (*next_erase < end)
+    {
+        flash_start_erase(*next_erase);
+        flash_finish_erase();
+        *next_erase += FLASH_PAGE_SIZE;
+    }
+}
+
+// Copy a staged update from the update area into the inactive slot,
+// checking its CRC as each page goes in; returns false (and leaves the
+// slot unbootable) if the CRC does not match
+bool process_firmware_update(void)
 {
     // 1. Validate the firmware update
-    FirmwareUpdateInfo *update_info = (FirmwareUpdateInfo *) 0x08020000;
+    FirmwareUpdateInfo *update_info = (FirmwareUpdateInfo *) UPDATE_INFO_ADDR;
     uint32_t app_size = update_info->app_size;
+    if (app_size > SLOT_IMAGE_MAX) return false;
 
-    // 2. Erase application space
-    for (uint32_t addr = APPLICATION_ADDR; addr < APPLICATION_ADDR + app_size;
-         addr += 0x800)
+    // 2. Copy page by page, erasing each page just before writing it;
+    //    the image is padded to a double-word
+    uint32_t slot = slot_for_update();
+    flash_unlock();
+    slot_begin_update(slot);
+
+    const uint32_t *src =
+        (const uint32_t *) (UPDATE_INFO_ADDR + sizeof(FirmwareUpdateInfo));
+    uint32_t next_erase = slot;
+    uint32_t crc = 0;
+    bool ok = true;
+    for (uint32_t offset = 0; ok && offset < app_size;
+         offset += FLASH_PAGE_SIZE)
     {
-        flash_erase_page(addr);  // Assuming 2KB pages
+        uint32_t bytes = app_size - offset;
+        if (bytes > FLASH_PAGE_SIZE) bytes = FLASH_PAGE_SIZE;
+        crc = crc32_update(crc, src, bytes);
+        bytes = (bytes + 7) & ~7u;
+
+        erase_up_to(&next_erase, slot + offset + bytes);
+        ok = flash_program_block(slot + offset, src, bytes / 4);
+        src += bytes / 4;
     }
 
-    // 3. Copy new firmware from update area to application area
+    // 3. Mark the slot verified, then clear the update pending flag
+    ok = ok
+         && slot_commit(
+             slot, app_size, crc, update_info->app_crc, update_info->version);
+    flash_start_erase(UPDATE_INFO_ADDR);  // Erase update info
+    flash_finish_erase();
+    flash_lock();
+    return ok;
+}
+
+// Streaming update straight from a link (UART, USB, CAN) into the
+// application area. The link fills one chunk buffer by DMA while the CPU
+// programs the other, and the page the next chunk lands on is erased
+// while that chunk is still arriving, so erase, receive and program
+// overlap instead of running one after another.
+typedef struct
+{
+    // Start receiving up to length bytes into buffer (by DMA or interrupt)
+    void (*start_receive)(uint8_t *buffer, uint32_t length);
+    // Bytes received once the transfer has finished, 0 while in progress
+    uint32_t (*receive_complete)(void);
+} UpdateTransport;
+
+typedef enum
+{
+    UPDATE_OK,
+    UPDATE_LINK_ERROR,
+    UPDATE_FLASH_ERROR,
+    UPDATE_CRC_ERROR
+} UpdateResult;
+
+#define UPDATE_CHUNK_SIZE FLASH_PAGE_SIZE  // One page per chunk
+
+// Stream an image of image_size bytes into the inactive slot; it becomes
+// bootable only if its CRC-32, computed as the chunks arrive, equals
+// expected_crc
+UpdateResult firmware_update_stream(const UpdateTransport *link,
+                                    uint32_t image_size,
+                                    uint32_t expected_crc,
+                                    uint32_t version)
+{
+    // Word-aligned for flash_program_block
+    static uint32_t chunks[2][UPDATE_CHUNK_SIZE / 4];
+    uint32_t slot = slot_for_update();
+    uint32_t offset = 0;
+    uint32_t next_erase = slot;
+    uint32_t crc = 0;
+    bool erasing = false;
+    int filling = 0;
+
+    if (image_size > SLOT_IMAGE_MAX) return UPDATE_FLASH_ERROR;
+
     flash_unlock();
+    slot_begin_update(slot);
 
-    uint32_t *src = (uint32_t *) (0x08020000 + sizeof(FirmwareUpdateInfo));
-    for (uint32_t offset = 0; offset < app_size; offset += 4)
+    uint32_t expected = image_size < UPDATE_CHUNK_SIZE ? image_size
+                                                       : UPDATE_CHUNK_SIZE;
+    link->start_receive((uint8_t *) chunks[filling], expected);
+
+    while (offset < image_size)
     {
-        flash_program_word(APPLICATION_ADDR + offset, *src++);
-    }
+        // Erase the destination of the chunk in flight while it arrives
+        uint32_t chunk_end = slot + offset + expected;
+        if (erasing && !flash_busy())
+        {
+            flash_finish_erase();
+            erasing = false;
+        }
+        if (!erasing && next_erase < chunk_end)
+        {
+            erasing = flash_start_erase(next_erase);
+            if (erasing) next_erase += FLASH_PAGE_SIZE;
+        }
 
-    flash_lock();
+        uint32_t received = link->receive_complete();
+        if (received == 0) continue;
+        if (received != expected)
+        {
+            flash_lock();
+            return UPDATE_LINK_ERROR;
+        }
 
-    // 4. Clear update pending flag
-    flash_unlock();
-    flash_erase_page(0x08020000);  // Erase update info
+        // Make sure every page the chunk covers is erased
+        if (erasing)
+        {
+            flash_finish_erase();
+            erasing = false;
+        }
+        erase_up_to(&next_erase, chunk_end);
+
+        // Start the next receive before programming this chunk
+        uint32_t *ready = chunks[filling];
+        uint32_t ready_offset = offset;
+        offset += received;
+        filling ^= 1;
+        if (offset < image_size)
+        {
+            expected = image_size - offset < UPDATE_CHUNK_SIZE
+                           ? image_size - offset
+                           : UPDATE_CHUNK_SIZE;
+            link->start_receive((uint8_t *) chunks[filling], expected);
+        }
+
+        // Checksum while the next chunk arrives, then pad a short final
+        // chunk with the erased value
+        crc = crc32_update(crc, ready, received);
+        uint32_t words = (received + 7) / 8 * 2;
+        for (uint32_t b = received; b < words * 4; b++)
+        {
+            ((uint8_t *) ready)[b] = 0xFF;
+        }
+        if (!flash_program_block(slot + ready_offset, ready, words))
+        {
+            flash_lock();
+            return UPDATE_FLASH_ERROR;
+        }
+    }
+
+    bool committed = slot_commit(slot, image_size, crc, expected_crc, version);
     flash_lock();
+    return committed ? UPDATE_OK : UPDATE_CRC_ERROR;
 }
 
 /* ---- Main Bootloader Function ---- */
@@ -221,13 +646,15 @@ void bootloader_main(void)
         // uart_puts("Firmware update complete.\r\n");
     }
 
-    // Check if application is valid
-    if (is_application_valid())
+    // Pick the newest valid image; the descriptor check replaces a
+    // full-image CRC pass on every boot
+    uint32_t slot = select_boot_slot();
+    if (slot != 0)
     {
         // uart_puts("Valid application found, booting...\r\n");
 
         // Jump to application
-        jump_to_application();
+        jump_to_application(slot);
     }
     else
     {
@@ -239,6 +666,8 @@ void bootloader_main(void)
         while (1)
         {
             // Process bootloader commands
+            // - Receive an image:
+            //   firmware_update_stream(&uart_link, size, crc, version)
             // - Erase flash
             // - Program flash
             // - Verify flash
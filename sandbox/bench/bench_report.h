@@ -0,0 +1,81 @@
+// Machine-readable results for the sandbox benchmark runner.
+//
+// The demos print their timings for people to read. bench_report() also
+// appends one line per measurement to the file named by $BENCH_REPORT,
+// which bench/run_benchmarks.sh sets for every run and then aggregates:
+//
+//   bench_report("vla", seconds * 1e3, "ms", BENCH_LOWER_IS_BETTER);
+//
+// bench_param() reads a run's parameters from the environment, so
+// bench_param("SIZE", 100) is $BENCH_SIZE when bench/benchmarks.conf sets
+// SIZE=... for the entry and 100 otherwise. Run by hand, with neither
+// variable set, a demo prints exactly what it always did.
+//
+// Names and units end up in CSV, so they must not contain commas.
+//
+// bench_ready() marks the end of a program's setup for bench/startup_bench,
+// which times exec-to-ready and reads the RSS at that point.
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef enum
+{
+    BENCH_LOWER_IS_BETTER,   // Times, latencies, sizes
+    BENCH_HIGHER_IS_BETTER,  // Throughput
+} BenchDirection;
+
+// $BENCH_<name> as a positive integer, or fallback if unset or invalid
+static inline long bench_param(const char *name, long fallback)
+{
+    char key[64];
+    snprintf(key, sizeof(key), "BENCH_%s", name);
+    const char *text = getenv(key);
+    if (text == NULL || *text == '\0') return fallback;
+
+    char *end;
+    long value = strtol(text, &end, 10);
+    return *end == '\0' && value > 0 ? value : fallback;
+}
+
+// Appends "name,value,unit,lower|higher"; opened per call in append mode,
+// so forked children and threads can report too
+static inline void bench_report(const char *name,
+                                double value,
+                                const char *unit,
+                                BenchDirection better)
+{
+    const char *path = getenv("BENCH_REPORT");
+    if (path == NULL || *path == '\0') return;
+
+    FILE *file = fopen(path, "a");
+    if (file == NULL) return;
+    fprintf(file,
+            "%s,%.6g,%s,%s\n",
+            name,
+            value,
+            unit,
+            better == BENCH_LOWER_IS_BETTER ? "lower" : "higher");
+    fclose(file);
+}
+
+// Writes one byte to the pipe startup_bench passes in $BENCH_READY_FD, the
+// first time it is called; without the variable it does nothing
+static inline void bench_ready(void)
+{
+    static bool signalled;
+    const char *text = getenv("BENCH_READY_FD");
+    if (signalled || text == NULL || *text == '\0') return;
+
+    signalled = true;
+    int fd = atoi(text);
+    ssize_t written = write(fd, "r", 1);  // Nothing to do if it fails
+    (void) written;
+    close(fd);
+}
+
+#endif  // BENCH_REPORT_H
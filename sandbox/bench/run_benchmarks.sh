@@ -0,0 +1,339 @@
+#!/usr/bin/env bash
+# Build, run and compare the sandbox benchmarks listed in benchmarks.conf.
+#
+#   bench/run_benchmarks.sh [options] [name-pattern ...]
+#
+#   -r N        runs per benchmark; the median is reported (default 5)
+#   -f FORMAT   csv or json (default csv; the CSV is always written)
+#   -o DIR      results directory (default bench/results)
+#   -b FILE     baseline to compare against (default bench/baseline.csv)
+#   -t PERCENT  default regression threshold (default 10)
+#   -c CPUS     taskset CPU list for every run, instead of the last
+#               THREADS CPUs of the machine
+#   -s          save the results as the new baseline instead of comparing
+#   -l          list the registered benchmarks and exit
+#
+# Every program is built with the same compiler and flags ($BENCH_CC,
+# default cc; $BENCH_CFLAGS, default -O2), run in a scratch directory with
+# stdin closed, pinned with taskset and with address space randomization
+# off where setarch allows it. If the cpufreq governor and turbo/boost
+# controls are writable (root), they are set to performance/off for the
+# session and restored afterwards; otherwise the script says so and records
+# what it found, since a baseline from a frequency-scaled run only compares
+# with another one like it.
+#
+# Exit status: 0 on success, 1 if any metric regressed past its threshold,
+# 2 on usage or build errors.
+
+set -u
+
+here=$(cd "$(dirname "$0")" && pwd)
+sandbox=$(dirname "$here")
+
+runs=5
+format=csv
+out_dir="$here/results"
+baseline="$here/baseline.csv"
+default_threshold=10
+cpu_list=
+save=0
+list=0
+
+usage()
+{
+    sed -n '4,15s/^# \{0,1\}//p' "$0" >&2
+    exit 2
+}
+
+while getopts "r:f:o:b:t:c:slh" opt; do
+    case $opt in
+        r) runs=$OPTARG ;;
+        f) format=$OPTARG ;;
+        o) out_dir=$OPTARG ;;
+        b) baseline=$OPTARG ;;
+        t) default_threshold=$OPTARG ;;
+        c) cpu_list=$OPTARG ;;
+        s) save=1 ;;
+        l) list=1 ;;
+        *) usage ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+case $format in
+    csv | json) ;;
+    *) echo "unknown format: $format" >&2; usage ;;
+esac
+
+cc=${BENCH_CC:-cc}
+cflags=${BENCH_CFLAGS:--O2}
+
+# Programs see only the parameters their registry line sets
+for variable in $(compgen -e | grep '^BENCH_'); do
+    unset "$variable"
+done
+
+# ---- Registry ----
+
+# Lines of "name threshold source params..." matching the patterns
+select_entries()
+{
+    while read -r name threshold source params; do
+        case $name in '' | '#'*) continue ;; esac
+        if [ $# -gt 0 ]; then
+            matched=0
+            for pattern in "$@"; do
+                # shellcheck disable=SC2254
+                case $name in $pattern) matched=1 ;; esac
+            done
+            [ $matched = 1 ] || continue
+        fi
+        echo "$name $threshold $source $params"
+    done < "$here/benchmarks.conf"
+}
+
+entries=$(select_entries "$@")
+if [ -z "$entries" ]; then
+    echo "no benchmarks match: $*" >&2
+    exit 2
+fi
+
+if [ $list = 1 ]; then
+    echo "$entries" | awk '{ params = ""
+                             for (i = 4; i <= NF; i++) params = params " " $i
+                             printf "%-14s %-3s %s\n", $1, $2, params }'
+    exit 0
+fi
+
+# ---- CPU frequency and pinning ----
+
+online_cpus=$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1)
+restore=()
+
+# Write value to a sysfs control, remembering the old value for exit
+set_control()
+{
+    local file=$1 value=$2 old
+    [ -e "$file" ] || return 2
+    old=$(cat "$file" 2>/dev/null) || return 1
+    [ "$old" = "$value" ] && return 0
+    if { echo "$value" > "$file"; } 2>/dev/null; then
+        restore+=("$file" "$old")
+        return 0
+    fi
+    return 1
+}
+
+restore_controls()
+{
+    local i
+    for ((i = 0; i < ${#restore[@]}; i += 2)); do
+        echo "${restore[i + 1]}" > "${restore[i]}" 2>/dev/null
+    done
+}
+trap restore_controls EXIT
+trap 'exit 130' INT TERM
+
+governor=none
+for file in /sys/devices/system/cpu/cpu[0-9]*/cpufreq/scaling_governor; do
+    [ -e "$file" ] || break
+    if set_control "$file" performance; then
+        governor=performance
+    else
+        governor=$(cat "$file")
+        echo "note: cannot set $file to performance (not root?);" \
+             "running with governor '$governor'" >&2
+        break
+    fi
+done
+[ $governor = none ] &&
+    echo "note: no cpufreq governor exposed; clock speed not controlled" >&2
+
+turbo=unknown
+if set_control /sys/devices/system/cpu/intel_pstate/no_turbo 1; then
+    turbo=off
+elif set_control /sys/devices/system/cpu/cpufreq/boost 0; then
+    turbo=off
+elif [ -e /sys/devices/system/cpu/intel_pstate/no_turbo ] ||
+     [ -e /sys/devices/system/cpu/cpufreq/boost ]; then
+    turbo=on
+    echo "note: cannot disable turbo/boost; results will vary more" >&2
+fi
+
+have_taskset=0
+command -v taskset > /dev/null && have_taskset=1
+[ $have_taskset = 1 ] || echo "note: taskset not found; runs are not pinned" >&2
+
+no_aslr=()
+setarch "$(uname -m)" -R true 2>/dev/null && no_aslr=(setarch "$(uname -m)" -R)
+
+# The highest-numbered CPUs, away from CPU 0 and its interrupts; one per
+# thread the run asks for
+cpus_for()
+{
+    local threads=$1
+    [ -n "$cpu_list" ] && { echo "$cpu_list"; return; }
+    [ "$threads" -gt "$online_cpus" ] && threads=$online_cpus
+    echo "$((online_cpus - threads))-$((online_cpus - 1))"
+}
+
+# ---- Build ----
+
+build_dir="$out_dir/build"
+log_dir="$out_dir/logs"
+mkdir -p "$build_dir" "$log_dir" || exit 2
+
+# Binary for a source path, built once per invocation
+binary_for()
+{
+    echo "$build_dir/$(echo "${1%/main.c}" | tr '/' '_')"
+}
+
+for source in $(echo "$entries" | awk '{ print $3 }' | sort -u); do
+    binary=$(binary_for "$source")
+    echo "build  $source" >&2
+    if ! $cc $cflags -pthread "$sandbox/$source" -o "$binary" -lm \
+            2> "$binary.log"; then
+        cat "$binary.log" >&2
+        echo "build failed: $source" >&2
+        exit 2
+    fi
+done
+
+# ---- Run ----
+
+samples="$out_dir/samples.csv"
+: > "$samples"
+scratch=$(mktemp -d)
+trap 'restore_controls; rm -rf "$scratch"' EXIT
+
+while read -r name threshold source params; do
+    binary=$(binary_for "$source")
+    threads=1
+    env_params=()
+    for param in $params; do
+        env_params+=("BENCH_$param")
+        case $param in THREADS=*) threads=${param#THREADS=} ;; esac
+    done
+    pin=()
+    [ $have_taskset = 1 ] && pin=(taskset -c "$(cpus_for "$threads")")
+
+    echo "run    $name ($runs runs, cpus ${pin[2]:-any})" >&2
+    for ((run = 1; run <= runs; run++)); do
+        report="$scratch/report.csv"
+        rm -f "$report"
+        if ! (cd "$scratch" &&
+              env "${env_params[@]}" BENCH_REPORT="$report" \
+                  "${pin[@]}" "${no_aslr[@]}" "$binary") \
+                < /dev/null > "$log_dir/$name.log" 2>&1; then
+            echo "warning: $name exited with an error (see $log_dir/$name.log)" >&2
+        fi
+        [ -f "$report" ] || continue
+        label=$(echo $params | tr ' ' ';')
+        sed "s/^/$name,$label,$threshold,/" "$report" >> "$samples"
+    done
+done <<< "$entries"
+
+# ---- Aggregate ----
+
+# samples: name,params,threshold,metric,value,unit,better
+# results: name,params,metric,unit,better,threshold,runs,median,min,max
+results="$out_dir/results.csv"
+{
+    echo "# date=$(date -u +%Y-%m-%dT%H:%M:%SZ)"
+    echo "# host=$(uname -n) $(uname -sr)"
+    echo "# cpu=$(awk -F': ' '/model name/ { print $2; exit }' /proc/cpuinfo 2>/dev/null)"
+    echo "# cc=$($cc --version 2>/dev/null | head -n 1)"
+    echo "# cflags=$cflags"
+    echo "# governor=$governor"
+    echo "# turbo=$turbo"
+    echo "# runs=$runs"
+    echo "name,params,metric,unit,better,threshold,runs,median,min,max"
+    sort -t, -k1,1 -k4,4 -k5,5g "$samples" | awk -F, -v OFS=, '
+        function flush() {
+            if (n == 0) return
+            median = n % 2 ? v[(n + 1) / 2] : (v[n / 2] + v[n / 2 + 1]) / 2
+            print key, n, median, v[1], v[n]
+            n = 0
+        }
+        {
+            k = $1 OFS $2 OFS $4 OFS $6 OFS $7 OFS $3
+            if (k != key) { flush(); key = k }
+            v[++n] = $5
+        }
+        END { flush() }'
+} > "$results"
+
+if [ "$format" = json ]; then
+    awk -F, '
+        /^# / { sub(/^# /, ""); i = index($0, "=")
+                meta = meta sprintf("%s\n    \"%s\": \"%s\"", sep, substr($0, 1, i - 1),
+                                    substr($0, i + 1))
+                sep = ","; next }
+        /^name,/ { next }
+        { rows = rows sprintf("%s\n    {\"name\": \"%s\", \"params\": \"%s\", " \
+                              "\"metric\": \"%s\", \"unit\": \"%s\", \"better\": \"%s\", " \
+                              "\"threshold\": \"%s\", \"runs\": %s, \"median\": %s, " \
+                              "\"min\": %s, \"max\": %s}",
+                              rsep, $1, $2, $3, $4, $5, $6, $7, $8, $9, $10)
+          rsep = "," }
+        END { printf "{\n  \"meta\": {%s\n  },\n  \"results\": [%s\n  ]\n}\n", meta, rows }
+    ' "$results" > "$out_dir/results.json"
+    echo "results: $out_dir/results.json" >&2
+else
+    echo "results: $results" >&2
+fi
+
+# ---- Baseline ----
+
+if [ $save = 1 ]; then
+    cp "$results" "$baseline" && echo "baseline saved: $baseline" >&2
+    exit 0
+fi
+
+if [ ! -f "$baseline" ]; then
+    echo "no baseline at $baseline; make one with: make bench-baseline" >&2
+    exit 0
+fi
+
+# Setup lines that differ make every comparison suspect
+diff <(grep -E '^# (cpu|cc|cflags|governor|turbo)=' "$baseline") \
+     <(grep -E '^# (cpu|cc|cflags|governor|turbo)=' "$results") > /dev/null ||
+    echo "note: baseline was recorded with a different setup:" \
+         "$(grep -E '^# (cpu|cc|cflags|governor|turbo)=' "$baseline" | tr '\n' ' ')" >&2
+
+awk -F, -v default_threshold="$default_threshold" '
+    BEGIN {
+        printf "%-44s %12s %12s %8s %-8s %s\n",
+               "benchmark/metric", "baseline", "current", "change", "unit", ""
+    }
+    /^#/ || /^name,/ { next }
+    FNR == NR { base[$1 "/" $3] = $8; next }
+    {
+        key = $1 "/" $3
+        limit = ($6 == "-" ? default_threshold : $6) / 100
+        if (!(key in base)) { status = "new"; change = "" }
+        else if (base[key] <= 0) { status = "n/a"; change = "" }
+        else {
+            ratio = $8 / base[key] - 1
+            change = sprintf("%+.1f%%", ratio * 100)
+            worse = ($5 == "lower") ? ratio : -ratio
+            if (worse > limit) { status = "REGRESSED"; regressed++ }
+            else if (worse < -limit) status = "improved"
+            else status = "ok"
+        }
+        printf "%-44s %12s %12s %8s %-8s %s\n", key,
+               key in base ? sprintf("%.4g", base[key]) : "-",
+               sprintf("%.4g", $8), change, $4, status
+        seen[key] = 1
+    }
+    END {
+        for (key in base) if (!(key in seen))
+            printf "%-44s %12.4g %12s %8s %-8s %s\n", key, base[key], "-", "", "", "missing"
+        if (regressed) {
+            printf "%d metric(s) regressed past their threshold\n", regressed
+            exit 1
+        }
+        print "no regressions"
+    }
+' "$baseline" "$results"
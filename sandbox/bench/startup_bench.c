@@ -0,0 +1,219 @@
+// Exec-to-ready time and resident set size of short-lived programs.
+//
+//   startup_bench [-n runs] program...
+//
+// Each program is started runs times, after one untimed warm-up run. The
+// clock starts before fork and stops when the program calls bench_ready()
+// (bench/bench_report.h), which writes a byte to the pipe named by
+// $BENCH_READY_FD; RSS is read from /proc at that moment and the program
+// is killed. A program that never calls bench_ready() is timed to its
+// exit instead, with its peak RSS: for a short-lived command line tool
+// that is the number that matters anyway.
+//
+// Prints p50/p90 ready time, median RSS and the binary's size per program,
+// and reports them through bench_report() when $BENCH_REPORT is set.
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench_report.h"
+
+#define MAX_RUNS 1000
+
+typedef struct
+{
+    double ready_ms;
+    long rss_kb;
+    int signalled;  // Called bench_ready(), as opposed to exiting
+} StartupSample;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// VmRSS of a running process in KiB, or -1
+static long process_rss_kb(pid_t pid)
+{
+    char path[64], line[256];
+    snprintf(path, sizeof(path), "/proc/%d/status", (int) pid);
+    FILE *file = fopen(path, "r");
+    if (file == NULL) return -1;
+
+    long rss = -1;
+    while (fgets(line, sizeof(line), file))
+    {
+        if (sscanf(line, "VmRSS: %ld kB", &rss) == 1) break;
+    }
+    fclose(file);
+    return rss;
+}
+
+// Start program once and time it to bench_ready() or exit; 0 on success
+static int startup_sample(const char *program, StartupSample *sample)
+{
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) return -1;
+
+    double start = now_ms();
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    if (pid == 0)
+    {
+        // dup() drops O_CLOEXEC, so only this copy survives the exec
+        char fd_text[16];
+        snprintf(fd_text, sizeof(fd_text), "%d", dup(fds[1]));
+        setenv("BENCH_READY_FD", fd_text, 1);
+        unsetenv("BENCH_REPORT");
+
+        int null = open("/dev/null", O_RDWR);
+        dup2(null, STDIN_FILENO);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        execl(program, program, (char *) NULL);
+        _exit(127);
+    }
+
+    close(fds[1]);
+    char byte;
+    ssize_t got;
+    do
+    {
+        got = read(fds[0], &byte, 1);
+    } while (got < 0 && errno == EINTR);
+    sample->ready_ms = now_ms() - start;
+    sample->signalled = got == 1;
+    close(fds[0]);
+
+    sample->rss_kb = -1;
+    if (sample->signalled)
+    {
+        sample->rss_kb = process_rss_kb(pid);
+        kill(pid, SIGKILL);
+    }
+
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid) return -1;
+    if (!sample->signalled)
+    {
+        if (!WIFEXITED(status) || WEXITSTATUS(status) == 127) return -1;
+        sample->rss_kb = usage.ru_maxrss;
+    }
+    return 0;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static void run_program(const char *program, int runs)
+{
+    static StartupSample samples[MAX_RUNS];
+    static double values[MAX_RUNS];
+
+    struct stat st;
+    if (stat(program, &st) != 0)
+    {
+        printf("%-40s not found\n", program);
+        return;
+    }
+
+    StartupSample warmup;
+    if (startup_sample(program, &warmup) != 0)
+    {
+        printf("%-40s failed to start\n", program);
+        return;
+    }
+    for (int i = 0; i < runs; i++)
+    {
+        if (startup_sample(program, &samples[i]) != 0)
+        {
+            printf("%-40s failed on run %d\n", program, i + 1);
+            return;
+        }
+    }
+
+    for (int i = 0; i < runs; i++) values[i] = samples[i].ready_ms;
+    qsort(values, runs, sizeof(double), compare_doubles);
+    double p50 = values[runs / 2];
+    double p90 = values[runs * 9 / 10];
+
+    for (int i = 0; i < runs; i++) values[i] = samples[i].rss_kb;
+    qsort(values, runs, sizeof(double), compare_doubles);
+    double rss = values[runs / 2];
+
+    const char *name = strrchr(program, '/');
+    name = name ? name + 1 : program;
+    printf("%-40s %9lld %9.2f %9.2f %9.0f   %s\n",
+           name,
+           (long long) st.st_size / 1024,
+           p50,
+           p90,
+           rss,
+           samples[0].signalled ? "bench_ready" : "exit");
+
+    char metric[128];
+    snprintf(metric, sizeof(metric), "%s_ready", name);
+    bench_report(metric, p50, "ms", BENCH_LOWER_IS_BETTER);
+    snprintf(metric, sizeof(metric), "%s_rss", name);
+    bench_report(metric, rss, "KiB", BENCH_LOWER_IS_BETTER);
+    snprintf(metric, sizeof(metric), "%s_size", name);
+    bench_report(
+        metric, (double) st.st_size / 1024, "KiB", BENCH_LOWER_IS_BETTER);
+}
+
+int main(int argc, char *argv[])
+{
+    int runs = 20;
+    int opt;
+    bool usage = false;
+    while ((opt = getopt(argc, argv, "n:")) != -1)
+    {
+        if (opt == 'n')
+        {
+            runs = atoi(optarg);
+        }
+        else
+        {
+            usage = true;
+        }
+    }
+    if (usage || optind >= argc || runs < 1 || runs > MAX_RUNS)
+    {
+        fprintf(stderr, "usage: %s [-n runs] program...\n", argv[0]);
+        return 2;
+    }
+
+    printf("%-40s %9s %9s %9s %9s   %s\n",
+           "program",
+           "size KiB",
+           "p50 ms",
+           "p90 ms",
+           "RSS KiB",
+           "ready at");
+    for (int i = optind; i < argc; i++)
+    {
+        run_program(argv[i], runs);
+    }
+    return 0;
+}
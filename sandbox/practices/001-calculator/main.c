@@ -1,8 +1,799 @@
+#include <ctype.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
+/*
+ * Expression engine
+ *
+ * An expression such as "(x + 2) * y / sqrt(z)" is parsed once into a
+ * small AST, with constant subexpressions folded as they are built, and
+ * compiled to stack bytecode. The interpreter then runs each instruction
+ * over a block of EXPR_BLOCK rows at a time: one dispatch per
+ * instruction per block instead of per row, and every instruction body is
+ * a plain loop over arrays that the compiler vectorizes. Variables are
+ * bound to columns (one array per variable), so a formula evaluates over
+ * millions of rows as a handful of array passes.
+ */
+
+#define EXPR_MAX_NODES 256
+#define EXPR_MAX_CODE  256
+#define EXPR_MAX_STACK 32
+#define EXPR_MAX_VARS  16
+#define EXPR_NAME_LEN  16
+#define EXPR_BLOCK     256  // Rows per instruction dispatch
+
+typedef enum
+{
+    OP_CONST,  // push k
+    OP_VAR,    // push column arg
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_POW,
+    OP_MIN,
+    OP_MAX,
+    OP_NEG,
+    OP_SQRT,
+    OP_ABS,
+    OP_ADD_K,  // top op= k: binary operators with a constant right side
+    OP_SUB_K,
+    OP_MUL_K,
+    OP_DIV_K,
+} OpCode;
+
+typedef struct
+{
+    unsigned char op;  // OpCode
+    unsigned char arg; // Variable index for OP_VAR
+    double k;          // Constant for OP_CONST and the _K forms
+} Instr;
+
+typedef struct
+{
+    unsigned char op;  // OP_CONST, OP_VAR, or the operator
+    unsigned char var;
+    double value;
+    int left, right;  // Child nodes, -1 if none
+} ExprNode;
+
+typedef struct
+{
+    Instr code[EXPR_MAX_CODE];
+    int length;
+    int max_depth;  // Stack slots the code needs
+    ExprNode nodes[EXPR_MAX_NODES];
+    int node_count;
+    int root;
+    char names[EXPR_MAX_VARS][EXPR_NAME_LEN];
+    int var_count;
+} Program;
+
+typedef struct
+{
+    const char *text;
+    const char *pos;
+    Program *program;
+    const char *error;  // First error, NULL if none
+    int error_at;
+} Parser;
+
+static void parse_fail(Parser *p, const char *message)
+{
+    if (p->error == NULL)
+    {
+        p->error = message;
+        p->error_at = (int) (p->pos - p->text);
+    }
+}
+
+static int is_constant(const Program *prog, int node)
+{
+    return prog->nodes[node].op == OP_CONST;
+}
+
+static double apply_binary(int op, double a, double b)
+{
+    switch (op)
+    {
+    case OP_ADD: return a + b;
+    case OP_SUB: return a - b;
+    case OP_MUL: return a * b;
+    case OP_DIV: return a / b;
+    case OP_POW: return pow(a, b);
+    case OP_MIN: return fmin(a, b);
+    case OP_MAX: return fmax(a, b);
+    default: return NAN;
+    }
+}
+
+static double apply_unary(int op, double a)
+{
+    switch (op)
+    {
+    case OP_NEG: return -a;
+    case OP_SQRT: return sqrt(a);
+    case OP_ABS: return fabs(a);
+    default: return NAN;
+    }
+}
+
+static int new_node(Parser *p, int op, double value, int var, int left, int right)
+{
+    Program *prog = p->program;
+    // Constant folding: an operator whose operands are all constants
+    // becomes a constant, so "2 * 3.14159 * r" costs one multiply per row
+    if (left >= 0 && is_constant(prog, left)
+        && (right < 0 || is_constant(prog, right)))
+    {
+        double a = prog->nodes[left].value;
+        value = right < 0 ? apply_unary(op, a)
+                          : apply_binary(op, a, prog->nodes[right].value);
+        op = OP_CONST;
+        left = right = -1;
+    }
+    if (prog->node_count == EXPR_MAX_NODES)
+    {
+        parse_fail(p, "expression too long");
+        return 0;
+    }
+    ExprNode *n = &prog->nodes[prog->node_count];
+    n->op = (unsigned char) op;
+    n->var = (unsigned char) var;
+    n->value = value;
+    n->left = left;
+    n->right = right;
+    return prog->node_count++;
+}
+
+static void skip_spaces(Parser *p)
+{
+    while (isspace((unsigned char) *p->pos)) p->pos++;
+}
+
+static int variable_index(Parser *p, const char *name, size_t length)
+{
+    Program *prog = p->program;
+    for (int i = 0; i < prog->var_count; i++)
+    {
+        if (strlen(prog->names[i]) == length
+            && strncmp(prog->names[i], name, length) == 0)
+        {
+            return i;
+        }
+    }
+    if (prog->var_count == EXPR_MAX_VARS || length >= EXPR_NAME_LEN)
+    {
+        parse_fail(p, "too many variables or name too long");
+        return 0;
+    }
+    memcpy(prog->names[prog->var_count], name, length);
+    prog->names[prog->var_count][length] = '\0';
+    return prog->var_count++;
+}
+
+static int parse_sum(Parser *p);
+
+static int parse_unary(Parser *p);
+
+// number | name | name(args) | (sum)
+static int parse_primary(Parser *p)
+{
+    skip_spaces(p);
+    char c = *p->pos;
+    if (c == '(')
+    {
+        p->pos++;
+        int node = parse_sum(p);
+        skip_spaces(p);
+        if (*p->pos != ')')
+        {
+            parse_fail(p, "expected ')'");
+            return node;
+        }
+        p->pos++;
+        return node;
+    }
+    if (isdigit((unsigned char) c) || c == '.')
+    {
+        char *end;
+        double value = strtod(p->pos, &end);
+        if (end == p->pos)
+        {
+            parse_fail(p, "bad number");
+            return 0;
+        }
+        p->pos = end;
+        return new_node(p, OP_CONST, value, 0, -1, -1);
+    }
+    if (isalpha((unsigned char) c) || c == '_')
+    {
+        const char *name = p->pos;
+        while (isalnum((unsigned char) *p->pos) || *p->pos == '_') p->pos++;
+        size_t length = (size_t) (p->pos - name);
+        skip_spaces(p);
+        if (*p->pos != '(')
+        {
+            return new_node(p, OP_VAR, 0, variable_index(p, name, length), -1, -1);
+        }
+
+        static const struct
+        {
+            const char *name;
+            int op;
+            int args;
+        } functions[] = {
+            {"sqrt", OP_SQRT, 1},
+            {"abs", OP_ABS, 1},
+            {"pow", OP_POW, 2},
+            {"min", OP_MIN, 2},
+            {"max", OP_MAX, 2},
+        };
+        for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); i++)
+        {
+            if (strlen(functions[i].name) != length
+                || strncmp(functions[i].name, name, length) != 0)
+            {
+                continue;
+            }
+            p->pos++;
+            int left = parse_sum(p), right = -1;
+            skip_spaces(p);
+            if (functions[i].args == 2)
+            {
+                if (*p->pos != ',')
+                {
+                    parse_fail(p, "expected ','");
+                    return left;
+                }
+                p->pos++;
+                right = parse_sum(p);
+                skip_spaces(p);
+            }
+            if (*p->pos != ')')
+            {
+                parse_fail(p, "expected ')'");
+                return left;
+            }
+            p->pos++;
+            return new_node(p, functions[i].op, 0, 0, left, right);
+        }
+        parse_fail(p, "unknown function");
+        return 0;
+    }
+    parse_fail(p, c ? "unexpected character" : "unexpected end");
+    return 0;
+}
+
+// primary [^ unary], right-associative
+static int parse_power(Parser *p)
+{
+    int left = parse_primary(p);
+    skip_spaces(p);
+    if (*p->pos == '^')
+    {
+        p->pos++;
+        return new_node(p, OP_POW, 0, 0, left, parse_unary(p));
+    }
+    return left;
+}
+
+// -unary | power: "-2^2" is -(2^2), and "2^-1" works
+static int parse_unary(Parser *p)
+{
+    skip_spaces(p);
+    if (*p->pos == '-')
+    {
+        p->pos++;
+        return new_node(p, OP_NEG, 0, 0, parse_unary(p), -1);
+    }
+    return parse_power(p);
+}
+
+static int parse_product(Parser *p)
+{
+    int left = parse_unary(p);
+    for (;;)
+    {
+        skip_spaces(p);
+        char c = *p->pos;
+        if (c != '*' && c != '/') return left;
+        p->pos++;
+        left = new_node(p, c == '*' ? OP_MUL : OP_DIV, 0, 0, left, parse_unary(p));
+    }
+}
+
+static int parse_sum(Parser *p)
+{
+    int left = parse_product(p);
+    for (;;)
+    {
+        skip_spaces(p);
+        char c = *p->pos;
+        if (c != '+' && c != '-') return left;
+        p->pos++;
+        left = new_node(p, c == '+' ? OP_ADD : OP_SUB, 0, 0, left, parse_product(p));
+    }
+}
+
+static void emit(Program *prog, int op, int arg, double k, int depth, bool *ok)
+{
+    if (prog->length == EXPR_MAX_CODE || depth > EXPR_MAX_STACK)
+    {
+        *ok = false;
+        return;
+    }
+    prog->code[prog->length++] = (Instr){(unsigned char) op, (unsigned char) arg, k};
+    if (depth > prog->max_depth) prog->max_depth = depth;
+}
+
+// Post-order code generation; depth is the stack height before the node
+static void compile_node(Program *prog, int node, int depth, bool *ok)
+{
+    const ExprNode *n = &prog->nodes[node];
+    switch (n->op)
+    {
+    case OP_CONST:
+        emit(prog, OP_CONST, 0, n->value, depth + 1, ok);
+        return;
+    case OP_VAR:
+        emit(prog, OP_VAR, n->var, 0, depth + 1, ok);
+        return;
+    case OP_NEG:
+    case OP_SQRT:
+    case OP_ABS:
+        compile_node(prog, n->left, depth, ok);
+        emit(prog, n->op, 0, 0, depth + 1, ok);
+        return;
+    default:
+        break;
+    }
+
+    int left = n->left, right = n->right;
+    // A constant operand becomes an immediate: "x * 2" is one instruction
+    // and one stack slot. Add and multiply can take it from either side.
+    if ((n->op == OP_ADD || n->op == OP_MUL) && is_constant(prog, left))
+    {
+        int t = left;
+        left = right;
+        right = t;
+    }
+    if (is_constant(prog, right)
+        && (n->op == OP_ADD || n->op == OP_SUB || n->op == OP_MUL || n->op == OP_DIV))
+    {
+        compile_node(prog, left, depth, ok);
+        int op = n->op == OP_ADD   ? OP_ADD_K
+                 : n->op == OP_SUB ? OP_SUB_K
+                 : n->op == OP_MUL ? OP_MUL_K
+                                   : OP_DIV_K;
+        emit(prog, op, 0, prog->nodes[right].value, depth + 1, ok);
+        return;
+    }
+    compile_node(prog, left, depth, ok);
+    compile_node(prog, right, depth + 1, ok);
+    emit(prog, n->op, 0, 0, depth + 1, ok);
+}
+
+// Parse and compile text. Returns false and sets *error/*error_at (offset
+// into text) on failure.
+bool program_compile(Program *prog, const char *text, const char **error, int *error_at)
+{
+    memset(prog, 0, sizeof(*prog));
+    Parser p = {text, text, prog, NULL, 0};
+    prog->root = parse_sum(&p);
+    skip_spaces(&p);
+    if (*p.pos != '\0') parse_fail(&p, "unexpected character");
+
+    bool ok = true;
+    if (p.error == NULL)
+    {
+        compile_node(prog, prog->root, 0, &ok);
+        if (!ok) parse_fail(&p, "expression too complex");
+    }
+    *error = p.error;
+    *error_at = p.error_at;
+    return p.error == NULL;
+}
+
+// Instruction bodies: one loop over the block. x is the top of stack
+// (after a binary op pops y); restrict tells the compiler the two slots
+// do not overlap, so the loops vectorize.
+#define EXPR_UNARY(body)                       \
+    do                                         \
+    {                                          \
+        double *restrict x = stack[top];       \
+        for (size_t i = 0; i < n; i++) body;   \
+    } while (0)
+
+#define EXPR_BINARY(body)                          \
+    do                                             \
+    {                                              \
+        double *restrict x = stack[top - 1];       \
+        const double *restrict y = stack[top];     \
+        for (size_t i = 0; i < n; i++) body;       \
+        top--;                                     \
+    } while (0)
+
+// Evaluate over rows, reading variable i from columns[i][row] and
+// writing out[row]. columns must cover prog->var_count variables.
+void program_run(const Program *prog, const double *const *columns, double *out, size_t rows)
+{
+    static double stack[EXPR_MAX_STACK][EXPR_BLOCK];
+
+    for (size_t base = 0; base < rows; base += EXPR_BLOCK)
+    {
+        size_t n = rows - base < EXPR_BLOCK ? rows - base : EXPR_BLOCK;
+        int top = -1;
+        for (int pc = 0; pc < prog->length; pc++)
+        {
+            const Instr *in = &prog->code[pc];
+            const double k = in->k;
+            switch (in->op)
+            {
+            case OP_CONST:
+                top++;
+                EXPR_UNARY(x[i] = k);
+                break;
+            case OP_VAR:
+                top++;
+                memcpy(stack[top], columns[in->arg] + base, n * sizeof(double));
+                break;
+            case OP_ADD: EXPR_BINARY(x[i] += y[i]); break;
+            case OP_SUB: EXPR_BINARY(x[i] -= y[i]); break;
+            case OP_MUL: EXPR_BINARY(x[i] *= y[i]); break;
+            case OP_DIV: EXPR_BINARY(x[i] /= y[i]); break;
+            case OP_POW: EXPR_BINARY(x[i] = pow(x[i], y[i])); break;
+            case OP_MIN: EXPR_BINARY(x[i] = fmin(x[i], y[i])); break;
+            case OP_MAX: EXPR_BINARY(x[i] = fmax(x[i], y[i])); break;
+            case OP_NEG: EXPR_UNARY(x[i] = -x[i]); break;
+            case OP_SQRT: EXPR_UNARY(x[i] = sqrt(x[i])); break;
+            case OP_ABS: EXPR_UNARY(x[i] = fabs(x[i])); break;
+            case OP_ADD_K: EXPR_UNARY(x[i] += k); break;
+            case OP_SUB_K: EXPR_UNARY(x[i] -= k); break;
+            case OP_MUL_K: EXPR_UNARY(x[i] *= k); break;
+            case OP_DIV_K: EXPR_UNARY(x[i] /= k); break;
+            }
+        }
+        memcpy(out + base, stack[0], n * sizeof(double));
+    }
+}
+
+// Straightforward recursive evaluation of one row, for comparison
+double program_eval_row(const Program *prog, int node, const double *values)
+{
+    const ExprNode *n = &prog->nodes[node];
+    switch (n->op)
+    {
+    case OP_CONST: return n->value;
+    case OP_VAR: return values[n->var];
+    case OP_NEG:
+    case OP_SQRT:
+    case OP_ABS: return apply_unary(n->op, program_eval_row(prog, n->left, values));
+    default:
+        return apply_binary(n->op,
+                            program_eval_row(prog, n->left, values),
+                            program_eval_row(prog, n->right, values));
+    }
+}
+
+/* Bulk input: a CSV of bindings, header row naming the variables */
+
+typedef struct
+{
+    char names[EXPR_MAX_VARS][EXPR_NAME_LEN];
+    double *columns[EXPR_MAX_VARS];
+    int column_count;
+    size_t rows;
+    size_t capacity;
+} DataSet;
+
+static void dataset_free(DataSet *data)
+{
+    for (int i = 0; i < data->column_count; i++) free(data->columns[i]);
+    memset(data, 0, sizeof(*data));
+}
+
+static bool dataset_load(DataSet *data, const char *path)
+{
+    memset(data, 0, sizeof(*data));
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+    {
+        perror(path);
+        return false;
+    }
+
+    char line[4096];
+    if (fgets(line, sizeof(line), f) != NULL)
+    {
+        for (char *name = strtok(line, ",\r\n"); name && data->column_count < EXPR_MAX_VARS;
+             name = strtok(NULL, ",\r\n"))
+        {
+            while (isspace((unsigned char) *name)) name++;
+            snprintf(data->names[data->column_count++], EXPR_NAME_LEN, "%s", name);
+        }
+    }
+
+    bool ok = data->column_count > 0;
+    while (ok && fgets(line, sizeof(line), f) != NULL)
+    {
+        if (data->rows == data->capacity)
+        {
+            size_t capacity = data->capacity ? data->capacity * 2 : 4096;
+            for (int c = 0; c < data->column_count && ok; c++)
+            {
+                double *grown = realloc(data->columns[c], capacity * sizeof(double));
+                if (grown == NULL) ok = false;
+                else data->columns[c] = grown;
+            }
+            if (!ok) break;
+            data->capacity = capacity;
+        }
+        char *p = line;
+        for (int c = 0; c < data->column_count; c++)
+        {
+            data->columns[c][data->rows] = strtod(p, &p);
+            while (*p == ',' || *p == ' ') p++;
+        }
+        data->rows++;
+    }
+    fclose(f);
+    if (!ok) dataset_free(data);
+    return ok;
+}
+
+static double seconds_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Read one line into line without its newline. Returns 1, 0 at end of
+// input, or -1 if the line did not fit; the rest of it is skipped so the
+// next call starts on the following line.
+static int read_line(char *line, size_t size, FILE *f)
+{
+    if (fgets(line, (int) size, f) == NULL) return 0;
+    size_t length = strcspn(line, "\n");
+    if (line[length] == '\n' || feof(f))
+    {
+        line[length] = '\0';
+        if (length > 0 && line[length - 1] == '\r') line[length - 1] = '\0';
+        return 1;
+    }
+
+    int c;
+    while ((c = getc(f)) != EOF && c != '\n')
+    {
+    }
+    return -1;
+}
+
+// Evaluate each expression in exprs_path (one per line, '#' comments)
+// over every row of data_path; results go to out_path as CSV if given
+static int run_batch(const char *exprs_path, const char *data_path, const char *out_path)
+{
+    DataSet data;
+    if (!dataset_load(&data, data_path)) return 1;
+    FILE *exprs = fopen(exprs_path, "r");
+    if (exprs == NULL)
+    {
+        perror(exprs_path);
+        dataset_free(&data);
+        return 1;
+    }
+
+    enum { MAX_EXPRS = 32 };
+    double *results[MAX_EXPRS];
+    char texts[MAX_EXPRS][256];
+    int count = 0;
+    Program *prog = malloc(sizeof(Program));
+    char line[256];
+    int line_number = 0;
+    int status = prog ? 0 : 1;
+    int read;
+
+    while (status == 0 && (read = read_line(line, sizeof(line), exprs)) != 0)
+    {
+        line_number++;
+        if (read < 0)
+        {
+            fprintf(stderr,
+                    "%s:%d: line longer than %zu characters\n",
+                    exprs_path,
+                    line_number,
+                    sizeof(line) - 2);
+            status = 1;
+            break;
+        }
+        if (line[0] == '\0' || line[0] == '#') continue;
+        if (count == MAX_EXPRS)
+        {
+            fprintf(stderr, "%s:%d: more than %d expressions\n", exprs_path, line_number, MAX_EXPRS);
+            status = 1;
+            break;
+        }
+
+        const char *error;
+        int error_at;
+        if (!program_compile(prog, line, &error, &error_at))
+        {
+            fprintf(stderr, "%s: %s at column %d\n", line, error, error_at + 1);
+            status = 1;
+            break;
+        }
+
+        // Bind each variable to the CSV column of the same name
+        const double *columns[EXPR_MAX_VARS];
+        for (int v = 0; v < prog->var_count && status == 0; v++)
+        {
+            int c = 0;
+            while (c < data.column_count && strcmp(data.names[c], prog->names[v]) != 0) c++;
+            if (c == data.column_count)
+            {
+                fprintf(stderr, "%s: no column named '%s'\n", line, prog->names[v]);
+                status = 1;
+            }
+            columns[v] = data.columns[c];
+        }
+        if (status != 0) break;
+
+        results[count] = malloc((data.rows ? data.rows : 1) * sizeof(double));
+        if (results[count] == NULL)
+        {
+            status = 1;
+            break;
+        }
+        double start = seconds_now();
+        program_run(prog, columns, results[count], data.rows);
+        double elapsed = seconds_now() - start;
+
+        double sum = 0;
+        for (size_t r = 0; r < data.rows; r++) sum += results[count][r];
+        printf("%-40s %zu rows, %d instructions, sum %.6g, %.1f ns/row\n",
+               line,
+               data.rows,
+               prog->length,
+               sum,
+               data.rows ? elapsed * 1e9 / data.rows : 0.0);
+        snprintf(texts[count], sizeof(texts[count]), "%s", line);
+        count++;
+    }
+    fclose(exprs);
+
+    FILE *out = status == 0 && out_path ? fopen(out_path, "w") : NULL;
+    if (out != NULL)
+    {
+        for (int e = 0; e < count; e++) fprintf(out, "%s\"%s\"", e ? "," : "", texts[e]);
+        fputc('\n', out);
+        for (size_t r = 0; r < data.rows; r++)
+        {
+            for (int e = 0; e < count; e++) fprintf(out, "%s%.17g", e ? "," : "", results[e][r]);
+            fputc('\n', out);
+        }
+        fclose(out);
+    }
+
+    for (int e = 0; e < count; e++) free(results[e]);
+    free(prog);
+    dataset_free(&data);
+    return status;
+}
+
+// Compiled block evaluation against per-row tree walking
+static int run_benchmark(size_t rows)
+{
+    const char *text = "(x + 2 * 3) * (y - 1) / (z * z + 1) + sqrt(abs(x)) - max(y, 0.5)";
+    Program *prog = malloc(sizeof(Program));
+    double *x = malloc(rows * sizeof(double)), *y = malloc(rows * sizeof(double));
+    double *z = malloc(rows * sizeof(double)), *out = malloc(rows * sizeof(double));
+    if (!prog || !x || !y || !z || !out)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    const char *error;
+    int error_at;
+    program_compile(prog, text, &error, &error_at);
+    srand(42);
+    for (size_t r = 0; r < rows; r++)
+    {
+        x[r] = rand() / (double) RAND_MAX * 200 - 100;
+        y[r] = rand() / (double) RAND_MAX * 10;
+        z[r] = rand() / (double) RAND_MAX * 4 - 2;
+    }
+
+    // Variables are numbered in order of first appearance: x, y, z
+    const double *columns[3] = {x, y, z};
+    double start = seconds_now();
+    double tree_sum = 0;
+    for (size_t r = 0; r < rows; r++)
+    {
+        double values[3] = {x[r], y[r], z[r]};
+        tree_sum += program_eval_row(prog, prog->root, values);
+    }
+    double tree = seconds_now() - start;
+
+    start = seconds_now();
+    program_run(prog, columns, out, rows);
+    double compiled = seconds_now() - start;
+    double sum = 0;
+    for (size_t r = 0; r < rows; r++) sum += out[r];
+
+    printf("%s\n%zu rows, %d instructions (stack depth %d)\n",
+           text,
+           rows,
+           prog->length,
+           prog->max_depth);
+    printf("  tree walk, row at a time: %6.1f ns/row (sum %.6f)\n", tree * 1e9 / rows, tree_sum);
+    printf("  bytecode, %d-row blocks: %6.1f ns/row (sum %.6f)\n",
+           EXPR_BLOCK,
+           compiled * 1e9 / rows,
+           sum);
+
+    free(prog);
+    free(x);
+    free(y);
+    free(z);
+    free(out);
+    return 0;
+}
+
+// Option 5: evaluate one typed expression (no variables)
+static void evaluate_line(void)
+{
+    char line[256];
+    printf("\nEnter expression (e.g. (1 + 2) * 3 ^ 2 / sqrt(16)): ");
+    int read = read_line(line, sizeof(line), stdin);
+    if (read == 0) return;
+    if (read < 0)
+    {
+        printf("Error: expression longer than %zu characters\n", sizeof(line) - 2);
+        return;
+    }
+
+    static Program prog;
+    const char *error;
+    int error_at;
+    if (!program_compile(&prog, line, &error, &error_at))
+    {
+        printf("Error: %s at column %d\n", error, error_at + 1);
+        return;
+    }
+    if (prog.var_count > 0)
+    {
+        printf("Error: unknown name '%s' (use --batch to bind variables)\n", prog.names[0]);
+        return;
+    }
+    double result;
+    program_run(&prog, NULL, &result, 1);
+    printf("%s = %.10g\n", line, result);
+}
+
+/*
+ * Usage (link with -lm):
+ *   ./main                                  - interactive menu
+ *   ./main --batch exprs.txt data.csv [out.csv]
+ *                                           - every expression over every row
+ *   ./main --bench [rows]                   - compiled vs tree-walking
+ */
 int main(int argc, char *argv[])
 {
+    if (argc >= 4 && strcmp(argv[1], "--batch") == 0)
+    {
+        return run_batch(argv[2], argv[3], argc > 4 ? argv[4] : NULL);
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0)
+    {
+        return run_benchmark(argc > 2 ? strtoul(argv[2], NULL, 10) : 4000000);
+    }
+
     bool sys_running = true;
     int choice;
     float num1, num2, result;
@@ -17,10 +808,11 @@ int main(int argc, char *argv[])
         printf("│  2. Subtraction (a - b)          │\n");
         printf("│  3. Multiplication (a x b)       │\n");
         printf("│  4. Division    (a ÷ b)          │\n");
+        printf("│  5. Expression  ((a + b) * c)    │\n");
         printf("│  0. Exit                         │\n");
         printf("│                                  │\n");
         printf("└──────────────────────────────────┘\n");
-        printf("\nChoose operation (0-4): ");
+        printf("\nChoose operation (0-5): ");
 
         if (scanf("%d", &choice) != 1)
         {
@@ -29,9 +821,9 @@ int main(int argc, char *argv[])
             continue;
         }
 
-        if (choice < 0 || choice > 4)
+        if (choice < 0 || choice > 5)
         {
-            printf("Error: Please choose a valid option (0-4).\n");
+            printf("Error: Please choose a valid option (0-5).\n");
             while ((c = getchar()) != '\n' && c != EOF);
             continue;
         }
@@ -42,6 +834,13 @@ int main(int argc, char *argv[])
             continue;
         }
 
+        if (choice == 5)
+        {
+            while ((c = getchar()) != '\n' && c != EOF);
+            evaluate_line();
+            continue;
+        }
+
         printf("\nEnter first number: ");
         if (scanf("%f", &num1) != 1)
         {
@@ -1,4 +1,6 @@
+#include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -12,6 +14,17 @@ float find_highest_score(float scores[], int n);
 float find_lowest_score(float scores[], int n);
 void sort_by_score(char names[][MAX_NAME_LEN], float scores[], int n);
 
+// Lowest, highest, mean and variance, gathered in one pass
+typedef struct
+{
+    float lowest;
+    float highest;
+    float mean;
+    float variance;
+} ScoreStats;
+
+ScoreStats compute_score_stats(float scores[], int n);
+
 int main(int argc, char *argv[])
 {
     int choice;
@@ -83,13 +96,13 @@ int main(int argc, char *argv[])
         case 4:
             if (data_entered)
             {
-                float highest = find_highest_score(student_scores, student_count);
-                float lowest = find_lowest_score(student_scores, student_count);
+                ScoreStats stats = compute_score_stats(student_scores, student_count);
                 printf(
                     "The highest score in your class is %.2f, lowest is: "
                     "%.2f\n",
-                    highest,
-                    lowest);
+                    stats.highest,
+                    stats.lowest);
+                printf("Average %.2f, standard deviation %.2f\n", stats.mean, sqrtf(stats.variance));
             }
             else
             {
@@ -173,26 +186,89 @@ float find_lowest_score(float scores[], int n)
     return lowest;
 }
 
+// Welford's update keeps the variance accurate in a single pass
+ScoreStats compute_score_stats(float scores[], int n)
+{
+    ScoreStats stats = {0, 0, 0, 0};
+    if (n <= 0) return stats;
+
+    stats.lowest = stats.highest = scores[0];
+    double mean = 0, m2 = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (scores[i] < stats.lowest) stats.lowest = scores[i];
+        if (scores[i] > stats.highest) stats.highest = scores[i];
+
+        double delta = scores[i] - mean;
+        mean += delta / (i + 1);
+        m2 += delta * (scores[i] - mean);
+    }
+    stats.mean = (float) mean;
+    stats.variance = (float) (m2 / n);
+    return stats;
+}
+
+// Unsigned key that sorts like the score, inverted so that ascending keys
+// are descending scores
+static uint32_t descending_key(float score)
+{
+    uint32_t bits;
+    score += 0.0f;  // -0.0 becomes 0.0, so equal scores get equal keys
+    memcpy(&bits, &score, sizeof(bits));
+    uint32_t key = (bits & 0x80000000u) ? ~bits : bits ^ 0x80000000u;
+    return ~key;
+}
+
+/*
+ * Highest score first, ties in input order. Radix sort of the scores'
+ * bit patterns over an index permutation, then each name and score is
+ * moved once, instead of three strcpy calls per bubble-sort swap.
+ */
 void sort_by_score(char names[][MAX_NAME_LEN], float scores[], int n)
 {
-    // bubble sort
+    uint32_t keys[2][MAX_STUDENTS];
+    int order[2][MAX_STUDENTS];
+    int in = 0;
+
+    if (n < 2 || n > MAX_STUDENTS) return;
+
     for (int i = 0; i < n; i++)
     {
-        for (int j = 0; j < n - i - 1; j++)
+        keys[0][i] = descending_key(scores[i]);
+        order[0][i] = i;
+    }
+
+    // Four stable counting-sort passes, least significant byte first
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int offsets[256] = {0};
+        for (int i = 0; i < n; i++)
         {
-            if (scores[j] < scores[j + 1])
-            {
-                // switch score
-                float temp_score = scores[j];
-                scores[j] = scores[j + 1];
-                scores[j + 1] = temp_score;
-
-                // switch name
-                char temp_name[MAX_NAME_LEN];
-                strcpy(temp_name, names[j]);
-                strcpy(names[j], names[j + 1]);
-                strcpy(names[j + 1], temp_name);
-            }
+            offsets[(keys[in][i] >> shift) & 0xFF]++;
+        }
+        int total = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            int count = offsets[b];
+            offsets[b] = total;
+            total += count;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            int dest = offsets[(keys[in][i] >> shift) & 0xFF]++;
+            keys[1 - in][dest] = keys[in][i];
+            order[1 - in][dest] = order[in][i];
         }
+        in = 1 - in;
+    }
+
+    char sorted_names[MAX_STUDENTS][MAX_NAME_LEN];
+    float sorted_scores[MAX_STUDENTS];
+    for (int i = 0; i < n; i++)
+    {
+        memcpy(sorted_names[i], names[order[in][i]], MAX_NAME_LEN);
+        sorted_scores[i] = scores[order[in][i]];
     }
+    memcpy(names, sorted_names, (size_t) n * MAX_NAME_LEN);
+    memcpy(scores, sorted_scores, (size_t) n * sizeof(float));
 }
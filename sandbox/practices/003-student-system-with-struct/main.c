@@ -1,7 +1,10 @@
+#include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #define MAX_STUDENTS 50
 #define MAX_NAME_LEN 30
@@ -19,6 +22,22 @@ const Student *find_highest_score(const Student *students, int n);
 const Student *find_lowest_score(const Student *students, int n);
 void sort_by_score(Student *students, int n);
 
+// Everything a report needs from one pass over the scores
+typedef struct
+{
+    int count;
+    const Student *lowest;
+    const Student *highest;
+    double mean;
+    double variance;  // population variance
+} ScoreStats;
+
+ScoreStats compute_score_stats(const Student *students, int n);
+int top_k_by_score(const Student *students, int n, int k, const Student **out);
+float score_percentile(const Student *students, int n, double percent);
+void print_report(const Student *students, int n);
+void benchmark_reports(int n);
+
 int main(int argc, char *argv[])
 {
     int choice;
@@ -34,9 +53,11 @@ int main(int argc, char *argv[])
         printf("3. Calculate the average score.\n");
         printf("4. Search highest and lowest scores.\n");
         printf("5. Sort by scores\n");
+        printf("6. Report: statistics, top 3 and percentiles\n");
+        printf("7. Benchmark report generation\n");
         printf("0. exit\n");
 
-        printf(" -- Please select(1~5): ");
+        printf(" -- Please select(1~7): ");
         scanf("%d", &choice);
 
         switch (choice)
@@ -84,9 +105,10 @@ int main(int argc, char *argv[])
         case 4:
             if (data_entered)
             {
-                const Student *highest = find_highest_score(students, student_count);
-                const Student *lowest = find_lowest_score(students, student_count);
-                printf("The highest score in your class is %.2f, lowest is: %.2f\n", highest->score, lowest->score);
+                ScoreStats stats = compute_score_stats(students, student_count);
+                printf("The highest score in your class is %.2f, lowest is: %.2f\n",
+                       stats.highest->score,
+                       stats.lowest->score);
             }
             else
             {
@@ -104,6 +126,19 @@ int main(int argc, char *argv[])
                 printf("Please input students data first.\n");
             }
             break;
+        case 6:
+            if (data_entered)
+            {
+                print_report(students, student_count);
+            }
+            else
+            {
+                printf("Please input students data first.\n");
+            }
+            break;
+        case 7:
+            benchmark_reports(1000000);
+            break;
         default:
             break;
         }
@@ -171,9 +206,9 @@ const Student *find_lowest_score(const Student *students, int n)
     return lowest;
 }
 
-void sort_by_score(Student *students, int n)
+// The original O(n^2) sort, kept as the benchmark baseline
+void bubble_sort_by_score(Student *students, int n)
 {
-    // bubble sort
     for (int i = 0; i < n; i++)
     {
         for (int j = 0; j < n - i - 1; j++)
@@ -187,3 +222,359 @@ void sort_by_score(Student *students, int n)
         }
     }
 }
+
+// Map a float to an unsigned key with the same order: flip all bits of
+// negatives (so more negative sorts lower), and just the sign bit otherwise.
+// Inverted, so ascending keys mean descending scores.
+static uint32_t descending_key(float score)
+{
+    uint32_t bits;
+    score += 0.0f;  // -0.0 becomes 0.0, so equal scores get equal keys
+    memcpy(&bits, &score, sizeof(bits));
+    uint32_t key = (bits & 0x80000000u) ? ~bits : bits ^ 0x80000000u;
+    return ~key;
+}
+
+static int compare_score_desc(const void *a, const void *b)
+{
+    float x = ((const Student *) a)->score;
+    float y = ((const Student *) b)->score;
+    return (x < y) - (x > y);
+}
+
+/*
+ * Highest score first, ties kept in input order (as the bubble sort did).
+ * LSD radix sort on the float bits, four 8-bit passes over (key, index)
+ * pairs, then one pass moving the Students: O(n), and each 36-byte record
+ * is moved once instead of once per swap.
+ */
+void sort_by_score(Student *students, int n)
+{
+    if (n < 2) return;
+
+    uint32_t *keys = (uint32_t *) malloc(2 * (size_t) n * sizeof(uint32_t));
+    int *order = (int *) malloc(2 * (size_t) n * sizeof(int));
+    Student *sorted = (Student *) malloc((size_t) n * sizeof(Student));
+    if (keys == NULL || order == NULL || sorted == NULL)
+    {
+        // Not stable, but needs no extra memory
+        free(keys);
+        free(order);
+        free(sorted);
+        qsort(students, n, sizeof(Student), compare_score_desc);
+        return;
+    }
+
+    uint32_t *key_in = keys, *key_out = keys + n;
+    int *order_in = order, *order_out = order + n;
+    for (int i = 0; i < n; i++)
+    {
+        key_in[i] = descending_key(students[i].score);
+        order_in[i] = i;
+    }
+
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int offsets[256] = {0};
+        for (int i = 0; i < n; i++)
+        {
+            offsets[(key_in[i] >> shift) & 0xFF]++;
+        }
+        if (offsets[(key_in[0] >> shift) & 0xFF] == n) continue;  // all share this byte
+
+        int total = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            int count = offsets[b];
+            offsets[b] = total;
+            total += count;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            int dest = offsets[(key_in[i] >> shift) & 0xFF]++;
+            key_out[dest] = key_in[i];
+            order_out[dest] = order_in[i];
+        }
+
+        uint32_t *tk = key_in;
+        key_in = key_out;
+        key_out = tk;
+        int *to = order_in;
+        order_in = order_out;
+        order_out = to;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        sorted[i] = students[order_in[i]];
+    }
+    memcpy(students, sorted, (size_t) n * sizeof(Student));
+
+    free(keys);
+    free(order);
+    free(sorted);
+}
+
+/*
+ * Min, max, mean and variance in one pass. The variance uses Welford's
+ * update, which stays accurate where sum of squares minus squared sum
+ * cancels catastrophically.
+ */
+ScoreStats compute_score_stats(const Student *students, int n)
+{
+    ScoreStats stats = {n, NULL, NULL, 0.0, 0.0};
+    if (n <= 0) return stats;
+
+    stats.lowest = stats.highest = &students[0];
+    double mean = 0.0, m2 = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        float score = students[i].score;
+        if (score < stats.lowest->score) stats.lowest = &students[i];
+        if (score > stats.highest->score) stats.highest = &students[i];
+
+        double delta = score - mean;
+        mean += delta / (i + 1);
+        m2 += delta * (score - mean);
+    }
+    stats.mean = mean;
+    stats.variance = m2 / n;
+    return stats;
+}
+
+// Swap-down for the top-k min-heap: the root is the weakest of the best k
+static void sift_down(const Student **heap, int size, int i)
+{
+    for (;;)
+    {
+        int smallest = i, left = 2 * i + 1, right = left + 1;
+        if (left < size && heap[left]->score < heap[smallest]->score) smallest = left;
+        if (right < size && heap[right]->score < heap[smallest]->score) smallest = right;
+        if (smallest == i) return;
+
+        const Student *temp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = temp;
+        i = smallest;
+    }
+}
+
+/*
+ * The k highest-scoring students, best first, written to out (k entries).
+ * A min-heap of the best k seen so far means each student costs one
+ * comparison against the root, plus O(log k) when it gets in: O(n log k)
+ * instead of sorting everything.
+ * Returns the number written (fewer than k only if n < k).
+ */
+int top_k_by_score(const Student *students, int n, int k, const Student **out)
+{
+    if (k > n) k = n;
+    if (k <= 0) return 0;
+
+    for (int i = 0; i < k; i++)
+    {
+        out[i] = &students[i];
+    }
+    for (int i = k / 2 - 1; i >= 0; i--)
+    {
+        sift_down(out, k, i);
+    }
+    for (int i = k; i < n; i++)
+    {
+        if (students[i].score > out[0]->score)
+        {
+            out[0] = &students[i];
+            sift_down(out, k, 0);
+        }
+    }
+
+    // Heap sort in place: repeatedly move the minimum to the back
+    for (int size = k - 1; size > 0; size--)
+    {
+        const Student *temp = out[0];
+        out[0] = out[size];
+        out[size] = temp;
+        sift_down(out, size, 0);
+    }
+    return k;
+}
+
+// Rearrange values so values[nth] is what a full sort would put there,
+// with nothing larger before it and nothing smaller after (Hoare quickselect)
+static void select_nth(float *values, int n, int nth)
+{
+    int lo = 0, hi = n - 1;
+    while (lo < hi)
+    {
+        // Median of three guards against sorted input
+        int mid = lo + (hi - lo) / 2;
+        float a = values[lo], b = values[mid], c = values[hi];
+        float pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+
+        int i = lo, j = hi;
+        while (i <= j)
+        {
+            while (values[i] < pivot) i++;
+            while (values[j] > pivot) j--;
+            if (i <= j)
+            {
+                float temp = values[i];
+                values[i] = values[j];
+                values[j] = temp;
+                i++;
+                j--;
+            }
+        }
+        if (nth <= j)
+        {
+            hi = j;
+        }
+        else if (nth >= i)
+        {
+            lo = i;
+        }
+        else
+        {
+            return;  // values[j + 1 .. i - 1] all equal the pivot
+        }
+    }
+}
+
+/*
+ * Score at the given percentile (0-100), interpolating linearly between
+ * neighbouring ranks; 50 is the median. Expected O(n) by selection rather
+ * than a sort. Returns 0 for an empty class or if memory runs out.
+ */
+float score_percentile(const Student *students, int n, double percent)
+{
+    if (n <= 0) return 0.0f;
+
+    float *scores = (float *) malloc((size_t) n * sizeof(float));
+    if (scores == NULL) return 0.0f;
+    for (int i = 0; i < n; i++)
+    {
+        scores[i] = students[i].score;
+    }
+
+    percent = percent < 0.0 ? 0.0 : (percent > 100.0 ? 100.0 : percent);
+    double rank = percent / 100.0 * (n - 1);
+    int below = (int) rank;
+    select_nth(scores, n, below);
+    float result = scores[below];
+
+    if (rank > below)
+    {
+        // The next rank is the smallest value after the selected one
+        float next = scores[below + 1];
+        for (int i = below + 2; i < n; i++)
+        {
+            if (scores[i] < next) next = scores[i];
+        }
+        result += (float) ((rank - below) * (next - result));
+    }
+
+    free(scores);
+    return result;
+}
+
+void print_report(const Student *students, int n)
+{
+    ScoreStats stats = compute_score_stats(students, n);
+    printf("\n----- Report -----\n");
+    printf("Students: %d, average %.2f, standard deviation %.2f\n", stats.count, stats.mean, sqrt(stats.variance));
+    printf("Highest: %s (%.2f), lowest: %s (%.2f)\n",
+           stats.highest->name,
+           stats.highest->score,
+           stats.lowest->name,
+           stats.lowest->score);
+
+    const Student *top[3];
+    int shown = top_k_by_score(students, n, 3, top);
+    printf("Top %d:", shown);
+    for (int i = 0; i < shown; i++)
+    {
+        printf(" %s (%.2f)", top[i]->name, top[i]->score);
+    }
+    printf("\n");
+
+    printf("Median %.2f, 25th percentile %.2f, 90th percentile %.2f\n",
+           score_percentile(students, n, 50),
+           score_percentile(students, n, 25),
+           score_percentile(students, n, 90));
+    printf("------------------\n");
+}
+
+static double seconds_since(clock_t start)
+{
+    return ((double) (clock() - start)) / CLOCKS_PER_SEC;
+}
+
+// The report on n random students: separate passes and a full sort vs the
+// single-pass stats, bounded heap and selection
+void benchmark_reports(int n)
+{
+    printf("\n----- Benchmark: report on %d students -----\n", n);
+
+    Student *students = (Student *) malloc((size_t) n * sizeof(Student));
+    Student *copy = (Student *) malloc((size_t) n * sizeof(Student));
+    if (students == NULL || copy == NULL)
+    {
+        printf("Out of memory.\n");
+        free(students);
+        free(copy);
+        return;
+    }
+    srand(58);
+    for (int i = 0; i < n; i++)
+    {
+        snprintf(students[i].name, MAX_NAME_LEN, "Student%d", i);
+        students[i].score = (float) (rand() % 10001) / 100.0f;
+    }
+
+    // Old report: average, highest and lowest in three passes, then a full
+    // sort to read off the top 10 and the median
+    clock_t start = clock();
+    float average = calculate_average(students, n);
+    const Student *highest = find_highest_score(students, n);
+    const Student *lowest = find_lowest_score(students, n);
+    memcpy(copy, students, (size_t) n * sizeof(Student));
+    qsort(copy, n, sizeof(Student), compare_score_desc);
+    float median = copy[n / 2].score;
+    double t_old = seconds_since(start);
+    printf("Three passes + qsort:      %.3f s (average %.2f, range %.2f-%.2f, median %.2f)\n",
+           t_old,
+           average,
+           lowest->score,
+           highest->score,
+           median);
+
+    start = clock();
+    ScoreStats stats = compute_score_stats(students, n);
+    const Student *top[10];
+    top_k_by_score(students, n, 10, top);
+    float p50 = score_percentile(students, n, 50);
+    double t_new = seconds_since(start);
+    printf("One pass + heap + select:  %.3f s (average %.2f, range %.2f-%.2f, median %.2f; %.0fx faster)\n",
+           t_new,
+           stats.mean,
+           stats.lowest->score,
+           stats.highest->score,
+           p50,
+           t_old / t_new);
+    printf("Top-10 matches the sort: %s\n", top[9]->score == copy[9].score ? "yes" : "NO");
+
+    memcpy(copy, students, (size_t) n * sizeof(Student));
+    start = clock();
+    sort_by_score(copy, n);
+    printf("Radix sort_by_score:       %.3f s\n", seconds_since(start));
+
+    // The bubble sort is quadratic: time it on a slice
+    int slice = n < 10000 ? n : 10000;
+    memcpy(copy, students, (size_t) slice * sizeof(Student));
+    start = clock();
+    bubble_sort_by_score(copy, slice);
+    printf("Bubble sort, %d students: %.3f s\n", slice, seconds_since(start));
+
+    free(students);
+    free(copy);
+}
@@ -1,10 +1,22 @@
+#include <fcntl.h>
+#include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
 #define MAX_NAME_LEN 30
 #define DATA_FILE "students.dat"
+#define INDEX_FILE "students.idx"
+#define INDEX_TEMP_FILE "students.idx.tmp"
+#define INDEX_MAGIC "SIDX"
+#define INDEX_MAX_TAIL 4096  // unindexed records tolerated before merging
+#define IO_BATCH 4096        // records per read/write call
 
 typedef struct
 {
@@ -18,7 +30,42 @@ void display_all_students(void);
 void search_student_by_id(void);
 void update_student_score(void);
 bool save_to_file(Student *student);
+bool save_students(const Student *students, int count);
 int load_from_file(Student *student, int max_size);
+bool update_index(void);
+long find_student(int id, Student *student);
+long scan_for_student(int id, Student *student);
+bool update_score_on_disk(int id, float score);
+void generate_students(void);
+void benchmark_search(void);
+void column_store_analytics(void);
+
+/*
+ * students.dat is append-only, so record n always stays at byte offset
+ * n * sizeof(Student). students.idx maps ids to record numbers: a header,
+ * then IndexEntry pairs sorted by (id, record), searched by binary search
+ * with pread instead of loading the file.
+ *
+ * Records appended after the index was written are the "tail" and are
+ * scanned linearly; once there are more than INDEX_MAX_TAIL of them they
+ * are sorted and merged into a new index. A missing or stale index (the
+ * data file shrank or was replaced) is rebuilt from scratch.
+ *
+ * With duplicate ids the lowest record number wins, as in a linear search.
+ */
+typedef struct
+{
+    int32_t id;
+    uint32_t record;
+} IndexEntry;
+
+typedef struct
+{
+    char magic[4];
+    uint32_t entry_size;
+    uint64_t count;    // entries in the file
+    uint64_t records;  // data records covered: [0, records)
+} IndexHeader;
 
 int main(int argc, char *argv[])
 {
@@ -31,6 +78,9 @@ int main(int argc, char *argv[])
         printf("2. Display All Students\n");
         printf("3. Search Student by ID\n");
         printf("4. Update Student Score\n");
+        printf("5. Generate Sample Students\n");
+        printf("6. Benchmark Search\n");
+        printf("7. Column Store Analytics\n");
         printf("0. Exit\n");
         printf("Enter your choice: ");
         scanf("%d", &choice);
@@ -52,6 +102,15 @@ int main(int argc, char *argv[])
         case 4:
             update_student_score();
             break;
+        case 5:
+            generate_students();
+            break;
+        case 6:
+            benchmark_search();
+            break;
+        case 7:
+            column_store_analytics();
+            break;
         default:
             break;
         }
@@ -83,6 +142,12 @@ void add_student(void)
 }
 
 bool save_to_file(Student *student)
+{
+    return save_students(student, 1);
+}
+
+// Append count records through one handle and one write
+bool save_students(const Student *students, int count)
 {
     FILE *fp;
     fp = fopen(DATA_FILE, "ab");
@@ -92,7 +157,7 @@ bool save_to_file(Student *student)
         return false;
     }
 
-    if (fwrite(student, sizeof(Student), 1, fp) != 1)
+    if (fwrite(students, sizeof(Student), count, fp) != (size_t) count)
     {
         fclose(fp);
         return false;
@@ -145,28 +210,241 @@ int load_from_file(Student *students, int max_size)
     return count;
 }
 
-void search_student_by_id(void)
+static long record_count(int fd)
 {
-    Student students[100];
-    int count, i, search_id;
-    bool found = false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) return -1;
+    return (long) (st.st_size / (off_t) sizeof(Student));
+}
 
-    printf("Enter student ID to search: ");
-    scanf("%d", &search_id);
+static bool read_index_header(int fd, IndexHeader *header)
+{
+    return pread(fd, header, sizeof(*header), 0) == (ssize_t) sizeof(*header)
+           && memcmp(header->magic, INDEX_MAGIC, 4) == 0 && header->entry_size == sizeof(IndexEntry);
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+    const IndexEntry *x = (const IndexEntry *) a;
+    const IndexEntry *y = (const IndexEntry *) b;
+    if (x->id != y->id) return x->id < y->id ? -1 : 1;
+    return x->record < y->record ? -1 : (x->record > y->record);
+}
+
+/*
+ * Bring students.idx up to date: sort the tail's (id, record) pairs and
+ * merge them with the existing entries into a new file, which replaces the
+ * old one by rename so a crash never leaves a half-written index.
+ */
+bool update_index(void)
+{
+    int data_fd = open(DATA_FILE, O_RDONLY);
+    if (data_fd < 0) return false;
+
+    long total = record_count(data_fd);
+    IndexHeader old = {{0}, 0, 0, 0};
+    int index_fd = open(INDEX_FILE, O_RDONLY);
+    if (index_fd >= 0 && (!read_index_header(index_fd, &old) || old.records > (uint64_t) total))
+    {
+        old.count = 0;  // unusable: rebuild from the whole data file
+        old.records = 0;
+    }
+
+    long tail = total - (long) old.records;
+    IndexEntry *fresh = (IndexEntry *) malloc((tail > 0 ? tail : 1) * sizeof(IndexEntry));
+    Student *batch = (Student *) malloc(IO_BATCH * sizeof(Student));
+    FILE *out = fopen(INDEX_TEMP_FILE, "wb");
+    bool ok = total >= 0 && fresh != NULL && batch != NULL && out != NULL;
+
+    // Collect and sort the tail
+    for (long r = (long) old.records; ok && r < total; r += IO_BATCH)
+    {
+        long n = total - r < IO_BATCH ? total - r : IO_BATCH;
+        ok = pread(data_fd, batch, n * sizeof(Student), (off_t) r * sizeof(Student)) == (ssize_t) (n * sizeof(Student));
+        for (long i = 0; ok && i < n; i++)
+        {
+            fresh[r - (long) old.records + i] = (IndexEntry){batch[i].id, (uint32_t) (r + i)};
+        }
+    }
+    if (ok) qsort(fresh, tail, sizeof(IndexEntry), compare_entries);
+
+    // Merge the old entries, streamed in batches, with the sorted tail
+    IndexHeader header = {{'S', 'I', 'D', 'X'}, sizeof(IndexEntry), old.count + tail, total};
+    IndexEntry *old_batch = (IndexEntry *) batch;  // reuse the buffer
+    size_t old_batch_len = IO_BATCH * sizeof(Student) / sizeof(IndexEntry);
+    uint64_t old_next = 0, old_loaded = 0, old_pos = 0;
+    long fresh_pos = 0;
+
+    ok = ok && fwrite(&header, sizeof(header), 1, out) == 1;
+    while (ok && (old_pos < old_loaded || old_next < old.count || fresh_pos < tail))
+    {
+        if (old_pos == old_loaded && old_next < old.count)
+        {
+            uint64_t n = old.count - old_next < old_batch_len ? old.count - old_next : old_batch_len;
+            off_t at = (off_t) sizeof(IndexHeader) + (off_t) (old_next * sizeof(IndexEntry));
+            ok = pread(index_fd, old_batch, n * sizeof(IndexEntry), at) == (ssize_t) (n * sizeof(IndexEntry));
+            old_next += n;
+            old_loaded = n;
+            old_pos = 0;
+            if (!ok) break;
+        }
+        bool take_old = old_pos < old_loaded
+                        && (fresh_pos == tail || compare_entries(&old_batch[old_pos], &fresh[fresh_pos]) <= 0);
+        const IndexEntry *e = take_old ? &old_batch[old_pos++] : &fresh[fresh_pos++];
+        ok = fwrite(e, sizeof(*e), 1, out) == 1;
+    }
+
+    if (out != NULL && fclose(out) != 0) ok = false;
+    ok = ok && rename(INDEX_TEMP_FILE, INDEX_FILE) == 0;
+    if (!ok) remove(INDEX_TEMP_FILE);
+
+    free(fresh);
+    free(batch);
+    if (index_fd >= 0) close(index_fd);
+    close(data_fd);
+    return ok;
+}
+
+// Record number of the first student with this id in records [begin, end)
+static long scan_records(int data_fd, long begin, long end, int id, Student *student)
+{
+    Student batch[256];
+    for (long r = begin; r < end; r += 256)
+    {
+        long n = end - r < 256 ? end - r : 256;
+        if (pread(data_fd, batch, n * sizeof(Student), (off_t) r * sizeof(Student)) != (ssize_t) (n * sizeof(Student)))
+        {
+            return -1;
+        }
+        for (long i = 0; i < n; i++)
+        {
+            if (batch[i].id == id)
+            {
+                *student = batch[i];
+                return r + i;
+            }
+        }
+    }
+    return -1;
+}
+
+// Binary search the index file for the lowest (id, record) entry with id
+static long search_index(int index_fd, const IndexHeader *header, int id)
+{
+    uint64_t lo = 0, hi = header->count;
+    IndexEntry entry;
+
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+        off_t at = (off_t) sizeof(IndexHeader) + (off_t) (mid * sizeof(IndexEntry));
+        if (pread(index_fd, &entry, sizeof(entry), at) != (ssize_t) sizeof(entry)) return -1;
+        if (entry.id < id)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    if (lo == header->count) return -1;
 
-    for (i = 0; i < count; i++)
+    off_t at = (off_t) sizeof(IndexHeader) + (off_t) (lo * sizeof(IndexEntry));
+    if (pread(index_fd, &entry, sizeof(entry), at) != (ssize_t) sizeof(entry) || entry.id != id) return -1;
+    return entry.record;
+}
+
+/*
+ * Find a student by id through the index: O(log n) small reads plus a
+ * scan of at most INDEX_MAX_TAIL unindexed records.
+ * Returns the record number (and fills *student), or -1 if not found.
+ */
+long find_student(int id, Student *student)
+{
+    for (int attempt = 0; attempt < 2; attempt++)
     {
-        if (students[i].id == search_id)
+        int data_fd = open(DATA_FILE, O_RDONLY);
+        if (data_fd < 0) return -1;
+
+        long total = record_count(data_fd);
+        IndexHeader header;
+        int index_fd = open(INDEX_FILE, O_RDONLY);
+        bool usable = index_fd >= 0 && read_index_header(index_fd, &header) && header.records <= (uint64_t) total;
+
+        if (!usable || total - (long) header.records > INDEX_MAX_TAIL)
+        {
+            if (index_fd >= 0) close(index_fd);
+            close(data_fd);
+            if (!update_index()) return scan_for_student(id, student);
+            continue;
+        }
+
+        long record = search_index(index_fd, &header, id);
+        bool stale = false;
+        if (record >= 0)
         {
-            printf("\nStudent found!\n");
-            printf("ID: %d\n", students[i].id);
-            printf("Name: %s\n", students[i].name);
-            printf("Score: %.2f\n", students[i].score);
-            found = true;
+            // The record must still carry the id; if not, the data file was
+            // replaced behind the index's back
+            off_t at = (off_t) record * sizeof(Student);
+            stale = pread(data_fd, student, sizeof(Student), at) != (ssize_t) sizeof(Student) || student->id != id;
         }
+        else
+        {
+            record = scan_records(data_fd, (long) header.records, total, id, student);
+        }
+
+        close(index_fd);
+        close(data_fd);
+        if (!stale) return record;
+        remove(INDEX_FILE);
     }
+    return scan_for_student(id, student);
+}
+
+// The old way: read every record until the id turns up
+long scan_for_student(int id, Student *student)
+{
+    int data_fd = open(DATA_FILE, O_RDONLY);
+    if (data_fd < 0) return -1;
 
-    if (!found)
+    long record = scan_records(data_fd, 0, record_count(data_fd), id, student);
+    close(data_fd);
+    return record;
+}
+
+// Overwrite just the score field of the student's record
+bool update_score_on_disk(int id, float score)
+{
+    Student student;
+    long record = find_student(id, &student);
+    if (record < 0) return false;
+
+    int data_fd = open(DATA_FILE, O_WRONLY);
+    if (data_fd < 0) return false;
+
+    off_t at = (off_t) record * sizeof(Student) + offsetof(Student, score);
+    bool ok = pwrite(data_fd, &score, sizeof(score), at) == (ssize_t) sizeof(score);
+    close(data_fd);
+    return ok;
+}
+
+void search_student_by_id(void)
+{
+    Student student;
+    int search_id;
+
+    printf("Enter student ID to search: ");
+    scanf("%d", &search_id);
+
+    if (find_student(search_id, &student) >= 0)
+    {
+        printf("\nStudent found!\n");
+        printf("ID: %d\n", student.id);
+        printf("Name: %s\n", student.name);
+        printf("Score: %.2f\n", student.score);
+    }
+    else
     {
         printf("Student with ID %d not found.\n", search_id);
     }
@@ -174,11 +452,8 @@ void search_student_by_id(void)
 
 void update_student_score(void)
 {
-    Student students[100];
-    int count, i, update_id;
+    int update_id;
     float new_score;
-    bool found = false;
-    FILE *fp;
 
     printf("Enter student ID to update: ");
     scanf("%d", &update_id);
@@ -186,40 +461,506 @@ void update_student_score(void)
     printf("Enter new score: ");
     scanf("%f", &new_score);
 
-    count = load_from_file(students, 100);
+    if (update_score_on_disk(update_id, new_score))
+    {
+        printf("Student score updated successfully!\n");
+    }
+    else
+    {
+        printf("Student with ID %d not found.\n", update_id);
+    }
+}
+
+// Append students with consecutive ids, IO_BATCH records per write
+// through one open handle, then index them
+void generate_students(void)
+{
+    int count, first_id;
+
+    printf("How many students to generate: ");
+    scanf("%d", &count);
+    printf("First student ID: ");
+    scanf("%d", &first_id);
+
+    Student *batch = (Student *) malloc(IO_BATCH * sizeof(Student));
+    FILE *fp = fopen(DATA_FILE, "ab");
+    if (batch == NULL || fp == NULL)
+    {
+        perror("Error opening file ");
+        free(batch);
+        if (fp != NULL) fclose(fp);
+        return;
+    }
 
-    for (i = 0; i < count; i++)
+    int written = 0;
+    while (written < count)
     {
-        if (students[i].id == update_id)
+        int n = count - written < IO_BATCH ? count - written : IO_BATCH;
+        for (int i = 0; i < n; i++)
         {
-            students[i].score = new_score;
-            found = true;
-            break;
+            Student *s = &batch[i];
+            memset(s, 0, sizeof(*s));
+            s->id = first_id + written + i;
+            snprintf(s->name, MAX_NAME_LEN, "Student%d", s->id);
+            s->score = (float) (rand() % 1001) / 10.0f;
+        }
+        if (fwrite(batch, sizeof(Student), n, fp) != (size_t) n) break;
+        written += n;
+    }
+    fclose(fp);
+    free(batch);
+
+    printf("Added %d students.\n", written);
+    if (!update_index()) printf("Error updating index.\n");
+}
+
+static double seconds_since(clock_t start)
+{
+    return ((double) (clock() - start)) / CLOCKS_PER_SEC;
+}
+
+// Random lookups by id: full scan vs index
+void benchmark_search(void)
+{
+    int data_fd = open(DATA_FILE, O_RDONLY);
+    long total = data_fd >= 0 ? record_count(data_fd) : 0;
+    if (total <= 0)
+    {
+        if (data_fd >= 0) close(data_fd);
+        printf("No student records found.\n");
+        return;
+    }
+
+    // Probe the ids of random records, so every lookup should succeed
+    enum { LOOKUPS = 1000, SCANS = 20 };
+    int ids[LOOKUPS];
+    for (int i = 0; i < LOOKUPS; i++)
+    {
+        Student s;
+        long r = (long) ((((unsigned long) rand() << 16) ^ (unsigned long) rand()) % (unsigned long) total);
+        ids[i] = pread(data_fd, &s, sizeof(s), (off_t) r * sizeof(Student)) == (ssize_t) sizeof(s) ? s.id : 0;
+    }
+    close(data_fd);
+    update_index();
+
+    Student student;
+    int found = 0;
+    clock_t start = clock();
+    for (int i = 0; i < SCANS; i++)
+    {
+        found += scan_for_student(ids[i], &student) >= 0;
+    }
+    double t_scan = seconds_since(start) / SCANS;
+
+    start = clock();
+    for (int i = 0; i < LOOKUPS; i++)
+    {
+        found += find_student(ids[i], &student) >= 0;
+    }
+    double t_index = seconds_since(start) / LOOKUPS;
+
+    printf("%ld records: full scan %.3f ms, index %.4f ms per lookup (%.0fx faster; %d of %d found)\n",
+           total,
+           t_scan * 1e3,
+           t_index * 1e3,
+           t_scan / t_index,
+           found,
+           SCANS + LOOKUPS);
+}
+
+/*
+ * Column store: the same rows as students.dat, one array per field. A
+ * scan over scores reads 4 bytes per student instead of the whole
+ * 40-byte Student, and plain loops over a float array vectorize. Names
+ * are interned: each distinct name is stored once in name_pool and rows
+ * hold its offset.
+ */
+typedef struct
+{
+    int32_t *ids;
+    float *scores;
+    uint32_t *names;  // offset of each row's name in name_pool
+    size_t count;
+    size_t capacity;
+
+    char *name_pool;  // NUL-terminated names, back to back
+    size_t pool_used;
+    size_t pool_capacity;
+    uint32_t *intern_slots;  // open addressing: name offset + 1, 0 if empty
+    size_t intern_capacity;  // power of two
+    size_t distinct_names;
+} StudentTable;
+
+// Aggregate over the scores a filter kept
+typedef struct
+{
+    size_t count;
+    double sum;
+    float min;
+    float max;
+} ScoreSummary;
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define TABLE_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define TABLE_CLONES
+#endif
+
+// Kernels walk the columns in fixed blocks with one partial result per
+// lane: GCC vectorizes those at -O2 without -ffast-math
+#define TABLE_LANES 16
+
+void table_init(StudentTable *table)
+{
+    memset(table, 0, sizeof(*table));
+}
+
+void table_free(StudentTable *table)
+{
+    free(table->ids);
+    free(table->scores);
+    free(table->names);
+    free(table->name_pool);
+    free(table->intern_slots);
+    table_init(table);
+}
+
+static uint32_t hash_name(const char *name, size_t length)
+{
+    uint32_t hash = 2166136261u;  // FNV-1a
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ (unsigned char) name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool grow_interning(StudentTable *table)
+{
+    size_t capacity = table->intern_capacity ? table->intern_capacity * 2 : 1024;
+    uint32_t *slots = (uint32_t *) calloc(capacity, sizeof(uint32_t));
+    if (slots == NULL) return false;
+
+    for (size_t i = 0; i < table->intern_capacity; i++)
+    {
+        uint32_t entry = table->intern_slots[i];
+        if (entry == 0) continue;
+
+        const char *name = table->name_pool + entry - 1;
+        size_t slot = hash_name(name, strlen(name)) & (capacity - 1);
+        while (slots[slot] != 0)
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        slots[slot] = entry;
+    }
+    free(table->intern_slots);
+    table->intern_slots = slots;
+    table->intern_capacity = capacity;
+    return true;
+}
+
+// Offset of the name in the pool, adding it if new; UINT32_MAX if out of
+// memory
+static uint32_t intern_name(StudentTable *table, const char *name, size_t length)
+{
+    if (2 * (table->distinct_names + 1) > table->intern_capacity && !grow_interning(table)) return UINT32_MAX;
+
+    size_t mask = table->intern_capacity - 1;
+    size_t slot = hash_name(name, length) & mask;
+    while (table->intern_slots[slot] != 0)
+    {
+        const char *existing = table->name_pool + table->intern_slots[slot] - 1;
+        if (strncmp(existing, name, length) == 0 && existing[length] == '\0') return table->intern_slots[slot] - 1;
+        slot = (slot + 1) & mask;
+    }
+
+    if (table->pool_used + length + 1 > table->pool_capacity)
+    {
+        size_t capacity = table->pool_capacity ? table->pool_capacity * 2 : 4096;
+        while (capacity < table->pool_used + length + 1)
+        {
+            capacity *= 2;
+        }
+        char *pool = (char *) realloc(table->name_pool, capacity);
+        if (pool == NULL) return UINT32_MAX;
+        table->name_pool = pool;
+        table->pool_capacity = capacity;
+    }
+
+    uint32_t offset = (uint32_t) table->pool_used;
+    memcpy(table->name_pool + offset, name, length);
+    table->name_pool[offset + length] = '\0';
+    table->pool_used += length + 1;
+    table->intern_slots[slot] = offset + 1;
+    table->distinct_names++;
+    return offset;
+}
+
+static bool grow_columns(StudentTable *table, size_t needed)
+{
+    if (needed <= table->capacity) return true;
+
+    size_t capacity = table->capacity ? table->capacity : 1024;
+    while (capacity < needed)
+    {
+        capacity *= 2;
+    }
+    int32_t *ids = (int32_t *) realloc(table->ids, capacity * sizeof(int32_t));
+    if (ids != NULL) table->ids = ids;
+    float *scores = (float *) realloc(table->scores, capacity * sizeof(float));
+    if (scores != NULL) table->scores = scores;
+    uint32_t *names = (uint32_t *) realloc(table->names, capacity * sizeof(uint32_t));
+    if (names != NULL) table->names = names;
+    if (ids == NULL || scores == NULL || names == NULL) return false;
+
+    table->capacity = capacity;
+    return true;
+}
+
+bool table_append(StudentTable *table, const Student *student)
+{
+    if (!grow_columns(table, table->count + 1)) return false;
+
+    // name[] is not guaranteed to be terminated within MAX_NAME_LEN
+    uint32_t name = intern_name(table, student->name, strnlen(student->name, MAX_NAME_LEN));
+    if (name == UINT32_MAX) return false;
+
+    table->ids[table->count] = student->id;
+    table->scores[table->count] = student->score;
+    table->names[table->count] = name;
+    table->count++;
+    return true;
+}
+
+const char *table_name(const StudentTable *table, size_t row)
+{
+    return table->name_pool + table->names[row];
+}
+
+// Read students.dat (the unchanged row format) into columns
+bool table_load(StudentTable *table)
+{
+    FILE *fp = fopen(DATA_FILE, "rb");
+    if (fp == NULL) return false;
+
+    Student *batch = (Student *) malloc(IO_BATCH * sizeof(Student));
+    bool ok = batch != NULL;
+    size_t n;
+    while (ok && (n = fread(batch, sizeof(Student), IO_BATCH, fp)) > 0)
+    {
+        ok = grow_columns(table, table->count + n);
+        for (size_t i = 0; ok && i < n; i++)
+        {
+            ok = table_append(table, &batch[i]);
         }
     }
 
-    if (found)
+    free(batch);
+    fclose(fp);
+    return ok;
+}
+
+TABLE_CLONES double scores_sum(const float *restrict scores, size_t n)
+{
+    double partial[TABLE_LANES] = {0};
+    size_t i = 0;
+    for (; i + TABLE_LANES <= n; i += TABLE_LANES)
     {
-        fp = fopen(DATA_FILE, "wb");
-        if (fp == NULL)
+        for (int j = 0; j < TABLE_LANES; j++)
         {
-            perror("Error opening file ");
-            return;
+            partial[j] += scores[i + j];
         }
+    }
+    double sum = 0.0;
+    for (int j = 0; j < TABLE_LANES; j++)
+    {
+        sum += partial[j];
+    }
+    for (; i < n; i++)
+    {
+        sum += scores[i];
+    }
+    return sum;
+}
+
+// keep ? a : b on the bit patterns. With a plain ?: on floats GCC keeps
+// the branch (the comparison feeding it may trap), and the loop will not
+// vectorize.
+static inline float select_float(bool keep, float a, float b)
+{
+    uint32_t x, y, mask = -(uint32_t) keep;
+    memcpy(&x, &a, sizeof(x));
+    memcpy(&y, &b, sizeof(y));
+    x = (x & mask) | (y & ~mask);
+    memcpy(&a, &x, sizeof(a));
+    return a;
+}
 
-        if (fwrite(students, sizeof(Student), count, fp) != count)
+/*
+ * Fused filter and aggregate: summary of the scores in [min_score,
+ * max_score]. The filter is a mask rather than a branch, so unpredictable
+ * data costs nothing extra and the loop vectorizes; no selection vector is
+ * materialized. An empty result has min = INFINITY and max = -INFINITY.
+ */
+TABLE_CLONES ScoreSummary scores_summarize_range(const float *restrict scores, size_t n, float min_score, float max_score)
+{
+    double sum[TABLE_LANES] = {0};
+    uint32_t count[TABLE_LANES] = {0};
+    float lo[TABLE_LANES], hi[TABLE_LANES];
+    for (int j = 0; j < TABLE_LANES; j++)
+    {
+        lo[j] = INFINITY;
+        hi[j] = -INFINITY;
+    }
+
+    ScoreSummary summary = {0, 0.0, INFINITY, -INFINITY};
+    size_t i = 0;
+    while (i + TABLE_LANES <= n)
+    {
+        // Flush the 32-bit lane counters before they could overflow
+        size_t block_end = n - i > ((size_t) 1 << 30) ? i + ((size_t) 1 << 30) : n;
+        for (; i + TABLE_LANES <= block_end; i += TABLE_LANES)
         {
-            printf("Error writing to file.\n");
+            for (int j = 0; j < TABLE_LANES; j++)
+            {
+                float s = scores[i + j];
+                bool keep = (s >= min_score) & (s <= max_score);
+                float low = select_float(keep, s, INFINITY);
+                float high = select_float(keep, s, -INFINITY);
+                sum[j] += select_float(keep, s, 0.0f);
+                count[j] += keep;
+                lo[j] = low < lo[j] ? low : lo[j];
+                hi[j] = high > hi[j] ? high : hi[j];
+            }
         }
-        else
+        for (int j = 0; j < TABLE_LANES; j++)
+        {
+            summary.count += count[j];
+            count[j] = 0;
+        }
+    }
+
+    for (int j = 0; j < TABLE_LANES; j++)
+    {
+        summary.sum += sum[j];
+        summary.min = lo[j] < summary.min ? lo[j] : summary.min;
+        summary.max = hi[j] > summary.max ? hi[j] : summary.max;
+    }
+    for (; i < n; i++)
+    {
+        float s = scores[i];
+        if (s >= min_score && s <= max_score)
         {
-            printf("Student score updated successfully!\n");
+            summary.count++;
+            summary.sum += s;
+            summary.min = s < summary.min ? s : summary.min;
+            summary.max = s > summary.max ? s : summary.max;
         }
+    }
+    return summary;
+}
 
-        fclose(fp);
+/*
+ * Selection vector: row numbers with a score in [min_score, max_score],
+ * for later stages that need other columns (ids, names) of just those
+ * rows. rows must have room for n entries. Branch-free: every row is
+ * written and the cursor advances only for kept ones.
+ */
+size_t scores_select_range(const float *scores, size_t n, float min_score, float max_score, uint32_t *rows)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        rows[kept] = (uint32_t) i;
+        kept += scores[i] >= min_score && scores[i] <= max_score;
     }
-    else
+    return kept;
+}
+
+// Column-store analytics on students.dat, timed against the same work on
+// an array of Student rows
+void column_store_analytics(void)
+{
+    StudentTable table;
+    table_init(&table);
+    clock_t start = clock();
+    if (!table_load(&table) || table.count == 0)
     {
-        printf("Student with ID %d not found.\n", update_id);
+        printf("No student records found.\n");
+        table_free(&table);
+        return;
+    }
+    double t_load = seconds_since(start);
+
+    size_t n = table.count;
+    printf("\n--- Column Store ---\n");
+    printf("Loaded %zu rows in %.3f s; %zu distinct names in %zu bytes (rows hold %zu bytes of names)\n",
+           n,
+           t_load,
+           table.distinct_names,
+           table.pool_used,
+           n * (size_t) MAX_NAME_LEN);
+
+    ScoreSummary all = scores_summarize_range(table.scores, n, -INFINITY, INFINITY);
+    ScoreSummary passed = scores_summarize_range(table.scores, n, 60.0f, 100.0f);
+    printf("All: average %.2f, range %.2f-%.2f\n", all.sum / all.count, all.min, all.max);
+    printf("Scores 60-100: %zu students, average %.2f\n", passed.count, passed.count ? passed.sum / passed.count : 0.0);
+
+    uint32_t *rows = (uint32_t *) malloc(n * sizeof(uint32_t));
+    if (rows != NULL)
+    {
+        size_t top = scores_select_range(table.scores, n, 99.5f, INFINITY, rows);
+        printf("Scores of 99.5 and up: %zu students", top);
+        for (size_t i = 0; i < top && i < 3; i++)
+        {
+            printf("%s %s (%d)", i ? "," : ":", table_name(&table, rows[i]), table.ids[rows[i]]);
+        }
+        printf("%s\n", top > 3 ? ", ..." : "");
+        free(rows);
     }
+
+    // The same averages over rows. Time several rounds each.
+    Student *students = (Student *) malloc(n * sizeof(Student));
+    if (students != NULL)
+    {
+        FILE *fp = fopen(DATA_FILE, "rb");
+        size_t loaded = fp ? fread(students, sizeof(Student), n, fp) : 0;
+        if (fp) fclose(fp);
+
+        const int rounds = 20;
+        double row_sum = 0.0, column_sum = 0.0;
+        size_t row_passed = 0;
+        start = clock();
+        for (int r = 0; r < rounds; r++)
+        {
+            row_sum = 0.0;
+            row_passed = 0;
+            for (size_t i = 0; i < loaded; i++)
+            {
+                row_sum += students[i].score;
+                row_passed += students[i].score >= 60.0f && students[i].score <= 100.0f;
+            }
+        }
+        double t_rows = seconds_since(start) / rounds;
+
+        start = clock();
+        for (int r = 0; r < rounds; r++)
+        {
+            column_sum = scores_sum(table.scores, n);
+            passed = scores_summarize_range(table.scores, n, 60.0f, 100.0f);
+        }
+        double t_columns = seconds_since(start) / rounds;
+
+        printf("Sum + filtered count: rows %.3f ms (%zu MB), columns %.3f ms (%zu MB): %.1fx faster, results %s\n",
+               t_rows * 1e3,
+               loaded * sizeof(Student) >> 20,
+               t_columns * 1e3,
+               n * sizeof(float) >> 20,
+               t_rows / t_columns,
+               fabs(row_sum - column_sum) <= 1e-9 * fabs(row_sum) + 1e-6 && row_passed == passed.count ? "agree" : "DIFFER");
+        free(students);
+    }
+
+    table_free(&table);
 }
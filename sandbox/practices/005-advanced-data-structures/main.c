@@ -1,8 +1,12 @@
 #include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 // === TYPEDEFS AND ENUMERATIONS ===
 
@@ -71,7 +75,10 @@ typedef void (*ShapeRenderer)(const Shape *);
 
 // === FUNCTION PROTOTYPES ===
 
-// Create different shapes
+// Create different shapes, as values (make_*) or on the heap (create_*)
+Shape make_circle(float x, float y, float radius, Color color);
+Shape make_rectangle(float x1, float y1, float x2, float y2, Color color);
+Shape make_triangle(const Point points[3], Color color);
 Shape *create_circle(float x, float y, float radius, Color color);
 Shape *create_rectangle(float x1, float y1, float x2, float y2, Color color);
 Shape *create_triangle(Point points[3], Color color);
@@ -95,58 +102,54 @@ const char *get_shape_name(ShapeType type);
 
 // === FUNCTION IMPLEMENTATIONS ===
 
-Shape *create_circle(float x, float y, float radius, Color color)
+// Shapes are returned by value: a compound literal built straight into the
+// caller's variable or array slot, so short-lived shapes never reach malloc
+Shape make_circle(float x, float y, float radius, Color color)
 {
-    Shape *shape = (Shape *) malloc(sizeof(Shape));
-    if (shape == NULL)
-    {
-        return NULL;
-    }
+    return (Shape){.type = SHAPE_CIRCLE,
+                   .color = color,
+                   .data.circle = {.center = {x, y}, .radius = radius}};
+}
 
-    shape->type = SHAPE_CIRCLE;
-    shape->color = color;
-    shape->data.circle.center.x = x;
-    shape->data.circle.center.y = y;
-    shape->data.circle.radius = radius;
+Shape make_rectangle(float x1, float y1, float x2, float y2, Color color)
+{
+    return (Shape){.type = SHAPE_RECTANGLE,
+                   .color = color,
+                   .data.rectangle = {.top_left = {x1, y1}, .bottom_right = {x2, y2}}};
+}
 
-    return shape;
+Shape make_triangle(const Point points[3], Color color)
+{
+    return (Shape){.type = SHAPE_TRIANGLE,
+                   .color = color,
+                   .data.triangle = {.points = {points[0], points[1], points[2]}}};
 }
 
-Shape *create_rectangle(float x1, float y1, float x2, float y2, Color color)
+// Heap copies, for shapes that must outlive their creator; the caller
+// frees them
+static Shape *shape_escape(Shape value)
 {
     Shape *shape = (Shape *) malloc(sizeof(Shape));
-    if (shape == NULL)
+    if (shape != NULL)
     {
-        return NULL;
+        *shape = value;
     }
-
-    shape->type = SHAPE_RECTANGLE;
-    shape->color = color;
-    shape->data.rectangle.top_left.x = x1;
-    shape->data.rectangle.top_left.y = y1;
-    shape->data.rectangle.bottom_right.x = x2;
-    shape->data.rectangle.bottom_right.y = y2;
-
     return shape;
 }
 
-Shape *create_triangle(Point points[3], Color color)
+Shape *create_circle(float x, float y, float radius, Color color)
 {
-    Shape *shape = (Shape *) malloc(sizeof(Shape));
-    if (shape == NULL)
-    {
-        return NULL;
-    }
-
-    shape->type = SHAPE_TRIANGLE;
-    shape->color = color;
+    return shape_escape(make_circle(x, y, radius, color));
+}
 
-    for (int i = 0; i < 3; i++)
-    {
-        shape->data.triangle.points[i] = points[i];
-    }
+Shape *create_rectangle(float x1, float y1, float x2, float y2, Color color)
+{
+    return shape_escape(make_rectangle(x1, y1, x2, y2, color));
+}
 
-    return shape;
+Shape *create_triangle(Point points[3], Color color)
+{
+    return shape_escape(make_triangle(points, color));
 }
 
 float calculate_circle_area(const Shape *shape)
@@ -303,85 +306,2203 @@ const char *get_shape_name(ShapeType type)
     }
 }
 
-int main()
+// === DATA-ORIENTED SCENE ===
+
+// A Scene keeps each shape type in its own structure-of-arrays (one array
+// per field), so a pass over all circles reads only circle data, the
+// per-type kernels vectorize, and no per-object switch or function pointer
+// is involved. A shape is identified by its type and index within that
+// type.
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define SCENE_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define SCENE_CLONES
+#endif
+
+typedef struct
 {
-    printf("==== ADVANCED DATA STRUCTURES DEMO ====\n\n");
+    float *cx;
+    float *cy;
+    float *radius;
+    Color *color;
+    size_t count;
+    size_t capacity;
+} CircleArray;
 
-    // Create some colors using bit fields
-    Color red = create_color(255, 0, 0, 255);
-    Color green = create_color(0, 255, 0, 255);
-    Color blue = create_color(0, 0, 255, 255);
+typedef struct
+{
+    float *x1;  // top_left
+    float *y1;
+    float *x2;  // bottom_right
+    float *y2;
+    Color *color;
+    size_t count;
+    size_t capacity;
+} RectangleArray;
 
-    // Create an array of shapes
-    Shape *shapes[3];
-    StatusCode status = STATUS_SUCCESS;
+typedef struct
+{
+    float *x[3];  // x[k][i] is point k of triangle i
+    float *y[3];
+    Color *color;
+    size_t count;
+    size_t capacity;
+} TriangleArray;
+
+typedef struct
+{
+    CircleArray circles;
+    RectangleArray rectangles;
+    TriangleArray triangles;
+} Scene;
 
-    // Create a circle
-    shapes[0] = create_circle(0.0f, 0.0f, 5.0f, red);
-    if (shapes[0] == NULL)
+void scene_init(Scene *scene)
+{
+    memset(scene, 0, sizeof(*scene));
+}
+
+void scene_free(Scene *scene)
+{
+    free(scene->circles.cx);
+    free(scene->circles.cy);
+    free(scene->circles.radius);
+    free(scene->circles.color);
+    free(scene->rectangles.x1);
+    free(scene->rectangles.y1);
+    free(scene->rectangles.x2);
+    free(scene->rectangles.y2);
+    free(scene->rectangles.color);
+    for (int k = 0; k < 3; k++)
     {
-        status = STATUS_ERROR_OUT_OF_MEMORY;
-        goto cleanup;
+        free(scene->triangles.x[k]);
+        free(scene->triangles.y[k]);
+    }
+    free(scene->triangles.color);
+    scene_init(scene);
+}
+
+size_t scene_count(const Scene *scene)
+{
+    return scene->circles.count + scene->rectangles.count
+           + scene->triangles.count;
+}
+
+// Resize one column; on failure the column keeps its old size and contents
+static bool grow_column(void **column, size_t capacity, size_t elem_size)
+{
+    void *grown = realloc(*column, capacity * elem_size);
+    if (grown == NULL) return false;
+    *column = grown;
+    return true;
+}
+
+// Capacity to grow to so that one more element fits, or 0 if there is room
+static size_t next_capacity(size_t count, size_t capacity)
+{
+    if (count < capacity) return 0;
+    return capacity ? capacity * 2 : 64;
+}
+
+StatusCode scene_add_circle(Scene *scene, float x, float y, float radius, Color color)
+{
+    CircleArray *c = &scene->circles;
+    size_t capacity = next_capacity(c->count, c->capacity);
+
+    if (capacity != 0)
+    {
+        // A column that grew before a later one failed is merely roomier
+        if (!grow_column((void **) &c->cx, capacity, sizeof(float))
+            || !grow_column((void **) &c->cy, capacity, sizeof(float))
+            || !grow_column((void **) &c->radius, capacity, sizeof(float))
+            || !grow_column((void **) &c->color, capacity, sizeof(Color)))
+        {
+            return STATUS_ERROR_OUT_OF_MEMORY;
+        }
+        c->capacity = capacity;
     }
 
-    // Create a rectangle
-    shapes[1] = create_rectangle(0.0f, 0.0f, 10.0f, 5.0f, green);
-    if (shapes[1] == NULL)
+    c->cx[c->count] = x;
+    c->cy[c->count] = y;
+    c->radius[c->count] = radius;
+    c->color[c->count] = color;
+    c->count++;
+    return STATUS_SUCCESS;
+}
+
+StatusCode scene_add_rectangle(Scene *scene, float x1, float y1, float x2, float y2, Color color)
+{
+    RectangleArray *r = &scene->rectangles;
+    size_t capacity = next_capacity(r->count, r->capacity);
+
+    if (capacity != 0)
     {
-        status = STATUS_ERROR_OUT_OF_MEMORY;
-        goto cleanup;
+        if (!grow_column((void **) &r->x1, capacity, sizeof(float))
+            || !grow_column((void **) &r->y1, capacity, sizeof(float))
+            || !grow_column((void **) &r->x2, capacity, sizeof(float))
+            || !grow_column((void **) &r->y2, capacity, sizeof(float))
+            || !grow_column((void **) &r->color, capacity, sizeof(Color)))
+        {
+            return STATUS_ERROR_OUT_OF_MEMORY;
+        }
+        r->capacity = capacity;
     }
 
-    // Create a triangle
-    Point triangle_points[3] = {{0.0f, 0.0f}, {5.0f, 10.0f}, {10.0f, 0.0f}};
-    shapes[2] = create_triangle(triangle_points, blue);
-    if (shapes[2] == NULL)
+    r->x1[r->count] = x1;
+    r->y1[r->count] = y1;
+    r->x2[r->count] = x2;
+    r->y2[r->count] = y2;
+    r->color[r->count] = color;
+    r->count++;
+    return STATUS_SUCCESS;
+}
+
+StatusCode scene_add_triangle(Scene *scene, Point points[3], Color color)
+{
+    TriangleArray *t = &scene->triangles;
+    size_t capacity = next_capacity(t->count, t->capacity);
+
+    if (capacity != 0)
     {
-        status = STATUS_ERROR_OUT_OF_MEMORY;
-        goto cleanup;
+        for (int k = 0; k < 3; k++)
+        {
+            if (!grow_column((void **) &t->x[k], capacity, sizeof(float))
+                || !grow_column((void **) &t->y[k], capacity, sizeof(float)))
+            {
+                return STATUS_ERROR_OUT_OF_MEMORY;
+            }
+        }
+        if (!grow_column((void **) &t->color, capacity, sizeof(Color)))
+        {
+            return STATUS_ERROR_OUT_OF_MEMORY;
+        }
+        t->capacity = capacity;
     }
 
-    // Create an array of function pointers for area calculation
-    AreaCalculator area_calculators[3] = {calculate_circle_area, calculate_rectangle_area, calculate_triangle_area};
+    for (int k = 0; k < 3; k++)
+    {
+        t->x[k][t->count] = points[k].x;
+        t->y[k][t->count] = points[k].y;
+    }
+    t->color[t->count] = color;
+    t->count++;
+    return STATUS_SUCCESS;
+}
 
-    // Render all shapes
-    for (int i = 0; i < 3; i++)
+// Copy a tagged-union Shape into the matching array
+StatusCode scene_add_shape(Scene *scene, const Shape *shape)
+{
+    if (shape == NULL) return STATUS_ERROR_INVALID_INPUT;
+
+    switch (shape->type)
+    {
+    case SHAPE_CIRCLE:
+        return scene_add_circle(scene,
+                                shape->data.circle.center.x,
+                                shape->data.circle.center.y,
+                                shape->data.circle.radius,
+                                shape->color);
+    case SHAPE_RECTANGLE:
+        return scene_add_rectangle(scene,
+                                   shape->data.rectangle.top_left.x,
+                                   shape->data.rectangle.top_left.y,
+                                   shape->data.rectangle.bottom_right.x,
+                                   shape->data.rectangle.bottom_right.y,
+                                   shape->color);
+    case SHAPE_TRIANGLE:
     {
-        render_shape(shapes[i]);
+        Point points[3];
+        memcpy(points, shape->data.triangle.points, sizeof(points));
+        return scene_add_triangle(scene, points, shape->color);
+    }
+    default:
+        return STATUS_ERROR_INVALID_INPUT;
     }
+}
 
-    // Use function pointers to calculate areas
-    printf("Using function pointers for area calculations:\n");
-    for (int i = 0; i < 3; i++)
+// Batched area kernels: plain loops over the columns that the compiler
+// vectorizes, built for AVX-512, AVX2 and baseline x86-64 and picked at
+// load time. out[i] is the area of shape i of that type.
+
+SCENE_CLONES void circle_areas(const CircleArray *c, float *restrict out)
+{
+    const float *restrict radius = c->radius;
+    for (size_t i = 0; i < c->count; i++)
     {
-        float area = area_calculators[i](shapes[i]);
-        printf("%s area: %.2f square units\n", get_shape_name(shapes[i]->type), area);
+        out[i] = 3.14159f * radius[i] * radius[i];
     }
+}
 
-cleanup:
-    // Display status
-    print_status(status);
+SCENE_CLONES void rectangle_areas(const RectangleArray *r, float *restrict out)
+{
+    const float *restrict x1 = r->x1;
+    const float *restrict y1 = r->y1;
+    const float *restrict x2 = r->x2;
+    const float *restrict y2 = r->y2;
+    for (size_t i = 0; i < r->count; i++)
+    {
+        out[i] = (x2[i] - x1[i]) * (y2[i] - y1[i]);
+    }
+}
 
-    // Free resources
-    for (int i = 0; i < 3; i++)
+// Half the cross product of two edges: the same area Heron's formula in
+// calculate_triangle_area gives, with two fewer square roots and without
+// its cancellation for thin triangles
+SCENE_CLONES void triangle_areas(const TriangleArray *t, float *restrict out)
+{
+    const float *restrict x0 = t->x[0];
+    const float *restrict y0 = t->y[0];
+    const float *restrict x1 = t->x[1];
+    const float *restrict y1 = t->y[1];
+    const float *restrict x2 = t->x[2];
+    const float *restrict y2 = t->y[2];
+    for (size_t i = 0; i < t->count; i++)
+    {
+        float cross = (x1[i] - x0[i]) * (y2[i] - y0[i])
+                      - (x2[i] - x0[i]) * (y1[i] - y0[i]);
+        out[i] = 0.5f * fabsf(cross);
+    }
+}
+
+// Areas of every shape, grouped by type. Each array must hold that type's
+// count; any may be NULL to skip the type.
+void scene_compute_areas(const Scene *scene, float *circle_out, float *rectangle_out, float *triangle_out)
+{
+    if (circle_out) circle_areas(&scene->circles, circle_out);
+    if (rectangle_out) rectangle_areas(&scene->rectangles, rectangle_out);
+    if (triangle_out) triangle_areas(&scene->triangles, triangle_out);
+}
+
+// Sum of all areas, computed in blocks so no scene-sized buffer is needed
+SCENE_CLONES float sum_floats(const float *values, size_t n)
+{
+    // Independent partial sums, so the adds vectorize without -ffast-math
+    float partial[16] = {0};
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
     {
-        if (shapes[i] != NULL)
+        for (int j = 0; j < 16; j++)
         {
-            free(shapes[i]);
-            shapes[i] = NULL;
+            partial[j] += values[i + j];
         }
     }
+    float sum = 0.0f;
+    for (int j = 0; j < 16; j++)
+    {
+        sum += partial[j];
+    }
+    for (; i < n; i++)
+    {
+        sum += values[i];
+    }
+    return sum;
+}
 
-    // Print memory usage information
-    printf("\nMemory Usage Information:\n");
-    printf("Size of Color (bit fields): %zu bytes\n", sizeof(Color));
-    printf("Size of Point: %zu bytes\n", sizeof(Point));
-    printf("Size of Shape: %zu bytes\n", sizeof(Shape));
+#define SCENE_AREA_BLOCK 4096
 
-    printf("\n=== Size of Each Shape Union Member ===\n");
-    printf("Circle struct: %zu bytes\n", sizeof(((Shape *) 0)->data.circle));
-    printf("Rectangle struct: %zu bytes\n", sizeof(((Shape *) 0)->data.rectangle));
-    printf("Triangle struct: %zu bytes\n", sizeof(((Shape *) 0)->data.triangle));
+double scene_total_area(const Scene *scene)
+{
+    float areas[SCENE_AREA_BLOCK];
+    double total = 0.0;
+
+    // Run each kernel on a window of its arrays, one block at a time
+    CircleArray c = scene->circles;
+    for (size_t i = 0; i < scene->circles.count; i += SCENE_AREA_BLOCK)
+    {
+        c.radius = scene->circles.radius + i;
+        c.count = scene->circles.count - i < SCENE_AREA_BLOCK ? scene->circles.count - i : SCENE_AREA_BLOCK;
+        circle_areas(&c, areas);
+        total += sum_floats(areas, c.count);
+    }
+
+    RectangleArray r = scene->rectangles;
+    for (size_t i = 0; i < scene->rectangles.count; i += SCENE_AREA_BLOCK)
+    {
+        r.x1 = scene->rectangles.x1 + i;
+        r.y1 = scene->rectangles.y1 + i;
+        r.x2 = scene->rectangles.x2 + i;
+        r.y2 = scene->rectangles.y2 + i;
+        r.count = scene->rectangles.count - i < SCENE_AREA_BLOCK ? scene->rectangles.count - i : SCENE_AREA_BLOCK;
+        rectangle_areas(&r, areas);
+        total += sum_floats(areas, r.count);
+    }
+
+    TriangleArray t = scene->triangles;
+    for (size_t i = 0; i < scene->triangles.count; i += SCENE_AREA_BLOCK)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            t.x[k] = scene->triangles.x[k] + i;
+            t.y[k] = scene->triangles.y[k] + i;
+        }
+        t.count = scene->triangles.count - i < SCENE_AREA_BLOCK ? scene->triangles.count - i : SCENE_AREA_BLOCK;
+        triangle_areas(&t, areas);
+        total += sum_floats(areas, t.count);
+    }
+
+    return total;
+}
+
+// Batched rendering: one loop per type, same output as render_shape
+void render_circles(const CircleArray *c)
+{
+    for (size_t i = 0; i < c->count; i++)
+    {
+        printf("Rendering Circle...\n");
+        printf("Circle at (%.1f, %.1f) with radius %.1f\n", c->cx[i], c->cy[i], c->radius[i]);
+        printf("  Color: RGBA(%u, %u, %u, %u)\n", c->color[i].red, c->color[i].green, c->color[i].blue, c->color[i].alpha);
+        printf("  Area: %.2f square units\n\n", 3.14159f * c->radius[i] * c->radius[i]);
+    }
+}
+
+void render_rectangles(const RectangleArray *r)
+{
+    for (size_t i = 0; i < r->count; i++)
+    {
+        printf("Rendering Rectangle...\n");
+        printf("Rectangle from (%.1f, %.1f) to (%.1f, %.1f)\n", r->x1[i], r->y1[i], r->x2[i], r->y2[i]);
+        printf("  Color: RGBA(%u, %u, %u, %u)\n", r->color[i].red, r->color[i].green, r->color[i].blue, r->color[i].alpha);
+        printf("  Area: %.2f square units\n\n", (r->x2[i] - r->x1[i]) * (r->y2[i] - r->y1[i]));
+    }
+}
+
+void render_triangles(const TriangleArray *t)
+{
+    for (size_t i = 0; i < t->count; i++)
+    {
+        printf("Rendering Triangle...\n");
+        printf("Triangle with points:\n");
+        for (int k = 0; k < 3; k++)
+        {
+            printf("  Point %d: (%.1f, %.1f)\n", k + 1, t->x[k][i], t->y[k][i]);
+        }
+        printf("  Color: RGBA(%u, %u, %u, %u)\n", t->color[i].red, t->color[i].green, t->color[i].blue, t->color[i].alpha);
+        float cross = (t->x[1][i] - t->x[0][i]) * (t->y[2][i] - t->y[0][i])
+                      - (t->x[2][i] - t->x[0][i]) * (t->y[1][i] - t->y[0][i]);
+        printf("  Area: %.2f square units\n\n", 0.5f * fabsf(cross));
+    }
+}
+
+void scene_render(const Scene *scene)
+{
+    render_circles(&scene->circles);
+    render_rectangles(&scene->rectangles);
+    render_triangles(&scene->triangles);
+}
+
+// Random shape of a random type, so per-object dispatch is unpredictable
+static void random_shape(Shape *shape, Color color)
+{
+    float x = (float) (rand() % 1000);
+    float y = (float) (rand() % 1000);
+    float size = 1.0f + (float) (rand() % 20);
+
+    shape->color = color;
+    shape->type = (ShapeType) (rand() % 3);
+    switch (shape->type)
+    {
+    case SHAPE_CIRCLE:
+        shape->data.circle.center = (Point){x, y};
+        shape->data.circle.radius = size;
+        break;
+    case SHAPE_RECTANGLE:
+        shape->data.rectangle.top_left = (Point){x, y};
+        shape->data.rectangle.bottom_right = (Point){x + size, y + size / 2};
+        break;
+    case SHAPE_TRIANGLE:
+        shape->data.triangle.points[0] = (Point){x, y};
+        shape->data.triangle.points[1] = (Point){x + size / 2, y + size};
+        shape->data.triangle.points[2] = (Point){x + size, y};
+        break;
+    }
+}
+
+static double seconds_since(clock_t start)
+{
+    return ((double) (clock() - start)) / CLOCKS_PER_SEC;
+}
+
+// Total area of n shapes: individually allocated Shapes through the switch
+// and through a function-pointer table, versus the Scene's batched kernels
+void benchmark_scene(size_t n)
+{
+    printf("\n=== Benchmark: %zu shapes, total area ===\n", n);
+
+    Shape **shapes = (Shape **) malloc(n * sizeof(Shape *));
+    Scene scene;
+    scene_init(&scene);
+    if (shapes == NULL) return;
+
+    srand(11);
+    size_t created = 0;
+    for (; created < n; created++)
+    {
+        shapes[created] = (Shape *) malloc(sizeof(Shape));
+        if (shapes[created] == NULL) break;
+        random_shape(shapes[created], create_color(255, 255, 255, 255));
+        if (scene_add_shape(&scene, shapes[created]) != STATUS_SUCCESS) break;
+    }
+
+    const int rounds = 10;
+    AreaCalculator area_calculators[3] = {calculate_circle_area, calculate_rectangle_area, calculate_triangle_area};
+    double switch_total = 0.0, table_total = 0.0, scene_total = 0.0;
+
+    clock_t start = clock();
+    for (int r = 0; r < rounds; r++)
+    {
+        switch_total = 0.0;
+        for (size_t i = 0; i < created; i++)
+        {
+            switch_total += calculate_shape_area(shapes[i]);
+        }
+    }
+    double t_switch = seconds_since(start) / rounds;
+
+    start = clock();
+    for (int r = 0; r < rounds; r++)
+    {
+        table_total = 0.0;
+        for (size_t i = 0; i < created; i++)
+        {
+            table_total += area_calculators[shapes[i]->type](shapes[i]);
+        }
+    }
+    double t_table = seconds_since(start) / rounds;
+
+    start = clock();
+    for (int r = 0; r < rounds; r++)
+    {
+        scene_total = scene_total_area(&scene);
+    }
+    double t_scene = seconds_since(start) / rounds;
+
+    printf("Shape * + switch:         %.4f s (total %.1f)\n", t_switch, switch_total);
+    printf("Shape * + function table: %.4f s (total %.1f)\n", t_table, table_total);
+    printf("Scene batched kernels:    %.4f s (total %.1f, %.1fx faster)\n", t_scene, scene_total, t_switch / t_scene);
+
+    for (size_t i = 0; i < created; i++)
+    {
+        free(shapes[i]);
+    }
+    free(shapes);
+    scene_free(&scene);
+}
+
+void demo_scene(void)
+{
+    printf("\n=== Data-Oriented Scene ===\n");
+
+    Scene scene;
+    scene_init(&scene);
+
+    Point points[3] = {{0.0f, 0.0f}, {5.0f, 10.0f}, {10.0f, 0.0f}};
+    StatusCode status = scene_add_circle(&scene, 0.0f, 0.0f, 5.0f, create_color(255, 0, 0, 255));
+    if (status == STATUS_SUCCESS) status = scene_add_triangle(&scene, points, create_color(0, 0, 255, 255));
+    if (status == STATUS_SUCCESS) status = scene_add_rectangle(&scene, 0.0f, 0.0f, 10.0f, 5.0f, create_color(0, 255, 0, 255));
+    if (status == STATUS_SUCCESS) status = scene_add_circle(&scene, 3.0f, 4.0f, 1.0f, create_color(255, 255, 0, 128));
+
+    if (status != STATUS_SUCCESS)
+    {
+        print_status(status);
+        scene_free(&scene);
+        return;
+    }
+
+    // Rendered grouped by type rather than in insertion order
+    scene_render(&scene);
+    printf("Scene of %zu shapes, total area %.2f square units\n", scene_count(&scene), scene_total_area(&scene));
+
+    scene_free(&scene);
+}
+
+// === PACKED COLORS ===
+
+// A pixel buffer is an array of PackedColor: one 32-bit word per pixel with
+// the same channel order as the Color bit-fields (blue in the low byte,
+// alpha in the high byte). The kernels below process whole buffers with
+// shifts and masks on 32-bit lanes, which the compiler vectorizes; going
+// through Color costs a bit-field extract and insert per channel per pixel.
+
+typedef uint32_t PackedColor;
+
+#define COLOR_BLUE_SHIFT 0
+#define COLOR_GREEN_SHIFT 8
+#define COLOR_RED_SHIFT 16
+#define COLOR_ALPHA_SHIFT 24
+
+#define PACKED_CHANNEL(p, shift) (((p) >> (shift)) & 0xFFu)
+
+// x / 255 rounded to nearest, exact for x in [0, 255 * 255], without a divide
+#define DIV_255(x) (((x) + 128u + (((x) + 128u) >> 8)) >> 8)
+
+PackedColor color_pack(Color color)
+{
+    return (PackedColor) color.blue << COLOR_BLUE_SHIFT | (PackedColor) color.green << COLOR_GREEN_SHIFT
+           | (PackedColor) color.red << COLOR_RED_SHIFT | (PackedColor) color.alpha << COLOR_ALPHA_SHIFT;
+}
+
+Color color_unpack(PackedColor packed)
+{
+    return create_color(PACKED_CHANNEL(packed, COLOR_RED_SHIFT),
+                        PACKED_CHANNEL(packed, COLOR_GREEN_SHIFT),
+                        PACKED_CHANNEL(packed, COLOR_BLUE_SHIFT),
+                        PACKED_CHANNEL(packed, COLOR_ALPHA_SHIFT));
+}
+
+// Per-pixel operations, shared by the kernels' vector body and scalar tail.
+// The kernels walk the buffer in fixed blocks of COLOR_BLOCK pixels: at -O2
+// GCC only vectorizes loops whose trip count is known.
+
+#define COLOR_BLOCK 16
+
+static inline void pixel_to_float(PackedColor p, float *restrict rgba)
+{
+    const float scale = 1.0f / 255.0f;
+    rgba[0] = (float) PACKED_CHANNEL(p, COLOR_RED_SHIFT) * scale;
+    rgba[1] = (float) PACKED_CHANNEL(p, COLOR_GREEN_SHIFT) * scale;
+    rgba[2] = (float) PACKED_CHANNEL(p, COLOR_BLUE_SHIFT) * scale;
+    rgba[3] = (float) PACKED_CHANNEL(p, COLOR_ALPHA_SHIFT) * scale;
+}
+
+// Clamp to [0, 1] (NaN becomes 0) and round to 8 bits
+static inline PackedColor channel_from_float(float v)
+{
+    v = v > 0.0f ? v : 0.0f;  // false for NaN
+    v = v < 1.0f ? v : 1.0f;
+    return (PackedColor) (v * 255.0f + 0.5f);
+}
+
+static inline PackedColor pixel_from_float(const float *restrict rgba)
+{
+    return channel_from_float(rgba[0]) << COLOR_RED_SHIFT | channel_from_float(rgba[1]) << COLOR_GREEN_SHIFT
+           | channel_from_float(rgba[2]) << COLOR_BLUE_SHIFT | channel_from_float(rgba[3]) << COLOR_ALPHA_SHIFT;
+}
+
+static inline PackedColor pixel_blend(PackedColor d, PackedColor s)
+{
+    PackedColor a = PACKED_CHANNEL(s, COLOR_ALPHA_SHIFT);
+    PackedColor inv = 255u - a;
+    PackedColor r = DIV_255(PACKED_CHANNEL(s, COLOR_RED_SHIFT) * a + PACKED_CHANNEL(d, COLOR_RED_SHIFT) * inv);
+    PackedColor g = DIV_255(PACKED_CHANNEL(s, COLOR_GREEN_SHIFT) * a + PACKED_CHANNEL(d, COLOR_GREEN_SHIFT) * inv);
+    PackedColor b = DIV_255(PACKED_CHANNEL(s, COLOR_BLUE_SHIFT) * a + PACKED_CHANNEL(d, COLOR_BLUE_SHIFT) * inv);
+    PackedColor out_a = a + DIV_255(PACKED_CHANNEL(d, COLOR_ALPHA_SHIFT) * inv);
+    return r << COLOR_RED_SHIFT | g << COLOR_GREEN_SHIFT | b << COLOR_BLUE_SHIFT | out_a << COLOR_ALPHA_SHIFT;
+}
+
+static inline PackedColor pixel_premultiply(PackedColor p)
+{
+    PackedColor a = PACKED_CHANNEL(p, COLOR_ALPHA_SHIFT);
+    PackedColor r = DIV_255(PACKED_CHANNEL(p, COLOR_RED_SHIFT) * a);
+    PackedColor g = DIV_255(PACKED_CHANNEL(p, COLOR_GREEN_SHIFT) * a);
+    PackedColor b = DIV_255(PACKED_CHANNEL(p, COLOR_BLUE_SHIFT) * a);
+    return r << COLOR_RED_SHIFT | g << COLOR_GREEN_SHIFT | b << COLOR_BLUE_SHIFT | a << COLOR_ALPHA_SHIFT;
+}
+
+static inline PackedColor pixel_composite(PackedColor d, PackedColor s)
+{
+    PackedColor inv = 255u - PACKED_CHANNEL(s, COLOR_ALPHA_SHIFT);
+    return (PACKED_CHANNEL(s, 0) + DIV_255(PACKED_CHANNEL(d, 0) * inv))
+           | (PACKED_CHANNEL(s, 8) + DIV_255(PACKED_CHANNEL(d, 8) * inv)) << 8
+           | (PACKED_CHANNEL(s, 16) + DIV_255(PACKED_CHANNEL(d, 16) * inv)) << 16
+           | (PACKED_CHANNEL(s, 24) + DIV_255(PACKED_CHANNEL(d, 24) * inv)) << 24;
+}
+
+// Pixels to floats in [0, 1], four per pixel in R, G, B, A order
+SCENE_CLONES void colors_to_float(const PackedColor *restrict src, float *restrict dst, size_t n)
+{
+    size_t i = 0;
+    for (; i + COLOR_BLOCK <= n; i += COLOR_BLOCK)
+    {
+        for (int j = 0; j < COLOR_BLOCK; j++)
+        {
+            pixel_to_float(src[i + j], dst + 4 * (i + j));
+        }
+    }
+    for (; i < n; i++)
+    {
+        pixel_to_float(src[i], dst + 4 * i);
+    }
+}
+
+// Inverse of colors_to_float: values are clamped to [0, 1] and rounded
+SCENE_CLONES void colors_from_float(const float *restrict src, PackedColor *restrict dst, size_t n)
+{
+    size_t i = 0;
+    for (; i + COLOR_BLOCK <= n; i += COLOR_BLOCK)
+    {
+        for (int j = 0; j < COLOR_BLOCK; j++)
+        {
+            dst[i + j] = pixel_from_float(src + 4 * (i + j));
+        }
+    }
+    for (; i < n; i++)
+    {
+        dst[i] = pixel_from_float(src + 4 * i);
+    }
+}
+
+// Straight-alpha "source over": each channel becomes
+// (src * a + dst * (255 - a)) / 255 with a the source alpha, and the result
+// alpha is a + dst_alpha * (255 - a) / 255. dst is updated in place.
+SCENE_CLONES void colors_blend(PackedColor *restrict dst, const PackedColor *restrict src, size_t n)
+{
+    size_t i = 0;
+    for (; i + COLOR_BLOCK <= n; i += COLOR_BLOCK)
+    {
+        for (int j = 0; j < COLOR_BLOCK; j++)
+        {
+            dst[i + j] = pixel_blend(dst[i + j], src[i + j]);
+        }
+    }
+    for (; i < n; i++)
+    {
+        dst[i] = pixel_blend(dst[i], src[i]);
+    }
+}
+
+// Scale each pixel's color channels by its alpha, in place
+SCENE_CLONES void colors_premultiply(PackedColor *restrict pixels, size_t n)
+{
+    size_t i = 0;
+    for (; i + COLOR_BLOCK <= n; i += COLOR_BLOCK)
+    {
+        for (int j = 0; j < COLOR_BLOCK; j++)
+        {
+            pixels[i + j] = pixel_premultiply(pixels[i + j]);
+        }
+    }
+    for (; i < n; i++)
+    {
+        pixels[i] = pixel_premultiply(pixels[i]);
+    }
+}
+
+// Premultiplied "source over": every channel, alpha included, becomes
+// src + dst * (255 - src_alpha) / 255. Both buffers must already be
+// premultiplied; the result is too. Cheaper than colors_blend (one
+// multiply per channel instead of two) and correct for translucent dst.
+SCENE_CLONES void colors_composite(PackedColor *restrict dst, const PackedColor *restrict src, size_t n)
+{
+    size_t i = 0;
+    for (; i + COLOR_BLOCK <= n; i += COLOR_BLOCK)
+    {
+        for (int j = 0; j < COLOR_BLOCK; j++)
+        {
+            dst[i + j] = pixel_composite(dst[i + j], src[i + j]);
+        }
+    }
+    for (; i < n; i++)
+    {
+        dst[i] = pixel_composite(dst[i], src[i]);
+    }
+}
+
+// The same blend one Color at a time through the bit-fields: the baseline
+Color color_blend(Color dst, Color src)
+{
+    unsigned int a = src.alpha, inv = 255u - a;
+    return create_color(DIV_255(src.red * a + dst.red * inv),
+                        DIV_255(src.green * a + dst.green * inv),
+                        DIV_255(src.blue * a + dst.blue * inv),
+                        a + DIV_255(dst.alpha * inv));
+}
+
+void demo_packed_colors(void)
+{
+    printf("\n=== Packed Colors ===\n");
+
+    Color red = create_color(255, 0, 0, 255);
+    Color half_blue = create_color(0, 0, 255, 128);
+    PackedColor pixels[2] = {color_pack(red), color_pack(red)};
+    PackedColor over[2] = {color_pack(half_blue), color_pack(create_color(0, 255, 0, 0))};
+    printf("Packed red: 0x%08X, half-transparent blue: 0x%08X\n", pixels[0], over[0]);
+
+    colors_blend(pixels, over, 2);
+    Color mixed = color_unpack(pixels[0]);
+    printf("Blue at 50%% over red: RGBA(%u, %u, %u, %u); transparent green leaves 0x%08X\n",
+           mixed.red,
+           mixed.green,
+           mixed.blue,
+           mixed.alpha,
+           pixels[1]);
+
+    // Premultiplied compositing of the same pair gives the same pixel
+    PackedColor base = color_pack(red), top = color_pack(half_blue);
+    colors_premultiply(&top, 1);
+    colors_composite(&base, &top, 1);
+    printf("Premultiplied composite: 0x%08X (blend gave 0x%08X)\n", base, pixels[0]);
+
+    float rgba[4];
+    colors_to_float(&pixels[0], rgba, 1);
+    printf("As floats: (%.3f, %.3f, %.3f, %.3f)\n", rgba[0], rgba[1], rgba[2], rgba[3]);
+}
+
+// Blending n pixels: Color bit-fields one at a time vs the packed kernels
+void benchmark_packed_colors(size_t n)
+{
+    printf("\n=== Benchmark: blending %zu pixels ===\n", n);
+
+    Color *dst_colors = (Color *) malloc(n * sizeof(Color));
+    Color *src_colors = (Color *) malloc(n * sizeof(Color));
+    PackedColor *dst = (PackedColor *) malloc(n * sizeof(PackedColor));
+    PackedColor *src = (PackedColor *) malloc(n * sizeof(PackedColor));
+    float *rgba = (float *) malloc(4 * n * sizeof(float));
+    if (!dst_colors || !src_colors || !dst || !src || !rgba)
+    {
+        print_status(STATUS_ERROR_OUT_OF_MEMORY);
+        free(dst_colors);
+        free(src_colors);
+        free(dst);
+        free(src);
+        free(rgba);
+        return;
+    }
+
+    srand(56);
+    for (size_t i = 0; i < n; i++)
+    {
+        dst_colors[i] = create_color(rand() % 256, rand() % 256, rand() % 256, 255);
+        src_colors[i] = create_color(rand() % 256, rand() % 256, rand() % 256, rand() % 256);
+        dst[i] = color_pack(dst_colors[i]);
+        src[i] = color_pack(src_colors[i]);
+    }
+
+    const int rounds = 10;
+    clock_t start = clock();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            dst_colors[i] = color_blend(dst_colors[i], src_colors[i]);
+        }
+    }
+    double t_bitfield = seconds_since(start) / rounds;
+
+    start = clock();
+    for (int r = 0; r < rounds; r++)
+    {
+        colors_blend(dst, src, n);
+    }
+    double t_packed = seconds_since(start) / rounds;
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        mismatches += color_pack(dst_colors[i]) != dst[i];
+    }
+    printf("Blend, Color bit-fields: %.3f ms\n", t_bitfield * 1e3);
+    printf("Blend, packed kernels:   %.3f ms (%.1fx faster, %zu mismatches)\n",
+           t_packed * 1e3,
+           t_bitfield / t_packed,
+           mismatches);
+
+    colors_premultiply(src, n);
+    start = clock();
+    for (int r = 0; r < rounds; r++)
+    {
+        colors_composite(dst, src, n);
+    }
+    printf("Premultiplied composite: %.3f ms\n", seconds_since(start) / rounds * 1e3);
+
+    start = clock();
+    for (int r = 0; r < rounds; r++)
+    {
+        colors_to_float(dst, rgba, n);
+        colors_from_float(rgba, dst, n);
+    }
+    printf("To float and back:       %.3f ms\n", seconds_since(start) / rounds * 1e3);
+
+    free(dst_colors);
+    free(src_colors);
+    free(dst);
+    free(src);
+    free(rgba);
+}
+
+// === SPATIAL INDEX ===
+
+// Two acceleration structures over the bounding boxes of a Scene's shapes:
+// a uniform grid, best when shapes are spread evenly, and a BVH built with
+// the surface area heuristic (SAH), which adapts to clustered scenes. Both
+// answer the same three queries:
+//   - point: shapes containing a point (exact test, not just the box)
+//   - rectangle: shapes whose bounding box overlaps a rectangle
+//   - nearest: the k shapes closest to a point
+// Query results are ShapeRefs into the Scene the index was built from; the
+// index must be rebuilt after shapes are added. Queries only read the
+// index, so any number of threads may query at once.
+
+typedef struct
+{
+    float min_x;
+    float min_y;
+    float max_x;
+    float max_y;
+} Box;
+
+typedef struct
+{
+    ShapeType type;
+    uint32_t index;  // position within the scene's array for that type
+} ShapeRef;
+
+static Box box_empty(void)
+{
+    return (Box){INFINITY, INFINITY, -INFINITY, -INFINITY};
+}
+
+// Comparisons rather than fminf/fmaxf: coordinates are never NaN, and these
+// compile to single min/max instructions instead of library calls
+static Box box_union(Box a, Box b)
+{
+    return (Box){a.min_x < b.min_x ? a.min_x : b.min_x,
+                 a.min_y < b.min_y ? a.min_y : b.min_y,
+                 a.max_x > b.max_x ? a.max_x : b.max_x,
+                 a.max_y > b.max_y ? a.max_y : b.max_y};
+}
+
+static bool box_overlaps(Box a, Box b)
+{
+    return a.min_x <= b.max_x && b.min_x <= a.max_x && a.min_y <= b.max_y && b.min_y <= a.max_y;
+}
+
+static bool box_contains(Box b, Point p)
+{
+    return p.x >= b.min_x && p.x <= b.max_x && p.y >= b.min_y && p.y <= b.max_y;
+}
+
+// Squared distance from p to the box (0 inside): a lower bound on the
+// distance to anything the box encloses
+static float box_distance_sq(Box b, Point p)
+{
+    float dx = fmaxf(fmaxf(b.min_x - p.x, 0.0f), p.x - b.max_x);
+    float dy = fmaxf(fmaxf(b.min_y - p.y, 0.0f), p.y - b.max_y);
+    return dx * dx + dy * dy;
+}
+
+// Half-perimeter: proportional to the chance a random query line hits the
+// box, which is all SAH needs in 2D
+static float box_half_perimeter(Box b)
+{
+    return (b.max_x - b.min_x) + (b.max_y - b.min_y);
+}
+
+Box scene_shape_bounds(const Scene *scene, ShapeRef ref)
+{
+    uint32_t i = ref.index;
+
+    switch (ref.type)
+    {
+    case SHAPE_CIRCLE:
+    {
+        const CircleArray *c = &scene->circles;
+        return (Box){c->cx[i] - c->radius[i], c->cy[i] - c->radius[i], c->cx[i] + c->radius[i], c->cy[i] + c->radius[i]};
+    }
+    case SHAPE_RECTANGLE:
+    {
+        // Corners may come in either order
+        const RectangleArray *r = &scene->rectangles;
+        return (Box){fminf(r->x1[i], r->x2[i]), fminf(r->y1[i], r->y2[i]), fmaxf(r->x1[i], r->x2[i]), fmaxf(r->y1[i], r->y2[i])};
+    }
+    case SHAPE_TRIANGLE:
+    {
+        const TriangleArray *t = &scene->triangles;
+        Box b = box_empty();
+        for (int k = 0; k < 3; k++)
+        {
+            b = box_union(b, (Box){t->x[k][i], t->y[k][i], t->x[k][i], t->y[k][i]});
+        }
+        return b;
+    }
+    default:
+        return box_empty();
+    }
+}
+
+// Signed double area of (a, b, p): which side of edge a->b the point is on
+static float edge_side(float ax, float ay, float bx, float by, Point p)
+{
+    return (bx - ax) * (p.y - ay) - (by - ay) * (p.x - ax);
+}
+
+// Exact point-in-shape test (boundary counts as inside)
+bool scene_shape_contains(const Scene *scene, ShapeRef ref, Point p)
+{
+    uint32_t i = ref.index;
+
+    switch (ref.type)
+    {
+    case SHAPE_CIRCLE:
+    {
+        float dx = p.x - scene->circles.cx[i];
+        float dy = p.y - scene->circles.cy[i];
+        return dx * dx + dy * dy <= scene->circles.radius[i] * scene->circles.radius[i];
+    }
+    case SHAPE_RECTANGLE:
+        return box_contains(scene_shape_bounds(scene, ref), p);
+    case SHAPE_TRIANGLE:
+    {
+        const TriangleArray *t = &scene->triangles;
+        float d0 = edge_side(t->x[0][i], t->y[0][i], t->x[1][i], t->y[1][i], p);
+        float d1 = edge_side(t->x[1][i], t->y[1][i], t->x[2][i], t->y[2][i], p);
+        float d2 = edge_side(t->x[2][i], t->y[2][i], t->x[0][i], t->y[0][i], p);
+        // Inside when on the same side of all three edges, either winding
+        bool has_negative = d0 < 0 || d1 < 0 || d2 < 0;
+        bool has_positive = d0 > 0 || d1 > 0 || d2 > 0;
+        return !(has_negative && has_positive);
+    }
+    default:
+        return false;
+    }
+}
+
+static float segment_distance_sq(float ax, float ay, float bx, float by, Point p)
+{
+    float ex = bx - ax, ey = by - ay;
+    float len_sq = ex * ex + ey * ey;
+    float u = len_sq > 0.0f ? ((p.x - ax) * ex + (p.y - ay) * ey) / len_sq : 0.0f;
+    u = fminf(fmaxf(u, 0.0f), 1.0f);
+    float dx = ax + u * ex - p.x, dy = ay + u * ey - p.y;
+    return dx * dx + dy * dy;
+}
+
+// Squared distance from p to the shape itself (0 inside it)
+float scene_shape_distance_sq(const Scene *scene, ShapeRef ref, Point p)
+{
+    uint32_t i = ref.index;
+
+    switch (ref.type)
+    {
+    case SHAPE_CIRCLE:
+    {
+        float dx = p.x - scene->circles.cx[i];
+        float dy = p.y - scene->circles.cy[i];
+        float d = fmaxf(sqrtf(dx * dx + dy * dy) - scene->circles.radius[i], 0.0f);
+        return d * d;
+    }
+    case SHAPE_RECTANGLE:
+        return box_distance_sq(scene_shape_bounds(scene, ref), p);
+    case SHAPE_TRIANGLE:
+    {
+        if (scene_shape_contains(scene, ref, p)) return 0.0f;
+        const TriangleArray *t = &scene->triangles;
+        float best = INFINITY;
+        for (int k = 0; k < 3; k++)
+        {
+            int n = (k + 1) % 3;
+            best = fminf(best, segment_distance_sq(t->x[k][i], t->y[k][i], t->x[n][i], t->y[n][i], p));
+        }
+        return best;
+    }
+    default:
+        return INFINITY;
+    }
+}
+
+// The k best candidates seen so far, sorted by distance. k is small, so
+// insertion into a sorted array beats a heap.
+typedef struct
+{
+    ShapeRef *refs;
+    float *dist_sq;
+    size_t k;
+    size_t count;
+} NearestSet;
+
+// Distance a candidate has to beat to get in
+static float nearest_bound(const NearestSet *set)
+{
+    return set->count < set->k ? INFINITY : set->dist_sq[set->count - 1];
+}
+
+static void nearest_offer(NearestSet *set, ShapeRef ref, float dist_sq)
+{
+    if (dist_sq >= nearest_bound(set)) return;
+
+    size_t i = set->count < set->k ? set->count++ : set->count - 1;
+    while (i > 0 && set->dist_sq[i - 1] > dist_sq)
+    {
+        set->refs[i] = set->refs[i - 1];
+        set->dist_sq[i] = set->dist_sq[i - 1];
+        i--;
+    }
+    set->refs[i] = ref;
+    set->dist_sq[i] = dist_sq;
+}
+
+// Every shape's reference and bounding box, in one array for the builders
+typedef struct
+{
+    ShapeRef *refs;
+    Box *boxes;
+    size_t count;
+} ShapeItems;
+
+static bool shape_items_collect(ShapeItems *items, const Scene *scene)
+{
+    size_t n = scene_count(scene);
+    items->refs = (ShapeRef *) malloc((n ? n : 1) * sizeof(ShapeRef));
+    items->boxes = (Box *) malloc((n ? n : 1) * sizeof(Box));
+    items->count = 0;
+    if (items->refs == NULL || items->boxes == NULL)
+    {
+        free(items->refs);
+        free(items->boxes);
+        return false;
+    }
+
+    size_t counts[3] = {scene->circles.count, scene->rectangles.count, scene->triangles.count};
+    ShapeType types[3] = {SHAPE_CIRCLE, SHAPE_RECTANGLE, SHAPE_TRIANGLE};
+    for (int t = 0; t < 3; t++)
+    {
+        for (size_t i = 0; i < counts[t]; i++)
+        {
+            ShapeRef ref = {types[t], (uint32_t) i};
+            items->refs[items->count] = ref;
+            items->boxes[items->count] = scene_shape_bounds(scene, ref);
+            items->count++;
+        }
+    }
+    return true;
+}
+
+static void shape_items_free(ShapeItems *items)
+{
+    free(items->refs);
+    free(items->boxes);
+}
+
+// --- Worker pool for the parallel builds ---
+
+// Runs task(ctx, 0..count-1) across persistent threads; the same design
+// as MatrixPool in 02-variable-length-arrays, but with a generic task.
+typedef void (*PoolTask)(void *ctx, int task);
+
+typedef struct
+{
+    pthread_t *threads;
+    int count;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    PoolTask task;
+    void *ctx;
+    int task_count;
+    atomic_int next_task;
+    unsigned long generation;  // bumped once per job
+    int busy;                  // workers still on the current job
+    bool shutdown;
+} WorkerPool;
+
+static void pool_run_tasks(WorkerPool *pool)
+{
+    int task;
+    while ((task = atomic_fetch_add(&pool->next_task, 1)) < pool->task_count)
+    {
+        pool->task(pool->ctx, task);
+    }
+}
+
+static void *pool_worker(void *arg)
+{
+    WorkerPool *pool = (WorkerPool *) arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        while (!pool->shutdown && pool->generation == seen)
+        {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->shutdown) break;
+
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        pool_run_tasks(pool);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) pthread_cond_signal(&pool->work_done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+void worker_pool_destroy(WorkerPool *pool);
+
+WorkerPool *worker_pool_create(int threads)
+{
+    WorkerPool *pool = (WorkerPool *) calloc(1, sizeof(WorkerPool));
+    if (pool == NULL) return NULL;
+
+    pool->threads = (pthread_t *) calloc(threads, sizeof(pthread_t));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+    if (pool->threads == NULL)
+    {
+        worker_pool_destroy(pool);
+        return NULL;
+    }
+
+    for (int i = 0; i < threads; i++)
+    {
+        if (pthread_create(&pool->threads[i], NULL, pool_worker, pool) != 0)
+        {
+            worker_pool_destroy(pool);
+            return NULL;
+        }
+        pool->count++;
+    }
+    return pool;
+}
+
+void worker_pool_destroy(WorkerPool *pool)
+{
+    if (pool == NULL) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->count; i++)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->work_done);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
+
+// Run task for every index in [0, count) and wait; with no pool (or no
+// workers) the calling thread runs them all
+void worker_pool_run(WorkerPool *pool, PoolTask task, void *ctx, int count)
+{
+    if (pool == NULL || pool->count == 0)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            task(ctx, i);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->ctx = ctx;
+    pool->task_count = count;
+    atomic_store(&pool->next_task, 0);
+    pool->busy = pool->count;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+    while (pool->busy > 0)
+    {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// --- Uniform grid ---
+
+#define GRID_SHAPES_PER_CELL 2  // target average occupancy
+#define GRID_MAX_CELLS_PER_AXIS 4096
+#define GRID_BUILD_SLICES 16    // parallel build splits the shapes this many ways
+
+// Cells in compressed-row form: cell c holds items[cell_start[c]] up to
+// items[cell_start[c + 1]]. A shape is listed in every cell its box
+// overlaps.
+typedef struct
+{
+    Box bounds;
+    int cells_x;
+    int cells_y;
+    float inv_cell_w;  // cells per unit, for point -> cell
+    float inv_cell_h;
+    uint32_t *cell_start;  // cells_x * cells_y + 1 entries
+    uint32_t *items;       // indices into refs/boxes
+    ShapeItems shapes;
+} ShapeGrid;
+
+static int grid_clamp(int v, int limit)
+{
+    return v < 0 ? 0 : (v >= limit ? limit - 1 : v);
+}
+
+static int grid_cell_x(const ShapeGrid *grid, float x)
+{
+    return grid_clamp((int) ((x - grid->bounds.min_x) * grid->inv_cell_w), grid->cells_x);
+}
+
+static int grid_cell_y(const ShapeGrid *grid, float y)
+{
+    return grid_clamp((int) ((y - grid->bounds.min_y) * grid->inv_cell_h), grid->cells_y);
+}
+
+typedef struct
+{
+    ShapeGrid *grid;
+    uint32_t *slice_counts;  // GRID_BUILD_SLICES rows of cell counts
+    size_t cell_count;
+} GridBuild;
+
+static void grid_slice_range(const GridBuild *build, int slice, size_t *begin, size_t *end)
+{
+    size_t n = build->grid->shapes.count;
+    *begin = n * slice / GRID_BUILD_SLICES;
+    *end = n * (slice + 1) / GRID_BUILD_SLICES;
+}
+
+// Pass 1: count how many entries each cell gets from this slice
+static void grid_count_task(void *ctx, int slice)
+{
+    GridBuild *build = (GridBuild *) ctx;
+    ShapeGrid *grid = build->grid;
+    uint32_t *counts = build->slice_counts + slice * build->cell_count;
+    size_t begin, end;
+
+    grid_slice_range(build, slice, &begin, &end);
+    for (size_t i = begin; i < end; i++)
+    {
+        Box b = grid->shapes.boxes[i];
+        for (int y = grid_cell_y(grid, b.min_y); y <= grid_cell_y(grid, b.max_y); y++)
+        {
+            for (int x = grid_cell_x(grid, b.min_x); x <= grid_cell_x(grid, b.max_x); x++)
+            {
+                counts[(size_t) y * grid->cells_x + x]++;
+            }
+        }
+    }
+}
+
+// Pass 2: write this slice's entries at the offsets the prefix sum gave it,
+// so the result is the same as a serial build
+static void grid_fill_task(void *ctx, int slice)
+{
+    GridBuild *build = (GridBuild *) ctx;
+    ShapeGrid *grid = build->grid;
+    uint32_t *next = build->slice_counts + slice * build->cell_count;
+    size_t begin, end;
+
+    grid_slice_range(build, slice, &begin, &end);
+    for (size_t i = begin; i < end; i++)
+    {
+        Box b = grid->shapes.boxes[i];
+        for (int y = grid_cell_y(grid, b.min_y); y <= grid_cell_y(grid, b.max_y); y++)
+        {
+            for (int x = grid_cell_x(grid, b.min_x); x <= grid_cell_x(grid, b.max_x); x++)
+            {
+                grid->items[next[(size_t) y * grid->cells_x + x]++] = (uint32_t) i;
+            }
+        }
+    }
+}
+
+void shape_grid_free(ShapeGrid *grid)
+{
+    free(grid->cell_start);
+    free(grid->items);
+    shape_items_free(&grid->shapes);
+    memset(grid, 0, sizeof(*grid));
+}
+
+// Build a grid over scene; pool may be NULL for a single-threaded build
+StatusCode shape_grid_build(ShapeGrid *grid, const Scene *scene, WorkerPool *pool)
+{
+    memset(grid, 0, sizeof(*grid));
+    if (!shape_items_collect(&grid->shapes, scene)) return STATUS_ERROR_OUT_OF_MEMORY;
+
+    size_t n = grid->shapes.count;
+    grid->bounds = box_empty();
+    for (size_t i = 0; i < n; i++)
+    {
+        grid->bounds = box_union(grid->bounds, grid->shapes.boxes[i]);
+    }
+    if (n == 0) grid->bounds = (Box){0.0f, 0.0f, 1.0f, 1.0f};
+
+    // Square cells holding about GRID_SHAPES_PER_CELL shapes each, but no
+    // smaller than the average shape, or every shape is copied into many
+    // cells
+    double mean_side = 0.0;
+    for (size_t i = 0; i < n; i++)
+    {
+        Box b = grid->shapes.boxes[i];
+        mean_side += fmaxf(b.max_x - b.min_x, b.max_y - b.min_y);
+    }
+    mean_side /= (double) (n ? n : 1);
+
+    float w = fmaxf(grid->bounds.max_x - grid->bounds.min_x, 1e-6f);
+    float h = fmaxf(grid->bounds.max_y - grid->bounds.min_y, 1e-6f);
+    float cell = fmaxf(sqrtf(w * h * GRID_SHAPES_PER_CELL / (float) (n ? n : 1)), (float) mean_side);
+    grid->cells_x = (int) fminf(fmaxf(ceilf(w / cell), 1.0f), GRID_MAX_CELLS_PER_AXIS);
+    grid->cells_y = (int) fminf(fmaxf(ceilf(h / cell), 1.0f), GRID_MAX_CELLS_PER_AXIS);
+    grid->inv_cell_w = grid->cells_x / w;
+    grid->inv_cell_h = grid->cells_y / h;
+
+    size_t cells = (size_t) grid->cells_x * grid->cells_y;
+    GridBuild build = {grid, NULL, cells};
+    build.slice_counts = (uint32_t *) calloc(GRID_BUILD_SLICES * cells, sizeof(uint32_t));
+    grid->cell_start = (uint32_t *) malloc((cells + 1) * sizeof(uint32_t));
+    if (build.slice_counts == NULL || grid->cell_start == NULL)
+    {
+        free(build.slice_counts);
+        shape_grid_free(grid);
+        return STATUS_ERROR_OUT_OF_MEMORY;
+    }
+
+    worker_pool_run(pool, grid_count_task, &build, GRID_BUILD_SLICES);
+
+    // Exclusive prefix sum in (cell, slice) order: each slice's counts
+    // become its first write position in each cell
+    uint32_t total = 0;
+    for (size_t c = 0; c < cells; c++)
+    {
+        grid->cell_start[c] = total;
+        for (int s = 0; s < GRID_BUILD_SLICES; s++)
+        {
+            uint32_t count = build.slice_counts[s * cells + c];
+            build.slice_counts[s * cells + c] = total;
+            total += count;
+        }
+    }
+    grid->cell_start[cells] = total;
+
+    grid->items = (uint32_t *) malloc((total ? total : 1) * sizeof(uint32_t));
+    if (grid->items == NULL)
+    {
+        free(build.slice_counts);
+        shape_grid_free(grid);
+        return STATUS_ERROR_OUT_OF_MEMORY;
+    }
+
+    worker_pool_run(pool, grid_fill_task, &build, GRID_BUILD_SLICES);
+    free(build.slice_counts);
+    return STATUS_SUCCESS;
+}
+
+// Shapes containing p. Writes up to max_out refs and returns how many
+// shapes matched, which may be more than max_out (like snprintf).
+size_t shape_grid_query_point(const ShapeGrid *grid, const Scene *scene, Point p, ShapeRef *out, size_t max_out)
+{
+    if (!box_contains(grid->bounds, p)) return 0;
+
+    size_t c = (size_t) grid_cell_y(grid, p.y) * grid->cells_x + grid_cell_x(grid, p.x);
+    size_t found = 0;
+    for (uint32_t e = grid->cell_start[c]; e < grid->cell_start[c + 1]; e++)
+    {
+        uint32_t i = grid->items[e];
+        if (box_contains(grid->shapes.boxes[i], p) && scene_shape_contains(scene, grid->shapes.refs[i], p))
+        {
+            if (found < max_out) out[found] = grid->shapes.refs[i];
+            found++;
+        }
+    }
+    return found;
+}
+
+// Shapes whose bounding box overlaps area; same output convention
+size_t shape_grid_query_rect(const ShapeGrid *grid, Box area, ShapeRef *out, size_t max_out)
+{
+    if (!box_overlaps(grid->bounds, area)) return 0;
+
+    int x0 = grid_cell_x(grid, area.min_x), x1 = grid_cell_x(grid, area.max_x);
+    int y0 = grid_cell_y(grid, area.min_y), y1 = grid_cell_y(grid, area.max_y);
+    size_t found = 0;
+
+    for (int y = y0; y <= y1; y++)
+    {
+        for (int x = x0; x <= x1; x++)
+        {
+            size_t c = (size_t) y * grid->cells_x + x;
+            for (uint32_t e = grid->cell_start[c]; e < grid->cell_start[c + 1]; e++)
+            {
+                uint32_t i = grid->items[e];
+                Box b = grid->shapes.boxes[i];
+                if (!box_overlaps(b, area)) continue;
+
+                // A shape spanning several cells is reported only from
+                // the first cell in which it meets the query: the one
+                // holding the overlap's lower-left corner
+                if (grid_cell_x(grid, fmaxf(b.min_x, area.min_x)) != x || grid_cell_y(grid, fmaxf(b.min_y, area.min_y)) != y)
+                {
+                    continue;
+                }
+
+                if (found < max_out) out[found] = grid->shapes.refs[i];
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+// The k shapes nearest to p, closest first; returns how many were found
+// (fewer than k only if the scene is smaller). Searches rings of cells
+// outward from p's cell until no unsearched cell can be closer than the
+// k-th best so far.
+size_t shape_grid_nearest(const ShapeGrid *grid, const Scene *scene, Point p, size_t k, ShapeRef *out, float *dist_out)
+{
+    float *dist_sq = (float *) malloc((k ? k : 1) * sizeof(float));
+    if (dist_sq == NULL || k == 0)
+    {
+        free(dist_sq);
+        return 0;
+    }
+
+    NearestSet set = {out, dist_sq, k, 0};
+    int cx = grid_cell_x(grid, p.x), cy = grid_cell_y(grid, p.y);
+    float cell_w = 1.0f / grid->inv_cell_w, cell_h = 1.0f / grid->inv_cell_h;
+    int max_ring = grid->cells_x > grid->cells_y ? grid->cells_x : grid->cells_y;
+
+    for (int ring = 0; ring <= max_ring; ring++)
+    {
+        // Cells not searched yet lie outside rings 0..ring-1, so they are
+        // at least as far as the nearest side of that square (sides at the
+        // grid's edge have nothing beyond them)
+        if (ring > 0)
+        {
+            float gap = INFINITY;
+            if (cx - ring + 1 > 0) gap = fminf(gap, p.x - (grid->bounds.min_x + (cx - ring + 1) * cell_w));
+            if (cx + ring < grid->cells_x) gap = fminf(gap, grid->bounds.min_x + (cx + ring) * cell_w - p.x);
+            if (cy - ring + 1 > 0) gap = fminf(gap, p.y - (grid->bounds.min_y + (cy - ring + 1) * cell_h));
+            if (cy + ring < grid->cells_y) gap = fminf(gap, grid->bounds.min_y + (cy + ring) * cell_h - p.y);
+            if (gap == INFINITY) break;  // the whole grid has been searched
+            gap = fmaxf(gap, 0.0f);
+            if (gap * gap >= nearest_bound(&set)) break;
+        }
+
+        for (int y = cy - ring; y <= cy + ring; y++)
+        {
+            if (y < 0 || y >= grid->cells_y) continue;
+            bool edge_row = y == cy - ring || y == cy + ring;
+            for (int x = cx - ring; x <= cx + ring; x += edge_row ? 1 : 2 * ring)
+            {
+                if (x >= 0 && x < grid->cells_x)
+                {
+                    size_t c = (size_t) y * grid->cells_x + x;
+                    for (uint32_t e = grid->cell_start[c]; e < grid->cell_start[c + 1]; e++)
+                    {
+                        uint32_t i = grid->items[e];
+                        if (box_distance_sq(grid->shapes.boxes[i], p) >= nearest_bound(&set)) continue;
+
+                        // A shape in several cells may be offered twice;
+                        // skip it if it is already in the set
+                        ShapeRef ref = grid->shapes.refs[i];
+                        bool seen = false;
+                        for (size_t j = 0; j < set.count && !seen; j++)
+                        {
+                            seen = set.refs[j].type == ref.type && set.refs[j].index == ref.index;
+                        }
+                        if (!seen) nearest_offer(&set, ref, scene_shape_distance_sq(scene, ref, p));
+                    }
+                }
+                if (ring == 0) break;
+            }
+        }
+    }
+
+    for (size_t j = 0; dist_out != NULL && j < set.count; j++)
+    {
+        dist_out[j] = sqrtf(set.dist_sq[j]);
+    }
+    free(dist_sq);
+    return set.count;
+}
+
+// --- Bounding volume hierarchy ---
+
+#define BVH_BINS 16           // candidate split planes per axis
+#define BVH_LEAF_SIZE 4       // leaves hold at most this many shapes
+#define BVH_MAX_DEPTH 64      // past this, split at the median (bounds depth)
+#define BVH_TRAVERSAL_COST 1.0f  // SAH cost of visiting a node, per shape test
+
+// Internal nodes have count == 0 and children at first and first + 1;
+// leaves cover shapes order[first] up to order[first + count]
+typedef struct
+{
+    Box box;
+    uint32_t first;
+    uint32_t count;
+} BVHNode;
+
+typedef struct
+{
+    BVHNode *nodes;
+    uint32_t *order;  // shape indices, permuted so each leaf is contiguous
+    atomic_uint node_count;
+    ShapeItems shapes;
+} ShapeBVH;
+
+typedef struct
+{
+    uint32_t node;
+    uint32_t begin;
+    uint32_t end;
+    int depth;
+} BVHTask;
+
+typedef struct
+{
+    ShapeBVH *bvh;
+    float *centroid_x;
+    float *centroid_y;
+    BVHTask *tasks;  // subtrees handed to the pool
+    int task_count;
+    int task_capacity;
+    uint32_t task_size;  // subtrees at most this big become tasks
+} BVHBuild;
+
+// Choose a split of order[begin, end) and partition it; returns the split
+// point, or begin if the range should stay a leaf
+static uint32_t bvh_partition(BVHBuild *build, uint32_t begin, uint32_t end, Box node_box, int depth)
+{
+    ShapeBVH *bvh = build->bvh;
+    uint32_t *order = bvh->order;
+    uint32_t n = end - begin;
+
+    if (n <= 2) return begin;
+
+    Box cbox = box_empty();
+    for (uint32_t i = begin; i < end; i++)
+    {
+        float cx = build->centroid_x[order[i]], cy = build->centroid_y[order[i]];
+        cbox = box_union(cbox, (Box){cx, cy, cx, cy});
+    }
+
+    int axis = (cbox.max_x - cbox.min_x) >= (cbox.max_y - cbox.min_y) ? 0 : 1;
+    float lo = axis == 0 ? cbox.min_x : cbox.min_y;
+    float extent = axis == 0 ? cbox.max_x - cbox.min_x : cbox.max_y - cbox.min_y;
+    const float *centroid = axis == 0 ? build->centroid_x : build->centroid_y;
+
+    // All centroids coincide: no plane separates them
+    if (extent <= 0.0f) return n <= BVH_LEAF_SIZE ? begin : begin + n / 2;
+
+    uint32_t split = end;
+    if (depth < BVH_MAX_DEPTH)
+    {
+        // Binned SAH: bucket centroids, then cost every plane between
+        // buckets from prefix/suffix boxes and counts
+        Box bin_box[BVH_BINS];
+        uint32_t bin_count[BVH_BINS] = {0};
+        float scale = BVH_BINS / extent;
+        for (int b = 0; b < BVH_BINS; b++)
+        {
+            bin_box[b] = box_empty();
+        }
+        for (uint32_t i = begin; i < end; i++)
+        {
+            int b = (int) ((centroid[order[i]] - lo) * scale);
+            b = b >= BVH_BINS ? BVH_BINS - 1 : b;
+            bin_count[b]++;
+            bin_box[b] = box_union(bin_box[b], bvh->shapes.boxes[order[i]]);
+        }
+
+        float right_cost[BVH_BINS];
+        Box acc = box_empty();
+        uint32_t acc_count = 0;
+        for (int b = BVH_BINS - 1; b > 0; b--)
+        {
+            acc = box_union(acc, bin_box[b]);
+            acc_count += bin_count[b];
+            right_cost[b] = acc_count ? box_half_perimeter(acc) * acc_count : INFINITY;
+        }
+
+        float best_cost = INFINITY;
+        int best_plane = -1;
+        acc = box_empty();
+        acc_count = 0;
+        for (int b = 1; b < BVH_BINS; b++)
+        {
+            acc = box_union(acc, bin_box[b - 1]);
+            acc_count += bin_count[b - 1];
+            if (acc_count == 0) continue;
+            float cost = box_half_perimeter(acc) * acc_count + right_cost[b];
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_plane = b;
+            }
+        }
+
+        // Stay a leaf when no split beats testing every shape
+        float parent_area = box_half_perimeter(node_box);
+        float leaf_cost = (float) n;
+        float split_cost = BVH_TRAVERSAL_COST + (parent_area > 0.0f ? best_cost / parent_area : leaf_cost);
+        if (best_plane < 0 || (n <= BVH_LEAF_SIZE && split_cost >= leaf_cost)) return begin;
+
+        // Partition by bin, in place
+        uint32_t i = begin, j = end;
+        while (i < j)
+        {
+            int b = (int) ((centroid[order[i]] - lo) * scale);
+            b = b >= BVH_BINS ? BVH_BINS - 1 : b;
+            if (b < best_plane)
+            {
+                i++;
+            }
+            else
+            {
+                uint32_t t = order[i];
+                order[i] = order[--j];
+                order[j] = t;
+            }
+        }
+        split = i;
+    }
+
+    if (split == begin || split == end)
+    {
+        // Too deep, or the bins could not separate: median on the axis
+        uint32_t mid = begin + n / 2;
+        uint32_t l = begin, r = end - 1;
+        while (l < r)
+        {
+            // Quickselect so order[mid] is the median and halves split on it
+            float pivot = centroid[order[l + (r - l) / 2]];
+            uint32_t a = l, b = r;
+            while (a <= b)
+            {
+                while (centroid[order[a]] < pivot) a++;
+                while (centroid[order[b]] > pivot) b--;
+                if (a <= b)
+                {
+                    uint32_t t = order[a];
+                    order[a] = order[b];
+                    order[b] = t;
+                    a++;
+                    if (b == 0) break;
+                    b--;
+                }
+            }
+            if (mid <= b)
+            {
+                r = b;
+            }
+            else if (mid >= a)
+            {
+                l = a;
+            }
+            else
+            {
+                break;
+            }
+        }
+        split = mid;
+    }
+    return split;
+}
+
+static Box bvh_range_box(const ShapeBVH *bvh, uint32_t begin, uint32_t end)
+{
+    Box b = box_empty();
+    for (uint32_t i = begin; i < end; i++)
+    {
+        b = box_union(b, bvh->shapes.boxes[bvh->order[i]]);
+    }
+    return b;
+}
+
+// Build the subtree for order[begin, end) into node. A build with
+// deferred == true stops at subtrees of at most task_size shapes and
+// queues them for the pool instead.
+static bool bvh_build_node(BVHBuild *build, uint32_t node, uint32_t begin, uint32_t end, int depth, bool deferred)
+{
+    ShapeBVH *bvh = build->bvh;
+    BVHNode *n = &bvh->nodes[node];
+    n->box = bvh_range_box(bvh, begin, end);
+
+    if (deferred && end - begin <= build->task_size)
+    {
+        if (build->task_count == build->task_capacity)
+        {
+            int capacity = build->task_capacity ? build->task_capacity * 2 : 64;
+            BVHTask *tasks = (BVHTask *) realloc(build->tasks, capacity * sizeof(BVHTask));
+            if (tasks == NULL) return false;
+            build->tasks = tasks;
+            build->task_capacity = capacity;
+        }
+        build->tasks[build->task_count++] = (BVHTask){node, begin, end, depth};
+        return true;
+    }
+
+    uint32_t split = bvh_partition(build, begin, end, n->box, depth);
+    if (split == begin)
+    {
+        n->first = begin;
+        n->count = end - begin;
+        return true;
+    }
+
+    // Children are allocated as a pair, so only the left index is stored;
+    // the atomic counter lets subtree tasks allocate concurrently
+    uint32_t left = atomic_fetch_add(&bvh->node_count, 2);
+    n->first = left;
+    n->count = 0;
+    return bvh_build_node(build, left, begin, split, depth + 1, deferred)
+           && bvh_build_node(build, left + 1, split, end, depth + 1, deferred);
+}
+
+static void bvh_subtree_task(void *ctx, int task)
+{
+    BVHBuild *build = (BVHBuild *) ctx;
+    BVHTask t = build->tasks[task];
+    bvh_build_node(build, t.node, t.begin, t.end, t.depth, false);
+}
+
+void shape_bvh_free(ShapeBVH *bvh)
+{
+    free(bvh->nodes);
+    free(bvh->order);
+    shape_items_free(&bvh->shapes);
+    memset(bvh, 0, sizeof(*bvh));
+}
+
+// Build a BVH over scene. With a pool, the top of the tree is split on the
+// calling thread and the subtrees below it are built in parallel.
+StatusCode shape_bvh_build(ShapeBVH *bvh, const Scene *scene, WorkerPool *pool)
+{
+    memset(bvh, 0, sizeof(*bvh));
+    if (!shape_items_collect(&bvh->shapes, scene)) return STATUS_ERROR_OUT_OF_MEMORY;
+
+    size_t n = bvh->shapes.count;
+    BVHBuild build = {bvh, NULL, NULL, NULL, 0, 0, 0};
+    bvh->nodes = (BVHNode *) malloc((2 * n + 1) * sizeof(BVHNode));  // a binary tree with n leaves at most
+    bvh->order = (uint32_t *) malloc((n ? n : 1) * sizeof(uint32_t));
+    build.centroid_x = (float *) malloc((n ? n : 1) * sizeof(float));
+    build.centroid_y = (float *) malloc((n ? n : 1) * sizeof(float));
+    StatusCode status = STATUS_ERROR_OUT_OF_MEMORY;
+
+    if (bvh->nodes && bvh->order && build.centroid_x && build.centroid_y)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            Box b = bvh->shapes.boxes[i];
+            bvh->order[i] = (uint32_t) i;
+            build.centroid_x[i] = 0.5f * (b.min_x + b.max_x);
+            build.centroid_y[i] = 0.5f * (b.min_y + b.max_y);
+        }
+
+        // Aim for several subtrees per thread so uneven ones balance out
+        int threads = pool ? pool->count : 0;
+        build.task_size = threads > 1 ? (uint32_t) (n / (threads * 8) + 1) : (uint32_t) n + 1;
+        atomic_init(&bvh->node_count, 1);
+
+        if (bvh_build_node(&build, 0, 0, (uint32_t) n, 0, threads > 1))
+        {
+            worker_pool_run(pool, bvh_subtree_task, &build, build.task_count);
+            status = STATUS_SUCCESS;
+        }
+    }
+
+    free(build.tasks);
+    free(build.centroid_x);
+    free(build.centroid_y);
+    if (status != STATUS_SUCCESS) shape_bvh_free(bvh);
+    return status;
+}
+
+// Traversal stacks are fixed size: the depth is bounded by BVH_MAX_DEPTH
+// plus the median-split levels below it
+#define BVH_STACK_SIZE 128
+
+size_t shape_bvh_query_point(const ShapeBVH *bvh, const Scene *scene, Point p, ShapeRef *out, size_t max_out)
+{
+    if (bvh->shapes.count == 0) return 0;
+
+    uint32_t stack[BVH_STACK_SIZE];
+    int top = 0;
+    size_t found = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const BVHNode *node = &bvh->nodes[stack[--top]];
+        if (!box_contains(node->box, p)) continue;
+
+        if (node->count == 0)
+        {
+            stack[top++] = node->first;
+            stack[top++] = node->first + 1;
+            continue;
+        }
+        for (uint32_t i = node->first; i < node->first + node->count; i++)
+        {
+            uint32_t s = bvh->order[i];
+            if (box_contains(bvh->shapes.boxes[s], p) && scene_shape_contains(scene, bvh->shapes.refs[s], p))
+            {
+                if (found < max_out) out[found] = bvh->shapes.refs[s];
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+size_t shape_bvh_query_rect(const ShapeBVH *bvh, Box area, ShapeRef *out, size_t max_out)
+{
+    if (bvh->shapes.count == 0) return 0;
+
+    uint32_t stack[BVH_STACK_SIZE];
+    int top = 0;
+    size_t found = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const BVHNode *node = &bvh->nodes[stack[--top]];
+        if (!box_overlaps(node->box, area)) continue;
+
+        if (node->count == 0)
+        {
+            stack[top++] = node->first;
+            stack[top++] = node->first + 1;
+            continue;
+        }
+        for (uint32_t i = node->first; i < node->first + node->count; i++)
+        {
+            uint32_t s = bvh->order[i];
+            if (box_overlaps(bvh->shapes.boxes[s], area))
+            {
+                if (found < max_out) out[found] = bvh->shapes.refs[s];
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+// Depth-first, nearer child first, skipping any node whose box is farther
+// than the current k-th best
+size_t shape_bvh_nearest(const ShapeBVH *bvh, const Scene *scene, Point p, size_t k, ShapeRef *out, float *dist_out)
+{
+    float *dist_sq = (float *) malloc((k ? k : 1) * sizeof(float));
+    if (dist_sq == NULL || k == 0 || bvh->shapes.count == 0)
+    {
+        free(dist_sq);
+        return 0;
+    }
+
+    NearestSet set = {out, dist_sq, k, 0};
+    uint32_t stack[BVH_STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const BVHNode *node = &bvh->nodes[stack[--top]];
+        if (box_distance_sq(node->box, p) >= nearest_bound(&set)) continue;
+
+        if (node->count == 0)
+        {
+            uint32_t near = node->first, far = node->first + 1;
+            if (box_distance_sq(bvh->nodes[far].box, p) < box_distance_sq(bvh->nodes[near].box, p))
+            {
+                near = far;
+                far = node->first;
+            }
+            stack[top++] = far;  // popped after near's whole subtree
+            stack[top++] = near;
+            continue;
+        }
+        for (uint32_t i = node->first; i < node->first + node->count; i++)
+        {
+            uint32_t s = bvh->order[i];
+            if (box_distance_sq(bvh->shapes.boxes[s], p) < nearest_bound(&set))
+            {
+                nearest_offer(&set, bvh->shapes.refs[s], scene_shape_distance_sq(scene, bvh->shapes.refs[s], p));
+            }
+        }
+    }
+
+    for (size_t j = 0; dist_out != NULL && j < set.count; j++)
+    {
+        dist_out[j] = sqrtf(set.dist_sq[j]);
+    }
+    free(dist_sq);
+    return set.count;
+}
+
+// --- Demo and benchmark ---
+
+void demo_spatial_index(void)
+{
+    printf("\n=== Spatial Index ===\n");
+
+    Scene scene;
+    scene_init(&scene);
+    Color white = create_color(255, 255, 255, 255);
+    Point points[3] = {{20.0f, 0.0f}, {25.0f, 10.0f}, {30.0f, 0.0f}};
+    scene_add_circle(&scene, 0.0f, 0.0f, 5.0f, white);
+    scene_add_rectangle(&scene, 2.0f, 2.0f, 12.0f, 7.0f, white);
+    scene_add_triangle(&scene, points, white);
+    scene_add_circle(&scene, 40.0f, 40.0f, 2.0f, white);
+
+    ShapeGrid grid;
+    ShapeBVH bvh;
+    if (shape_grid_build(&grid, &scene, NULL) != STATUS_SUCCESS || shape_bvh_build(&bvh, &scene, NULL) != STATUS_SUCCESS)
+    {
+        print_status(STATUS_ERROR_OUT_OF_MEMORY);
+        scene_free(&scene);
+        return;
+    }
+
+    ShapeRef hits[8];
+    Point p = {3.0f, 3.0f};
+    size_t nh = shape_bvh_query_point(&bvh, &scene, p, hits, 8);
+    printf("Shapes containing (%.0f, %.0f):", p.x, p.y);
+    for (size_t i = 0; i < nh; i++)
+    {
+        printf(" %s #%u", get_shape_name(hits[i].type), hits[i].index);
+    }
+    printf(" (grid agrees: %s)\n", shape_grid_query_point(&grid, &scene, p, hits, 8) == nh ? "yes" : "no");
+
+    Box area = {15.0f, -1.0f, 45.0f, 1.0f};
+    printf("Boxes overlapping [15, 45] x [-1, 1]: %zu (grid), %zu (BVH)\n",
+           shape_grid_query_rect(&grid, area, hits, 8),
+           shape_bvh_query_rect(&bvh, area, hits, 8));
+
+    float dist[2];
+    Point q = {35.0f, 30.0f};
+    size_t nk = shape_bvh_nearest(&bvh, &scene, q, 2, hits, dist);
+    printf("2 nearest to (%.0f, %.0f):", q.x, q.y);
+    for (size_t i = 0; i < nk; i++)
+    {
+        printf(" %s #%u at %.2f", get_shape_name(hits[i].type), hits[i].index, dist[i]);
+    }
+    printf("\n");
+
+    shape_bvh_free(&bvh);
+    shape_grid_free(&grid);
+    scene_free(&scene);
+}
+
+// Shrink a shape 100x towards (ox, oy): random_shape's 1000 x 1000 layout
+// becomes a 10 x 10 hot spot
+static void cluster_shape(Shape *shape, float ox, float oy)
+{
+    const float scale = 0.01f;
+    switch (shape->type)
+    {
+    case SHAPE_CIRCLE:
+        shape->data.circle.center = (Point){ox + shape->data.circle.center.x * scale, oy + shape->data.circle.center.y * scale};
+        shape->data.circle.radius *= scale;
+        break;
+    case SHAPE_RECTANGLE:
+        shape->data.rectangle.top_left = (Point){ox + shape->data.rectangle.top_left.x * scale, oy + shape->data.rectangle.top_left.y * scale};
+        shape->data.rectangle.bottom_right = (Point){ox + shape->data.rectangle.bottom_right.x * scale, oy + shape->data.rectangle.bottom_right.y * scale};
+        break;
+    case SHAPE_TRIANGLE:
+        for (int k = 0; k < 3; k++)
+        {
+            shape->data.triangle.points[k] = (Point){ox + shape->data.triangle.points[k].x * scale, oy + shape->data.triangle.points[k].y * scale};
+        }
+        break;
+    }
+}
+
+// Uniform scene and a clustered one, where most shapes sit in a few small
+// hot spots: queries by linear scan, grid and BVH
+void benchmark_spatial_index(size_t n, int threads)
+{
+    WorkerPool *pool = threads > 1 ? worker_pool_create(threads) : NULL;
+    const char *names[2] = {"uniform", "clustered"};
+
+    for (int layout = 0; layout < 2; layout++)
+    {
+        printf("\n=== Benchmark: spatial queries, %zu %s shapes, %d thread(s) ===\n", n, names[layout], pool ? pool->count : 1);
+
+        Scene scene;
+        scene_init(&scene);
+        srand(5);
+        for (size_t i = 0; i < n; i++)
+        {
+            Shape shape;
+            random_shape(&shape, create_color(255, 255, 255, 255));
+            if (layout == 1 && rand() % 10 != 0) cluster_shape(&shape, (float) (rand() % 8) * 120.0f, 500.0f);
+            scene_add_shape(&scene, &shape);
+        }
+
+        ShapeGrid grid;
+        ShapeBVH bvh;
+        clock_t start = clock();
+        StatusCode gs = shape_grid_build(&grid, &scene, pool);
+        double t_grid_build = seconds_since(start);
+        start = clock();
+        StatusCode bs = shape_bvh_build(&bvh, &scene, pool);
+        double t_bvh_build = seconds_since(start);
+        if (gs != STATUS_SUCCESS || bs != STATUS_SUCCESS)
+        {
+            print_status(STATUS_ERROR_OUT_OF_MEMORY);
+            if (gs == STATUS_SUCCESS) shape_grid_free(&grid);
+            if (bs == STATUS_SUCCESS) shape_bvh_free(&bvh);
+            scene_free(&scene);
+            continue;
+        }
+        printf("build: grid %.3f s (%d x %d cells), BVH %.3f s (%u nodes)\n",
+               t_grid_build,
+               grid.cells_x,
+               grid.cells_y,
+               t_bvh_build,
+               atomic_load(&bvh.node_count));
+
+        const int queries = 2000;
+        Point *probes = (Point *) malloc(queries * sizeof(Point));
+        if (probes == NULL) break;
+        for (int q = 0; q < queries; q++)
+        {
+            // Half the probes land in the hot spots, where most shapes are
+            bool hot = layout == 1 && q % 2 == 0;
+            probes[q] = hot ? (Point){(float) (rand() % 8) * 120.0f + (float) (rand() % 10), 500.0f + (float) (rand() % 10)}
+                            : (Point){(float) (rand() % 1000), (float) (rand() % 1000)};
+        }
+
+        // Point hit-testing: linear scan over 50 probes (it is slow), the
+        // indexes over all of them
+        size_t linear_hits = 0, grid_hits = 0, bvh_hits = 0;
+        const int linear_queries = 50;
+        ShapeRef hits[64];
+        start = clock();
+        for (int q = 0; q < linear_queries; q++)
+        {
+            for (size_t i = 0; i < grid.shapes.count; i++)
+            {
+                linear_hits += scene_shape_contains(&scene, grid.shapes.refs[i], probes[q]);
+            }
+        }
+        double t_linear = seconds_since(start) / linear_queries;
+
+        size_t check_grid = 0, check_bvh = 0;
+        start = clock();
+        for (int q = 0; q < queries; q++)
+        {
+            size_t h = shape_grid_query_point(&grid, &scene, probes[q], hits, 64);
+            grid_hits += h;
+            if (q < linear_queries) check_grid += h;
+        }
+        double t_grid = seconds_since(start) / queries;
+
+        start = clock();
+        for (int q = 0; q < queries; q++)
+        {
+            size_t h = shape_bvh_query_point(&bvh, &scene, probes[q], hits, 64);
+            bvh_hits += h;
+            if (q < linear_queries) check_bvh += h;
+        }
+        double t_bvh = seconds_since(start) / queries;
+
+        printf("point query: linear %.2f us, grid %.2f us, BVH %.2f us (%zu hits; results %s)\n",
+               t_linear * 1e6,
+               t_grid * 1e6,
+               t_bvh * 1e6,
+               bvh_hits,
+               check_grid == linear_hits && check_bvh == linear_hits && grid_hits == bvh_hits ? "agree" : "DIFFER");
+
+        // 8 nearest neighbours
+        ShapeRef near[8];
+        float dist_grid[8], dist_bvh[8];
+        int mismatches = 0;
+        start = clock();
+        for (int q = 0; q < queries; q++)
+        {
+            shape_grid_nearest(&grid, &scene, probes[q], 8, near, dist_grid);
+        }
+        t_grid = seconds_since(start) / queries;
+        start = clock();
+        for (int q = 0; q < queries; q++)
+        {
+            shape_bvh_nearest(&bvh, &scene, probes[q], 8, near, dist_bvh);
+        }
+        t_bvh = seconds_since(start) / queries;
+        for (int q = 0; q < 100; q++)
+        {
+            shape_grid_nearest(&grid, &scene, probes[q], 8, near, dist_grid);
+            shape_bvh_nearest(&bvh, &scene, probes[q], 8, near, dist_bvh);
+            mismatches += dist_grid[7] != dist_bvh[7];
+        }
+        printf("8-nearest:   grid %.2f us, BVH %.2f us (%d of 100 differ)\n", t_grid * 1e6, t_bvh * 1e6, mismatches);
+
+        free(probes);
+        shape_bvh_free(&bvh);
+        shape_grid_free(&grid);
+        scene_free(&scene);
+    }
+
+    worker_pool_destroy(pool);
+}
+
+int main()
+{
+    printf("==== ADVANCED DATA STRUCTURES DEMO ====\n\n");
+
+    // Create some colors using bit fields
+    Color red = create_color(255, 0, 0, 255);
+    Color green = create_color(0, 255, 0, 255);
+    Color blue = create_color(0, 0, 255, 255);
+
+    // Create an array of shapes: values, so there is nothing to allocate,
+    // check or free
+    Point triangle_points[3] = {{0.0f, 0.0f}, {5.0f, 10.0f}, {10.0f, 0.0f}};
+    Shape shapes[3] = {
+        make_circle(0.0f, 0.0f, 5.0f, red),
+        make_rectangle(0.0f, 0.0f, 10.0f, 5.0f, green),
+        make_triangle(triangle_points, blue),
+    };
+    StatusCode status = STATUS_SUCCESS;
+
+    // Create an array of function pointers for area calculation
+    AreaCalculator area_calculators[3] = {calculate_circle_area, calculate_rectangle_area, calculate_triangle_area};
+
+    // Render all shapes
+    for (int i = 0; i < 3; i++)
+    {
+        render_shape(&shapes[i]);
+    }
+
+    // Use function pointers to calculate areas
+    printf("Using function pointers for area calculations:\n");
+    for (int i = 0; i < 3; i++)
+    {
+        float area = area_calculators[i](&shapes[i]);
+        printf("%s area: %.2f square units\n", get_shape_name(shapes[i].type), area);
+    }
+
+    // A shape that must outlive this scope escapes to the heap explicitly
+    Shape *kept = create_circle(1.0f, 1.0f, 2.0f, blue);
+    if (kept == NULL)
+    {
+        status = STATUS_ERROR_OUT_OF_MEMORY;
+    }
+    else
+    {
+        printf("\nShape kept on the heap:\n");
+        render_shape(kept);
+        free(kept);
+    }
+
+    // Display status
+    print_status(status);
+
+    // Print memory usage information
+    printf("\nMemory Usage Information:\n");
+    printf("Size of Color (bit fields): %zu bytes\n", sizeof(Color));
+    printf("Size of Point: %zu bytes\n", sizeof(Point));
+    printf("Size of Shape: %zu bytes\n", sizeof(Shape));
+
+    printf("\n=== Size of Each Shape Union Member ===\n");
+    printf("Circle struct: %zu bytes\n", sizeof(((Shape *) 0)->data.circle));
+    printf("Rectangle struct: %zu bytes\n", sizeof(((Shape *) 0)->data.rectangle));
+    printf("Triangle struct: %zu bytes\n", sizeof(((Shape *) 0)->data.triangle));
+
+    demo_scene();
+    benchmark_scene(2000000);
+    demo_spatial_index();
+    benchmark_spatial_index(1000000, 4);
+    demo_packed_colors();
+    benchmark_packed_colors(4000000);
 
     return (int) status;
 }
@@ -1,7 +1,9 @@
 /* generic_linked_list.c */
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 // Generic linked list node structure
 typedef struct Node
@@ -9,6 +11,11 @@ typedef struct Node
     void *data;         // Pointer to the actual data
     size_t data_size;   // Size of the data in bytes
     struct Node *next;  // Pointer to the next node
+    struct Node *prev;  // Pointer to the previous node (O(1) unlink)
+
+    // Hash index links, used only by lists from create_indexed_list
+    struct Node *hash_next;  // Next node in the same bucket
+    size_t hash;             // hash_data(data), cached for rehashing
 } Node;
 
 // Linked list structure
@@ -22,8 +29,16 @@ typedef struct
 
     // Function pointer for comparing data (returns 0 if equal)
     int (*compare_data)(void *a, void *b);
+
+    // Optional hash index: equal data must hash equally. NULL for lists
+    // from create_list, which fall back to linear scans.
+    size_t (*hash_data)(void *data);
+    Node **buckets;       // Chains through hash_next, in list order
+    size_t bucket_count;  // Power of two, grown to keep chains short
 } LinkedList;
 
+#define INITIAL_BUCKETS 16
+
 // Function to create a new linked list
 LinkedList *create_list(void (*print_func)(void *), int (*compare_func)(void *, void *))
 {
@@ -39,10 +54,111 @@ LinkedList *create_list(void (*print_func)(void *), int (*compare_func)(void *,
     list->size = 0;
     list->print_data = print_func;
     list->compare_data = compare_func;
+    list->hash_data = NULL;
+    list->buckets = NULL;
+    list->bucket_count = 0;
 
     return list;
 }
 
+// Function to create a linked list with a hash index, so find and
+// remove_element take O(1) on average instead of scanning the list
+LinkedList *create_indexed_list(void (*print_func)(void *),
+                                int (*compare_func)(void *, void *),
+                                size_t (*hash_func)(void *))
+{
+    if (compare_func == NULL || hash_func == NULL) return NULL;
+
+    LinkedList *list = create_list(print_func, compare_func);
+
+    if (list == NULL) return NULL;
+
+    list->buckets = (Node **) calloc(INITIAL_BUCKETS, sizeof(Node *));
+
+    if (list->buckets == NULL)
+    {
+        printf("Failed to allocate memory for hash index\n");
+        free(list);
+        return NULL;
+    }
+
+    list->hash_data = hash_func;
+    list->bucket_count = INITIAL_BUCKETS;
+
+    return list;
+}
+
+// Double the bucket array once the list has as many nodes as buckets.
+// The list is walked front to back and each node appended to its new
+// chain, so chains stay in list order and find still returns the first
+// match.
+static void index_grow(LinkedList *list)
+{
+    if ((size_t) list->size < list->bucket_count) return;
+
+    size_t new_count = list->bucket_count * 2;
+    Node **buckets = (Node **) calloc(new_count, sizeof(Node *));
+    Node **tails = (Node **) calloc(new_count, sizeof(Node *));
+
+    if (buckets == NULL || tails == NULL)
+    {
+        // Keep the old, fuller table; it is slower but still correct
+        free(buckets);
+        free(tails);
+        return;
+    }
+
+    for (Node *node = list->head; node != NULL; node = node->next)
+    {
+        size_t b = node->hash & (new_count - 1);
+        node->hash_next = NULL;
+        if (tails[b] != NULL)
+        {
+            tails[b]->hash_next = node;
+        }
+        else
+        {
+            buckets[b] = node;
+        }
+        tails[b] = node;
+    }
+
+    free(tails);
+    free(list->buckets);
+    list->buckets = buckets;
+    list->bucket_count = new_count;
+}
+
+// Add a node (already linked into the list) to its bucket: at the front
+// for prepend, at the end for append, matching its place in the list
+static void index_insert(LinkedList *list, Node *node, int at_front)
+{
+    node->hash = list->hash_data(node->data);
+    Node **slot = &list->buckets[node->hash & (list->bucket_count - 1)];
+
+    if (!at_front)
+    {
+        while (*slot != NULL)
+        {
+            slot = &(*slot)->hash_next;
+        }
+    }
+
+    node->hash_next = *slot;
+    *slot = node;
+}
+
+static void index_remove(LinkedList *list, Node *node)
+{
+    Node **slot = &list->buckets[node->hash & (list->bucket_count - 1)];
+
+    while (*slot != node)
+    {
+        slot = &(*slot)->hash_next;
+    }
+    *slot = node->hash_next;
+}
+
 // Function to create a new node with given data
 Node *create_node(void *data, size_t data_size)
 {
@@ -68,6 +184,9 @@ Node *create_node(void *data, size_t data_size)
     memcpy(new_node->data, data, data_size);
     new_node->data_size = data_size;
     new_node->next = NULL;
+    new_node->prev = NULL;
+    new_node->hash_next = NULL;
+    new_node->hash = 0;
 
     return new_node;
 }
@@ -81,8 +200,17 @@ void prepend(LinkedList *list, void *data, size_t data_size)
 
     if (new_node == NULL) return;
 
+    if (list->hash_data != NULL) index_grow(list);
+
     new_node->next = list->head;
+    if (list->head != NULL)
+    {
+        list->head->prev = new_node;
+    }
     list->head = new_node;
+
+    if (list->hash_data != NULL) index_insert(list, new_node, 1);
+
     list->size++;
 }
 
@@ -107,6 +235,13 @@ void append(LinkedList *list, void *data, size_t data_size)
             current = current->next;
         }
         current->next = new_node;
+        new_node->prev = current;
+    }
+
+    if (list->hash_data != NULL)
+    {
+        index_grow(list);
+        index_insert(list, new_node, 0);
     }
 
     list->size++;
@@ -117,6 +252,25 @@ Node *find(LinkedList *list, void *data)
 {
     if (list == NULL || list->head == NULL || list->compare_data == NULL) return NULL;
 
+    if (list->hash_data != NULL)
+    {
+        // Only nodes in data's bucket with the same full hash can match
+        size_t hash = list->hash_data(data);
+        Node *current = list->buckets[hash & (list->bucket_count - 1)];
+
+        while (current != NULL)
+        {
+            if (current->hash == hash
+                && list->compare_data(current->data, data) == 0)
+            {
+                return current;
+            }
+            current = current->hash_next;
+        }
+
+        return NULL;  // Not found
+    }
+
     Node *current = list->head;
 
     while (current != NULL)
@@ -134,40 +288,31 @@ Node *find(LinkedList *list, void *data)
 // Function to remove an element from the list
 int remove_element(LinkedList *list, void *data)
 {
-    if (list == NULL || list->head == NULL || list->compare_data == NULL) return 0;
+    // find uses the hash index when there is one; the prev links make the
+    // unlink itself O(1) either way
+    Node *node = find(list, data);
 
-    Node *current = list->head;
-    Node *prev = NULL;
+    if (node == NULL) return 0;  // Element not found
 
-    // Check if the head node matches
-    if (list->compare_data(current->data, data) == 0)
+    if (list->hash_data != NULL) index_remove(list, node);
+
+    if (node->prev != NULL)
     {
-        list->head = current->next;
-        free(current->data);
-        free(current);
-        list->size--;
-        return 1;
+        node->prev->next = node->next;
     }
-
-    // Check the rest of the list
-    prev = current;
-    current = current->next;
-
-    while (current != NULL)
+    else
     {
-        if (list->compare_data(current->data, data) == 0)
-        {
-            prev->next = current->next;
-            free(current->data);
-            free(current);
-            list->size--;
-            return 1;
-        }
-        prev = current;
-        current = current->next;
+        list->head = node->next;
+    }
+    if (node->next != NULL)
+    {
+        node->next->prev = node->prev;
     }
 
-    return 0;  // Element not found
+    free(node->data);
+    free(node);
+    list->size--;
+    return 1;
 }
 
 // Function to print the list
@@ -220,6 +365,349 @@ void free_list(LinkedList *list)
         current = next;
     }
 
+    free(list->buckets);
+    free(list);
+}
+
+// ==== Unrolled linked list ====
+//
+// Same operations as LinkedList, but each node is one (or a few) cache
+// lines holding several payloads inline, so there is no second malloc per
+// element and a scan touches one line per handful of elements instead of
+// two scattered allocations per element. Nodes come from a pool that
+// carves them out of large blocks and recycles freed ones through a free
+// list, and a tail pointer makes append O(1).
+//
+// Payloads are stored in fixed-size slots: the list is created with the
+// largest data_size it will be given, and each element gets that many
+// bytes (shorter data is zero-padded).
+
+#define CACHE_LINE 64
+#define POOL_BLOCK_NODES 1024  // nodes per block the pool allocates
+
+typedef struct UnrolledNode
+{
+    struct UnrolledNode *next;
+    int count;                 // slots in use, always packed at the front
+    // capacity * slot_size bytes, aligned for any slot (see slot_size)
+    _Alignas(void *) unsigned char payload[];
+} UnrolledNode;
+
+// Allocates nodes in blocks and keeps released nodes on a free list
+typedef struct
+{
+    UnrolledNode *free_nodes;  // linked through ->next
+    void **blocks;             // every block, so the pool can free them
+    int block_count;
+    int block_capacity;
+    size_t node_size;          // a multiple of CACHE_LINE
+} NodePool;
+
+typedef struct
+{
+    UnrolledNode *head;
+    UnrolledNode *tail;
+    int size;           // number of elements
+    int capacity;       // elements per node
+    size_t slot_size;   // bytes per element
+    NodePool pool;
+
+    void (*print_data)(void *data);
+    int (*compare_data)(void *a, void *b);
+} UnrolledList;
+
+UnrolledNode *pool_acquire(NodePool *pool)
+{
+    if (pool->free_nodes == NULL)
+    {
+        if (pool->block_count == pool->block_capacity)
+        {
+            int new_capacity =
+                pool->block_capacity ? pool->block_capacity * 2 : 8;
+            void **blocks = (void **) realloc(
+                pool->blocks, new_capacity * sizeof(void *));
+            if (blocks == NULL) return NULL;
+            pool->blocks = blocks;
+            pool->block_capacity = new_capacity;
+        }
+
+        unsigned char *block = (unsigned char *) aligned_alloc(
+            CACHE_LINE, pool->node_size * POOL_BLOCK_NODES);
+        if (block == NULL)
+        {
+            printf("Failed to allocate memory for node pool\n");
+            return NULL;
+        }
+        pool->blocks[pool->block_count++] = block;
+
+        // Thread the new nodes onto the free list, first node on top
+        for (int i = POOL_BLOCK_NODES - 1; i >= 0; i--)
+        {
+            UnrolledNode *node = (UnrolledNode *) (block + i * pool->node_size);
+            node->next = pool->free_nodes;
+            pool->free_nodes = node;
+        }
+    }
+
+    UnrolledNode *node = pool->free_nodes;
+    pool->free_nodes = node->next;
+    node->next = NULL;
+    node->count = 0;
+    return node;
+}
+
+void pool_release(NodePool *pool, UnrolledNode *node)
+{
+    node->next = pool->free_nodes;
+    pool->free_nodes = node;
+}
+
+// Create an unrolled list whose elements are at most max_data_size bytes
+UnrolledList *create_unrolled_list(void (*print_func)(void *),
+                                   int (*compare_func)(void *, void *),
+                                   size_t max_data_size)
+{
+    if (max_data_size == 0) return NULL;
+
+    UnrolledList *list = (UnrolledList *) calloc(1, sizeof(UnrolledList));
+
+    if (list == NULL)
+    {
+        printf("Failed to allocate memory for list\n");
+        return NULL;
+    }
+
+    // Round slots up to their natural alignment (capped at a pointer's) so
+    // payloads can be read in place through a cast: 3 bytes -> 4, 12 -> 16
+    size_t align = sizeof(void *);
+    while (align / 2 >= max_data_size)
+    {
+        align /= 2;
+    }
+    list->slot_size = (max_data_size + align - 1) / align * align;
+
+    // One cache line if at least two elements fit, otherwise as many lines
+    // as two elements need (a node of one element is just a slow array)
+    size_t header = offsetof(UnrolledNode, payload);
+    int capacity = (int) ((CACHE_LINE - header) / list->slot_size);
+    if (capacity < 2) capacity = 2;
+    size_t node_size = header + capacity * list->slot_size;
+    node_size = (node_size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+
+    // Use whatever room the rounding left
+    list->capacity = (int) ((node_size - header) / list->slot_size);
+    list->pool.node_size = node_size;
+    list->print_data = print_func;
+    list->compare_data = compare_func;
+
+    return list;
+}
+
+static void *slot_at(const UnrolledList *list, UnrolledNode *node, int i)
+{
+    return node->payload + i * list->slot_size;
+}
+
+static void store_slot(UnrolledList *list,
+                       UnrolledNode *node,
+                       int i,
+                       void *data,
+                       size_t data_size)
+{
+    unsigned char *slot = (unsigned char *) slot_at(list, node, i);
+    memcpy(slot, data, data_size);
+    memset(slot + data_size, 0, list->slot_size - data_size);
+}
+
+// Add an element at the beginning of the list
+void unrolled_prepend(UnrolledList *list, void *data, size_t data_size)
+{
+    if (list == NULL || data_size > list->slot_size) return;
+
+    UnrolledNode *node = list->head;
+
+    if (node == NULL || node->count == list->capacity)
+    {
+        node = pool_acquire(&list->pool);
+        if (node == NULL) return;
+
+        node->next = list->head;
+        list->head = node;
+        if (list->tail == NULL) list->tail = node;
+    }
+    else
+    {
+        // Slide the head node's elements up one slot (at most one line)
+        memmove(slot_at(list, node, 1),
+                slot_at(list, node, 0),
+                node->count * list->slot_size);
+    }
+
+    store_slot(list, node, 0, data, data_size);
+    node->count++;
+    list->size++;
+}
+
+// Add an element at the end of the list: O(1) through the tail pointer
+void unrolled_append(UnrolledList *list, void *data, size_t data_size)
+{
+    if (list == NULL || data_size > list->slot_size) return;
+
+    UnrolledNode *node = list->tail;
+
+    if (node == NULL || node->count == list->capacity)
+    {
+        node = pool_acquire(&list->pool);
+        if (node == NULL) return;
+
+        if (list->tail != NULL)
+        {
+            list->tail->next = node;
+        }
+        else
+        {
+            list->head = node;
+        }
+        list->tail = node;
+    }
+
+    store_slot(list, node, node->count, data, data_size);
+    node->count++;
+    list->size++;
+}
+
+// Find an element; returns a pointer to its payload inside the list, valid
+// until the list is next modified
+void *unrolled_find(UnrolledList *list, void *data)
+{
+    if (list == NULL || list->compare_data == NULL) return NULL;
+
+    for (UnrolledNode *node = list->head; node != NULL; node = node->next)
+    {
+        for (int i = 0; i < node->count; i++)
+        {
+            void *slot = slot_at(list, node, i);
+            if (list->compare_data(slot, data) == 0)
+            {
+                return slot;
+            }
+        }
+    }
+
+    return NULL;  // Not found
+}
+
+// Remove the first matching element; returns 1 if one was removed
+int unrolled_remove_element(UnrolledList *list, void *data)
+{
+    if (list == NULL || list->compare_data == NULL) return 0;
+
+    UnrolledNode *prev = NULL;
+
+    for (UnrolledNode *node = list->head; node != NULL; node = node->next)
+    {
+        for (int i = 0; i < node->count; i++)
+        {
+            if (list->compare_data(slot_at(list, node, i), data) != 0)
+            {
+                continue;
+            }
+
+            memmove(slot_at(list, node, i),
+                    slot_at(list, node, i + 1),
+                    (node->count - i - 1) * list->slot_size);
+            node->count--;
+            list->size--;
+
+            UnrolledNode *next = node->next;
+            if (node->count == 0)
+            {
+                // Unlink the empty node and recycle it
+                if (prev != NULL)
+                {
+                    prev->next = next;
+                }
+                else
+                {
+                    list->head = next;
+                }
+                if (list->tail == node) list->tail = prev;
+                pool_release(&list->pool, node);
+            }
+            else if (next != NULL
+                     && node->count + next->count <= list->capacity)
+            {
+                // Pull the next node's elements in so nodes stay dense
+                memcpy(slot_at(list, node, node->count),
+                       slot_at(list, next, 0),
+                       next->count * list->slot_size);
+                node->count += next->count;
+                node->next = next->next;
+                if (list->tail == next) list->tail = node;
+                pool_release(&list->pool, next);
+            }
+            return 1;
+        }
+        prev = node;
+    }
+
+    return 0;  // Element not found
+}
+
+// Print the list
+void unrolled_print_list(UnrolledList *list)
+{
+    if (list == NULL || list->head == NULL)
+    {
+        printf("List is empty\n");
+        return;
+    }
+
+    printf("Unrolled list (size %d, %d per node): ",
+           list->size,
+           list->capacity);
+
+    for (UnrolledNode *node = list->head; node != NULL; node = node->next)
+    {
+        printf("[");
+        for (int i = 0; i < node->count; i++)
+        {
+            if (list->print_data != NULL)
+            {
+                list->print_data(slot_at(list, node, i));
+            }
+            else
+            {
+                printf("[data]");
+            }
+
+            if (i + 1 < node->count)
+            {
+                printf(", ");
+            }
+        }
+        printf("]");
+
+        if (node->next != NULL)
+        {
+            printf(" -> ");
+        }
+    }
+
+    printf("\n");
+}
+
+// Free the list; every node lives in a pool block, so this is one free per
+// block rather than two per element
+void unrolled_free_list(UnrolledList *list)
+{
+    if (list == NULL) return;
+
+    for (int i = 0; i < list->pool.block_count; i++)
+    {
+        free(list->pool.blocks[i]);
+    }
+    free(list->pool.blocks);
     free(list);
 }
 
@@ -235,6 +723,13 @@ int compare_int(void *a, void *b)
     return *(int *) a - *(int *) b;
 }
 
+// Hash function for integers (the multiply spreads nearby values, which
+// the index masks down to their low bits, across buckets)
+size_t hash_int(void *data)
+{
+    return (size_t) ((unsigned int) *(int *) data * 2654435761u);
+}
+
 // Print function for strings
 void print_string(void *data)
 {
@@ -247,6 +742,127 @@ int compare_string(void *a, void *b)
     return strcmp((char *) a, (char *) b);
 }
 
+// Hash function for strings (FNV-1a)
+size_t hash_string(void *data)
+{
+    size_t hash = 14695981039346656037ull;
+    for (const unsigned char *p = (const unsigned char *) data; *p; p++)
+    {
+        hash = (hash ^ *p) * 1099511628211ull;
+    }
+    return hash;
+}
+
+double seconds_since(clock_t start)
+{
+    return ((double) (clock() - start)) / CLOCKS_PER_SEC;
+}
+
+// Deduplicate n values drawn from [0, n / 2): insert each one unless the
+// list already has it, then remove every value again. The linear list is
+// quadratic, so large runs can skip it.
+void benchmark_dedup(int n, int include_linear)
+{
+    LinkedList *lists[] = {
+        create_list(print_int, compare_int),
+        create_indexed_list(print_int, compare_int, hash_int),
+    };
+    const char *names[] = {"linear", "hash index"};
+
+    printf("\nDedup of %d values:\n", n);
+
+    for (int l = 0; l < 2; l++)
+    {
+        LinkedList *list = lists[l];
+        if (list == NULL) continue;
+        if (l == 0 && !include_linear)
+        {
+            free_list(list);
+            continue;
+        }
+
+        srand(42);
+        clock_t start = clock();
+        for (int i = 0; i < n; i++)
+        {
+            int value = rand() % (n / 2);
+            if (find(list, &value) == NULL)
+            {
+                prepend(list, &value, sizeof(int));
+            }
+        }
+        int unique = list->size;
+        for (int value = 0; value < n / 2; value++)
+        {
+            remove_element(list, &value);
+        }
+        printf("  %-10s %8.3f s (%d unique, %d left)\n",
+               names[l],
+               seconds_since(start),
+               unique,
+               list->size);
+        free_list(list);
+    }
+}
+
+// Build, scan and tear down both lists with n integers
+void benchmark_lists(int n, int include_linked_append)
+{
+    int missing = -1;
+    clock_t start;
+
+    printf("\n%d elements:\n", n);
+
+    if (include_linked_append)
+    {
+        // append walks from head every time: O(n^2) overall
+        LinkedList *list = create_list(print_int, compare_int);
+        start = clock();
+        for (int i = 0; i < n; i++)
+        {
+            append(list, &i, sizeof(int));
+        }
+        printf("  LinkedList append:     %8.3f s\n", seconds_since(start));
+        free_list(list);
+    }
+
+    // prepend is O(1) but still two mallocs per element
+    LinkedList *list = create_list(print_int, compare_int);
+    start = clock();
+    for (int i = 0; i < n; i++)
+    {
+        prepend(list, &i, sizeof(int));
+    }
+    printf("  LinkedList prepend:    %8.3f s\n", seconds_since(start));
+
+    start = clock();
+    find(list, &missing);
+    printf("  LinkedList full scan:  %8.3f s\n", seconds_since(start));
+
+    start = clock();
+    free_list(list);
+    printf("  LinkedList free:       %8.3f s\n", seconds_since(start));
+
+    UnrolledList *unrolled =
+        create_unrolled_list(print_int, compare_int, sizeof(int));
+    if (unrolled == NULL) return;
+
+    start = clock();
+    for (int i = 0; i < n; i++)
+    {
+        unrolled_append(unrolled, &i, sizeof(int));
+    }
+    printf("  UnrolledList append:   %8.3f s\n", seconds_since(start));
+
+    start = clock();
+    unrolled_find(unrolled, &missing);
+    printf("  UnrolledList full scan:%8.3f s\n", seconds_since(start));
+
+    start = clock();
+    unrolled_free_list(unrolled);
+    printf("  UnrolledList free:     %8.3f s\n", seconds_since(start));
+}
+
 int main()
 {
     printf("=== Generic Linked List Example ===\n\n");
@@ -334,5 +950,67 @@ int main()
     print_list(string_list);
     free_list(string_list);
 
+    // 3. A string list with a hash index: same calls, O(1) lookups
+    printf("\n--- Indexed List Example ---\n");
+    LinkedList *indexed =
+        create_indexed_list(print_string, compare_string, hash_string);
+
+    for (int i = 0; i < 5; i++)
+    {
+        append(indexed, fruits[i], strlen(fruits[i]) + 1);
+    }
+    prepend(indexed, "Fig", strlen("Fig") + 1);
+
+    found = find(indexed, search_string);
+    printf("Found string \"%s\" in the list\n",
+           found ? (char *) found->data : "(none)");
+    remove_element(indexed, remove_string);
+    remove_element(indexed, "Fig");
+    print_list(indexed);
+    free_list(indexed);
+
+    // 4. The same operations on an unrolled list
+    printf("\n--- Unrolled List Example ---\n");
+    UnrolledList *unrolled =
+        create_unrolled_list(print_int, compare_int, sizeof(int));
+
+    for (int i = 1; i <= 30; i++)
+    {
+        int value = i * 10;
+        unrolled_append(unrolled, &value, sizeof(int));
+    }
+    int first = 0;
+    unrolled_prepend(unrolled, &first, sizeof(int));
+    unrolled_print_list(unrolled);
+
+    int *found_int = (int *) unrolled_find(unrolled, &search_value);
+    printf("Found value %d in the list\n", found_int ? *found_int : -1);
+
+    for (int value = 10; value <= 300; value += 20)
+    {
+        unrolled_remove_element(unrolled, &value);
+    }
+    printf("Removed 10, 30, ..., 290\n");
+    unrolled_print_list(unrolled);
+    unrolled_free_list(unrolled);
+
+    UnrolledList *unrolled_strings =
+        create_unrolled_list(print_string, compare_string, 16);
+
+    for (int i = 0; i < 5; i++)
+    {
+        unrolled_append(unrolled_strings, fruits[i], strlen(fruits[i]) + 1);
+    }
+    unrolled_remove_element(unrolled_strings, remove_string);
+    unrolled_print_list(unrolled_strings);
+    unrolled_free_list(unrolled_strings);
+
+    // 5. Benchmark
+    printf("\n--- Benchmark ---");
+    benchmark_lists(20000, 1);
+    benchmark_lists(10000000, 0);
+    benchmark_dedup(20000, 1);
+    benchmark_dedup(1000000, 0);
+
     return 0;
 }
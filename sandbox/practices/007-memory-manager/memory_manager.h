@@ -0,0 +1,1017 @@
+// The practice's allocator: size-class slab pools with an optional
+// per-thread magazine cache and sampled leak tracking. main.c runs the
+// demos; other programs include this header to use the same allocator
+// (MM_ALLOC/MM_FREE, memory_manager_* and memory_thread_flush).
+#ifndef MEMORY_MANAGER_H
+#define MEMORY_MANAGER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// =================================================================
+// Memory Manager: A comprehensive example combining various concepts
+// =================================================================
+
+// Define block sizes for small object pool
+#define TINY_BLOCK_SIZE 16
+#define SMALL_BLOCK_SIZE 64
+#define MEDIUM_BLOCK_SIZE 256
+
+// Size and alignment of one slab page; a block finds its slab by masking
+#define SLAB_SIZE 16384
+
+// Fully free slabs a pool keeps before returning pages to the system
+#define POOL_MAX_EMPTY_SLABS 1
+
+// Magic number for detecting overwrites
+#define MEMORY_MAGIC 0xDEADBEEF
+
+// Header flags
+#define HEADER_TRACKED 0x1  // Linked into the allocation list
+#define HEADER_POOLED  0x2  // Block came from a pool (block_size bytes)
+
+// Average number of allocated bytes between two tracked allocations.
+// Debug builds (-DMEMORY_DEBUG) track every allocation instead.
+#ifdef MEMORY_DEBUG
+#define MEMORY_DEFAULT_SAMPLE_INTERVAL 0
+#else
+#define MEMORY_DEFAULT_SAMPLE_INTERVAL (512 * 1024)
+#endif
+
+// Compact header in front of every allocation
+typedef struct
+{
+    size_t size;     // Size of the allocation
+    uint32_t magic;  // Magic number for validation
+    uint32_t flags;  // HEADER_* flags
+} BlockHeader;
+
+// Internal tracking header, only present on tracked allocations
+typedef struct MemoryHeader
+{
+    const char *file;           // Source file where allocation happened
+    int line;                   // Line number where allocation happened
+    struct MemoryHeader *prev;  // Previous allocation in the list
+    struct MemoryHeader *next;  // Next allocation in the list
+    BlockHeader block;          // Must be last: it directly precedes the data
+} MemoryHeader;
+
+// Block size categories
+typedef enum
+{
+    BLOCK_TINY,
+    BLOCK_SMALL,
+    BLOCK_MEDIUM,
+    BLOCK_LARGE  // For any size larger than medium blocks
+} BlockCategory;
+
+// Free block, the link is stored inside the block itself
+typedef struct FreeBlock
+{
+    struct FreeBlock *next;
+} FreeBlock;
+
+// Slab page header; the blocks are carved from the rest of the page
+typedef struct Slab
+{
+    struct Slab *prev;
+    struct Slab *next;
+    FreeBlock *free_list;  // Free blocks in this slab
+    size_t free_count;     // Number of blocks on free_list
+    size_t capacity;       // Number of blocks carved from this slab
+} Slab;
+
+// Fixed-size block pool made of growable slab pages
+typedef struct
+{
+    Slab *partial;       // Slabs with at least one free block
+    Slab *full;          // Slabs with every block in use
+    size_t block_size;
+    size_t count;        // Blocks carved across all slabs
+    size_t slab_count;   // Slabs currently owned by the pool
+    size_t empty_slabs;  // Slabs with every block free
+} BlockPool;
+
+// Memory Manager
+typedef struct
+{
+    // Block pools for different sizes
+    BlockPool tiny_pool;    // For allocations <= 16 bytes
+    BlockPool small_pool;   // For allocations <= 64 bytes
+    BlockPool medium_pool;  // For allocations <= 256 bytes
+
+    // Tracking for all allocations (including large ones)
+    MemoryHeader *allocations;
+    size_t allocation_count;
+    size_t total_allocated;
+    size_t peak_allocated;
+
+    // Statistics
+    size_t malloc_calls;
+    size_t free_calls;
+    size_t pool_hits;
+    size_t cache_hits;  // Served from a thread magazine or the depot
+
+    // Route pooled sizes through per-thread magazines
+    bool thread_cache_enabled;
+
+    // Bytes between tracked allocations, 0 tracks every allocation
+    size_t sample_interval;
+} MemoryManager;
+
+// State before the first allocation. The pools are empty and grow a slab
+// at a time when used, so there is nothing to set up at startup: the
+// manager works from this static initializer without memory_manager_init.
+#define MEMORY_MANAGER_INITIAL                             \
+    {                                                      \
+        .tiny_pool = {.block_size = TINY_BLOCK_SIZE},      \
+        .small_pool = {.block_size = SMALL_BLOCK_SIZE},    \
+        .medium_pool = {.block_size = MEDIUM_BLOCK_SIZE},  \
+        .sample_interval = MEMORY_DEFAULT_SAMPLE_INTERVAL, \
+    }
+
+// Global memory manager
+static MemoryManager g_memory_manager = MEMORY_MANAGER_INITIAL;
+
+// Serializes the pools and the allocation list in thread cache mode
+static pthread_mutex_t g_manager_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Initialize a block pool
+static inline void init_block_pool(BlockPool *pool, size_t block_size)
+{
+    pool->partial = NULL;
+    pool->full = NULL;
+    pool->block_size = block_size;
+    pool->count = 0;
+    pool->slab_count = 0;
+    pool->empty_slabs = 0;
+}
+
+// Reset the memory manager to its initial state. Optional before the first
+// allocation; after memory_manager_cleanup the manager is already reset.
+static inline void memory_manager_init()
+{
+    g_memory_manager = (MemoryManager) MEMORY_MANAGER_INITIAL;
+}
+
+// Change the tracking sample interval; 0 records every allocation
+static inline void memory_set_sample_interval(size_t bytes)
+{
+    g_memory_manager.sample_interval = bytes;
+}
+
+// Unlink a slab from one of the pool's slab lists
+static inline void slab_unlink(Slab **list, Slab *slab)
+{
+    if (slab->prev)
+    {
+        slab->prev->next = slab->next;
+    }
+    else
+    {
+        *list = slab->next;
+    }
+
+    if (slab->next)
+    {
+        slab->next->prev = slab->prev;
+    }
+}
+
+// Push a slab onto the front of one of the pool's slab lists
+static inline void slab_push(Slab **list, Slab *slab)
+{
+    slab->prev = NULL;
+    slab->next = *list;
+    if (*list)
+    {
+        (*list)->prev = slab;
+    }
+    *list = slab;
+}
+
+// Find the slab that owns a block
+static inline Slab *slab_of_block(void *block)
+{
+    return (Slab *) ((uintptr_t) block & ~((uintptr_t) SLAB_SIZE - 1));
+}
+
+// Add a new slab page to the pool
+static inline bool add_slab_to_pool(BlockPool *pool)
+{
+    Slab *slab = aligned_alloc(SLAB_SIZE, SLAB_SIZE);
+    if (!slab)
+    {
+        return false;  // Out of memory
+    }
+
+    // Thread the free list through the blocks following the header
+    size_t header_size = (sizeof(Slab) + 15) & ~(size_t) 15;
+    char *first = (char *) slab + header_size;
+    slab->capacity = (SLAB_SIZE - header_size) / pool->block_size;
+    slab->free_list = NULL;
+    for (size_t i = slab->capacity; i > 0; i--)
+    {
+        FreeBlock *block = (FreeBlock *) (first + (i - 1) * pool->block_size);
+        block->next = slab->free_list;
+        slab->free_list = block;
+    }
+    slab->free_count = slab->capacity;
+
+    slab_push(&pool->partial, slab);
+    pool->count += slab->capacity;
+    pool->slab_count++;
+    pool->empty_slabs++;
+
+    return true;
+}
+
+// Get block category based on size
+static inline BlockCategory get_block_category(size_t size)
+{
+    if (size <= TINY_BLOCK_SIZE) return BLOCK_TINY;
+    if (size <= SMALL_BLOCK_SIZE) return BLOCK_SMALL;
+    if (size <= MEDIUM_BLOCK_SIZE) return BLOCK_MEDIUM;
+    return BLOCK_LARGE;
+}
+
+// Get corresponding pool for block category
+static inline BlockPool *get_pool_for_category(BlockCategory category)
+{
+    switch (category)
+    {
+    case BLOCK_TINY:
+        return &g_memory_manager.tiny_pool;
+    case BLOCK_SMALL:
+        return &g_memory_manager.small_pool;
+    case BLOCK_MEDIUM:
+        return &g_memory_manager.medium_pool;
+    default:
+        return NULL;
+    }
+}
+
+// Allocate from block pool
+static inline void *allocate_from_pool(BlockPool *pool)
+{
+    // No free blocks in any slab, grow the pool by one page
+    if (!pool->partial)
+    {
+        if (!add_slab_to_pool(pool))
+        {
+            return NULL;  // Failed to allocate
+        }
+    }
+    else
+    {
+        g_memory_manager.pool_hits++;
+    }
+
+    Slab *slab = pool->partial;
+    FreeBlock *block = slab->free_list;
+
+    if (slab->free_count == slab->capacity)
+    {
+        pool->empty_slabs--;
+    }
+    slab->free_list = block->next;
+    slab->free_count--;
+
+    // Slab is exhausted, move it to the full list
+    if (slab->free_count == 0)
+    {
+        slab_unlink(&pool->partial, slab);
+        slab_push(&pool->full, slab);
+    }
+
+    return block;
+}
+
+// Per-thread sampling state
+static _Thread_local size_t t_bytes_until_sample;
+static _Thread_local uint32_t t_sample_seed = 2463534242u;
+
+// Decide whether an allocation gets a tracking header. Like a heap
+// profiler, one allocation is picked roughly every sample_interval bytes;
+// the interval is jittered so periodic allocation patterns are not missed.
+static inline bool should_track_allocation(size_t size)
+{
+    size_t interval = g_memory_manager.sample_interval;
+    if (interval == 0)
+    {
+        return true;
+    }
+
+    if (size < t_bytes_until_sample)
+    {
+        t_bytes_until_sample -= size;
+        return false;
+    }
+
+    // xorshift32, uniform in [0, 2 * interval) so the mean stays interval
+    t_sample_seed ^= t_sample_seed << 13;
+    t_sample_seed ^= t_sample_seed >> 17;
+    t_sample_seed ^= t_sample_seed << 5;
+    t_bytes_until_sample = (size_t) ((uint64_t) t_sample_seed * (2 * (uint64_t) interval) >> 32);
+    return true;
+}
+
+// Bytes of header in front of the data for the given flags
+static inline size_t header_overhead(uint32_t flags)
+{
+    return (flags & HEADER_TRACKED) ? sizeof(MemoryHeader) : sizeof(BlockHeader);
+}
+
+// Get the tracking header of a tracked block
+static inline MemoryHeader *tracking_header(BlockHeader *block)
+{
+    return (MemoryHeader *) ((char *) block - offsetof(MemoryHeader, block));
+}
+
+// Start of the underlying block for a header
+static inline void *block_start(BlockHeader *block)
+{
+    if (block->flags & HEADER_TRACKED)
+    {
+        return tracking_header(block);
+    }
+    return block;
+}
+
+// Track allocation in the linked list
+static inline void track_allocation(MemoryHeader *header, const char *file, int line)
+{
+    // Set header fields
+    header->file = file;
+    header->line = line;
+    header->prev = NULL;
+    header->next = g_memory_manager.allocations;
+
+    // Update linked list
+    if (g_memory_manager.allocations)
+    {
+        g_memory_manager.allocations->prev = header;
+    }
+    g_memory_manager.allocations = header;
+}
+
+// Untrack allocation from the linked list
+static inline void untrack_allocation(MemoryHeader *header)
+{
+    // Remove from linked list
+    if (header->prev)
+    {
+        header->prev->next = header->next;
+    }
+    else
+    {
+        g_memory_manager.allocations = header->next;
+    }
+
+    if (header->next)
+    {
+        header->next->prev = header->prev;
+    }
+}
+
+// Update statistics for a new allocation
+static inline void account_allocation(size_t size)
+{
+    g_memory_manager.allocation_count++;
+    g_memory_manager.total_allocated += size;
+
+    // Update peak memory usage
+    if (g_memory_manager.total_allocated > g_memory_manager.peak_allocated)
+    {
+        g_memory_manager.peak_allocated = g_memory_manager.total_allocated;
+    }
+}
+
+// Update statistics for a freed allocation
+static inline void account_free(size_t size)
+{
+    g_memory_manager.allocation_count--;
+    g_memory_manager.total_allocated -= size;
+}
+
+// =================================================================
+// Thread cache: per-thread magazines over a lock-free depot
+// =================================================================
+
+// Blocks held by one magazine
+#define MAGAZINE_CAPACITY 32
+
+// Magazines owned by the depot of each pooled category
+#define DEPOT_MAGAZINES 64
+
+// Tiny, small and medium are pooled; large always goes to malloc
+#define POOLED_CATEGORIES BLOCK_LARGE
+
+static inline void return_to_pool(void *ptr, BlockCategory category);
+
+// A magazine is a small stack of free blocks of one category
+typedef struct
+{
+    _Atomic uint32_t next;  // Index + 1 of the next magazine in a depot stack
+    size_t rounds;          // Number of blocks currently held
+    void *blocks[MAGAZINE_CAPACITY];
+} Magazine;
+
+// Depot stack heads pack (tag << 32 | index + 1); the tag defeats ABA.
+// Magazines are handed out in index order the first time they are needed,
+// so enabling the cache touches none of them and a process that never
+// frees into the cache never faults in the depot's pages.
+typedef struct
+{
+    Magazine magazines[DEPOT_MAGAZINES];
+    _Atomic uint64_t full;    // Magazines holding at least one block
+    _Atomic uint64_t empty;   // Magazines holding no blocks
+    _Atomic uint32_t unused;  // Magazines[unused..] never handed out yet
+} Depot;
+
+// Per-thread state: two magazines per category plus local statistics
+typedef struct
+{
+    Magazine *loaded[POOLED_CATEGORIES];
+    Magazine *previous[POOLED_CATEGORIES];
+    size_t malloc_calls;
+    size_t free_calls;
+    size_t cache_hits;
+    size_t bytes_allocated;
+    size_t bytes_freed;
+} ThreadCache;
+
+static Depot g_depots[POOLED_CATEGORIES];
+static _Thread_local ThreadCache t_cache;
+
+// Push a magazine onto a depot stack
+static inline void depot_push(Depot *depot, _Atomic uint64_t *head, Magazine *mag)
+{
+    uint64_t index = (uint64_t) (mag - depot->magazines) + 1;
+    uint64_t old = atomic_load_explicit(head, memory_order_relaxed);
+    uint64_t desired;
+
+    do
+    {
+        atomic_store_explicit(&mag->next, (uint32_t) old, memory_order_relaxed);
+        desired = (((old >> 32) + 1) << 32) | index;
+    } while (!atomic_compare_exchange_weak_explicit(
+        head, &old, desired, memory_order_release, memory_order_relaxed));
+}
+
+// Pop a magazine from a depot stack, or NULL if it is empty
+static inline Magazine *depot_pop(Depot *depot, _Atomic uint64_t *head)
+{
+    uint64_t old = atomic_load_explicit(head, memory_order_acquire);
+    uint64_t desired;
+
+    do
+    {
+        uint32_t index = (uint32_t) old;
+        if (index == 0)
+        {
+            return NULL;
+        }
+        uint32_t next = atomic_load_explicit(
+            &depot->magazines[index - 1].next, memory_order_relaxed);
+        desired = (((old >> 32) + 1) << 32) | next;
+    } while (!atomic_compare_exchange_weak_explicit(
+        head, &old, desired, memory_order_acquire, memory_order_acquire));
+
+    return &depot->magazines[(uint32_t) old - 1];
+}
+
+// An empty magazine: one returned to the depot, else one never used
+static inline Magazine *depot_pop_empty(Depot *depot)
+{
+    Magazine *mag = depot_pop(depot, &depot->empty);
+    if (mag)
+    {
+        return mag;
+    }
+
+    uint32_t index = atomic_load_explicit(&depot->unused, memory_order_relaxed);
+    do
+    {
+        if (index == DEPOT_MAGAZINES)
+        {
+            return NULL;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(
+        &depot->unused, &index, index + 1, memory_order_relaxed, memory_order_relaxed));
+
+    mag = &depot->magazines[index];
+    mag->rounds = 0;
+    return mag;
+}
+
+// Enable thread cache mode; call before starting threads
+static inline void memory_manager_enable_thread_cache()
+{
+    for (int c = 0; c < POOLED_CATEGORIES; c++)
+    {
+        Depot *depot = &g_depots[c];
+        atomic_init(&depot->full, 0);
+        atomic_init(&depot->empty, 0);
+        atomic_init(&depot->unused, 0);
+    }
+    g_memory_manager.thread_cache_enabled = true;
+}
+
+// Slow path: take one block straight from the shared pool
+static inline void *cache_alloc_from_pool(BlockCategory category)
+{
+    pthread_mutex_lock(&g_manager_lock);
+    void *block = allocate_from_pool(get_pool_for_category(category));
+    pthread_mutex_unlock(&g_manager_lock);
+    return block;
+}
+
+// Refill an empty magazine with half a load from the shared pool
+static inline void cache_refill(Magazine *mag, BlockCategory category)
+{
+    BlockPool *pool = get_pool_for_category(category);
+
+    pthread_mutex_lock(&g_manager_lock);
+    while (mag->rounds < MAGAZINE_CAPACITY / 2)
+    {
+        void *block = allocate_from_pool(pool);
+        if (!block)
+        {
+            break;
+        }
+        mag->blocks[mag->rounds++] = block;
+    }
+    pthread_mutex_unlock(&g_manager_lock);
+}
+
+// Take a pooled block of the given category, or NULL if the pool is exhausted
+static inline void *thread_cache_alloc(BlockCategory category)
+{
+    Depot *depot = &g_depots[category];
+    Magazine **loaded = &t_cache.loaded[category];
+    Magazine **previous = &t_cache.previous[category];
+
+    if (*loaded && (*loaded)->rounds > 0)
+    {
+        t_cache.cache_hits++;
+        return (*loaded)->blocks[--(*loaded)->rounds];
+    }
+
+    // Previous magazine still has blocks: swap it in
+    if (*previous && (*previous)->rounds > 0)
+    {
+        Magazine *tmp = *loaded;
+        *loaded = *previous;
+        *previous = tmp;
+        t_cache.cache_hits++;
+        return (*loaded)->blocks[--(*loaded)->rounds];
+    }
+
+    // Both are empty: trade one for a full magazine from the depot
+    Magazine *full = depot_pop(depot, &depot->full);
+    if (full)
+    {
+        if (*previous)
+        {
+            depot_push(depot, &depot->empty, *previous);
+        }
+        *previous = *loaded;
+        *loaded = full;
+        t_cache.cache_hits++;
+        return full->blocks[--full->rounds];
+    }
+
+    // Depot has nothing cached: refill from the shared pool
+    if (!*loaded)
+    {
+        *loaded = depot_pop_empty(depot);
+    }
+    if (!*loaded)
+    {
+        return cache_alloc_from_pool(category);
+    }
+
+    cache_refill(*loaded, category);
+    if ((*loaded)->rounds == 0)
+    {
+        return NULL;
+    }
+    return (*loaded)->blocks[--(*loaded)->rounds];
+}
+
+// Give a pooled block back to the calling thread's cache
+static inline void thread_cache_free(void *block, BlockCategory category)
+{
+    Depot *depot = &g_depots[category];
+    Magazine **loaded = &t_cache.loaded[category];
+    Magazine **previous = &t_cache.previous[category];
+
+    if (*loaded && (*loaded)->rounds < MAGAZINE_CAPACITY)
+    {
+        (*loaded)->blocks[(*loaded)->rounds++] = block;
+        return;
+    }
+
+    // Previous magazine is empty: swap it in
+    if (*previous && (*previous)->rounds == 0)
+    {
+        Magazine *tmp = *loaded;
+        *loaded = *previous;
+        *previous = tmp;
+        (*loaded)->blocks[(*loaded)->rounds++] = block;
+        return;
+    }
+
+    // Loaded is full: trade a magazine for an empty one from the depot
+    Magazine *empty = depot_pop_empty(depot);
+    if (empty)
+    {
+        if (*previous)
+        {
+            depot_push(depot, &depot->full, *previous);
+        }
+        *previous = *loaded;
+        *loaded = empty;
+        empty->blocks[empty->rounds++] = block;
+        return;
+    }
+
+    // Depot is out of magazines: hand the block back to the shared pool
+    pthread_mutex_lock(&g_manager_lock);
+    return_to_pool(block, category);
+    pthread_mutex_unlock(&g_manager_lock);
+}
+
+// Allocation path used in thread cache mode
+static inline void *memory_alloc_cached(size_t size, const char *file, int line)
+{
+    uint32_t flags = should_track_allocation(size) ? HEADER_TRACKED : 0;
+    size_t total_size = size + header_overhead(flags);
+    BlockCategory category = get_block_category(total_size);
+    void *ptr = NULL;
+
+    if (category != BLOCK_LARGE)
+    {
+        ptr = thread_cache_alloc(category);
+        flags |= ptr ? HEADER_POOLED : 0;
+    }
+
+    if (!ptr)
+    {
+        ptr = malloc(total_size);
+        if (!ptr)
+        {
+            return NULL;
+        }
+    }
+
+    // Only sampled allocations take the lock to join the allocation list
+    BlockHeader *block = ptr;
+    if (flags & HEADER_TRACKED)
+    {
+        block = &((MemoryHeader *) ptr)->block;
+        pthread_mutex_lock(&g_manager_lock);
+        track_allocation(ptr, file, line);
+        pthread_mutex_unlock(&g_manager_lock);
+    }
+    block->size = size;
+    block->magic = MEMORY_MAGIC;
+    block->flags = flags;
+
+    t_cache.malloc_calls++;
+    t_cache.bytes_allocated += size;
+
+    return block + 1;
+}
+
+// Free path used in thread cache mode
+static inline void memory_free_cached(void *ptr, const char *file, int line)
+{
+    BlockHeader *block = (BlockHeader *) ptr - 1;
+
+    if (block->magic != MEMORY_MAGIC)
+    {
+        printf("ERROR: Memory corruption detected in free! Magic number mismatch at %s:%d\n", file, line);
+        return;
+    }
+
+    t_cache.free_calls++;
+    t_cache.bytes_freed += block->size;
+
+    if (block->flags & HEADER_TRACKED)
+    {
+        pthread_mutex_lock(&g_manager_lock);
+        untrack_allocation(tracking_header(block));
+        pthread_mutex_unlock(&g_manager_lock);
+    }
+
+    // Clear magic number to detect double-frees
+    block->magic = 0;
+
+    if (block->flags & HEADER_POOLED)
+    {
+        size_t total_size = block->size + header_overhead(block->flags);
+        thread_cache_free(block_start(block), get_block_category(total_size));
+    }
+    else
+    {
+        free(block_start(block));
+    }
+}
+
+// Return this thread's magazines to the depot and publish its statistics.
+// Every thread that allocated in thread cache mode must call this before exit.
+static inline void memory_thread_flush()
+{
+    for (int c = 0; c < POOLED_CATEGORIES; c++)
+    {
+        Depot *depot = &g_depots[c];
+        Magazine *mags[2] = {t_cache.loaded[c], t_cache.previous[c]};
+
+        for (int i = 0; i < 2; i++)
+        {
+            if (mags[i])
+            {
+                depot_push(depot, mags[i]->rounds > 0 ? &depot->full : &depot->empty, mags[i]);
+            }
+        }
+    }
+
+    pthread_mutex_lock(&g_manager_lock);
+    g_memory_manager.malloc_calls += t_cache.malloc_calls;
+    g_memory_manager.free_calls += t_cache.free_calls;
+    g_memory_manager.cache_hits += t_cache.cache_hits;
+    g_memory_manager.allocation_count += t_cache.malloc_calls;
+    g_memory_manager.allocation_count -= t_cache.free_calls;
+    g_memory_manager.total_allocated += t_cache.bytes_allocated;
+    g_memory_manager.total_allocated -= t_cache.bytes_freed;
+    if (g_memory_manager.total_allocated > g_memory_manager.peak_allocated)
+    {
+        g_memory_manager.peak_allocated = g_memory_manager.total_allocated;
+    }
+    pthread_mutex_unlock(&g_manager_lock);
+
+    memset(&t_cache, 0, sizeof(t_cache));
+}
+
+// Custom memory allocation function
+static inline void *memory_alloc(size_t size, const char *file, int line)
+{
+    if (g_memory_manager.thread_cache_enabled)
+    {
+        return memory_alloc_cached(size, file, line);
+    }
+
+    g_memory_manager.malloc_calls++;
+
+    // Sampled allocations carry the full tracking header
+    uint32_t flags = should_track_allocation(size) ? HEADER_TRACKED : 0;
+
+    // Account for header size
+    size_t total_size = size + header_overhead(flags);
+
+    // Determine block category
+    BlockCategory category = get_block_category(total_size);
+
+    void *ptr = NULL;
+
+    // Try to allocate from pool for small sizes
+    if (category != BLOCK_LARGE)
+    {
+        BlockPool *pool = get_pool_for_category(category);
+        ptr = allocate_from_pool(pool);
+        flags |= ptr ? HEADER_POOLED : 0;
+    }
+
+    // Fall back to malloc for large blocks or if pool allocation failed
+    if (!ptr)
+    {
+        ptr = malloc(total_size);
+        if (!ptr)
+        {
+            return NULL;  // Out of memory
+        }
+    }
+
+    // Set up header
+    BlockHeader *block = ptr;
+    if (flags & HEADER_TRACKED)
+    {
+        block = &((MemoryHeader *) ptr)->block;
+        track_allocation(ptr, file, line);
+    }
+    block->size = size;
+    block->magic = MEMORY_MAGIC;
+    block->flags = flags;
+    account_allocation(size);
+
+    // Return pointer after header
+    return block + 1;
+}
+
+// Return memory to pool or free it
+static inline void return_to_pool(void *ptr, BlockCategory category)
+{
+    // For large blocks, just free them
+    if (category == BLOCK_LARGE)
+    {
+        free(ptr);
+        return;
+    }
+
+    BlockPool *pool = get_pool_for_category(category);
+    Slab *slab = slab_of_block(ptr);
+    FreeBlock *block = (FreeBlock *) ptr;
+
+    // Slab was full, it can serve allocations again
+    if (slab->free_count == 0)
+    {
+        slab_unlink(&pool->full, slab);
+        slab_push(&pool->partial, slab);
+    }
+
+    block->next = slab->free_list;
+    slab->free_list = block;
+    slab->free_count++;
+
+    if (slab->free_count < slab->capacity)
+    {
+        return;
+    }
+
+    // Slab is idle: keep a few for reuse, give the rest back to the system
+    if (pool->empty_slabs >= POOL_MAX_EMPTY_SLABS)
+    {
+        slab_unlink(&pool->partial, slab);
+        pool->count -= slab->capacity;
+        pool->slab_count--;
+        free(slab);
+    }
+    else
+    {
+        pool->empty_slabs++;
+    }
+}
+
+// Custom memory free function
+static inline void memory_free(void *ptr, const char *file, int line)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    if (g_memory_manager.thread_cache_enabled)
+    {
+        memory_free_cached(ptr, file, line);
+        return;
+    }
+
+    g_memory_manager.free_calls++;
+
+    // Get the header
+    BlockHeader *block = (BlockHeader *) ptr - 1;
+
+    // Check for memory corruption
+    if (block->magic != MEMORY_MAGIC)
+    {
+        printf("ERROR: Memory corruption detected in free! Magic number mismatch at %s:%d\n", file, line);
+        if (block->flags & HEADER_TRACKED)
+        {
+            MemoryHeader *header = tracking_header(block);
+            printf("  Original allocation at %s:%d\n", header->file, header->line);
+        }
+        return;
+    }
+
+    // Calculate block category; blocks malloc'd as a fallback are just freed
+    BlockCategory category = (block->flags & HEADER_POOLED)
+                                 ? get_block_category(block->size + header_overhead(block->flags))
+                                 : BLOCK_LARGE;
+
+    // Remove from tracking
+    if (block->flags & HEADER_TRACKED)
+    {
+        untrack_allocation(tracking_header(block));
+    }
+    account_free(block->size);
+
+    // Clear magic number to detect double-frees
+    block->magic = 0;
+
+    // Return to pool or free
+    return_to_pool(block_start(block), category);
+}
+
+// Print memory usage report
+static inline void memory_print_report()
+{
+    printf("\n=== Memory Manager Report ===\n");
+    printf("Current memory usage: %zu bytes\n", g_memory_manager.total_allocated);
+    printf("Peak memory usage: %zu bytes\n", g_memory_manager.peak_allocated);
+    printf("Total allocations: %zu\n", g_memory_manager.malloc_calls);
+    printf("Total frees: %zu\n", g_memory_manager.free_calls);
+    printf("Pool allocations: %zu\n", g_memory_manager.pool_hits);
+    printf("Slab pages: tiny %zu, small %zu, medium %zu\n",
+           g_memory_manager.tiny_pool.slab_count,
+           g_memory_manager.small_pool.slab_count,
+           g_memory_manager.medium_pool.slab_count);
+    printf("Outstanding allocations: %zu\n", g_memory_manager.allocation_count);
+    if (g_memory_manager.thread_cache_enabled)
+    {
+        printf("Thread cache hits: %zu\n", g_memory_manager.cache_hits);
+    }
+
+    if (g_memory_manager.allocation_count > 0)
+    {
+        printf("\nMemory Leaks Detected:\n");
+        MemoryHeader *current = g_memory_manager.allocations;
+        size_t leak_count = 0;
+        size_t total_leaked = 0;
+
+        size_t interval = g_memory_manager.sample_interval;
+        size_t estimated = 0;
+
+        while (current)
+        {
+            size_t size = current->block.size;
+            printf("  Leak #%zu: %zu bytes at %s:%d\n", ++leak_count, size, current->file, current->line);
+            total_leaked += size;
+
+            // A sample stands for about one interval's worth of allocations
+            estimated += size > interval ? size : interval;
+            current = current->next;
+        }
+
+        printf("\nTotal leaked memory: %zu bytes\n", total_leaked);
+
+        // Unsampled allocations are counted but have no tracking header
+        if (interval > 0)
+        {
+            printf("Sampling 1 allocation per ~%zu bytes: %zu of %zu leaks recorded, ~%zu bytes estimated from samples\n",
+                   interval,
+                   leak_count,
+                   g_memory_manager.allocation_count,
+                   estimated);
+        }
+    }
+}
+
+// Check for memory leaks
+static inline bool memory_check_leaks()
+{
+    return g_memory_manager.allocation_count > 0;
+}
+
+// Release every slab page owned by a pool
+static inline void destroy_block_pool(BlockPool *pool)
+{
+    Slab *lists[2] = {pool->partial, pool->full};
+
+    for (int i = 0; i < 2; i++)
+    {
+        Slab *slab = lists[i];
+        while (slab)
+        {
+            Slab *next = slab->next;
+            free(slab);
+            slab = next;
+        }
+    }
+
+    init_block_pool(pool, pool->block_size);
+}
+
+// Clean up memory manager
+static inline void memory_manager_cleanup()
+{
+    // Report leaks
+    if (memory_check_leaks())
+    {
+        memory_print_report();
+    }
+
+    // Free all pooled memory
+    destroy_block_pool(&g_memory_manager.tiny_pool);
+    destroy_block_pool(&g_memory_manager.small_pool);
+    destroy_block_pool(&g_memory_manager.medium_pool);
+
+    // Reset memory manager and the calling thread's cache
+    memory_manager_init();
+    memset(&t_cache, 0, sizeof(t_cache));
+}
+
+// Macro to simplify allocation
+#define MM_ALLOC(size) memory_alloc(size, __FILE__, __LINE__)
+
+// Macro to simplify deallocation
+#define MM_FREE(ptr) memory_free(ptr, __FILE__, __LINE__)
+
+#endif  // MEMORY_MANAGER_H
@@ -1,6 +1,8 @@
+#define _POSIX_C_SOURCE 199309L
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <time.h>
 
 // GPIO register definitions (simulating hardware registers)
 typedef struct
@@ -20,6 +22,34 @@ typedef struct
 // Simulated GPIO port
 GPIO_TypeDef GPIOA;
 
+// Register accesses made through the helpers below; on a real part each
+// one is a bus transaction of a few cycles, so fewer accesses per edge
+// means faster bit-banged protocols
+static unsigned long bus_accesses;
+
+static inline uint32_t gpio_read(volatile uint32_t* reg)
+{
+    bus_accesses++;
+    return *reg;
+}
+
+static inline void gpio_write(volatile uint32_t* reg, uint32_t value)
+{
+    bus_accesses++;
+    *reg = value;
+}
+
+// Write BSRR: the lower 16 bits set pins, the upper 16 reset them, all in
+// one store that leaves every other pin alone. An interrupt that changes
+// other pins of the port between our read and write cannot be undone by
+// it, which a read-modify-write of ODR can. On hardware the port logic
+// updates ODR; here the simulation does (set wins if both bits are given).
+static inline void gpio_write_bsrr(GPIO_TypeDef* gpio, uint32_t value)
+{
+    gpio_write(&gpio->BSRR, value);
+    gpio->ODR = (gpio->ODR & ~(value >> 16)) | (value & 0xFFFF);
+}
+
 // GPIO pin definitions
 #define GPIO_PIN_0 ((uint16_t) 0x0001)    // Pin 0
 #define GPIO_PIN_1 ((uint16_t) 0x0002)    // Pin 1
@@ -67,52 +97,64 @@ void print_pin_states(uint32_t port_value)
     printf("\n");
 }
 
-// Configure a pin as output
+// Spread a 16-bit pin mask to one 2-bit field per pin (bit i -> bits 2i
+// and 2i+1), the layout of MODE, OSPEED and PUPD
+static uint32_t spread_pins(uint16_t pins)
+{
+    uint32_t x = pins;
+    x = (x | (x << 8)) & 0x00FF00FF;
+    x = (x | (x << 4)) & 0x0F0F0F0F;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    return x * 3;
+}
+
+// Set the mode of every pin in the mask with one read and one write of
+// MODE, however many pins there are
+void GPIO_ConfigurePins(GPIO_TypeDef* gpio, uint16_t pins, uint32_t mode)
+{
+    uint32_t field = spread_pins(pins);
+    uint32_t temp = gpio_read(&gpio->MODE);
+    temp &= ~field;                        // Clear the 2 bits of each pin
+    temp |= field & (mode * 0x55555555U);  // Mode repeated in every field
+    gpio_write(&gpio->MODE, temp);
+
+    // In a real system, we might also configure other parameters
+    // like speed, output type, etc.
+}
+
+// Configure pins as outputs
 void GPIO_ConfigureOutput(GPIO_TypeDef* gpio, uint16_t pin)
 {
-    // For each pin in the pin mask:
-    for (int i = 0; i < 16; i++)
-    {
-        if (pin & (1 << i))
-        {
-            // Each pin takes 2 bits in MODE register
-            uint32_t temp = gpio->MODE;
-            temp &= ~(3U << (i * 2));               // Clear the 2 bits
-            temp |= (GPIO_MODE_OUTPUT << (i * 2));  // Set as output
-            gpio->MODE = temp;
-
-            // In a real system, we might also configure other parameters
-            // like speed, output type, etc.
-        }
-    }
+    GPIO_ConfigurePins(gpio, pin, GPIO_MODE_OUTPUT);
 }
 
 // Set pins to high state
 void GPIO_SetPins(GPIO_TypeDef* gpio, uint16_t pin)
 {
-    // Write to the Bit Set/Reset Register
-    // The lower 16 bits set pins, upper 16 bits would reset pins
-    gpio->BSRR = pin;
-
-    // This also updates the ODR register
-    gpio->ODR |= pin;
+    gpio_write_bsrr(gpio, pin);
 }
 
 // Reset pins to low state
 void GPIO_ResetPins(GPIO_TypeDef* gpio, uint16_t pin)
 {
-    // Write to the Bit Set/Reset Register
-    // Lower 16 bits set pins, upper 16 bits reset pins
-    gpio->BSRR = (uint32_t) pin << 16;
+    gpio_write_bsrr(gpio, (uint32_t) pin << 16);
+}
 
-    // This also updates the ODR register
-    gpio->ODR &= ~pin;
+// Drive the pins in mask to the matching bits of value in one write:
+// mask bits that are 1 in value go high, the rest of mask goes low
+void GPIO_WritePins(GPIO_TypeDef* gpio, uint16_t mask, uint16_t value)
+{
+    gpio_write_bsrr(gpio, (uint32_t) (mask & value)
+                              | (uint32_t) (mask & ~value) << 16);
 }
 
-// Toggle pins
+// Toggle pins: one read of ODR to learn their levels, then one BSRR write,
+// so pins outside the mask are never written
 void GPIO_TogglePins(GPIO_TypeDef* gpio, uint16_t pin)
 {
-    gpio->ODR ^= pin;
+    uint16_t odr = (uint16_t) gpio_read(&gpio->ODR);
+    GPIO_WritePins(gpio, pin, (uint16_t) ~odr);
 }
 
 // Read pin state
@@ -122,6 +164,104 @@ bool GPIO_ReadPin(GPIO_TypeDef* gpio, uint16_t pin)
     return (gpio->IDR & pin) != 0;
 }
 
+// Bit-banged parallel bus: data lines on consecutive pins of one port and
+// a clock (strobe) pin that latches on its rising edge
+typedef struct
+{
+    GPIO_TypeDef* gpio;
+    uint8_t data_shift;  // Pin of data bit 0
+    uint8_t data_width;  // Number of data lines
+    uint16_t clock_pin;  // GPIO_PIN_x mask
+} ParallelBus;
+
+static uint16_t bus_data_mask(const ParallelBus* bus)
+{
+    return (uint16_t) (((1U << bus->data_width) - 1) << bus->data_shift);
+}
+
+void bus_init(const ParallelBus* bus)
+{
+    GPIO_ConfigurePins(bus->gpio, bus_data_mask(bus) | bus->clock_pin,
+                       GPIO_MODE_OUTPUT);
+    GPIO_ResetPins(bus->gpio, bus_data_mask(bus) | bus->clock_pin);
+}
+
+// Two writes per word: the first drives all data lines and drops the
+// clock together, the second raises the clock to latch them
+void bus_write(const ParallelBus* bus, const uint8_t* data, int count)
+{
+    uint16_t mask = bus_data_mask(bus) | bus->clock_pin;
+    for (int i = 0; i < count; i++)
+    {
+        GPIO_WritePins(bus->gpio, mask, (uint16_t) (data[i] << bus->data_shift));
+        gpio_write_bsrr(bus->gpio, bus->clock_pin);
+    }
+}
+
+// The same transfer done one line at a time with read-modify-write of
+// ODR, for comparison
+void bus_write_per_pin(const ParallelBus* bus, const uint8_t* data, int count)
+{
+    GPIO_TypeDef* gpio = bus->gpio;
+    for (int i = 0; i < count; i++)
+    {
+        gpio_write(&gpio->ODR, gpio_read(&gpio->ODR) & ~bus->clock_pin);
+        for (int bit = 0; bit < bus->data_width; bit++)
+        {
+            uint32_t line = 1U << (bus->data_shift + bit);
+            uint32_t odr = gpio_read(&gpio->ODR);
+            odr = (data[i] >> bit) & 1 ? odr | line : odr & ~line;
+            gpio_write(&gpio->ODR, odr);
+        }
+        gpio_write(&gpio->ODR, gpio_read(&gpio->ODR) | bus->clock_pin);
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Bus accesses and time per word for both ways of driving the bus. The
+// host timing only reflects the simulation; on a microcontroller each
+// access is a peripheral bus transaction, so the access count is what
+// sets the achievable clock rate.
+void bus_timing_demo(void)
+{
+    enum { WORDS = 4096, ROUNDS = 64 };
+    static uint8_t data[WORDS];
+    for (int i = 0; i < WORDS; i++) data[i] = (uint8_t) (i * 37);
+
+    ParallelBus bus = {&GPIOA, 8, 8, GPIO_PIN_3};
+    bus_init(&bus);
+
+    struct
+    {
+        const char* name;
+        void (*write)(const ParallelBus*, const uint8_t*, int);
+    } methods[] = {
+        {"Per-pin read-modify-write", bus_write_per_pin},
+        {"BSRR, whole word at once", bus_write},
+    };
+
+    printf("\n=== Bit-banged 8-bit Parallel Bus ===\n");
+    for (int m = 0; m < 2; m++)
+    {
+        unsigned long accesses = bus_accesses;
+        double start = now_ns();
+        for (int r = 0; r < ROUNDS; r++) methods[m].write(&bus, data, WORDS);
+        double elapsed = now_ns() - start;
+        printf("%-26s %5.1f accesses/word, %6.2f ns/word (simulated)\n",
+               methods[m].name,
+               (double) (bus_accesses - accesses) / (WORDS * ROUNDS),
+               elapsed / (WORDS * ROUNDS));
+    }
+    printf("Last word on the bus: 0x%02X\n",
+           (unsigned) ((GPIOA.ODR & bus_data_mask(&bus)) >> bus.data_shift));
+}
+
 int main()
 {
     printf("=== GPIO Register Manipulation Example ===\n\n");
@@ -185,5 +325,15 @@ int main()
     printf("3. Bit-set/reset registers: Atomic operations to avoid race conditions\n");
     printf("4. Bit masking: Using bit masks to access specific bits\n");
 
+    // Several pins to different levels in one write
+    printf("\nWriting pins 0-3 to 0b1010 in one BSRR write...\n");
+    GPIO_ConfigurePins(&GPIOA, GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3,
+                       GPIO_MODE_OUTPUT);
+    GPIO_WritePins(&GPIOA, 0x000F, 0x000A);
+    printf("BSRR written: 0x%08X\n", GPIOA.BSRR);
+    print_pin_states(GPIOA.ODR);
+
+    bus_timing_demo();
+
     return 0;
 }